@@ -20,9 +20,12 @@ Environment:
 
 typedef struct {
     DWORD MsSleepTime;
-    UCHAR CommandBytes[4];
+    USHORT Address;
+    USHORT Value;
 } CODEC_COMMAND, *PCODEC_COMMAND;
 
+#define CODEC_COMMAND(wait, addr, data) {(DWORD)wait, (USHORT)(addr), (USHORT)(data)}
+
 NTSTATUS
 CodecSendCommands(
     _In_ PDEVICE_CONTEXT DeviceContext,
@@ -43,46 +46,56 @@ CodecInitializeHeadphoneOutJack(
 {
     CODEC_COMMAND Commands[] =
     {   
-                { 0,    0x00, 0x30, 0x40, 0x60 },    // CHIP_ANA_POWER 0x0030       
-                                                     // chip is externally driven, so disable power regulators                               
-        { 0,    0x00, 0x26, 0x00, 0x6c },    // CHIP_LINREG_CTRL 0x0026
-                                             // Configure the charge pump to use the VDDIO rail (set bit 5 and bit 6)
-        { 0,    0x00, 0x28, 0x01, 0xf0 },    // CHIP_REF_CTRL 0x0028
-                                             // 
-        { 0,    0x00, 0x2c, 0x03, 0x20 },    // CHIP_LINE_OUT_CTRL 0x002C
-                                             // Set LINEOUT reference voltage to VDDIO/2 (1.6 V) (bits 5:0),
-                                             // bias current (bits 11:8) to the recommended value of 0.36 mA 
-        { 0,    0x00, 0x28, 0x01, 0xf9 },    // CHIP_REF_CTRL 0x0028
-                                             // Set analog ground voltage to 1.575V, Bias control to 12.5%, 
-                                             // enable slow volume ramp to minimize the startup pop
-        { 0,    0x00, 0x2a, 0x02, 0x31 },    // CHIP_MIC_CTRL 0x002a
-                                             // Select 4 ohm input, MIC Bias at 2.0V, 20 dB MIC amplifier gain.
-        { 0,    0x00, 0x3c, 0x66, 0x66 },    // CHIP_SHORT_CTRL 0x003C
-                                             // Enable short detect mode for headphone left/right
-                                             // and center channel and set short detect current trip level
-                                             // to 175 mA.
-        { 0,    0x00, 0x24, 0x01, 0x22 },    // CHIP_ANA_CTRL 0x0024                                                     
-                                             // Unmute the headphone and ADC, leave LINEOUT muted
-        { 0,    0x00, 0x30, 0x40, 0x7f },    // CHIP_ANA_POWER 0x0030
-                                             // enable DACs, Headphone power
-        { 0,    0x00, 0x30, 0x40, 0xff },    // CHIP_ANA_POWER 0x0030
-                                             // Enable the VAG reference buffer to slowly ramp out the headphone
-                                             // amplifier while avoiding pops
-        { 0,    0x00, 0x02, 0x00, 0x73 },    // CHIP_DIG_POWER 0x0002
-                                             // Power up desired digital blocks
-                                             // I2S_IN (bit 0), I2S_OUT (bit 1), DAP (bit 4), DAC (bit 5),
-                                             // ADC (bit 6) are powered on 
-        { 0,    0x00, 0x06, 0x00, 0x00 },    // CHIP_I2S_CTRL 0x0006
-                                             // I2s Slave mode, 32bit
-        { 0,    0x00, 0x04, 0x00, 0x06 },    // CHIP_CLK_CTRL 0x0004
-                                             // 44.1 KHz, MCLK_FREQ is 512x the audio sample rate
-        { 0,    0x00, 0x0e, 0x02, 0x00 },    // CHIP_ADCDAC_CTRL 0x000E                                                     
-                                             // unmute DACs, leave the volume ramp enable on.
+                CODEC_COMMAND (0,    0x0030, 0x4060),    // CHIP_ANA_POWER 0x0030       
+                                                         // chip is externally driven, so disable power regulators                               
+        CODEC_COMMAND (0,    0x0026, 0x006c),    // CHIP_LINREG_CTRL 0x0026
+                                                 // Configure the charge pump to use the VDDIO rail (set bit 5 and bit 6)
+        CODEC_COMMAND (0,    0x0028, 0x01f0),    // CHIP_REF_CTRL 0x0028
+                                                 // 
+        CODEC_COMMAND (0,    0x002c, 0x0320),    // CHIP_LINE_OUT_CTRL 0x002C
+                                                 // Set LINEOUT reference voltage to VDDIO/2 (1.6 V) (bits 5:0),
+                                                 // bias current (bits 11:8) to the recommended value of 0.36 mA 
+        CODEC_COMMAND (0,    0x0028, 0x01f9),    // CHIP_REF_CTRL 0x0028
+                                                 // Set analog ground voltage to 1.575V, Bias control to 12.5%, 
+                                                 // enable slow volume ramp to minimize the startup pop
+        CODEC_COMMAND (0,    0x002a, 0x0231),    // CHIP_MIC_CTRL 0x002a
+                                                 // Select 4 ohm input, MIC Bias at 2.0V, 20 dB MIC amplifier gain.
+        CODEC_COMMAND (0,    0x003c, 0x6666),    // CHIP_SHORT_CTRL 0x003C
+                                                 // Enable short detect mode for headphone left/right
+                                                 // and center channel and set short detect current trip level
+                                                 // to 175 mA.
+        CODEC_COMMAND (0,    0x0024, 0x0122),    // CHIP_ANA_CTRL 0x0024                                                     
+                                                 // Unmute the headphone and ADC, leave LINEOUT muted
+        CODEC_COMMAND (0,    0x0030, 0x407f),    // CHIP_ANA_POWER 0x0030
+                                                 // enable DACs, Headphone power
+        CODEC_COMMAND (0,    0x0030, 0x40ff),    // CHIP_ANA_POWER 0x0030
+                                                 // Enable the VAG reference buffer to slowly ramp out the headphone
+                                                 // amplifier while avoiding pops
+        CODEC_COMMAND (0,    0x0002, 0x0073),    // CHIP_DIG_POWER 0x0002
+                                                 // Power up desired digital blocks
+                                                 // I2S_IN (bit 0), I2S_OUT (bit 1), DAP (bit 4), DAC (bit 5),
+                                                 // ADC (bit 6) are powered on 
+        CODEC_COMMAND (0,    0x0006, 0x0000),    // CHIP_I2S_CTRL 0x0006
+                                                 // I2s Slave mode, 32bit
+        CODEC_COMMAND (0,    0x0004, 0x0006),    // CHIP_CLK_CTRL 0x0004
+                                                 // 44.1 KHz, MCLK_FREQ is 512x the audio sample rate
+        CODEC_COMMAND (0,    0x000e, 0x0200),    // CHIP_ADCDAC_CTRL 0x000E                                                     
+                                                 // unmute DACs, leave the volume ramp enable on.
 
     };
 
     NTSTATUS status;
 
+    //
+    // The codec has just been (re)connected, so start from an empty
+    // register cache.
+    //
+    CodecRegMapInitialize(&DeviceContext->RegMap,
+                          DeviceContext->I2cTarget,
+                          CodecRegMapFormat16Addr16Data,
+                          NULL,
+                          0);
+
     status = CodecSendCommands(DeviceContext, Commands, ARRAYSIZE(Commands));
 
     return status;
@@ -96,14 +109,17 @@ CodecSendCommand(
 {
     NTSTATUS status;
 
-    ULONG_PTR bytesWritten;
-    
-    WDF_MEMORY_DESCRIPTOR MemDescriptor;
+    status = CodecRegMapWrite(&DeviceContext->RegMap, CodecCommand->Address, CodecCommand->Value);
 
-    WDF_MEMORY_DESCRIPTOR_INIT_BUFFER(&MemDescriptor,&CodecCommand->CommandBytes[0], sizeof(CodecCommand->CommandBytes));
+    if (NT_SUCCESS(status) && (CodecCommand->MsSleepTime != 0))
+    {
+        //
+        // The codec needs this write, and everything queued before it,
+        // to have completed before the delay starts.
+        //
+        status = CodecRegMapFlush(&DeviceContext->RegMap);
+    }
 
-    status = WdfIoTargetSendWriteSynchronously(DeviceContext->I2cTarget, NULL, &MemDescriptor, 0, NULL, &bytesWritten);
-    
     if (CodecCommand->MsSleepTime != 0)
     {
         Sleep(CodecCommand->MsSleepTime);
@@ -131,5 +147,9 @@ CodecSendCommands(
             return status;
         }
     }
-    return STATUS_SUCCESS;
+
+    //
+    // Send whatever is still queued.
+    //
+    return CodecRegMapFlush(&DeviceContext->RegMap);
 }
@@ -21,10 +21,16 @@ Environment:
 
 typedef struct {
     DWORD MsSleepTime;
-    UCHAR CommandBytes[2];
+    USHORT Address;
+    USHORT Value;
 } CODEC_COMMAND, *PCODEC_COMMAND;
 
-#define CODEC_COMMAND(wait, addr, data) {(DWORD)wait, (UCHAR)((addr << 1)|((data & 0x1FF) >> 8)), (UCHAR)(data & 0xFF)}
+#define CODEC_COMMAND(wait, addr, data) {(DWORD)wait, (USHORT)(addr), (USHORT)(data)}
+
+//
+// Writing register F resets the codec.
+//
+static const USHORT CodecVolatileRegisters[] = { 0x0F };
 
 NTSTATUS
 CodecSendCommands(
@@ -65,6 +71,16 @@ CodecInitializeHeadphoneOutJack(
     };
     NTSTATUS status;
 
+    //
+    // The codec has just been (re)connected, so start from an empty
+    // register cache.
+    //
+    CodecRegMapInitialize(&DeviceContext->RegMap,
+                          DeviceContext->I2cTarget,
+                          CodecRegMapFormat7Addr9Data,
+                          CodecVolatileRegisters,
+                          ARRAYSIZE(CodecVolatileRegisters));
+
     status = CodecSendCommands(DeviceContext, Commands, ARRAYSIZE(Commands));
 
     return status;
@@ -77,13 +93,18 @@ CodecSendCommand(
     )
 {
     NTSTATUS status;
-    ULONG_PTR bytesWritten;
-    WDF_MEMORY_DESCRIPTOR MemDescriptor;
 
-    WDF_MEMORY_DESCRIPTOR_INIT_BUFFER(&MemDescriptor,&CodecCommand->CommandBytes[0], sizeof(CodecCommand->CommandBytes));
+    status = CodecRegMapWrite(&DeviceContext->RegMap, CodecCommand->Address, CodecCommand->Value);
+
+    if (NT_SUCCESS(status) && (CodecCommand->MsSleepTime != 0))
+    {
+        //
+        // The codec needs this write, and everything queued before it,
+        // to have completed before the delay starts.
+        //
+        status = CodecRegMapFlush(&DeviceContext->RegMap);
+    }
 
-    status = WdfIoTargetSendWriteSynchronously(DeviceContext->I2cTarget, NULL, &MemDescriptor, 0, NULL, &bytesWritten);
-    
     if (CodecCommand->MsSleepTime != 0)
     {
         Sleep(CodecCommand->MsSleepTime);
@@ -112,6 +133,9 @@ CodecSendCommands(
         }
     }
 
-    return STATUS_SUCCESS;
+    //
+    // Send whatever is still queued.
+    //
+    return CodecRegMapFlush(&DeviceContext->RegMap);
 }
 
@@ -20,9 +20,18 @@ Environment:
 
 typedef struct {
     DWORD MsSleepTime;
-    UCHAR CommandBytes[4];
+    USHORT Address;
+    USHORT Value;
 } CODEC_COMMAND, *PCODEC_COMMAND;
 
+#define CODEC_COMMAND(wait, addr, data) {(DWORD)wait, (USHORT)(addr), (USHORT)(data)}
+
+//
+// R15 is the software reset and R90 starts the write sequencer; both change
+// other registers behind the register cache.
+//
+static const USHORT CodecVolatileRegisters[] = { 0x000f, 0x005a };
+
 NTSTATUS
 CodecSendCommands(
     _In_ PDEVICE_CONTEXT DeviceContext,
@@ -43,21 +52,31 @@ CodecInitializeHeadphoneOutJack(
 {
     CODEC_COMMAND Commands[] =
     {   
-        { 0,    0x00, 0x08, 0x08, 0x20 },  // R8 - Clocking2. Set codec to use external clock.
-        { 0,    0x00, 0x1b, 0x00, 0x00 },  // R27 - Additional control 3. Set the sample rate to 44.1 kHz.
-        { 0,    0x00, 0x26, 0x00, 0x13 },  // R38 - Right input PGA control - select IN3R/IN4R as the inputs to the input PGA.
-        { 0,    0x00, 0x57, 0x00, 0xa0 },  // R87 - Write Sequencer Control 1 - enable the sequencer.
-        { 100,  0x00, 0x5a, 0x00, 0x80 },  // R90 - Write Sequencer Control 1 - run the 'DAC to Headphone Power Up' sequence.
-        { 100,  0x00, 0x5a, 0x00, 0x92 },  // R90 - Write Sequencer Control 1 - run the 'Analogue Input Power Up' sequence.
-        { 0,    0x00, 0x07, 0x00, 0x0e },  // R7 - Audio interface 0 - set word length to 32 bit. CAUTION: this gets reset by the
-                                           // 'DAC to Headphone Power Up' sequence.
-        { 0,    0x00, 0x01, 0x01, 0x1f },  // R1 - Mic right volume - Set the right mic channel to max volume.
-        { 0,    0x00, 0x02, 0x01, 0xff },  // R2 - HPOUTL volume - Set the left headphone channel to max volume.
-        { 0,    0x00, 0x03, 0x01, 0xff },  // R3 - HPOUTR volume - Set the right headphone channel to max volume.
+        CODEC_COMMAND (0,    0x0008, 0x0820),  // R8 - Clocking2. Set codec to use external clock.
+        CODEC_COMMAND (0,    0x001b, 0x0000),  // R27 - Additional control 3. Set the sample rate to 44.1 kHz.
+        CODEC_COMMAND (0,    0x0026, 0x0013),  // R38 - Right input PGA control - select IN3R/IN4R as the inputs to the input PGA.
+        CODEC_COMMAND (0,    0x0057, 0x00a0),  // R87 - Write Sequencer Control 1 - enable the sequencer.
+        CODEC_COMMAND (100,  0x005a, 0x0080),  // R90 - Write Sequencer Control 1 - run the 'DAC to Headphone Power Up' sequence.
+        CODEC_COMMAND (100,  0x005a, 0x0092),  // R90 - Write Sequencer Control 1 - run the 'Analogue Input Power Up' sequence.
+        CODEC_COMMAND (0,    0x0007, 0x000e),  // R7 - Audio interface 0 - set word length to 32 bit. CAUTION: this gets reset by the
+                                               // 'DAC to Headphone Power Up' sequence.
+        CODEC_COMMAND (0,    0x0001, 0x011f),  // R1 - Mic right volume - Set the right mic channel to max volume.
+        CODEC_COMMAND (0,    0x0002, 0x01ff),  // R2 - HPOUTL volume - Set the left headphone channel to max volume.
+        CODEC_COMMAND (0,    0x0003, 0x01ff),  // R3 - HPOUTR volume - Set the right headphone channel to max volume.
     };
 
     NTSTATUS status;
 
+    //
+    // The codec has just been (re)connected, so start from an empty
+    // register cache.
+    //
+    CodecRegMapInitialize(&DeviceContext->RegMap,
+                          DeviceContext->I2cTarget,
+                          CodecRegMapFormat16Addr16Data,
+                          CodecVolatileRegisters,
+                          ARRAYSIZE(CodecVolatileRegisters));
+
     status = CodecSendCommands(DeviceContext, Commands, ARRAYSIZE(Commands));
 
     return status;
@@ -71,14 +90,17 @@ CodecSendCommand(
 {
     NTSTATUS status;
 
-    ULONG_PTR bytesWritten;
-    
-    WDF_MEMORY_DESCRIPTOR MemDescriptor;
+    status = CodecRegMapWrite(&DeviceContext->RegMap, CodecCommand->Address, CodecCommand->Value);
 
-    WDF_MEMORY_DESCRIPTOR_INIT_BUFFER(&MemDescriptor,&CodecCommand->CommandBytes[0], sizeof(CodecCommand->CommandBytes));
+    if (NT_SUCCESS(status) && (CodecCommand->MsSleepTime != 0))
+    {
+        //
+        // The codec needs this write, and everything queued before it,
+        // to have completed before the delay starts.
+        //
+        status = CodecRegMapFlush(&DeviceContext->RegMap);
+    }
 
-    status = WdfIoTargetSendWriteSynchronously(DeviceContext->I2cTarget, NULL, &MemDescriptor, 0, NULL, &bytesWritten);
-    
     if (CodecCommand->MsSleepTime != 0)
     {
         Sleep(CodecCommand->MsSleepTime);
@@ -106,5 +128,9 @@ CodecSendCommands(
             return status;
         }
     }
-    return STATUS_SUCCESS;
+
+    //
+    // Send whatever is still queued.
+    //
+    return CodecRegMapFlush(&DeviceContext->RegMap);
 }
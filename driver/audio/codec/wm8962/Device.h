@@ -17,6 +17,7 @@ Environment:
 #pragma once
 
 #include "public.h"
+#include <codecregmap.h>
 
 #define RESHUB_USE_HELPER_ROUTINES
 
@@ -32,6 +33,7 @@ typedef struct _DEVICE_CONTEXT
 {   
 	LARGE_INTEGER I2cConnectionId; 
     WDFIOTARGET   I2cTarget;
+    CODEC_REGMAP  RegMap;
     
 } DEVICE_CONTEXT, *PDEVICE_CONTEXT;
 
@@ -367,6 +367,19 @@ DECLARE_INTERFACE_(IAdapterCommon, IUnknown)
         THIS_
         _In_        CMiniportWaveRTStream* Stream
     );
+
+    STDMETHOD_(BOOLEAN,         IsDmaSupported)
+    (
+        THIS_
+                    eDeviceType DeviceType
+    );
+
+    STDMETHOD_(NTSTATUS,        GetDmaPosition)
+    (
+        THIS_
+        _In_        CMiniportWaveRTStream* Stream,
+        _Out_       PULONG Position
+    );
 };
 
 typedef IAdapterCommon *PADAPTERCOMMON;
@@ -120,6 +120,8 @@ Return Value:
     m_bUnregisterStream = FALSE;
     m_ulDmaBufferSize = 0;
     m_DataBuffer = NULL;
+    m_pBufferMdl = NULL;
+    m_bDmaPosition = FALSE;
     m_KsState = KSSTATE_STOP;
     m_ulNotificationsPerBuffer = 0;
 
@@ -246,6 +248,7 @@ CMiniportWaveRTStream::AllocateBufferCommon
 )
 {
     NTSTATUS ntStatus;
+    MEMORY_CACHING_TYPE bufferCacheType;
 
     PAGED_CODE();
 
@@ -256,22 +259,43 @@ CMiniportWaveRTStream::AllocateBufferCommon
 
     RequestedSize -= RequestedSize % (m_pWfExt->Format.nBlockAlign);
 
+    PHYSICAL_ADDRESS lowAddress;
+    lowAddress.QuadPart = 0;
+
     PHYSICAL_ADDRESS highAddress;
     highAddress.HighPart = 0;
     highAddress.LowPart = MAXULONG;
 
-    PMDL pBufferMdl = m_pPortStream->AllocatePagesForMdl (highAddress, RequestedSize);
+    //
+    // A buffer moved by the SDMA is physically contiguous, so the cyclic transfer
+    // fits in the few buffer descriptors of an SDMA channel. The SDMA does not
+    // snoop the CPU caches, so the audio engine must not access it through the cache.
+    //
+    m_bDmaPosition = m_pAdapterCommon->IsDmaSupported(m_pMiniport->GetDeviceType());
+    bufferCacheType = m_bDmaPosition ? MmWriteCombined : MmCached;
+
+    PMDL pBufferMdl;
+
+    if (m_bDmaPosition)
+    {
+        pBufferMdl = m_pPortStream->AllocateContiguousPagesForMdl (lowAddress, highAddress, RequestedSize);
+    }
+    else
+    {
+        pBufferMdl = m_pPortStream->AllocatePagesForMdl (highAddress, RequestedSize);
+    }
 
     if (NULL == pBufferMdl)
     {
         return STATUS_UNSUCCESSFUL;
     }
 
-    m_DataBuffer = (ULONG*)m_pPortStream->MapAllocatedPages(pBufferMdl, MmCached);
+    m_DataBuffer = (ULONG*)m_pPortStream->MapAllocatedPages(pBufferMdl, bufferCacheType);
     if (m_DataBuffer)
     {
         m_ulNotificationsPerBuffer = NotificationCount;
         m_ulDmaBufferSize = RequestedSize;
+        m_pBufferMdl = pBufferMdl;
 
         ntStatus = m_pAdapterCommon->RegisterStream(this, m_pMiniport->GetDeviceType());
 
@@ -280,13 +304,15 @@ CMiniportWaveRTStream::AllocateBufferCommon
             *AudioBufferMdl = pBufferMdl;
             *ActualSize = RequestedSize;
             *OffsetFromFirstPage = 0;
-            *CacheType = MmCached;
+            *CacheType = bufferCacheType;
         }
         else
         {
+            m_pPortStream->UnmapAllocatedPages(m_DataBuffer, pBufferMdl);
             m_pPortStream->FreePagesFromMdl(pBufferMdl);
             m_ulDmaBufferSize = 0;
             m_DataBuffer = NULL;
+            m_pBufferMdl = NULL;
             DPF(D_ERROR, ("[CMiniportWaveRTStream::AllocateBufferWithNotification] failed to register stream with CSoc class."));
         }
 
@@ -400,6 +426,7 @@ Return Value:
         Mdl = NULL;
     }
 
+    m_pBufferMdl = NULL;
     m_ulNotificationsPerBuffer = 0;
     m_ulDmaBufferSize = 0;
 
@@ -599,6 +626,15 @@ Return Value:
 
     DPF_ENTER(("[CMiniportWaveRTStream::GetPositionRegister]"));
 
+    //
+    // The DMA position is read from the SDMA counter on request, there is
+    // no register that could be mapped. The audio engine falls back to GetPosition.
+    //
+    if (m_bDmaPosition)
+    {
+        return STATUS_NOT_SUPPORTED;
+    }
+
     Register->Register = &m_ulVirtualPosition;
     Register->Width = 32; // bits.
     Register->Accuracy = 15 * m_pWfExt->Format.nBlockAlign;
@@ -741,12 +777,19 @@ Return Value:
 
 --*/
 {
+    ULONG position;
+
     //
     // We only support render and capture, so update PlayOffset and WriteOffset.
     //
 
-    Position->PlayOffset = m_ulVirtualPosition;
-    Position->WriteOffset = m_ulVirtualPosition;
+    if (!m_bDmaPosition || !NT_SUCCESS(m_pAdapterCommon->GetDmaPosition(this, &position)))
+    {
+        position = m_ulVirtualPosition;
+    }
+
+    Position->PlayOffset = position;
+    Position->WriteOffset = position;
 
     return STATUS_SUCCESS;
 }
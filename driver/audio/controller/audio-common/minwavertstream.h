@@ -60,6 +60,8 @@ public:
 
     ULONG GetDmaBufferSize() { return m_ulDmaBufferSize; }
     ULONG* GetDmaBuffer() { return m_DataBuffer; }
+    PMDL GetDmaBufferMdl() { return m_pBufferMdl; }
+    ULONG GetNotificationsPerBuffer() { return m_ulNotificationsPerBuffer; }
     PWAVEFORMATEXTENSIBLE       GetDataFormat() { return m_pWfExt; }
 
 protected:
@@ -68,6 +70,8 @@ protected:
     BOOLEAN                     m_bUnregisterStream;
     ULONG                       m_ulDmaBufferSize;
     ULONG*                      m_DataBuffer;
+    PMDL                        m_pBufferMdl;
+    BOOLEAN                     m_bDmaPosition;
     LIST_ENTRY                  m_NotificationList;
     ULONG                       m_ulNotificationsPerBuffer;
     LARGE_INTEGER               m_PerformanceCounterFrequency;
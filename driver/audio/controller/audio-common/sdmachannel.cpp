@@ -0,0 +1,360 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License.
+
+Abstract:
+    CSdmaChannel class implementation.
+
+    The channel runs a single auto-initialize system DMA transfer over the
+    whole WaveRT buffer. The SDMA HAL extension splits the buffer into
+    buffer descriptors of the notification size and completes each of them
+    with an interrupt, so the caller is notified a fixed number of times per
+    buffer while the audio data itself is moved without CPU involvement.
+
+*/
+
+#include "imx_audio.h"
+#include "sdmachannel.h"
+#include "HalExtiMXDmaCfg.h"
+
+//=============================================================================
+#pragma code_seg("PAGE")
+NTSTATUS
+CSdmaChannel::Init
+(
+    _In_ PDEVICE_OBJECT PDO,
+    _In_ PCM_PARTIAL_RESOURCE_DESCRIPTOR DmaDescriptor,
+    _In_ PHYSICAL_ADDRESS DeviceAddress,
+    _In_ BOOLEAN WriteToDevice,
+    _In_ ULONG WatermarkBytes
+)
+/*++
+
+Routine Description:
+
+    Opens the system DMA adapter for the FixedDMA resource of the audio
+    interface and takes ownership of its SDMA request line.
+
+Arguments:
+
+    PDO - physical device object of the adapter.
+
+    DmaDescriptor - translated CmResourceTypeDma descriptor.
+
+    DeviceAddress - physical address of the FIFO data register.
+
+    WriteToDevice - TRUE for render, FALSE for capture.
+
+    WatermarkBytes - number of bytes moved per DMA request.
+
+Return Value:
+
+    NT status code
+
+--*/
+{
+    DEVICE_DESCRIPTION deviceDescription;
+    NTSTATUS status;
+
+    PAGED_CODE();
+
+    ASSERT(m_pDmaAdapter == NULL);
+
+    RtlZeroMemory(&deviceDescription, sizeof(deviceDescription));
+
+    //
+    // Demand mode, the SAI FIFO watermark drives the DMA requests.
+    // The FIFO data register is 32 bit wide. The SDMA HAL extension builds
+    // the buffer descriptors straight from the scatter/gather list, the
+    // buffer must not be double buffered through map registers.
+    //
+    deviceDescription.Version = DEVICE_DESCRIPTION_VERSION3;
+    deviceDescription.Master = FALSE;
+    deviceDescription.ScatterGather = TRUE;
+    deviceDescription.DemandMode = TRUE;
+    deviceDescription.AutoInitialize = TRUE;
+    deviceDescription.Dma32BitAddresses = TRUE;
+    deviceDescription.InterfaceType = ACPIBus;
+    deviceDescription.DmaWidth = Width32Bits;
+    deviceDescription.MaximumLength = SDMA_MAX_TRANSFER_LENGTH;
+    deviceDescription.DmaChannel = DmaDescriptor->u.DmaV3.Channel;
+    deviceDescription.DmaRequestLine = DmaDescriptor->u.DmaV3.RequestLine;
+    deviceDescription.DeviceAddress = DeviceAddress;
+
+    m_pDmaAdapter = IoGetDmaAdapter(PDO, &deviceDescription, &m_ulNumberOfMapRegisters);
+    if (m_pDmaAdapter == NULL)
+    {
+        DPF(D_ERROR, ("[CSdmaChannel::Init] IoGetDmaAdapter failed for request line %d", deviceDescription.DmaRequestLine));
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    m_pPDO = PDO;
+    m_bWriteToDevice = WriteToDevice;
+    m_ulWatermarkBytes = WatermarkBytes;
+    m_ulRequestLine = deviceDescription.DmaRequestLine;
+
+    //
+    // The SDMA request lines may be shared with other peripherals, make sure we own it.
+    //
+    status = m_pDmaAdapter->DmaOperations->ConfigureAdapterChannel(m_pDmaAdapter,
+                                                                   SDMA_CFG_FUN_ACQUIRE_REQUEST_LINE,
+                                                                   &m_ulRequestLine);
+    if (!NT_SUCCESS(status))
+    {
+        DPF(D_ERROR, ("[CSdmaChannel::Init] SDMA_CFG_FUN_ACQUIRE_REQUEST_LINE failed for line %d, 0x%x", m_ulRequestLine, status));
+        Cleanup();
+        return status;
+    }
+
+    m_bRequestLineAcquired = TRUE;
+
+    return STATUS_SUCCESS;
+}
+
+//=============================================================================
+#pragma code_seg("PAGE")
+VOID
+CSdmaChannel::Cleanup()
+{
+    PAGED_CODE();
+
+    if (m_pDmaAdapter == NULL)
+    {
+        return;
+    }
+
+    Stop();
+
+    if (m_bRequestLineAcquired)
+    {
+        (void)m_pDmaAdapter->DmaOperations->ConfigureAdapterChannel(m_pDmaAdapter,
+                                                                    SDMA_CFG_FUN_RELEASE_REQUEST_LINE,
+                                                                    &m_ulRequestLine);
+        m_bRequestLineAcquired = FALSE;
+    }
+
+    m_pDmaAdapter->DmaOperations->PutDmaAdapter(m_pDmaAdapter);
+    m_pDmaAdapter = NULL;
+}
+
+//=============================================================================
+#pragma code_seg()
+NTSTATUS
+CSdmaChannel::Start
+(
+    _In_ PMDL BufferMdl,
+    _In_ ULONG BufferSize,
+    _In_ ULONG NotificationBytes,
+    _In_ PSDMA_CHANNEL_NOTIFICATION Notification,
+    _In_ PVOID NotificationContext
+)
+/*++
+
+Routine Description:
+
+    Starts the cyclic transfer over the whole buffer. Notification is called
+    at DISPATCH_LEVEL each time about NotificationBytes have been moved.
+
+Arguments:
+
+    BufferMdl - MDL of the WaveRT buffer.
+
+    BufferSize - size of the WaveRT buffer in bytes.
+
+    NotificationBytes - number of bytes between notifications.
+
+    Notification - routine to call on each notification.
+
+    NotificationContext - context passed to Notification.
+
+Return Value:
+
+    NT status code
+
+--*/
+{
+    PDMA_OPERATIONS dmaOperations;
+    ULONG mapRegisters;
+    ULONG length;
+    NTSTATUS status;
+
+    if (!IsInitialized() || m_bRunning)
+    {
+        return STATUS_INVALID_DEVICE_STATE;
+    }
+
+    dmaOperations = m_pDmaAdapter->DmaOperations;
+
+    mapRegisters = ADDRESS_AND_SIZE_TO_SPAN_PAGES(MmGetMdlVirtualAddress(BufferMdl), BufferSize);
+    if (mapRegisters > m_ulNumberOfMapRegisters)
+    {
+        DPF(D_ERROR, ("[CSdmaChannel::Start] buffer of %d bytes needs %d map registers, %d available", BufferSize, mapRegisters, m_ulNumberOfMapRegisters));
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    status = dmaOperations->InitializeDmaTransferContext(m_pDmaAdapter, m_TransferContext);
+    if (!NT_SUCCESS(status))
+    {
+        return status;
+    }
+
+    status = dmaOperations->AllocateAdapterChannelEx(m_pDmaAdapter,
+                                                     m_pPDO,
+                                                     m_TransferContext,
+                                                     mapRegisters,
+                                                     DMA_SYNCHRONOUS_CALLBACK,
+                                                     NULL,
+                                                     NULL,
+                                                     &m_MapRegisterBase);
+    if (!NT_SUCCESS(status))
+    {
+        DPF(D_ERROR, ("[CSdmaChannel::Start] AllocateAdapterChannelEx failed, 0x%x", status));
+        return status;
+    }
+
+    //
+    // The watermark must match the number of FIFO entries free (render) or
+    // filled (capture) when the interface raises its DMA request.
+    //
+    status = dmaOperations->ConfigureAdapterChannel(m_pDmaAdapter,
+                                                    SDMA_CFG_FUN_SET_CHANNEL_WATERMARK_LEVEL,
+                                                    &m_ulWatermarkBytes);
+    if (NT_SUCCESS(status))
+    {
+        NotificationBytes = min(NotificationBytes, (ULONG)(SDMA_BD_MAX_COUNT - 1));
+
+        status = dmaOperations->ConfigureAdapterChannel(m_pDmaAdapter,
+                                                        SDMA_CFG_FUN_SET_CHANNEL_NOTIFICATION_THRESHOLD,
+                                                        &NotificationBytes);
+    }
+
+    if (!NT_SUCCESS(status))
+    {
+        DPF(D_ERROR, ("[CSdmaChannel::Start] SDMA channel configuration failed, 0x%x", status));
+        dmaOperations->FreeAdapterChannel(m_pDmaAdapter);
+        return status;
+    }
+
+    m_pBufferMdl = BufferMdl;
+    m_ulBufferSize = BufferSize;
+    m_pfnNotification = Notification;
+    m_pNotificationContext = NotificationContext;
+    m_bRunning = TRUE;
+
+    length = BufferSize;
+    status = dmaOperations->MapTransferEx(m_pDmaAdapter,
+                                          BufferMdl,
+                                          m_MapRegisterBase,
+                                          0,
+                                          0,
+                                          &length,
+                                          m_bWriteToDevice,
+                                          NULL,
+                                          0,
+                                          &CSdmaChannel::DmaCompletion,
+                                          this);
+
+    //
+    // An auto-initialize transfer cannot be continued, it has to cover the whole buffer.
+    //
+    if (NT_SUCCESS(status) && (length != BufferSize))
+    {
+        DPF(D_ERROR, ("[CSdmaChannel::Start] only %d of %d bytes mapped", length, BufferSize));
+        Stop();
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    if (!NT_SUCCESS(status))
+    {
+        DPF(D_ERROR, ("[CSdmaChannel::Start] MapTransferEx failed, 0x%x", status));
+        m_bRunning = FALSE;
+        dmaOperations->FreeAdapterChannel(m_pDmaAdapter);
+        return status;
+    }
+
+    return STATUS_SUCCESS;
+}
+
+//=============================================================================
+#pragma code_seg()
+VOID
+CSdmaChannel::Stop()
+{
+    PDMA_OPERATIONS dmaOperations;
+
+    if (!m_bRunning)
+    {
+        return;
+    }
+
+    m_bRunning = FALSE;
+
+    dmaOperations = m_pDmaAdapter->DmaOperations;
+
+    (void)dmaOperations->CancelMappedTransfer(m_pDmaAdapter, m_TransferContext);
+
+    (void)dmaOperations->FlushAdapterBuffersEx(m_pDmaAdapter,
+                                               m_pBufferMdl,
+                                               m_MapRegisterBase,
+                                               0,
+                                               m_ulBufferSize,
+                                               m_bWriteToDevice);
+
+    dmaOperations->FreeAdapterChannel(m_pDmaAdapter);
+
+    m_pBufferMdl = NULL;
+    m_ulBufferSize = 0;
+    m_MapRegisterBase = NULL;
+}
+
+//=============================================================================
+#pragma code_seg()
+ULONG
+CSdmaChannel::GetPosition()
+/*++
+
+Routine Description:
+
+    Returns the byte offset into the buffer the DMA is currently at.
+
+--*/
+{
+    ULONG remaining;
+
+    if (!m_bRunning)
+    {
+        return 0;
+    }
+
+    //
+    // The SDMA counter holds the number of bytes left in the current pass over the buffer.
+    //
+    remaining = m_pDmaAdapter->DmaOperations->ReadDmaCounter(m_pDmaAdapter);
+    if ((remaining == 0) || (remaining > m_ulBufferSize))
+    {
+        return 0;
+    }
+
+    return m_ulBufferSize - remaining;
+}
+
+//=============================================================================
+#pragma code_seg()
+VOID
+CSdmaChannel::DmaCompletion
+(
+    _In_ PDMA_ADAPTER DmaAdapter,
+    _In_ PDEVICE_OBJECT DeviceObject,
+    _In_ PVOID CompletionContext,
+    _In_ DMA_COMPLETION_STATUS Status
+)
+{
+    UNREFERENCED_PARAMETER(DmaAdapter);
+    UNREFERENCED_PARAMETER(DeviceObject);
+
+    CSdmaChannel* me = (CSdmaChannel*) CompletionContext;
+
+    if ((Status == DmaComplete) && me->m_bRunning)
+    {
+        me->m_pfnNotification(me->m_pNotificationContext);
+    }
+}
@@ -0,0 +1,76 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License.
+
+Abstract:
+    CSdmaChannel class declaration. Cyclic (auto-initialize) system DMA
+    between a WaveRT buffer and the data register of the audio interface.
+
+*/
+
+#pragma once
+
+typedef VOID SDMA_CHANNEL_NOTIFICATION(_In_ PVOID Context);
+typedef SDMA_CHANNEL_NOTIFICATION *PSDMA_CHANNEL_NOTIFICATION;
+
+class CSdmaChannel
+{
+public:
+    CSdmaChannel() { }
+    ~CSdmaChannel() { Cleanup(); }
+
+    NTSTATUS Init
+    (
+        _In_ PDEVICE_OBJECT PDO,
+        _In_ PCM_PARTIAL_RESOURCE_DESCRIPTOR DmaDescriptor,
+        _In_ PHYSICAL_ADDRESS DeviceAddress,
+        _In_ BOOLEAN WriteToDevice,
+        _In_ ULONG WatermarkBytes
+    );
+
+    VOID Cleanup();
+
+    BOOLEAN IsInitialized()
+    {
+        return (m_pDmaAdapter != NULL) ? TRUE : FALSE;
+    }
+
+    BOOLEAN IsRunning()
+    {
+        return m_bRunning;
+    }
+
+    NTSTATUS Start
+    (
+        _In_ PMDL BufferMdl,
+        _In_ ULONG BufferSize,
+        _In_ ULONG NotificationBytes,
+        _In_ PSDMA_CHANNEL_NOTIFICATION Notification,
+        _In_ PVOID NotificationContext
+    );
+
+    VOID Stop();
+
+    ULONG GetPosition();
+
+private:
+
+    static DMA_COMPLETION_ROUTINE DmaCompletion;
+
+    PDEVICE_OBJECT              m_pPDO;
+    PDMA_ADAPTER                m_pDmaAdapter;
+    ULONG                       m_ulNumberOfMapRegisters;
+    ULONG                       m_ulRequestLine;
+    BOOLEAN                     m_bRequestLineAcquired;
+    BOOLEAN                     m_bWriteToDevice;
+    ULONG                       m_ulWatermarkBytes;
+
+    BOOLEAN                     m_bRunning;
+    PMDL                        m_pBufferMdl;
+    ULONG                       m_ulBufferSize;
+    PVOID                       m_MapRegisterBase;
+    PSDMA_CHANNEL_NOTIFICATION  m_pfnNotification;
+    PVOID                       m_pNotificationContext;
+
+    DECLSPEC_ALIGN(MEMORY_ALLOCATION_ALIGNMENT)
+    UCHAR                       m_TransferContext[DMA_TRANSFER_CONTEXT_SIZE_V1];
+};
@@ -191,6 +191,17 @@ class CAdapterCommon :
             _In_        CMiniportWaveRTStream* Stream
         );
 
+        STDMETHODIMP_(BOOLEAN) IsDmaSupported
+        (
+                        eDeviceType DeviceType
+        );
+
+        STDMETHODIMP_(NTSTATUS) GetDmaPosition
+        (
+            _In_        CMiniportWaveRTStream* Stream,
+            _Out_       PULONG Position
+        );
+
 
         //=====================================================================
         // friends
@@ -2006,5 +2017,34 @@ CAdapterCommon::PauseDma
     return m_Soc.PauseDma(Stream);    
 }
 
+BOOLEAN
+CAdapterCommon::IsDmaSupported
+(
+                eDeviceType            DeviceType
+)
+{
+    UNREFERENCED_PARAMETER(DeviceType);
+
+    //
+    // The SSI FIFOs hold 24 bit LSB aligned samples, so the WaveRT buffer
+    // cannot be moved to them as is; the SSI is always serviced by the ISR.
+    //
+    return FALSE;
+}
+
+NTSTATUS
+CAdapterCommon::GetDmaPosition
+(
+    _In_        CMiniportWaveRTStream* Stream,
+    _Out_       PULONG                 Position
+)
+{
+    UNREFERENCED_PARAMETER(Stream);
+
+    *Position = 0;
+
+    return STATUS_NOT_SUPPORTED;
+}
+
 
 
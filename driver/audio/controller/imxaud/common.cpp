@@ -188,6 +188,17 @@ class CAdapterCommon :
             _In_        CMiniportWaveRTStream* Stream
         );
 
+        STDMETHODIMP_(BOOLEAN) IsDmaSupported
+        (
+                        eDeviceType DeviceType
+        );
+
+        STDMETHODIMP_(NTSTATUS) GetDmaPosition
+        (
+            _In_        CMiniportWaveRTStream* Stream,
+            _Out_       PULONG Position
+        );
+
 
         //=====================================================================
         // friends
@@ -574,6 +585,14 @@ Return Value:
                     goto Done;
                 }
                 m_Soc.InitSsiBlock(pSaiRegisters, interruptDescriptor, m_pPhysicalDeviceObject);
+
+                //
+                // The optional FixedDMA resources of the transmitter and the receiver,
+                // in that order, let the SDMA move the audio data.
+                //
+                m_Soc.InitDma(descriptor->u.Memory.Start,
+                              ResourceList->FindTranslatedEntry(CmResourceTypeDma, 0),
+                              ResourceList->FindTranslatedEntry(CmResourceTypeDma, 1));
             }
         }
     }
@@ -2250,5 +2269,24 @@ CAdapterCommon::PauseDma
     return m_Soc.PauseDma(Stream);    
 }
 
+BOOLEAN
+CAdapterCommon::IsDmaSupported
+(
+                eDeviceType            DeviceType
+)
+{
+    return m_Soc.IsDmaSupported(DeviceType);
+}
+
+NTSTATUS
+CAdapterCommon::GetDmaPosition
+(
+    _In_        CMiniportWaveRTStream* Stream,
+    _Out_       PULONG                 Position
+)
+{
+    return m_Soc.GetDmaPosition(Stream, Position);
+}
+
 
 
@@ -151,6 +151,9 @@ typedef union {
 #define FIFO_PTR_MSB(fifoptr) (fifoptr&0x20)
 #define FIFO_PTR_NOMSB(fifoptr) (fifoptr&0x1F)
 
+// Number of words in the FIFO, the pointers carry one extra bit to tell full from empty.
+#define FIFO_PTR_COUNT(writeptr, readptr) ((writeptr - readptr)&0x3F)
+
 //
 // IM7DRM: 13.8.4.9 SAI Transmit Mask Register (I2Sx_TMR)
 //
@@ -52,31 +52,36 @@ VOID
 CDmaBuffer::FillFifos()
 {
     SAI_TRANSMIT_FIFO_REGISTER FifoControl;
-    ULONG sampleIndex;
+    ULONG bufferWords;
+    ULONG freeWords;
+    ULONG wordIndex;
+    ULONG words;
 
+    //
+    // The FIFO level is only read once. It can only drop while we write, so
+    // the whole burst fits.
+    //
     FifoControl.AsUlong = READ_REGISTER_ULONG(&m_pSaiRegisters->TransmitFifoRegister.AsUlong);
+    freeWords = SAI_FIFO_DEPTH - FIFO_PTR_COUNT(FifoControl.WriteFifoPointer, FifoControl.ReadFifoPointer);
 
-    // If Read Fifo Pointer and Write Fifo Pointer are identical except for MSB, the FIFO is full
-    while(!((FIFO_PTR_NOMSB(FifoControl.ReadFifoPointer) == FIFO_PTR_NOMSB(FifoControl.WriteFifoPointer)) &&
-            (FIFO_PTR_MSB(FifoControl.ReadFifoPointer) != FIFO_PTR_MSB(FifoControl.WriteFifoPointer))))
-    {
-        // Samples consist of n values where n is number of channels, Left first.
-        ULONG sample;
-
-        sampleIndex = GetSampleIndex();
-        sample = m_DataBuffer[sampleIndex + m_ulChannel];
+    // Samples consist of n values where n is number of channels, Left first.
+    bufferWords = m_ulDmaBufferSize >> 2;
+    wordIndex = GetSampleIndex() + m_ulChannel;
 
-        WRITE_REGISTER_ULONG(&m_pSaiRegisters->TransmitDataRegister.AsUlong, sample);
+    for (words = 0; words < freeWords; words++)
+    {
+        WRITE_REGISTER_ULONG(&m_pSaiRegisters->TransmitDataRegister.AsUlong, m_DataBuffer[wordIndex]);
 
-        m_ulChannel += 1;
-        if (m_ulChannel >= m_pWfExt->Format.nChannels) {
-            m_ulChannel = 0;
-            m_ulSamplesTransferred += 1;
+        wordIndex += 1;
+        if (wordIndex == bufferWords) {
+            wordIndex = 0;
         }
-
-        FifoControl.AsUlong = READ_REGISTER_ULONG(&m_pSaiRegisters->TransmitFifoRegister.AsUlong);
     }
 
+    words = m_ulChannel + freeWords;
+    m_ulSamplesTransferred += words / m_pWfExt->Format.nChannels;
+    m_ulChannel = words % m_pWfExt->Format.nChannels;
+
     m_pRtStream->UpdateVirtualPositionRegisters(m_ulSamplesTransferred);
 }
 
@@ -85,31 +90,62 @@ VOID
 CDmaBuffer::DrainFifos()
 {
     SAI_RECEIVE_FIFO_REGISTER FifoControl;
+    ULONG bufferWords;
+    ULONG sampleIndex;
+    ULONG sample;
+    ULONG words;
 
+    //
+    // The FIFO level is only read once. It can only grow while we read, the
+    // remainder is picked up on the next request.
+    //
     FifoControl.AsUlong = READ_REGISTER_ULONG(&m_pSaiRegisters->ReceiveFifoRegister.AsUlong);
+    words = FIFO_PTR_COUNT(FifoControl.WriteFifoPointer, FifoControl.ReadFifoPointer);
 
-    ULONG sampleIndex;
-    ULONG sample;
+    if (words == 0)
+    {
+        return;
+    }
 
-    while(FifoControl.ReadFifoPointer != FifoControl.WriteFifoPointer) 
+    //
+    // We capture in mono but the frame has two words, only the first one is kept.
+    //
+    bufferWords = m_ulDmaBufferSize >> 2;
+    sampleIndex = GetSampleIndex();
+
+    if (m_ulChannel == 1)
+    {
+        (void)READ_REGISTER_ULONG(&m_pSaiRegisters->ReceiveDataRegister.AsUlong);
+        m_ulChannel = 0;
+        words -= 1;
+    }
+
+    while (words >= 2)
     {
-        // pull sample out of the fifo
         sample = READ_REGISTER_ULONG(&m_pSaiRegisters->ReceiveDataRegister.AsUlong);
-        sampleIndex = GetSampleIndex();
+        (void)READ_REGISTER_ULONG(&m_pSaiRegisters->ReceiveDataRegister.AsUlong);
 
         // Mask to 24-bit depth, MSB at bit 31
-        sample = sample & 0xffffff00;
+        m_DataBuffer[sampleIndex] = sample & 0xffffff00;
 
-        if (m_ulChannel == 0) {
-            m_DataBuffer[sampleIndex] = sample;
-         
-            m_ulSamplesTransferred += 1;
+        sampleIndex += 1;
+        if (sampleIndex == bufferWords) {
+            sampleIndex = 0;
         }
 
-        m_ulChannel = 0x01 & (m_ulChannel + 1);
+        m_ulSamplesTransferred += 1;
+        words -= 2;
+    }
 
-        FifoControl.AsUlong = READ_REGISTER_ULONG(&m_pSaiRegisters->ReceiveFifoRegister.AsUlong);
-    } 
+    if (words == 1)
+    {
+        sample = READ_REGISTER_ULONG(&m_pSaiRegisters->ReceiveDataRegister.AsUlong);
+
+        m_DataBuffer[sampleIndex] = sample & 0xffffff00;
+
+        m_ulSamplesTransferred += 1;
+        m_ulChannel = 1;
+    }
 
     m_pRtStream->UpdateVirtualPositionRegisters(m_ulSamplesTransferred);
 }
@@ -142,6 +178,8 @@ CDmaBuffer::UnregisterStream
     UNREFERENCED_PARAMETER(Stream);
     ASSERT(m_pRtStream == Stream);
 
+    m_DmaChannel.Stop();
+
     m_pRtStream = NULL;
     m_ulSamplesTransferred = 0;
     m_ulChannel = 0;
@@ -150,6 +188,59 @@ CDmaBuffer::UnregisterStream
     m_pWfExt = NULL;
 }
 
+#pragma code_seg()
+NTSTATUS
+CDmaBuffer::StartDmaTransfer()
+{
+    ULONG notifications;
+    ULONG notificationBytes;
+
+    //
+    // Notify at least twice per buffer so that the virtual position used for
+    // the notification events keeps following the DMA.
+    //
+    notifications = max(m_pRtStream->GetNotificationsPerBuffer(), 2UL);
+    notificationBytes = m_ulDmaBufferSize / notifications;
+    notificationBytes -= notificationBytes % m_pWfExt->Format.nBlockAlign;
+
+    m_ulSamplesTransferred = 0;
+    m_ulLastDmaPosition = 0;
+    m_ullDmaBytesTransferred = 0;
+
+    return m_DmaChannel.Start(m_pRtStream->GetDmaBufferMdl(),
+                              m_ulDmaBufferSize,
+                              notificationBytes,
+                              &CDmaBuffer::DmaNotification,
+                              this);
+}
+
+#pragma code_seg()
+VOID
+CDmaBuffer::StopDmaTransfer()
+{
+    m_DmaChannel.Stop();
+}
+
+#pragma code_seg()
+VOID
+CDmaBuffer::DmaNotification
+(
+    _In_ PVOID Context
+)
+{
+    CDmaBuffer* me = (CDmaBuffer*) Context;
+    ULONG position;
+
+    position = me->m_DmaChannel.GetPosition();
+
+    me->m_ullDmaBytesTransferred += (position + me->m_ulDmaBufferSize - me->m_ulLastDmaPosition) % me->m_ulDmaBufferSize;
+    me->m_ulLastDmaPosition = position;
+
+    me->m_ulSamplesTransferred = (ULONG)(me->m_ullDmaBytesTransferred / me->m_pWfExt->Format.nBlockAlign);
+
+    me->m_pRtStream->UpdateVirtualPositionRegisters(me->m_ulSamplesTransferred);
+}
+
 
 CSoc::CSoc()
 {
@@ -218,6 +309,116 @@ CSoc::UnregisterStream
     return STATUS_SUCCESS;
 }
 
+#pragma code_seg("PAGE")
+NTSTATUS
+CSoc::InitDma
+(
+    _In_ PHYSICAL_ADDRESS SaiPhysicalAddress,
+    _In_opt_ PCM_PARTIAL_RESOURCE_DESCRIPTOR TxDmaDescriptor,
+    _In_opt_ PCM_PARTIAL_RESOURCE_DESCRIPTOR RxDmaDescriptor
+)
+/*++
+
+Routine Description:
+
+    Sets up SDMA transfers between the WaveRT buffers and the SAI data
+    registers. Streams without a DMA resource, or whose DMA channel cannot
+    be opened, keep being serviced from the FIFO request interrupt.
+
+Arguments:
+
+    SaiPhysicalAddress - physical address of the SAI register block.
+
+    TxDmaDescriptor - FixedDMA resource of the transmitter, if any.
+
+    RxDmaDescriptor - FixedDMA resource of the receiver, if any.
+
+Return Value:
+
+    NT status code
+
+--*/
+{
+    PHYSICAL_ADDRESS dataRegisterAddress;
+    SAI_RECEIVE_MASK_REGISTER ReceiveMaskRegister;
+    NTSTATUS status;
+
+    PAGED_CODE();
+
+    if (TxDmaDescriptor != NULL)
+    {
+        //
+        // The SAI requests a transfer when no more than SAI_TX_FIFO_WATERMARK
+        // words are left in the transmit FIFO.
+        //
+        dataRegisterAddress.QuadPart = SaiPhysicalAddress.QuadPart + FIELD_OFFSET(SAI_REGISTERS, TransmitDataRegister);
+
+        status = m_Buffer[eSpeakerHpDevice].InitDma(m_pPDO,
+                                                    TxDmaDescriptor,
+                                                    dataRegisterAddress,
+                                                    TRUE,
+                                                    (SAI_FIFO_DEPTH - SAI_TX_FIFO_WATERMARK) * sizeof(ULONG));
+        if (!NT_SUCCESS(status))
+        {
+            DPF(D_ERROR, ("[CSoc::InitDma] render DMA not available, using FIFO interrupts, 0x%x", status));
+        }
+    }
+
+    if (RxDmaDescriptor != NULL)
+    {
+        //
+        // The SAI requests a transfer when more than SAI_RX_FIFO_WATERMARK
+        // words are in the receive FIFO.
+        //
+        dataRegisterAddress.QuadPart = SaiPhysicalAddress.QuadPart + FIELD_OFFSET(SAI_REGISTERS, ReceiveDataRegister);
+
+        status = m_Buffer[eMicInDevice].InitDma(m_pPDO,
+                                                RxDmaDescriptor,
+                                                dataRegisterAddress,
+                                                FALSE,
+                                                (SAI_RX_FIFO_WATERMARK + 1) * sizeof(ULONG));
+        if (NT_SUCCESS(status))
+        {
+            //
+            // Capture is mono. Only receive the first word of each frame so
+            // that the FIFO content can be moved to the buffer as is.
+            //
+            ReceiveMaskRegister.AsUlong = ~0x1u;
+            WRITE_REGISTER_ULONG(&m_pSaiRegisters->ReceiveMaskRegister.AsUlong, ReceiveMaskRegister.AsUlong);
+        }
+        else
+        {
+            DPF(D_ERROR, ("[CSoc::InitDma] capture DMA not available, using FIFO interrupts, 0x%x", status));
+        }
+    }
+
+    return STATUS_SUCCESS;
+}
+
+#pragma code_seg()
+NTSTATUS
+CSoc::GetDmaPosition
+(
+    _In_        CMiniportWaveRTStream* Stream,
+    _Out_       PULONG Position
+)
+{
+    ULONG i;
+
+    *Position = 0;
+
+    for (i = 0; i < eMaxDeviceType; i++)
+    {
+        if (m_Buffer[i].IsMyStream(Stream) && m_Buffer[i].IsDmaRunning())
+        {
+            *Position = m_Buffer[i].GetDmaPosition();
+            return STATUS_SUCCESS;
+        }
+    }
+
+    return STATUS_NOT_SUPPORTED;
+}
+
 #pragma code_seg("PAGE")
 NTSTATUS
 CSoc::SetupClocks()
@@ -255,8 +456,8 @@ CSoc::SetupClocks()
     TransmitConfigReg1.AsUlong = 0;
     ReceiveConfigReg1.AsUlong = 0;
 
-    TransmitConfigReg1.TransmitFifoWatermark = 0xC;
-    ReceiveConfigReg1.ReceiveFifoWatermark = 0xC;
+    TransmitConfigReg1.TransmitFifoWatermark = SAI_TX_FIFO_WATERMARK;
+    ReceiveConfigReg1.ReceiveFifoWatermark = SAI_RX_FIFO_WATERMARK;
 
     WRITE_REGISTER_ULONG(&m_pSaiRegisters->TransmitConfigRegister1.AsUlong, TransmitConfigReg1.AsUlong);
     WRITE_REGISTER_ULONG(&m_pSaiRegisters->ReceiveConfigRegister1.AsUlong, ReceiveConfigReg1.AsUlong);
@@ -419,12 +620,15 @@ CSoc::EnableInterruptsNoLock()
     TransmitControlRegister.AsUlong = READ_REGISTER_ULONG(&m_pSaiRegisters->TransmitControlRegister.AsUlong);
     ReceiveControlRegister.AsUlong = READ_REGISTER_ULONG(&m_pSaiRegisters->ReceiveControlRegister.AsUlong);
 
-    if (m_bIsRenderActive == TRUE)
+    //
+    // Streams moved by the SDMA are driven by the FIFO DMA request instead.
+    //
+    if ((m_bIsRenderActive == TRUE) && !m_Buffer[eSpeakerHpDevice].UsesDma())
     {
         TransmitControlRegister.FifoRequestInterruptEnable = 1;
     }
 
-    if (m_bIsCaptureActive == TRUE)
+    if ((m_bIsCaptureActive == TRUE) && !m_Buffer[eMicInDevice].UsesDma())
     {
         ReceiveControlRegister.FifoRequestInterruptEnable = 1;
     }
@@ -484,6 +688,23 @@ CSoc::StartDma
     SAI_TRANSMIT_CONTROL_REGISTER TransmitControlRegister;
     SAI_RECEIVE_CONTROL_REGISTER ReceiveControlRegister;
     KIRQL irql;
+    NTSTATUS status;
+
+    //
+    // The SDMA channel is armed before the SAI raises its first DMA request.
+    // A paused stream keeps its channel, so it resumes where it stopped.
+    //
+    for (ULONG i = 0; i < eMaxDeviceType; i++)
+    {
+        if (m_Buffer[i].IsMyStream(Stream) && m_Buffer[i].UsesDma() && !m_Buffer[i].IsDmaRunning())
+        {
+            status = m_Buffer[i].StartDmaTransfer();
+            if (!NT_SUCCESS(status))
+            {
+                return status;
+            }
+        }
+    }
 
     irql = AcquireIsrSpinLock();
 
@@ -511,11 +732,14 @@ CSoc::StartDma
     {
         m_Buffer[eMicInDevice].ResetRxFifo();
         ReceiveControlRegister.AsUlong = READ_REGISTER_ULONG(&m_pSaiRegisters->ReceiveControlRegister.AsUlong);
+        ReceiveControlRegister.FifoRequestDMAEnable = m_Buffer[eMicInDevice].UsesDma() ? 1 : 0;
         ReceiveControlRegister.ReceiverEnable = 1;
         WRITE_REGISTER_ULONG(&m_pSaiRegisters->ReceiveControlRegister.AsUlong, ReceiveControlRegister.AsUlong);
 
-        // Rx is synchronous on Tx, so Tx must be enabled
+        // Rx is synchronous on Tx, so Tx must be enabled. The Tx reset above also
+        // cleared the DMA request of a running render stream.
         TransmitControlRegister.AsUlong = READ_REGISTER_ULONG(&m_pSaiRegisters->TransmitControlRegister.AsUlong);
+        TransmitControlRegister.FifoRequestDMAEnable = ((m_bIsRenderActive == TRUE) && m_Buffer[eSpeakerHpDevice].IsDmaRunning()) ? 1 : 0;
         TransmitControlRegister.TransmitterEnable = 1;
         WRITE_REGISTER_ULONG(&m_pSaiRegisters->TransmitControlRegister.AsUlong, TransmitControlRegister.AsUlong);
 
@@ -524,9 +748,18 @@ CSoc::StartDma
     else if (m_Buffer[eSpeakerHpDevice].IsMyStream(Stream))
     {
         m_Buffer[eSpeakerHpDevice].ResetTxFifo();
-        m_Buffer[eSpeakerHpDevice].FillFifos();
 
         TransmitControlRegister.AsUlong = READ_REGISTER_ULONG(&m_pSaiRegisters->TransmitControlRegister.AsUlong);
+
+        if (m_Buffer[eSpeakerHpDevice].UsesDma())
+        {
+            TransmitControlRegister.FifoRequestDMAEnable = 1;
+        }
+        else
+        {
+            m_Buffer[eSpeakerHpDevice].FillFifos();
+        }
+
         TransmitControlRegister.TransmitterEnable = 1;
         WRITE_REGISTER_ULONG(&m_pSaiRegisters->TransmitControlRegister.AsUlong, TransmitControlRegister.AsUlong);
 
@@ -557,6 +790,7 @@ CSoc::StopDma
     {
         TransmitControlRegister.AsUlong = READ_REGISTER_ULONG(&m_pSaiRegisters->TransmitControlRegister.AsUlong);
         TransmitControlRegister.TransmitterEnable = 0;
+        TransmitControlRegister.FifoRequestDMAEnable = 0;
         WRITE_REGISTER_ULONG(&m_pSaiRegisters->TransmitControlRegister.AsUlong, TransmitControlRegister.AsUlong);
 
         m_bIsRenderActive = FALSE;
@@ -570,15 +804,27 @@ CSoc::StopDma
 
         ReceiveControlRegister.AsUlong = READ_REGISTER_ULONG(&m_pSaiRegisters->ReceiveControlRegister.AsUlong);
         ReceiveControlRegister.ReceiverEnable = 0;
+        ReceiveControlRegister.FifoRequestDMAEnable = 0;
         WRITE_REGISTER_ULONG(&m_pSaiRegisters->ReceiveControlRegister.AsUlong, ReceiveControlRegister.AsUlong);
 
-        m_Buffer[eMicInDevice].DrainFifos();
+        if (!m_Buffer[eMicInDevice].UsesDma())
+        {
+            m_Buffer[eMicInDevice].DrainFifos();
+        }
 
         m_bIsCaptureActive = FALSE;
     }
 
     ReleaseIsrSpinLock(irql);
 
+    for (ULONG i = 0; i < eMaxDeviceType; i++)
+    {
+        if (m_Buffer[i].IsMyStream(Stream))
+        {
+            m_Buffer[i].StopDmaTransfer();
+        }
+    }
+
     // EnableInterrupts will properly set the enables based on the active streams (if any.)
     EnableInterrupts();
 
@@ -607,8 +853,12 @@ CSoc::PauseDma
     }
     else if (m_Buffer[eSpeakerHpDevice].IsMyStream(Stream))
     {
+        //
+        // A paused DMA stream keeps its SDMA channel, only the requests stop.
+        //
         TransmitControlRegister.AsUlong = READ_REGISTER_ULONG(&m_pSaiRegisters->TransmitControlRegister.AsUlong);
         TransmitControlRegister.TransmitterEnable = 0;
+        TransmitControlRegister.FifoRequestDMAEnable = 0;
         WRITE_REGISTER_ULONG(&m_pSaiRegisters->TransmitControlRegister.AsUlong, TransmitControlRegister.AsUlong);
 
         m_bIsRenderActive = FALSE;
@@ -622,9 +872,13 @@ CSoc::PauseDma
 
         ReceiveControlRegister.AsUlong = READ_REGISTER_ULONG(&m_pSaiRegisters->ReceiveControlRegister.AsUlong);
         ReceiveControlRegister.ReceiverEnable = 0;
+        ReceiveControlRegister.FifoRequestDMAEnable = 0;
         WRITE_REGISTER_ULONG(&m_pSaiRegisters->ReceiveControlRegister.AsUlong, ReceiveControlRegister.AsUlong);
 
-        m_Buffer[eMicInDevice].DrainFifos();
+        if (!m_Buffer[eMicInDevice].UsesDma())
+        {
+            m_Buffer[eMicInDevice].DrainFifos();
+        }
 
         m_bIsCaptureActive = FALSE;
     }
@@ -685,12 +939,14 @@ CSoc::DoIsrWork ()
     if (ReceiveControlRegister.FifoWarningFlag)
         cntRxFifoWarning ++;
 
-    if ((ReceiveControlRegister.FifoWarningFlag == 1 || ReceiveControlRegister.FifoRequestFlag == 1) && m_bIsCaptureActive == TRUE)
+    if ((ReceiveControlRegister.FifoWarningFlag == 1 || ReceiveControlRegister.FifoRequestFlag == 1) && m_bIsCaptureActive == TRUE &&
+        !m_Buffer[eMicInDevice].UsesDma())
     {
         m_Buffer[eMicInDevice].DrainFifos();
     }
 
-    if ((TransmitControlRegister.FifoWarningFlag == 1 || TransmitControlRegister.FifoRequestFlag == 1) && m_bIsRenderActive == TRUE)
+    if ((TransmitControlRegister.FifoWarningFlag == 1 || TransmitControlRegister.FifoRequestFlag == 1) && m_bIsRenderActive == TRUE &&
+        !m_Buffer[eSpeakerHpDevice].UsesDma())
     {
         m_Buffer[eSpeakerHpDevice].FillFifos();
     }
@@ -11,6 +11,16 @@ Abstract:
 #include "common.h"
 #include "imx_sairegs.h"
 #include "minwavertstream.h"
+#include "sdmachannel.h"
+
+//
+// Depth of the SAI transmit and receive FIFOs in 32 bit words, and the
+// watermarks at which the FIFO request flag (and DMA request) is raised:
+// transmit when the FIFO is half empty, receive when it is half full.
+//
+#define SAI_FIFO_DEPTH          32
+#define SAI_TX_FIFO_WATERMARK   (SAI_FIFO_DEPTH / 2)
+#define SAI_RX_FIFO_WATERMARK   (SAI_FIFO_DEPTH / 2 - 1)
 
 class CSoc;
 
@@ -25,6 +35,37 @@ public:
         m_pSaiRegisters = SaiRegisters;
     }
 
+    NTSTATUS InitDma
+    (
+        _In_ PDEVICE_OBJECT PDO,
+        _In_ PCM_PARTIAL_RESOURCE_DESCRIPTOR DmaDescriptor,
+        _In_ PHYSICAL_ADDRESS DataRegisterAddress,
+        _In_ BOOLEAN WriteToDevice,
+        _In_ ULONG WatermarkBytes
+    )
+    {
+        return m_DmaChannel.Init(PDO, DmaDescriptor, DataRegisterAddress, WriteToDevice, WatermarkBytes);
+    }
+
+    BOOLEAN UsesDma()
+    {
+        return m_DmaChannel.IsInitialized();
+    }
+
+    BOOLEAN IsDmaRunning()
+    {
+        return m_DmaChannel.IsRunning();
+    }
+
+    ULONG GetDmaPosition()
+    {
+        return m_DmaChannel.GetPosition();
+    }
+
+    NTSTATUS StartDmaTransfer();
+
+    VOID StopDmaTransfer();
+
     BOOLEAN IsMyStream(CMiniportWaveRTStream* stream)
     {
         if (stream == m_pRtStream)
@@ -71,6 +112,8 @@ public:
 
 private:
 
+    static SDMA_CHANNEL_NOTIFICATION DmaNotification;
+
     ULONG                  m_ulSamplesTransferred;
     ULONG                  m_ulChannel;
     CMiniportWaveRTStream* m_pRtStream;
@@ -79,6 +122,10 @@ private:
     ULONG                  m_ulDmaBufferSize;
     eDeviceType            m_DeviceType;
 
+    CSdmaChannel           m_DmaChannel;
+    ULONG                  m_ulLastDmaPosition;
+    ULONGLONG              m_ullDmaBytesTransferred;
+
     volatile PSAI_REGISTERS          m_pSaiRegisters;
 };
 
@@ -106,6 +153,27 @@ public:
         return SetupClocks();
     }
 
+    NTSTATUS InitDma
+    (
+        _In_ PHYSICAL_ADDRESS SaiPhysicalAddress,
+        _In_opt_ PCM_PARTIAL_RESOURCE_DESCRIPTOR TxDmaDescriptor,
+        _In_opt_ PCM_PARTIAL_RESOURCE_DESCRIPTOR RxDmaDescriptor
+    );
+
+    BOOLEAN IsDmaSupported
+    (
+                    eDeviceType DeviceType
+    )
+    {
+        return m_Buffer[DeviceType].UsesDma();
+    }
+
+    NTSTATUS GetDmaPosition
+    (
+        _In_        CMiniportWaveRTStream* Stream,
+        _Out_       PULONG Position
+    );
+
     NTSTATUS RegisterStream
     (
         _In_        CMiniportWaveRTStream* Stream,
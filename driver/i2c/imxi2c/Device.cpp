@@ -54,7 +54,6 @@ NTSTATUS OnPrepareHardware(
     PDEVICE_CONTEXT deviceCtxPtr = NULL;
     NTSTATUS status = STATUS_SUCCESS;
     PCM_PARTIAL_RESOURCE_DESCRIPTOR res;
-    UNREFERENCED_PARAMETER(FxResourcesRaw);
     int iCountMemoryRes = 1;  // on Sabre must have one memory resource
     int iCountInterruptRes = 1; // on Sabre must have one interrupt resource
 
@@ -152,11 +151,41 @@ NTSTATUS OnPrepareHardware(
             case CmResourceTypeInterrupt:
             TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_DEVICE, "ACPI resource %lu - interrupt.", i);
             iCountInterruptRes-=1;
-            deviceCtxPtr->RegistersCb = res->u.Memory.Length;
             TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_DEVICE, "Interrupt vect=%Xh disp=%Xh affin=%IXh",
                 res->u.Interrupt.Vector,
                 res->ShareDisposition,
                 res->u.Interrupt.Affinity);
+
+            // create the interrupt object for interrupt driven transfers.
+            // on failure transfers fall back to polled mode.
+
+            {
+                WDF_INTERRUPT_CONFIG interruptConfig;
+                WDF_OBJECT_ATTRIBUTES interruptAttributes;
+                NTSTATUS interruptStatus;
+
+                WDF_INTERRUPT_CONFIG_INIT(&interruptConfig, OnInterruptIsr, OnInterruptDpc);
+                interruptConfig.InterruptRaw = WdfCmResourceListGetDescriptor(FxResourcesRaw, i);
+                interruptConfig.InterruptTranslated = res;
+
+                WDF_OBJECT_ATTRIBUTES_INIT(&interruptAttributes);
+                interruptAttributes.ParentObject = WdfDevice;
+
+                interruptStatus = WdfInterruptCreate(WdfDevice,
+                                                     &interruptConfig,
+                                                     &interruptAttributes,
+                                                     &deviceCtxPtr->InterruptObj);
+
+                if(!NT_SUCCESS(interruptStatus)) {
+
+                    TraceEvents(TRACE_LEVEL_WARNING, TRACE_DEVICE,
+                        "Failed to create interrupt for WDFDEVICE %p, using polled mode - Err=%Xh",
+                        deviceCtxPtr->WdfDevice,
+                        interruptStatus);
+
+                    deviceCtxPtr->InterruptObj = NULL;
+                }
+            }
             break;
 
             default:
@@ -225,6 +254,10 @@ NTSTATUS OnReleaseHardware(
         deviceCtxPtr->RegistersCb = 0;
     };
 
+    // the framework deletes the interrupt object created in OnPrepareHardware
+
+    deviceCtxPtr->InterruptObj = NULL;
+
     TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_DEVICE, "--OnReleaseHardware()=%Xh",status);
 
     return status;
@@ -1068,8 +1101,21 @@ VOID OnCancel(WDFREQUEST Request)
             "Delay timer previously schedule, now stopped");
     }
 
+    // Stop the interrupt driven byte engine, a DPC already queued
+    // will find the transfer idle.
+
+    WdfTimerStop(deviceCtxPtr->TransferTimer, FALSE);
+    requestPtr->TransferState = I2cTransferStateIdle;
+
     deviceCtxPtr->RegistersPtr->ControlReg = deviceCtxPtr->RegistersPtr->ControlReg & ~IMX_I2C_CTRL_REG_IIEN_MASK;
 
+    if(deviceCtxPtr->InterruptObj != NULL) {
+
+        WdfInterruptAcquireLock(deviceCtxPtr->InterruptObj);
+        deviceCtxPtr->InterruptStatus = 0;
+        WdfInterruptReleaseLock(deviceCtxPtr->InterruptObj);
+    }
+
     // Abort the current IO operation
 
     ControllerGenerateStop(deviceCtxPtr);
@@ -1190,6 +1236,251 @@ exit:
     return;
 }
 
+/*++
+
+  Routine Description:
+
+    This routine is invoked when an interrupt driven transfer
+    did not complete in time. It aborts the transfer.
+
+  Arguments:
+
+    Timer - a handle to a framework timer object
+
+  Return Value:
+
+    None.
+
+--*/
+_Use_decl_annotations_
+VOID OnTransferTimerExpired(WDFTIMER Timer)
+{
+    TraceEvents(TRACE_LEVEL_VERBOSE, TRACE_DEVICE, "++OnTransferTimerExpired()");
+
+    WDFDEVICE fxDevice;
+    PDEVICE_CONTEXT deviceCtxPtr;
+    PPBC_TARGET targetPtr = NULL;
+    PPBC_REQUEST requestPtr = NULL;
+    BOOLEAN completeRequest = FALSE;
+
+    fxDevice = (WDFDEVICE) WdfTimerGetParentObject(Timer);
+    deviceCtxPtr = GetDeviceContext(fxDevice);
+
+    NT_ASSERT(deviceCtxPtr != NULL);
+
+    // Acquire the device lock.
+
+    WdfSpinLockAcquire(deviceCtxPtr->Lock);
+
+    // Make sure the target and request are still valid,
+    // and the transfer has not completed meanwhile.
+
+    targetPtr = deviceCtxPtr->CurrentTargetPtr;
+
+    if(targetPtr == NULL) {
+
+        goto exit;
+    }
+
+    requestPtr = targetPtr->CurrentRequestPtr;
+
+    if(requestPtr == NULL || requestPtr->TransferState == I2cTransferStateIdle) {
+
+        goto exit;
+    }
+
+    TraceEvents(TRACE_LEVEL_ERROR, TRACE_DEVICE,
+        "Interrupt mode transfer timed out in state %d after %Iu of %Iu bytes "
+        "(SPBREQUEST %p)",
+        requestPtr->TransferState,
+        requestPtr->Information,
+        requestPtr->Length,
+        requestPtr->SpbRequest);
+
+    requestPtr->Status = STATUS_IO_TIMEOUT;
+
+    ControllerFinishInterruptTransfer(deviceCtxPtr, requestPtr, STATUS_IO_TIMEOUT);
+
+    if(requestPtr->bIoComplete) {
+
+        completeRequest = TRUE;
+    }
+
+exit:
+
+    // Release the device lock.
+
+    WdfSpinLockRelease(deviceCtxPtr->Lock);
+
+    if (completeRequest) {
+
+        PbcRequestComplete(requestPtr);
+    }
+
+    TraceEvents(TRACE_LEVEL_VERBOSE, TRACE_DEVICE, "--OnTransferTimerExpired()");
+    return;
+}
+
+/*++
+
+  Routine Description:
+
+    This routine is the controller ISR. The controller raises one
+    interrupt per byte (IIF); the ISR latches and acknowledges it,
+    and the byte engine runs from the DPC.
+
+  Arguments:
+
+    Interrupt - a handle to a framework interrupt object
+    MessageID - message number identifying the device's
+        hardware interrupt message (if using MSI)
+
+  Return Value:
+
+    TRUE if interrupt recognized.
+
+--*/
+_Use_decl_annotations_
+BOOLEAN OnInterruptIsr(
+    WDFINTERRUPT Interrupt,
+    ULONG MessageID
+    )
+{
+    PDEVICE_CONTEXT deviceCtxPtr;
+    USHORT statusReg;
+
+    UNREFERENCED_PARAMETER(MessageID);
+
+    deviceCtxPtr = GetDeviceContext(WdfInterruptGetDevice(Interrupt));
+
+    // polled transfers leave IIEN clear and handle IIF themselves
+
+    if((deviceCtxPtr->RegistersPtr->ControlReg & IMX_I2C_CTRL_REG_IIEN_MASK) == 0) {
+
+        return FALSE;
+    }
+
+    statusReg = deviceCtxPtr->RegistersPtr->StatusReg;
+
+    if((statusReg & IMX_I2C_STA_REG_IIF_MASK) == 0) {
+
+        return FALSE;
+    }
+
+    // acknowledge the interrupt, the controller does not
+    // start the next byte until the DPC services this one
+
+    deviceCtxPtr->RegistersPtr->StatusReg = statusReg & ~IMX_I2C_STA_REG_IIF_MASK;
+
+    deviceCtxPtr->InterruptStatus |= statusReg;
+
+    WdfInterruptQueueDpcForIsr(Interrupt);
+
+    return TRUE;
+}
+
+/*++
+
+  Routine Description:
+
+    This routine is the controller DPC. It advances the current
+    interrupt driven transfer, and completes the request when the
+    transfer sequence is done.
+
+  Arguments:
+
+    Interrupt - a handle to a framework interrupt object
+    AssociatedObject - a handle to the associated framework device object
+
+  Return Value:
+
+    None.
+
+--*/
+_Use_decl_annotations_
+VOID OnInterruptDpc(
+    WDFINTERRUPT Interrupt,
+    WDFOBJECT AssociatedObject
+    )
+{
+    PDEVICE_CONTEXT deviceCtxPtr;
+    PPBC_TARGET targetPtr = NULL;
+    PPBC_REQUEST requestPtr = NULL;
+    BOOLEAN completeRequest = FALSE;
+    USHORT statusReg;
+
+    UNREFERENCED_PARAMETER(AssociatedObject);
+
+    TraceEvents(TRACE_LEVEL_VERBOSE, TRACE_INTRPT, "++OnInterruptDpc()");
+
+    deviceCtxPtr = GetDeviceContext(WdfInterruptGetDevice(Interrupt));
+
+    NT_ASSERT(deviceCtxPtr != NULL);
+
+    // Acquire the device lock.
+
+    WdfSpinLockAcquire(deviceCtxPtr->Lock);
+
+    // Fetch the status latched by the ISR. This is done with the device
+    // lock held, since a transfer that ended meanwhile discards it.
+
+    WdfInterruptAcquireLock(Interrupt);
+    statusReg = deviceCtxPtr->InterruptStatus;
+    deviceCtxPtr->InterruptStatus = 0;
+    WdfInterruptReleaseLock(Interrupt);
+
+    if((statusReg & IMX_I2C_STA_REG_IIF_MASK) == 0) {
+
+        goto exit;
+    }
+
+    // Make sure the target and request are still valid, the
+    // request may have been cancelled or timed out meanwhile.
+
+    targetPtr = deviceCtxPtr->CurrentTargetPtr;
+
+    if(targetPtr == NULL) {
+
+        TraceEvents(TRACE_LEVEL_WARNING, TRACE_INTRPT,
+            "Interrupt DPC without a valid current target for WDFDEVICE %p",
+            deviceCtxPtr->WdfDevice);
+
+        goto exit;
+    }
+
+    requestPtr = targetPtr->CurrentRequestPtr;
+
+    if(requestPtr == NULL || requestPtr->TransferState == I2cTransferStateIdle) {
+
+        TraceEvents(TRACE_LEVEL_WARNING, TRACE_INTRPT,
+            "Interrupt DPC without an active transfer for SPBTARGET %p",
+            targetPtr->SpbTarget);
+
+        goto exit;
+    }
+
+    ControllerProcessInterrupt(deviceCtxPtr, requestPtr, statusReg);
+
+    if(requestPtr->bIoComplete) {
+
+        completeRequest = TRUE;
+    }
+
+exit:
+
+    // Release the device lock.
+
+    WdfSpinLockRelease(deviceCtxPtr->Lock);
+
+    if (completeRequest) {
+
+        PbcRequestComplete(requestPtr);
+    }
+
+    TraceEvents(TRACE_LEVEL_VERBOSE, TRACE_INTRPT, "--OnInterruptDpc()");
+    return;
+}
+
 
 /*++
 
@@ -1319,6 +1610,35 @@ NTSTATUS GetI2cConfigValues(
         goto DoneGetParams;
     }
 
+    status = WdfRegistryQueryULong(hKey, &valueName, &ulTemp);
+
+    if(!NT_SUCCESS(status)) {
+
+        TraceEvents(TRACE_LEVEL_WARNING, TRACE_DRIVER, "GetI2cConfigValues() registry has no value for %S",
+                    USE_INTERRUPT_MODE_VALUE_NAME);
+
+        DriverI2cConfigPtr->UseInterruptMode = 1;
+
+        // if there is no value in registry for some reason, create one now
+
+        status = WdfRegistryAssignULong(hKey, &valueName,
+                                        DriverI2cConfigPtr->UseInterruptMode);
+        if(!NT_SUCCESS(status)) {
+
+            TraceEvents(TRACE_LEVEL_ERROR, TRACE_DRIVER,
+                "GetI2cConfigValues() Error %Xh to write to registry the value for %S",
+                status,
+                USE_INTERRUPT_MODE_VALUE_NAME);
+        }
+    } else {
+            TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_DRIVER,
+                        "GetI2cConfigValues()  %S value from registry %lu",
+                        USE_INTERRUPT_MODE_VALUE_NAME,
+                        ulTemp);
+
+            DriverI2cConfigPtr->UseInterruptMode = ulTemp;
+    }
+
     DriverI2cConfigPtr->DelayBeforeStart_us = 0;
 
     TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_DRIVER, "--GetI2cConfigValues()=%Xh", status);
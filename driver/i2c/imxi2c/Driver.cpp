@@ -340,6 +340,31 @@ NTSTATUS OnDeviceAdd(
         }
     }
 
+    // Create the watchdog timer for interrupt driven transfers.
+
+    {
+        WDF_TIMER_CONFIG wdfTimerConfig;
+        WDF_OBJECT_ATTRIBUTES timerAttributes;
+
+        WDF_TIMER_CONFIG_INIT(&wdfTimerConfig, OnTransferTimerExpired);
+        WDF_OBJECT_ATTRIBUTES_INIT(&timerAttributes);
+        timerAttributes.ParentObject = pDeviceCtx->WdfDevice;
+
+        status = WdfTimerCreate(&wdfTimerConfig,
+                                &timerAttributes,
+                                &(pDeviceCtx->TransferTimer));
+
+        if (!NT_SUCCESS(status)) {
+
+            TraceEvents(TRACE_LEVEL_ERROR, TRACE_CTRLR,
+                        "Failed to create transfer timer for WDFDEVICE %p - Err=%Xh",
+                        pDeviceCtx->WdfDevice,
+                        status);
+
+            goto OnDeviceAddErr;
+        }
+    }
+
     // Create the spin lock to synchronize access
     // to the controller driver.
 
@@ -392,6 +417,7 @@ NTSTATUS OnDeviceAdd(
 
     pDeviceCtx->ModuleClock_kHz = I2cConfigDataSt.ModuleClock_kHz;
     pDeviceCtx->PeripheralAccessClock_kHz = I2cConfigDataSt.PeripheralClock_kHz;
+    pDeviceCtx->bUseInterruptMode = (I2cConfigDataSt.UseInterruptMode != 0) ? TRUE : FALSE;
 
 OnDeviceAddErr:
 
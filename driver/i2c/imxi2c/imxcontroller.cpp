@@ -118,124 +118,141 @@ NTSTATUS ControllerInitialize(PDEVICE_CONTEXT DeviceCtxPtr)
 
   Routine Description:
 
-    This routine finds best fit clock divider for given i2c clock speed in kHz
+    This routine solves the IFDR divider for a given i2c bus speed. All
+    entries of the divider table are scanned and the one yielding the
+    fastest SCL rate that does not exceed the requested speed for the
+    actual module clock is selected.
 
   Arguments:
 
-    DeviceCtxPtr - a pointer to device context
-    DesiredClockFrequencyHz - desired bus clock frequency in kHz
+    ModuleClock_kHz - i2c module (root) clock frequency in kHz
+    DesiredClockFrequencyHz - desired bus clock frequency in Hz
+    DividerIndexPtr - receives the IFDR value to program
+    ActualClockFrequencyHzPtr - receives the resulting bus clock frequency in Hz
 
   Return Value:
 
-    status_success if it was possible to find close enough divider in the table
-    error if not
+    status_success if the speed is in the supported range, error if not
 
 --*/
 _Use_decl_annotations_
-NTSTATUS SetControllerClockDiv(
-    PDEVICE_CONTEXT DeviceCtxPtr,
-    ULONG DesiredClockFrequencyHz
+NTSTATUS ControllerSolveClockDiv(
+    ULONG ModuleClock_kHz,
+    ULONG DesiredClockFrequencyHz,
+    USHORT* DividerIndexPtr,
+    ULONG* ActualClockFrequencyHzPtr
     )
 {
     NTSTATUS status = STATUS_SUCCESS;
-    USHORT estimatedDivider = 0;
-    int iFirstRd = 0;
-    int iSecondRd = 0;
-    TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_CTRLR,
-                "++SetControllerClockDiv(%lu Hz)",
-                DesiredClockFrequencyHz);
-
-    // perform validation
+    ULONGLONG moduleClockHz = (ULONGLONG)ModuleClock_kHz * 1000;
+    ULONG bestIdx = I2C_DIV_TAB_SIZE;
+    ULONG idx = 0;
 
     if(DesiredClockFrequencyHz > IMX_I2C_MAX_CONNECTION_SPEED ||
-                        DesiredClockFrequencyHz < IMX_I2C_MIN_CONNECTION_SPEED) {
-
+        DesiredClockFrequencyHz < IMX_I2C_MIN_CONNECTION_SPEED ||
+        ModuleClock_kHz == 0) {
 
         // error - out of range
 
         status = STATUS_NOT_SUPPORTED;
-        goto SetClockFreqDone;
+        goto SolveClockDivDone;
     }
 
-    estimatedDivider=(USHORT)((DeviceCtxPtr->ModuleClock_kHz*1000) / DesiredClockFrequencyHz);
+    // the bus must not be clocked faster than requested, so pick the smallest
+    // divider whose SCL rate is at or below the target. Equal dividers appear
+    // twice in the table, keep the first one found.
 
-    // round divider up
+    for(idx = 0; idx < I2C_DIV_TAB_SIZE; idx++) {
 
-    if((DeviceCtxPtr->ModuleClock_kHz * 1000 -
-        (DesiredClockFrequencyHz * estimatedDivider)) * 100 >
-            DeviceCtxPtr->ModuleClock_kHz * 1000) {
-
-        estimatedDivider += 1;
-    }
+        if(moduleClockHz > (ULONGLONG)DesiredClockFrequencyHz * I2C_Clock_Rate_Dividers_Table[idx]) {
 
-    // now perform a search in imx6 table of dividers
-    // use left part of the table first
+            continue;
+        }
 
-    for(iFirstRd = 0; iFirstRd < (I2C_DIV_TAB_SIZE/2 - 1); iFirstRd++) {
-        // Once found a divider greater than the estimate, stop
+        if(bestIdx == I2C_DIV_TAB_SIZE ||
+            I2C_Clock_Rate_Dividers_Table[idx] < I2C_Clock_Rate_Dividers_Table[bestIdx]) {
 
-        if (estimatedDivider <= I2C_Clock_Rate_Dividers_Table[iFirstRd])
-            break;
+            bestIdx = idx;
+        }
     }
 
-    if(estimatedDivider == I2C_Clock_Rate_Dividers_Table[iFirstRd]) {
+    if(bestIdx == I2C_DIV_TAB_SIZE) {
 
+        // module clock is too fast even for the largest divider
 
-        // If the estimated divider matched one of the array entries, no need
-        // to search further
+        for(idx = 0; idx < I2C_DIV_TAB_SIZE; idx++) {
 
-        estimatedDivider = (USHORT)iFirstRd;
-    } else {
-        // look int the right part of the table
+            if(I2C_Clock_Rate_Dividers_Table[idx] == I2C_MAXDIVIDER) {
 
-        for (iSecondRd = (I2C_DIV_TAB_SIZE/2); iSecondRd < (I2C_DIV_TAB_SIZE-1); iSecondRd++)
-        {
-            // Again, if a greater entry is found, stop
-
-            if (estimatedDivider <= I2C_Clock_Rate_Dividers_Table[iSecondRd])
+                bestIdx = idx;
                 break;
+            }
         }
 
-        if (estimatedDivider == I2C_Clock_Rate_Dividers_Table[iSecondRd]) {
+        TraceEvents(TRACE_LEVEL_WARNING, TRACE_CTRLR,
+                    "ControllerSolveClockDiv() module clock %lu kHz too fast for %lu Hz, using max divider",
+                    ModuleClock_kHz,
+                    DesiredClockFrequencyHz);
+    }
 
-            // If the estimated divider is found in the second round, stop
+    *DividerIndexPtr = (USHORT)bestIdx;
+    *ActualClockFrequencyHzPtr =
+        (ULONG)(moduleClockHz / I2C_Clock_Rate_Dividers_Table[bestIdx]);
 
-            estimatedDivider = (USHORT)iSecondRd;
+    TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_CTRLR,
+                "ControllerSolveClockDiv() %lu kHz / %u = %lu Hz (requested %lu Hz, idx=%lu)",
+                ModuleClock_kHz,
+                I2C_Clock_Rate_Dividers_Table[bestIdx],
+                *ActualClockFrequencyHzPtr,
+                DesiredClockFrequencyHz,
+                bestIdx);
 
-        } else {
-            // Search for the nearest divider among the 2 portion of the array
+SolveClockDivDone:
 
-            if ((I2C_Clock_Rate_Dividers_Table[iFirstRd] > estimatedDivider) &&
-                            (I2C_Clock_Rate_Dividers_Table[iSecondRd] > estimatedDivider)) {
+    return status;
+}
 
-                if ((I2C_Clock_Rate_Dividers_Table[iFirstRd] - estimatedDivider) <
-                            (I2C_Clock_Rate_Dividers_Table[iSecondRd] - estimatedDivider)) {
+/*++
 
-                    estimatedDivider = (USHORT)iFirstRd;
+  Routine Description:
 
-                    } else {
+    This routine programs the best fit clock divider for given i2c clock speed
 
-                    estimatedDivider = (USHORT)iSecondRd;
-                    }
-            } else {
-                if (I2C_Clock_Rate_Dividers_Table[iSecondRd] > estimatedDivider) {
+  Arguments:
 
-                    estimatedDivider = (USHORT)iSecondRd;
-                } else {
-                    // Less than setting, use I2CClockRateDividersTable[31] as default
+    DeviceCtxPtr - a pointer to device context
+    DesiredClockFrequencyHz - desired bus clock frequency in Hz
 
-                    estimatedDivider = (USHORT)iFirstRd;
-                }
-            }
-        }
-    }
+  Return Value:
+
+    status_success if it was possible to find close enough divider in the table
+    error if not
 
+--*/
+_Use_decl_annotations_
+NTSTATUS SetControllerClockDiv(
+    PDEVICE_CONTEXT DeviceCtxPtr,
+    ULONG DesiredClockFrequencyHz
+    )
+{
+    NTSTATUS status = STATUS_SUCCESS;
+    USHORT dividerIdx = 0;
+    ULONG actualClockFrequencyHz = 0;
     TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_CTRLR,
-                "SetControllerClockDiv() divider: idx=%u, value=%u",
-                estimatedDivider,
-                I2C_Clock_Rate_Dividers_Table[estimatedDivider]);
+                "++SetControllerClockDiv(%lu Hz)",
+                DesiredClockFrequencyHz);
+
+    status = ControllerSolveClockDiv(DeviceCtxPtr->ModuleClock_kHz,
+                                     DesiredClockFrequencyHz,
+                                     &dividerIdx,
+                                     &actualClockFrequencyHz);
 
-    DeviceCtxPtr->RegistersPtr->FreqDivReg = estimatedDivider;
+    if(!NT_SUCCESS(status)) {
+
+        goto SetClockFreqDone;
+    }
+
+    DeviceCtxPtr->RegistersPtr->FreqDivReg = dividerIdx;
 
     TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_CTRLR,
                 "SetControllerClockDiv() ReqDiv Reg=%04Xh",
@@ -414,6 +431,17 @@ VOID ControllerConfigureForTransfer(
     RequestPtr->Settings = g_TransferSettings[RequestPtr->SequencePosition];
     RequestPtr->Status = STATUS_SUCCESS;
 
+    // Use the interrupt driven byte engine unless the controller has no
+    // interrupt, interrupt mode is disabled in the registry, or this is a
+    // very short write which is faster to poll.
+
+    RequestPtr->TransferState = I2cTransferStateIdle;
+    RequestPtr->bInterruptMode = (DeviceCtxPtr->InterruptObj != NULL) &&
+        (DeviceCtxPtr->bUseInterruptMode == TRUE) &&
+        (RequestPtr->Length != 0) &&
+        !(RequestPtr->Direction == SpbTransferDirectionToDevice &&
+          RequestPtr->Length <= IMX_I2C_POLLED_MAX_WRITE_LENGTH);
+
     // Configure hardware for transfer.
 
     // Initialize controller hardware for a general
@@ -428,8 +456,8 @@ VOID ControllerConfigureForTransfer(
 
         // set data sampling rate SCL frequency
 
-        SetControllerClockDiv(DeviceCtxPtr,
-                            DeviceCtxPtr->CurrentTargetPtr->Settings.ConnectionSpeed);
+        DeviceCtxPtr->RegistersPtr->FreqDivReg =
+            DeviceCtxPtr->CurrentTargetPtr->Settings.ClockDividerIdx;
 
         // clear out i2c status
 
@@ -473,6 +501,29 @@ VOID ControllerConfigureForTransfer(
 
     status = ControllerTransferDataMultp(DeviceCtxPtr, RequestPtr);
 
+    if(STATUS_PENDING == status) {
+
+        // the transfer continues from the interrupt DPC.
+        // arm the watchdog in case the bus hangs: ~9 clocks per byte
+        // plus address, with a 10x margin.
+
+        ULONGLONG timeout_us = ((ULONGLONG)RequestPtr->Length + 1) * 9 * 10 * 1000000 /
+                               DeviceCtxPtr->CurrentTargetPtr->Settings.ActualConnectionSpeed;
+
+        if(timeout_us < IMX_I2C_TRANSFER_TIMEOUT_MIN_us) {
+
+            timeout_us = IMX_I2C_TRANSFER_TIMEOUT_MIN_us;
+        }
+
+        TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_CTRLR,
+                    "ControllerConfigureForTransfer() interrupt mode, timeout %I64u us",
+                    timeout_us);
+
+        WdfTimerStart(DeviceCtxPtr->TransferTimer, WDF_REL_TIMEOUT_IN_US(timeout_us));
+
+        goto ControllerConfigureForTransferEnd;
+    }
+
     // complete the request synchronously.
     // partial operations return success per PBC framework
     // do not proceed with next transfer after partial transfer
@@ -485,6 +536,8 @@ VOID ControllerConfigureForTransfer(
         ControllerCompleteTransfer(DeviceCtxPtr, RequestPtr, FALSE);
     }
 
+ControllerConfigureForTransferEnd:
+
     TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_CTRLR, "--ControllerConfigureForTransfer()");
     return;
 }
@@ -528,7 +581,7 @@ NTSTATUS ControllerTransferDataMultp(
     // formula : timeout = 10/Fscl
     // the minimum timeout for polling IIF bit is 25us at 400 kHz (period 2.5us x 10 )
 
-    timeoutMax = ( 10 * 1000000 ) / DeviceCtxPtr->CurrentTargetPtr->Settings.ConnectionSpeed;
+    timeoutMax = (int)DeviceCtxPtr->CurrentTargetPtr->Settings.PollTimeout_us;
 
     TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_CTRLR,
                 "ControllerTransferDataMultp() timeout value=%lu us",
@@ -540,7 +593,7 @@ NTSTATUS ControllerTransferDataMultp(
 
         status = ControllerGenerateStart(DeviceCtxPtr, RequestPtr);
 
-        if(STATUS_SUCCESS != status) {
+        if(!NT_SUCCESS(status)) {
 
             TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_CTRLR,
                         "ControllerTransferDataMultp() Start failed!");
@@ -550,7 +603,7 @@ NTSTATUS ControllerTransferDataMultp(
     } else {
         status = ControllerGenerateRepeatedStart(DeviceCtxPtr, RequestPtr);
 
-        if(STATUS_SUCCESS != status) {
+        if(!NT_SUCCESS(status)) {
 
             TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_CTRLR,
                         "ControllerTransferDataMultp() Repeated Start failed!");
@@ -559,6 +612,14 @@ NTSTATUS ControllerTransferDataMultp(
         }
     }
 
+    // in interrupt mode the slave address is on the wire and the
+    // rest of the transfer is driven by ControllerProcessInterrupt
+
+    if(STATUS_PENDING == status) {
+
+        goto ControllerTransferDataMultpEnd;
+    }
+
     // switch into receive mode if needed prior to loop start
 
     if(RequestPtr->Direction == SpbTransferDirectionFromDevice) {
@@ -866,6 +927,328 @@ ControllerTransferDataMultpEnd:
     return status;
 }
 
+/*++
+
+  Routine Description:
+
+    This routine advances an interrupt driven transfer by one byte.
+    It is called from the interrupt DPC with the device lock held,
+    with the status register value latched by the ISR.
+
+  Arguments:
+
+    DeviceCtxPtr - a pointer to device context
+    RequestPtr - a pointer to the PBC request context
+    StatusReg - status register value at interrupt time
+
+  Return Value:
+
+    None. The transfer is completed when the last byte is done
+    or an error is detected.
+
+--*/
+_Use_decl_annotations_
+VOID ControllerProcessInterrupt(
+    PDEVICE_CONTEXT DeviceCtxPtr,
+    PPBC_REQUEST RequestPtr,
+    USHORT StatusReg
+    )
+{
+    NTSTATUS status = STATUS_SUCCESS;
+    BOOLEAN transferDone = FALSE;
+    UCHAR uchDataByte = 0x00;
+    size_t j = RequestPtr->Information;
+
+    TraceEvents(TRACE_LEVEL_VERBOSE, TRACE_INTRPT,
+                "++ControllerProcessInterrupt() Sts=%04Xh state=%d byte[%Iu]",
+                StatusReg,
+                RequestPtr->TransferState,
+                j);
+
+    NT_ASSERT(RequestPtr->bInterruptMode);
+
+    // arbitration lost terminates the transfer in any state
+
+    if(StatusReg & IMX_I2C_STA_REG_IAL_MASK) {
+
+        TraceEvents(TRACE_LEVEL_ERROR, TRACE_INTRPT,
+                    "ControllerProcessInterrupt() i2c arbitration lost");
+
+        DeviceCtxPtr->RegistersPtr->StatusReg = DeviceCtxPtr->RegistersPtr->StatusReg & ~IMX_I2C_STA_REG_IAL_MASK;
+
+        status = RequestPtr->Status = STATUS_NO_SUCH_DEVICE;
+        goto ControllerProcessInterruptEnd;
+    }
+
+    switch(RequestPtr->TransferState) {
+
+        case I2cTransferStateAddress:
+
+        // check if slave acknowledged its address
+
+        if(StatusReg & IMX_I2C_STA_REG_RXAK_MASK) {
+
+            TraceEvents(TRACE_LEVEL_ERROR, TRACE_INTRPT,
+                        "ControllerProcessInterrupt() slave address was not acknowledged");
+
+            status = RequestPtr->Status = STATUS_NO_SUCH_DEVICE;
+            goto ControllerProcessInterruptEnd;
+        }
+
+        RequestPtr->TransferState = I2cTransferStateData;
+
+        if(RequestPtr->Direction == SpbTransferDirectionToDevice) {
+
+            // send out the first data byte
+
+            status = PbcRequestGetByte(RequestPtr, j, &uchDataByte);
+
+            if(STATUS_SUCCESS != status) {
+
+                TraceEvents(TRACE_LEVEL_ERROR, TRACE_INTRPT,
+                            "ControllerProcessInterrupt(W) error %Xh from request get byte",
+                            status);
+                goto ControllerProcessInterruptEnd;
+            }
+
+            DeviceCtxPtr->RegistersPtr->DataIOReg = (USHORT)uchDataByte;
+        } else {
+
+            // switch into receive mode, nxp application note AN4481
+
+            DeviceCtxPtr->RegistersPtr->ControlReg = DeviceCtxPtr->RegistersPtr->ControlReg & ~IMX_I2C_CTRL_REG_MTX_MASK;
+
+            if(RequestPtr->Length == 1) {
+
+                DeviceCtxPtr->RegistersPtr->ControlReg = DeviceCtxPtr->RegistersPtr->ControlReg | IMX_I2C_CTRL_REG_TXAK_MASK;
+            } else {
+
+                DeviceCtxPtr->RegistersPtr->ControlReg = DeviceCtxPtr->RegistersPtr->ControlReg & ~IMX_I2C_CTRL_REG_TXAK_MASK;
+            }
+
+            // make a dummy read to kick off the first byte
+
+            uchDataByte = (UCHAR)DeviceCtxPtr->RegistersPtr->DataIOReg;
+        }
+        break;
+
+        case I2cTransferStateData:
+
+        if(RequestPtr->Direction == SpbTransferDirectionToDevice) {
+
+            // byte j is out, check for no ack
+
+            if(StatusReg & IMX_I2C_STA_REG_RXAK_MASK) {
+
+                TraceEvents(TRACE_LEVEL_ERROR, TRACE_INTRPT,
+                            "ControllerProcessInterrupt(W) i2c data write not acknowledged!");
+
+                status = STATUS_NO_SUCH_DEVICE;
+                RequestPtr->Status = STATUS_SUCCESS; // to satisfy TAEFF partial write test
+                goto ControllerProcessInterruptEnd;
+            }
+
+            RequestPtr->Information += 1;
+
+            if(RequestPtr->Information == RequestPtr->Length) {
+
+                transferDone = TRUE;
+                break;
+            }
+
+            status = PbcRequestGetByte(RequestPtr, RequestPtr->Information, &uchDataByte);
+
+            if(STATUS_SUCCESS != status) {
+
+                TraceEvents(TRACE_LEVEL_ERROR, TRACE_INTRPT,
+                            "ControllerProcessInterrupt(W) error %Xh from request get byte",
+                            status);
+                goto ControllerProcessInterruptEnd;
+            }
+
+            DeviceCtxPtr->RegistersPtr->DataIOReg = (USHORT)uchDataByte;
+        } else {
+
+            // byte j has been received. Set up the bus for what follows
+            // before reading the data register, since reading it starts
+            // the next byte.
+
+            if(j == RequestPtr->Length-1) {
+
+                if(RequestPtr->SequencePosition == SpbRequestSequencePositionSingle ||
+                    RequestPtr->SequencePosition == SpbRequestSequencePositionLast) {
+
+                    // last byte in sequence - generate stop
+
+                    DeviceCtxPtr->RegistersPtr->ControlReg = DeviceCtxPtr->RegistersPtr->ControlReg & ~IMX_I2C_CTRL_REG_MSTA_MASK;
+                } else {
+
+                    // keep the bus for the repeated start, switching to
+                    // transmit mode stops reading the data register from
+                    // clocking in another byte
+
+                    DeviceCtxPtr->RegistersPtr->ControlReg = DeviceCtxPtr->RegistersPtr->ControlReg | IMX_I2C_CTRL_REG_MTX_MASK;
+                }
+            } else if(j == RequestPtr->Length-2) {
+
+                // do not generate ACK for the last byte
+
+                DeviceCtxPtr->RegistersPtr->ControlReg = DeviceCtxPtr->RegistersPtr->ControlReg | IMX_I2C_CTRL_REG_TXAK_MASK;
+            }
+
+            uchDataByte = (UCHAR)DeviceCtxPtr->RegistersPtr->DataIOReg;
+
+            status = PbcRequestSetByte(RequestPtr, j, uchDataByte);
+
+            if(STATUS_SUCCESS != status) {
+
+                TraceEvents(TRACE_LEVEL_ERROR, TRACE_INTRPT,
+                            "ControllerProcessInterrupt(R) error %Xh from request set byte",
+                            status);
+                goto ControllerProcessInterruptEnd;
+            }
+
+            RequestPtr->Information += 1;
+
+            if(RequestPtr->Information == RequestPtr->Length) {
+
+                transferDone = TRUE;
+            }
+        }
+        break;
+
+        default:
+
+        TraceEvents(TRACE_LEVEL_ERROR, TRACE_INTRPT,
+                    "ControllerProcessInterrupt() unexpected state %d",
+                    RequestPtr->TransferState);
+
+        NT_ASSERT(FALSE);
+        status = RequestPtr->Status = STATUS_DEVICE_DATA_ERROR;
+        break;
+    }
+
+ControllerProcessInterruptEnd:
+
+    // wait for the next byte unless done or failed
+
+    if(transferDone || STATUS_SUCCESS != status) {
+
+        ControllerFinishInterruptTransfer(DeviceCtxPtr, RequestPtr, status);
+    }
+
+    TraceEvents(TRACE_LEVEL_VERBOSE, TRACE_INTRPT,
+                "--ControllerProcessInterrupt()=%Xh",
+                status);
+}
+
+/*++
+
+  Routine Description:
+
+    This routine ends an interrupt driven transfer: it quiesces the
+    interrupt and the watchdog, generates stop if this was the last
+    transfer in the sequence or it failed, and completes the transfer.
+
+  Arguments:
+
+    DeviceCtxPtr - a pointer to device context
+    RequestPtr - a pointer to the PBC request context
+    TransferStatus - status of the transfer
+
+  Return Value:
+
+    None.
+
+--*/
+_Use_decl_annotations_
+VOID ControllerFinishInterruptTransfer(
+    PDEVICE_CONTEXT DeviceCtxPtr,
+    PPBC_REQUEST RequestPtr,
+    NTSTATUS TransferStatus
+    )
+{
+    int n = 0;
+    int timeoutMax = 25;
+
+    TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_CTRLR,
+                "++ControllerFinishInterruptTransfer(%Xh) %Iu of %Iu bytes",
+                TransferStatus,
+                RequestPtr->Information,
+                RequestPtr->Length);
+
+    timeoutMax = (int)DeviceCtxPtr->CurrentTargetPtr->Settings.PollTimeout_us;
+
+    RequestPtr->TransferState = I2cTransferStateIdle;
+
+    DeviceCtxPtr->RegistersPtr->ControlReg = DeviceCtxPtr->RegistersPtr->ControlReg & ~IMX_I2C_CTRL_REG_IIEN_MASK;
+    DeviceCtxPtr->RegistersPtr->StatusReg = DeviceCtxPtr->RegistersPtr->StatusReg & ~IMX_I2C_STA_REG_IIF_MASK;
+
+    // discard any status the ISR latched for a DPC that has not run yet
+
+    WdfInterruptAcquireLock(DeviceCtxPtr->InterruptObj);
+    DeviceCtxPtr->InterruptStatus = 0;
+    WdfInterruptReleaseLock(DeviceCtxPtr->InterruptObj);
+
+    WdfTimerStop(DeviceCtxPtr->TransferTimer, FALSE);
+
+    if(RequestPtr->SequencePosition == SpbRequestSequencePositionSingle ||
+        RequestPtr->SequencePosition == SpbRequestSequencePositionLast ||
+        STATUS_SUCCESS != TransferStatus) {
+
+        if(DeviceCtxPtr->RegistersPtr->ControlReg & IMX_I2C_CTRL_REG_MSTA_MASK) {
+
+            // writes, and any transfer that ended early
+
+            ControllerGenerateStop(DeviceCtxPtr);
+        } else {
+
+            // reads - stop was made prior to reading the last byte.
+            // wait for Stop condition to complete.
+
+            for(n = 0;
+                n < timeoutMax && ((DeviceCtxPtr->RegistersPtr->StatusReg & IMX_I2C_STA_REG_IBB_MASK)!=0);
+                n++) {
+                KeStallExecutionProcessor(1);
+            }
+
+            if((DeviceCtxPtr->RegistersPtr->StatusReg & IMX_I2C_STA_REG_IBB_MASK) != 0) {
+
+                TraceEvents(TRACE_LEVEL_ERROR, TRACE_CTRLR,
+                            "ControllerFinishInterruptTransfer(R) i2c IBB timeout! n=%ld", n);
+
+                RequestPtr->Status = STATUS_IO_TIMEOUT;
+            }
+        }
+
+        //  disable i2c block
+
+        DeviceCtxPtr->RegistersPtr->ControlReg = (USHORT)0;
+    }
+
+    // make note of partial transfer
+
+    if(TransferStatus != STATUS_SUCCESS && RequestPtr->Information != 0) {
+
+        TraceEvents(TRACE_LEVEL_WARNING, TRACE_CTRLR,
+                    "ControllerFinishInterruptTransfer(WARN) partial transfer! only %Id of %Id bytes succeeded.",
+                    RequestPtr->Information, RequestPtr->Length);
+    }
+
+    // partial operations return success per PBC framework
+    // do not proceed with next transfer after partial transfer
+
+    if(RequestPtr->Information != RequestPtr->Length || TransferStatus != STATUS_SUCCESS) {
+
+        ControllerCompleteTransfer(DeviceCtxPtr, RequestPtr, TRUE);
+    } else {
+
+        ControllerCompleteTransfer(DeviceCtxPtr, RequestPtr, FALSE);
+    }
+
+    TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_CTRLR, "--ControllerFinishInterruptTransfer()");
+}
+
 /*++
 
   Routine Description:
@@ -1149,7 +1532,7 @@ NTSTATUS ControllerGenerateStart(
     NTSTATUS status = STATUS_SUCCESS;
     TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_CTRLR, "++ControllerGenerateStart()");
 
-    timeoutMax = ( 10 * 1000000 ) / DeviceCtxPtr->CurrentTargetPtr->Settings.ConnectionSpeed; // 100us at 100 kHz
+    timeoutMax = (int)DeviceCtxPtr->CurrentTargetPtr->Settings.PollTimeout_us; // 100us at 100 kHz
 
     // expect i2c bus be Not busy.
     // check if i2c bus is busy - wait until i2c bus becomes not busy
@@ -1241,11 +1624,25 @@ NTSTATUS ControllerGenerateStart(
                 "ControllerGenerateStart() i2c slave addr %02Xh",
                 uchSlaveAddress);
 
+    // in interrupt mode the address acknowledge is handled by the DPC
+
+    if(RequestPtr->bInterruptMode) {
+
+        RequestPtr->TransferState = I2cTransferStateAddress;
+        DeviceCtxPtr->RegistersPtr->ControlReg = DeviceCtxPtr->RegistersPtr->ControlReg | IMX_I2C_CTRL_REG_IIEN_MASK;
+    }
+
     // send out first byte - slave address
     // write calling address to data register. ICF will now become 0
 
     DeviceCtxPtr->RegistersPtr->DataIOReg = uchSlaveAddress;
 
+    if(RequestPtr->bInterruptMode) {
+
+        status = STATUS_PENDING;
+        goto ControllerGenerateStart;
+    }
+
     TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_CTRLR,
                 "ControllerGenerateStart() slave address written, awaiting IIF");
 
@@ -1282,7 +1679,7 @@ ControllerGenerateStart:
 
     // clean up error condition if occurred
 
-    if(STATUS_SUCCESS != status) {
+    if(!NT_SUCCESS(status)) {
 
         DeviceCtxPtr->RegistersPtr->StatusReg = (USHORT)0;
 
@@ -1327,7 +1724,7 @@ NTSTATUS ControllerGenerateRepeatedStart(
     NTSTATUS status = STATUS_SUCCESS;
     TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_CTRLR, "++ControllerGenerateRepeatedStart()");
 
-    timeoutMax = ( 10 * 1000000 ) / DeviceCtxPtr->CurrentTargetPtr->Settings.ConnectionSpeed;
+    timeoutMax = (int)DeviceCtxPtr->CurrentTargetPtr->Settings.PollTimeout_us;
 
     // set RSTA bit
 
@@ -1378,11 +1775,25 @@ NTSTATUS ControllerGenerateRepeatedStart(
     TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_CTRLR,
                 "ControllerGenerateRepeatedStart() i2c slave addr %02Xh", uchSlaveAddress);
 
+    // in interrupt mode the address acknowledge is handled by the DPC
+
+    if(RequestPtr->bInterruptMode) {
+
+        RequestPtr->TransferState = I2cTransferStateAddress;
+        DeviceCtxPtr->RegistersPtr->ControlReg = DeviceCtxPtr->RegistersPtr->ControlReg | IMX_I2C_CTRL_REG_IIEN_MASK;
+    }
+
     // send out first byte - slave address
     // write calling address to data register. ICF will now become 0
 
     DeviceCtxPtr->RegistersPtr->DataIOReg = uchSlaveAddress;
 
+    if(RequestPtr->bInterruptMode) {
+
+        status = STATUS_PENDING;
+        goto ControllerGenerateRepeatedStartErr;
+    }
+
     TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_CTRLR,
                 "ControllerGenerateRepeatedStart() slave address written, awaiting IIF");
 
@@ -1451,7 +1862,7 @@ NTSTATUS ControllerGenerateStop(PDEVICE_CONTEXT DeviceCtxPtr)
 
     // Note: our default is ten*(10) clock cycles (e.g. 100us at 100 kHz).
 
-    timeoutMax = ( 10 * 1000000 ) / DeviceCtxPtr->CurrentTargetPtr->Settings.ConnectionSpeed;
+    timeoutMax = (int)DeviceCtxPtr->CurrentTargetPtr->Settings.PollTimeout_us;
 
     // bus must be busy to generate stop
 
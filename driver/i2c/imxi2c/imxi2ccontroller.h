@@ -31,6 +31,12 @@ NTSTATUS ResetController(
     _In_ PDEVICE_CONTEXT DeviceCtxPtr,
     _In_ BOOLEAN DisableFisrt);
 
+NTSTATUS ControllerSolveClockDiv(
+    _In_ ULONG ModuleClock_kHz,
+    _In_ ULONG DesiredClockFrequencyHz,
+    _Out_ USHORT* DividerIndexPtr,
+    _Out_ ULONG* ActualClockFrequencyHzPtr);
+
 NTSTATUS SetControllerClockDiv(
     _In_ PDEVICE_CONTEXT DeviceCtxPtr,
     _In_ ULONG ClockFrequencyHz);
@@ -55,6 +61,18 @@ ControllerTransferDataMultp(
     _In_ PDEVICE_CONTEXT DeviceCtxPtr,
     _In_ PPBC_REQUEST pRequest);
 
+VOID
+ControllerProcessInterrupt(
+    _In_ PDEVICE_CONTEXT DeviceCtxPtr,
+    _In_ PPBC_REQUEST pRequest,
+    _In_ USHORT StatusReg);
+
+VOID
+ControllerFinishInterruptTransfer(
+    _In_ PDEVICE_CONTEXT DeviceCtxPtr,
+    _In_ PPBC_REQUEST pRequest,
+    _In_ NTSTATUS TransferStatus);
+
 VOID
 ControllerCompleteTransfer(
     _In_ PDEVICE_CONTEXT DeviceCtxPtr,
@@ -27,6 +27,7 @@ typedef struct _IMX_I2C_CONFIG_DATA {
     ULONG PeripheralClock_kHz;
     ULONG ModuleClock_kHz;
     ULONG DelayBeforeStart_us;
+    ULONG UseInterruptMode;
 } IMX_I2C_CONFIG_DATA;
 
 // WDF event callbacks.
@@ -37,6 +38,8 @@ EVT_WDF_DEVICE_D0_ENTRY OnD0Entry;
 EVT_WDF_DEVICE_D0_EXIT OnD0Exit;
 EVT_WDF_DEVICE_SELF_MANAGED_IO_INIT OnSelfManagedIoInit;
 EVT_WDF_DEVICE_SELF_MANAGED_IO_CLEANUP OnSelfManagedIoCleanup;
+EVT_WDF_INTERRUPT_ISR OnInterruptIsr;
+EVT_WDF_INTERRUPT_DPC OnInterruptDpc;
 
 // enable I2C_IS_PEP_MANAGED macro when PEP will become fully functional on iMX platform
 
@@ -102,9 +105,14 @@ PbcRequestDoTransfer(
 VOID PbcRequestComplete(_In_ PPBC_REQUEST RequestPtr);
 
 EVT_WDF_TIMER OnDelayTimerExpired;
+EVT_WDF_TIMER OnTransferTimerExpired;
 
 size_t PbcRequestGetInfoRemaining(_In_ PPBC_REQUEST RequestPtr);
 
+NTSTATUS PbcRequestSeekCursor(
+    _Inout_ PPBC_REQUEST RequestPtr,
+    _In_ size_t Index);
+
 NTSTATUS PbcRequestGetByte(
     _In_ PPBC_REQUEST RequestPtr,
    _In_  size_t Index,
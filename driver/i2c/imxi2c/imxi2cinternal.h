@@ -76,7 +76,21 @@ typedef struct _PNP_I2C_SERIAL_BUS_DESCRIPTOR {
 #define I2C_MAX_ADDRESS 0x7F
 
 #define IMX_I2C_MIN_CONNECTION_SPEED 100000 // min supported speed is 100 kHz on iMX6 Sabre
-#define IMX_I2C_MAX_CONNECTION_SPEED 400000 // max supported speed is 400 kHz
+#define IMX_I2C_MAX_CONNECTION_SPEED 1000000 // max supported speed is 1 MHz (Fm+)
+
+// bus polling loops wait for this many SCL periods before giving up
+
+#define IMX_I2C_POLL_TIMEOUT_SCL_PERIODS 10
+
+// writes up to this length are polled even in interrupt mode - they complete
+// faster than an interrupt and DPC round trip per byte
+
+#define IMX_I2C_POLLED_MAX_WRITE_LENGTH 2
+
+// interrupt mode transfer watchdog: 10 times the nominal transfer time,
+// but never less than the minimum
+
+#define IMX_I2C_TRANSFER_TIMEOUT_MIN_us 10000
 
 // Settings.
 
@@ -125,6 +139,13 @@ typedef struct PBC_TARGET_SETTINGS {
     ADDRESS_MODE AddressMode;
     USHORT Address;
     ULONG ConnectionSpeed;
+
+    // derived once when the target connects: IFDR value and the SCL
+    // rate it yields on this module clock, and the bus polling timeout
+
+    USHORT ClockDividerIdx;
+    ULONG ActualConnectionSpeed;
+    ULONG PollTimeout_us;
 }
 PBC_TARGET_SETTINGS, *PPBC_TARGET_SETTINGS;
 
@@ -138,6 +159,16 @@ typedef enum BUS_CONDITION {
 }
 BUS_CONDITION, *PBUS_CONDITION;
 
+// Interrupt mode transfer state.
+
+typedef enum I2C_TRANSFER_STATE {
+
+    I2cTransferStateIdle,       // no interrupt driven transfer in progress
+    I2cTransferStateAddress,    // slave address sent, awaiting acknowledge
+    I2cTransferStateData        // data bytes being transferred
+}
+I2C_TRANSFER_STATE, *PI2C_TRANSFER_STATE;
+
 typedef struct PBC_TRANSFER_SETTINGS {
 
     // May need Update this structure to include other
@@ -191,6 +222,17 @@ typedef struct _PBC_REQUEST_ {
     size_t Length;
     PMDL pMdlChain;
 
+    // Transfer buffer cursor: the MDL holding the last
+    // accessed byte, its system address, the byte offset
+    // within it and the byte index in the transfer.
+    // Sequential byte access continues from the cursor
+    // instead of walking the MDL chain from the start.
+
+    PMDL pCursorMdl;
+    PUCHAR pCursorBuffer;
+    size_t CursorMdlOffset;
+    size_t CursorIndex;
+
     // Position of the current transfer within
     // the sequence and its associated controller
     // settings.
@@ -211,6 +253,12 @@ typedef struct _PBC_REQUEST_ {
 
     ULONG DataReadyFlag;
 
+    // Current transfer is driven by the controller interrupt
+    // rather than polled, and the state of its byte engine.
+
+    BOOLEAN bInterruptMode;
+    I2C_TRANSFER_STATE TransferState;
+
     // Bytes read/written in the current transfer.
 
     size_t Information;
@@ -269,6 +317,24 @@ typedef struct _DEVICE_CONTEXT_ {
 
     WDFTIMER DelayTimer;
 
+    // Controller interrupt, NULL if the controller has no interrupt
+    // resource and all transfers are polled.
+
+    WDFINTERRUPT InterruptObj;
+
+    // Status register value latched by the ISR for the DPC.
+    // Protected by the interrupt lock.
+
+    USHORT InterruptStatus;
+
+    // Use the interrupt driven byte engine ("Use Interrupt Mode" registry value)
+
+    BOOLEAN bUseInterruptMode;
+
+    // Watchdog for interrupt driven transfers
+
+    WDFTIMER TransferTimer;
+
     // The power setting callback handle
 
     PVOID MonitorPowerSettingHandlePtr;
@@ -52,7 +52,6 @@ NTSTATUS PbcTargetGetSettings(
     RH_QUERY_CONNECTION_PROPERTIES_OUTPUT_BUFFER* connectionPtr;
     PNP_SERIAL_BUS_DESCRIPTOR* descriptorPtr;
     PNP_I2C_SERIAL_BUS_DESCRIPTOR* i2cDescriptorPtr;
-    UNREFERENCED_PARAMETER(pDevice);
 
     TraceEvents(TRACE_LEVEL_VERBOSE, TRACE_DEVICE, "++PbcTargetGetSettings()");
 
@@ -153,12 +152,37 @@ NTSTATUS PbcTargetGetSettings(
 
     pSettings->ConnectionSpeed = i2cDescriptorPtr->ConnectionSpeed;
 
+    // solve the clock divider for this module clock now, so transfers
+    // only need to program it
+
+    status = ControllerSolveClockDiv(pDevice->ModuleClock_kHz,
+                                     pSettings->ConnectionSpeed,
+                                     &pSettings->ClockDividerIdx,
+                                     &pSettings->ActualConnectionSpeed);
+
+    if(!NT_SUCCESS(status)) {
+
+        TraceEvents(TRACE_LEVEL_ERROR, TRACE_DEVICE,
+                    "No clock divider for %lu Hz with module clock %lu kHz",
+                    pSettings->ConnectionSpeed,
+                    pDevice->ModuleClock_kHz);
+
+        goto EndGetTargetSet;
+    }
+
+    pSettings->PollTimeout_us =
+        (IMX_I2C_POLL_TIMEOUT_SCL_PERIODS * 1000000 + pSettings->ActualConnectionSpeed - 1) /
+        pSettings->ActualConnectionSpeed;
+
     TraceEvents(TRACE_LEVEL_INFORMATION, TRACE_DEVICE,
                 "Connected to SPBTARGET. (SpbTarget = %p, "
-                "targetPtr->Address = %04xh, targetPtr->ConnectionSpeed = %lu)",
+                "targetPtr->Address = %04xh, targetPtr->ConnectionSpeed = %lu, "
+                "actual %lu Hz, poll timeout %lu us)",
                 pSettings,
                 pSettings->Address,
-                pSettings->ConnectionSpeed);
+                pSettings->ConnectionSpeed,
+                pSettings->ActualConnectionSpeed,
+                pSettings->PollTimeout_us);
 
 EndGetTargetSet:
     TraceEvents(TRACE_LEVEL_VERBOSE, TRACE_DEVICE, "--PbcTargetGetSettings()=%Xh", status);
@@ -439,6 +463,24 @@ NTSTATUS PbcRequestConfigureForIndex(
 
     NT_ASSERT(pMdl != NULL);
 
+    // Map the transfer buffer once, so byte access
+    // does not need to map it again.
+
+    for (PMDL mdl = pMdl; mdl != NULL; mdl = mdl->Next) {
+
+        if (MmGetSystemAddressForMdlSafe(mdl,
+                                         NormalPagePriority |
+                                         MdlMappingNoExecute) == NULL) {
+
+            TraceEvents(TRACE_LEVEL_ERROR, TRACE_PBC,
+                        "Failed to map transfer buffer MDL %p (index %lu)",
+                        mdl,
+                        Index);
+
+            return STATUS_INSUFFICIENT_RESOURCES;
+        }
+    }
+
     // Configure request context.
 
     pRequest->pMdlChain = pMdl;
@@ -447,6 +489,13 @@ NTSTATUS PbcRequestConfigureForIndex(
     pRequest->Direction = descriptor.Direction;
     pRequest->DelayInMicroseconds = descriptor.DelayInUs;
 
+    // Reset the transfer buffer cursor to the first byte.
+
+    pRequest->pCursorMdl = pMdl;
+    pRequest->pCursorBuffer = NULL;
+    pRequest->CursorMdlOffset = 0;
+    pRequest->CursorIndex = 0;
+
     // Update sequence position if request is type sequence.
 
     if (pRequest->Type == SpbRequestTypeSequence) {
@@ -616,8 +665,12 @@ PbcRequestGetInfoRemaining(PPBC_REQUEST pRequest)
 
   Routine Description:
 
-    This is a helper routine used to retrieve the
-    specified byte of the current transfer descriptor buffer.
+    This is a helper routine used to move the transfer
+    buffer cursor to the specified byte of the current
+    transfer descriptor buffer. Moving forward continues
+    from the current cursor position, so sequential byte
+    access is O(1); moving backward restarts from the
+    head of the MDL chain.
 
   Arguments:
 
@@ -625,68 +678,93 @@ PbcRequestGetInfoRemaining(PPBC_REQUEST pRequest)
 
     Index - index of desired byte in current transfer descriptor buffer
 
-    pByte - pointer to the location for the specified byte
-
   Return Value:
 
     STATUS_INFO_LENGTH_MISMATCH if invalid index,
+    STATUS_INSUFFICIENT_RESOURCES if the buffer cannot be mapped,
     otherwise STATUS_SUCCESS
 
 --*/
 _Use_decl_annotations_
 NTSTATUS
-PbcRequestGetByte(
+PbcRequestSeekCursor(
     PPBC_REQUEST pRequest,
-    size_t Index,
-    UCHAR* pByte)
+    size_t Index
+    )
 {
-    PMDL mdl = pRequest->pMdlChain;
+    PMDL mdl;
     size_t mdlByteCount;
-    size_t currentOffset = Index;
-    PUCHAR pBuffer;
-    NTSTATUS status = STATUS_INFO_LENGTH_MISMATCH;
+    size_t currentOffset;
 
     // Check for out-of-bounds index
 
-    if (Index < pRequest->Length) {
+    if (Index >= pRequest->Length) {
 
-        while (mdl != NULL) {
-
-            mdlByteCount = MmGetMdlByteCount(mdl);
+        return STATUS_INFO_LENGTH_MISMATCH;
+    }
 
-            if (currentOffset < mdlByteCount) {
+    if ((pRequest->pCursorMdl == NULL) || (Index < pRequest->CursorIndex)) {
 
-                pBuffer = (PUCHAR) MmGetSystemAddressForMdlSafe(mdl,
-                                                                NormalPagePriority |
-                                                                MdlMappingNoExecute);
+        pRequest->pCursorMdl = pRequest->pMdlChain;
+        pRequest->pCursorBuffer = NULL;
+        pRequest->CursorMdlOffset = 0;
+        pRequest->CursorIndex = 0;
+    }
 
-                if (pBuffer != NULL) {
+    mdl = pRequest->pCursorMdl;
+    currentOffset = pRequest->CursorMdlOffset + (Index - pRequest->CursorIndex);
 
-                    // Byte found, mark successful
+    while (mdl != NULL) {
 
-                    *pByte = pBuffer[currentOffset];
-                    status = STATUS_SUCCESS;
-                }
+        mdlByteCount = MmGetMdlByteCount(mdl);
 
-                break;
-            }
+        if (currentOffset < mdlByteCount) {
 
-            currentOffset -= mdlByteCount;
-            mdl = mdl->Next;
+            break;
         }
 
-        // If after walking the MDL the byte hasn't been found,
-        // status will still be STATUS_INFO_LENGTH_MISMATCH
+        currentOffset -= mdlByteCount;
+        mdl = mdl->Next;
+        pRequest->pCursorBuffer = NULL;
     }
 
-    return status;
+    if (mdl == NULL) {
+
+        // Chain is shorter than the transfer length,
+        // restart from the head next time.
+
+        pRequest->pCursorMdl = NULL;
+        return STATUS_INFO_LENGTH_MISMATCH;
+    }
+
+    // The MDL is already mapped by PbcRequestConfigureForIndex,
+    // this only fetches the mapped address.
+
+    if (pRequest->pCursorBuffer == NULL) {
+
+        pRequest->pCursorBuffer = (PUCHAR) MmGetSystemAddressForMdlSafe(mdl,
+                                                                        NormalPagePriority |
+                                                                        MdlMappingNoExecute);
+
+        if (pRequest->pCursorBuffer == NULL) {
+
+            pRequest->pCursorMdl = NULL;
+            return STATUS_INSUFFICIENT_RESOURCES;
+        }
+    }
+
+    pRequest->pCursorMdl = mdl;
+    pRequest->CursorMdlOffset = currentOffset;
+    pRequest->CursorIndex = Index;
+
+    return STATUS_SUCCESS;
 }
 
 /*++
 
   Routine Description:
 
-    This is a helper routine used to set the
+    This is a helper routine used to retrieve the
     specified byte of the current transfer descriptor buffer.
 
   Arguments:
@@ -695,7 +773,7 @@ PbcRequestGetByte(
 
     Index - index of desired byte in current transfer descriptor buffer
 
-    Byte - the byte
+    pByte - pointer to the location for the specified byte
 
   Return Value:
 
@@ -705,49 +783,59 @@ PbcRequestGetByte(
 --*/
 _Use_decl_annotations_
 NTSTATUS
-PbcRequestSetByte(
+PbcRequestGetByte(
     PPBC_REQUEST pRequest,
     size_t Index,
-    UCHAR Byte
-   )
+    UCHAR* pByte)
 {
-    PMDL mdl = pRequest->pMdlChain;
-    size_t mdlByteCount;
-    size_t currentOffset = Index;
-    PUCHAR pBuffer;
-    NTSTATUS status = STATUS_INFO_LENGTH_MISMATCH;
+    NTSTATUS status;
 
-    // Check for out-of-bounds index
+    status = PbcRequestSeekCursor(pRequest, Index);
+
+    if (NT_SUCCESS(status)) {
+
+        *pByte = pRequest->pCursorBuffer[pRequest->CursorMdlOffset];
+    }
+
+    return status;
+}
+
+/*++
 
-    if (Index < pRequest->Length) {
+  Routine Description:
 
-        while (mdl != NULL) {
+    This is a helper routine used to set the
+    specified byte of the current transfer descriptor buffer.
 
-            mdlByteCount = MmGetMdlByteCount(mdl);
+  Arguments:
 
-            if (currentOffset < mdlByteCount) {
+    pRequest - a pointer to the PBC request context
 
-                pBuffer = (PUCHAR) MmGetSystemAddressForMdlSafe(mdl,
-                                                                NormalPagePriority |
-                                                                MdlMappingNoExecute);
+    Index - index of desired byte in current transfer descriptor buffer
 
-                if (pBuffer != NULL) {
+    Byte - the byte
 
-                    // Byte found, mark successful
+  Return Value:
 
-                    pBuffer[currentOffset] = Byte;
-                    status = STATUS_SUCCESS;
-                }
+    STATUS_INFO_LENGTH_MISMATCH if invalid index,
+    otherwise STATUS_SUCCESS
 
-                break;
-            }
+--*/
+_Use_decl_annotations_
+NTSTATUS
+PbcRequestSetByte(
+    PPBC_REQUEST pRequest,
+    size_t Index,
+    UCHAR Byte
+   )
+{
+    NTSTATUS status;
 
-            currentOffset -= mdlByteCount;
-            mdl = mdl->Next;
-        }
+    status = PbcRequestSeekCursor(pRequest, Index);
+
+    if (NT_SUCCESS(status)) {
 
-        // If after walking the MDL the byte hasn't been found,
-        // status will still be STATUS_INFO_LENGTH_MISMATCH
+        pRequest->pCursorBuffer[pRequest->CursorMdlOffset] = Byte;
     }
 
     return status;
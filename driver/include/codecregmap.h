@@ -0,0 +1,125 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License.
+
+Module Name:
+
+    codecregmap.h
+
+Abstract:
+
+    This module contains the register map shared by the I2C audio codec
+    drivers. Register values are shadowed so that writes of an unchanged
+    value are skipped and read-modify-write does not need a bus read.
+    Queued writes are sent to the codec as a single SPB sequence.
+
+Environment:
+
+    User-mode Driver Framework 2
+
+*/
+#pragma once
+
+EXTERN_C_START
+
+//
+// Number of registers whose value can be shadowed.
+//
+#define CODEC_REGMAP_MAX_REGISTERS  64
+
+//
+// Number of register writes coalesced into one SPB sequence.
+//
+#define CODEC_REGMAP_MAX_BATCH      16
+
+typedef enum _CODEC_REGMAP_FORMAT
+{
+    //
+    // 16 bit register address followed by 16 bit value, MSB first
+    // (SGTL5000, WM8962).
+    //
+    CodecRegMapFormat16Addr16Data,
+
+    //
+    // 7 bit register address and 9 bit value packed in 16 bits, MSB first
+    // (WM8731). Registers are write-only.
+    //
+    CodecRegMapFormat7Addr9Data,
+
+} CODEC_REGMAP_FORMAT;
+
+typedef struct _CODEC_REGMAP_ENTRY
+{
+    USHORT Address;
+    USHORT Value;
+} CODEC_REGMAP_ENTRY, *PCODEC_REGMAP_ENTRY;
+
+typedef struct _CODEC_REGMAP
+{
+    WDFIOTARGET I2cTarget;
+    CODEC_REGMAP_FORMAT Format;
+
+    //
+    // Registers that are always written and whose write changes other
+    // registers behind the cache's back (software reset, write sequencers).
+    // The cache is dropped after writing one of them.
+    //
+    const USHORT* VolatileRegisters;
+    ULONG VolatileRegisterCount;
+
+    ULONG CacheCount;
+    CODEC_REGMAP_ENTRY Cache[CODEC_REGMAP_MAX_REGISTERS];
+
+    ULONG PendingCount;
+    UCHAR PendingBytes[CODEC_REGMAP_MAX_BATCH][4];
+
+    //
+    // Number of register writes requested, skipped because the shadowed
+    // value matched, and SPB requests actually sent.
+    //
+    ULONG WriteCount;
+    ULONG WriteSkipCount;
+    ULONG BusRequestCount;
+} CODEC_REGMAP, *PCODEC_REGMAP;
+
+VOID
+CodecRegMapInitialize(
+    _Out_ PCODEC_REGMAP RegMap,
+    _In_ WDFIOTARGET I2cTarget,
+    _In_ CODEC_REGMAP_FORMAT Format,
+    _In_reads_opt_(VolatileRegisterCount) const USHORT* VolatileRegisters,
+    _In_ ULONG VolatileRegisterCount
+    );
+
+VOID
+CodecRegMapInvalidate(
+    _Inout_ PCODEC_REGMAP RegMap
+    );
+
+NTSTATUS
+CodecRegMapWrite(
+    _Inout_ PCODEC_REGMAP RegMap,
+    _In_ USHORT Address,
+    _In_ USHORT Value
+    );
+
+NTSTATUS
+CodecRegMapUpdateBits(
+    _Inout_ PCODEC_REGMAP RegMap,
+    _In_ USHORT Address,
+    _In_ USHORT Mask,
+    _In_ USHORT Value
+    );
+
+NTSTATUS
+CodecRegMapRead(
+    _Inout_ PCODEC_REGMAP RegMap,
+    _In_ USHORT Address,
+    _Out_ PUSHORT ValuePtr
+    );
+
+NTSTATUS
+CodecRegMapFlush(
+    _Inout_ PCODEC_REGMAP RegMap
+    );
+
+EXTERN_C_END
@@ -77,7 +77,15 @@
 typedef union {
     UINT32 U;
     struct {
-        unsigned RSRVD_0_14 : 15;
+        unsigned RXB1       :  1;
+        unsigned RXF1       :  1;
+        unsigned TXB1       :  1;
+        unsigned TXF1       :  1;
+        unsigned RXB2       :  1;
+        unsigned RXF2       :  1;
+        unsigned TXB2       :  1;
+        unsigned TXF2       :  1;
+        unsigned RSRVD_8_14 :  7;
         unsigned TS_TIMER   :  1;
         unsigned TS_AVAIL   :  1;
         unsigned WAKEUP     :  1;
@@ -98,6 +106,14 @@ typedef union {
     } B;
 } EIR_t;
                                                
+#define ENET_EIR_RXB1_MASK                     0x00000001
+#define ENET_EIR_RXF1_MASK                     0x00000002
+#define ENET_EIR_TXB1_MASK                     0x00000004
+#define ENET_EIR_TXF1_MASK                     0x00000008
+#define ENET_EIR_RXB2_MASK                     0x00000010
+#define ENET_EIR_RXF2_MASK                     0x00000020
+#define ENET_EIR_TXB2_MASK                     0x00000040
+#define ENET_EIR_TXF2_MASK                     0x00000080
 #define ENET_EIR_TS_TIMER_MASK                 0x00008000
 #define ENET_EIR_TS_AVAIL_MASK                 0x00010000
 #define ENET_EIR_WAKEUP_MASK                   0x00020000
@@ -300,6 +316,66 @@ typedef union {
 #define ENET_TFWR_TFWR_MASK                    0x0000003F
 #define ENET_TCR_STRFWD_MASK                   0x00000100
 
+/*
+ * ENET_TXICn/ENET_RXICn - ENET Transmit/Receive Interrupt Coalescing Registers
+ */
+typedef union {
+    UINT32  U;
+    struct {
+        unsigned ICTT       : 16;
+        unsigned RSRVD_16_19:  4;
+        unsigned ICFT       :  8;
+        unsigned RSRVD_28_29:  2;
+        unsigned ICCS       :  1;
+        unsigned ICEN       :  1;
+    } B;
+} IC_t;
+
+#define ENET_IC_ICTT_MASK                      0x0000FFFF
+#define ENET_IC_ICFT_MASK                      0x0FF00000
+#define ENET_IC_ICFT_SHIFT                     20
+#define ENET_IC_ICCS_MASK                      0x40000000
+#define ENET_IC_ICEN_MASK                      0x80000000
+
+/*
+ * ENET_RCMRn - ENET Receive Classification Match Register for Class n (AVB capable ENET only)
+ */
+#define ENET_RCMR_CMP_MASK                     0x00000007
+#define ENET_RCMR_CMP_SHIFT(_Idx)              ((_Idx) * 4)
+#define ENET_RCMR_CMP_COUNT                    4
+#define ENET_RCMR_MATCHEN_MASK                 0x00010000
+
+/*
+ * ENET_DMAnCFG - ENET DMA Class Based Configuration (AVB capable ENET only)
+ */
+#define ENET_DMACFG_IDLE_SLOPE_MASK            0x0000FFFF
+#define ENET_DMACFG_DMA_CLASS_EN_MASK          0x00010000
+#define ENET_DMACFG_CALC_NOIPG_MASK            0x00020000
+
+/*
+ * ENET_ATCR - ENET IEEE 1588 Timer Control Register
+ */
+#define ENET_ATCR_EN_MASK                      0x00000001
+#define ENET_ATCR_OFFEN_MASK                   0x00000004
+#define ENET_ATCR_OFFRST_MASK                  0x00000008
+#define ENET_ATCR_PEREN_MASK                   0x00000010
+#define ENET_ATCR_PINPER_MASK                  0x00000080
+#define ENET_ATCR_RESTART_MASK                 0x00000200
+#define ENET_ATCR_CAPTURE_MASK                 0x00000800
+#define ENET_ATCR_SLAVE_MASK                   0x00002000
+
+/*
+ * ENET_ATCOR - ENET IEEE 1588 Timer Correction Register
+ */
+#define ENET_ATCOR_COR_MASK                    0x7FFFFFFF
+
+/*
+ * ENET_ATINC - ENET IEEE 1588 Time-Stamping Clock Period Register
+ */
+#define ENET_ATINC_INC_MASK                    0x0000007F
+#define ENET_ATINC_INC_CORR_MASK               0x00007F00
+#define ENET_ATINC_INC_CORR_SHIFT              8
+
 /*
  * ENET_TACC - ENET Transmit Accelerator Function Configuration
  */
@@ -379,14 +455,28 @@ typedef struct {
     UINT32  PALR;               // 0E4
     UINT32  PAUR;               // 0E8
     OPD_t   OPD;                // 0EC
-    UINT32  ___RES_0F0[10];
+    IC_t    TXIC0;              // 0F0
+    IC_t    TXIC1;              // 0F4
+    IC_t    TXIC2;              // 0F8
+    UINT32  ___RES_0FC;
+    IC_t    RXIC0;              // 100
+    IC_t    RXIC1;              // 104
+    IC_t    RXIC2;              // 108
+    UINT32  ___RES_10C[3];
     UINT32  IAUR;               // 118
     UINT32  IALR;               // 11C
     UINT32  GAUR;               // 120
     UINT32  GALR;               // 124
     UINT32  ___RES_128[7];
     TFWR_t  TFWR;               // 144
-    UINT32  ___RES_D148[14];
+    UINT32  ___RES_D148[6];
+    UINT32  RDSR1;              // 160
+    UINT32  TDSR1;              // 164
+    UINT32  MRBR1;              // 168
+    UINT32  RDSR2;              // 16C
+    UINT32  TDSR2;              // 170
+    UINT32  MRBR2;              // 174
+    UINT32  ___RES_178[2];
     UINT32  ERDSR;              // 180
     UINT32  ETDSR;              // 184
     UINT32  EMRBR;              // 188
@@ -403,7 +493,17 @@ typedef struct {
     UINT32  ___RES_1B4[3];
     TACC_t  TACC;               // 1C0
     RACC_t  RACC;               // 1C4
-    UINT32  ___RES_1C8[14];
+    UINT32  RCMR1;              // 1C8
+    UINT32  RCMR2;              // 1CC
+    UINT32  ___RES_1D0[2];
+    UINT32  DMACFG1;            // 1D8
+    UINT32  DMACFG2;            // 1DC
+    UINT32  RDAR1;              // 1E0
+    UINT32  TDAR1;              // 1E4
+    UINT32  RDAR2;              // 1E8
+    UINT32  TDAR2;              // 1EC
+    UINT32  QOS;                // 1F0
+    UINT32  ___RES_1F4[3];
 
     // statistics
     UINT32  RMON_T_DROP_NI;     // 200
@@ -461,6 +561,16 @@ typedef struct {
     UINT32  IEEE_R_MACERR;      // 2D8
     UINT32  IEEE_R_FDXFC;       // 2DC
     UINT32  IEEE_R_OCTETS_OK;   // 2E0
+    UINT32  ___RES_2E4[71];
+
+    // IEEE 1588 timer
+    UINT32  ATCR;               // 400
+    UINT32  ATVR;               // 404
+    UINT32  ATOFF;              // 408
+    UINT32  ATPER;              // 40C
+    UINT32  ATCOR;              // 410
+    UINT32  ATINC;              // 414
+    UINT32  ATSTMP;             // 418
 } CSP_ENET_REGS, *PCSP_ENET_REGS;
 
 // the buffer descriptor structure for the ENET Legacy Buffer Descriptor
@@ -499,6 +609,16 @@ typedef struct  _ENET_BD {
     ULONG BufferAddress;
 } ENET_BD, *PENET_BD;
 
+// the buffer descriptor structure for the ENET Enhanced Buffer Descriptor (ECR[EN1588] = 1)
+typedef struct  _ENET_ENHANCED_BD {
+    ENET_BD Legacy;                 // Same layout as the ENET Legacy Buffer Descriptor
+    ULONG   ExtControlStatus;       // Tx: INT, TS, PINS, IINS and error flags, Rx: INT, ICE, PCR, IPV6, FRAG and error flags
+    ULONG   ProtocolInfo;           // Rx: Protocol type, header length and payload checksum
+    ULONG   BDU;                    // Last buffer descriptor update done
+    ULONG   TimeStamp;              // IEEE 1588 time stamp
+    USHORT  Reserved[4];
+} ENET_ENHANCED_BD, *PENET_ENHANCED_BD;
+
 #define ENET_RX_BD_E_MASK            ((USHORT)0x8000)
 #define ENET_RX_BD_W_MASK            ((USHORT)0x2000)
 #define ENET_RX_BD_L_MASK            ((USHORT)0x0800)
@@ -516,4 +636,19 @@ typedef struct  _ENET_BD {
 #define ENET_TX_BD_L_MASK            ((USHORT)0x0800)
 #define ENET_TX_BD_TC_MASK           ((USHORT)0x0400)
 
+#define ENET_TX_EBD_INT_MASK         ((ULONG)0x40000000)
+#define ENET_TX_EBD_TS_MASK          ((ULONG)0x20000000)
+#define ENET_TX_EBD_PINS_MASK        ((ULONG)0x10000000)
+#define ENET_TX_EBD_IINS_MASK        ((ULONG)0x08000000)
+#define ENET_TX_EBD_FTYPE_MASK       ((ULONG)0x00F00000)
+#define ENET_TX_EBD_FTYPE_SHIFT      20
+
+#define ENET_RX_EBD_INT_MASK         ((ULONG)0x00800000)
+#define ENET_RX_EBD_ICE_MASK         ((ULONG)0x00000020)
+#define ENET_RX_EBD_PCR_MASK         ((ULONG)0x00000010)
+#define ENET_RX_EBD_VLAN_MASK        ((ULONG)0x00000004)
+#define ENET_RX_EBD_IPV6_MASK        ((ULONG)0x00000002)
+#define ENET_RX_EBD_FRAG_MASK        ((ULONG)0x00000001)
+#define ENET_RX_EBD_PROT_TYPE_MASK   ((ULONG)0x000000FF)
+
 #endif
\ No newline at end of file
@@ -0,0 +1,109 @@
+/*
+* Copyright 2018 NXP
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted (subject to the limitations in the disclaimer
+* below) provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice, this
+* list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* * Neither the name of NXP nor the names of its contributors may be used to
+* endorse or promote products derived from this software without specific prior
+* written permission.
+*
+* NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY THIS
+* LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+* THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+* GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+* LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+//
+// IMX ENET miniport IEEE 1588 (PTP) clock IOCTL definitions.
+// Each ENET adapter exposes a control device \\.\ImxEnetPtp<n>, <n> is the ENET instance index.
+// The PTP clock counts nanoseconds, it is initialized from the system time (Unix epoch) when the adapter starts.
+//
+
+#ifndef _IMX_NET_MINI_IOCTL_H_
+#define _IMX_NET_MINI_IOCTL_H_
+
+#define IMX_ENET_PTP_DEVICE_NAME                L"\\Device\\ImxEnetPtp"
+#define IMX_ENET_PTP_SYMBOLIC_NAME              L"\\DosDevices\\ImxEnetPtp"
+
+//
+// IMX ENET IOCTL function codes
+//
+#define IMX_ENET_IOCTL_ID_PTP_GET_TIME          0x800
+#define IMX_ENET_IOCTL_ID_PTP_SET_TIME          0x801
+#define IMX_ENET_IOCTL_ID_PTP_ADJUST_TIME       0x802
+#define IMX_ENET_IOCTL_ID_PTP_ADJUST_FREQUENCY  0x803
+
+//
+// IOCTL_IMX_ENET_PTP_GET_TIME
+//
+// Returns the current PTP clock time bracketed by two performance counter
+// samples, so the caller can correlate the PTP clock with the system time.
+//
+#define IOCTL_IMX_ENET_PTP_GET_TIME \
+            CTL_CODE(FILE_DEVICE_NETWORK, IMX_ENET_IOCTL_ID_PTP_GET_TIME, METHOD_BUFFERED, FILE_ANY_ACCESS)
+
+typedef struct _IMX_ENET_PTP_GET_TIME_OUTPUT {
+    ULONG64 Time;                       // PTP clock time [ns]
+    LONG64  PerformanceCounterBefore;   // KeQueryPerformanceCounter() before the PTP timer was captured
+    LONG64  PerformanceCounterAfter;    // KeQueryPerformanceCounter() after the PTP timer was captured
+    LONG64  PerformanceFrequency;       // Performance counter frequency [Hz]
+    LONG    FrequencyPpb;               // Current frequency adjustment [ppb]
+} IMX_ENET_PTP_GET_TIME_OUTPUT;
+
+//
+// IOCTL_IMX_ENET_PTP_SET_TIME
+//
+// Sets the PTP clock time [ns].
+//
+#define IOCTL_IMX_ENET_PTP_SET_TIME \
+            CTL_CODE(FILE_DEVICE_NETWORK, IMX_ENET_IOCTL_ID_PTP_SET_TIME, METHOD_BUFFERED, FILE_WRITE_DATA)
+
+typedef struct _IMX_ENET_PTP_SET_TIME_INPUT {
+    ULONG64 Time;                       // New PTP clock time [ns]
+} IMX_ENET_PTP_SET_TIME_INPUT;
+
+//
+// IOCTL_IMX_ENET_PTP_ADJUST_TIME
+//
+// Steps the PTP clock by a signed offset [ns].
+//
+#define IOCTL_IMX_ENET_PTP_ADJUST_TIME \
+            CTL_CODE(FILE_DEVICE_NETWORK, IMX_ENET_IOCTL_ID_PTP_ADJUST_TIME, METHOD_BUFFERED, FILE_WRITE_DATA)
+
+typedef struct _IMX_ENET_PTP_ADJUST_TIME_INPUT {
+    LONG64  Offset;                     // Time offset [ns]
+} IMX_ENET_PTP_ADJUST_TIME_INPUT;
+
+//
+// IOCTL_IMX_ENET_PTP_ADJUST_FREQUENCY
+//
+// Sets the PTP clock frequency adjustment relative to the nominal
+// frequency [ppb], positive values make the clock run faster.
+// The value is limited to +/- 100000000 ppb.
+//
+#define IOCTL_IMX_ENET_PTP_ADJUST_FREQUENCY \
+            CTL_CODE(FILE_DEVICE_NETWORK, IMX_ENET_IOCTL_ID_PTP_ADJUST_FREQUENCY, METHOD_BUFFERED, FILE_WRITE_DATA)
+
+typedef struct _IMX_ENET_PTP_ADJUST_FREQUENCY_INPUT {
+    LONG    FrequencyPpb;               // Frequency adjustment [ppb]
+} IMX_ENET_PTP_ADJUST_FREQUENCY_INPUT;
+
+#endif // !_IMX_NET_MINI_IOCTL_H_
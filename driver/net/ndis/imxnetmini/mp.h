@@ -123,6 +123,7 @@ typedef struct _MP_MII_STATE_MACHINE MP_MII_STATE_MACHINE, *PMP_MII_STATE_MACHIN
 #define MP_TAG_RX_ADAPTER               ((ULONG)'AceF')
 #define MP_TAG_RX_INT_FIFO_DESC         ((ULONG)'IceF')
 #define MP_TAG_SM_TIMER_DESC            ((ULONG)'TceF')
+#define MP_TAG_PTP_TIMER_DESC           ((ULONG)'PceF')
 
 //--------------------------------------
 // Configuration
@@ -190,12 +191,16 @@ typedef struct _MP_WAKE_PATTERN {
 #define MP_OFFSET(field)   ((UINT)FIELD_OFFSET(MP_ADAPTER,field))
 #define MP_SIZE(field)     sizeof(((PMP_ADAPTER)0)->field)
 
-// A generic queue
-typedef struct _MP_QUEUE {
-    NDIS_SPIN_LOCK  Lock;       // Sync object
-    LIST_ENTRY      Head;       // The list head
-    LONG            Count;      // Number of members
-} MP_QUEUE, *PMP_QUEUE;
+// ENET DMA buffer descriptor addresses, the size of BD depends on the legacy/enhanced BD mode
+#define MP_TX_DMA_BD(_pAdapter, _pTxQueue, _Idx)   ((volatile ENET_BD *)((PUCHAR)(_pTxQueue)->DmaBDT + (_Idx) * (_pAdapter)->DmaBDSize))
+#define MP_RX_DMA_BD(_pAdapter, _pRxQueue, _Idx)   ((PENET_BD)((PUCHAR)(_pRxQueue)->DmaBDT + (_Idx) * (_pAdapter)->DmaBDSize))
+#define MP_ENHANCED_BD(_pDmaBD)         ((volatile ENET_ENHANCED_BD *)(_pDmaBD))
+
+// Checksum offload settings, the same values as *IPChecksumOffloadIPv4 and similar standardized keywords
+#define MP_CHECKSUM_OFFLOAD_DISABLED    0
+#define MP_CHECKSUM_OFFLOAD_TX          1
+#define MP_CHECKSUM_OFFLOAD_RX          2
+#define MP_CHECKSUM_OFFLOAD_TX_RX       (MP_CHECKSUM_OFFLOAD_TX | MP_CHECKSUM_OFFLOAD_RX)
 
 //--------------------------------------
 // Miniport tx net buffer descriptor
@@ -203,13 +208,41 @@ typedef struct _MP_QUEUE {
 typedef struct _MP_TX_BD {
     LIST_ENTRY            Link;            // Queable
     PMP_ADAPTER           pAdapter;        // Adapter private data address
+    struct _MP_TX_QUEUE  *pTxQueue;        // ENET ring the frame is sent through
     PNET_BUFFER           pNB;             // NB address
     PNET_BUFFER_LIST      pNBL;            // MBL address
     LONG                  NBId;            // For debug only
+    LONG                  EnetBDCount;     // Number of ENET_TxBDs the frame occupies
+    ULONG                 EnhancedFlags;   // Enhanced ENET_TxBD flags (PINS, IINS) of the frame
+    USHORT                IpCsumOffset;    // Offset of IP header checksum to clear before transmission, 0 if none
+    USHORT                L4CsumOffset;    // Offset of TCP/UDP checksum to clear before transmission, 0 if none
+    BOOLEAN               CopyRequired;    // TRUE if the frame is copied to the driver Tx buffer, FALSE if SG elements are mapped directly
+    USHORT                HeaderLength;    // Leading bytes sent from the driver Tx buffer, so checksum fields can be cleared there. 0 if none
+    ULONG                 PayloadSGIdx;    // The first SG element mapped directly, elements holding copied headers only are skipped
+    ULONG                 PayloadSGOffset; // Bytes of the first mapped SG element already sent from the driver Tx buffer
+    ULONG                 RingIdx;         // Pending ring slot of the frame, fixed when the slot is reserved
+    LONG                  MapRefCount;     // Held by MpSendNetBufferLists() and MpProcessSGList(), the frame can be sent once both dropped theirs
     PSCATTER_GATHER_LIST  pSGList;         // The scatter gather list address
     SCATTER_GATHER_LIST   SGList;          // SG list passed to MpProcessSGList
 } MP_TX_BD, *PMP_TX_BD;
 
+//--------------------------------------
+// Bounded ring of Tx frames waiting for free ENET_TxBDs.
+// Head and Tail are free-running, both ends are serialized by Tx_SpinLock.
+// Each frame gets its slot before it is mapped, the ring is consumed in order and stops at a frame that is not mapped yet.
+// Frames that are canceled or fail to map leave a NULL hole in their slot.
+//--------------------------------------
+#define MP_TX_RING_SIZE                 (4 * TX_DESC_COUNT_MAX)    // Must be a power of two
+typedef struct _MP_TX_RING {
+    ULONG                 Head;            // Producer index, the next free slot
+    ULONG                 Tail;            // Consumer index, the oldest queued frame
+    PMP_TX_BD             Items[MP_TX_RING_SIZE];
+} MP_TX_RING, *PMP_TX_RING;
+
+#define MP_TX_RING_DEPTH(_pRing)        ((LONG)((_pRing)->Head - (_pRing)->Tail))
+#define MP_TX_RING_FREE_COUNT(_pRing)   ((ULONG)(MP_TX_RING_SIZE - MP_TX_RING_DEPTH(_pRing)))
+#define MP_TX_RING_ITEM(_pRing, _Idx)   ((_pRing)->Items[(_Idx) & (MP_TX_RING_SIZE - 1)])
+
 // ------------------------------------------------------------------------------------------------
 // The TX payload data buffer descriptor.
 // ------------------------------------------------------------------------------------------------
@@ -226,10 +259,12 @@ typedef struct _MP_TX_PAYLOAD_BD {
 // ------------------------------------------------------------------------------------------------
 typedef struct _MP_RX_FRAME_BD {
     LIST_ENTRY              Link;
+    struct _MP_RX_QUEUE    *pRxQueue;       // ENET ring the buffer belongs to
     PNET_BUFFER_LIST        pNBL;           //
     PMDL                    pMdl;           // Address of the MDL describing buffer
     PUCHAR                  pBuffer;        // Address of the buffer (in the context of miniport driver)
     NDIS_PHYSICAL_ADDRESS   BufferPa;       // Physical address of the buffer
+    BOOLEAN                 IsCopyBuffer;   // Small copy break buffer, never owned by ENET DMA
 } MP_RX_FRAME_BD, *PMP_RX_FRAME_BD;
 
 
@@ -237,6 +272,45 @@ typedef struct _MP_ENET_BD_SW_EXT_ {
     PMP_RX_FRAME_BD         pRxFrameBD;
 } MP_ENET_BD_SW_EXT, *PMP_ENET_BD_SW_EXT;
 
+// ------------------------------------------------------------------------------------------------
+// ENET Tx ring. Ring 0 is the best effort ring, rings 1 and 2 are the AVB class rings. Serialized by Tx_SpinLock.
+// ------------------------------------------------------------------------------------------------
+typedef struct _MP_TX_QUEUE {
+    ULONG                   QueueIdx;                           // ENET ring index
+    volatile UINT32        *pTDAR;                              // Transmit descriptor active register of the ring
+    MP_TX_RING              PendingRing;                        // Pending (owned by driver) TX ethernet frames (NET_BUFFERs) waiting for free ENET_TxBDs
+    LONG                    EnetFreeBDCount;                    // Number of unused Enet Buffer Descriptors
+    LONG                    EnetFreeBDIdx;                      // Index of the first free BD
+    LONG                    EnetPendingBDIdx;                   // Index of first BD submitted to ENET DMA
+    MP_TX_PAYLOAD_BD        EnetSwExtBDT[TX_DESC_COUNT_MAX];    // Table containing Sw related data for each Enet BD, pMpBD of the first BD tracks the in progress (owned by Enet DMA) frame
+    PUCHAR                  DataBuffer_Va;                      // Driver Tx buffers, one ENET_TX_FRAME_SIZE buffer for each BD
+    ULONG                   DataBuffer_Size;
+    NDIS_PHYSICAL_ADDRESS   DataBuffer_Pa;
+    volatile ENET_BD       *DmaBDT;                             // ENET peripheral Tx Dma buffer descriptor table (BDT) address
+    LONG                    DmaBDT_ItemCount;                   // ENET peripheral Tx Dma buffer descriptor table (BDT) item count
+    ULONG                   DmaBDT_Size;                        // Size of the DmaBDT [Bytes]
+    NDIS_PHYSICAL_ADDRESS   DmaBDT_Pa;                          // DmaBDT physical address
+} MP_TX_QUEUE, *PMP_TX_QUEUE;
+
+// ------------------------------------------------------------------------------------------------
+// ENET Rx ring. Ring 0 receives untagged and best effort frames, rings 1 and 2 receive frames matched
+// by the VLAN priority classification (RCMRn). Serialized by Rx_SpinLock.
+// ------------------------------------------------------------------------------------------------
+typedef struct _MP_RX_QUEUE {
+    ULONG                   QueueIdx;                           // ENET ring index
+    volatile UINT32        *pRDAR;                              // Receive descriptor active register of the ring
+    PMP_RX_FRAME_BD         FrameBDT;                           // Rx payload data buffer descriptor table address
+    LONG                    EnetFreeBDIdx;                      // Index of the first free BD
+    LONG                    EnetPendingBDIdx;                   // Index of first BD submitted to ENET DMA
+    LONG                    DmaBDT_DmaOwnedBDsCount;            // Number of BDs owned by ENET DMA (ready to receive data)
+    LONG                    DmaBDT_DmaOwnedBDsLowWatterMark;    // Number of BDs that must be ready for data reception
+    PENET_BD                DmaBDT;                             // ENET peripheral Dma buffer descriptor table (BDT) address
+    PMP_ENET_BD_SW_EXT      DmaBDT_SwExt;                       // SW extension of DmaBDT
+    LONG                    DmaBDT_ItemCount;                   // ENET peripheral Dma buffer descriptor table (BDT) item count
+    ULONG                   DmaBDT_Size;                        // Size of DmaBDT in bytes
+    NDIS_PHYSICAL_ADDRESS   DmaBDT_Pa;                          // Physical address of DmaBDT
+} MP_RX_QUEUE, *PMP_RX_QUEUE;
+
 // Next state delay periods...
 #define MP_SM_NEXT_STATE_IMMEDIATELY                 -1
 #define MP_SM_NEXT_STATE_SAMPLE_DEALY_MSEC          100
@@ -313,27 +387,33 @@ typedef struct _MP_ADAPTER {
     PDEVICE_OBJECT          NextDeviceObject;
 
     USHORT                  SpeedSelect;                           // Selected Speed Mode from registry
+    ULONG                   EnhancedBDs;                           // Use ENET enhanced buffer descriptors, required by checksum offload
+    ULONG                   DmaBDSize;                             // Size of one ENET DMA buffer descriptor [Bytes]
+    ULONG                   IPChecksumOffloadIPv4;                 // Current checksum offload settings (MP_CHECKSUM_OFFLOAD_xxx)
+    ULONG                   TCPChecksumOffloadIPv4;
+    ULONG                   UDPChecksumOffloadIPv4;
+    ULONG                   TCPChecksumOffloadIPv6;
+    ULONG                   UDPChecksumOffloadIPv6;
+    ULONG                   InterruptModeration;                   // Adaptive interrupt moderation enabled
+    BOOLEAN                 IntCoalescingSupported;                // ENET implements TXIC/RXIC registers
+    ULONG                   IntCoalescingClockFrequencyHz;         // ENET system clock frequency used to count ICTT, SoC specific
+    ULONG                   PriorityQueues;                        // Use AVB class rings for 802.1p priority traffic
+    BOOLEAN                 ClassQueuesSupported;                  // ENET implements AVB class rings 1 and 2
+    ULONG                   QueueCount;                            // Number of ENET Rx/Tx rings in use, 1 or ENET_QUEUE_COUNT_MAX
+    ULONG                   PtpHardwareTimestamp;                  // IEEE 1588 Rx/Tx time stamping enabled in registry
+    MP_PTP_CLOCK            Ptp;                                   // IEEE 1588 clock
+    MP_INT_MODERATION       Rx_IntModeration;                      // Rx interrupt coalescing state
+    MP_INT_MODERATION       Tx_IntModeration;                      // Tx interrupt coalescing state
+    LONGLONG                IntModerationSampleTime;               // Start of the current moderation sampling period [100ns]
     USHORT                  TheMostPowefullSpeedAndDuplexMode;     // The most powerful speed and duplex mode for both partners are capable
     NDIS_HANDLE             Tx_DmaHandle;                          // Scatter/Gather DMA handle
     ULONG                   Tx_SGListSize;
     NPAGED_LOOKASIDE_LIST   Tx_MpTxBDLookasideList;                // Tx buffer descriptor lookaside list
     ULONG                   Tx_CheckForHangCounter;
     LONG                    Tx_PendingNBs;                         // Number of TX frames (NET_BUFFERs) that are owned by the miniport. Total number of queued TX frames and frames that are already setup for DMA transfers.
-    MP_QUEUE                Tx_qMpOwnedBDs;                        // Pending (owned by driver) TX ethernet frames (NET_BUFFERs) queue
-    MP_QUEUE                Tx_qDmaOwnedBDs;                       // In progress (owned by Enet DMA) TX ethernet frames (NET_BUFFERs) queue
     NDIS_SPIN_LOCK          Tx_SpinLock;                           // Tx path spin lock
-    LONG                    Tx_EnetFreeBDCount;                    // Number of unused Enet Buffer Descriptors
-    LONG                    Tx_EnetFreeBDIdx;                      // Index of the first free BD
-    LONG                    Tx_EnetPendingBDIdx;                   // Index of first BD submitted to ENET DMA
-    MP_TX_PAYLOAD_BD        Tx_EnetSwExtBDT[TX_DESC_COUNT_MAX];    // Table containing Sw related data for each Enet BD
-    PUCHAR                  Tx_DataBuffer_Va;                      // TxBufAlloc points to the block of numTCB*NIC_PACKET_SIZE
-    ULONG                   Tx_DataBuffer_Size;                    // numTCB*NIC_PACKET_SIZE
-    NDIS_PHYSICAL_ADDRESS   Tx_DataBuffer_Pa;
-
-    volatile ENET_BD       *Tx_DmaBDT;                             // ENET peripheral Tx Dma buffer descriptor table (BDT) address
-    LONG                    Tx_DmaBDT_ItemCount;                   // ENET peripheral Tx Dma buffer descriptor table (BDT) item count
-    ULONG                   Tx_DmaBDT_Size;                        // Size of the Tx_DmaBDT [Bytes]
-    NDIS_PHYSICAL_ADDRESS   Tx_DmaBDT_Pa;                          // Tx_DmaBDT physical address
+    LONG                    Tx_DmaBDT_ItemCount;                   // Number of Tx Dma buffer descriptors of the best effort ring
+    MP_TX_QUEUE             Tx_Queue[ENET_QUEUE_COUNT_MAX];        // ENET Tx rings, QueueCount of them are used
     #if DBG
     LONG                    Tx_NBCounter;                          // For debug only
     LONG                    Tx_NBLCounter;                         // For debug only
@@ -341,18 +421,16 @@ typedef struct _MP_ADAPTER {
 
     // RECV
     NDIS_HANDLE             Rx_NBAndNBLPool;                       // NB and NBL pool handle
-    PMP_RX_FRAME_BD         Rx_FrameBDT;                           // Rx payload data buffer descriptor table address
     NDIS_SPIN_LOCK          Rx_SpinLock;                           // Rx path spin lock
-    LONG                    Rx_EnetFreeBDIdx;                      // Index of the first free BD
-    LONG                    Rx_EnetPendingBDIdx;                   // Index of first BD submitted to ENET DMA
     LONG                    Rx_NdisOwnedBDsCount;                  // Number of buffers owned by NDIS
-    LONG                    Rx_DmaBDT_DmaOwnedBDsCount;            // Number of BDs owned by ENET DMA (ready to receive data)
-    LONG                    Rx_DmaBDT_DmaOwnedBDsLowWatterMark;    // Number of BDs that must be ready for data reception
-    PENET_BD                Rx_DmaBDT;                             // ENET peripheral Dma buffer descriptor table (BDT) address
-    PMP_ENET_BD_SW_EXT      Rx_DmaBDT_SwExt;                       // SW extension of Rx_DmaBDT
-    LONG                    Rx_DmaBDT_ItemCount;                   // ENET peripheral Dma buffer descriptor table (BDT) item count
-    ULONG                   Rx_DmaBDT_Size;                        // Size of Rx_DmaBDT in bytes
-    NDIS_PHYSICAL_ADDRESS   Rx_DmaBDT_Pa;                          // Physical address of Rx_DmaBDT
+    LONG                    Rx_DmaBDT_ItemCount;                   // Number of Rx Dma buffer descriptors of the best effort ring
+    MP_RX_QUEUE             Rx_Queue[ENET_QUEUE_COUNT_MAX];        // ENET Rx rings, QueueCount of them are used
+    PMP_RX_FRAME_BD         Rx_SpareFrameBDT;                      // Spare ENET_RX_FRAME_SIZE buffers, they refill ENET_RxBDs whose buffers are owned by NDIS
+    LONG                    Rx_SpareFrameBDT_ItemCount;            // Number of spare buffers
+    LIST_ENTRY              Rx_SpareFreeList;                      // Free spare buffers
+    PMP_RX_FRAME_BD         Rx_CopyFrameBDT;                       // Small copy break buffer descriptor table
+    PUCHAR                  Rx_CopyBuffer_Va;                      // Small copy break buffers, ENET_RX_COPY_BUFFER_COUNT * ENET_RX_COPY_BUFFER_SIZE bytes
+    LIST_ENTRY              Rx_CopyFreeList;                       // Free small copy break buffers
     LONG                    Rx_NBLCounter;                         // For debug only
     NDIS_SPIN_LOCK          Dev_SpinLock;                          // spin locks
     // Packet Filter and look ahead size.
@@ -450,6 +528,9 @@ NDIS_STATUS NICReadRegParameters(_In_ PMP_ADAPTER Adapter);
 _Must_inspect_result_
 _IRQL_requires_max_(PASSIVE_LEVEL)
 NDIS_STATUS NICAllocAdapterMemory(_In_ PMP_ADAPTER Adapter);
+void MpFillOffload(_In_ PMP_ADAPTER pAdapter, _Out_ PNDIS_OFFLOAD pOffload, _In_ BOOLEAN HardwareCapabilities);
+_IRQL_requires_max_(PASSIVE_LEVEL)
+NDIS_STATUS MpSetOffloadAttributes(_In_ PMP_ADAPTER pAdapter);
 
 // MP_REQ.C
 _IRQL_requires_max_(DISPATCH_LEVEL)
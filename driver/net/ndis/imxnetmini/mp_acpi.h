@@ -41,6 +41,7 @@ EXTERN_C_START
 #define IMX_ENET_DSM_FUNCTION_GET_MAC_ADDRESS_INDEX                 2
 #define IMX_ENET_DSM_FUNCTION_GET_MDIO_BASE_ADDRESS_INDEX           3
 #define IMX_ENET_DSM_FUNCTION_GET_ENET_PHY_INTERFACE_TYPE_INDEX     4
+#define IMX_ENET_DSM_FUNCTION_GET_ENET_CLOCK_FREQUENCY_INDEX        5
 
 _IRQL_requires_max_(PASSIVE_LEVEL)
 NTSTATUS Acpi_Init(_In_ PMP_ADAPTER pAdapter, _Out_ ULONG *pACPI_SupportedFunctions);
@@ -35,176 +35,116 @@
 
 /*++
 Routine Description:
-    It is called to initialize a generic queue.
+    It is called to reserve the next pending ring slot for a Tx frame that is about to be mapped. The slot index is fixed,
+    the frame keeps its position in the ring regardless of when MpProcessSGList() is called for it.
+    Caller must hold Tx_SpinLock and make sure that the ring is not full.
 Arguments:
-    pQueue  Address of a caller allocated ST_MP_QUEUE object to be initialized.
+    pRing       The target ring address.
+    pMpTxBD     The Tx frame to be added.
 Return Value:
     None
 --*/
-_Use_decl_annotations_
-void MpQueueInit(PMP_QUEUE pQueue)
+static void MpTxRingReserve(_Inout_ PMP_TX_RING pRing, _Inout_ PMP_TX_BD pMpTxBD)
 {
-    RtlZeroMemory(pQueue, sizeof(MP_QUEUE));
-    NdisAllocateSpinLock(&pQueue->Lock);
-    InitializeListHead(&pQueue->Head);
+    ASSERT(MP_TX_RING_FREE_COUNT(pRing) > 0);
+    pMpTxBD->RingIdx = pRing->Head;
+    MP_TX_RING_ITEM(pRing, pRing->Head) = pMpTxBD;
+    pRing->Head++;
 }
 
 /*++
 Routine Description:
-    It is called to add a new entry to the beginning of the queue.
+    It is called to give up the pending ring slot of a Tx frame that is not going to be sent. The slot becomes a hole,
+    MpTxRingPeek() skips it once it reaches the tail of the ring.
+    Caller must hold Tx_SpinLock.
 Arguments:
-    pQueue      The target queue address.
-    pListEntry  The address of the new entry to be added.
+    pRing       The target ring address.
+    pMpTxBD     The Tx frame to be removed.
 Return Value:
     None
 --*/
-_Use_decl_annotations_
-void MpQueueAdd(PMP_QUEUE pQueue, PLIST_ENTRY pListEntry)
+static void MpTxRingRelease(_Inout_ PMP_TX_RING pRing, _In_ PMP_TX_BD pMpTxBD)
 {
-    NdisAcquireSpinLock(&pQueue->Lock);
-    InsertHeadList(&pQueue->Head, pListEntry);
-    pQueue->Count++;
-    NdisReleaseSpinLock(&pQueue->Lock);
+    ASSERT(MP_TX_RING_ITEM(pRing, pMpTxBD->RingIdx) == pMpTxBD);
+    MP_TX_RING_ITEM(pRing, pMpTxBD->RingIdx) = NULL;
 }
 
 /*++
 Routine Description:
-    It is called to get the next (oldest) entry of the queue.
-    The entry is removed from the queue. If the queue is empty, NULL is returned.
+    Peeks at the first (oldest) Tx frame in the pending ring, without removing it. Holes left by released slots are dropped.
+    Caller must hold Tx_SpinLock.
 Arguments:
-    pQueue      The target queue address.
+    pRing       The target ring address.
 Return Value:
-    The address of the oldest entry in the queue, or NULL if the queue is empty.
+    Address of the oldest Tx frame in the ring, or NULL if the ring is empty.
 --*/
-_IRQL_requires_max_(DISPATCH_LEVEL)
-PLIST_ENTRY MpQueueGetNext(PMP_QUEUE pQueue)
+static PMP_TX_BD MpTxRingPeek(_Inout_ PMP_TX_RING pRing)
 {
-    PLIST_ENTRY pNextEntry = NULL;
-
-    NdisAcquireSpinLock(&pQueue->Lock);
-    ASSERT(pQueue->Count >= 0);
-    do {
-        if (IsListEmpty(&pQueue->Head)) {
-            ASSERT(pQueue->Count == 0);
-            break;
-        }
-        pNextEntry = RemoveTailList(&pQueue->Head);
-        NdisZeroMemory(pNextEntry, sizeof(LIST_ENTRY));   // Mark that it is not queued
-        pQueue->Count--;
-    } while (0);
-    NdisReleaseSpinLock(&pQueue->Lock);
-    return  pNextEntry;
+    while ((pRing->Head != pRing->Tail) && (MP_TX_RING_ITEM(pRing, pRing->Tail) == NULL)) {
+        pRing->Tail++;
+    }
+    return (pRing->Head != pRing->Tail)? MP_TX_RING_ITEM(pRing, pRing->Tail) : NULL;
 }
 
 /*++
 Routine Description:
-    Called to remove an entry from the queue.
+    It is called to get the first (oldest) Tx frame of the pending ring.
+    The frame is removed from the ring. Caller must hold Tx_SpinLock.
 Arguments:
-    pQueue      The target queue address.
-    pListEntry  The address of the entry to be removed.
+    pRing       The target ring address.
 Return Value:
-    TRUE if after removing the entry the queue is empty, otherwise FALSE.
+    Address of the oldest Tx frame in the ring, or NULL if the ring is empty.
 --*/
-_IRQL_requires_max_(DISPATCH_LEVEL)
-BOOLEAN MpQueueRemoveEntry(PMP_QUEUE pQueue, PLIST_ENTRY pListEntry)
+static PMP_TX_BD MpTxRingPop(_Inout_ PMP_TX_RING pRing)
 {
-    BOOLEAN isRemoved = FALSE;
-
-    NdisAcquireSpinLock(&pQueue->Lock);
-    do {
-        if (IsListEmpty(&pQueue->Head)) {
-            ASSERT(pQueue->Count == 0);
-            break;
-        }
-        ASSERT(pQueue->Count > 0);
-        isRemoved = RemoveEntryList(pListEntry);
-        pQueue->Count--;
-        if (isRemoved) {
-            ASSERT(pQueue->Count == 0);
-            ASSERT(IsListEmpty(&pQueue->Head));
-        }
-        NdisZeroMemory(pListEntry, sizeof(LIST_ENTRY)); // Mark that it is not queued
-    } while (0);
-    NdisReleaseSpinLock(&pQueue->Lock);
-    return isRemoved;
-}
+    PMP_TX_BD pMpTxBD = MpTxRingPeek(pRing);
 
-/*++
-Routine Description:
-    It returns the number of items currently in the queue.
-Arguments:
-    pQueue    The target queue address.
-Return Value:
-    The number of items currently in the queue.
---*/
-_Use_decl_annotations_
-LONG MpQueueGetDepth(PMP_QUEUE pQueue)
-{
-    NdisAcquireSpinLock(&pQueue->Lock);
-    LONG ulDepth = pQueue->Count;
-    NdisReleaseSpinLock(&pQueue->Lock);
-    return ulDepth;
+    if (pMpTxBD != NULL) {
+        MP_TX_RING_ITEM(pRing, pRing->Tail) = NULL;
+        pRing->Tail++;
+    }
+    return pMpTxBD;
 }
 
 /*++
 Routine Description:
-    Peeks at the first (oldest) entry in the queue, without removing it
+    Returns TRUE if the Tx frame is ready to be posted to ENET_TxBDs, i.e. both MpSendNetBufferLists() and MpProcessSGList()
+    are done with it. Until then the frame may still be modified by one of them, it must not be sent or unwound.
 Arguments:
-    pQueue      The target queue address.
+    pMpTxBD     The Tx frame.
 Return Value:
-    Address of the first (oldest) entry in the queue, or NULL if queue is empty
+    TRUE if the frame is mapped.
 --*/
-_IRQL_requires_max_(DISPATCH_LEVEL)
-PLIST_ENTRY MpQueuePeekFirst(PMP_QUEUE pQueue)
+static BOOLEAN MpTxIsMapped(_In_ PMP_TX_BD pMpTxBD)
 {
-    PLIST_ENTRY firstEntryPtr = NULL;
-
-    NdisAcquireSpinLock(&pQueue->Lock);
-    do {
-        if (IsListEmpty(&pQueue->Head)) {
-            ASSERT(pQueue->Count == 0);
-            break;
-        }
-        ASSERT(pQueue->Count > 0);
-        firstEntryPtr = pQueue->Head.Blink;
-    } while (0);
-    NdisReleaseSpinLock(&pQueue->Lock);
-    return firstEntryPtr;
+    return ReadAcquire(&pMpTxBD->MapRefCount) == 0;
 }
 
 /*++
 Routine Description:
-   Peeks at the next entry in the queue, without removing it given a current entry
+    It is called to free MpTxBDs of NET_BUFFERs that were never handed over to NdisMAllocateNetBufferSGList().
 Arguments:
-    pQueue      The target queue address.
-    pListEntry  The current entry
+    pAdapter    Address of the adapter context
+    pFirstNB    The first NET_BUFFER
+    pEndNB      The NET_BUFFER to stop at (not freed), NULL to free up to the last NET_BUFFER of the list
 Return Value:
-    Address of the next entry in the queue, or NULL if queue is empty
+    None
 --*/
-_IRQL_requires_max_(DISPATCH_LEVEL)
-PLIST_ENTRY MpQueuePeekNext(PMP_QUEUE pQueue, PLIST_ENTRY pListEntry)
+static void MpTxFreeMpTxBDs(_In_ PMP_ADAPTER pAdapter, _In_ PNET_BUFFER pFirstNB, _In_opt_ PNET_BUFFER pEndNB)
 {
-    PLIST_ENTRY nextEntryPtr = NULL;
-    NdisAcquireSpinLock(&pQueue->Lock);
-    do {
-        if (IsListEmpty(&pQueue->Head))  {
-            ASSERT(pQueue->Count == 0);
-            break;
-        }
-        ASSERT(pQueue->Count > 0);
-        nextEntryPtr = pListEntry->Blink;
-        if (nextEntryPtr == &pQueue->Head) {
-            nextEntryPtr = NULL;
+    for (PNET_BUFFER pNB = pFirstNB; pNB != pEndNB; pNB = NET_BUFFER_NEXT_NB(pNB)) {
+        PMP_TX_BD pMpTxBD = MP_NB_pMpTxBD(pNB);
+        if (pMpTxBD != NULL) {
+            MP_NB_SET_pMpTxBD(pNB, NULL);
+            NdisFreeToNPagedLookasideList(&pAdapter->Tx_MpTxBDLookasideList, pMpTxBD);
         }
-    } while (0);
-    NdisReleaseSpinLock(&pQueue->Lock);
-    return nextEntryPtr;
+    }
 }
 
 /*++
 Routine Description:
     Checks if the transmission process is stalled.
-    Check is there are Tx Ethernet frame in the 'in progress' queue that have timed out.
+    Check is there are Tx Ethernet frame owned by ENET DMA that have timed out.
     NDIS calls MiniportCheckForHangEx at IRQL = PASSIVE_LEVEL.
 Arguments:
     MiniportAdapterContext
@@ -220,7 +160,12 @@ BOOLEAN MpCheckForHangEx(NDIS_HANDLE MiniportAdapterContext)
 
     NdisAcquireSpinLock(&pAdapter->Tx_SpinLock);
     for(;;) {
-        if (MpQueueGetDepth(&pAdapter->Tx_qDmaOwnedBDs) > 0) {  // Any Tx frame pending in HW?
+        BOOLEAN isTxPending = FALSE;
+        for (ULONG QueueIdx = 0; QueueIdx < pAdapter->QueueCount; QueueIdx++) {
+            PMP_TX_QUEUE pTxQueue = &pAdapter->Tx_Queue[QueueIdx];
+            isTxPending |= (pTxQueue->EnetFreeBDCount < pTxQueue->DmaBDT_ItemCount);
+        }
+        if (isTxPending) {                                      // Any Tx frame pending in HW?
             if (++pAdapter->Tx_CheckForHangCounter > 2) {       // Second call of this function without successful Tx transfer?
                 DBG_ENET_DEV_PRINT_ERROR("TX is hang!");
                 break;
@@ -291,13 +236,29 @@ BOOLEAN MpTxCancelAll(PMP_ADAPTER pAdapter)
     LIST_ENTRY  CanceledNetBufferList;                                // The list of NET_BUFFERs associated with NET_BUFFER_LISTs that should be canceled.
     NDIS_STATUS CompletionStatus;                                     // Completion status to use
     PLIST_ENTRY pListEntry;
+    PMP_TX_BD   pMpTxBD;
+    LONG        EnetBDIdx;
 
     InitializeListHead(&CanceledNetBufferList);
     NdisAcquireSpinLock(&pAdapter->Tx_SpinLock);
-    while ((pListEntry = MpQueueGetNext(&pAdapter->Tx_qDmaOwnedBDs)) != NULL)
-        InsertHeadList(&CanceledNetBufferList, pListEntry);
-    while ((pListEntry = MpQueueGetNext(&pAdapter->Tx_qMpOwnedBDs)) != NULL)
-        InsertHeadList(&CanceledNetBufferList, pListEntry);
+    for (ULONG QueueIdx = 0; QueueIdx < pAdapter->QueueCount; QueueIdx++) {
+        PMP_TX_QUEUE pTxQueue = &pAdapter->Tx_Queue[QueueIdx];
+        EnetBDIdx = pTxQueue->EnetPendingBDIdx;
+        while ((pMpTxBD = pTxQueue->EnetSwExtBDT[EnetBDIdx].pMpBD) != NULL) {  // Frames handed over to ENET DMA, ENET is already stopped by the caller
+            pTxQueue->EnetSwExtBDT[EnetBDIdx].pMpBD = NULL;
+            EnetBDIdx = (EnetBDIdx + pMpTxBD->EnetBDCount) % pTxQueue->DmaBDT_ItemCount;  // Move to the first ENET_TxBD of the next frame
+            InsertHeadList(&CanceledNetBufferList, &pMpTxBD->Link);
+        }
+        PMP_TX_RING pRing = &pTxQueue->PendingRing;
+        for (ULONG Idx = pRing->Tail; Idx != pRing->Head; Idx++) {
+            pMpTxBD = MP_TX_RING_ITEM(pRing, Idx);
+            if ((pMpTxBD != NULL) && MpTxIsMapped(pMpTxBD)) {               // Frames still being mapped are left to MpProcessSGList()
+                MpTxRingRelease(pRing, pMpTxBD);
+                InsertHeadList(&CanceledNetBufferList, &pMpTxBD->Link);
+            }
+        }
+        (void)MpTxRingPeek(pRing);                                           // Drop the holes at the tail
+    }
     CompletionStatus = pAdapter->NdisStatus;                                 // Get the completion status to use
     BOOLEAN isAnyTxFrameCanceled = !IsListEmpty(&CanceledNetBufferList);     // The status to return...
     NdisReleaseSpinLock(&pAdapter->Tx_SpinLock);
@@ -305,7 +266,7 @@ BOOLEAN MpTxCancelAll(PMP_ADAPTER pAdapter)
     while (!IsListEmpty(&CanceledNetBufferList)) {
         pListEntry = RemoveTailList(&CanceledNetBufferList);
         ASSERT(pListEntry != NULL);
-        PMP_TX_BD pMpTxBD = CONTAINING_RECORD(pListEntry, MP_TX_BD, Link);   // Get pMpTxBD address
+        pMpTxBD = CONTAINING_RECORD(pListEntry, MP_TX_BD, Link);             // Get pMpTxBD address
         MpTxUnwindNetBuffer(pAdapter, pMpTxBD->pNBL, pMpTxBD->pNB, CompletionStatus, NDIS_SEND_COMPLETE_FLAGS_DISPATCH_LEVEL);
     }
     return isAnyTxFrameCanceled;
@@ -329,20 +290,23 @@ void MpCancelSendNetBufferLists(NDIS_HANDLE MiniportAdapterContext, PVOID Cancel
 {
     PMP_ADAPTER       pAdapter = (PMP_ADAPTER)MiniportAdapterContext;
     LIST_ENTRY        CanceledNBList;       // The list of NET_BUFFERs associated with NET_BUFFER_LISTs that should be cancelled.
+    PLIST_ENTRY       pListEntry;
 
     InitializeListHead(&CanceledNBList);
     NdisAcquireSpinLock(&pAdapter->Tx_SpinLock);
-    PLIST_ENTRY pListEntry = MpQueuePeekFirst(&pAdapter->Tx_qMpOwnedBDs);
-    while (pListEntry != NULL) {
-        PMP_TX_BD pMpTxBD = CONTAINING_RECORD(pListEntry, MP_TX_BD, Link);         // Get pMpTxBD address
-        if (NDIS_GET_NET_BUFFER_LIST_CANCEL_ID(pMpTxBD->pNBL) == CancelId) {       // Compare CancelIds
-            PLIST_ENTRY curpListEntry = pListEntry;                                // Remember current pMpTxBD
-            pListEntry = MpQueuePeekNext(&pAdapter->Tx_qMpOwnedBDs, pListEntry);   // Move to next pMpTxBD, before removing...
-            MpQueueRemoveEntry(&pAdapter->Tx_qMpOwnedBDs, curpListEntry);          // Remove pMpTxBD from Tx_qMpOwnedBDs queue
-            InsertHeadList(&CanceledNBList, &pMpTxBD->Link);                       // Add pMpTxBD to the cancel ready queue
-        } else {
-            pListEntry = MpQueuePeekNext(&pAdapter->Tx_qMpOwnedBDs, pListEntry);   // CancelIds are different, move to the next pMpTxBD
+    for (ULONG QueueIdx = 0; QueueIdx < pAdapter->QueueCount; QueueIdx++) {
+        PMP_TX_RING pRing = &pAdapter->Tx_Queue[QueueIdx].PendingRing;
+        for (ULONG Idx = pRing->Tail; Idx != pRing->Head; Idx++) {                 // Slots are fixed, canceled frames leave holes
+            PMP_TX_BD pMpTxBD = MP_TX_RING_ITEM(pRing, Idx);                       // Get pMpTxBD address
+            if ((pMpTxBD == NULL) || !MpTxIsMapped(pMpTxBD)) {                     // Hole, or frame still owned by MpProcessSGList()?
+                continue;
+            }
+            if (NDIS_GET_NET_BUFFER_LIST_CANCEL_ID(pMpTxBD->pNBL) == CancelId) {   // Compare CancelIds
+                MpTxRingRelease(pRing, pMpTxBD);
+                InsertHeadList(&CanceledNBList, &pMpTxBD->Link);                   // Add pMpTxBD to the cancel ready queue
+            }
         }
+        (void)MpTxRingPeek(pRing);                                                 // Drop the holes at the tail
     }
     NdisReleaseSpinLock(&pAdapter->Tx_SpinLock);
     while (!IsListEmpty(&CanceledNBList)) {                                        // Unwind all cancelled NET_BUFFERs
@@ -355,14 +319,15 @@ void MpCancelSendNetBufferLists(NDIS_HANDLE MiniportAdapterContext, PVOID Cancel
 
 /*++
 Routine Description:
-   Copy data in a packet to the specified location
+   Copy data in a packet to the specified location and clear the checksum fields to be inserted by ENET
 Arguments:
     pMpTxBD         A pointer to the source buffer
     pEnetSwExtBD    A pointer to the destination buffer
+    Length          Number of leading bytes to copy, the whole frame or just its headers
 Return Value:
     The number of bytes actually copied
 --*/
-ULONG MpCopyNetBuffer(_In_ PMP_TX_BD pMpTxBD, _Inout_ PMP_TX_PAYLOAD_BD pEnetSwExtBD)
+ULONG MpCopyNetBuffer(_In_ PMP_TX_BD pMpTxBD, _Inout_ PMP_TX_PAYLOAD_BD pEnetSwExtBD, _In_ ULONG Length)
 {
     ULONG          CurrLength=0;
     PUCHAR         pSrc=NULL;
@@ -372,13 +337,12 @@ ULONG MpCopyNetBuffer(_In_ PMP_TX_BD pMpTxBD, _Inout_ PMP_TX_PAYLOAD_BD pEnetSwE
     PMDL           CurrentMdl;
     ULONG          DataLength;
     PNET_BUFFER    NetBuffer = pMpTxBD->pNB;
-    PSCATTER_GATHER_LIST sgListPtr = pMpTxBD->pSGList;
 
 //TODO    DBG_ENET_DEV_TX_METHOD_BEG();
     pDest = pEnetSwExtBD->pBuffer;
     CurrentMdl = NET_BUFFER_FIRST_MDL(NetBuffer);
     Offset = NET_BUFFER_DATA_OFFSET(NetBuffer);
-    DataLength = NET_BUFFER_DATA_LENGTH(NetBuffer);
+    DataLength = min(Length, NET_BUFFER_DATA_LENGTH(NetBuffer));
 
     while (CurrentMdl && DataLength > 0) {
         NdisQueryMdl(CurrentMdl, &pSrc, &CurrLength, NormalPagePriority);
@@ -409,18 +373,92 @@ ULONG MpCopyNetBuffer(_In_ PMP_TX_BD pMpTxBD, _Inout_ PMP_TX_PAYLOAD_BD pEnetSwE
     if ((BytesCopied != 0) && (BytesCopied < ETHER_FRAME_NIN_LENGTH))  {
         NdisZeroMemory(pDest, ETHER_FRAME_NIN_LENGTH - BytesCopied);
     }
+    if ((BytesCopied != 0) && pMpTxBD->IpCsumOffset) {
+        *(UNALIGNED USHORT *)(pEnetSwExtBD->pBuffer + pMpTxBD->IpCsumOffset) = 0;    // ENET inserts IP header checksum only if the field is cleared
+    }
+    if ((BytesCopied != 0) && pMpTxBD->L4CsumOffset) {
+        *(UNALIGNED USHORT *)(pEnetSwExtBD->pBuffer + pMpTxBD->L4CsumOffset) = 0;    // ENET inserts TCP/UDP checksum only if the field is cleared
+    }
     NdisAdjustMdlLength(pEnetSwExtBD->pMdl, BytesCopied);
     ASSERT(BytesCopied <= pEnetSwExtBD->BufferSize);
-
-    sgListPtr->Elements[0].Address = pEnetSwExtBD->BufferPa;
-    sgListPtr->Elements[0].Length = BytesCopied;
 //TODO    DBG_ENET_DEV_TX_METHOD_END();
     return BytesCopied;
 }
 
+/*++
+Routine Description:
+    Prepares ENET checksum insertion for a frame whose NBL requests IPv4 header or TCP/UDP checksum offload.
+    ENET inserts checksums only if the checksum fields are cleared. The NET_BUFFER belongs to the protocol and must not
+    be modified, so the headers up to the last checksum field are copied to the driver Tx buffer and the fields are cleared
+    there. The payload is still mapped from the NET_BUFFER, see MpProcessSGList().
+Arguments:
+    pAdapter    Address of the adapter context
+    pMpTxBD     Address of the TCB of the frame
+Return Value:
+    None
+--*/
+static void MpTxPrepareChecksum(_In_ PMP_ADAPTER pAdapter, _Inout_ PMP_TX_BD pMpTxBD)
+{
+    NDIS_TCP_IP_CHECKSUM_NET_BUFFER_LIST_INFO ChecksumInfo;
+    UCHAR       HeaderStorage[ENET_TX_CSUM_HEADERS_MAX_LENGTH];
+    PUCHAR      pHeader;
+    ULONG       HeaderLength = min(NET_BUFFER_DATA_LENGTH(pMpTxBD->pNB), ENET_TX_CSUM_HEADERS_MAX_LENGTH);
+    ULONG       IpOffset = ETHER_FRAME_HEADER_LENGTH;
+    ULONG       L4Offset;
+    USHORT      EtherType;
+    UCHAR       Protocol;
+
+    ChecksumInfo.Value = NET_BUFFER_LIST_INFO(pMpTxBD->pNBL, TcpIpChecksumNetBufferListInfo);
+    if (!pAdapter->EnhancedBDs || !(ChecksumInfo.Transmit.IpHeaderChecksum || ChecksumInfo.Transmit.TcpChecksum || ChecksumInfo.Transmit.UdpChecksum)) {
+        return;                                                                          // No checksum offload requested
+    }
+    if (HeaderLength < ETHER_FRAME_HEADER_LENGTH + IPV4_HEADER_MIN_LENGTH) {
+        return;
+    }
+    if ((pHeader = (PUCHAR)NdisGetDataBuffer(pMpTxBD->pNB, HeaderLength, HeaderStorage, 1, 0)) == NULL) {
+        return;                                                                          // Headers are only read here
+    }
+    EtherType = (USHORT)((pHeader[ETHER_FRAME_TYPE_OFFSET] << 8) | pHeader[ETHER_FRAME_TYPE_OFFSET + 1]);
+    if (EtherType == ETHER_TYPE_VLAN) {                                                  // Skip 802.1Q tag
+        IpOffset += ETHER_VLAN_TAG_LENGTH;
+        EtherType = (USHORT)((pHeader[ETHER_FRAME_TYPE_OFFSET + ETHER_VLAN_TAG_LENGTH] << 8) | pHeader[ETHER_FRAME_TYPE_OFFSET + ETHER_VLAN_TAG_LENGTH + 1]);
+    }
+    if ((EtherType == ETHER_TYPE_IPV4) && ChecksumInfo.Transmit.IsIPv4 && (IpOffset + IPV4_HEADER_MIN_LENGTH <= HeaderLength)) {
+        L4Offset = IpOffset + (pHeader[IpOffset] & 0x0F) * 4;                           // IHL is in 32-bit words
+        Protocol = pHeader[IpOffset + IPV4_HEADER_PROTOCOL_OFFSET];
+        if (ChecksumInfo.Transmit.IpHeaderChecksum) {
+            pMpTxBD->EnhancedFlags |= ENET_TX_EBD_IINS_MASK;
+            pMpTxBD->IpCsumOffset   = (USHORT)(IpOffset + IPV4_HEADER_CHECKSUM_OFFSET);
+        }
+    } else if ((EtherType == ETHER_TYPE_IPV6) && ChecksumInfo.Transmit.IsIPv6 && (IpOffset + IPV6_HEADER_LENGTH <= HeaderLength)) {
+        L4Offset = IpOffset + IPV6_HEADER_LENGTH;
+        Protocol = pHeader[IpOffset + IPV6_HEADER_NEXT_HEADER_OFFSET];
+    } else {
+        return;                                                                          // Not an IP frame, let the hardware send it as is
+    }
+    if (ChecksumInfo.Transmit.TcpChecksum && (Protocol == IP_PROTOCOL_TCP) && (L4Offset + TCP_HEADER_CHECKSUM_OFFSET + 2 <= HeaderLength)) {
+        pMpTxBD->EnhancedFlags |= ENET_TX_EBD_PINS_MASK;
+        pMpTxBD->L4CsumOffset   = (USHORT)(L4Offset + TCP_HEADER_CHECKSUM_OFFSET);
+    } else if (ChecksumInfo.Transmit.UdpChecksum && (Protocol == IP_PROTOCOL_UDP) && (L4Offset + UDP_HEADER_CHECKSUM_OFFSET + 2 <= HeaderLength)) {
+        pMpTxBD->EnhancedFlags |= ENET_TX_EBD_PINS_MASK;
+        pMpTxBD->L4CsumOffset   = (USHORT)(L4Offset + UDP_HEADER_CHECKSUM_OFFSET);
+    }
+    if (pMpTxBD->IpCsumOffset || pMpTxBD->L4CsumOffset) {
+        pMpTxBD->HeaderLength = (USHORT)(max(pMpTxBD->IpCsumOffset, pMpTxBD->L4CsumOffset) + 2);   // Checksum fields are cleared by MpCopyNetBuffer()
+    }
+}
+
 /*++
 Routine Description:
     It is called to map all NET_BUFFER scatter gather elements into TX DMA descriptors.
+    Small and runt frames are copied to the driver Tx buffer and sent by one ENET_TxBD. Other frames are sent directly from
+    the NET_BUFFER memory, each scatter gather element is mapped to its own ENET_TxBD and only the last one has L bit set.
+    Headers of frames with checksum insertion are copied to the driver Tx buffer, which becomes the first ENET_TxBD,
+    the payload SG elements follow it.
+    The R bit of the first ENET_TxBD is set as the last step, so ENET DMA never sees a partially built chain.
+    The frame is posted to the ENET ring selected by MpSendNetBufferLists(), if the AVB class rings are used the FTYPE field
+    of the enhanced ENET_TxBD identifies the ring.
+    Caller must hold Tx_SpinLock and make sure that at least pMpTxBD->EnetBDCount ENET_TxBDs of the ring are free.
 Arguments:
     pAdapter    Address of the adapter context
     pMpTxBD     Address of the TCB to be freed
@@ -429,40 +467,87 @@ Return Value:
 --*/
 void MpTxFillEnetTxBD(_In_ PMP_ADAPTER pAdapter, _In_ PMP_TX_BD pMpTxBD)
 {
+    PMP_TX_QUEUE         pTxQueue = pMpTxBD->pTxQueue;
     PSCATTER_GATHER_LIST sgListPtr = pMpTxBD->pSGList;
-    LONG                 EnetFreeBDIdx = pAdapter->Tx_EnetFreeBDIdx;            // First free Ethernet packet hw buffer descriptor index
-    volatile ENET_BD    *pFreeEnetBD = &pAdapter->Tx_DmaBDT[EnetFreeBDIdx];    // First free Ethernet packet hw buffer descriptor address
+    LONG                 EnetFreeBDIdx = pTxQueue->EnetFreeBDIdx;                          // First free Ethernet packet hw buffer descriptor index
+    volatile ENET_BD    *pFirstEnetBD = MP_TX_DMA_BD(pAdapter, pTxQueue, EnetFreeBDIdx);   // First Ethernet packet hw buffer descriptor address of the frame
+    ULONG                ExtControlStatus = ENET_TX_EBD_INT_MASK | pMpTxBD->EnhancedFlags;  // Generate interrupt, insert checksums if requested
+    volatile ENET_BD    *pFreeEnetBD;
     USHORT               ControlStatus;
-    ULONG                bytesToSent;
+    USHORT               FirstControlStatus = 0;
+    PMP_TX_PAYLOAD_BD    pEnetSwExtBD = &pTxQueue->EnetSwExtBDT[EnetFreeBDIdx];            // Driver Tx buffer of the frame
+    ULONG                bytesToSent = NET_BUFFER_DATA_LENGTH(pMpTxBD->pNB);
+    ULONG                bytesCopied = 0;
+    ULONG                copiedBDCount = 0;                                                // ENET_TxBDs sent from the driver Tx buffer, 0 or 1
+    ULONG                elementIdx;
 
     ASSERT(sgListPtr != NULL);
     ASSERT(sgListPtr->NumberOfElements > 0);
+    ASSERT(pMpTxBD->EnetBDCount <= pTxQueue->EnetFreeBDCount);
 
     DBG_ENET_DEV_TX_METHOD_BEG();
-    bytesToSent = MpCopyNetBuffer(pMpTxBD, &pAdapter->Tx_EnetSwExtBDT[EnetFreeBDIdx]);          // Copy data to driver provided buffer
-    ASSERT(bytesToSent);
-    ASSERT(!(pFreeEnetBD->ControlStatus & ENET_TX_BD_R_MASK));
-    pAdapter->Tx_EnetSwExtBDT[EnetFreeBDIdx].pMpBD = pMpTxBD;                                   // Associate sw MP_TxBD with current hw ENET_TxBD
-    ControlStatus = ENET_TX_BD_L_MASK | ENET_TX_BD_TC_MASK | ENET_TX_BD_R_MASK;                 // Prepare transfer flags
-    if (++EnetFreeBDIdx == pAdapter->Tx_DmaBDT_ItemCount) {                                     // Update Free BD index
-        ControlStatus |= ENET_TX_BD_W_MASK;                                                     // Last BD in BDT must have WRAP bit set
-        EnetFreeBDIdx = 0;                                                                      // Free BD is the first item of Tx_DmaBDT
-    }
-    pAdapter->Tx_EnetFreeBDIdx = EnetFreeBDIdx;
-    pAdapter->Tx_EnetFreeBDCount--;
-
-    pFreeEnetBD->DataLen        = (USHORT)sgListPtr->Elements[0].Length;                       // Set ENET_TxBD data length
-    pFreeEnetBD->BufferAddress  = NdisGetPhysicalAddressLow(sgListPtr->Elements[0].Address);   // Set ENET_TxBD data address
-    pFreeEnetBD->ControlStatus  = ControlStatus;                                               // Write ControlStatus word of BD as last step
+    if (pAdapter->QueueCount > 1) {
+        ExtControlStatus |= pTxQueue->QueueIdx << ENET_TX_EBD_FTYPE_SHIFT;                     // Frame type selects the AVB class ring
+    }
+    if (pMpTxBD->CopyRequired) {
+        bytesCopied = MpCopyNetBuffer(pMpTxBD, pEnetSwExtBD, bytesToSent);                      // Copy data to driver provided buffer
+        ASSERT(bytesCopied);
+        copiedBDCount = 1;
+        pAdapter->TxdStatus.FramesXmitCopied++;
+    } else {
+        if (pMpTxBD->HeaderLength) {
+            bytesCopied = MpCopyNetBuffer(pMpTxBD, pEnetSwExtBD, pMpTxBD->HeaderLength);        // Copy headers only, checksum fields are cleared there
+            ASSERT(bytesCopied == pMpTxBD->HeaderLength);
+            copiedBDCount = 1;
+        }
+        pAdapter->TxdStatus.FramesXmitCopyAvoided++;
+        pAdapter->TxdStatus.BytesXmitCopyAvoided += bytesToSent - bytesCopied;
+    }
+    pTxQueue->EnetSwExtBDT[EnetFreeBDIdx].pMpBD = pMpTxBD;                                      // Associate sw MP_TxBD with the first hw ENET_TxBD of the frame
+    for (elementIdx = 0; elementIdx < (ULONG)pMpTxBD->EnetBDCount; elementIdx++) {
+        pFreeEnetBD = MP_TX_DMA_BD(pAdapter, pTxQueue, EnetFreeBDIdx);
+        ASSERT(!(pFreeEnetBD->ControlStatus & ENET_TX_BD_R_MASK));
+        ControlStatus = ENET_TX_BD_R_MASK;                                                      // Prepare transfer flags
+        if (elementIdx == (ULONG)pMpTxBD->EnetBDCount - 1) {
+            ControlStatus |= ENET_TX_BD_L_MASK | ENET_TX_BD_TC_MASK;                            // Last BD of the frame
+        }
+        if (++EnetFreeBDIdx == pTxQueue->DmaBDT_ItemCount) {                                    // Update Free BD index
+            ControlStatus |= ENET_TX_BD_W_MASK;                                                 // Last BD in BDT must have WRAP bit set
+            EnetFreeBDIdx = 0;                                                                  // Free BD is the first item of Tx_DmaBDT
+        }
+        if (elementIdx < copiedBDCount) {
+            pFreeEnetBD->DataLen        = (USHORT)bytesCopied;                                            // Set ENET_TxBD data length
+            pFreeEnetBD->BufferAddress  = NdisGetPhysicalAddressLow(pEnetSwExtBD->BufferPa);              // Set ENET_TxBD data address
+        } else {
+            ULONG sgElementIdx = pMpTxBD->PayloadSGIdx + elementIdx - copiedBDCount;
+            ULONG sgElementOffset = (sgElementIdx == pMpTxBD->PayloadSGIdx)? pMpTxBD->PayloadSGOffset : 0;
+            pFreeEnetBD->DataLen        = (USHORT)(sgListPtr->Elements[sgElementIdx].Length - sgElementOffset);                   // Set ENET_TxBD data length
+            pFreeEnetBD->BufferAddress  = NdisGetPhysicalAddressLow(sgListPtr->Elements[sgElementIdx].Address) + sgElementOffset; // Set ENET_TxBD data address
+        }
+        if (pAdapter->EnhancedBDs) {
+            MP_ENHANCED_BD(pFreeEnetBD)->ExtControlStatus = ExtControlStatus;
+            MP_ENHANCED_BD(pFreeEnetBD)->BDU              = 0;
+        }
+        if (elementIdx == 0) {
+            FirstControlStatus = ControlStatus;                                                 // First BD is handed over to DMA as the last one
+        } else {
+            pFreeEnetBD->ControlStatus = ControlStatus;                                         // Write ControlStatus word of BD as last step
+        }
+    }
+    pTxQueue->EnetFreeBDIdx = EnetFreeBDIdx;
+    pTxQueue->EnetFreeBDCount -= pMpTxBD->EnetBDCount;
+
+    _DataSynchronizationBarrier();                                                             // Make sure the rest of the chain is visible before the first BD
+    pFirstEnetBD->ControlStatus = FirstControlStatus;                                          // Write ControlStatus word of the first BD as last step
     _DataSynchronizationBarrier();                                                             // Wait for read is finished
-    ControlStatus = pFreeEnetBD->ControlStatus;                                                // Read ControlStatus back
+    ControlStatus = pFirstEnetBD->ControlStatus;                                               // Read ControlStatus back
     _DataSynchronizationBarrier();                                                             // Wait for read is finished
-    DBG_ENET_DEV_TX_PRINT_TRACE("NB(%d): Added to ENET_BD, Size: %5d.",pMpTxBD->NBId,(USHORT)sgListPtr->Elements[0].Length);
-    if (pAdapter->ENETRegBase->TDAR == 0) {
+    DBG_ENET_DEV_TX_PRINT_TRACE("NB(%d): Added to %d ENET_BD(s), Size: %5d, Copied: %d bytes.", pMpTxBD->NBId, pMpTxBD->EnetBDCount, bytesToSent, bytesCopied);
+    if (*pTxQueue->pTDAR == 0) {
         _DataSynchronizationBarrier();                                                         // Wait for read is finished
-        if (pFreeEnetBD->ControlStatus & ENET_TX_BD_R_MASK) {                                  // Transfer not started yet?
-            DBG_ENET_DEV_TX_PRINT_TRACE("NB(%d): Starting transfer. TDAR: 0x%08X, EIR: 0x%08X", pMpTxBD->NBId, pAdapter->ENETRegBase->TDAR, pAdapter->ENETRegBase->EIR.U);
-            pAdapter->ENETRegBase->TDAR = 0x00000000;                                          // No, start transfer
+        if (pFirstEnetBD->ControlStatus & ENET_TX_BD_R_MASK) {                                 // Transfer not started yet?
+            DBG_ENET_DEV_TX_PRINT_TRACE("NB(%d): Starting transfer on ring %d. TDAR: 0x%08X, EIR: 0x%08X", pMpTxBD->NBId, pTxQueue->QueueIdx, *pTxQueue->pTDAR, pAdapter->ENETRegBase->EIR.U);
+            *pTxQueue->pTDAR = 0x00000000;                                                     // No, start transfer
         }
     }
     DBG_ENET_DEV_TX_METHOD_END();
@@ -472,11 +557,14 @@ void MpTxFillEnetTxBD(_In_ PMP_ADAPTER pAdapter, _In_ PMP_TX_BD pMpTxBD)
 Routine Description:
     Tries to send the next pending Ethernet frame (Net buffer). If an outgoing frame is pending, it makes sure we have enough
     free BDs to accommodate for the frame fragments. If we do, the frame is taken out from
-    the queue, the required TFD list is setup to map the frame fragments and the transmission is
+    the pending ring, the required TFD list is setup to map the frame fragments and the transmission is
     initiated.
     The above process continues until there are no more TX frames to send or we exhausted all
     our free TFDs, and we need to wait for a TX frame to complete before we can send the next
     pending frames.
+    The rings are served from the highest priority AVB class ring down to the best effort ring. Each ring is consumed in order,
+    a frame whose SG list is not ready yet stops the ring.
+    Caller must hold Tx_SpinLock, so a whole batch of frames is posted under one lock acquisition.
 Arguments:
     pAdapter    Address of the adapter context
 Return Value:
@@ -485,28 +573,33 @@ Return Value:
 void MpSendNextNB(_In_ PMP_ADAPTER pAdapter)
 {
     DBG_ENET_DEV_TX_METHOD_BEG();
-    NdisAcquireSpinLock(&pAdapter->Tx_SpinLock);
     do {
         if (pAdapter->NdisStatus != NDIS_STATUS_SUCCESS)  {                       // Make sure the adapter is ready
             DBG_SM_PRINT_TRACE("NIC is not ready ");
             break;
         }
-        for (;;) {
-            if ((pAdapter->Tx_EnetFreeBDCount == 0)) {                            // No Dma BD empty?
-//TODO                DBG_ENET_DEV_TX_PRINT_TRACE("NB(%d) - OUT of ENET_TxBD", pAdapter->Tx_pCurrentMpBD->NBId);
-                break;                                                            // Do nothing, Tx DPC will dequeue NB from Tx_qMpOwnedBDs
-            }
-            PLIST_ENTRY pListEntry = MpQueueGetNext(&pAdapter->Tx_qMpOwnedBDs);   // Get NB from remove from Miniport queue
-            if (pListEntry == NULL) {                                             // Queue empty?
-                DBG_ENET_DEV_TX_PRINT_TRACE("Tx_qMpOwnedBDs EMPTY");
-                break;                                                            // Yes, no more NBs to send.
-            }
-            PMP_TX_BD Tx_pCurrentMpBD = Tx_pCurrentMpBD = CONTAINING_RECORD(pListEntry, MP_TX_BD, Link);  // Get NB address
-            MpQueueAdd(&pAdapter->Tx_qDmaOwnedBDs, &Tx_pCurrentMpBD->Link);                               // Add NB to the DMA queue
-            MpTxFillEnetTxBD(pAdapter, Tx_pCurrentMpBD);                                                  // Put data to HW add start transfer
-        } // Keep processing queued TX frames
+        for (ULONG QueueIdx = pAdapter->QueueCount; QueueIdx-- > 0;) {
+            PMP_TX_QUEUE pTxQueue = &pAdapter->Tx_Queue[QueueIdx];
+            for (;;) {
+                if ((pTxQueue->EnetFreeBDCount == 0)) {                               // No Dma BD empty?
+                    break;                                                            // Do nothing, Tx DPC will dequeue NB from PendingRing
+                }
+                PMP_TX_BD Tx_pCurrentMpBD = MpTxRingPeek(&pTxQueue->PendingRing);     // Get the oldest NB, but leave it in the pending ring
+                if (Tx_pCurrentMpBD == NULL) {                                        // Ring empty?
+                    break;                                                            // Yes, no more NBs to send.
+                }
+                if (!MpTxIsMapped(Tx_pCurrentMpBD)) {                                 // SG list of the oldest NB not ready yet?
+                    break;                                                            // Keep the frame order, its publisher calls us again
+                }
+                if (Tx_pCurrentMpBD->EnetBDCount > pTxQueue->EnetFreeBDCount) {       // Not enough Dma BDs for all the NB fragments?
+                    DBG_ENET_DEV_TX_PRINT_TRACE("NB(%d) - OUT of ENET_TxBD on ring %d, %d required", Tx_pCurrentMpBD->NBId, QueueIdx, Tx_pCurrentMpBD->EnetBDCount);
+                    break;                                                            // Do nothing, Tx DPC will dequeue NB from PendingRing
+                }
+                (void)MpTxRingPop(&pTxQueue->PendingRing);                            // Remove NB from the pending ring, EnetSwExtBDT tracks it from now on
+                MpTxFillEnetTxBD(pAdapter, Tx_pCurrentMpBD);                          // Put data to HW add start transfer
+            } // Keep processing queued TX frames
+        }
     } while (0);
-    NdisReleaseSpinLock(&pAdapter->Tx_SpinLock);
     DBG_ENET_DEV_TX_METHOD_END();
 }
 
@@ -515,6 +608,10 @@ Routine Description:
     It is called by NDIS to process a scatter/gather list for a NET_BUFFER.
     The routine makes sure we have enough TXDs to satisfy Ethernet NET_BUFFER scatter/gather list
     requirements, and if we do, the buffer is queued for transmission.
+    NDIS calls it at DISPATCH_LEVEL, either from NdisMAllocateNetBufferSGList() in MpSendNetBufferLists()
+    or later, when map registers become available. The frame already has its own slot in the pending ring, so it is
+    prepared without Tx_SpinLock. MpSendNetBufferLists() and this routine each drop one MapRefCount reference, the one
+    that drops the last reference posts the frame.
 Arguments:
     DeviceObjectPtr Address of the related device object.
     Reserved        Not used
@@ -527,19 +624,94 @@ _Use_decl_annotations_
 void MpProcessSGList(PDEVICE_OBJECT DeviceObjectPtr, PVOID Reserved, PSCATTER_GATHER_LIST SGListPtr, PVOID ContextPtr)
 {
     PMP_TX_BD         pMpTxBD = (PMP_TX_BD)(ContextPtr);
+    PMP_ADAPTER       pAdapter = pMpTxBD->pAdapter;
+    PMP_TX_QUEUE      pTxQueue = pMpTxBD->pTxQueue;
+    ULONG             maxBDCount = min(ENET_TX_MAX_BD_PER_FRAME, (ULONG)pTxQueue->DmaBDT_ItemCount);
 
     UNREFERENCED_PARAMETER(DeviceObjectPtr);
     UNREFERENCED_PARAMETER(Reserved);
 
-//TODO    DBG_ENET_DEV_TX_PRINT_TRACE("NB(%d) Adding to Tx_qMpOwnedBDs queue", pMpTxBD->NBId);
-    pMpTxBD->pSGList = SGListPtr;
-    MpQueueAdd(&pMpTxBD->pAdapter->Tx_qMpOwnedBDs, &pMpTxBD->Link);
+//TODO    DBG_ENET_DEV_TX_PRINT_TRACE("NB(%d) Adding to Tx_PendingRing", pMpTxBD->NBId);
+    pMpTxBD->pSGList      = SGListPtr;
+    pMpTxBD->EnetBDCount  = 1;                                                           // Copied frame occupies one ENET_TxBD
+    pMpTxBD->CopyRequired = TRUE;                                                        // Small frame, or uDMA can't handle the SG elements
+    if (NET_BUFFER_DATA_LENGTH(pMpTxBD->pNB) > ENET_TX_COPY_BREAK_LENGTH) {
+        ULONG copiedBDCount = pMpTxBD->HeaderLength? 1 : 0;                              // Headers with checksum fields are sent from the driver Tx buffer
+        ULONG elementIdx = 0;
+        ULONG offset = pMpTxBD->HeaderLength;
+        while ((elementIdx < SGListPtr->NumberOfElements) && (offset >= SGListPtr->Elements[elementIdx].Length)) {
+            offset -= SGListPtr->Elements[elementIdx++].Length;                          // Skip SG elements holding copied headers only
+        }
+        if (copiedBDCount && (elementIdx < SGListPtr->NumberOfElements)) {
+            ULONG misalignment = (NdisGetPhysicalAddressLow(SGListPtr->Elements[elementIdx].Address) + offset) & ENET_TX_BUFFER_ALIGN_MASK;
+            if (misalignment) {                                                          // Copy a few more bytes, so the payload starts aligned
+                offset += ENET_TX_BUFFER_ALIGN_MASK + 1 - misalignment;
+                pMpTxBD->HeaderLength += (USHORT)(ENET_TX_BUFFER_ALIGN_MASK + 1 - misalignment);
+            }
+        }
+        if ((elementIdx < SGListPtr->NumberOfElements) && (offset < SGListPtr->Elements[elementIdx].Length) &&
+            (copiedBDCount + SGListPtr->NumberOfElements - elementIdx <= maxBDCount)) {
+            pMpTxBD->CopyRequired = FALSE;                                               // Map SG elements directly, if uDMA can handle all of them
+            for (ULONG Idx = elementIdx; Idx < SGListPtr->NumberOfElements; Idx++) {
+                ULONG elementOffset = (Idx == elementIdx)? offset : 0;
+                if ((SGListPtr->Elements[Idx].Length == 0) || ((NdisGetPhysicalAddressLow(SGListPtr->Elements[Idx].Address) + elementOffset) & ENET_TX_BUFFER_ALIGN_MASK)) {
+                    pMpTxBD->CopyRequired = TRUE;                                        // Empty or unaligned fragment, use driver Tx buffer
+                    break;
+                }
+            }
+        }
+        if (!pMpTxBD->CopyRequired) {
+            pMpTxBD->PayloadSGIdx    = elementIdx;
+            pMpTxBD->PayloadSGOffset = offset;
+            pMpTxBD->EnetBDCount     = (LONG)(copiedBDCount + SGListPtr->NumberOfElements - elementIdx);
+        }
+    }
+    if (NdisInterlockedDecrement(&pMpTxBD->MapRefCount) == 0) {                         // Mapped after NdisMAllocateNetBufferSGList() returned?
+        NdisDprAcquireSpinLock(&pAdapter->Tx_SpinLock);                                  // Yes, pMpTxBD may be already gone, only the ring is touched
+        MpSendNextNB(pAdapter);                                                          // Post it to ENET_TxBDs, if there are enough free
+        NdisDprReleaseSpinLock(&pAdapter->Tx_SpinLock);
+    }
+}
+
+/*++
+Routine Description:
+    Selects the ENET Tx ring of the packet. The 802.1p priority is taken from the packet out-of-band 802.1Q information,
+    or from the VLAN tag of the first frame if the tag is already inserted in the frame data. Untagged packets use the best effort ring.
+Arguments:
+    pAdapter    Address of the adapter context
+    pNBL        The Tx packet (NET_BUFFER_LIST)
+Return Value:
+    Address of the ENET Tx ring
+--*/
+static PMP_TX_QUEUE MpTxGetQueue(_In_ PMP_ADAPTER pAdapter, _In_ PNET_BUFFER_LIST pNBL)
+{
+    NDIS_NET_BUFFER_LIST_8021Q_INFO Ieee8021QInfo;
+    ULONG                           Priority;
+    UCHAR                           VlanHeader[ETHER_FRAME_HEADER_LENGTH + 1];
+
+    if (pAdapter->QueueCount == 1) {
+        return &pAdapter->Tx_Queue[0];
+    }
+    Ieee8021QInfo.Value = NET_BUFFER_LIST_INFO(pNBL, Ieee8021QNetBufferListInfo);
+    Priority = (ULONG)Ieee8021QInfo.TagHeader.UserPriority;
+    if (Priority == 0) {
+        PUCHAR pHeader = (PUCHAR)NdisGetDataBuffer(NET_BUFFER_LIST_FIRST_NB(pNBL), sizeof(VlanHeader), VlanHeader, 1, 0);
+        if ((pHeader != NULL) && ((USHORT)((pHeader[ETHER_FRAME_TYPE_OFFSET] << 8) | pHeader[ETHER_FRAME_TYPE_OFFSET + 1]) == ETHER_TYPE_VLAN)) {  // 802.1Q tag present?
+            Priority = pHeader[ETHER_FRAME_HEADER_LENGTH] >> 5;                                                                                  // PCP field of TCI
+        }
+    }
+    return &pAdapter->Tx_Queue[ENET_PRIORITY_TO_QUEUE(Priority)];
 }
 
 /*++
 Routine Description:
     NDIS calls this method to send a list of Tx Ethernet frames through the network. Each NET_BUFFER structure
     that is linked to a NET_BUFFER_LIST structure describes a single Ethernet frame.
+    The MpTxBDs of all frames of the NBL chain are prepared first, then pending ring slots are reserved for all of them
+    under one Tx_SpinLock acquisition. Each frame gets a fixed slot, so frames are sent in the NBL chain order regardless
+    of the order MpProcessSGList() is called in. The frames are mapped without the lock held and the ones mapped
+    synchronously are posted to ENET_TxBDs under a second acquisition at the end.
+    Failed NET_BUFFER_LISTs are completed at the end.
 Argument:
     MiniportAdapterContext  Adapter context.
     NetBufferListPtr        A linked list of NET_BUFFER_LIST objects that we previously indicated to NDIS.
@@ -551,42 +723,46 @@ Return Value:
 _Use_decl_annotations_
 void MpSendNetBufferLists(NDIS_HANDLE MiniportAdapterContext, PNET_BUFFER_LIST NetBufferListPtr, NDIS_PORT_NUMBER PortNumber, ULONG SendFlags)
 {
-    ULONG             uQueuedPacketCounter = 0;
     NDIS_STATUS       status               = NDIS_STATUS_SUCCESS;
+    NDIS_STATUS       sgStatus             = NDIS_STATUS_SUCCESS;
     PMP_ADAPTER       pAdapter             = (PMP_ADAPTER)MiniportAdapterContext;
     PNET_BUFFER_LIST  pNextNBL             = NetBufferListPtr;
+    PNET_BUFFER_LIST  pUnreservedNBL       = NULL;                                            // The first NBL without pending ring slots, it and the rest of the chain are failed
+    PNET_BUFFER_LIST  pCompletedNBL        = NULL;                                            // NBLs whose frames all completed before the NB loop ended
     PNET_BUFFER_LIST  pCurrentNBL;
     PNET_BUFFER       pCurrentNB;
     PMP_TX_BD         pMpTxBD;
+    PMP_TX_QUEUE      pTxQueue;
+    LIST_ENTRY        releasedList;                                                           // Frames whose reserved slots are given up
+    BOOLEAN           isPostRequired       = FALSE;                                           // At least one frame was mapped synchronously
+    ULONG             sendCompleteFlags    = 0;
 
     UNREFERENCED_PARAMETER(PortNumber);
     DBG_ENET_DEV_TX_METHOD_BEG();
-
+    InitializeListHead(&releasedList);
+    if (NDIS_TEST_SEND_AT_DISPATCH_LEVEL(SendFlags)) {
+        NDIS_SET_SEND_COMPLETE_FLAG(sendCompleteFlags, NDIS_SEND_COMPLETE_FLAGS_DISPATCH_LEVEL);
+    }
     for(;;) {
-        NdisAcquireSpinLock(&pAdapter->Tx_SpinLock);
         status = pAdapter->NdisStatus;
-        NdisReleaseSpinLock(&pAdapter->Tx_SpinLock);
         if (status != NDIS_STATUS_SUCCESS)  {                                                 // Make sure the adapter is ready
             DBG_SM_PRINT_TRACE("NIC is not ready ");
             break;
         }
-        while (pNextNBL != NULL) {                                                            // For all NBL in NBL chain do
-            pCurrentNBL = pNextNBL;                                                           // Save current NBL address
-            pNextNBL = NET_BUFFER_LIST_NEXT_NBL(pNextNBL);                                    // Save next NBL address
-            NET_BUFFER_LIST_NEXT_NBL(pCurrentNBL) = NULL;                                     // Detach current NBL from NBL chain
+        // Prepare MpTxBDs of all NBs of the NBL chain, Tx_SpinLock is not needed
+        for (pCurrentNBL = NetBufferListPtr; pCurrentNBL != NULL; pCurrentNBL = NET_BUFFER_LIST_NEXT_NBL(pCurrentNBL)) {
             #if DBG
             MP_NBL_SET_ID(pCurrentNBL, NdisInterlockedIncrement(&pAdapter->Tx_NBLCounter));   // Save NBL sequence number
             #endif
-            // For all NB in current NBL do:
+            pTxQueue = MpTxGetQueue(pAdapter, pCurrentNBL);                                   // All NBs of the NBL are sent through the same ring
             for (pCurrentNB = NET_BUFFER_LIST_FIRST_NB(pCurrentNBL); pCurrentNB != NULL; pCurrentNB = NET_BUFFER_NEXT_NB(pCurrentNB)) {
-                NdisInterlockedIncrement(&MP_NBL_NB_Counter(pCurrentNBL));                     // Increment pending NB counter in NBL
                 pMpTxBD = (PMP_TX_BD)NdisAllocateFromNPagedLookasideList(&pAdapter->Tx_MpTxBDLookasideList);
+                MP_NB_SET_pMpTxBD(pCurrentNB, pMpTxBD);
                 if (pMpTxBD == NULL) {
                     DBG_ENET_DEV_TX_PRINT_TRACE("Fail to allocate memory for MpTxBD");
                     status = NDIS_STATUS_RESOURCES;                                           // Fail to allocate memory from non-paged pool
                     break;
                 }
-                MP_NB_SET_pMpTxBD(pCurrentNB, pMpTxBD);
                 #if DBG
                 KeQuerySystemTimePrecise(&MP_NB_Time(pCurrentNB));
                 pMpTxBD->NBId                   = NdisInterlockedIncrement(&pAdapter->Tx_NBCounter);   // Save NB sequence number
@@ -594,69 +770,128 @@ void MpSendNetBufferLists(NDIS_HANDLE MiniportAdapterContext, PNET_BUFFER_LIST N
                 #endif
                 DBG_ENET_DEV_TX_PRINT_TRACE("NB(%d) MpTxBD allocated ", pMpTxBD->NBId);
                 pMpTxBD->pAdapter  = pAdapter;
+                pMpTxBD->pTxQueue  = pTxQueue;
                 pMpTxBD->pNBL      = pCurrentNBL;                          // Associate NBL with MpTxBD
                 pMpTxBD->pNB       = pCurrentNB;                           // Associate NB with MpTxBD
                 pMpTxBD->pSGList   = NULL;
-                // Map the buffer to its physically contiguous fragments. NdisMAllocateNetBufferSGList needs to be called at DISPATCH_LEVEL
+                pMpTxBD->MapRefCount   = 2;                                // Dropped by this routine and by MpProcessSGList()
+                pMpTxBD->CopyRequired  = FALSE;
+                pMpTxBD->EnhancedFlags = 0;
+                pMpTxBD->IpCsumOffset  = 0;
+                pMpTxBD->L4CsumOffset  = 0;
+                pMpTxBD->HeaderLength  = 0;
+                MpTxPrepareChecksum(pAdapter, pMpTxBD);                    // Headers of frames with checksum offload are sent from the driver Tx buffer
+                #if NDIS_SUPPORT_NDIS682
+                if (pAdapter->Ptp.Enabled && NdisTestNblFlag(pCurrentNBL, NDIS_NBL_FLAGS_CAPTURE_TIMESTAMP_ON_TRANSMIT)) {
+                    pMpTxBD->EnhancedFlags |= ENET_TX_EBD_TS_MASK;         // Capture the IEEE 1588 transmit time stamp
+                }
+                #endif
+            }
+            if (status != NDIS_STATUS_SUCCESS) {
+                MpTxFreeMpTxBDs(pAdapter, NET_BUFFER_LIST_FIRST_NB(pCurrentNBL), pCurrentNB);
+                pUnreservedNBL = pCurrentNBL;
+                break;
+            }
+        }
+        // Reserve pending ring slots for all prepared NBs under one Tx_SpinLock acquisition, all NBs of an NBL or none of them
+        NdisAcquireSpinLock(&pAdapter->Tx_SpinLock);
+        for (pCurrentNBL = NetBufferListPtr; pCurrentNBL != pUnreservedNBL; pCurrentNBL = NET_BUFFER_LIST_NEXT_NBL(pCurrentNBL)) {
+            PMP_TX_RING pRing = &MP_NB_pMpTxBD(NET_BUFFER_LIST_FIRST_NB(pCurrentNBL))->pTxQueue->PendingRing;
+            ULONG       NBCount = 0;
+            for (pCurrentNB = NET_BUFFER_LIST_FIRST_NB(pCurrentNBL); pCurrentNB != NULL; pCurrentNB = NET_BUFFER_NEXT_NB(pCurrentNB)) {
+                NBCount++;
+            }
+            if (NBCount > MP_TX_RING_FREE_COUNT(pRing)) {                                     // Not enough free slots in the pending ring?
+                DBG_ENET_DEV_TX_PRINT_TRACE("PendingRing FULL, NBL(%d) needs %d slots", MP_NBL_ID(pCurrentNBL), NBCount);
+                status = NDIS_STATUS_RESOURCES;
+                break;
+            }
+            for (pCurrentNB = NET_BUFFER_LIST_FIRST_NB(pCurrentNBL); pCurrentNB != NULL; pCurrentNB = NET_BUFFER_NEXT_NB(pCurrentNB)) {
+                MpTxRingReserve(pRing, MP_NB_pMpTxBD(pCurrentNB));
+            }
+        }
+        NdisReleaseSpinLock(&pAdapter->Tx_SpinLock);
+        for (PNET_BUFFER_LIST pNBL = pCurrentNBL; pNBL != pUnreservedNBL; pNBL = NET_BUFFER_LIST_NEXT_NBL(pNBL)) {
+            MpTxFreeMpTxBDs(pAdapter, NET_BUFFER_LIST_FIRST_NB(pNBL), NULL);                  // Prepared, but no slot reserved
+        }
+        pUnreservedNBL = pCurrentNBL;
+        // Map the frames, MpProcessSGList() may run asynchronously
+        while (pNextNBL != pUnreservedNBL) {                                                  // For all NBLs with reserved slots do
+            pCurrentNBL = pNextNBL;                                                           // Save current NBL address
+            pNextNBL = NET_BUFFER_LIST_NEXT_NBL(pNextNBL);                                    // Save next NBL address
+            NET_BUFFER_LIST_NEXT_NBL(pCurrentNBL) = NULL;                                     // Detach current NBL from NBL chain
+            NdisInterlockedIncrement(&MP_NBL_NB_Counter(pCurrentNBL));                         // Keep the NBL, its first NBs may complete before the last one is mapped
+            for (pCurrentNB = NET_BUFFER_LIST_FIRST_NB(pCurrentNBL); pCurrentNB != NULL; pCurrentNB = NET_BUFFER_NEXT_NB(pCurrentNB)) {
+                pMpTxBD = MP_NB_pMpTxBD(pCurrentNB);
+                NdisInterlockedIncrement(&MP_NBL_NB_Counter(pCurrentNBL));                     // Increment pending NB counter in NBL
                 DBG_ENET_DEV_TX_PRINT_TRACE("NB(%d) Calling AllocSGList()", pMpTxBD->NBId);
-                NdisAcquireSpinLock(&pAdapter->Tx_SpinLock);
-                status = NdisMAllocateNetBufferSGList(pAdapter->Tx_DmaHandle, pCurrentNB, pMpTxBD, NDIS_SG_LIST_WRITE_TO_DEVICE, &pMpTxBD->SGList, pAdapter->Tx_SGListSize);
-                NdisReleaseSpinLock(&pAdapter->Tx_SpinLock);
-                if (status != NDIS_STATUS_SUCCESS) {                       // Fail to allocate memory from non-paged pool for SGList
-                    DBG_ENET_DEV_PRINT_ERROR("NB(%d) NdisMAllocateNetBufferSGList() failed. Status: 0x%08X", pMpTxBD->NBId, status);
+                NdisInterlockedIncrement(&pAdapter->Tx_PendingNBs);                            // The frame may be sent and completed before NdisMAllocateNetBufferSGList() returns
+                sgStatus = NdisMAllocateNetBufferSGList(pAdapter->Tx_DmaHandle, pCurrentNB, pMpTxBD, NDIS_SG_LIST_WRITE_TO_DEVICE, &pMpTxBD->SGList, pAdapter->Tx_SGListSize);
+                if (sgStatus != NDIS_STATUS_SUCCESS) {                                         // Fail to allocate memory from non-paged pool for SGList
+                    DBG_ENET_DEV_PRINT_ERROR("NB(%d) NdisMAllocateNetBufferSGList() failed. Status: 0x%08X", pMpTxBD->NBId, sgStatus);
+                    NdisInterlockedDecrement(&pAdapter->Tx_PendingNBs);
+                    NdisInterlockedDecrement(&MP_NBL_NB_Counter(pCurrentNBL));                 // The failed NB is not sent
                     break;
                 }
-                NdisInterlockedIncrement(&pAdapter->Tx_PendingNBs);
+                if (NdisInterlockedDecrement(&pMpTxBD->MapRefCount) == 0) {                    // MpProcessSGList() already done?
+                    isPostRequired = TRUE;                                                     // Yes, the frame is posted at the end
+                }
             }
-            if (status == NDIS_STATUS_SUCCESS) {
-                uQueuedPacketCounter++;
-            } else {  // handle error case
-                if (pCurrentNB != NULL) {
-                    pMpTxBD = MP_NB_pMpTxBD(pCurrentNB);
-                    if (pMpTxBD != NULL) {
-                        DBG_ENET_DEV_TX_PRINT_TRACE("Discarding NB(%d) 0x%08X", pCurrentNB, pMpTxBD->NBId);
-                        if (pMpTxBD->pSGList != NULL) {
-                            NdisMFreeNetBufferSGList(pAdapter->AdapterHandle, pMpTxBD->pSGList, pCurrentNB);   // Free SG list
-                        }
-                        NdisFreeToNPagedLookasideList(&pAdapter->Tx_MpTxBDLookasideList, pMpTxBD);             // Free TxBD
-                    }
-                    if (NdisInterlockedDecrement(&MP_NBL_NB_Counter(pCurrentNBL)) == 0) {
-                        ULONG sendCompleteFlags = 0;
-                        if (NDIS_TEST_SEND_AT_DISPATCH_LEVEL(SendFlags)) {
-                            NDIS_SET_SEND_COMPLETE_FLAG(sendCompleteFlags, NDIS_SEND_COMPLETE_FLAGS_DISPATCH_LEVEL);
-                        }
-                        NET_BUFFER_LIST_STATUS(NetBufferListPtr) = status;
-                        DBG_ENET_DEV_TX_PRINT_TRACE("Completing NBL: 0x%08X, Status: 0x%08X", pCurrentNBL, status);
-                        NdisMSendNetBufferListsComplete(pAdapter->AdapterHandle, pCurrentNBL, sendCompleteFlags);
+            if (NdisInterlockedDecrement(&MP_NBL_NB_Counter(pCurrentNBL)) == 0) {              // No NB of this NBL still queued?
+                NET_BUFFER_LIST_STATUS(pCurrentNBL) = sgStatus;
+                NET_BUFFER_LIST_NEXT_NBL(pCurrentNBL) = pCompletedNBL;
+                pCompletedNBL = pCurrentNBL;                                                   // Complete it at the end
+            }
+            if (sgStatus != NDIS_STATUS_SUCCESS) {                                             // Give up the slots of the failed NB and of all NBs behind it
+                for (; pCurrentNB != NULL; pCurrentNB = NET_BUFFER_NEXT_NB(pCurrentNB)) {
+                    InsertTailList(&releasedList, &MP_NB_pMpTxBD(pCurrentNB)->Link);
+                }
+                for (PNET_BUFFER_LIST pNBL = pNextNBL; pNBL != pUnreservedNBL; pNBL = NET_BUFFER_LIST_NEXT_NBL(pNBL)) {
+                    for (pCurrentNB = NET_BUFFER_LIST_FIRST_NB(pNBL); pCurrentNB != NULL; pCurrentNB = NET_BUFFER_NEXT_NB(pCurrentNB)) {
+                        InsertTailList(&releasedList, &MP_NB_pMpTxBD(pCurrentNB)->Link);
                     }
                 }
+                status = sgStatus;
+                break;                                                                         // Fail the remaining NBLs
             }
         } // More NBLs
+        // Post the frames mapped synchronously, in the ring order, under one Tx_SpinLock acquisition
+        if (isPostRequired || !IsListEmpty(&releasedList)) {
+            NdisAcquireSpinLock(&pAdapter->Tx_SpinLock);
+            for (PLIST_ENTRY pListEntry = releasedList.Flink; pListEntry != &releasedList; pListEntry = pListEntry->Flink) {
+                pMpTxBD = CONTAINING_RECORD(pListEntry, MP_TX_BD, Link);
+                MpTxRingRelease(&pMpTxBD->pTxQueue->PendingRing, pMpTxBD);
+            }
+            MpSendNextNB(pAdapter);
+            NdisReleaseSpinLock(&pAdapter->Tx_SpinLock);
+        }
+        while (!IsListEmpty(&releasedList)) {
+            pMpTxBD = CONTAINING_RECORD(RemoveHeadList(&releasedList), MP_TX_BD, Link);
+            DBG_ENET_DEV_TX_PRINT_TRACE("Discarding NB(%d) 0x%08X", pMpTxBD->NBId, pMpTxBD->pNB);
+            MP_NB_SET_pMpTxBD(pMpTxBD->pNB, NULL);
+            NdisFreeToNPagedLookasideList(&pAdapter->Tx_MpTxBDLookasideList, pMpTxBD);     // Free TxBD
+        }
         break;
     }
-    if (status != NDIS_STATUS_SUCCESS) {    // On failure, complete (fail) the remaining packets (NBLs)
-        ULONG sendCompleteFlags = 0;
-        if (NDIS_TEST_SEND_AT_DISPATCH_LEVEL(SendFlags)) {
-            NDIS_SET_SEND_COMPLETE_FLAG(sendCompleteFlags, NDIS_SEND_COMPLETE_FLAGS_DISPATCH_LEVEL);
-        }
-        if (pNextNBL) { // Complete remaining packets (NBLs)
-            for (PNET_BUFFER_LIST tmp_pNBL = pNextNBL; tmp_pNBL != NULL;  tmp_pNBL = NET_BUFFER_LIST_NEXT_NBL(tmp_pNBL)) {
-                NET_BUFFER_LIST_STATUS(tmp_pNBL) = status;
-                DBG_ENET_DEV_TX_PRINT_TRACE("Completing NBL: 0x%08, Status: 0x%08", tmp_pNBL, status);
-            }
-            NdisMSendNetBufferListsComplete(pAdapter->AdapterHandle, pNextNBL, sendCompleteFlags);
+    if (pCompletedNBL != NULL) {
+        DBG_ENET_DEV_TX_PRINT_TRACE("Completing NBL: 0x%08X, Status: 0x%08X", pCompletedNBL, NET_BUFFER_LIST_STATUS(pCompletedNBL));
+        NdisMSendNetBufferListsComplete(pAdapter->AdapterHandle, pCompletedNBL, sendCompleteFlags);
+    }
+    if ((status != NDIS_STATUS_SUCCESS) && (pNextNBL != NULL)) {    // On failure, complete (fail) the remaining packets (NBLs)
+        for (PNET_BUFFER_LIST tmp_pNBL = pNextNBL; tmp_pNBL != NULL;  tmp_pNBL = NET_BUFFER_LIST_NEXT_NBL(tmp_pNBL)) {
+            NET_BUFFER_LIST_STATUS(tmp_pNBL) = status;
+            DBG_ENET_DEV_TX_PRINT_TRACE("Completing NBL: 0x%08X, Status: 0x%08X", tmp_pNBL, status);
         }
+        NdisMSendNetBufferListsComplete(pAdapter->AdapterHandle, pNextNBL, sendCompleteFlags);
     }
-    if (uQueuedPacketCounter != 0) // If at lease one NBL (packet) was queued, kick off the transmission, if it had not been already started.
-        MpSendNextNB(pAdapter);    // Send queued NBs (Ethernet frames)
     DBG_ENET_DEV_TX_METHOD_END();
 }
 
 /*++
 Routine Description:
     It is called from EnetDpc() to handle 'frame transmission complete' interrupts.
-    MpHandleTxInterrupt() scans the TFD list for transmitted frames, notifies NDIS,
-    and tries to send the next queued outgoing frame.
+    MpHandleTxInterrupt() scans the TFD list of each used ENET ring for transmitted frames, tries to send the next queued outgoing frames
+    under the same Tx_SpinLock acquisition and notifies NDIS.
 Arguments:
     pAdapter        The miniport adapter context
     InterruptEvent  The Interrupt Event Register image.
@@ -676,31 +911,45 @@ void MpHandleTxInterrupt(PMP_ADAPTER pAdapter, UINT32 InterruptEvent)
     DBG_ENET_DEV_DPC_TX_METHOD_BEG();
 
     NdisDprAcquireSpinLock(&pAdapter->Tx_SpinLock);
-    EnetPendingBDIdx = pAdapter->Tx_EnetPendingBDIdx;
-    DBG_ENET_DEV_TX_PRINT_TRACE("**** ISR,  Tx_EnetPendingBDIdx: %d, Tx_EnetFreeBDIdx: %d, flags: 0x%08X, TDAR: 0x%08X ****", pAdapter->Tx_EnetPendingBDIdx, pAdapter->Tx_EnetFreeBDIdx, InterruptEvent, pAdapter->ENETRegBase->TDAR);
-    do {
-        pMpTxBD = pAdapter->Tx_EnetSwExtBDT[EnetPendingBDIdx].pMpBD;                     // Get Mp NB Tx BD
-        if (pMpTxBD == NULL) {                                                           // Mp NB Tx BD already processed as the first item in this loop?
-            break;                                                                       // Break the loop
-        }
-        pDmaTxBD = &pAdapter->Tx_DmaBDT[EnetPendingBDIdx];                               // Get Dma Tx BD
-        if (pDmaTxBD->ControlStatus & ENET_TX_BD_R_MASK) {                               // Dma Tx BD owned by DMA engine?
-            if (pAdapter->ENETRegBase->TDAR == 0) {                                      // DMA stopped? (ERR006358 bug fix)
-                pAdapter->ENETRegBase->TDAR = 0x0000000;                                 // Restart DMA
+    for (ULONG QueueIdx = 0; QueueIdx < pAdapter->QueueCount; QueueIdx++) {
+        PMP_TX_QUEUE pTxQueue = &pAdapter->Tx_Queue[QueueIdx];
+        EnetPendingBDIdx = pTxQueue->EnetPendingBDIdx;
+        DBG_ENET_DEV_TX_PRINT_TRACE("**** ISR, ring %d, EnetPendingBDIdx: %d, EnetFreeBDIdx: %d, flags: 0x%08X, TDAR: 0x%08X ****", QueueIdx, pTxQueue->EnetPendingBDIdx, pTxQueue->EnetFreeBDIdx, InterruptEvent, *pTxQueue->pTDAR);
+        do {
+            pMpTxBD = pTxQueue->EnetSwExtBDT[EnetPendingBDIdx].pMpBD;                        // Get Mp NB Tx BD
+            if (pMpTxBD == NULL) {                                                           // Mp NB Tx BD already processed as the first item in this loop?
+                break;                                                                       // Break the loop
             }
-            break;                                                                       // Break the loop
-        }
-        pAdapter->Tx_EnetSwExtBDT[EnetPendingBDIdx].pMpBD = NULL;                        // Mark Mp NB Tx BD as "already processed"
-        if (++EnetPendingBDIdx >= pAdapter->Tx_DmaBDT_ItemCount)                         // Updated ENET_BDT index
-            EnetPendingBDIdx = 0;
-        pAdapter->Tx_EnetFreeBDCount ++;                                                 // Update Free ENET_TxBD counter
-        pAdapter->Tx_EnetPendingBDIdx = EnetPendingBDIdx;                                // Update pending BD index
-        DBG_ENET_DEV_TX_PRINT_TRACE("NB(%d) 0x%08X done, adding it to the complete queue.", pMpTxBD->NBId, pMpTxBD->pNB);
-        (void)MpQueueGetNext(&pAdapter->Tx_qDmaOwnedBDs);           // Remove the TX BD from the 'in progress' queue
-        InsertHeadList(&completedNetBufferList, &pMpTxBD->Link);                         // Put BD to the completed BD queue
-        pAdapter->Tx_CheckForHangCounter = 0;                                            // Restart "check for hang" counter
-    } while (EnetPendingBDIdx != pAdapter->Tx_EnetFreeBDIdx);
-    DBG_ENET_DEV_TX_PRINT_TRACE("**** ISR, Before release spin lock, Tx_EnetPendingBDIdx: %d, Tx_EnetFreeBDIdx: %d", pAdapter->Tx_EnetPendingBDIdx, pAdapter->Tx_EnetFreeBDIdx);
+            LONG EnetLastBDIdx = EnetPendingBDIdx + pMpTxBD->EnetBDCount - 1;                // Index of the last ENET_TxBD of the frame
+            if (EnetLastBDIdx >= pTxQueue->DmaBDT_ItemCount)
+                EnetLastBDIdx -= pTxQueue->DmaBDT_ItemCount;
+            pDmaTxBD = MP_TX_DMA_BD(pAdapter, pTxQueue, EnetLastBDIdx);                      // Get the last Dma Tx BD of the frame
+            if (pDmaTxBD->ControlStatus & ENET_TX_BD_R_MASK) {                               // Dma Tx BD owned by DMA engine?
+                if (*pTxQueue->pTDAR == 0) {                                                 // DMA stopped? (ERR006358 bug fix)
+                    *pTxQueue->pTDAR = 0x0000000;                                            // Restart DMA
+                }
+                break;                                                                       // Break the loop
+            }
+            #if NDIS_SUPPORT_NDIS682
+            if (pMpTxBD->EnhancedFlags & ENET_TX_EBD_TS_MASK) {                              // Transmit time stamp requested?
+                NET_BUFFER_LIST_TIMESTAMP NblTimestamp;
+                NblTimestamp.Timestamp = MpPtpTimestampToTime(pAdapter, MP_ENHANCED_BD(pDmaTxBD)->TimeStamp);  // Stored in the last Dma Tx BD of the frame
+                NdisSetNblTimestampInfo(pMpTxBD->pNBL, &NblTimestamp);
+            }
+            #endif
+            pTxQueue->EnetSwExtBDT[EnetPendingBDIdx].pMpBD = NULL;                           // Mark Mp NB Tx BD as "already processed"
+            EnetPendingBDIdx = EnetLastBDIdx;
+            if (++EnetPendingBDIdx >= pTxQueue->DmaBDT_ItemCount)                            // Updated ENET_BDT index
+                EnetPendingBDIdx = 0;
+            pTxQueue->EnetFreeBDCount += pMpTxBD->EnetBDCount;                               // Update Free ENET_TxBD counter
+            pAdapter->Tx_IntModeration.Frames++;                                             // Frames completed by this interrupt
+            pTxQueue->EnetPendingBDIdx = EnetPendingBDIdx;                                   // Update pending BD index
+            DBG_ENET_DEV_TX_PRINT_TRACE("NB(%d) 0x%08X done, adding it to the complete queue.", pMpTxBD->NBId, pMpTxBD->pNB);
+            InsertHeadList(&completedNetBufferList, &pMpTxBD->Link);                         // Put BD to the completed BD queue
+            pAdapter->Tx_CheckForHangCounter = 0;                                            // Restart "check for hang" counter
+        } while (EnetPendingBDIdx != pTxQueue->EnetFreeBDIdx);
+    }
+    MpSendNextNB(pAdapter);                                                              // Send next waiting TX frames, if any...
     NdisDprReleaseSpinLock(&pAdapter->Tx_SpinLock);
 
     while (!IsListEmpty(&completedNetBufferList)) {                                      // Unwind all completed NET_BUFFERs
@@ -711,7 +960,6 @@ void MpHandleTxInterrupt(PMP_ADAPTER pAdapter, UINT32 InterruptEvent)
         NDIS_STATUS completionStatus = (InterruptEvent & ENET_TX_ERR_INT_MASK)? NDIS_STATUS_FAILURE : NDIS_STATUS_SUCCESS;   // Get the completion status
         MpTxUnwindNetBuffer(pAdapter, pMpTxBD->pNBL, pMpTxBD->pNB, completionStatus, NDIS_SEND_COMPLETE_FLAGS_DISPATCH_LEVEL);
     } // More completed TX frames
-    MpSendNextNB(pAdapter);            // Send next waiting TX frames, if any...
     DBG_ENET_DEV_DPC_TX_METHOD_END();
     return;
 }
@@ -728,9 +976,6 @@ _Use_decl_annotations_
 VOID MpTxInit(PMP_ADAPTER pAdapter)
 {
     pAdapter->Tx_CheckForHangCounter = 0;
-    pAdapter->Tx_EnetFreeBDCount     = pAdapter->Tx_DmaBDT_ItemCount;    // Initialize number of unused Ethernet Buffer Descriptors
-    pAdapter->Tx_EnetFreeBDIdx       = 0;
-    pAdapter->Tx_EnetPendingBDIdx    = 0;
 
     pAdapter->TxdStatus.FramesXmitGood            = 0;
     pAdapter->TxdStatus.FramesXmitBad             = 0;
@@ -739,7 +984,19 @@ VOID MpTxInit(PMP_ADAPTER pAdapter)
     pAdapter->TxdStatus.FramesXmitCollisionErrors = 0;
     pAdapter->TxdStatus.FramesXmitAbortedErrors   = 0;
     pAdapter->TxdStatus.FramsXmitCarrierErrors    = 0;
-    NdisZeroMemory((VOID*)pAdapter->Tx_DmaBDT, pAdapter->Tx_DmaBDT_Size);      // Zero TxBDT
+    pAdapter->TxdStatus.FramesXmitCopied          = 0;
+    pAdapter->TxdStatus.FramesXmitCopyAvoided     = 0;
+    pAdapter->TxdStatus.BytesXmitCopyAvoided      = 0;
+    for (ULONG QueueIdx = 0; QueueIdx < pAdapter->QueueCount; QueueIdx++) {
+        PMP_TX_QUEUE pTxQueue = &pAdapter->Tx_Queue[QueueIdx];
+        pTxQueue->EnetFreeBDCount  = pTxQueue->DmaBDT_ItemCount;               // Initialize number of unused Ethernet Buffer Descriptors
+        pTxQueue->EnetFreeBDIdx    = 0;
+        pTxQueue->EnetPendingBDIdx = 0;
+        for (LONG i = 0; i < pTxQueue->DmaBDT_ItemCount; i++) {
+            pTxQueue->EnetSwExtBDT[i].pMpBD = NULL;                            // No frame is associated with any ENET_TxBD
+        }
+        NdisZeroMemory((VOID*)pTxQueue->DmaBDT, pTxQueue->DmaBDT_Size);        // Zero TxBDT
+    }
 }
 
 /*++
@@ -753,26 +1010,43 @@ Return Value:
 _Use_decl_annotations_
 void MpRxInit(PMP_ADAPTER pAdapter)
 {
-    PENET_BD             pDmaBD = NULL;
-
-    ASSERT(pAdapter->Rx_DmaBDT_ItemCount);                                                // There must be at least one Rx buffer
-    pAdapter->Rx_EnetFreeBDIdx           = 0;                                             // Initialize HW Dma buffer descriptor ring index
-    pAdapter->Rx_EnetPendingBDIdx        = 0;                                             
     pAdapter->Rx_NBLCounter              = 0;
     pAdapter->Rx_NdisOwnedBDsCount       = 0;                                             // No buffer is owned by NDIS
-    pAdapter->Rx_DmaBDT_DmaOwnedBDsCount = pAdapter->Rx_DmaBDT_ItemCount;                 // All Rx BDs are owned by ENET DMA
     NdisZeroMemory(&pAdapter->RcvStatus, sizeof(pAdapter->RcvStatus));
-    for (LONG Idx = 0; Idx < pAdapter->Rx_DmaBDT_ItemCount; ++Idx) {                      // For each DmaBD do:
-        MP_RX_FRAME_BD *pRxFrameBD = &pAdapter->Rx_FrameBDT[Idx];
-        pDmaBD = &pAdapter->Rx_DmaBDT[Idx];                                               // Get DmaBD address
-        pAdapter->Rx_DmaBDT_SwExt[Idx].pRxFrameBD = pRxFrameBD;                           // Create link between Rx frame descriptor and DmaBD
-        NET_BUFFER_LIST_NEXT_NBL(pRxFrameBD->pNBL) = NULL;                                // Not necessary consider removing
-        pDmaBD->BufferAddress = pRxFrameBD->BufferPa.LowPart;                             // Fill DmaBD data buffer address
-        pDmaBD->ControlStatus = ENET_RX_BD_E_MASK | ENET_RX_BD_L_MASK;                    // Fill DMaBD Status (Mark DmaBD as ready to receive data)
-        /* MS-temp */ NdisAdjustMdlLength(pRxFrameBD->pMdl, ENET_RX_FRAME_SIZE);
+    for (ULONG QueueIdx = 0; QueueIdx < pAdapter->QueueCount; QueueIdx++) {
+        PMP_RX_QUEUE pRxQueue = &pAdapter->Rx_Queue[QueueIdx];
+        PENET_BD     pDmaBD = NULL;
+
+        ASSERT(pRxQueue->DmaBDT_ItemCount);                                               // There must be at least one Rx buffer
+        pRxQueue->EnetFreeBDIdx           = 0;                                            // Initialize HW Dma buffer descriptor ring index
+        pRxQueue->EnetPendingBDIdx        = 0;
+        pRxQueue->DmaBDT_DmaOwnedBDsCount = pRxQueue->DmaBDT_ItemCount;                   // All Rx BDs are owned by ENET DMA
+        for (LONG Idx = 0; Idx < pRxQueue->DmaBDT_ItemCount; ++Idx) {                     // For each DmaBD do:
+            MP_RX_FRAME_BD *pRxFrameBD = &pRxQueue->FrameBDT[Idx];
+            pDmaBD = MP_RX_DMA_BD(pAdapter, pRxQueue, Idx);                               // Get DmaBD address
+            pRxFrameBD->pRxQueue = pRxQueue;                                              // A spare buffer may have been holding this ring slot
+            pRxQueue->DmaBDT_SwExt[Idx].pRxFrameBD = pRxFrameBD;                          // Create link between Rx frame descriptor and DmaBD
+            NET_BUFFER_LIST_NEXT_NBL(pRxFrameBD->pNBL) = NULL;                            // Not necessary consider removing
+            pDmaBD->BufferAddress = pRxFrameBD->BufferPa.LowPart;                         // Fill DmaBD data buffer address
+            if (pAdapter->EnhancedBDs) {
+                MP_ENHANCED_BD(pDmaBD)->ExtControlStatus = ENET_RX_EBD_INT_MASK;          // Generate interrupt when the frame is received
+                MP_ENHANCED_BD(pDmaBD)->BDU              = 0;
+            }
+            pDmaBD->ControlStatus = ENET_RX_BD_E_MASK | ENET_RX_BD_L_MASK;                // Fill DMaBD Status (Mark DmaBD as ready to receive data)
+            /* MS-temp */ NdisAdjustMdlLength(pRxFrameBD->pMdl, ENET_RX_FRAME_SIZE);
+        }
+        if (pDmaBD) {
+            pDmaBD->ControlStatus |= ENET_RX_BD_W_MASK;                                   // Mark last DmaBD
+        }
     }
-    if (pDmaBD) {
-        pDmaBD->ControlStatus |= ENET_RX_BD_W_MASK;                                       // Mark last DmaBD
+    InitializeListHead(&pAdapter->Rx_SpareFreeList);                                     // All spare buffers are free
+    for (LONG Idx = 0; Idx < pAdapter->Rx_SpareFrameBDT_ItemCount; ++Idx) {
+        /* MS-temp */ NdisAdjustMdlLength(pAdapter->Rx_SpareFrameBDT[Idx].pMdl, ENET_RX_FRAME_SIZE);
+        InsertTailList(&pAdapter->Rx_SpareFreeList, &pAdapter->Rx_SpareFrameBDT[Idx].Link);
+    }
+    InitializeListHead(&pAdapter->Rx_CopyFreeList);                                      // All copy break buffers are free
+    for (LONG Idx = 0; Idx < ENET_RX_COPY_BUFFER_COUNT; ++Idx) {
+        InsertTailList(&pAdapter->Rx_CopyFreeList, &pAdapter->Rx_CopyFrameBDT[Idx].Link);
     }
 }
 
@@ -814,55 +1088,73 @@ void MpReturnNetBufferLists(NDIS_HANDLE MiniportAdapterContext, PNET_BUFFER_LIST
     PMP_ADAPTER       pAdapter = (PMP_ADAPTER)MiniportAdapterContext;
     PNET_BUFFER_LIST  pNextNBL;
     PMP_RX_FRAME_BD   pRxFrameBD;
+    PMP_RX_QUEUE      pRxQueue;
     PENET_BD          pCurrentDmaBD;
-    PENET_BD          pFirstDmaBD = NULL;
-    USHORT            CurrentControlStatus, FirtsControlStatus = 0;
+    PENET_BD          pFirstDmaBD[ENET_QUEUE_COUNT_MAX] = { NULL };             // The first returned Dma BD of each ring
+    USHORT            CurrentControlStatus, FirtsControlStatus[ENET_QUEUE_COUNT_MAX] = { 0 };
     LONG              Rx_EnetFreeBDIdx;
 
     UNREFERENCED_PARAMETER(ReturnFlags);
     DBG_ENET_DEV_RX_METHOD_BEG();
     NdisAcquireSpinLock(&pAdapter->Rx_SpinLock);
-    Rx_EnetFreeBDIdx = pAdapter->Rx_EnetFreeBDIdx;
     // Mark all returned frames as active, so adapter DMA can use them for future RX frames.
     ASSERT(pNBL);
     for (PNET_BUFFER_LIST pCurrentNBL = pNBL; pCurrentNBL != NULL; pCurrentNBL = pNextNBL) {
         pNextNBL = NET_BUFFER_LIST_NEXT_NBL(pCurrentNBL);
         pRxFrameBD = MP_NBL_RX_FRAME_BD(pCurrentNBL);                               // Get Frame BD address from the current NBL.
-        /* MS-temp */ NdisAdjustMdlLength(pRxFrameBD->pMdl, ENET_RX_FRAME_SIZE);
-        pAdapter->Rx_DmaBDT_DmaOwnedBDsCount++;                                     // Increment counter of Rx BDs owned by ENET DMA.
         pAdapter->Rx_NdisOwnedBDsCount--;
+        if (pRxFrameBD->IsCopyBuffer) {                                             // Small copy break buffer?
+            InsertTailList(&pAdapter->Rx_CopyFreeList, &pRxFrameBD->Link);          // Yes, return it to the copy break pool
+            continue;
+        }
+        pRxQueue = pRxFrameBD->pRxQueue;                                            // The frame buffer is returned to its own ring
+        /* MS-temp */ NdisAdjustMdlLength(pRxFrameBD->pMdl, ENET_RX_FRAME_SIZE);
         if (!pAdapter->EnetStarted) {
             continue;
         }
-        ASSERT(!pAdapter->Rx_DmaBDT_SwExt[Rx_EnetFreeBDIdx].pRxFrameBD);
+        if (pRxQueue->DmaBDT_DmaOwnedBDsCount == pRxQueue->DmaBDT_ItemCount) {      // Ring slot already refilled by a spare buffer?
+            InsertTailList(&pAdapter->Rx_SpareFreeList, &pRxFrameBD->Link);         // Yes, the buffer becomes a spare one
+            continue;
+        }
+        pRxQueue->DmaBDT_DmaOwnedBDsCount++;                                        // Increment counter of Rx BDs owned by ENET DMA.
+        Rx_EnetFreeBDIdx = pRxQueue->EnetFreeBDIdx;
+        ASSERT(!pRxQueue->DmaBDT_SwExt[Rx_EnetFreeBDIdx].pRxFrameBD);
         /* Reuse frame descriptor */
-        pAdapter->Rx_DmaBDT_SwExt[Rx_EnetFreeBDIdx].pRxFrameBD = pRxFrameBD;    // Association current Frame BD and the first free Dma BD
-        DBG_ENET_DEV_RX_PRINT_TRACE("NBL(%4d, 0x%08X) returned,       DmaIdx: %4d, NewDmaIdx: %4d DmaBD ready: %4d, PhyAddr: 0x%08X", MP_NBL_ID(pCurrentNBL), pCurrentNBL, MP_NB_DmaIdx(pCurrentNBL->FirstNetBuffer), Rx_EnetFreeBDIdx, pAdapter->Rx_DmaBDT_DmaOwnedBDsCount, pRxFrameBD->BufferPa.LowPart);
-        pCurrentDmaBD                = &pAdapter->Rx_DmaBDT[Rx_EnetFreeBDIdx];  // Get address of the first free Dma BD
+        pRxQueue->DmaBDT_SwExt[Rx_EnetFreeBDIdx].pRxFrameBD = pRxFrameBD;       // Association current Frame BD and the first free Dma BD
+        DBG_ENET_DEV_RX_PRINT_TRACE("NBL(%4d, 0x%08X) returned,       Ring: %d, DmaIdx: %4d, NewDmaIdx: %4d DmaBD ready: %4d, PhyAddr: 0x%08X", MP_NBL_ID(pCurrentNBL), pCurrentNBL, pRxQueue->QueueIdx, MP_NB_DmaIdx(pCurrentNBL->FirstNetBuffer), Rx_EnetFreeBDIdx, pRxQueue->DmaBDT_DmaOwnedBDsCount, pRxFrameBD->BufferPa.LowPart);
+        pCurrentDmaBD                = MP_RX_DMA_BD(pAdapter, pRxQueue, Rx_EnetFreeBDIdx);  // Get address of the first free Dma BD
         pCurrentDmaBD->BufferAddress = pRxFrameBD->BufferPa.LowPart;            // Fill Dma BD data buffer address
+        if (pAdapter->EnhancedBDs) {
+            MP_ENHANCED_BD(pCurrentDmaBD)->ExtControlStatus = ENET_RX_EBD_INT_MASK;  // Generate interrupt when the frame is received
+            MP_ENHANCED_BD(pCurrentDmaBD)->BDU              = 0;
+        }
         CurrentControlStatus = ENET_RX_BD_E_MASK;                               // Set EMPTY bit
         CurrentControlStatus |= ENET_RX_BD_L_MASK;                              // Set LAST bit
-        if (++Rx_EnetFreeBDIdx == pAdapter->Rx_DmaBDT_ItemCount) {              // Compute next Rx_EnetFreeBDIdx
+        if (++Rx_EnetFreeBDIdx == pRxQueue->DmaBDT_ItemCount) {                 // Compute next Rx_EnetFreeBDIdx
             Rx_EnetFreeBDIdx = 0;
             CurrentControlStatus |= ENET_RX_BD_W_MASK;                          // Set WRAP bit in the last Dma BD
         }
-        if (pFirstDmaBD == NULL) {                                              // For the first returned BD do not set Dma BD control and status word now, do it as the last step
-            pFirstDmaBD = pCurrentDmaBD;                                        // Remember the first free Dma BD address
-            FirtsControlStatus = CurrentControlStatus;                          // Remember Dma BD control and status word for the first free Dma BD
+        pRxQueue->EnetFreeBDIdx = Rx_EnetFreeBDIdx;                             // Update EnetFreeBDIdx
+        if (pFirstDmaBD[pRxQueue->QueueIdx] == NULL) {                          // For the first returned BD do not set Dma BD control and status word now, do it as the last step
+            pFirstDmaBD[pRxQueue->QueueIdx] = pCurrentDmaBD;                    // Remember the first free Dma BD address
+            FirtsControlStatus[pRxQueue->QueueIdx] = CurrentControlStatus;      // Remember Dma BD control and status word for the first free Dma BD
         } else {
             pCurrentDmaBD->ControlStatus = CurrentControlStatus;                // Fill Dma BD control and status word
         }
     } // More free buffers
-    pAdapter->Rx_EnetFreeBDIdx = Rx_EnetFreeBDIdx;                              // Update Rx_EnetFreeBDIdx
-    if (pFirstDmaBD != NULL) {
-        pFirstDmaBD->ControlStatus = FirtsControlStatus;                        // Mark first Dma BD as empty = ready to receive data
+    for (ULONG QueueIdx = 0; QueueIdx < pAdapter->QueueCount; QueueIdx++) {
+        if (pFirstDmaBD[QueueIdx] == NULL) {
+            continue;
+        }
+        pRxQueue = &pAdapter->Rx_Queue[QueueIdx];
+        pFirstDmaBD[QueueIdx]->ControlStatus = FirtsControlStatus[QueueIdx];    // Mark first Dma BD as empty = ready to receive data
         _DataSynchronizationBarrier();                                          // Wait until write is finished
-        FirtsControlStatus = pFirstDmaBD->ControlStatus;                        // Read ControlStatus back
-        DBG_ENET_DEV_RX_PRINT_TRACE("NBL(%4d): Added to ENET_BD.",MP_NBL_ID(pNBL));
-        if (pAdapter->ENETRegBase->RDAR == 0) {                                 // Receive in progress?
-            if (pFirstDmaBD->ControlStatus & ENET_RX_BD_E_MASK) {               // No, Transfer not started yet?
-                DBG_ENET_DEV_RX_PRINT_TRACE("NBL(%4d): Starting transfer. TDAR: 0x%08X, EIR: 0x%08X", MP_NBL_ID(pNBL), pAdapter->ENETRegBase->RDAR, pAdapter->ENETRegBase->EIR.U);
-                pAdapter->ENETRegBase->RDAR = 0x00000000;                       // No, start transfer
+        FirtsControlStatus[QueueIdx] = pFirstDmaBD[QueueIdx]->ControlStatus;    // Read ControlStatus back
+        DBG_ENET_DEV_RX_PRINT_TRACE("NBL(%4d): Added to ENET_BD of ring %d.", MP_NBL_ID(pNBL), QueueIdx);
+        if (*pRxQueue->pRDAR == 0) {                                            // Receive in progress?
+            if (pFirstDmaBD[QueueIdx]->ControlStatus & ENET_RX_BD_E_MASK) {     // No, Transfer not started yet?
+                DBG_ENET_DEV_RX_PRINT_TRACE("NBL(%4d): Starting transfer. RDAR: 0x%08X, EIR: 0x%08X", MP_NBL_ID(pNBL), *pRxQueue->pRDAR, pAdapter->ENETRegBase->EIR.U);
+                *pRxQueue->pRDAR = 0x00000000;                                  // No, start transfer
             }
         }
     }
@@ -870,10 +1162,113 @@ void MpReturnNetBufferLists(NDIS_HANDLE MiniportAdapterContext, PNET_BUFFER_LIST
     DBG_ENET_DEV_RX_METHOD_END();
 }
 
+/*++
+Routine Description:
+    Builds the receive checksum information of a frame from the enhanced ENET_RxBD.
+    ENET validates IPv4 header checksum and TCP/UDP checksum of not fragmented IPv4/IPv6 frames.
+Arguments:
+    pAdapter    Pointer to the adapter structure
+    pDmaBD      Address of the ENET_RxBD of the frame
+    pFrame      Address of the received frame data
+Return Value:
+    NDIS_TCP_IP_CHECKSUM_NET_BUFFER_LIST_INFO value, NULL if no checksum was validated
+--*/
+static PVOID MpRxGetChecksumInfo(_In_ PMP_ADAPTER pAdapter, _In_ PENET_BD pDmaBD, _In_ PUCHAR pFrame)
+{
+    NDIS_TCP_IP_CHECKSUM_NET_BUFFER_LIST_INFO ChecksumInfo;
+    ULONG       ExtControlStatus;
+    ULONG       TypeOffset = ETHER_FRAME_TYPE_OFFSET;
+    USHORT      EtherType;
+    UCHAR       Protocol;
+    BOOLEAN     IsIPv6;
+
+    ChecksumInfo.Value = NULL;
+    if (!pAdapter->EnhancedBDs) {
+        return ChecksumInfo.Value;
+    }
+    ExtControlStatus = MP_ENHANCED_BD(pDmaBD)->ExtControlStatus;
+    Protocol         = (UCHAR)(MP_ENHANCED_BD(pDmaBD)->ProtocolInfo & ENET_RX_EBD_PROT_TYPE_MASK);
+    EtherType        = (USHORT)((pFrame[TypeOffset] << 8) | pFrame[TypeOffset + 1]);
+    if (EtherType == ETHER_TYPE_VLAN) {
+        TypeOffset += ETHER_VLAN_TAG_LENGTH;
+        EtherType = (USHORT)((pFrame[TypeOffset] << 8) | pFrame[TypeOffset + 1]);
+    }
+    if ((EtherType != ETHER_TYPE_IPV4) && (EtherType != ETHER_TYPE_IPV6)) {
+        return ChecksumInfo.Value;                                         // Not an IP frame, nothing was validated
+    }
+    IsIPv6 = (ExtControlStatus & ENET_RX_EBD_IPV6_MASK) != 0;
+    if (!IsIPv6 && (pAdapter->IPChecksumOffloadIPv4 & MP_CHECKSUM_OFFLOAD_RX)) {
+        if (ExtControlStatus & ENET_RX_EBD_ICE_MASK) {
+            ChecksumInfo.Receive.IpChecksumFailed = 1;
+            pAdapter->RcvStatus.FrameRcvIpChecksumErrors++;
+        } else {
+            ChecksumInfo.Receive.IpChecksumSucceeded = 1;
+        }
+    }
+    if (ExtControlStatus & ENET_RX_EBD_FRAG_MASK) {
+        return ChecksumInfo.Value;                                         // Protocol checksum is not validated for fragments
+    }
+    if ((Protocol == IP_PROTOCOL_TCP) && ((IsIPv6 ? pAdapter->TCPChecksumOffloadIPv6 : pAdapter->TCPChecksumOffloadIPv4) & MP_CHECKSUM_OFFLOAD_RX)) {
+        if (ExtControlStatus & ENET_RX_EBD_PCR_MASK) {
+            ChecksumInfo.Receive.TcpChecksumFailed = 1;
+            pAdapter->RcvStatus.FrameRcvProtocolChecksumErrors++;
+        } else {
+            ChecksumInfo.Receive.TcpChecksumSucceeded = 1;
+        }
+    } else if ((Protocol == IP_PROTOCOL_UDP) && ((IsIPv6 ? pAdapter->UDPChecksumOffloadIPv6 : pAdapter->UDPChecksumOffloadIPv4) & MP_CHECKSUM_OFFLOAD_RX)) {
+        if (ExtControlStatus & ENET_RX_EBD_PCR_MASK) {
+            ChecksumInfo.Receive.UdpChecksumFailed = 1;
+            pAdapter->RcvStatus.FrameRcvProtocolChecksumErrors++;
+        } else {
+            ChecksumInfo.Receive.UdpChecksumSucceeded = 1;
+        }
+    }
+    return ChecksumInfo.Value;
+}
+
+/*++
+Routine Description:
+    Gives a frame buffer to the first free ENET_RxBD of the ring, the ENET_RxBD is marked as empty (ready to receive data).
+    Assumption: Receive spin lock has been acquired
+Arguments:
+    pAdapter    Pointer to the adapter structure
+    pRxQueue    ENET Rx ring
+    pRxFrameBD  ENET_RX_FRAME_SIZE frame buffer
+Return Value:
+    None
+--*/
+static void MpRxRepostFrameBD(_In_ PMP_ADAPTER pAdapter, _Inout_ PMP_RX_QUEUE pRxQueue, _Inout_ PMP_RX_FRAME_BD pRxFrameBD)
+{
+    LONG     Rx_EnetFreeBDIdx = pRxQueue->EnetFreeBDIdx;
+    PENET_BD pDmaBD           = MP_RX_DMA_BD(pAdapter, pRxQueue, Rx_EnetFreeBDIdx);
+    USHORT   ControlStatus    = ENET_RX_BD_E_MASK | ENET_RX_BD_L_MASK;
+
+    ASSERT(!pRxFrameBD->IsCopyBuffer);
+    ASSERT(!pRxQueue->DmaBDT_SwExt[Rx_EnetFreeBDIdx].pRxFrameBD);
+    pRxFrameBD->pRxQueue = pRxQueue;
+    /* MS-temp */ NdisAdjustMdlLength(pRxFrameBD->pMdl, ENET_RX_FRAME_SIZE);
+    pRxQueue->DmaBDT_SwExt[Rx_EnetFreeBDIdx].pRxFrameBD = pRxFrameBD;         // Association Frame BD and the first free Dma BD
+    pDmaBD->BufferAddress = pRxFrameBD->BufferPa.LowPart;                     // Fill Dma BD data buffer address
+    if (pAdapter->EnhancedBDs) {
+        MP_ENHANCED_BD(pDmaBD)->ExtControlStatus = ENET_RX_EBD_INT_MASK;      // Generate interrupt when the frame is received
+        MP_ENHANCED_BD(pDmaBD)->BDU              = 0;
+    }
+    if (++Rx_EnetFreeBDIdx == pRxQueue->DmaBDT_ItemCount) {                   // Compute next Rx_EnetFreeBDIdx
+        Rx_EnetFreeBDIdx = 0;
+        ControlStatus |= ENET_RX_BD_W_MASK;                                   // Set WRAP bit in the last Dma BD
+    }
+    pRxQueue->EnetFreeBDIdx = Rx_EnetFreeBDIdx;
+    pRxQueue->DmaBDT_DmaOwnedBDsCount++;                                      // Increment counter of Rx BDs owned by ENET DMA
+    _DataSynchronizationBarrier();                                            // Buffer address must be written before the BD is given to ENET DMA
+    pDmaBD->ControlStatus = ControlStatus;                                    // Mark Dma BD as empty = ready to receive data
+}
+
 /*++
 Routine Description:
     Interrupt handler for receive processing. Put the received packets into an array and call
     NdisMIndicateReceivePacket. If we run low on RFDs, allocate another one
+    Frames up to ENET_RX_COPY_BREAK_LENGTH bytes are copied to a small buffer and the ENET_RxBD buffer is reposted immediately,
+    longer frames are indicated in the ENET_RxBD buffer and a spare buffer (if any) takes its place in the ring.
     Assumption: Receive spin lock has been acquired
 Arguments:
     pAdapter
@@ -899,6 +1294,11 @@ void MpHandleRecvInterrupt(PMP_ADAPTER pAdapter, PULONG pMaxNBLsToIndicate, PNDI
     PNET_BUFFER_LIST pSyncNBLTail      = NULL;
     ULONG            SyncNBLItemCount = 0;
     LONG             Rx_EnetPendingBDIdx;
+    BOOLEAN          BDsReposted;
+    PVOID            ChecksumInfo;
+    #if NDIS_SUPPORT_NDIS682
+    NET_BUFFER_LIST_TIMESTAMP NblTimestamp;
+    #endif
 
     DBG_ENET_DEV_DPC_RX_METHOD_BEG();
     NdisDprAcquireSpinLock(&pAdapter->Rx_SpinLock);
@@ -907,88 +1307,129 @@ void MpHandleRecvInterrupt(PMP_ADAPTER pAdapter, PULONG pMaxNBLsToIndicate, PNDI
        DBG_ENET_DEV_DPC_RX_METHOD_END();
        return;
     }
-    Rx_EnetPendingBDIdx = pAdapter->Rx_EnetPendingBDIdx;
-    for (LONG Idx = 0; Idx < pAdapter->Rx_DmaBDT_ItemCount; ++Idx) {          // One call of MpHandleRecvInterrupt() will indicate up to pAdapter->Rx_DmaBDT_ItemCount NBLs
-        PENET_BD pDmaBD = &pAdapter->Rx_DmaBDT[Rx_EnetPendingBDIdx];          // Get address of the first not checked BD
-        if (pDmaBD->ControlStatus & ENET_RX_BD_E_MASK) {                      // No data received or reception in progress?
-            break;                                                            // Stop BD checking
-        }
-        if (pAdapter->Rx_DmaBDT_DmaOwnedBDsCount == 0) {                      // All NBL has been already indicated to NDIS, next packet will be lost
-            break;
-        }
-        if ((*pMaxNBLsToIndicate) == 0) {                                     // Did we reach the max number of RX frames we are allowed to indicate to NDIS?
-            DBG_ENET_DEV_PRINT_WARNING("NDIS RX frame throttle applied %d RX frames will be indicated", AsyncNBLItemCount + SyncNBLItemCount);
-            pRecvThrottleParameters->MoreNblsPending = TRUE;                  // No, inform NDIS about it
-            break;
-        }
-        pAdapter->Rx_DmaBDT_DmaOwnedBDsCount--;                                                    // Decrement counter of Rx BDs owned by ENET DMA
-        PMP_RX_FRAME_BD pRxFrameBD = pAdapter->Rx_DmaBDT_SwExt[Rx_EnetPendingBDIdx].pRxFrameBD;    // Get frame descriptor
-        ASSERT(pRxFrameBD != NULL);
-        pAdapter->Rx_DmaBDT_SwExt[Rx_EnetPendingBDIdx].pRxFrameBD = NULL;                          // Disconnect Rx Frame BD from ENET DMA BD
-        PNET_BUFFER_LIST  pCurrentNBL     = pRxFrameBD->pNBL;                                      // Get NBL
-        ULONG             realFrameLength = (ULONG)pDmaBD->DataLen - ETHER_FRAME_CRC_LENGTH - 2;   // Compute real data length
-        #if DBG
-        MP_NBL_SET_ID(pCurrentNBL, NdisInterlockedIncrement(&pAdapter->Rx_NBLCounter) - 1);        // for debug only
-        MP_NB_SET_DmaIdx(pCurrentNBL->FirstNetBuffer, Rx_EnetPendingBDIdx);                        // for debug only
-        #endif
-        NET_BUFFER_DATA_LENGTH(pCurrentNBL->FirstNetBuffer) = realFrameLength;                     // Save real data length
-        // Is this packet completed and has error bits set?
-        if (pDmaBD->ControlStatus & (ENET_RX_BD_TR_MASK | ENET_RX_BD_OV_MASK | ENET_RX_BD_NO_MASK | ENET_RX_BD_CR_MASK)) {
-            /* MS-temp */ NdisAdjustMdlLength(pRxFrameBD->pMdl, ENET_RX_FRAME_SIZE);
-            NET_BUFFER_LIST_NEXT_NBL(pCurrentNBL) = pErrorNBLHead;        // Append this NBL to the had of the error NBL list
-            pErrorNBLHead = pCurrentNBL;
-            pAdapter->RcvStatus.FrameRcvErrors++;
-            ErrorNBLItemCount++;
-            if (pDmaBD->ControlStatus & ENET_RX_BD_TR_MASK) {             // Truncated frame?
-                DBG_ENET_DEV_PRINT_ERROR(" NBL(%4d) data received, DmaIdx: %4d, DmaOwnedBDs: %4d:, !!! ERROR Truncated frame !!!, status: 0x%08X, Size: %4d, PhyAddr: 0x%08X", MP_NBL_ID(pCurrentNBL), Rx_EnetPendingBDIdx, pAdapter->Rx_DmaBDT_DmaOwnedBDsCount, pDmaBD->ControlStatus, realFrameLength, pRxFrameBD->BufferPa.LowPart);
-                pAdapter->RcvStatus.FrameRcvLCErrors++;
-            } else if (pDmaBD->ControlStatus & ENET_RX_BD_OV_MASK) {      // Receive FIFO overrun?
-                DBG_ENET_DEV_PRINT_ERROR(" NBL(%4d) data received, DmaIdx: %4d, DmaOwnedBDs: %4d:, !!! ERROR Receive FIFO overrun !!!, status: 0x%08X, Size: %4d, PhyAddr: 0x%08X", MP_NBL_ID(pCurrentNBL), Rx_EnetPendingBDIdx, pAdapter->Rx_DmaBDT_DmaOwnedBDsCount, pDmaBD->ControlStatus, realFrameLength, pRxFrameBD->BufferPa.LowPart);
-                pAdapter->RcvStatus.FrameRcvOverrunErrors++;
-            } else if (pDmaBD->ControlStatus & ENET_RX_BD_NO_MASK) {      // No-octet aligned frame
-                DBG_ENET_DEV_PRINT_ERROR(" NBL(%4d) data received, DmaIdx: %4d, DmaOwnedBDs: %4d:, !!! ERROR No-octet aligned frame !!!, status: 0x%08X, Size: %4d, PhyAddr: 0x%08X", MP_NBL_ID(pCurrentNBL), Rx_EnetPendingBDIdx, pAdapter->Rx_DmaBDT_DmaOwnedBDsCount, pDmaBD->ControlStatus,realFrameLength,  pRxFrameBD->BufferPa.LowPart);
-                pAdapter->RcvStatus.FrameRcvAllignmentErrors++;
-            } else if (pDmaBD->ControlStatus & ENET_RX_BD_CR_MASK) {      // CRC error?
-                DBG_ENET_DEV_PRINT_ERROR(" NBL(%4d) data received, DmaIdx: %4d, DmaOwnedBDs: %4d:, !!! ERROR CRC !!!, status: 0x%08X, Size: %4d, PhyAddr: 0x%08X", MP_NBL_ID(pCurrentNBL), Rx_EnetPendingBDIdx, pAdapter->Rx_DmaBDT_DmaOwnedBDsCount, pDmaBD->ControlStatus, realFrameLength, pRxFrameBD->BufferPa.LowPart);
-                pAdapter->RcvStatus.FrameRcvCRCErrors++;
-            } else {                                                      // Too long frame
-                DBG_ENET_DEV_PRINT_ERROR(" NBL(%4d) data received, DmaIdx: %4d, DmaOwnedBDs: %4d:, !!! ERROR Frame too long !!!, status: 0x%08X, Size: %4d, PhyAddr: 0x%08X", MP_NBL_ID(pCurrentNBL), Rx_EnetPendingBDIdx, pAdapter->Rx_DmaBDT_DmaOwnedBDsCount, pDmaBD->ControlStatus, realFrameLength, pRxFrameBD->BufferPa.LowPart);
-                pAdapter->RcvStatus.FrameRcvExtraDataErrors++;
+    for (ULONG QueueIdx = pAdapter->QueueCount; QueueIdx-- > 0;) {          // AVB class rings are drained first
+        PMP_RX_QUEUE pRxQueue = &pAdapter->Rx_Queue[QueueIdx];
+        Rx_EnetPendingBDIdx = pRxQueue->EnetPendingBDIdx;
+        BDsReposted = FALSE;
+        for (LONG Idx = 0; Idx < pRxQueue->DmaBDT_ItemCount; ++Idx) {          // One call of MpHandleRecvInterrupt() will indicate up to DmaBDT_ItemCount NBLs of each ring
+            PENET_BD pDmaBD = MP_RX_DMA_BD(pAdapter, pRxQueue, Rx_EnetPendingBDIdx);        // Get address of the first not checked BD
+            if (pDmaBD->ControlStatus & ENET_RX_BD_E_MASK) {                      // No data received or reception in progress?
+                break;                                                            // Stop BD checking
             }
-        } else {
-            (*pMaxNBLsToIndicate)--;                                                   // Decrement MaxNBLsToIndicate counter
-            NdisFlushBuffer(pRxFrameBD->pMdl, FALSE);                                  // Flush Rx buffer
-            /* MS-temp */NdisAdjustMdlLength(pRxFrameBD->pMdl, realFrameLength + 2);   // Update real length in MDL
-            DBG_ENET_DEV_RX_PRINT_TRACE(" NBL(%4d) data received, DmaIdx: %4d, DmaOwnedBDs: %4d:, Size: %d, PhyAddr: 0x%08X", MP_NBL_ID(pCurrentNBL), Rx_EnetPendingBDIdx, pAdapter->Rx_DmaBDT_DmaOwnedBDsCount, realFrameLength, pRxFrameBD->BufferPa.LowPart);
-            // Decide how we are going to indicate the RX buffer to NDIS. If we are running low on RX buffers, we will do in synchronously, otherwise we do it asynchronously.
-            if (pAdapter->Rx_DmaBDT_DmaOwnedBDsCount <= pAdapter->Rx_DmaBDT_DmaOwnedBDsLowWatterMark) {
-                ppNBLTail = &pSyncNBLTail;                            // Low RX buffers level, use synchronous RX buffer indication
-                if (pSyncNBLTail == NULL) {                           // Synchronous NBL list empty?
-                    pSyncNBLHead = pCurrentNBL;                       // Current NBL is the first item of the Synchronous NBL list
+            if (pRxQueue->DmaBDT_DmaOwnedBDsCount == 0) {                      // All NBL has been already indicated to NDIS, next packet will be lost
+                break;
+            }
+            if ((*pMaxNBLsToIndicate) == 0) {                                     // Did we reach the max number of RX frames we are allowed to indicate to NDIS?
+                DBG_ENET_DEV_PRINT_WARNING("NDIS RX frame throttle applied %d RX frames will be indicated", AsyncNBLItemCount + SyncNBLItemCount);
+                pRecvThrottleParameters->MoreNblsPending = TRUE;                  // No, inform NDIS about it
+                break;
+            }
+            pRxQueue->DmaBDT_DmaOwnedBDsCount--;                                                    // Decrement counter of Rx BDs owned by ENET DMA
+            PMP_RX_FRAME_BD pRxFrameBD = pRxQueue->DmaBDT_SwExt[Rx_EnetPendingBDIdx].pRxFrameBD;    // Get frame descriptor
+            ASSERT(pRxFrameBD != NULL);
+            pRxQueue->DmaBDT_SwExt[Rx_EnetPendingBDIdx].pRxFrameBD = NULL;                          // Disconnect Rx Frame BD from ENET DMA BD
+            PNET_BUFFER_LIST  pCurrentNBL     = pRxFrameBD->pNBL;                                      // Get NBL (may be replaced by a copy break NBL)
+            ULONG             realFrameLength = (ULONG)pDmaBD->DataLen - ETHER_FRAME_CRC_LENGTH - 2;   // Compute real data length
+            #if DBG
+            MP_NBL_SET_ID(pCurrentNBL, NdisInterlockedIncrement(&pAdapter->Rx_NBLCounter) - 1);        // for debug only
+            MP_NB_SET_DmaIdx(pCurrentNBL->FirstNetBuffer, Rx_EnetPendingBDIdx);                        // for debug only
+            #endif
+            NET_BUFFER_DATA_LENGTH(pCurrentNBL->FirstNetBuffer) = realFrameLength;                     // Save real data length
+            // Is this packet completed and has error bits set?
+            if (pDmaBD->ControlStatus & (ENET_RX_BD_TR_MASK | ENET_RX_BD_OV_MASK | ENET_RX_BD_NO_MASK | ENET_RX_BD_CR_MASK)) {
+                /* MS-temp */ NdisAdjustMdlLength(pRxFrameBD->pMdl, ENET_RX_FRAME_SIZE);
+                NET_BUFFER_LIST_NEXT_NBL(pCurrentNBL) = pErrorNBLHead;        // Append this NBL to the had of the error NBL list
+                pErrorNBLHead = pCurrentNBL;
+                pAdapter->RcvStatus.FrameRcvErrors++;
+                ErrorNBLItemCount++;
+                if (pDmaBD->ControlStatus & ENET_RX_BD_TR_MASK) {             // Truncated frame?
+                    DBG_ENET_DEV_PRINT_ERROR(" NBL(%4d) data received, DmaIdx: %4d, DmaOwnedBDs: %4d:, !!! ERROR Truncated frame !!!, status: 0x%08X, Size: %4d, PhyAddr: 0x%08X", MP_NBL_ID(pCurrentNBL), Rx_EnetPendingBDIdx, pRxQueue->DmaBDT_DmaOwnedBDsCount, pDmaBD->ControlStatus, realFrameLength, pRxFrameBD->BufferPa.LowPart);
+                    pAdapter->RcvStatus.FrameRcvLCErrors++;
+                } else if (pDmaBD->ControlStatus & ENET_RX_BD_OV_MASK) {      // Receive FIFO overrun?
+                    DBG_ENET_DEV_PRINT_ERROR(" NBL(%4d) data received, DmaIdx: %4d, DmaOwnedBDs: %4d:, !!! ERROR Receive FIFO overrun !!!, status: 0x%08X, Size: %4d, PhyAddr: 0x%08X", MP_NBL_ID(pCurrentNBL), Rx_EnetPendingBDIdx, pRxQueue->DmaBDT_DmaOwnedBDsCount, pDmaBD->ControlStatus, realFrameLength, pRxFrameBD->BufferPa.LowPart);
+                    pAdapter->RcvStatus.FrameRcvOverrunErrors++;
+                } else if (pDmaBD->ControlStatus & ENET_RX_BD_NO_MASK) {      // No-octet aligned frame
+                    DBG_ENET_DEV_PRINT_ERROR(" NBL(%4d) data received, DmaIdx: %4d, DmaOwnedBDs: %4d:, !!! ERROR No-octet aligned frame !!!, status: 0x%08X, Size: %4d, PhyAddr: 0x%08X", MP_NBL_ID(pCurrentNBL), Rx_EnetPendingBDIdx, pRxQueue->DmaBDT_DmaOwnedBDsCount, pDmaBD->ControlStatus,realFrameLength,  pRxFrameBD->BufferPa.LowPart);
+                    pAdapter->RcvStatus.FrameRcvAllignmentErrors++;
+                } else if (pDmaBD->ControlStatus & ENET_RX_BD_CR_MASK) {      // CRC error?
+                    DBG_ENET_DEV_PRINT_ERROR(" NBL(%4d) data received, DmaIdx: %4d, DmaOwnedBDs: %4d:, !!! ERROR CRC !!!, status: 0x%08X, Size: %4d, PhyAddr: 0x%08X", MP_NBL_ID(pCurrentNBL), Rx_EnetPendingBDIdx, pRxQueue->DmaBDT_DmaOwnedBDsCount, pDmaBD->ControlStatus, realFrameLength, pRxFrameBD->BufferPa.LowPart);
+                    pAdapter->RcvStatus.FrameRcvCRCErrors++;
+                } else {                                                      // Too long frame
+                    DBG_ENET_DEV_PRINT_ERROR(" NBL(%4d) data received, DmaIdx: %4d, DmaOwnedBDs: %4d:, !!! ERROR Frame too long !!!, status: 0x%08X, Size: %4d, PhyAddr: 0x%08X", MP_NBL_ID(pCurrentNBL), Rx_EnetPendingBDIdx, pRxQueue->DmaBDT_DmaOwnedBDsCount, pDmaBD->ControlStatus, realFrameLength, pRxFrameBD->BufferPa.LowPart);
+                    pAdapter->RcvStatus.FrameRcvExtraDataErrors++;
                 }
-                SyncNBLItemCount++;                                   // Increment SyncNBLItemCount
-                DBG_ENET_DEV_RX_PRINT_TRACE(" NBL(%4d, 0x%08X) indicate  SYNC, DmaIdx: %4d, Size: %d", MP_NBL_ID(pCurrentNBL), pCurrentNBL, MP_NB_DmaIdx(pCurrentNBL->FirstNetBuffer), NET_BUFFER_DATA_LENGTH(pCurrentNBL->FirstNetBuffer));
             } else {
-                ppNBLTail = &pAsyncNBLTail;                           // Normal RX buffers, use asynchronous RX buffer indication
-                if (pAsyncNBLTail == NULL) {                          // Asynchronous NBL list empty?
-                    pAsyncNBLHead = pCurrentNBL;                      // Current NBL is the first item of the Asynchronous NBL list
+                (*pMaxNBLsToIndicate)--;                                                   // Decrement MaxNBLsToIndicate counter
+                NdisFlushBuffer(pRxFrameBD->pMdl, FALSE);                                  // Flush Rx buffer
+                ChecksumInfo = MpRxGetChecksumInfo(pAdapter, pDmaBD, pRxFrameBD->pBuffer + 2);  // Must be read before the Dma BD is reposted
+                #if NDIS_SUPPORT_NDIS682
+                if (pAdapter->Ptp.Enabled) {
+                    NblTimestamp.Timestamp = MpPtpTimestampToTime(pAdapter, MP_ENHANCED_BD(pDmaBD)->TimeStamp);  // Must be read before the Dma BD is reposted
+                }
+                #endif
+                if ((realFrameLength <= ENET_RX_COPY_BREAK_LENGTH) && !IsListEmpty(&pAdapter->Rx_CopyFreeList)) {
+                    PMP_RX_FRAME_BD pCopyFrameBD = CONTAINING_RECORD(RemoveHeadList(&pAdapter->Rx_CopyFreeList), MP_RX_FRAME_BD, Link);
+                    NdisMoveMemory(pCopyFrameBD->pBuffer + 2, pRxFrameBD->pBuffer + 2, realFrameLength);  // Copy the frame (keep the IP header alignment)
+                    MpRxRepostFrameBD(pAdapter, pRxQueue, pRxFrameBD);                     // ENET DMA buffer is reused immediately
+                    #if DBG
+                    MP_NBL_SET_ID(pCopyFrameBD->pNBL, MP_NBL_ID(pCurrentNBL));             // for debug only
+                    MP_NB_SET_DmaIdx(pCopyFrameBD->pNBL->FirstNetBuffer, Rx_EnetPendingBDIdx);  // for debug only
+                    #endif
+                    pRxFrameBD  = pCopyFrameBD;
+                    pCurrentNBL = pCopyFrameBD->pNBL;
+                    NET_BUFFER_DATA_LENGTH(pCurrentNBL->FirstNetBuffer) = realFrameLength;
+                    pAdapter->RcvStatus.FrameRcvCopied++;
+                    BDsReposted = TRUE;
+                } else if (!IsListEmpty(&pAdapter->Rx_SpareFreeList)) {
+                    MpRxRepostFrameBD(pAdapter, pRxQueue, CONTAINING_RECORD(RemoveHeadList(&pAdapter->Rx_SpareFreeList), MP_RX_FRAME_BD, Link));  // Spare buffer takes place of the indicated one
+                    pAdapter->RcvStatus.FrameRcvSpareBufferUsed++;
+                    BDsReposted = TRUE;
+                }
+                /* MS-temp */NdisAdjustMdlLength(pRxFrameBD->pMdl, realFrameLength + 2);   // Update real length in MDL
+                DBG_ENET_DEV_RX_PRINT_TRACE(" NBL(%4d) data received, DmaIdx: %4d, DmaOwnedBDs: %4d:, Size: %d, PhyAddr: 0x%08X", MP_NBL_ID(pCurrentNBL), Rx_EnetPendingBDIdx, pRxQueue->DmaBDT_DmaOwnedBDsCount, realFrameLength, pRxFrameBD->BufferPa.LowPart);
+                // Decide how we are going to indicate the RX buffer to NDIS. If we are running low on RX buffers, we will do in synchronously, otherwise we do it asynchronously.
+                if (pRxQueue->DmaBDT_DmaOwnedBDsCount <= pRxQueue->DmaBDT_DmaOwnedBDsLowWatterMark) {
+                    ppNBLTail = &pSyncNBLTail;                            // Low RX buffers level, use synchronous RX buffer indication
+                    if (pSyncNBLTail == NULL) {                           // Synchronous NBL list empty?
+                        pSyncNBLHead = pCurrentNBL;                       // Current NBL is the first item of the Synchronous NBL list
+                    }
+                    SyncNBLItemCount++;                                   // Increment SyncNBLItemCount
+                    DBG_ENET_DEV_RX_PRINT_TRACE(" NBL(%4d, 0x%08X) indicate  SYNC, DmaIdx: %4d, Size: %d", MP_NBL_ID(pCurrentNBL), pCurrentNBL, MP_NB_DmaIdx(pCurrentNBL->FirstNetBuffer), NET_BUFFER_DATA_LENGTH(pCurrentNBL->FirstNetBuffer));
+                } else {
+                    ppNBLTail = &pAsyncNBLTail;                           // Normal RX buffers, use asynchronous RX buffer indication
+                    if (pAsyncNBLTail == NULL) {                          // Asynchronous NBL list empty?
+                        pAsyncNBLHead = pCurrentNBL;                      // Current NBL is the first item of the Asynchronous NBL list
+                    }
+                    AsyncNBLItemCount++;                                  // Increment AsyncNBLItemCount
+                    DBG_ENET_DEV_RX_PRINT_TRACE(" NBL(%4d, 0x%08X) indicate ASYNC, DmaIdx: %4d, Size: %d", MP_NBL_ID(pCurrentNBL), pCurrentNBL, MP_NB_DmaIdx(pCurrentNBL->FirstNetBuffer), NET_BUFFER_DATA_LENGTH(pCurrentNBL->FirstNetBuffer));
+                }
+                if (*ppNBLTail != NULL) {                                 // List empty?
+                    NET_BUFFER_LIST_NEXT_NBL(*ppNBLTail) = pCurrentNBL;   // No, attach current NBL to the tail of the list
+                }
+                *ppNBLTail = pCurrentNBL;                                 // Remember current tail of the list
+                NET_BUFFER_LIST_NEXT_NBL(pCurrentNBL) = NULL;             // Current NBL is the last NBL in the list
+                pCurrentNBL->SourceHandle = pAdapter->AdapterHandle;      // Set NBL source handle
+                NET_BUFFER_LIST_INFO(pCurrentNBL, TcpIpChecksumNetBufferListInfo) = ChecksumInfo;
+                #if NDIS_SUPPORT_NDIS682
+                if (pAdapter->Ptp.Enabled) {
+                    NdisSetNblTimestampInfo(pCurrentNBL, &NblTimestamp);
                 }
-                AsyncNBLItemCount++;                                  // Increment AsyncNBLItemCount
-                DBG_ENET_DEV_RX_PRINT_TRACE(" NBL(%4d, 0x%08X) indicate ASYNC, DmaIdx: %4d, Size: %d", MP_NBL_ID(pCurrentNBL), pCurrentNBL, MP_NB_DmaIdx(pCurrentNBL->FirstNetBuffer), NET_BUFFER_DATA_LENGTH(pCurrentNBL->FirstNetBuffer));
+                #endif
             }
-            if (*ppNBLTail != NULL) {                                 // List empty?
-                NET_BUFFER_LIST_NEXT_NBL(*ppNBLTail) = pCurrentNBL;   // No, attach current NBL to the tail of the list
+            if (++Rx_EnetPendingBDIdx == pRxQueue->DmaBDT_ItemCount) { // Compute next Rx_EnetPendingBDIdx
+                Rx_EnetPendingBDIdx = 0;
             }
-            *ppNBLTail = pCurrentNBL;                                 // Remember current tail of the list
-            NET_BUFFER_LIST_NEXT_NBL(pCurrentNBL) = NULL;             // Current NBL is the last NBL in the list
-            pCurrentNBL->SourceHandle = pAdapter->AdapterHandle;      // Set NBL source handle
+        } // More RFDs
+        pRxQueue->EnetPendingBDIdx = Rx_EnetPendingBDIdx;             // Update Ethernet Dma Rx empty buffer index
+        if (BDsReposted && (*pRxQueue->pRDAR == 0)) {                // Reposted Dma BDs and receive not in progress?
+            *pRxQueue->pRDAR = 0x00000000;                            // Yes, restart receive
         }
-        if (++Rx_EnetPendingBDIdx == pAdapter->Rx_DmaBDT_ItemCount) { // Compute next Rx_EnetPendingBDIdx
-            Rx_EnetPendingBDIdx = 0;
+        if (pRecvThrottleParameters->MoreNblsPending) {
+            break;
         }
-    } // More RFDs
-    pAdapter->Rx_EnetPendingBDIdx = Rx_EnetPendingBDIdx;              // Update Ethernet Dma Rx empty buffer index
+    }
     pAdapter->Rx_NdisOwnedBDsCount += AsyncNBLItemCount + SyncNBLItemCount + ErrorNBLItemCount;
+    pAdapter->Rx_IntModeration.Frames += AsyncNBLItemCount + SyncNBLItemCount + ErrorNBLItemCount;  // Frames received by this interrupt
     NdisDprReleaseSpinLock(&pAdapter->Rx_SpinLock);
     if (pErrorNBLHead) {
         DBG_ENET_DEV_RX_PRINT_ERROR(" NBL(%4d) received with error, returning back", MP_NBL_ID(pErrorNBLHead));
@@ -35,6 +35,7 @@
 #define _MP_DATA_PATH_H
 
 #define MAC_RX_BUFFER_LOW_WATER_PERCENT  20
+#define MAC_RX_SPARE_BUFFER_PERCENT      50
 
 
 #define MP_NB_pMpTxBD(_NetBuffer)             ((PMP_TX_BD)((_NetBuffer)->MiniportReserved[0]))
@@ -62,14 +63,8 @@ MINIPORT_RETURN_NET_BUFFER_LISTS    MpReturnNetBufferLists;
 
 _IRQL_requires_(DISPATCH_LEVEL)
 BOOLEAN MpTxCancelAll(_In_ PMP_ADAPTER pAdapter);
-_IRQL_requires_max_(DISPATCH_LEVEL)
-void MpQueueInit(PMP_QUEUE QueuePtr);
 MINIPORT_PROCESS_SG_LIST MpProcessSGList;
 _IRQL_requires_max_(DISPATCH_LEVEL)
-void MpQueueAdd(_In_ PMP_QUEUE QueuePtr, PLIST_ENTRY ListEntryPtr);
-_IRQL_requires_max_(DISPATCH_LEVEL)
-LONG MpQueueGetDepth(PMP_QUEUE pQueue);
-_IRQL_requires_max_(DISPATCH_LEVEL)
 void MpHandleTxInterrupt(_In_ PMP_ADAPTER pAdapter, _In_ UINT32 InterruptEvent);
 _IRQL_requires_max_(DISPATCH_LEVEL)
 void MpHandleRecvInterrupt(_In_ PMP_ADAPTER pAdapter, _Inout_ PULONG pMaxNBLsToIndicate, _Inout_ PNDIS_RECEIVE_THROTTLE_PARAMETERS pRecvThrottleParameters);
@@ -327,6 +327,13 @@ void Dbg_DumpTxStats(PMP_ADAPTER pAdapter)
     RETAILMSG(ZONE_REGDUMP, FORMAT_REGNAME_REGVALUE(IEEE_T_FDXFC));
     RETAILMSG(ZONE_REGDUMP, FORMAT_REGNAME_REGVALUE(IEEE_T_OCTETS_OK));
 
+    RETAILMSG(ZONE_REGDUMP, "Tx frames copied\t= %u\n", pAdapter->TxdStatus.FramesXmitCopied);
+    RETAILMSG(ZONE_REGDUMP, "Tx frames copy avoided\t= %u\n", pAdapter->TxdStatus.FramesXmitCopyAvoided);
+    RETAILMSG(ZONE_REGDUMP, "Tx bytes copy avoided\t= %I64u\n", pAdapter->TxdStatus.BytesXmitCopyAvoided);
+    RETAILMSG(ZONE_REGDUMP, "Tx interrupt rate\t= %u/s\n", pAdapter->Tx_IntModeration.InterruptRate);
+    RETAILMSG(ZONE_REGDUMP, "Tx frame rate\t= %u/s\n", pAdapter->Tx_IntModeration.FrameRate);
+    RETAILMSG(ZONE_REGDUMP, "Tx moderation level\t= %u (%u changes)\n", pAdapter->Tx_IntModeration.Level, pAdapter->Tx_IntModeration.LevelChanges);
+
     RETAILMSG(ZONE_REGDUMP, "%s ---\r\n\r\n",__FUNCTION__);
 }
 
@@ -368,6 +375,18 @@ void Dbg_DumpRxStats(PMP_ADAPTER pAdapter)
     RETAILMSG(ZONE_REGDUMP, FORMAT_REGNAME_REGVALUE(IEEE_R_MACERR));
     RETAILMSG(ZONE_REGDUMP, FORMAT_REGNAME_REGVALUE(IEEE_R_FDXFC));
     RETAILMSG(ZONE_REGDUMP, FORMAT_REGNAME_REGVALUE(IEEE_R_OCTETS_OK));
+    RETAILMSG(ZONE_REGDUMP, FORMAT_REGNAME_REGVALUE(ATCR));
+    RETAILMSG(ZONE_REGDUMP, FORMAT_REGNAME_REGVALUE(ATPER));
+    RETAILMSG(ZONE_REGDUMP, FORMAT_REGNAME_REGVALUE(ATCOR));
+    RETAILMSG(ZONE_REGDUMP, FORMAT_REGNAME_REGVALUE(ATINC));
+
+    RETAILMSG(ZONE_REGDUMP, "Rx IP checksum errors\t= %u\n", pAdapter->RcvStatus.FrameRcvIpChecksumErrors);
+    RETAILMSG(ZONE_REGDUMP, "Rx protocol checksum errors\t= %u\n", pAdapter->RcvStatus.FrameRcvProtocolChecksumErrors);
+    RETAILMSG(ZONE_REGDUMP, "Rx frames copied\t= %u\n", pAdapter->RcvStatus.FrameRcvCopied);
+    RETAILMSG(ZONE_REGDUMP, "Rx spare buffers used\t= %u\n", pAdapter->RcvStatus.FrameRcvSpareBufferUsed);
+    RETAILMSG(ZONE_REGDUMP, "Rx interrupt rate\t= %u/s\n", pAdapter->Rx_IntModeration.InterruptRate);
+    RETAILMSG(ZONE_REGDUMP, "Rx frame rate\t= %u/s\n", pAdapter->Rx_IntModeration.FrameRate);
+    RETAILMSG(ZONE_REGDUMP, "Rx moderation level\t= %u (%u changes)\n", pAdapter->Rx_IntModeration.Level, pAdapter->Rx_IntModeration.LevelChanges);
 
     RETAILMSG(ZONE_REGDUMP, "%s ---\r\n\r\n",__FUNCTION__);
 }
@@ -754,6 +773,7 @@ const char* Dbg_GetACPIFunctionName(ULONG i) {
         MAKECASE1(IMX_ENET_DSM_FUNCTION_GET_MAC_ADDRESS_INDEX,               MAC_ADDRESS)
         MAKECASE1(IMX_ENET_DSM_FUNCTION_GET_MDIO_BASE_ADDRESS_INDEX,         MDIO_BASE_ADDRESS)
         MAKECASE1(IMX_ENET_DSM_FUNCTION_GET_ENET_PHY_INTERFACE_TYPE_INDEX,   ENET_PHY_INTERFACE_TYPE)
+        MAKECASE1(IMX_ENET_DSM_FUNCTION_GET_ENET_CLOCK_FREQUENCY_INDEX,      ENET_CLOCK_FREQUENCY)
         MAKEDEFAULT("ACPI function")
     }
 }
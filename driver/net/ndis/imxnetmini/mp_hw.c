@@ -123,6 +123,177 @@ void ClearAllMultiCast(PMP_ADAPTER pAdapter)
     pAdapter->ENETRegBase->GALR = 0;
 }
 
+// Adaptive interrupt moderation levels, level 0 means coalescing disabled
+static const struct {
+    ULONG   FrameThreshold;     // ICFT, number of frames before the interrupt is generated
+    ULONG   TimeThresholdUs;    // ICTT, the longest time the interrupt is delayed after the first frame [us]
+} EnetImLevels[ENET_IM_LEVEL_COUNT] = {
+    {  0,   0 },
+    {  4,  32 },
+    { 16,  64 },
+    { 32, 128 },
+    { 64, 256 },
+};
+
+/*++
+Routine Description:
+    Returns ICFT value of the moderation level limited to half of the buffer descriptor ring.
+Arguments:
+    Level           Moderation level
+    BDItemCount     Number of buffer descriptors in the ring
+Return Value:
+    Frame threshold
+--*/
+static ULONG EnetImFrameThreshold(_In_ ULONG Level, _In_ LONG BDItemCount)
+{
+    ULONG MaxThreshold = (BDItemCount > 2) ? (ULONG)BDItemCount / 2 : 1;
+    return min(EnetImLevels[Level].FrameThreshold, MaxThreshold);
+}
+
+/*++
+Routine Description:
+    Returns TXICn/RXICn register value of the moderation level for a ring.
+Arguments:
+    pAdapter        Pointer to adapter data
+    Level           Moderation level
+    BDItemCount     Number of buffer descriptors in the ring
+Return Value:
+    Interrupt coalescing register value
+--*/
+static UINT32 EnetImRegValue(_In_ PMP_ADAPTER pAdapter, _In_ ULONG Level, _In_ LONG BDItemCount)
+{
+    if (!Level) {
+        return 0;
+    }
+    return ENET_IC_ICEN_MASK | ENET_IC_ICCS_MASK | (EnetImFrameThreshold(Level, BDItemCount) << ENET_IC_ICFT_SHIFT) |
+           ((UINT32)((ULONGLONG)EnetImLevels[Level].TimeThresholdUs * pAdapter->IntCoalescingClockFrequencyHz / (64 * 1000000ULL)) & ENET_IC_ICTT_MASK);
+}
+
+/*++
+Routine Description:
+    Programs ENET Rx and Tx interrupt coalescing registers according to the current moderation levels.
+    All used rings share the Rx and Tx moderation levels, the frame threshold is limited by the size of each ring.
+    Caller must hold Dev_SpinLock or call it before the ENET is started.
+Arguments:
+    pAdapter    Pointer to adapter data
+Return Value:
+    None
+--*/
+static void EnetProgramInterruptCoalescing(_In_ PMP_ADAPTER pAdapter)
+{
+    volatile CSP_ENET_REGS  *ENETRegBase = pAdapter->ENETRegBase;
+    volatile IC_t           *pRXIC = &ENETRegBase->RXIC0;          // RXIC0-2 and TXIC0-2 are consecutive registers
+    volatile IC_t           *pTXIC = &ENETRegBase->TXIC0;
+
+    if (!pAdapter->IntCoalescingSupported) {
+        return;
+    }
+    for (ULONG QueueIdx = 0; QueueIdx < pAdapter->QueueCount; QueueIdx++) {
+        pRXIC[QueueIdx].U = 0;                    // Coalescing must be disabled before thresholds are changed
+        pRXIC[QueueIdx].U = EnetImRegValue(pAdapter, pAdapter->Rx_IntModeration.Level, pAdapter->Rx_Queue[QueueIdx].DmaBDT_ItemCount);
+        pTXIC[QueueIdx].U = 0;
+        pTXIC[QueueIdx].U = EnetImRegValue(pAdapter, pAdapter->Tx_IntModeration.Level, pAdapter->Tx_Queue[QueueIdx].DmaBDT_ItemCount);
+    }
+}
+
+/*++
+Routine Description:
+    Computes interrupt and frame rates of the last sampling period and selects the new moderation level.
+    The level is raised while interrupts are generated by the frame threshold (the ring fills up faster than the
+    timer expires) and lowered when the timer mostly generates interrupts with only a few frames.
+Arguments:
+    pAdapter        Pointer to adapter data
+    pIntModeration  Moderation state of Rx or Tx path
+    BDItemCount     Number of buffer descriptors in the ring
+    Elapsed         Length of the sampling period [100ns]
+Return Value:
+    TRUE if the moderation level has been changed
+--*/
+static BOOLEAN EnetEvaluateInterruptModeration(_In_ PMP_ADAPTER pAdapter, _Inout_ PMP_INT_MODERATION pIntModeration, _In_ LONG BDItemCount, _In_ LONGLONG Elapsed)
+{
+    ULONG   Level = pIntModeration->Level;
+    ULONG   FramesPerInterrupt;
+    ULONG   FrameThreshold;
+
+    pIntModeration->InterruptRate = (ULONG)((ULONG64)pIntModeration->Interrupts * 10000000 / (ULONG64)Elapsed);
+    pIntModeration->FrameRate     = (ULONG)((ULONG64)pIntModeration->Frames * 10000000 / (ULONG64)Elapsed);
+    FramesPerInterrupt            = pIntModeration->Interrupts ? pIntModeration->Frames / pIntModeration->Interrupts : 0;
+    if (!pAdapter->InterruptModeration || (pIntModeration->FrameRate < ENET_IM_LOW_FRAME_RATE)) {
+        Level = 0;                                                           // Low load, prefer latency
+    } else if (Level == 0) {
+        Level = 1;                                                           // Load is high enough to start coalescing
+    } else {
+        FrameThreshold = EnetImFrameThreshold(Level, BDItemCount);
+        if ((FramesPerInterrupt >= FrameThreshold) && (Level < ENET_IM_LEVEL_COUNT - 1)) {
+            Level++;                                                         // Frame threshold is reached before the timer expires
+        } else if ((FramesPerInterrupt * 4 < FrameThreshold) && (Level > 1)) {
+            Level--;                                                         // Timer expires with only a few frames, reduce latency
+        }
+    }
+    pIntModeration->Interrupts = 0;
+    pIntModeration->Frames     = 0;
+    if (Level == pIntModeration->Level) {
+        return FALSE;
+    }
+    pIntModeration->Level = Level;
+    pIntModeration->LevelChanges++;
+    return TRUE;
+}
+
+/*++
+Routine Description:
+    Re-evaluates adaptive interrupt moderation once per sampling period. It is called from EnetDpc().
+Arguments:
+    pAdapter    Pointer to adapter data
+Return Value:
+    None
+--*/
+_Use_decl_annotations_
+void EnetUpdateInterruptModeration(PMP_ADAPTER pAdapter)
+{
+    LONGLONG    Now = (LONGLONG)KeQueryInterruptTime();
+    LONGLONG    Elapsed = Now - pAdapter->IntModerationSampleTime;
+    BOOLEAN     Changed;
+
+    if (!pAdapter->IntCoalescingSupported || (Elapsed < ENET_IM_SAMPLE_PERIOD_100NS)) {
+        return;
+    }
+    NdisDprAcquireSpinLock(&pAdapter->Dev_SpinLock);
+    pAdapter->IntModerationSampleTime = Now;
+    Changed  = EnetEvaluateInterruptModeration(pAdapter, &pAdapter->Rx_IntModeration, pAdapter->Rx_DmaBDT_ItemCount, Elapsed);
+    Changed |= EnetEvaluateInterruptModeration(pAdapter, &pAdapter->Tx_IntModeration, pAdapter->Tx_DmaBDT_ItemCount, Elapsed);
+    if (Changed) {
+        DBG_ENET_DEV_DPC_PRINT_TRACE("Interrupt moderation level Rx: %d (%d frames/s), Tx: %d (%d frames/s)", pAdapter->Rx_IntModeration.Level, pAdapter->Rx_IntModeration.FrameRate, pAdapter->Tx_IntModeration.Level, pAdapter->Tx_IntModeration.FrameRate);
+        EnetProgramInterruptCoalescing(pAdapter);
+    }
+    NdisDprReleaseSpinLock(&pAdapter->Dev_SpinLock);
+}
+
+/*++
+Routine Description:
+    Enables or disables adaptive interrupt moderation. Coalescing is switched off immediately when disabled,
+    when enabled the level is raised by EnetUpdateInterruptModeration() according to the load.
+Arguments:
+    pAdapter    Pointer to adapter data
+    Enable      TRUE to enable adaptive interrupt moderation
+Return Value:
+    None
+--*/
+_Use_decl_annotations_
+void EnetSetInterruptModeration(PMP_ADAPTER pAdapter, BOOLEAN Enable)
+{
+    NdisAcquireSpinLock(&pAdapter->Dev_SpinLock);
+    pAdapter->InterruptModeration = Enable;
+    if (!Enable) {
+        pAdapter->Rx_IntModeration.Level = 0;
+        pAdapter->Tx_IntModeration.Level = 0;
+        if (pAdapter->EnetStarted) {
+            EnetProgramInterruptCoalescing(pAdapter);
+        }
+    }
+    NdisReleaseSpinLock(&pAdapter->Dev_SpinLock);
+}
+
 /*++
 Routine Description:
     MiniportHandleInterrupt handler
@@ -173,9 +344,11 @@ VOID EnetDpc(NDIS_HANDLE  MiniportInterruptContext, PVOID MiniportDpcContext, PV
             return;
         }
         if (InterruptEvent & ENET_TX_INT_MASK) {                        // Handle frame(s) sent or sent error interrupt
+            pAdapter->Tx_IntModeration.Interrupts++;
             MpHandleTxInterrupt(pAdapter, InterruptEvent);
         }
         if (InterruptEvent & ENET_RX_INT_MASK) {                        // Handle frame(s) received or receive error interrupt
+            pAdapter->Rx_IntModeration.Interrupts++;
             MpHandleRecvInterrupt(pAdapter, &MaxNBLsToIndicate, pRecvThrottleParameters);
             if (pRecvThrottleParameters->MoreNblsPending) {
                 NdisDprAcquireSpinLock(&pAdapter->Dev_SpinLock);
@@ -185,9 +358,12 @@ VOID EnetDpc(NDIS_HANDLE  MiniportInterruptContext, PVOID MiniportDpcContext, PV
             }
         }
         if (InterruptEvent & ENET_EIR_GRA_MASK) {                       // Restart Tx path after pause frame transmit
-            pAdapter->ENETRegBase->TDAR = 0x0000000;
+            for (ULONG QueueIdx = 0; QueueIdx < pAdapter->QueueCount; QueueIdx++) {
+                *pAdapter->Tx_Queue[QueueIdx].pTDAR = 0x0000000;
+            }
         }
     } while (0);
+    EnetUpdateInterruptModeration(pAdapter);                            // Adapt interrupt coalescing to the current load
     if (!pRecvThrottleParameters->MoreNblsPending) {
       NdisMSynchronizeWithInterruptEx(pAdapter->NdisInterruptHandle, 0, EnetEnableRxAndTxInterrupts, pAdapter);
     }
@@ -296,6 +472,34 @@ void EnetStop(PMP_ADAPTER pAdapter, NDIS_STATUS NdisStatus)
     NdisReleaseSpinLock(&pAdapter->Dev_SpinLock);
 }
 
+/*++
+Routine Description:
+    Returns RCMRn value that steers VLAN tagged frames to the AVB class ring, according to ENET_PRIORITY_TO_QUEUE().
+    Unused compare fields repeat the last matched priority.
+Arguments:
+    QueueIdx    AVB class ring index (1 or 2)
+Return Value:
+    Receive classification match register value
+--*/
+static UINT32 EnetClassMatchRegValue(_In_ ULONG QueueIdx)
+{
+    UINT32  RegValue = ENET_RCMR_MATCHEN_MASK;
+    ULONG   CmpIdx = 0;
+    ULONG   LastPriority = 0;
+
+    for (ULONG Priority = 0; Priority < ENET_PRIORITY_COUNT; Priority++) {
+        if (ENET_PRIORITY_TO_QUEUE(Priority) == QueueIdx) {
+            ASSERT(CmpIdx < ENET_RCMR_CMP_COUNT);
+            RegValue |= (Priority & ENET_RCMR_CMP_MASK) << ENET_RCMR_CMP_SHIFT(CmpIdx++);
+            LastPriority = Priority;
+        }
+    }
+    while (CmpIdx < ENET_RCMR_CMP_COUNT) {
+        RegValue |= (LastPriority & ENET_RCMR_CMP_MASK) << ENET_RCMR_CMP_SHIFT(CmpIdx++);
+    }
+    return RegValue;
+}
+
 /*++
 Routine Description:
     This function starts the frame reception.
@@ -319,14 +523,32 @@ void EnetStart(PMP_ADAPTER pAdapter)
     pAdapter->EnetStarted = TRUE;                                     // Remember new Enet state
     pAdapter->NdisStatus = NDIS_STATUS_SUCCESS;                       // Remember new NDIS status
     pAdapter->InterruptFlags = 0;                                     // No interrupt flags pending from previous call of DPC
-    ENETRegBase->ERDSR = (ULONG)pAdapter->Rx_DmaBDT_Pa.QuadPart;      // Set the Rx_DmaBDT physical address
-    ENETRegBase->ETDSR = (ULONG)pAdapter->Tx_DmaBDT_Pa.QuadPart;      // Set the Tx_DmaBDT physical address
+    NdisZeroMemory(&pAdapter->Rx_IntModeration, sizeof(pAdapter->Rx_IntModeration));  // Start with coalescing disabled
+    NdisZeroMemory(&pAdapter->Tx_IntModeration, sizeof(pAdapter->Tx_IntModeration));
+    pAdapter->IntModerationSampleTime = (LONGLONG)KeQueryInterruptTime();
+    EnetProgramInterruptCoalescing(pAdapter);
+    ENETRegBase->ERDSR = (ULONG)pAdapter->Rx_Queue[0].DmaBDT_Pa.QuadPart;   // Set the best effort ring Rx_DmaBDT physical address
+    ENETRegBase->ETDSR = (ULONG)pAdapter->Tx_Queue[0].DmaBDT_Pa.QuadPart;   // Set the best effort ring Tx_DmaBDT physical address
     ENETRegBase->EMRBR = 0x7f0;                                       //
+    if (pAdapter->QueueCount > 1) {                                   // AVB class rings used?
+        ENETRegBase->RDSR1   = (ULONG)pAdapter->Rx_Queue[1].DmaBDT_Pa.QuadPart;
+        ENETRegBase->TDSR1   = (ULONG)pAdapter->Tx_Queue[1].DmaBDT_Pa.QuadPart;
+        ENETRegBase->MRBR1   = 0x7f0;
+        ENETRegBase->RDSR2   = (ULONG)pAdapter->Rx_Queue[2].DmaBDT_Pa.QuadPart;
+        ENETRegBase->TDSR2   = (ULONG)pAdapter->Tx_Queue[2].DmaBDT_Pa.QuadPart;
+        ENETRegBase->MRBR2   = 0x7f0;
+        ENETRegBase->RCMR1   = EnetClassMatchRegValue(1);             // Steer VLAN tagged frames to the class rings by priority
+        ENETRegBase->RCMR2   = EnetClassMatchRegValue(2);
+        ENETRegBase->DMACFG1 = ENET_DMACFG_DMA_CLASS_EN_MASK | (ENET_CLASS_QUEUE_IDLE_SLOPE & ENET_DMACFG_IDLE_SLOPE_MASK);  // Enable credit based shaping
+        ENETRegBase->DMACFG2 = ENET_DMACFG_DMA_CLASS_EN_MASK | (ENET_CLASS_QUEUE_IDLE_SLOPE & ENET_DMACFG_IDLE_SLOPE_MASK);
+    }
     ENETRegBase->EIR.U = (ENET_RX_TX_INT_MASK);                       // Clear Rx and Tx interrupts flags
     NdisMSynchronizeWithInterruptEx(pAdapter->NdisInterruptHandle, 0, EnetEnableRxAndTxInterrupts, pAdapter);
     _DataSynchronizationBarrier();                                    // Wait until mem-io accesses are finished 
     ENETRegBase->ECR.U |= ENET_ECR_ETHER_EN_MASK;                     // Start Enet (ENET must be running in order to invoke MII interrupt)
-    ENETRegBase->RDAR = 0x00000000;                                   // Start data reception
+    for (ULONG QueueIdx = 0; QueueIdx < pAdapter->QueueCount; QueueIdx++) {
+        *pAdapter->Rx_Queue[QueueIdx].pRDAR = 0x00000000;             // Start data reception
+    }
     DBG_SM_PRINT_TRACE("ENET started, releasing all spinlocks");
     NdisReleaseSpinLock(&pAdapter->Tx_SpinLock);
     NdisReleaseSpinLock(&pAdapter->Rx_SpinLock);
@@ -352,6 +574,28 @@ void EnetDeinit(PMP_ADAPTER pAdapter)
     DBG_SM_PRINT_TRACE("ENET reset done");
 }
 
+/*++
+Routine Description:
+    Probes the ENET AVB class rings and selects the number of Rx/Tx rings used by the driver.
+    Not all ENET versions implement the class rings, the RDSR1 register reads as zero in such case.
+    The class rings are used only if enabled in registry and enhanced buffer descriptors are used (Tx ring is selected by the FTYPE field).
+Arguments:
+    pAdapter    Pointer to adapter data
+Return Value:
+    None
+--*/
+_Use_decl_annotations_
+void EnetProbeQueues(PMP_ADAPTER pAdapter)
+{
+    volatile CSP_ENET_REGS* ENETRegBase = pAdapter->ENETRegBase;
+
+    ENETRegBase->RDSR1 = 0xFFFFFFF8;                                                                 // Probe class ring registers, the descriptor ring start address is 8 byte aligned
+    pAdapter->ClassQueuesSupported = (ENETRegBase->RDSR1 != 0);
+    ENETRegBase->RDSR1 = 0;
+    pAdapter->QueueCount = (pAdapter->PriorityQueues && pAdapter->EnhancedBDs && pAdapter->ClassQueuesSupported) ? ENET_QUEUE_COUNT_MAX : 1;
+    DBG_ENET_DEV_PRINT_INFO("Class rings supported: %d, used rings: %d", pAdapter->ClassQueuesSupported, pAdapter->QueueCount);
+}
+
 /*++
 Routine Description:
     Initialize the adapter and set up everything
@@ -396,10 +640,27 @@ void EnetInit(PMP_ADAPTER pAdapter, MP_MDIO_PHY_INTERFACE_TYPE EnetPhyInterfaceT
             RCR_RegMask |= ENET_RCR_RMII_10T_MASK;                             // Select 10 MBs
         }
     }
+    if (pAdapter->EnhancedBDs) {
+        ECR_RegMask |= ENET_ECR_EN1588_EN_MASK;                                // Use enhanced buffer descriptors (checksum offload)
+    }
     ENETRegBase->ECR.U = ECR_RegMask;
     ENETRegBase->RCR.U = RCR_RegMask;
     ENETRegBase->TCR.U = TCR_RegMask;
     ENETRegBase->MIBC.U = 0;                                                                         // Enable statistic counters
+    ENETRegBase->RXIC0.U = ENET_IC_ICFT_MASK;                                                        // Probe interrupt coalescing registers, not all ENET versions implement them
+    pAdapter->IntCoalescingSupported = (ENETRegBase->RXIC0.U & ENET_IC_ICFT_MASK) != 0;
+    ENETRegBase->RXIC0.U = 0;
+    ENETRegBase->TXIC0.U = 0;
+    if (pAdapter->ClassQueuesSupported) {
+        ENETRegBase->RXIC1.U = 0;
+        ENETRegBase->RXIC2.U = 0;
+        ENETRegBase->TXIC1.U = 0;
+        ENETRegBase->TXIC2.U = 0;
+        ENETRegBase->RCMR1   = 0;                                                                    // No classification, the class rings are set up by EnetStart()
+        ENETRegBase->RCMR2   = 0;
+        ENETRegBase->DMACFG1 = 0;
+        ENETRegBase->DMACFG2 = 0;
+    }
     ENETRegBase->RACC.U = ENET_RACC_SHIFT16_MASK;                                                    // Instructs the MAC to write two additional bytes in front of each frame received into the RX FIFO.
     ENETRegBase->PALR = pAdapter->FecMacAddress[3] | pAdapter->FecMacAddress[2] << 8 | pAdapter->FecMacAddress[1] << 16 | pAdapter->FecMacAddress[0] << 24;
     ENETRegBase->PAUR = pAdapter->FecMacAddress[5] << 16 | pAdapter->FecMacAddress[4] << 24;           // Set the station address for the ENET Adapter
@@ -425,7 +686,13 @@ void EnetInit(PMP_ADAPTER pAdapter, MP_MDIO_PHY_INTERFACE_TYPE EnetPhyInterfaceT
     ENETRegBase->TAFL = ENET_MAC_TX_ALMOST_FULL_DEFAULT_VALUE;   // min 4
     ENETRegBase->TSEM = ENET_MAC_TX_SECTION_EMPTY_DEFAULT_VALUE; // 8~480?
 #endif
+    if (pAdapter->EnhancedBDs) {
+        ENETRegBase->TFWR.U |= ENET_TCR_STRFWD_MASK;    // Checksum insertion requires the whole frame in Tx FIFO before transmission starts
+    }
     SetUnicast(pAdapter);
+    if (pAdapter->Ptp.Enabled) {
+        EnetPtpStart(pAdapter);                         // Start the IEEE 1588 timer, ECR[EN1588] is set above
+    }
     //Dbg_DumpFifoTrasholdsAndPauseFrameDuration(pAdapter);
     DBG_SM_METHOD_END();
 }
\ No newline at end of file
@@ -38,9 +38,13 @@
 extern "C" {
 #endif
 
-// The Version of NDIS that the ENET driver is compatible with
+// The Version of NDIS that the ENET driver is compatible with, NDIS 6.82 is required by the NBL timestamp OOB data
 #define ENET_NDIS_MAJOR_VERSION                    6
+#if NDIS_SUPPORT_NDIS682
+#define ENET_NDIS_MINOR_VERSION                   82
+#else
 #define ENET_NDIS_MINOR_VERSION                   30
+#endif
 
 #define NDIS60_MINIPORT                            1
 
@@ -77,6 +81,24 @@ extern "C" {
 #define ETHER_FRAME_CRC_LENGTH                    4  // Size of Ethernet frame CRC
 #define ETHER_FRAME_MAX_LENGTH                 1518  // Maximal Ethernet frame size (sum of header, payload and CRC)
 #define ETHER_FRAME_NIN_LENGTH                   64  // Minimal Ethernet frame size (sum of header, payload and CRC)
+#define ETHER_FRAME_TYPE_OFFSET                  12  // Offset of EtherType in Ethernet frame MAC header
+#define ETHER_VLAN_TAG_LENGTH                     4  // Size of 802.1Q tag
+#define ETHER_TYPE_IPV4                      0x0800
+#define ETHER_TYPE_IPV6                      0x86DD
+#define ETHER_TYPE_VLAN                      0x8100
+
+// IP header definitions used by checksum offload
+#define IPV4_HEADER_MIN_LENGTH                   20  // Size of IPv4 header without options
+#define IPV4_HEADER_MAX_LENGTH                   60  // Size of IPv4 header with maximal options
+#define IPV4_HEADER_PROTOCOL_OFFSET               9  // Offset of protocol in IPv4 header
+#define IPV4_HEADER_CHECKSUM_OFFSET              10  // Offset of header checksum in IPv4 header
+#define IPV6_HEADER_LENGTH                       40  // Size of IPv6 header (extension headers are not offloaded)
+#define IPV6_HEADER_NEXT_HEADER_OFFSET            6  // Offset of next header in IPv6 header
+#define TCP_HEADER_CHECKSUM_OFFSET               16  // Offset of checksum in TCP header
+#define UDP_HEADER_CHECKSUM_OFFSET                6  // Offset of checksum in UDP header
+#define ENET_TX_CSUM_HEADERS_MAX_LENGTH          (ETHER_FRAME_HEADER_LENGTH + ETHER_VLAN_TAG_LENGTH + IPV4_HEADER_MAX_LENGTH + TCP_HEADER_CHECKSUM_OFFSET + 2)  // Headers parsed for checksum insertion
+#define IP_PROTOCOL_TCP                           6
+#define IP_PROTOCOL_UDP                          17
 
 // Configuration from registry, should be the same as in INF file
 #define RX_DESC_COUNT_DEFAULT                   128  // Number of Rx buffer descriptors
@@ -88,15 +110,52 @@ extern "C" {
 #define SPEED_SELECT_DEFAULT             SPEED_AUTO  // Speed select
 #define SPEED_SELECT_MIN                 SPEED_AUTO
 #define SPEED_SELECT_MAX     SPEED_FULL_DUPLEX_100M
+#define ENHANCED_BDS_DEFAULT                      1  // Use enhanced buffer descriptors
+#define CHECKSUM_OFFLOAD_DEFAULT                  3  // Rx & Tx checksum offload enabled
+#define CHECKSUM_OFFLOAD_MIN                      0
+#define CHECKSUM_OFFLOAD_MAX                      3
+#define INTERRUPT_MODERATION_DEFAULT              1  // Adaptive interrupt moderation enabled
+#define PRIORITY_QUEUES_DEFAULT                   1  // 802.1p priority traffic uses ENET AVB class rings, if implemented
+#define PTP_HARDWARE_TIMESTAMP_DEFAULT            1  // IEEE 1588 Rx/Tx time stamping enabled (requires enhanced buffer descriptors)
+#define PTP_CLOCK_FREQUENCY_DEFAULT       125000000  // IEEE 1588 timer reference clock frequency [Hz] (ENET_REF_CLK)
+#define PTP_CLOCK_FREQUENCY_MIN            10000000
+#define PTP_CLOCK_FREQUENCY_MAX           250000000
+
+// IEEE 1588 timer. The timer counts nanoseconds and wraps at ENET_PTP_COUNTER_PERIOD, the driver extends it to 64 bits.
+#define ENET_PTP_COUNTER_PERIOD          0x80000000UL  // ATPER value, the counter (and the ENET_xxBD time stamps) wraps every ~2.1 s
+#define ENET_PTP_COUNTER_MASK            0x7FFFFFFFUL
+#define ENET_PTP_UPDATE_PERIOD_MS               500  // The 64 bit time is updated at least once per half of the counter period
+#define ENET_PTP_MAX_ADJ_PPB             100000000L  // Max frequency adjustment [ppb]
+
+// ENET rings (queues). Ring 0 is the best effort ring, rings 1 and 2 are the AVB class rings with credit based shaping.
+#define ENET_QUEUE_COUNT_MAX                      3
+#define ENET_CLASS_QUEUE_RX_DESC_COUNT           32  // Number of Rx buffer descriptors of each AVB class ring
+#define ENET_CLASS_QUEUE_TX_DESC_COUNT           32  // Number of Tx buffer descriptors of each AVB class ring
+#define ENET_CLASS_QUEUE_IDLE_SLOPE          0x0200  // Credit based shaper idle slope of the AVB class rings
+#define ENET_PRIORITY_TO_QUEUE(_Priority)    (((_Priority) < 2) ? 0UL : ((_Priority) < 5) ? 1UL : 2UL)  // 802.1p priority 0-1: ring 0, 2-4: ring 1, 5-7: ring 2
+#define ENET_PRIORITY_COUNT                       8
+
+// Adaptive interrupt moderation
+#define ENET_IC_CLOCK_FREQUENCY_DEFAULT   132000000  // ENET system (AHB) clock used to count ICTT [Hz] on i.MX6, one ICTT tick is 64 clock cycles
+#define ENET_IC_CLOCK_FREQUENCY_MAX       500000000  // 0 in registry means the frequency is taken from ACPI, or the default if ACPI does not provide it
+#define ENET_IM_SAMPLE_PERIOD_100NS          100000  // Moderation level is re-evaluated every 10 ms
+#define ENET_IM_LOW_FRAME_RATE                10000  // Below this number of frames per second coalescing is disabled (the lowest latency)
+#define ENET_IM_LEVEL_COUNT                       5  // Number of moderation levels, level 0 means coalescing disabled
 
 #define ENET_RX_FRAME_SIZE                     2048
 #define ENET_TX_FRAME_SIZE                     2048
+#define ENET_TX_COPY_BREAK_LENGTH               128  // Tx frames up to this size (including runt frames) are copied to the driver Tx buffer
+#define ENET_RX_COPY_BREAK_LENGTH               256  // Rx frames up to this size are copied to a small buffer, the ENET_RxBD buffer is reposted immediately
+#define ENET_RX_COPY_BUFFER_SIZE                320  // Size of the small Rx buffer (copy break length + 2 bytes alignment shift, rounded up to the cache line)
+#define ENET_RX_COPY_BUFFER_COUNT               256  // Number of the small Rx buffers
+#define ENET_TX_MAX_BD_PER_FRAME                  8  // Maximal number of ENET_TxBDs (SG elements) mapped for one Tx frame
+#define ENET_TX_BUFFER_ALIGN_MASK              0x0F  // Tx data buffer alignment required by uDMA (4 bytes on i.MX6Q, 16 bytes on AVB capable ENET)
 
 #define MMI_DATA_MASK                         0xFFFF
 
 #define ENET_TX_ERR_INT_MASK (ENET_EIR_LC_MASK| ENET_EIR_RL_MASK | ENET_EIR_UN_MASK)
-#define ENET_RX_INT_MASK     (ENET_EIR_RXF_MASK)
-#define ENET_TX_INT_MASK     (ENET_EIR_TXF_MASK | ENET_TX_ERR_INT_MASK)
+#define ENET_RX_INT_MASK     (ENET_EIR_RXF_MASK | ENET_EIR_RXF1_MASK | ENET_EIR_RXF2_MASK)
+#define ENET_TX_INT_MASK     (ENET_EIR_TXF_MASK | ENET_EIR_TXF1_MASK | ENET_EIR_TXF2_MASK | ENET_TX_ERR_INT_MASK)
 #define ENET_RX_TX_INT_MASK  (ENET_RX_INT_MASK | ENET_TX_INT_MASK | ENET_EIR_GRA_MASK)
 
 // statistic counters for the frames which have been received by the ENET
@@ -110,6 +169,10 @@ typedef struct  _FRAME_RCV_STATUS
     ULONG    FrameRcvOverrunErrors;
     ULONG    FrameRcvAllignmentErrors;
     ULONG    FrameRcvLCErrors;
+    ULONG    FrameRcvIpChecksumErrors;
+    ULONG    FrameRcvProtocolChecksumErrors;
+    ULONG    FrameRcvCopied;                    // Frames copied to a small buffer (copy break)
+    ULONG    FrameRcvSpareBufferUsed;           // ENET_RxBDs refilled from the spare buffer pool
 } FRAME_RCV_STATUS,  *PFRAME_RCV_STATUS;
 
 // statistic counters for the frames which have been transmitted by the ENET
@@ -122,8 +185,22 @@ typedef struct  _FRAME_TXD_STATUS
     ULONG    FramesXmitAbortedErrors;
     ULONG    FramesXmitUnderrunErrors;
     ULONG    FramsXmitCarrierErrors;
+    ULONG    FramesXmitCopied;          // Frames copied to the driver Tx buffer
+    ULONG    FramesXmitCopyAvoided;     // Frames mapped from the NET_BUFFER SG list without copying
+    ULONG64  BytesXmitCopyAvoided;      // Bytes mapped from the NET_BUFFER SG list without copying
 } FRAME_TXD_STATUS,  *PFRAME_TXD_STATUS;
 
+// Adaptive interrupt moderation state of one direction (Rx or Tx)
+typedef struct _MP_INT_MODERATION
+{
+    ULONG    Level;                     // Current moderation level, 0 = coalescing disabled
+    ULONG    Interrupts;                // Interrupts in the current sampling period
+    ULONG    Frames;                    // Frames handled in the current sampling period
+    ULONG    InterruptRate;             // Interrupts per second in the last sampling period
+    ULONG    FrameRate;                 // Frames per second in the last sampling period
+    ULONG    LevelChanges;              // Number of moderation level changes
+} MP_INT_MODERATION, *PMP_INT_MODERATION;
+
 MINIPORT_ISR EnetIsr;
 MINIPORT_SYNCHRONIZE_INTERRUPT EnetEnableRxAndTxInterrupts;
 MINIPORT_SYNCHRONIZE_INTERRUPT EnetDisableRxAndTxInterrupts;
@@ -132,9 +209,12 @@ typedef struct _MP_ADAPTER MP_ADAPTER,*PMP_ADAPTER;
 
 // ENET hardware related functions
 void EnetInit  (_In_ PMP_ADAPTER pAdapter, _In_ MP_MDIO_PHY_INTERFACE_TYPE EnetPhyInterfaceType);
+void EnetProbeQueues(_In_ PMP_ADAPTER pAdapter);
 void EnetDeinit(_In_ PMP_ADAPTER pAdapter);
 void EnetStop  (_In_ PMP_ADAPTER pAdapter, _In_ NDIS_STATUS NdisStatus);
 void EnetStart (_In_ PMP_ADAPTER pAdapter);
+void EnetSetInterruptModeration(_In_ PMP_ADAPTER pAdapter, _In_ BOOLEAN Enable);
+void EnetUpdateInterruptModeration(_In_ PMP_ADAPTER pAdapter);
 
 // Multicast hash tables related functions
 void ClearAllMultiCast(_In_ PMP_ADAPTER Adapter);
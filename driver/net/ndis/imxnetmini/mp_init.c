@@ -64,8 +64,6 @@ NDIS_STATUS MpAllocAdapterBlock(PMP_ADAPTER *ppAdapter, NDIS_HANDLE MiniportAdap
         InitializeListHead(&pAdapter->PoMgmt.PatternList);
         NdisAllocateSpinLock(&pAdapter->Dev_SpinLock);
 
-        MpQueueInit(&pAdapter->Tx_qMpOwnedBDs);                // Initialize pending Tx Ethernet frames (NET_BUFFERs) queue
-        MpQueueInit(&pAdapter->Tx_qDmaOwnedBDs);               // Initialize in-progress Tx Ethernet frames (NET_BUFFERs) queue
         NdisAllocateSpinLock(&pAdapter->Tx_SpinLock);          // Initialize Tx path spin lock
         NdisAllocateSpinLock(&pAdapter->Rx_SpinLock);          // Initialize Rx path spin lock
 
@@ -100,143 +98,272 @@ NDIS_STATUS MpAllocAdapterBlock(PMP_ADAPTER *ppAdapter, NDIS_HANDLE MiniportAdap
 
 /*++
 Routine Description:
-    Allocate all the memory blocks for send, receive and others
+    Allocates the MDL and the NBL (and NB) of one Rx frame buffer.
+    ENET_RX_FRAME_SIZE buffers are allocated here, small copy break buffers (pBuffer != NULL) are provided by the caller.
 Arguments:
     pAdapter    Pointer to our adapter
+    pRxFrameBD  Rx frame buffer descriptor
+    BufferSize  Size of the frame buffer
 Return Value:
     NDIS_STATUS_SUCCESS
-    NDIS_STATUS_FAILURE
     NDIS_STATUS_RESOURCES
 --*/
-_Use_decl_annotations_
-NDIS_STATUS NICAllocAdapterMemory(PMP_ADAPTER pAdapter)
+static NDIS_STATUS NICAllocRxFrameBuffer(_In_ PMP_ADAPTER pAdapter, _Inout_ PMP_RX_FRAME_BD pRxFrameBD, _In_ ULONG BufferSize)
 {
-    NDIS_STATUS                     Status = NDIS_STATUS_SUCCESS;
-    PMP_TX_PAYLOAD_BD               pEnetSwExtBD;
-    LONG                            index;
-    NDIS_SG_DMA_DESCRIPTION         DmaDescription;
-    PUCHAR                          AllocVa;
-    NDIS_PHYSICAL_ADDRESS           AllocPa;
-    NET_BUFFER_LIST_POOL_PARAMETERS PoolParameters;
+    NDIS_STATUS             Status = NDIS_STATUS_SUCCESS;
 
-    DBG_ENET_DEV_METHOD_BEG();
     for(;;) {
-
-        // Initialize DMA system
-        NdisZeroMemory(&DmaDescription, sizeof(DmaDescription));
-        DmaDescription.Header.Type                      = NDIS_OBJECT_TYPE_SG_DMA_DESCRIPTION;
-        DmaDescription.Header.Revision                  = NDIS_SG_DMA_DESCRIPTION_REVISION_1;
-        DmaDescription.Header.Size                      = sizeof(NDIS_SG_DMA_DESCRIPTION);
-        DmaDescription.Flags                            = 0;                    // we don't do 64 bit DMA
-        DmaDescription.MaximumPhysicalMapping           = ENET_TX_FRAME_SIZE;   // Even if offload is enabled, the packet size for mapping shouldn't change
-        DmaDescription.ProcessSGListHandler             = MpProcessSGList;      //
-        DmaDescription.SharedMemAllocateCompleteHandler = NULL;                 // ENET does not call NdisMAllocateSharedMemoryAsyncEx, hence no need for complete handler
-        if ((Status = NdisMRegisterScatterGatherDma(pAdapter->AdapterHandle, &DmaDescription, &pAdapter->Tx_DmaHandle)) == NDIS_STATUS_SUCCESS) {
-            pAdapter->Tx_SGListSize = DmaDescription.ScatterGatherListSize;
-        } else {
-            DBG_ENET_DEV_PRINT_ERROR_WITH_STATUS("NdisMRegisterScatterGatherDma() failed.");
+        if (pRxFrameBD->pBuffer == NULL) {
+            #if 0 //MVa
+            NdisMAllocateSharedMemory(pAdapter->AdapterHandle, pAdapter->ENET_RX_FRAME_SIZE, TRUE, &pRxFrameBD->pBuffer, &pRxFrameBD->BufferPa);
+            if (pRxFrameBD->pBuffer == NULL) {
+                DBG_PRINT_ERROR(ZONE_INIT, "Failed to allocate memory for ENET receive buffer descriptor.");
+                Status = NDIS_STATUS_RESOURCES;
+                break;
+            #endif
+            { // MS-temp fix begin
+                #pragma prefast(disable:30030, "Temporary fix")
+                PHYSICAL_ADDRESS highestAcceptableAddress; highestAcceptableAddress.QuadPart = (LONGLONG)-1;
+                PHYSICAL_ADDRESS lowestAcceptableAddress; lowestAcceptableAddress.QuadPart = 0;
+                PHYSICAL_ADDRESS boundaryAddress; boundaryAddress.QuadPart = 0;
+                pRxFrameBD->pBuffer = (PUCHAR)MmAllocateContiguousMemorySpecifyCache(ENET_RX_FRAME_SIZE,lowestAcceptableAddress,highestAcceptableAddress,boundaryAddress,MmCached);
+                if (pRxFrameBD->pBuffer == NULL) {
+                    DBG_ENET_DEV_PRINT_ERROR_WITH_STATUS("MmAllocateContiguousMemorySpecifyCache() failed to allocate memory for receive buffer.");
+                    Status = NDIS_STATUS_RESOURCES;
+                    break;
+                }
+                pRxFrameBD->BufferPa = MmGetPhysicalAddress(pRxFrameBD->pBuffer);
+            } // MS-temp fix end
+        }
+        // Allocate MDL
+        if ((pRxFrameBD->pMdl = NdisAllocateMdl(pAdapter->AdapterHandle, pRxFrameBD->pBuffer, BufferSize)) == NULL) {
+            Status = NDIS_STATUS_RESOURCES;
+            DBG_ENET_DEV_PRINT_ERROR_WITH_STATUS("NdisAllocateMdl() failed to allocate Mdl for receive buffer.");
             break;
         }
-        pAdapter->CacheFillSize = NdisMGetDmaAlignment(pAdapter->AdapterHandle);
+        // Allocate NBL and NB
+        if ((pRxFrameBD->pNBL = NdisAllocateNetBufferAndNetBufferList(pAdapter->Rx_NBAndNBLPool, 0, 0, pRxFrameBD->pMdl, 2, 0)) == NULL) {
+            Status = NDIS_STATUS_RESOURCES;
+            DBG_ENET_DEV_PRINT_ERROR_WITH_STATUS("NdisAllocateNetBufferAndNetBufferList() failed to allocate NBL and NB for receive buffer.");
+            break;
+        }
+        MP_NBL_SET_RX_FRAME_BD(pRxFrameBD->pNBL, pRxFrameBD);       // Associate NBL and payload buffer descriptor
+        break;
+    }
+    return Status;
+}
 
-        //  Allocates a pool of NBL(and NB) structures for Rx path. Each allocated NBL structure is initialized with one NB structure.
-        NdisZeroMemory(&PoolParameters, sizeof(NET_BUFFER_LIST_POOL_PARAMETERS));
-        PoolParameters.Header.Type        = NDIS_OBJECT_TYPE_DEFAULT;
-        PoolParameters.Header.Revision    = NET_BUFFER_LIST_POOL_PARAMETERS_REVISION_1;
-        PoolParameters.Header.Size        = sizeof(PoolParameters);
-        PoolParameters.fAllocateNetBuffer = TRUE;                     // Allocate one NB for each NBL
-        // PoolParameters.DataSize        = 0;                        // Do not allocate data buffer
-        // PoolParameters.ProtocolId      = NDIS_PROTOCOL_ID_DEFAULT; // NDIS_PROTOCOL_ID_DEFAULT = 0;
-        PoolParameters.PoolTag            = MP_TAG_TX_NBL_AND_NB;
-        pAdapter->Rx_NBAndNBLPool         = NdisAllocateNetBufferListPool(pAdapter->AdapterHandle,&PoolParameters);
-        if (pAdapter->Rx_NBAndNBLPool == NULL)  {
+/*++
+Routine Description:
+    Frees the MDL, the NBL and the ENET_RX_FRAME_SIZE buffer of one Rx frame buffer.
+Arguments:
+    pRxFrameBD  Rx frame buffer descriptor
+Return Value:
+    None
+--*/
+static void NICFreeRxFrameBuffer(_In_ PMP_RX_FRAME_BD pRxFrameBD)
+{
+    if (pRxFrameBD->pMdl != NULL) {
+        NdisFreeMdl(pRxFrameBD->pMdl);
+    }
+    if (pRxFrameBD->pNBL != NULL) {
+        NdisFreeNetBufferList(pRxFrameBD->pNBL);
+    }
+    if ((pRxFrameBD->pBuffer != NULL) && !pRxFrameBD->IsCopyBuffer) {
+        // MVa NdisMFreeSharedMemory(pAdapter->AdapterHandle, ENET_RX_FRAME_SIZE, TRUE, pRxFrameBD->pBuffer, pRxFrameBD->BufferPa);
+        /* MS temp fix*/ MmFreeContiguousMemory(pRxFrameBD->pBuffer);
+    }
+}
+
+/*++
+Routine Description:
+    Allocates the Rx buffer pools shared by all ENET Rx rings:
+    - The spare ENET_RX_FRAME_SIZE buffers. A spare buffer refills the ENET_RxBD whose buffer has been indicated to NDIS,
+      so the ring does not run dry while NDIS holds the indicated buffers.
+    - The small copy break buffers. Short frames are copied to them and the ENET_RxBD buffer is reposted immediately.
+Arguments:
+    pAdapter    Pointer to our adapter
+Return Value:
+    NDIS_STATUS_SUCCESS
+    NDIS_STATUS_RESOURCES
+--*/
+static NDIS_STATUS NICAllocRxPoolMemory(_In_ PMP_ADAPTER pAdapter)
+{
+    NDIS_STATUS             Status = NDIS_STATUS_SUCCESS;
+    ULONG                   Size;
+
+    for(;;) {
+        // Allocate spare Rx frame buffers
+        pAdapter->Rx_SpareFrameBDT_ItemCount = (pAdapter->Rx_DmaBDT_ItemCount * MAC_RX_SPARE_BUFFER_PERCENT) / 100;
+        Size = sizeof(MP_RX_FRAME_BD) * pAdapter->Rx_SpareFrameBDT_ItemCount;
+        if (Size != 0) {
+            if ((pAdapter->Rx_SpareFrameBDT = NdisAllocateMemoryWithTagPriority(pAdapter->AdapterHandle, Size, MP_TAG_RX_PAYLOAD_DESC, NormalPoolPriority)) == NULL) {
+                Status = NDIS_STATUS_RESOURCES;
+                DBG_ENET_DEV_PRINT_ERROR_WITH_STATUS("NdisAllocateMemoryWithTagPriority() failed to allocated RX spare frame descriptors table.");
+                break;
+            }
+            NdisZeroMemory(pAdapter->Rx_SpareFrameBDT, Size);
+            for (LONG RxBuffIdx = 0; RxBuffIdx < pAdapter->Rx_SpareFrameBDT_ItemCount; ++RxBuffIdx) {
+                if ((Status = NICAllocRxFrameBuffer(pAdapter, &pAdapter->Rx_SpareFrameBDT[RxBuffIdx], ENET_RX_FRAME_SIZE)) != NDIS_STATUS_SUCCESS) {
+                    break;
+                }
+            }
+            if (Status != NDIS_STATUS_SUCCESS) {
+                break;
+            }
+        }
+        // Allocate small copy break Rx buffers, they are never accessed by ENET DMA
+        Size = sizeof(MP_RX_FRAME_BD) * ENET_RX_COPY_BUFFER_COUNT;
+        if ((pAdapter->Rx_CopyFrameBDT = NdisAllocateMemoryWithTagPriority(pAdapter->AdapterHandle, Size, MP_TAG_RX_PAYLOAD_DESC, NormalPoolPriority)) == NULL) {
+            Status = NDIS_STATUS_RESOURCES;
+            DBG_ENET_DEV_PRINT_ERROR_WITH_STATUS("NdisAllocateMemoryWithTagPriority() failed to allocated RX copy frame descriptors table.");
+            break;
+        }
+        NdisZeroMemory(pAdapter->Rx_CopyFrameBDT, Size);
+        if ((pAdapter->Rx_CopyBuffer_Va = NdisAllocateMemoryWithTagPriority(pAdapter->AdapterHandle, ENET_RX_COPY_BUFFER_COUNT * ENET_RX_COPY_BUFFER_SIZE, MP_TAG_RX_PAYLOAD_DESC, NormalPoolPriority)) == NULL) {
             Status = NDIS_STATUS_RESOURCES;
+            DBG_ENET_DEV_PRINT_ERROR_WITH_STATUS("NdisAllocateMemoryWithTagPriority() failed to allocated RX copy buffers.");
             break;
         }
+        for (LONG RxBuffIdx = 0; RxBuffIdx < ENET_RX_COPY_BUFFER_COUNT; ++RxBuffIdx) {
+            MP_RX_FRAME_BD *pRxFrameBD = &pAdapter->Rx_CopyFrameBDT[RxBuffIdx];
+            pRxFrameBD->IsCopyBuffer = TRUE;
+            pRxFrameBD->pBuffer      = pAdapter->Rx_CopyBuffer_Va + RxBuffIdx * ENET_RX_COPY_BUFFER_SIZE;
+            if ((Status = NICAllocRxFrameBuffer(pAdapter, pRxFrameBD, ENET_RX_COPY_BUFFER_SIZE)) != NDIS_STATUS_SUCCESS) {
+                break;
+            }
+        }
+        break;
+    }
+    return Status;
+}
 
-        // Initialize Tx Lookaside lists
-        NdisInitializeNPagedLookasideList(&pAdapter->Tx_MpTxBDLookasideList, NULL, NULL, 0, sizeof(MP_TX_BD) - sizeof(SCATTER_GATHER_LIST) + pAdapter->Tx_SGListSize, MP_TAG_TX_BD, 0);
+/*++
+Routine Description:
+    Frees the spare and the small copy break Rx buffer pools.
+Arguments:
+    pAdapter    Pointer to our adapter
+Return Value:
+    None
+--*/
+static void NICFreeRxPoolMemory(_In_ PMP_ADAPTER pAdapter)
+{
+    if (pAdapter->Rx_SpareFrameBDT != NULL) {
+        for (LONG RxBuffIdx = 0; RxBuffIdx < pAdapter->Rx_SpareFrameBDT_ItemCount; ++RxBuffIdx) {
+            NICFreeRxFrameBuffer(&pAdapter->Rx_SpareFrameBDT[RxBuffIdx]);
+        }
+        NdisFreeMemory(pAdapter->Rx_SpareFrameBDT, 0, 0);
+        pAdapter->Rx_SpareFrameBDT = NULL;
+    }
+    if (pAdapter->Rx_CopyFrameBDT != NULL) {
+        for (LONG RxBuffIdx = 0; RxBuffIdx < ENET_RX_COPY_BUFFER_COUNT; ++RxBuffIdx) {
+            NICFreeRxFrameBuffer(&pAdapter->Rx_CopyFrameBDT[RxBuffIdx]);
+        }
+        NdisFreeMemory(pAdapter->Rx_CopyFrameBDT, 0, 0);
+        pAdapter->Rx_CopyFrameBDT = NULL;
+    }
+    if (pAdapter->Rx_CopyBuffer_Va != NULL) {
+        NdisFreeMemory(pAdapter->Rx_CopyBuffer_Va, 0, 0);
+        pAdapter->Rx_CopyBuffer_Va = NULL;
+    }
+}
 
-        pAdapter->Rx_DmaBDT_DmaOwnedBDsLowWatterMark = (pAdapter->Rx_DmaBDT_ItemCount * MAC_RX_BUFFER_LOW_WATER_PERCENT) / 100;
+/*++
+Routine Description:
+    Allocates the buffer descriptor tables and data buffers of one ENET Rx and Tx ring.
+    The best effort ring (0) uses the registry ring sizes, the AVB class rings are limited to ENET_CLASS_QUEUE_xX_DESC_COUNT BDs.
+Arguments:
+    pAdapter    Pointer to our adapter
+    QueueIdx    ENET ring index
+Return Value:
+    NDIS_STATUS_SUCCESS
+    NDIS_STATUS_RESOURCES
+--*/
+static NDIS_STATUS NICAllocQueueMemory(_In_ PMP_ADAPTER pAdapter, _In_ ULONG QueueIdx)
+{
+    volatile CSP_ENET_REGS *ENETRegBase = pAdapter->ENETRegBase;
+    MP_RX_QUEUE            *pRxQueue = &pAdapter->Rx_Queue[QueueIdx];
+    MP_TX_QUEUE            *pTxQueue = &pAdapter->Tx_Queue[QueueIdx];
+    NDIS_STATUS             Status = NDIS_STATUS_SUCCESS;
+    PMP_TX_PAYLOAD_BD       pEnetSwExtBD;
+    LONG                    index;
+    PUCHAR                  AllocVa;
+    NDIS_PHYSICAL_ADDRESS   AllocPa;
+
+    pRxQueue->QueueIdx = QueueIdx;
+    pTxQueue->QueueIdx = QueueIdx;
+    switch (QueueIdx) {
+        case 1:
+            pRxQueue->pRDAR = &ENETRegBase->RDAR1;
+            pTxQueue->pTDAR = &ENETRegBase->TDAR1;
+            break;
+        case 2:
+            pRxQueue->pRDAR = &ENETRegBase->RDAR2;
+            pTxQueue->pTDAR = &ENETRegBase->TDAR2;
+            break;
+        default:
+            pRxQueue->pRDAR = &ENETRegBase->RDAR;
+            pTxQueue->pTDAR = &ENETRegBase->TDAR;
+            break;
+    }
+    pRxQueue->DmaBDT_ItemCount = pAdapter->Rx_DmaBDT_ItemCount;
+    pTxQueue->DmaBDT_ItemCount = pAdapter->Tx_DmaBDT_ItemCount;
+    if (QueueIdx != 0) {
+        pRxQueue->DmaBDT_ItemCount = min(pRxQueue->DmaBDT_ItemCount, ENET_CLASS_QUEUE_RX_DESC_COUNT);
+        pTxQueue->DmaBDT_ItemCount = min(pTxQueue->DmaBDT_ItemCount, ENET_CLASS_QUEUE_TX_DESC_COUNT);
+    }
+    for(;;) {
+        pRxQueue->DmaBDT_DmaOwnedBDsLowWatterMark = (pRxQueue->DmaBDT_ItemCount * MAC_RX_BUFFER_LOW_WATER_PERCENT) / 100;
 
         /* ************************************************************************************************************************************ */
         /* Allocated memory for ENET DMA Receive Descriptors Table(Rx_DmaBDT). Note: This memory must be 8 bytes aligned!                       */
         /* ************************************************************************************************************************************ */
-        pAdapter->Rx_DmaBDT_Size = pAdapter->Rx_DmaBDT_ItemCount * sizeof(ENET_BD);
-        NdisMAllocateSharedMemory(pAdapter->AdapterHandle, pAdapter->Rx_DmaBDT_Size, FALSE, (PVOID) &pAdapter->Rx_DmaBDT, &pAdapter->Rx_DmaBDT_Pa);
-        ASSERT(!((uintptr_t)pAdapter->Rx_DmaBDT & 0x7));   // This memory must be 8 bytes aligned!
-        if (!pAdapter->Rx_DmaBDT) {
+        pRxQueue->DmaBDT_Size = pRxQueue->DmaBDT_ItemCount * pAdapter->DmaBDSize;
+        NdisMAllocateSharedMemory(pAdapter->AdapterHandle, pRxQueue->DmaBDT_Size, FALSE, (PVOID) &pRxQueue->DmaBDT, &pRxQueue->DmaBDT_Pa);
+        ASSERT(!((uintptr_t)pRxQueue->DmaBDT & 0x7));   // This memory must be 8 bytes aligned!
+        if (!pRxQueue->DmaBDT) {
             Status = NDIS_STATUS_RESOURCES;
             DBG_ENET_DEV_PRINT_ERROR_WITH_STATUS("NdisMAllocateSharedMemory() failed to allocate memory for Rx_DmaBDT.");
             break;
         }
-        NdisZeroMemory((PVOID)pAdapter->Rx_DmaBDT, pAdapter->Rx_DmaBDT_Size);
+        NdisZeroMemory((PVOID)pRxQueue->DmaBDT, pRxQueue->DmaBDT_Size);
 
         /* ************************************************************************************************************************************ */
         /* Allocated memory for ENET DMA Transmit Descriptors Table(Tx_DmaBDT). Note: This memory must be 8 bytes aligned!                      */
         /* ************************************************************************************************************************************ */
-        pAdapter->Tx_DmaBDT_Size = pAdapter->Tx_DmaBDT_ItemCount * sizeof(ENET_BD);
-        NdisMAllocateSharedMemory(pAdapter->AdapterHandle, pAdapter->Tx_DmaBDT_Size, FALSE, (PVOID) &pAdapter->Tx_DmaBDT, &pAdapter->Tx_DmaBDT_Pa);
-        ASSERT(!((uintptr_t)pAdapter->Tx_DmaBDT & 0x7));   // This memory must be 8 bytes aligned!
-        if (!pAdapter->Tx_DmaBDT) {
+        pTxQueue->DmaBDT_Size = pTxQueue->DmaBDT_ItemCount * pAdapter->DmaBDSize;
+        NdisMAllocateSharedMemory(pAdapter->AdapterHandle, pTxQueue->DmaBDT_Size, FALSE, (PVOID) &pTxQueue->DmaBDT, &pTxQueue->DmaBDT_Pa);
+        ASSERT(!((uintptr_t)pTxQueue->DmaBDT & 0x7));   // This memory must be 8 bytes aligned!
+        if (!pTxQueue->DmaBDT) {
             Status = NDIS_STATUS_RESOURCES;
             DBG_ENET_DEV_PRINT_ERROR_WITH_STATUS("NdisMAllocateSharedMemory() failed to allocate memory for Tx_DmaBDT.");
             break;
         }
-        NdisZeroMemory((PVOID)pAdapter->Tx_DmaBDT, pAdapter->Tx_DmaBDT_Size);
+        NdisZeroMemory((PVOID)pTxQueue->DmaBDT, pTxQueue->DmaBDT_Size);
 
         // Allocate RX DMA SW extension buffer descriptors array.
-        ULONG Rx_DmaBDT_SwExtSize =  sizeof(PMP_RX_FRAME_BD) * pAdapter->Rx_DmaBDT_ItemCount;
-        if ((pAdapter->Rx_DmaBDT_SwExt = NdisAllocateMemoryWithTagPriority(pAdapter->AdapterHandle, Rx_DmaBDT_SwExtSize, MP_TAG_RX_PAYLOAD_DESC, NormalPoolPriority)) == NULL) {
+        ULONG Rx_DmaBDT_SwExtSize =  sizeof(PMP_RX_FRAME_BD) * pRxQueue->DmaBDT_ItemCount;
+        if ((pRxQueue->DmaBDT_SwExt = NdisAllocateMemoryWithTagPriority(pAdapter->AdapterHandle, Rx_DmaBDT_SwExtSize, MP_TAG_RX_PAYLOAD_DESC, NormalPoolPriority)) == NULL) {
             Status = NDIS_STATUS_RESOURCES;
             DBG_ENET_DEV_PRINT_ERROR_WITH_STATUS("NdisMAllocateSharedMemory() failed to allocated RX Dma SW extension descriptors table.");
             break;
         }
-        NdisZeroMemory(pAdapter->Rx_DmaBDT_SwExt, Rx_DmaBDT_SwExtSize);
+        NdisZeroMemory(pRxQueue->DmaBDT_SwExt, Rx_DmaBDT_SwExtSize);
         // Allocate RX frame buffer descriptors array.
-        ULONG Rx_FrameBDTSize =  sizeof(MP_RX_FRAME_BD) * pAdapter->Rx_DmaBDT_ItemCount;
-        if ((pAdapter->Rx_FrameBDT = NdisAllocateMemoryWithTagPriority(pAdapter->AdapterHandle, Rx_FrameBDTSize, MP_TAG_RX_PAYLOAD_DESC, NormalPoolPriority)) == NULL) {
+        ULONG Rx_FrameBDTSize =  sizeof(MP_RX_FRAME_BD) * pRxQueue->DmaBDT_ItemCount;
+        if ((pRxQueue->FrameBDT = NdisAllocateMemoryWithTagPriority(pAdapter->AdapterHandle, Rx_FrameBDTSize, MP_TAG_RX_PAYLOAD_DESC, NormalPoolPriority)) == NULL) {
             Status = NDIS_STATUS_RESOURCES;
             DBG_ENET_DEV_PRINT_ERROR_WITH_STATUS("NdisAllocateMemoryWithTagPriority() failed to allocated RX frame descriptors table.");
             break;
         }
-        NdisZeroMemory(pAdapter->Rx_FrameBDT, Rx_FrameBDTSize);
+        NdisZeroMemory(pRxQueue->FrameBDT, Rx_FrameBDTSize);
         // Allocate RX frame date buffers. Allocate buffer memory, MDL, NBL, NB
-        for (LONG RxBuffIdx = 0; RxBuffIdx < pAdapter->Rx_DmaBDT_ItemCount; ++RxBuffIdx) {
-            MP_RX_FRAME_BD *pRxFrameBD = &pAdapter->Rx_FrameBDT[RxBuffIdx];
-            #if 0 //MVa
-            NdisMAllocateSharedMemory(pAdapter->AdapterHandle, pAdapter->ENET_RX_FRAME_SIZE, TRUE, &pRxFrameBD->pBuffer, &pRxFrameBD->BufferPa);
-            if (pRxFrameBD->pBuffer == NULL) {
-                DBG_PRINT_ERROR(ZONE_INIT, "Failed to allocate memory for ENET receive buffer descriptor.");
-                Status = NDIS_STATUS_RESOURCES;
-                break;
-            #endif
-            { // MS-temp fix begin
-                #pragma prefast(disable:30030, "Temporary fix")
-                PHYSICAL_ADDRESS highestAcceptableAddress; highestAcceptableAddress.QuadPart = (LONGLONG)-1;
-                PHYSICAL_ADDRESS lowestAcceptableAddress; lowestAcceptableAddress.QuadPart = 0;
-                PHYSICAL_ADDRESS boundaryAddress; boundaryAddress.QuadPart = 0;
-                pRxFrameBD->pBuffer = (PUCHAR)MmAllocateContiguousMemorySpecifyCache(ENET_RX_FRAME_SIZE,lowestAcceptableAddress,highestAcceptableAddress,boundaryAddress,MmCached);
-                if (pRxFrameBD->pBuffer == NULL) {
-                    DBG_ENET_DEV_PRINT_ERROR_WITH_STATUS("MmAllocateContiguousMemorySpecifyCache() failed to allocate memory for receive buffer.");
-                    Status = NDIS_STATUS_RESOURCES;
-                    break;
-                }
-                pRxFrameBD->BufferPa = MmGetPhysicalAddress(pRxFrameBD->pBuffer);
-            } // MS-temp fix end
-            // Allocate MDL
-            if ((pRxFrameBD->pMdl = NdisAllocateMdl(pAdapter->AdapterHandle, pRxFrameBD->pBuffer, ENET_RX_FRAME_SIZE)) == NULL) {
-                Status = NDIS_STATUS_RESOURCES;
-                DBG_ENET_DEV_PRINT_ERROR_WITH_STATUS("NdisAllocateMdl() failed to allocate Mdl for receive buffer.");
+        for (LONG RxBuffIdx = 0; RxBuffIdx < pRxQueue->DmaBDT_ItemCount; ++RxBuffIdx) {
+            MP_RX_FRAME_BD *pRxFrameBD = &pRxQueue->FrameBDT[RxBuffIdx];
+            if ((Status = NICAllocRxFrameBuffer(pAdapter, pRxFrameBD, ENET_RX_FRAME_SIZE)) != NDIS_STATUS_SUCCESS) {
                 break;
             }
-            // Allocate NBL and NB
-            if ((pRxFrameBD->pNBL = NdisAllocateNetBufferAndNetBufferList(pAdapter->Rx_NBAndNBLPool, 0, 0, pRxFrameBD->pMdl, 2, 0)) == NULL) {
-                Status = NDIS_STATUS_RESOURCES;
-                DBG_ENET_DEV_PRINT_ERROR_WITH_STATUS("NdisAllocateNetBufferAndNetBufferList() failed to allocate NBL and NB for receive buffer.");
-                break;
-            }
-            MP_NBL_SET_RX_FRAME_BD(pRxFrameBD->pNBL, pRxFrameBD);       // Associate NBL and payload buffer descriptor
+            pRxFrameBD->pRxQueue = pRxQueue;
         }
         if (Status != NDIS_STATUS_SUCCESS) {
             break;
@@ -245,18 +372,18 @@ NDIS_STATUS NICAllocAdapterMemory(PMP_ADAPTER pAdapter)
         /* ************************************************************************************************************************************ */
         // Allocate memory for tx Ethernet frames
         /* ************************************************************************************************************************************ */
-        pAdapter->Tx_DataBuffer_Size = pAdapter->Tx_DmaBDT_ItemCount * (ENET_TX_FRAME_SIZE/*+ pAdapter->CacheFillSize*/ );
-        NdisMAllocateSharedMemory(pAdapter->AdapterHandle, pAdapter->Tx_DataBuffer_Size, TRUE, &pAdapter->Tx_DataBuffer_Va, &pAdapter->Tx_DataBuffer_Pa);
-        if (pAdapter->Tx_DataBuffer_Va == NULL) {
+        pTxQueue->DataBuffer_Size = pTxQueue->DmaBDT_ItemCount * (ENET_TX_FRAME_SIZE/*+ pAdapter->CacheFillSize*/ );
+        NdisMAllocateSharedMemory(pAdapter->AdapterHandle, pTxQueue->DataBuffer_Size, TRUE, &pTxQueue->DataBuffer_Va, &pTxQueue->DataBuffer_Pa);
+        if (pTxQueue->DataBuffer_Va == NULL) {
             Status = NDIS_STATUS_RESOURCES;
             DBG_ENET_DEV_PRINT_ERROR_WITH_STATUS("NdisMAllocateSharedMemory() failed to allocate a big Tx data buffer");
             break;
         }
         // For each Tx buffer initialize buffer description
-        AllocVa = pAdapter->Tx_DataBuffer_Va;
-        AllocPa = pAdapter->Tx_DataBuffer_Pa;
-        for (index = 0; index < pAdapter->Tx_DmaBDT_ItemCount; index++) {
-            pEnetSwExtBD = &pAdapter->Tx_EnetSwExtBDT[index];
+        AllocVa = pTxQueue->DataBuffer_Va;
+        AllocPa = pTxQueue->DataBuffer_Pa;
+        for (index = 0; index < pTxQueue->DmaBDT_ItemCount; index++) {
+            pEnetSwExtBD = &pTxQueue->EnetSwExtBDT[index];
             pEnetSwExtBD->BufferSize        = ENET_TX_FRAME_SIZE;
             pEnetSwExtBD->pBuffer           = MP_ALIGNMEM(AllocVa, pAdapter->CacheFillSize); // Align the buffer on the cache line boundary
             pEnetSwExtBD->BufferPa.QuadPart = MP_ALIGNMEM_PA(AllocPa, pAdapter->CacheFillSize);
@@ -272,6 +399,124 @@ NDIS_STATUS NICAllocAdapterMemory(PMP_ADAPTER pAdapter)
         }
         break;
     }
+    return Status;
+}
+
+/*++
+Routine Description:
+    Frees the buffer descriptor tables and data buffers of one ENET Rx and Tx ring.
+Arguments:
+    pAdapter    Pointer to our adapter
+    QueueIdx    ENET ring index
+Return Value:
+    None
+--*/
+static void NICFreeQueueMemory(_In_ PMP_ADAPTER pAdapter, _In_ ULONG QueueIdx)
+{
+    MP_RX_QUEUE            *pRxQueue = &pAdapter->Rx_Queue[QueueIdx];
+    MP_TX_QUEUE            *pTxQueue = &pAdapter->Tx_Queue[QueueIdx];
+
+    for (int i = 0; i < TX_DESC_COUNT_MAX; i++) { // Free all Tx packet buffer MDL
+        if (pTxQueue->EnetSwExtBDT[i].pMdl != NULL) {
+             NdisFreeMdl(pTxQueue->EnetSwExtBDT[i].pMdl);
+             pTxQueue->EnetSwExtBDT[i].pMdl = NULL;
+        }
+    }
+    if (pTxQueue->DataBuffer_Va != NULL)  { // Free Tx packets memory
+        NdisMFreeSharedMemory(pAdapter->AdapterHandle, pTxQueue->DataBuffer_Size, TRUE, pTxQueue->DataBuffer_Va, pTxQueue->DataBuffer_Pa);
+        pTxQueue->DataBuffer_Va = NULL;
+    }
+    if (pTxQueue->DmaBDT) { // Free Tx_DmaBDT
+        NdisMFreeSharedMemory(pAdapter->AdapterHandle, pTxQueue->DmaBDT_Size, FALSE, (PVOID)pTxQueue->DmaBDT, pTxQueue->DmaBDT_Pa);
+        pTxQueue->DmaBDT = NULL;
+    }
+    if (pRxQueue->DmaBDT) { // Free ENET Rx_DmaBDT
+        NdisMFreeSharedMemory(pAdapter->AdapterHandle, pRxQueue->DmaBDT_Size, FALSE, (PVOID)pRxQueue->DmaBDT, pRxQueue->DmaBDT_Pa);
+        pRxQueue->DmaBDT = NULL;
+    }
+    // Free Rx_DmaBDT_SwExt
+    if (pRxQueue->DmaBDT_SwExt != NULL) {
+        NdisFreeMemory(pRxQueue->DmaBDT_SwExt, 0, 0);
+        pRxQueue->DmaBDT_SwExt = NULL;
+    }
+    // Free RX payload buffer descriptors
+    if (pRxQueue->FrameBDT != NULL) {
+        for (LONG RxBuffIdx = 0; RxBuffIdx < pRxQueue->DmaBDT_ItemCount; ++RxBuffIdx) {
+            NICFreeRxFrameBuffer(&pRxQueue->FrameBDT[RxBuffIdx]);
+        }
+        NdisFreeMemory(pRxQueue->FrameBDT, 0, 0);
+        pRxQueue->FrameBDT = NULL;
+    }
+}
+
+/*++
+Routine Description:
+    Allocate all the memory blocks for send, receive and others
+Arguments:
+    pAdapter    Pointer to our adapter
+Return Value:
+    NDIS_STATUS_SUCCESS
+    NDIS_STATUS_FAILURE
+    NDIS_STATUS_RESOURCES
+--*/
+_Use_decl_annotations_
+NDIS_STATUS NICAllocAdapterMemory(PMP_ADAPTER pAdapter)
+{
+    NDIS_STATUS                     Status = NDIS_STATUS_SUCCESS;
+    NDIS_SG_DMA_DESCRIPTION         DmaDescription;
+    NET_BUFFER_LIST_POOL_PARAMETERS PoolParameters;
+
+    DBG_ENET_DEV_METHOD_BEG();
+    for(;;) {
+
+        // Initialize DMA system
+        NdisZeroMemory(&DmaDescription, sizeof(DmaDescription));
+        DmaDescription.Header.Type                      = NDIS_OBJECT_TYPE_SG_DMA_DESCRIPTION;
+        DmaDescription.Header.Revision                  = NDIS_SG_DMA_DESCRIPTION_REVISION_1;
+        DmaDescription.Header.Size                      = sizeof(NDIS_SG_DMA_DESCRIPTION);
+        DmaDescription.Flags                            = 0;                    // we don't do 64 bit DMA
+        DmaDescription.MaximumPhysicalMapping           = ENET_TX_FRAME_SIZE;   // Even if offload is enabled, the packet size for mapping shouldn't change
+        DmaDescription.ProcessSGListHandler             = MpProcessSGList;      //
+        DmaDescription.SharedMemAllocateCompleteHandler = NULL;                 // ENET does not call NdisMAllocateSharedMemoryAsyncEx, hence no need for complete handler
+        if ((Status = NdisMRegisterScatterGatherDma(pAdapter->AdapterHandle, &DmaDescription, &pAdapter->Tx_DmaHandle)) == NDIS_STATUS_SUCCESS) {
+            pAdapter->Tx_SGListSize = DmaDescription.ScatterGatherListSize;
+        } else {
+            DBG_ENET_DEV_PRINT_ERROR_WITH_STATUS("NdisMRegisterScatterGatherDma() failed.");
+            break;
+        }
+        pAdapter->CacheFillSize = NdisMGetDmaAlignment(pAdapter->AdapterHandle);
+
+        //  Allocates a pool of NBL(and NB) structures for Rx path. Each allocated NBL structure is initialized with one NB structure.
+        NdisZeroMemory(&PoolParameters, sizeof(NET_BUFFER_LIST_POOL_PARAMETERS));
+        PoolParameters.Header.Type        = NDIS_OBJECT_TYPE_DEFAULT;
+        PoolParameters.Header.Revision    = NET_BUFFER_LIST_POOL_PARAMETERS_REVISION_1;
+        PoolParameters.Header.Size        = sizeof(PoolParameters);
+        PoolParameters.fAllocateNetBuffer = TRUE;                     // Allocate one NB for each NBL
+        // PoolParameters.DataSize        = 0;                        // Do not allocate data buffer
+        // PoolParameters.ProtocolId      = NDIS_PROTOCOL_ID_DEFAULT; // NDIS_PROTOCOL_ID_DEFAULT = 0;
+        PoolParameters.PoolTag            = MP_TAG_TX_NBL_AND_NB;
+        pAdapter->Rx_NBAndNBLPool         = NdisAllocateNetBufferListPool(pAdapter->AdapterHandle,&PoolParameters);
+        if (pAdapter->Rx_NBAndNBLPool == NULL)  {
+            Status = NDIS_STATUS_RESOURCES;
+            break;
+        }
+
+        // Initialize Tx Lookaside lists
+        NdisInitializeNPagedLookasideList(&pAdapter->Tx_MpTxBDLookasideList, NULL, NULL, 0, sizeof(MP_TX_BD) - sizeof(SCATTER_GATHER_LIST) + pAdapter->Tx_SGListSize, MP_TAG_TX_BD, 0);
+
+        // Allocate Rx and Tx rings
+        for (ULONG QueueIdx = 0; QueueIdx < pAdapter->QueueCount; QueueIdx++) {
+            if ((Status = NICAllocQueueMemory(pAdapter, QueueIdx)) != NDIS_STATUS_SUCCESS) {
+                break;
+            }
+        }
+        if (Status != NDIS_STATUS_SUCCESS) {
+            break;
+        }
+        // Allocate spare and copy break Rx buffers
+        Status = NICAllocRxPoolMemory(pAdapter);
+        break;
+    }
     DBG_ENET_DEV_METHOD_END_WITH_STATUS(Status);
     return Status;
 }
@@ -292,6 +537,8 @@ void MpFreeAdapter(PMP_ADAPTER  pAdapter)
     ASSERT(NDIS_CURRENT_IRQL() == PASSIVE_LEVEL);
 
     if (pAdapter) {
+        MpPtpDeregisterDevice(pAdapter);                   // Close the IEEE 1588 clock control device and stop the clock
+        MpPtpDeinit(pAdapter);
         // Free hardware resources
 
         if (pAdapter->NdisInterruptHandle)  {
@@ -303,50 +550,10 @@ void MpFreeAdapter(PMP_ADAPTER  pAdapter)
 
         MDIODev_DeinitDevice(&pAdapter->ENETDev_MDIODevice);
 
-        for (int i = 0; i < pAdapter->Tx_DmaBDT_ItemCount; i++) { // Free all Tx packet buffer MDL
-            if (pAdapter->Tx_EnetSwExtBDT[i].pMdl != NULL) {
-                 NdisFreeMdl(pAdapter->Tx_EnetSwExtBDT[i].pMdl);
-                 pAdapter->Tx_EnetSwExtBDT[i].pMdl = NULL;
-            }
-        }
-        if (pAdapter->Tx_DataBuffer_Va != NULL)  { // Free Tx packets memory
-            NdisMFreeSharedMemory(pAdapter->AdapterHandle, pAdapter->Tx_DataBuffer_Size, TRUE, pAdapter->Tx_DataBuffer_Va, pAdapter->Tx_DataBuffer_Pa);
-            pAdapter->Tx_DataBuffer_Va = NULL;
-        }
-        if (pAdapter->Tx_DmaBDT) { // Free Tx_DmaBDT
-            NdisMFreeSharedMemory(pAdapter->AdapterHandle, pAdapter->Tx_DmaBDT_Size, FALSE, (PVOID)pAdapter->Tx_DmaBDT, pAdapter->Tx_DmaBDT_Pa);
-            pAdapter->Tx_DmaBDT = NULL;
-        }
-        if (pAdapter->Rx_DmaBDT) { // Free ENET Rx_DmaBDT
-            NdisMFreeSharedMemory(pAdapter->AdapterHandle, pAdapter->Rx_DmaBDT_Size, FALSE, (PVOID)pAdapter->Rx_DmaBDT, pAdapter->Rx_DmaBDT_Pa);
-            pAdapter->Rx_DmaBDT = NULL;
-        }
-        // Free Rx_DmaBDT_SwExt
-        if (pAdapter->Rx_DmaBDT_SwExt != NULL) {
-            NdisFreeMemory(pAdapter->Rx_DmaBDT_SwExt, 0, 0);
-            pAdapter->Rx_DmaBDT_SwExt = NULL;
-        }
-        // Free RX payload buffer descriptors
-        if (pAdapter->Rx_FrameBDT != NULL) {
-            for (LONG RxBuffIdx = 0; RxBuffIdx < pAdapter->Rx_DmaBDT_ItemCount; ++RxBuffIdx) {
-                MP_RX_FRAME_BD *pRxFrameBD = &pAdapter->Rx_FrameBDT[RxBuffIdx];
-                if (pRxFrameBD != NULL) {
-                    if (pRxFrameBD->pMdl != NULL) {
-                        NdisFreeMdl(pRxFrameBD->pMdl);
-                    }
-                    if (pRxFrameBD->pNBL != NULL) {
-                        NdisFreeNetBufferList(pRxFrameBD->pNBL);
-                    }
-                    if (pRxFrameBD->pBuffer != NULL) {
-                        // MVa NdisMFreeSharedMemory(pAdapter->AdapterHandle, ENET_RX_FRAME_SIZE, TRUE, pRxFrameBD->pBuffer, pRxFrameBD->BufferPa);
-                        /* MS temp fix*/ MmFreeContiguousMemory(pRxFrameBD->pBuffer);
-                    }
-                }
-            }
-            NdisFreeMemory(pAdapter->Rx_FrameBDT, 0, 0);
-            pAdapter->Rx_FrameBDT = NULL;
-
+        for (ULONG QueueIdx = 0; QueueIdx < ENET_QUEUE_COUNT_MAX; QueueIdx++) {  // Free all Rx and Tx rings
+            NICFreeQueueMemory(pAdapter, QueueIdx);
         }
+        NICFreeRxPoolMemory(pAdapter);
         // Free NB and NBL pool
         if (pAdapter->Rx_NBAndNBLPool) {
             NdisFreeNetBufferListPool(pAdapter->Rx_NBAndNBLPool);
@@ -412,6 +619,94 @@ NDIS_STATUS NICReadRegParameters(PMP_ADAPTER pAdapter)
             SPEED_SELECT_MIN,
             SPEED_SELECT_MAX
         },
+        {
+            NDIS_STRING_CONST("*InterruptModeration"),
+            MP_OFFSET(InterruptModeration),
+            MP_SIZE(InterruptModeration),
+            INTERRUPT_MODERATION_DEFAULT,
+            0,
+            1
+        },
+        {
+            NDIS_STRING_CONST("EnhancedBufferDescriptors"),
+            MP_OFFSET(EnhancedBDs),
+            MP_SIZE(EnhancedBDs),
+            ENHANCED_BDS_DEFAULT,
+            0,
+            1
+        },
+        {
+            NDIS_STRING_CONST("PriorityQueues"),
+            MP_OFFSET(PriorityQueues),
+            MP_SIZE(PriorityQueues),
+            PRIORITY_QUEUES_DEFAULT,
+            0,
+            1
+        },
+        {
+            NDIS_STRING_CONST("*PtpHardwareTimestamp"),
+            MP_OFFSET(PtpHardwareTimestamp),
+            MP_SIZE(PtpHardwareTimestamp),
+            PTP_HARDWARE_TIMESTAMP_DEFAULT,
+            0,
+            1
+        },
+        {
+            NDIS_STRING_CONST("PtpClockFrequency"),
+            MP_OFFSET(Ptp.ClockFrequencyHz),
+            MP_SIZE(Ptp.ClockFrequencyHz),
+            PTP_CLOCK_FREQUENCY_DEFAULT,
+            PTP_CLOCK_FREQUENCY_MIN,
+            PTP_CLOCK_FREQUENCY_MAX
+        },
+        {
+            NDIS_STRING_CONST("InterruptCoalescingClockFrequency"),
+            MP_OFFSET(IntCoalescingClockFrequencyHz),
+            MP_SIZE(IntCoalescingClockFrequencyHz),
+            0,
+            0,
+            ENET_IC_CLOCK_FREQUENCY_MAX
+        },
+        {
+            NDIS_STRING_CONST("*IPChecksumOffloadIPv4"),
+            MP_OFFSET(IPChecksumOffloadIPv4),
+            MP_SIZE(IPChecksumOffloadIPv4),
+            CHECKSUM_OFFLOAD_DEFAULT,
+            CHECKSUM_OFFLOAD_MIN,
+            CHECKSUM_OFFLOAD_MAX
+        },
+        {
+            NDIS_STRING_CONST("*TCPChecksumOffloadIPv4"),
+            MP_OFFSET(TCPChecksumOffloadIPv4),
+            MP_SIZE(TCPChecksumOffloadIPv4),
+            CHECKSUM_OFFLOAD_DEFAULT,
+            CHECKSUM_OFFLOAD_MIN,
+            CHECKSUM_OFFLOAD_MAX
+        },
+        {
+            NDIS_STRING_CONST("*UDPChecksumOffloadIPv4"),
+            MP_OFFSET(UDPChecksumOffloadIPv4),
+            MP_SIZE(UDPChecksumOffloadIPv4),
+            CHECKSUM_OFFLOAD_DEFAULT,
+            CHECKSUM_OFFLOAD_MIN,
+            CHECKSUM_OFFLOAD_MAX
+        },
+        {
+            NDIS_STRING_CONST("*TCPChecksumOffloadIPv6"),
+            MP_OFFSET(TCPChecksumOffloadIPv6),
+            MP_SIZE(TCPChecksumOffloadIPv6),
+            CHECKSUM_OFFLOAD_DEFAULT,
+            CHECKSUM_OFFLOAD_MIN,
+            CHECKSUM_OFFLOAD_MAX
+        },
+        {
+            NDIS_STRING_CONST("*UDPChecksumOffloadIPv6"),
+            MP_OFFSET(UDPChecksumOffloadIPv6),
+            MP_SIZE(UDPChecksumOffloadIPv6),
+            CHECKSUM_OFFLOAD_DEFAULT,
+            CHECKSUM_OFFLOAD_MIN,
+            CHECKSUM_OFFLOAD_MAX
+        },
 #if DBG
         {
             NDIS_STRING_CONST("OpcodePauseDuration"),
@@ -518,6 +813,16 @@ NDIS_STATUS NICReadRegParameters(PMP_ADAPTER pAdapter)
             NdisMoveMemory((PUCHAR)pAdapter + regValueDescPtr->ParamOffset, &value, regValueDescPtr->ParamSize);
             Status = NDIS_STATUS_SUCCESS;
         }
+        if (pAdapter->EnhancedBDs) {
+            pAdapter->DmaBDSize = sizeof(ENET_ENHANCED_BD);
+        } else {                                                   // Checksum offload requires enhanced buffer descriptors
+            pAdapter->DmaBDSize              = sizeof(ENET_BD);
+            pAdapter->IPChecksumOffloadIPv4  = MP_CHECKSUM_OFFLOAD_DISABLED;
+            pAdapter->TCPChecksumOffloadIPv4 = MP_CHECKSUM_OFFLOAD_DISABLED;
+            pAdapter->UDPChecksumOffloadIPv4 = MP_CHECKSUM_OFFLOAD_DISABLED;
+            pAdapter->TCPChecksumOffloadIPv6 = MP_CHECKSUM_OFFLOAD_DISABLED;
+            pAdapter->UDPChecksumOffloadIPv6 = MP_CHECKSUM_OFFLOAD_DISABLED;
+        }
         // If there is a MAC address in registry, use it.
         NdisReadNetworkAddress(&Status, &NetworkAddress, &Length, ConfigurationHandle);
         if ((Status == NDIS_STATUS_SUCCESS) && (Length == ETH_LENGTH_OF_ADDRESS)) {
@@ -538,3 +843,87 @@ NDIS_STATUS NICReadRegParameters(PMP_ADAPTER pAdapter)
     DBG_ENET_DEV_METHOD_END_WITH_STATUS(Status);
     return Status;
 }
+
+/*++
+Routine Description:
+    Fills NDIS_OFFLOAD structure with either the checksum offload capabilities of the ENET or the current checksum offload configuration.
+Arguments:
+    pAdapter                Pointer to our adapter
+    pOffload                Pointer to NDIS_OFFLOAD structure to fill
+    HardwareCapabilities    TRUE to report hardware capabilities, FALSE to report current configuration
+Return Value:
+    None
+--*/
+_Use_decl_annotations_
+void MpFillOffload(PMP_ADAPTER pAdapter, PNDIS_OFFLOAD pOffload, BOOLEAN HardwareCapabilities)
+{
+    ULONG IpV4 = HardwareCapabilities && pAdapter->EnhancedBDs ? MP_CHECKSUM_OFFLOAD_TX_RX : pAdapter->IPChecksumOffloadIPv4;
+    ULONG TcpV4 = HardwareCapabilities && pAdapter->EnhancedBDs ? MP_CHECKSUM_OFFLOAD_TX_RX : pAdapter->TCPChecksumOffloadIPv4;
+    ULONG UdpV4 = HardwareCapabilities && pAdapter->EnhancedBDs ? MP_CHECKSUM_OFFLOAD_TX_RX : pAdapter->UDPChecksumOffloadIPv4;
+    ULONG TcpV6 = HardwareCapabilities && pAdapter->EnhancedBDs ? MP_CHECKSUM_OFFLOAD_TX_RX : pAdapter->TCPChecksumOffloadIPv6;
+    ULONG UdpV6 = HardwareCapabilities && pAdapter->EnhancedBDs ? MP_CHECKSUM_OFFLOAD_TX_RX : pAdapter->UDPChecksumOffloadIPv6;
+
+    NdisZeroMemory(pOffload, sizeof(NDIS_OFFLOAD));
+    pOffload->Header.Type     = NDIS_OBJECT_TYPE_OFFLOAD;
+    pOffload->Header.Revision = NDIS_OFFLOAD_REVISION_1;
+    pOffload->Header.Size     = NDIS_SIZEOF_NDIS_OFFLOAD_REVISION_1;
+
+    pOffload->Checksum.IPv4Transmit.Encapsulation       = NDIS_ENCAPSULATION_IEEE_802_3;
+    pOffload->Checksum.IPv4Transmit.IpOptionsSupported  = NDIS_OFFLOAD_SUPPORTED;
+    pOffload->Checksum.IPv4Transmit.TcpOptionsSupported = NDIS_OFFLOAD_SUPPORTED;
+    pOffload->Checksum.IPv4Transmit.TcpChecksum         = (TcpV4 & MP_CHECKSUM_OFFLOAD_TX) ? NDIS_OFFLOAD_SUPPORTED : NDIS_OFFLOAD_NOT_SUPPORTED;
+    pOffload->Checksum.IPv4Transmit.UdpChecksum         = (UdpV4 & MP_CHECKSUM_OFFLOAD_TX) ? NDIS_OFFLOAD_SUPPORTED : NDIS_OFFLOAD_NOT_SUPPORTED;
+    pOffload->Checksum.IPv4Transmit.IpChecksum          = (IpV4  & MP_CHECKSUM_OFFLOAD_TX) ? NDIS_OFFLOAD_SUPPORTED : NDIS_OFFLOAD_NOT_SUPPORTED;
+
+    pOffload->Checksum.IPv4Receive.Encapsulation        = NDIS_ENCAPSULATION_IEEE_802_3;
+    pOffload->Checksum.IPv4Receive.IpOptionsSupported   = NDIS_OFFLOAD_SUPPORTED;
+    pOffload->Checksum.IPv4Receive.TcpOptionsSupported  = NDIS_OFFLOAD_SUPPORTED;
+    pOffload->Checksum.IPv4Receive.TcpChecksum          = (TcpV4 & MP_CHECKSUM_OFFLOAD_RX) ? NDIS_OFFLOAD_SUPPORTED : NDIS_OFFLOAD_NOT_SUPPORTED;
+    pOffload->Checksum.IPv4Receive.UdpChecksum          = (UdpV4 & MP_CHECKSUM_OFFLOAD_RX) ? NDIS_OFFLOAD_SUPPORTED : NDIS_OFFLOAD_NOT_SUPPORTED;
+    pOffload->Checksum.IPv4Receive.IpChecksum           = (IpV4  & MP_CHECKSUM_OFFLOAD_RX) ? NDIS_OFFLOAD_SUPPORTED : NDIS_OFFLOAD_NOT_SUPPORTED;
+
+    pOffload->Checksum.IPv6Transmit.Encapsulation               = NDIS_ENCAPSULATION_IEEE_802_3;
+    pOffload->Checksum.IPv6Transmit.IpExtensionHeadersSupported = NDIS_OFFLOAD_NOT_SUPPORTED;
+    pOffload->Checksum.IPv6Transmit.TcpOptionsSupported         = NDIS_OFFLOAD_SUPPORTED;
+    pOffload->Checksum.IPv6Transmit.TcpChecksum                 = (TcpV6 & MP_CHECKSUM_OFFLOAD_TX) ? NDIS_OFFLOAD_SUPPORTED : NDIS_OFFLOAD_NOT_SUPPORTED;
+    pOffload->Checksum.IPv6Transmit.UdpChecksum                 = (UdpV6 & MP_CHECKSUM_OFFLOAD_TX) ? NDIS_OFFLOAD_SUPPORTED : NDIS_OFFLOAD_NOT_SUPPORTED;
+
+    pOffload->Checksum.IPv6Receive.Encapsulation                = NDIS_ENCAPSULATION_IEEE_802_3;
+    pOffload->Checksum.IPv6Receive.IpExtensionHeadersSupported  = NDIS_OFFLOAD_NOT_SUPPORTED;
+    pOffload->Checksum.IPv6Receive.TcpOptionsSupported          = NDIS_OFFLOAD_SUPPORTED;
+    pOffload->Checksum.IPv6Receive.TcpChecksum                  = (TcpV6 & MP_CHECKSUM_OFFLOAD_RX) ? NDIS_OFFLOAD_SUPPORTED : NDIS_OFFLOAD_NOT_SUPPORTED;
+    pOffload->Checksum.IPv6Receive.UdpChecksum                  = (UdpV6 & MP_CHECKSUM_OFFLOAD_RX) ? NDIS_OFFLOAD_SUPPORTED : NDIS_OFFLOAD_NOT_SUPPORTED;
+}
+
+/*++
+Routine Description:
+    Registers checksum offload hardware capabilities and default (current) configuration with NDIS.
+Arguments:
+    pAdapter    Pointer to our adapter
+Return Value:
+    NDIS_STATUS_SUCCESS
+    NDIS_STATUS_FAILURE
+--*/
+_Use_decl_annotations_
+NDIS_STATUS MpSetOffloadAttributes(PMP_ADAPTER pAdapter)
+{
+    NDIS_STATUS                                 Status;
+    NDIS_OFFLOAD                                HardwareCapabilities;
+    NDIS_OFFLOAD                                DefaultConfiguration;
+    NDIS_MINIPORT_ADAPTER_OFFLOAD_ATTRIBUTES    OffloadAttributes;
+
+    DBG_ENET_DEV_METHOD_BEG();
+    MpFillOffload(pAdapter, &HardwareCapabilities, TRUE);
+    MpFillOffload(pAdapter, &DefaultConfiguration, FALSE);
+    NdisZeroMemory(&OffloadAttributes, sizeof(OffloadAttributes));
+    OffloadAttributes.Header.Type                 = NDIS_OBJECT_TYPE_MINIPORT_ADAPTER_OFFLOAD_ATTRIBUTES;
+    OffloadAttributes.Header.Revision             = NDIS_MINIPORT_ADAPTER_OFFLOAD_ATTRIBUTES_REVISION_1;
+    OffloadAttributes.Header.Size                 = NDIS_SIZEOF_MINIPORT_ADAPTER_OFFLOAD_ATTRIBUTES_REVISION_1;
+    OffloadAttributes.DefaultOffloadConfiguration = &DefaultConfiguration;
+    OffloadAttributes.HardwareOffloadCapabilities = &HardwareCapabilities;
+    if ((Status = NdisMSetMiniportAttributes(pAdapter->AdapterHandle, (PNDIS_MINIPORT_ADAPTER_ATTRIBUTES)&OffloadAttributes)) != NDIS_STATUS_SUCCESS) {
+        DBG_ENET_DEV_PRINT_ERROR_WITH_STATUS("NdisMSetMiniportAttributes() failed.");
+    }
+    DBG_ENET_DEV_METHOD_END_WITH_STATUS(Status);
+    return Status;
+}
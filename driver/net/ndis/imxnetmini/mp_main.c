@@ -169,6 +169,7 @@ NDIS_STATUS MpInitializeEx(NDIS_HANDLE MiniportAdapterHandle, NDIS_HANDLE Minipo
     PCM_PARTIAL_RESOURCE_DESCRIPTOR                 pResDesc;
     ULONG                                           index;
     PMP_MDIO_DRIVER                                 pMDIODriver = (PMP_MDIO_DRIVER)MiniportDriverContext;
+    ULONG                                           DeviceIndex;
 
     PAGED_CODE();
 
@@ -180,8 +181,9 @@ NDIS_STATUS MpInitializeEx(NDIS_HANDLE MiniportAdapterHandle, NDIS_HANDLE Minipo
             DBG_ENET_DEV_PRINT_ERROR_WITH_STATUS("MpAllocAdapterBlock() failed.");
             break;
         }
+        DeviceIndex = (ULONG)(NdisInterlockedIncrement(&pMDIODriver->MDIODrv_EnetDeviceCount) - 1);
         #if DBG
-        RtlStringCbPrintfA(pAdapter->ENETDev_DeviceName, sizeof(pAdapter->ENETDev_DeviceName) - 1, "ENET%d", NdisInterlockedIncrement(&pMDIODriver->MDIODrv_EnetDeviceCount) - 1);
+        RtlStringCbPrintfA(pAdapter->ENETDev_DeviceName, sizeof(pAdapter->ENETDev_DeviceName) - 1, "ENET%d", DeviceIndex);
         RtlStringCbCopyA(pAdapter->ENETDev_PHYDevice.PHYDev_DeviceName, sizeof(pAdapter->ENETDev_PHYDevice.PHYDev_DeviceName) - 1, pAdapter->ENETDev_DeviceName);
         #endif
         // Register miniport
@@ -212,6 +214,15 @@ NDIS_STATUS MpInitializeEx(NDIS_HANDLE MiniportAdapterHandle, NDIS_HANDLE Minipo
             pAdapter->NdisInterruptHandle = NULL;  // SDV bug fix
             break;
         }
+        // ICTT is counted in ENET system clock cycles, the clock frequency differs among i.MX SoCs
+        if (!pAdapter->IntCoalescingClockFrequencyHz) {
+            if (!NT_SUCCESS(Acpi_GetValue(pAdapter, IMX_ENET_DSM_FUNCTION_GET_ENET_CLOCK_FREQUENCY_INDEX, &pAdapter->IntCoalescingClockFrequencyHz, sizeof(pAdapter->IntCoalescingClockFrequencyHz))) ||
+                !pAdapter->IntCoalescingClockFrequencyHz || (pAdapter->IntCoalescingClockFrequencyHz > ENET_IC_CLOCK_FREQUENCY_MAX)) {
+                DBG_ENET_DEV_PRINT_INFO("Acpi_GetValue(GET_ENET_CLOCK_FREQUENCY) failed, using default.");
+                pAdapter->IntCoalescingClockFrequencyHz = ENET_IC_CLOCK_FREQUENCY_DEFAULT;
+            }
+        }
+        DBG_ENET_DEV_PRINT_INFO("ENET interrupt coalescing clock: %d Hz", pAdapter->IntCoalescingClockFrequencyHz);
         #ifdef DBG
         if (!(pAdapter->FecMacAddress[0] || pAdapter->FecMacAddress[1] || pAdapter->FecMacAddress[2] || pAdapter->FecMacAddress[3] || pAdapter->FecMacAddress[4] || pAdapter->FecMacAddress[5])) {
             Status = NDIS_STATUS_FAILURE;
@@ -274,6 +285,10 @@ NDIS_STATUS MpInitializeEx(NDIS_HANDLE MiniportAdapterHandle, NDIS_HANDLE Minipo
             DBG_ENET_DEV_PRINT_ERROR_WITH_STATUS("NdisMSetMiniportAttributes() failed.");
             break;
         }
+        // Set up checksum offload attributes
+        if ((Status = MpSetOffloadAttributes(pAdapter)) != NDIS_STATUS_SUCCESS) {
+            break;
+        }
         // Get HW resources
         NDIS_PHYSICAL_ADDRESS  ENETRegBase;
         BOOLEAN                GotInterrupt = FALSE;
@@ -354,12 +369,24 @@ NDIS_STATUS MpInitializeEx(NDIS_HANDLE MiniportAdapterHandle, NDIS_HANDLE Minipo
             pAdapter->NdisInterruptHandle = NULL;  // SDV bug fix
             break;
         }
+        EnetProbeQueues(pAdapter);                 // Number of Rx/Tx rings must be known before the rings are allocated
         // Allocate all other memory blocks including shared memory
         if ((Status = NICAllocAdapterMemory(pAdapter)) != NDIS_STATUS_SUCCESS)  {
             pAdapter->NdisInterruptHandle = NULL;  // SDV bug fix
             break;
         }
+        if ((Status = MpPtpInit(pAdapter)) != NDIS_STATUS_SUCCESS)  {
+            pAdapter->NdisInterruptHandle = NULL;  // SDV bug fix
+            break;
+        }
         EnetInit(pAdapter, EnetPhyConfig.MDIOCfg_PhyInterfaceType);
+        if ((Status = MpPtpRegisterDevice(pAdapter, DeviceIndex)) != NDIS_STATUS_SUCCESS)  {
+            pAdapter->NdisInterruptHandle = NULL;  // SDV bug fix
+            break;
+        }
+        #if NDIS_SUPPORT_NDIS682
+        MpPtpIndicateCapabilities(pAdapter);       // Report the IEEE 1588 time stamping capabilities
+        #endif
         NdisZeroMemory(&Interrupt, sizeof(NDIS_MINIPORT_INTERRUPT_CHARACTERISTICS));
         Interrupt.Header.Type             = NDIS_OBJECT_TYPE_MINIPORT_INTERRUPT;
         Interrupt.Header.Revision         = NDIS_MINIPORT_INTERRUPT_REVISION_1;
@@ -0,0 +1,590 @@
+/*
+* Copyright 2018 NXP
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted (subject to the limitations in the disclaimer
+* below) provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice, this
+* list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* * Neither the name of NXP nor the names of its contributors may be used to
+* endorse or promote products derived from this software without specific prior
+* written permission.
+*
+* NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY THIS
+* LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+* THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+* GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+* LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+
+#include "precomp.h"
+#include "imxnetminiioctl.h"
+
+extern NDIS_HANDLE NdisMiniportDriverHandle;
+
+#define ENET_PTP_UNIX_EPOCH_100NS   116444736000000000ULL   // KeQuerySystemTime() value at 1.1.1970 (100 ns units since 1.1.1601)
+#define ENET_PTP_NAME_MAX_LENGTH    64                      // Max length of the control device name [WCHAR]
+
+static NDIS_TIMER_FUNCTION MpPtpTimerCallback;
+_Dispatch_type_(IRP_MJ_CREATE)
+_Dispatch_type_(IRP_MJ_CLEANUP)
+_Dispatch_type_(IRP_MJ_CLOSE)
+_Dispatch_type_(IRP_MJ_DEVICE_CONTROL)
+static DRIVER_DISPATCH MpPtpDispatch;
+
+/*++
+Routine Description:
+    Captures the ENET timer counter.
+    Caller must hold the PTP clock spin lock.
+Arguments:
+    pAdapter    Pointer to adapter data
+Return Value:
+    Counter value
+--*/
+_IRQL_requires_(DISPATCH_LEVEL)
+static ULONG EnetPtpReadCounter(_In_ PMP_ADAPTER pAdapter)
+{
+    volatile CSP_ENET_REGS* ENETRegBase = pAdapter->ENETRegBase;
+
+    ENETRegBase->ATCR |= ENET_ATCR_CAPTURE_MASK;                         // Latch the counter value to ATVR
+    NdisStallExecution(1);                                               // The capture takes a few ENET_REF_CLK cycles
+    return ENETRegBase->ATVR & ENET_PTP_COUNTER_MASK;
+}
+
+/*++
+Routine Description:
+    Reads the ENET timer counter and updates the 64 bit time reference point.
+    Caller must hold the PTP clock spin lock.
+Arguments:
+    pAdapter    Pointer to adapter data
+Return Value:
+    Current 64 bit time [ns]
+--*/
+_IRQL_requires_(DISPATCH_LEVEL)
+static ULONG64 EnetPtpUpdateTime(_In_ PMP_ADAPTER pAdapter)
+{
+    PMP_PTP_CLOCK pPtp    = &pAdapter->Ptp;
+    ULONG         Counter = EnetPtpReadCounter(pAdapter);
+
+    pPtp->LastTime    = EnetPtpCounterToTime(pPtp->LastTime, pPtp->LastCounter, Counter);
+    pPtp->LastCounter = Counter;
+    return pPtp->LastTime;
+}
+
+/*++
+Routine Description:
+    Writes the counter increment and the correction for the current frequency adjustment to the ENET timer.
+    Caller must hold the PTP clock spin lock.
+Arguments:
+    pAdapter    Pointer to adapter data
+Return Value:
+    None
+--*/
+_IRQL_requires_max_(DISPATCH_LEVEL)
+static void EnetPtpWriteCorrection(_In_ PMP_ADAPTER pAdapter)
+{
+    volatile CSP_ENET_REGS* ENETRegBase = pAdapter->ENETRegBase;
+    PMP_PTP_CLOCK           pPtp        = &pAdapter->Ptp;
+    ULONG                   CorrectionInc;
+    ULONG                   CorrectionPeriod;
+
+    CorrectionPeriod   = EnetPtpGetCorrection(pPtp->ClockFrequencyHz, pPtp->Inc, pPtp->FrequencyPpb, &CorrectionInc);
+    ENETRegBase->ATCOR = CorrectionPeriod;                                // 0 disables the correction
+    ENETRegBase->ATINC = (pPtp->Inc & ENET_ATINC_INC_MASK) | ((CorrectionInc << ENET_ATINC_INC_CORR_SHIFT) & ENET_ATINC_INC_CORR_MASK);
+}
+
+/*++
+Routine Description:
+    Initializes the IEEE 1588 clock data. The ENET timer is started by EnetPtpStart().
+Arguments:
+    pAdapter    Pointer to adapter data
+Return Value:
+    NDIS_STATUS_SUCCESS
+    NDIS_STATUS_RESOURCES
+--*/
+_Use_decl_annotations_
+NDIS_STATUS MpPtpInit(PMP_ADAPTER pAdapter)
+{
+    NDIS_STATUS                 Status = NDIS_STATUS_SUCCESS;
+    PMP_PTP_CLOCK               pPtp   = &pAdapter->Ptp;
+    NDIS_TIMER_CHARACTERISTICS  Timer;
+
+    DBG_ENET_DEV_METHOD_BEG();
+    for (;;) {
+        pPtp->Enabled = pAdapter->PtpHardwareTimestamp && pAdapter->EnhancedBDs;      // Time stamps are stored in the enhanced buffer descriptors
+        if (!pPtp->Enabled) {
+            DBG_ENET_DEV_PRINT_INFO("IEEE 1588 time stamping disabled.");
+            break;
+        }
+        NdisAllocateSpinLock(&pPtp->SpinLock);
+        pPtp->Inc          = 1000000000UL / pPtp->ClockFrequencyHz;
+        pPtp->FrequencyPpb = 0;
+        NdisZeroMemory(&Timer, sizeof(Timer));
+        Timer.Header.Type     = NDIS_OBJECT_TYPE_TIMER_CHARACTERISTICS;
+        Timer.Header.Revision = NDIS_TIMER_CHARACTERISTICS_REVISION_1;
+        Timer.Header.Size     = NDIS_SIZEOF_TIMER_CHARACTERISTICS_REVISION_1;
+        Timer.AllocationTag   = MP_TAG_PTP_TIMER_DESC;
+        Timer.TimerFunction   = MpPtpTimerCallback;
+        Timer.FunctionContext = pAdapter;
+        if ((Status = NdisAllocateTimerObject(pAdapter->AdapterHandle, &Timer, &pPtp->hTimer)) != NDIS_STATUS_SUCCESS) {
+            Status = NDIS_STATUS_RESOURCES;
+            pPtp->hTimer  = NULL;
+            pPtp->Enabled = FALSE;
+            DBG_ENET_DEV_PRINT_ERROR_WITH_STATUS("NdisAllocateTimerObject() failed.");
+            break;
+        }
+        DBG_ENET_DEV_PRINT_INFO("IEEE 1588 clock: %d Hz, increment %d ns", pPtp->ClockFrequencyHz, pPtp->Inc);
+        break;
+    }
+    DBG_ENET_DEV_METHOD_END_WITH_STATUS(Status);
+    return Status;
+}
+
+/*++
+Routine Description:
+    Stops the ENET timer and frees the IEEE 1588 clock resources.
+Arguments:
+    pAdapter    Pointer to adapter data
+Return Value:
+    None
+--*/
+_Use_decl_annotations_
+void MpPtpDeinit(PMP_ADAPTER pAdapter)
+{
+    PMP_PTP_CLOCK pPtp = &pAdapter->Ptp;
+
+    DBG_ENET_DEV_METHOD_BEG();
+    if (pPtp->hTimer) {
+        (void)NdisCancelTimerObject(pPtp->hTimer);
+        NdisFreeTimerObject(pPtp->hTimer);
+        pPtp->hTimer = NULL;
+    }
+    if (pPtp->Enabled) {
+        if (pAdapter->ENETRegBase) {
+            pAdapter->ENETRegBase->ATCR = 0;                             // Stop the timer
+        }
+        NdisFreeSpinLock(&pPtp->SpinLock);
+        pPtp->Enabled = FALSE;
+    }
+    DBG_ENET_DEV_METHOD_END();
+}
+
+/*++
+Routine Description:
+    Starts the ENET timer, sets the clock to the current system time and starts the periodic 64 bit time update.
+Arguments:
+    pAdapter    Pointer to adapter data
+Return Value:
+    None
+--*/
+_Use_decl_annotations_
+void EnetPtpStart(PMP_ADAPTER pAdapter)
+{
+    volatile CSP_ENET_REGS* ENETRegBase = pAdapter->ENETRegBase;
+    PMP_PTP_CLOCK           pPtp        = &pAdapter->Ptp;
+    LARGE_INTEGER           SystemTime;
+    LARGE_INTEGER           DueTime;
+
+    DBG_ENET_DEV_METHOD_BEG();
+    KeQuerySystemTimePrecise(&SystemTime);
+    NdisAcquireSpinLock(&pPtp->SpinLock);
+    ENETRegBase->ATCR  = 0;                                              // Stop the timer
+    ENETRegBase->ATPER = ENET_PTP_COUNTER_PERIOD;                        // Wrap at 2^31 ns
+    EnetPtpWriteCorrection(pAdapter);
+    ENETRegBase->ATCR  = ENET_ATCR_RESTART_MASK;                         // Reset the counter
+    ENETRegBase->ATCR  = ENET_ATCR_EN_MASK;
+    pPtp->LastCounter  = EnetPtpReadCounter(pAdapter);
+    pPtp->LastTime     = ((ULONG64)SystemTime.QuadPart - ENET_PTP_UNIX_EPOCH_100NS) * 100;
+    NdisReleaseSpinLock(&pPtp->SpinLock);
+    DueTime.QuadPart = -(LONGLONG)ENET_PTP_UPDATE_PERIOD_MS * 10000;     // Relative time in 100 ns units
+    (void)NdisSetTimerObject(pPtp->hTimer, DueTime, ENET_PTP_UPDATE_PERIOD_MS, pAdapter);
+    DBG_ENET_DEV_METHOD_END();
+}
+
+/*++
+Routine Description:
+    Periodic timer callback, keeps the 64 bit time reference point within half of the counter period.
+Arguments:
+    SystemSpecific1     Not used
+    FunctionContext     Pointer to our adapter
+    SystemSpecific2     Not used
+    SystemSpecific3     Not used
+Return Value:
+    None
+--*/
+_Use_decl_annotations_
+static void MpPtpTimerCallback(PVOID SystemSpecific1, PVOID FunctionContext, PVOID SystemSpecific2, PVOID SystemSpecific3)
+{
+    UNREFERENCED_PARAMETER(SystemSpecific1);
+    UNREFERENCED_PARAMETER(SystemSpecific2);
+    UNREFERENCED_PARAMETER(SystemSpecific3);
+    (void)MpPtpGetTime((PMP_ADAPTER)FunctionContext);
+}
+
+/*++
+Routine Description:
+    Returns the current IEEE 1588 clock time.
+Arguments:
+    pAdapter    Pointer to adapter data
+Return Value:
+    Current time [ns]
+--*/
+_Use_decl_annotations_
+ULONG64 MpPtpGetTime(PMP_ADAPTER pAdapter)
+{
+    ULONG64 Time;
+
+    NdisAcquireSpinLock(&pAdapter->Ptp.SpinLock);
+    Time = EnetPtpUpdateTime(pAdapter);
+    NdisReleaseSpinLock(&pAdapter->Ptp.SpinLock);
+    return Time;
+}
+
+/*++
+Routine Description:
+    Converts the ENET_xxBD time stamp to the IEEE 1588 clock time.
+    The time stamp must not be older than ~0.5 s, i.e. it must be converted when the frame is completed.
+Arguments:
+    pAdapter    Pointer to adapter data
+    Timestamp   ENET_xxBD time stamp
+Return Value:
+    Time stamp [ns]
+--*/
+_Use_decl_annotations_
+ULONG64 MpPtpTimestampToTime(PMP_ADAPTER pAdapter, ULONG Timestamp)
+{
+    PMP_PTP_CLOCK pPtp = &pAdapter->Ptp;
+    ULONG64       Time;
+
+    NdisAcquireSpinLock(&pPtp->SpinLock);
+    Time = EnetPtpCounterToTime(pPtp->LastTime, pPtp->LastCounter, Timestamp & ENET_PTP_COUNTER_MASK);
+    NdisReleaseSpinLock(&pPtp->SpinLock);
+    return Time;
+}
+
+/*++
+Routine Description:
+    Sets the IEEE 1588 clock time. The ENET timer keeps running, only the 64 bit time reference point is moved,
+    so the time stamps of the frames in flight stay consistent with the new time.
+Arguments:
+    pAdapter    Pointer to adapter data
+    Time        New time [ns]
+Return Value:
+    None
+--*/
+_Use_decl_annotations_
+void MpPtpSetTime(PMP_ADAPTER pAdapter, ULONG64 Time)
+{
+    PMP_PTP_CLOCK pPtp = &pAdapter->Ptp;
+
+    NdisAcquireSpinLock(&pPtp->SpinLock);
+    pPtp->LastCounter = EnetPtpReadCounter(pAdapter);
+    pPtp->LastTime    = Time;
+    NdisReleaseSpinLock(&pPtp->SpinLock);
+    DBG_ENET_DEV_PRINT_INFO("IEEE 1588 clock set to %I64u ns", Time);
+}
+
+/*++
+Routine Description:
+    Steps the IEEE 1588 clock time.
+Arguments:
+    pAdapter    Pointer to adapter data
+    Offset      Time offset [ns]
+Return Value:
+    None
+--*/
+_Use_decl_annotations_
+void MpPtpAdjustTime(PMP_ADAPTER pAdapter, LONG64 Offset)
+{
+    PMP_PTP_CLOCK pPtp = &pAdapter->Ptp;
+
+    NdisAcquireSpinLock(&pPtp->SpinLock);
+    (void)EnetPtpUpdateTime(pAdapter);
+    pPtp->LastTime += (ULONG64)Offset;
+    NdisReleaseSpinLock(&pPtp->SpinLock);
+    DBG_ENET_DEV_PRINT_INFO("IEEE 1588 clock adjusted by %I64d ns", Offset);
+}
+
+/*++
+Routine Description:
+    Sets the IEEE 1588 clock frequency adjustment.
+Arguments:
+    pAdapter        Pointer to adapter data
+    FrequencyPpb    Frequency adjustment [ppb], limited to +/- ENET_PTP_MAX_ADJ_PPB
+Return Value:
+    None
+--*/
+_Use_decl_annotations_
+void MpPtpAdjustFrequency(PMP_ADAPTER pAdapter, LONG FrequencyPpb)
+{
+    PMP_PTP_CLOCK pPtp = &pAdapter->Ptp;
+
+    if (FrequencyPpb > ENET_PTP_MAX_ADJ_PPB) {
+        FrequencyPpb = ENET_PTP_MAX_ADJ_PPB;
+    } else if (FrequencyPpb < -ENET_PTP_MAX_ADJ_PPB) {
+        FrequencyPpb = -ENET_PTP_MAX_ADJ_PPB;
+    }
+    NdisAcquireSpinLock(&pPtp->SpinLock);
+    (void)EnetPtpUpdateTime(pAdapter);                                   // Time elapsed so far was counted with the previous rate
+    pPtp->FrequencyPpb = FrequencyPpb;
+    EnetPtpWriteCorrection(pAdapter);
+    NdisReleaseSpinLock(&pPtp->SpinLock);
+}
+
+/*++
+Routine Description:
+    Handles the IEEE 1588 clock IOCTL requests (see imxnetminiioctl.h).
+Arguments:
+    pAdapter        Pointer to adapter data
+    pIrp            The IOCTL request
+    pIrpSp          Current IRP stack location
+Return Value:
+    STATUS_SUCCESS
+    STATUS_BUFFER_TOO_SMALL
+    STATUS_INVALID_DEVICE_REQUEST
+--*/
+_IRQL_requires_max_(PASSIVE_LEVEL)
+static NTSTATUS MpPtpDeviceControl(_In_ PMP_ADAPTER pAdapter, _Inout_ PIRP pIrp, _In_ PIO_STACK_LOCATION pIrpSp)
+{
+    NTSTATUS                        Status       = STATUS_SUCCESS;
+    PVOID                           pBuffer      = pIrp->AssociatedIrp.SystemBuffer;
+    ULONG                           InputLength  = pIrpSp->Parameters.DeviceIoControl.InputBufferLength;
+    ULONG                           OutputLength = pIrpSp->Parameters.DeviceIoControl.OutputBufferLength;
+    IMX_ENET_PTP_GET_TIME_OUTPUT*   pGetTime;
+    LARGE_INTEGER                   PerformanceFrequency;
+
+    switch (pIrpSp->Parameters.DeviceIoControl.IoControlCode) {
+        case IOCTL_IMX_ENET_PTP_GET_TIME:
+            if (OutputLength < sizeof(IMX_ENET_PTP_GET_TIME_OUTPUT)) {
+                Status = STATUS_BUFFER_TOO_SMALL;
+                break;
+            }
+            pGetTime = (IMX_ENET_PTP_GET_TIME_OUTPUT*)pBuffer;
+            pGetTime->PerformanceCounterBefore = KeQueryPerformanceCounter(NULL).QuadPart;
+            pGetTime->Time                     = MpPtpGetTime(pAdapter);
+            pGetTime->PerformanceCounterAfter  = KeQueryPerformanceCounter(&PerformanceFrequency).QuadPart;
+            pGetTime->PerformanceFrequency     = PerformanceFrequency.QuadPart;
+            pGetTime->FrequencyPpb             = pAdapter->Ptp.FrequencyPpb;
+            pIrp->IoStatus.Information = sizeof(IMX_ENET_PTP_GET_TIME_OUTPUT);
+            break;
+        case IOCTL_IMX_ENET_PTP_SET_TIME:
+            if (InputLength < sizeof(IMX_ENET_PTP_SET_TIME_INPUT)) {
+                Status = STATUS_BUFFER_TOO_SMALL;
+                break;
+            }
+            MpPtpSetTime(pAdapter, ((IMX_ENET_PTP_SET_TIME_INPUT*)pBuffer)->Time);
+            break;
+        case IOCTL_IMX_ENET_PTP_ADJUST_TIME:
+            if (InputLength < sizeof(IMX_ENET_PTP_ADJUST_TIME_INPUT)) {
+                Status = STATUS_BUFFER_TOO_SMALL;
+                break;
+            }
+            MpPtpAdjustTime(pAdapter, ((IMX_ENET_PTP_ADJUST_TIME_INPUT*)pBuffer)->Offset);
+            break;
+        case IOCTL_IMX_ENET_PTP_ADJUST_FREQUENCY:
+            if (InputLength < sizeof(IMX_ENET_PTP_ADJUST_FREQUENCY_INPUT)) {
+                Status = STATUS_BUFFER_TOO_SMALL;
+                break;
+            }
+            MpPtpAdjustFrequency(pAdapter, ((IMX_ENET_PTP_ADJUST_FREQUENCY_INPUT*)pBuffer)->FrequencyPpb);
+            break;
+        default:
+            Status = STATUS_INVALID_DEVICE_REQUEST;
+            break;
+    }
+    return Status;
+}
+
+/*++
+Routine Description:
+    IEEE 1588 clock control device dispatch routine.
+Arguments:
+    DeviceObject    The control device object
+    Irp             The request
+Return Value:
+    NTSTATUS
+--*/
+_Use_decl_annotations_
+static NTSTATUS MpPtpDispatch(PDEVICE_OBJECT DeviceObject, PIRP Irp)
+{
+    NTSTATUS            Status   = STATUS_SUCCESS;
+    PIO_STACK_LOCATION  pIrpSp   = IoGetCurrentIrpStackLocation(Irp);
+    PMP_ADAPTER         pAdapter = *(PMP_ADAPTER*)NdisGetDeviceReservedExtension(DeviceObject);
+
+    Irp->IoStatus.Information = 0;
+    switch (pIrpSp->MajorFunction) {
+        case IRP_MJ_CREATE:
+        case IRP_MJ_CLEANUP:
+        case IRP_MJ_CLOSE:
+            break;
+        case IRP_MJ_DEVICE_CONTROL:
+            if (pAdapter == NULL) {
+                Status = STATUS_DEVICE_NOT_READY;
+                break;
+            }
+            Status = MpPtpDeviceControl(pAdapter, Irp, pIrpSp);
+            break;
+        default:
+            Status = STATUS_INVALID_DEVICE_REQUEST;
+            break;
+    }
+    Irp->IoStatus.Status = Status;
+    IoCompleteRequest(Irp, IO_NO_INCREMENT);
+    return Status;
+}
+
+/*++
+Routine Description:
+    Creates the IEEE 1588 clock control device \Device\ImxEnetPtp<DeviceIndex>.
+    The device is accessible by the administrators and the system only.
+Arguments:
+    pAdapter        Pointer to adapter data
+    DeviceIndex     ENET instance index
+Return Value:
+    NDIS_STATUS_SUCCESS
+    NDIS_STATUS_FAILURE
+--*/
+_Use_decl_annotations_
+NDIS_STATUS MpPtpRegisterDevice(PMP_ADAPTER pAdapter, ULONG DeviceIndex)
+{
+    NDIS_STATUS                     Status = NDIS_STATUS_SUCCESS;
+    PMP_PTP_CLOCK                   pPtp   = &pAdapter->Ptp;
+    NDIS_DEVICE_OBJECT_ATTRIBUTES   DeviceAttributes;
+    PDRIVER_DISPATCH                DispatchTable[IRP_MJ_MAXIMUM_FUNCTION + 1];
+    WCHAR                           DeviceNameBuffer[ENET_PTP_NAME_MAX_LENGTH];
+    WCHAR                           SymbolicNameBuffer[ENET_PTP_NAME_MAX_LENGTH];
+    UNICODE_STRING                  DeviceName;
+    UNICODE_STRING                  SymbolicName;
+    NDIS_STRING                     Sddl = NDIS_STRING_CONST("D:P(A;;GA;;;SY)(A;;GA;;;BA)");
+
+    DBG_ENET_DEV_METHOD_BEG_WITH_PARAMS("Device index: %d", DeviceIndex);
+    for (;;) {
+        if (!pPtp->Enabled) {
+            break;
+        }
+        RtlInitEmptyUnicodeString(&DeviceName, DeviceNameBuffer, sizeof(DeviceNameBuffer));
+        RtlInitEmptyUnicodeString(&SymbolicName, SymbolicNameBuffer, sizeof(SymbolicNameBuffer));
+        if (!NT_SUCCESS(RtlUnicodeStringPrintf(&DeviceName, L"%ws%u", IMX_ENET_PTP_DEVICE_NAME, DeviceIndex)) ||
+            !NT_SUCCESS(RtlUnicodeStringPrintf(&SymbolicName, L"%ws%u", IMX_ENET_PTP_SYMBOLIC_NAME, DeviceIndex))) {
+            Status = NDIS_STATUS_FAILURE;
+            DBG_ENET_DEV_PRINT_ERROR_WITH_STATUS("RtlUnicodeStringPrintf() failed.");
+            break;
+        }
+        NdisZeroMemory(DispatchTable, sizeof(DispatchTable));
+        DispatchTable[IRP_MJ_CREATE]         = MpPtpDispatch;
+        DispatchTable[IRP_MJ_CLEANUP]        = MpPtpDispatch;
+        DispatchTable[IRP_MJ_CLOSE]          = MpPtpDispatch;
+        DispatchTable[IRP_MJ_DEVICE_CONTROL] = MpPtpDispatch;
+        NdisZeroMemory(&DeviceAttributes, sizeof(DeviceAttributes));
+        DeviceAttributes.Header.Type         = NDIS_OBJECT_TYPE_DEVICE_OBJECT_ATTRIBUTES;
+        DeviceAttributes.Header.Revision     = NDIS_DEVICE_OBJECT_ATTRIBUTES_REVISION_1;
+        DeviceAttributes.Header.Size         = NDIS_SIZEOF_DEVICE_OBJECT_ATTRIBUTES_REVISION_1;
+        DeviceAttributes.DeviceName          = &DeviceName;
+        DeviceAttributes.SymbolicName        = &SymbolicName;
+        DeviceAttributes.MajorFunctions      = DispatchTable;
+        DeviceAttributes.ExtensionSize       = sizeof(PMP_ADAPTER);
+        DeviceAttributes.DefaultSDDLString   = &Sddl;
+        DeviceAttributes.DeviceClassGuid     = NULL;
+        if ((Status = NdisRegisterDeviceEx(NdisMiniportDriverHandle, &DeviceAttributes, &pPtp->DeviceObject, &pPtp->DeviceHandle)) != NDIS_STATUS_SUCCESS) {
+            pPtp->DeviceObject = NULL;
+            pPtp->DeviceHandle = NULL;
+            DBG_ENET_DEV_PRINT_ERROR_WITH_STATUS("NdisRegisterDeviceEx() failed.");
+            break;
+        }
+        *(PMP_ADAPTER*)NdisGetDeviceReservedExtension(pPtp->DeviceObject) = pAdapter;
+        break;
+    }
+    DBG_ENET_DEV_METHOD_END_WITH_STATUS(Status);
+    return Status;
+}
+
+/*++
+Routine Description:
+    Deletes the IEEE 1588 clock control device.
+Arguments:
+    pAdapter    Pointer to adapter data
+Return Value:
+    None
+--*/
+_Use_decl_annotations_
+void MpPtpDeregisterDevice(PMP_ADAPTER pAdapter)
+{
+    PMP_PTP_CLOCK pPtp = &pAdapter->Ptp;
+
+    if (pPtp->DeviceHandle) {
+        NdisDeregisterDeviceEx(pPtp->DeviceHandle);
+        pPtp->DeviceHandle = NULL;
+        pPtp->DeviceObject = NULL;
+    }
+}
+
+#if NDIS_SUPPORT_NDIS682
+/*++
+Routine Description:
+    Fills the NDIS_TIMESTAMP_CAPABILITIES structure.
+    The hardware clock counts nanoseconds, all received frames and the transmitted frames tagged with
+    NDIS_NBL_FLAGS_CAPTURE_TIMESTAMP_ON_TRANSMIT are time stamped.
+Arguments:
+    pAdapter        Pointer to adapter data
+    pCapabilities   Pointer to the capabilities structure
+Return Value:
+    None
+--*/
+_Use_decl_annotations_
+void MpPtpGetCapabilities(PMP_ADAPTER pAdapter, PNDIS_TIMESTAMP_CAPABILITIES pCapabilities)
+{
+    NdisZeroMemory(pCapabilities, sizeof(NDIS_TIMESTAMP_CAPABILITIES));
+    pCapabilities->Header.Type     = NDIS_OBJECT_TYPE_DEFAULT;
+    pCapabilities->Header.Revision = NDIS_TIMESTAMP_CAPABILITIES_REVISION_1;
+    pCapabilities->Header.Size     = NDIS_SIZEOF_TIMESTAMP_CAPABILITIES_REVISION_1;
+    if (pAdapter->Ptp.Enabled) {
+        pCapabilities->HardwareClockFrequencyHz        = 1000000000ULL;   // The clock counts nanoseconds
+        pCapabilities->CrossTimestamp                  = TRUE;            // OID_TIMESTAMP_GET_CROSSTIMESTAMP
+        pCapabilities->TimestampFlags.AllReceiveHw     = TRUE;
+        pCapabilities->TimestampFlags.TaggedTransmitHw = TRUE;
+    }
+}
+
+/*++
+Routine Description:
+    Indicates the time stamping capabilities and the current configuration to NDIS.
+Arguments:
+    pAdapter    Pointer to adapter data
+Return Value:
+    None
+--*/
+_Use_decl_annotations_
+void MpPtpIndicateCapabilities(PMP_ADAPTER pAdapter)
+{
+    NDIS_TIMESTAMP_CAPABILITIES Capabilities;
+    NDIS_STATUS_INDICATION      StatusIndication;
+
+    MpPtpGetCapabilities(pAdapter, &Capabilities);
+    NdisZeroMemory(&StatusIndication, sizeof(NDIS_STATUS_INDICATION));
+    StatusIndication.Header.Type      = NDIS_OBJECT_TYPE_STATUS_INDICATION;
+    StatusIndication.Header.Revision  = NDIS_STATUS_INDICATION_REVISION_1;
+    StatusIndication.Header.Size      = NDIS_SIZEOF_STATUS_INDICATION_REVISION_1;
+    StatusIndication.SourceHandle     = pAdapter->AdapterHandle;
+    StatusIndication.StatusCode       = NDIS_STATUS_TIMESTAMP_CAPABILITY;
+    StatusIndication.StatusBuffer     = (PVOID)&Capabilities;
+    StatusIndication.StatusBufferSize = sizeof(Capabilities);
+    NdisMIndicateStatusEx(pAdapter->AdapterHandle, &StatusIndication);
+    StatusIndication.StatusCode       = NDIS_STATUS_TIMESTAMP_CURRENT_CONFIG;
+    NdisMIndicateStatusEx(pAdapter->AdapterHandle, &StatusIndication);
+}
+#endif
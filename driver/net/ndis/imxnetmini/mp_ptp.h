@@ -0,0 +1,146 @@
+/*
+* Copyright 2018 NXP
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted (subject to the limitations in the disclaimer
+* below) provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice, this
+* list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* * Neither the name of NXP nor the names of its contributors may be used to
+* endorse or promote products derived from this software without specific prior
+* written permission.
+*
+* NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY THIS
+* LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+* "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+* THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+* GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+* HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+* LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+* OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+*/
+
+
+#ifndef _MP_PTP_H
+#define _MP_PTP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct _MP_ADAPTER MP_ADAPTER,*PMP_ADAPTER;
+
+// IEEE 1588 (PTP) clock. The ENET timer counter (31 bits, nanoseconds) is extended to the 64 bit time in software.
+typedef struct _MP_PTP_CLOCK {
+    BOOLEAN         Enabled;                   // Time stamping enabled (registry and enhanced buffer descriptors)
+    NDIS_SPIN_LOCK  SpinLock;                  // Serializes the timer access and the fields below
+    NDIS_HANDLE     hTimer;                    // Periodic 64 bit time update timer
+    ULONG           ClockFrequencyHz;          // Timer reference clock frequency
+    ULONG           Inc;                       // Nominal counter increment per reference clock cycle [ns] (ATINC[INC])
+    LONG            FrequencyPpb;              // Current frequency adjustment [ppb]
+    ULONG           LastCounter;               // Counter value at LastTime
+    ULONG64         LastTime;                  // 64 bit time of the last counter read [ns]
+    NDIS_HANDLE     DeviceHandle;              // Control device (IOCTL) handle
+    PDEVICE_OBJECT  DeviceObject;              // Control device object
+} MP_PTP_CLOCK, *PMP_PTP_CLOCK;
+
+/*++
+Routine Description:
+    Converts the ENET timer counter value (or the ENET_xxBD time stamp) to the 64 bit time.
+    The counter value may be older or newer than the reference point, but it must not be more than half of the counter period away.
+Arguments:
+    LastTime        64 bit time of the reference point [ns]
+    LastCounter     Counter value at the reference point
+    Counter         Counter value to convert
+Return Value:
+    64 bit time [ns]
+--*/
+static __inline ULONG64 EnetPtpCounterToTime(_In_ ULONG64 LastTime, _In_ ULONG LastCounter, _In_ ULONG Counter)
+{
+    ULONG Delta = (Counter - LastCounter) & ENET_PTP_COUNTER_MASK;
+
+    if (Delta > (ENET_PTP_COUNTER_MASK >> 1)) {                        // Counter value precedes the reference point
+        return LastTime - ((LastCounter - Counter) & ENET_PTP_COUNTER_MASK);
+    }
+    return LastTime + Delta;
+}
+
+/*++
+Routine Description:
+    Computes the ENET timer correction for the requested frequency adjustment.
+    The counter is incremented by Inc each reference clock cycle, every CorrectionPeriod cycles by CorrectionInc instead.
+    CorrectionInc is Inc +/- 1, so CorrectionPeriod = ClockFrequencyHz / |1e9 + FrequencyPpb - Inc * ClockFrequencyHz|.
+    This also compensates the nominal error if ClockFrequencyHz is not an integer divisor of 1 GHz.
+Arguments:
+    ClockFrequencyHz    Timer reference clock frequency
+    Inc                 Nominal counter increment [ns]
+    FrequencyPpb        Frequency adjustment [ppb]
+    pCorrectionInc      Counter increment used every CorrectionPeriod cycles (ATINC[INC_CORR])
+Return Value:
+    Correction period (ATCOR), 0 if no correction is required
+--*/
+static __inline ULONG EnetPtpGetCorrection(_In_ ULONG ClockFrequencyHz, _In_ ULONG Inc, _In_ LONG FrequencyPpb, _Out_ PULONG pCorrectionInc)
+{
+    LONG64  Error = 1000000000LL + FrequencyPpb - (LONG64)Inc * ClockFrequencyHz;   // Nanoseconds per second the counter must gain (> 0) or lose (< 0)
+    ULONG64 AbsError;
+    ULONG64 Period;
+
+    *pCorrectionInc = Inc;
+    if (Error == 0) {
+        return 0;
+    }
+    AbsError = (Error > 0) ? (ULONG64)Error : (ULONG64)-Error;
+    *pCorrectionInc = (Error > 0) ? Inc + 1 : Inc - 1;
+    Period = (ClockFrequencyHz + AbsError / 2) / AbsError;               // Rounded to the nearest cycle count
+    if (Period == 0) {
+        Period = 1;                                                       // Every cycle corrected, the max adjustment is ClockFrequencyHz [ppb]
+    }
+    if (Period > ENET_ATCOR_COR_MASK) {
+        Period = ENET_ATCOR_COR_MASK;
+    }
+    return (ULONG)Period;
+}
+
+// IEEE 1588 clock functions
+_IRQL_requires_max_(PASSIVE_LEVEL)
+NDIS_STATUS MpPtpInit(_In_ PMP_ADAPTER pAdapter);
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void        MpPtpDeinit(_In_ PMP_ADAPTER pAdapter);
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void        EnetPtpStart(_In_ PMP_ADAPTER pAdapter);
+_IRQL_requires_max_(DISPATCH_LEVEL)
+ULONG64     MpPtpGetTime(_In_ PMP_ADAPTER pAdapter);
+_IRQL_requires_max_(DISPATCH_LEVEL)
+ULONG64     MpPtpTimestampToTime(_In_ PMP_ADAPTER pAdapter, _In_ ULONG Timestamp);
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void        MpPtpSetTime(_In_ PMP_ADAPTER pAdapter, _In_ ULONG64 Time);
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void        MpPtpAdjustTime(_In_ PMP_ADAPTER pAdapter, _In_ LONG64 Offset);
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void        MpPtpAdjustFrequency(_In_ PMP_ADAPTER pAdapter, _In_ LONG FrequencyPpb);
+_IRQL_requires_max_(PASSIVE_LEVEL)
+NDIS_STATUS MpPtpRegisterDevice(_In_ PMP_ADAPTER pAdapter, _In_ ULONG DeviceIndex);
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void        MpPtpDeregisterDevice(_In_ PMP_ADAPTER pAdapter);
+#if NDIS_SUPPORT_NDIS682
+_IRQL_requires_max_(PASSIVE_LEVEL)
+void        MpPtpIndicateCapabilities(_In_ PMP_ADAPTER pAdapter);
+void        MpPtpGetCapabilities(_In_ PMP_ADAPTER pAdapter, _Out_ PNDIS_TIMESTAMP_CAPABILITIES pCapabilities);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _MP_PTP_H
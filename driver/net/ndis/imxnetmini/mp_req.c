@@ -59,6 +59,13 @@ NDIS_OID ENETSupportedOids[] = {
     OID_802_3_RCV_OVERRUN,
     OID_802_3_XMIT_UNDERRUN,
     OID_PNP_SET_POWER,                             // Q: ""   S: "O"  RH
+    OID_TCP_OFFLOAD_PARAMETERS,
+#if NDIS_SUPPORT_NDIS682
+    // IEEE 1588 time stamping
+    OID_TIMESTAMP_CAPABILITY,
+    OID_TIMESTAMP_CURRENT_CONFIG,
+    OID_TIMESTAMP_GET_CROSSTIMESTAMP,
+#endif
 };
 
 ULONG ENETSupportedOidsSize = sizeof(ENETSupportedOids);
@@ -378,6 +385,10 @@ NDIS_STATUS MpQueryInformation(NDIS_HANDLE MiniportAdapterContext, PNDIS_OID_REQ
     ULONG                                 ulInfoLen               = sizeof(ulInfo);
     ULONG                                 ulBytesAvailable        = ulInfoLen;
     BOOLEAN                               DoCopy                  = TRUE;
+#if NDIS_SUPPORT_NDIS682
+    NDIS_TIMESTAMP_CAPABILITIES           TimestampCapabilities;
+    NDIS_HARDWARE_CROSSTIMESTAMP          CrossTimestamp;
+#endif
 
     DBG_ENET_DEV_OIDS_METHOD_BEG_WITH_PARAMS("%s",Dbg_GetNdisOidName(Oid));
     switch (Oid)  {    // Process different type of requests
@@ -467,18 +478,51 @@ NDIS_STATUS MpQueryInformation(NDIS_HANDLE MiniportAdapterContext, PNDIS_OID_REQ
             break;
 
         case OID_GEN_INTERRUPT_MODERATION:
-            // Miniport driver does not support interrupt moderation, the driver must specify NdisInterruptModerationNotSupported
+            // If ENET does not implement interrupt coalescing registers, the driver must specify NdisInterruptModerationNotSupported
             // in the InterruptModeration member of the NDIS_INTERRUPT_MODERATION_PARAMETERS structure.
             NdisZeroMemory(&ndisIntModParams, sizeof(ndisIntModParams));
             ndisIntModParams.Header.Type         = NDIS_OBJECT_TYPE_DEFAULT;
             ndisIntModParams.Header.Revision     = NDIS_INTERRUPT_MODERATION_PARAMETERS_REVISION_1;
             ndisIntModParams.Header.Size         = NDIS_SIZEOF_INTERRUPT_MODERATION_PARAMETERS_REVISION_1;
             ndisIntModParams.Flags               = 0;
-            ndisIntModParams.InterruptModeration = NdisInterruptModerationNotSupported;
+            if (!pAdapter->IntCoalescingSupported) {
+                ndisIntModParams.InterruptModeration = NdisInterruptModerationNotSupported;
+            } else if (pAdapter->InterruptModeration) {
+                ndisIntModParams.InterruptModeration = NdisInterruptModerationEnabled;
+            } else {
+                ndisIntModParams.InterruptModeration = NdisInterruptModerationDisabled;
+            }
             pInfo = &ndisIntModParams;
-            ulBytesAvailable = sizeof(ndisIntModParams);
+            ulInfoLen = ulBytesAvailable = sizeof(ndisIntModParams);
+            break;
+
+#if NDIS_SUPPORT_NDIS682
+        case OID_TIMESTAMP_CAPABILITY:
+        case OID_TIMESTAMP_CURRENT_CONFIG:
+            // Time stamping can only be enabled or disabled in the registry, the current configuration equals the capabilities.
+            MpPtpGetCapabilities(pAdapter, &TimestampCapabilities);
+            pInfo = &TimestampCapabilities;
+            ulInfoLen = ulBytesAvailable = sizeof(TimestampCapabilities);
             break;
 
+        case OID_TIMESTAMP_GET_CROSSTIMESTAMP:
+            // The hardware clock time bracketed by two performance counter samples.
+            if (!pAdapter->Ptp.Enabled) {
+                Status = NDIS_STATUS_NOT_SUPPORTED;
+                break;
+            }
+            NdisZeroMemory(&CrossTimestamp, sizeof(CrossTimestamp));
+            CrossTimestamp.Header.Type            = NDIS_OBJECT_TYPE_DEFAULT;
+            CrossTimestamp.Header.Revision        = NDIS_HARDWARE_CROSSTIMESTAMP_REVISION_1;
+            CrossTimestamp.Header.Size            = NDIS_SIZEOF_HARDWARE_CROSSTIMESTAMP_REVISION_1;
+            CrossTimestamp.SystemTimestamp1       = (ULONG64)KeQueryPerformanceCounter(NULL).QuadPart;
+            CrossTimestamp.HardwareClockTimestamp = MpPtpGetTime(pAdapter);
+            CrossTimestamp.SystemTimestamp2       = (ULONG64)KeQueryPerformanceCounter(NULL).QuadPart;
+            pInfo = &CrossTimestamp;
+            ulInfoLen = ulBytesAvailable = sizeof(CrossTimestamp);
+            break;
+#endif
+
         default:
             Status = NDIS_STATUS_NOT_SUPPORTED;
             DBG_ENET_DEV_OIDS_PRINT_INFO("%s not supported", Dbg_GetNdisOidName(Oid));
@@ -502,6 +546,79 @@ NDIS_STATUS MpQueryInformation(NDIS_HANDLE MiniportAdapterContext, PNDIS_OID_REQ
     return(Status);
 }
 
+/*++
+Routine Description:
+    Applies one NDIS_OFFLOAD_PARAMETERS checksum setting to the current adapter configuration.
+Arguments:
+    pSetting    Pointer to the adapter checksum offload setting (MP_CHECKSUM_OFFLOAD_xxx)
+    Value       NDIS_OFFLOAD_PARAMETERS_xxx value requested by the protocol
+Return Value:
+    None
+--*/
+static void MpUpdateChecksumOffloadSetting(_Inout_ PULONG pSetting, _In_ UCHAR Value)
+{
+    if (Value != NDIS_OFFLOAD_PARAMETERS_NO_CHANGE) {               // NDIS_OFFLOAD_PARAMETERS_TX_RX_DISABLED (1) .. NDIS_OFFLOAD_PARAMETERS_TX_AND_RX_ENABLED (4)
+        *pSetting = (ULONG)(Value - 1) & MP_CHECKSUM_OFFLOAD_TX_RX; // maps to MP_CHECKSUM_OFFLOAD_DISABLED .. MP_CHECKSUM_OFFLOAD_TX_RX
+    }
+}
+
+/*++
+Routine Description:
+    Handles OID_TCP_OFFLOAD_PARAMETERS request and indicates the new checksum offload configuration to NDIS.
+Arguments:
+    pAdapter                    Pointer to our adapter
+    InformationBuffer           Pointer to NDIS_OFFLOAD_PARAMETERS structure
+    InformationBufferLength     Size of the InformationBuffer
+Return Value:
+    NDIS_STATUS_SUCCESS
+    NDIS_STATUS_INVALID_LENGTH
+    NDIS_STATUS_INVALID_PARAMETER
+--*/
+static NDIS_STATUS MpSetOffloadParameters(_In_ PMP_ADAPTER pAdapter, _In_ PVOID InformationBuffer, _In_ ULONG InformationBufferLength)
+{
+    PNDIS_OFFLOAD_PARAMETERS    pParams = (PNDIS_OFFLOAD_PARAMETERS)InformationBuffer;
+    NDIS_OFFLOAD                Offload;
+    NDIS_STATUS_INDICATION      StatusIndication;
+
+    if (InformationBufferLength < NDIS_SIZEOF_OFFLOAD_PARAMETERS_REVISION_1) {
+        return NDIS_STATUS_INVALID_LENGTH;
+    }
+    if ((pParams->Header.Type != NDIS_OBJECT_TYPE_DEFAULT) || (pParams->Header.Revision < NDIS_OFFLOAD_PARAMETERS_REVISION_1) || (pParams->Header.Size < NDIS_SIZEOF_OFFLOAD_PARAMETERS_REVISION_1)) {
+        return NDIS_STATUS_INVALID_PARAMETER;
+    }
+    if ((pParams->LsoV1 > NDIS_OFFLOAD_PARAMETERS_LSOV1_DISABLED) || (pParams->IPsecV1 > NDIS_OFFLOAD_PARAMETERS_IPSECV1_DISABLED) ||
+        (pParams->LsoV2IPv4 > NDIS_OFFLOAD_PARAMETERS_LSOV2_DISABLED) || (pParams->LsoV2IPv6 > NDIS_OFFLOAD_PARAMETERS_LSOV2_DISABLED) ||
+        (pParams->TcpConnectionIPv4 > NDIS_OFFLOAD_PARAMETERS_CONNECTION_OFFLOAD_DISABLED) || (pParams->TcpConnectionIPv6 > NDIS_OFFLOAD_PARAMETERS_CONNECTION_OFFLOAD_DISABLED)) {
+        return NDIS_STATUS_INVALID_PARAMETER;                       // Only checksum offload is supported
+    }
+    if (!pAdapter->EnhancedBDs) {
+        if ((pParams->IPv4Checksum > NDIS_OFFLOAD_PARAMETERS_TX_RX_DISABLED) || (pParams->TCPIPv4Checksum > NDIS_OFFLOAD_PARAMETERS_TX_RX_DISABLED) ||
+            (pParams->UDPIPv4Checksum > NDIS_OFFLOAD_PARAMETERS_TX_RX_DISABLED) || (pParams->TCPIPv6Checksum > NDIS_OFFLOAD_PARAMETERS_TX_RX_DISABLED) ||
+            (pParams->UDPIPv6Checksum > NDIS_OFFLOAD_PARAMETERS_TX_RX_DISABLED)) {
+            return NDIS_STATUS_INVALID_PARAMETER;                   // Checksum offload requires enhanced buffer descriptors
+        }
+        return NDIS_STATUS_SUCCESS;
+    }
+    MpUpdateChecksumOffloadSetting(&pAdapter->IPChecksumOffloadIPv4,  pParams->IPv4Checksum);
+    MpUpdateChecksumOffloadSetting(&pAdapter->TCPChecksumOffloadIPv4, pParams->TCPIPv4Checksum);
+    MpUpdateChecksumOffloadSetting(&pAdapter->UDPChecksumOffloadIPv4, pParams->UDPIPv4Checksum);
+    MpUpdateChecksumOffloadSetting(&pAdapter->TCPChecksumOffloadIPv6, pParams->TCPIPv6Checksum);
+    MpUpdateChecksumOffloadSetting(&pAdapter->UDPChecksumOffloadIPv6, pParams->UDPIPv6Checksum);
+    DBG_ENET_DEV_OIDS_PRINT_INFO("Checksum offload IPv4: %d, TCPv4: %d, UDPv4: %d, TCPv6: %d, UDPv6: %d", pAdapter->IPChecksumOffloadIPv4, pAdapter->TCPChecksumOffloadIPv4, pAdapter->UDPChecksumOffloadIPv4, pAdapter->TCPChecksumOffloadIPv6, pAdapter->UDPChecksumOffloadIPv6);
+
+    MpFillOffload(pAdapter, &Offload, FALSE);
+    NdisZeroMemory(&StatusIndication, sizeof(NDIS_STATUS_INDICATION));
+    StatusIndication.Header.Type      = NDIS_OBJECT_TYPE_STATUS_INDICATION;
+    StatusIndication.Header.Revision  = NDIS_STATUS_INDICATION_REVISION_1;
+    StatusIndication.Header.Size      = NDIS_SIZEOF_STATUS_INDICATION_REVISION_1;
+    StatusIndication.SourceHandle     = pAdapter->AdapterHandle;
+    StatusIndication.StatusCode       = NDIS_STATUS_TASK_OFFLOAD_CURRENT_CONFIG;
+    StatusIndication.StatusBuffer     = (PVOID)&Offload;
+    StatusIndication.StatusBufferSize = sizeof(Offload);
+    NdisMIndicateStatusEx(pAdapter->AdapterHandle, &StatusIndication);  // Report new offload configuration
+    return NDIS_STATUS_SUCCESS;
+}
+
 /*++
 Routine Description:
     NDIS calls a miniport driver's MiniportOidRequest function to handle an OID request to query or set information in the driver.
@@ -600,6 +717,39 @@ NDIS_STATUS MpSetInformation(NDIS_HANDLE MiniportAdapterContext, PNDIS_OID_REQUE
               BytesRead = sizeof(NDIS_DEVICE_POWER_STATE);
           }
           break;
+
+        case OID_GEN_INTERRUPT_MODERATION:
+            if (InformationBufferLength < NDIS_SIZEOF_INTERRUPT_MODERATION_PARAMETERS_REVISION_1) {
+                BytesNeeded = NDIS_SIZEOF_INTERRUPT_MODERATION_PARAMETERS_REVISION_1;
+                Status = NDIS_STATUS_INVALID_LENGTH;
+                break;
+            }
+            if (!pAdapter->IntCoalescingSupported) {
+                Status = NDIS_STATUS_NOT_SUPPORTED;
+                break;
+            }
+            switch (((PNDIS_INTERRUPT_MODERATION_PARAMETERS)InformationBuffer)->InterruptModeration) {
+                case NdisInterruptModerationEnabled:
+                    EnetSetInterruptModeration(pAdapter, TRUE);
+                    break;
+                case NdisInterruptModerationDisabled:
+                    EnetSetInterruptModeration(pAdapter, FALSE);
+                    break;
+                default:
+                    Status = NDIS_STATUS_INVALID_DATA;
+                    break;
+            }
+            BytesRead = NDIS_SIZEOF_INTERRUPT_MODERATION_PARAMETERS_REVISION_1;
+            break;
+
+        case OID_TCP_OFFLOAD_PARAMETERS:
+            if ((Status = MpSetOffloadParameters(pAdapter, InformationBuffer, InformationBufferLength)) == NDIS_STATUS_INVALID_LENGTH) {
+                BytesNeeded = NDIS_SIZEOF_OFFLOAD_PARAMETERS_REVISION_1;
+            }
+            if (Status == NDIS_STATUS_SUCCESS) {
+                BytesRead = InformationBufferLength;
+            }
+            break;
         default:
             Status = NDIS_STATUS_NOT_SUPPORTED;
             DBG_ENET_DEV_OIDS_PRINT_INFO("%s not supported", Dbg_GetNdisOidName(Oid));
@@ -41,6 +41,7 @@
 #include "mp_mdio.h"
 #include "mp_enet_phy.h"
 #include "mp_hw.h"
+#include "mp_ptp.h"
 #include "mp.h"
 #include "mp_data_path.h"
 #include "mp_dbg.h"
@@ -58,6 +58,17 @@ typedef struct {
     UINT32 Regulator1V8Exist;
     UINT32 SlotCount;
 
+    //
+    // HS400 needs the strobe DLL found on iMX8M uSDHCs
+    //
+    UINT32 Hs400Supported;
+
+    //
+    // Opt-out of the eMMC command queuing engine found on iMX8M uSDHCs,
+    // which is otherwise used for cards that report CMDQ support
+    //
+    UINT32 CqeDisabled;
+
     //
     // Can power on/off SD/MMC slot supply voltage via
     // firmware
@@ -38,6 +38,39 @@ RECORDER_LOG DriverLogHandle = NULL;
 
 ULONG32 gForcePio = 0;
 
+//
+// Tuning block patterns as defined by SD and eMMC specs
+//
+static const UCHAR SdTuningBlockPattern4Bit[SD_TUNING_BLOCK_SIZE_4BIT] = {
+    0xFF, 0x0F, 0xFF, 0x00, 0xFF, 0xCC, 0xC3, 0xCC,
+    0xC3, 0x3C, 0xCC, 0xFF, 0xFE, 0xFF, 0xFE, 0xEF,
+    0xFF, 0xDF, 0xFF, 0xDD, 0xFF, 0xFB, 0xFF, 0xFB,
+    0xBF, 0xFF, 0x7F, 0xFF, 0x77, 0xF7, 0xBD, 0xEF,
+    0xFF, 0xF0, 0xFF, 0xF0, 0x0F, 0xFC, 0xCC, 0x3C,
+    0xCC, 0x33, 0xCC, 0xCF, 0xFF, 0xEF, 0xFF, 0xEE,
+    0xFF, 0xFD, 0xFF, 0xFD, 0xDF, 0xFF, 0xBF, 0xFF,
+    0xBB, 0xFF, 0xF7, 0xFF, 0xF7, 0x7F, 0x7B, 0xDE,
+};
+
+static const UCHAR MmcTuningBlockPattern8Bit[MMC_TUNING_BLOCK_SIZE_8BIT] = {
+    0xFF, 0xFF, 0x00, 0xFF, 0xFF, 0xFF, 0x00, 0x00,
+    0xFF, 0xFF, 0xCC, 0xCC, 0xCC, 0x33, 0xCC, 0xCC,
+    0xCC, 0x33, 0x33, 0xCC, 0xCC, 0xCC, 0xFF, 0xFF,
+    0xFF, 0xEE, 0xFF, 0xFF, 0xFF, 0xEE, 0xEE, 0xFF,
+    0xFF, 0xFF, 0xDD, 0xFF, 0xFF, 0xFF, 0xDD, 0xDD,
+    0xFF, 0xFF, 0xFF, 0xBB, 0xFF, 0xFF, 0xFF, 0xBB,
+    0xBB, 0xFF, 0xFF, 0xFF, 0x77, 0xFF, 0xFF, 0xFF,
+    0x77, 0x77, 0xFF, 0x77, 0xBB, 0xDD, 0xEE, 0xFF,
+    0xFF, 0xFF, 0xFF, 0x00, 0xFF, 0xFF, 0xFF, 0x00,
+    0x00, 0xFF, 0xFF, 0xCC, 0xCC, 0xCC, 0x33, 0xCC,
+    0xCC, 0xCC, 0x33, 0x33, 0xCC, 0xCC, 0xCC, 0xFF,
+    0xFF, 0xFF, 0xEE, 0xFF, 0xFF, 0xFF, 0xEE, 0xEE,
+    0xFF, 0xFF, 0xFF, 0xDD, 0xFF, 0xFF, 0xFF, 0xDD,
+    0xDD, 0xFF, 0xFF, 0xFF, 0xBB, 0xFF, 0xFF, 0xFF,
+    0xBB, 0xBB, 0xFF, 0xFF, 0xFF, 0x77, 0xFF, 0xFF,
+    0xFF, 0x77, 0x77, 0xFF, 0x77, 0xBB, 0xDD, 0xEE,
+};
+
 _Use_decl_annotations_
 NTSTATUS
 DriverEntry(
@@ -131,16 +164,11 @@ DriverEntry(
     //
     // Initialize the device properties bookkeeping data structures
     //
-    // N.B. Decision made to remove Device Properties List structure from current
-    //  release. Device Properties List was using _DSD to obtain information from
-    //  the platform in a manner that violates the _DSD specification.
-    //  However, the Device Properties List structure is necessary for future
-    //  enhancements to this driver so we are leaving it in the code.
-    //  Search for "DevicePropertiesList Code"
+    // N.B. Device properties are optional. A uSDHC without a _DSD device
+    //  properties package runs with the defaults, which keep 1.8V bus
+    //  speeds off. Search for "DevicePropertiesList Code"
     //
-#if 0   // DevicePropertiesList Code
     SdhcDevicePropertiesListInit();
-#endif
 
     //
     // Hook up the IRP dispatch routines
@@ -274,13 +302,6 @@ SdhcSlotInterrupt(
             admaSysAddr);
     }
 
-    if (intStatus.BRR || intStatus.BWR) {
-        USDHC_INT_STATUS_REG intStatusEnableMask = { 0 };
-        intStatusEnableMask.BRR = intStatus.BRR;
-        intStatusEnableMask.BWR = intStatus.BWR;
-        SdhcDisableInterrupt(sdhcExtPtr, intStatusEnableMask.AsUint32);
-    }
-
     //
     // Acknowledge/clear interrupt status. Request completions will occur in
     // the port driver's slot completion DPC. We need to make the members of 
@@ -289,6 +310,16 @@ SdhcSlotInterrupt(
     //
     SdhcAcknowledgeInterrupts(sdhcExtPtr, intStatus.AsUint32);
 
+    //
+    // CQE reports through INT_STATUS.CQI, completed tasks get accumulated
+    // in the completion bitmap and surface to Sdport as TC
+    //
+    BOOLEAN cqeHandled = FALSE;
+    if (sdhcExtPtr->CqeEnabled && (intStatus.AsUint32 & USDHC_INT_STATUS_CQI)) {
+        SdhcCqeInterrupt(sdhcExtPtr, &intStatus);
+        cqeHandled = TRUE;
+    }
+
     intStatus.CINS = 0;
     intStatus.CRM = 0;
     intStatus.CINT = 0;
@@ -300,7 +331,8 @@ SdhcSlotInterrupt(
         (*ErrorsPtr != 0) ||
         (*CardChangePtr) ||
         (*SdioInterruptPtr) ||
-        (*TuningPtr);
+        (*TuningPtr) ||
+        cqeHandled;
 
     USDHC_DDI_EXIT(sdhcExtPtr->IfrLogHandle, sdhcExtPtr, "%!bool!", handled);
     return handled;
@@ -364,14 +396,24 @@ SdhcSlotIssueRequest(
     switch (RequestPtr->Type) {
     case SdRequestTypeCommandNoTransfer:
     case SdRequestTypeCommandWithTransfer:
-        status = SdhcSendCommand(sdhcExtPtr, RequestPtr);
-        if (!NT_SUCCESS(status)) {
-            USDHC_LOG_ERROR_STATUS(
-                sdhcExtPtr->IfrLogHandle,
-                sdhcExtPtr,
-                status,
-                "SdhcSendCommand() failed");
+        //
+        // Requests that can't be started while command queue tasks or a
+        // legacy request are in flight wait for them, in arrival order
+        //
+        if ((sdhcExtPtr->CqeDeferredHead != sdhcExtPtr->CqeDeferredTail) ||
+            SdhcCqeMustDeferRequest(sdhcExtPtr, RequestPtr)) {
+
+            NT_ASSERT((sdhcExtPtr->CqeDeferredTail - sdhcExtPtr->CqeDeferredHead) <
+                      USDHC_CQE_MAX_OUTSTANDING_REQUESTS);
+
+            sdhcExtPtr->CqeDeferredRequests[
+                sdhcExtPtr->CqeDeferredTail % USDHC_CQE_MAX_OUTSTANDING_REQUESTS] = RequestPtr;
+            ++sdhcExtPtr->CqeDeferredTail;
+            status = STATUS_PENDING;
+            break;
         }
+
+        status = SdhcIssueCommandRequest(sdhcExtPtr, RequestPtr);
         break;
 
     case SdRequestTypeStartTransfer:
@@ -394,6 +436,11 @@ SdhcSlotIssueRequest(
             RequestPtr->Type);
     }
 
+    //
+    // A legacy transfer that just completed may unblock deferred requests
+    //
+    SdhcCqeIssueDeferredRequests(sdhcExtPtr);
+
     USDHC_DDI_EXIT(sdhcExtPtr->IfrLogHandle, sdhcExtPtr, "%!STATUS!", status);
     return status;
 }
@@ -422,7 +469,19 @@ SdhcSlotGetResponse(
     case SdResponseTypeR5B:
     {
         UINT32* bufferPtr = static_cast<UINT32*>(ResponseBufferPtr);
-        *bufferPtr = SdhcReadRegister(&registersPtr->CMD_RSP0);
+        ULONG tag;
+
+        //
+        // CQE issues CMD44/45/46/47 and CMD13 queue status polls on its own,
+        // CMD_RSP0 does not hold the queued command's R1. The card status
+        // CQCRA held when the task got reaped is reported instead, which is
+        // shared by all tasks reaped together
+        //
+        if (SdhcCqeFindTaskRequest(sdhcExtPtr, CommandPtr, &tag)) {
+            *bufferPtr = sdhcExtPtr->CqeTaskResponses[tag];
+        } else {
+            *bufferPtr = SdhcReadRegister(&registersPtr->CMD_RSP0);
+        }
         USDHC_LOG_INFORMATION(sdhcExtPtr->IfrLogHandle, sdhcExtPtr, "RSP[0]: %08X" , *bufferPtr);
     }
         break;
@@ -435,6 +494,17 @@ SdhcSlotGetResponse(
         bufferPtr[2] = SdhcReadRegister(&registersPtr->CMD_RSP2);
         bufferPtr[3] = SdhcReadRegister(&registersPtr->CMD_RSP3);
 
+        //
+        // Keep the card identity around to validate the tuning cache
+        //
+        if ((CommandPtr->Index == SD_CMD2_ALL_SEND_CID) ||
+            (CommandPtr->Index == SD_CMD10_SEND_CID)) {
+            RtlCopyMemory(
+                sdhcExtPtr->CurrentCardCid,
+                bufferPtr,
+                sizeof(sdhcExtPtr->CurrentCardCid));
+        }
+
         USDHC_LOG_INFORMATION(
             sdhcExtPtr->IfrLogHandle,
             sdhcExtPtr,
@@ -475,6 +545,17 @@ SdhcSlotRequestDpc(
         Events,
         Errors);
 
+    //
+    // Reap completed command queue tasks first, the request stays pending
+    // while its own task is still in flight
+    //
+    if ((sdhcExtPtr->CqeActiveTasks != 0) &&
+        !SdhcCqeCompleteTasks(sdhcExtPtr, RequestPtr, Errors)) {
+        SdhcCqeIssueDeferredRequests(sdhcExtPtr);
+        USDHC_DDI_EXIT(sdhcExtPtr->IfrLogHandle, sdhcExtPtr, "()");
+        return;
+    }
+
     //
     // Clear the request's required events if they have completed.
     //
@@ -527,6 +608,8 @@ SdhcSlotRequestDpc(
         SdhcCompleteRequest(sdhcExtPtr, RequestPtr, RequestPtr->Status);
     }
 
+    SdhcCqeIssueDeferredRequests(sdhcExtPtr);
+
     USDHC_DDI_EXIT(sdhcExtPtr->IfrLogHandle, sdhcExtPtr, "()");
 }
 
@@ -574,7 +657,18 @@ SdhcSlotToggleEvents(
     UINT32 InterruptMask = SdhcConvertStandardEventsToIntStatusMask(
         EventMask, 
         SDHC_ALL_STANDARD_ERRORS_MASK);
-    if (Enable) {
+
+    //
+    // CQE owns the interrupt enables until it gets halted, which restores
+    // the saved interrupt mask
+    //
+    if (sdhcExtPtr->CqeEnabled) {
+        if (Enable) {
+            sdhcExtPtr->CqeSavedInterruptMask |= InterruptMask;
+        } else {
+            sdhcExtPtr->CqeSavedInterruptMask &= ~InterruptMask;
+        }
+    } else if (Enable) {
         SdhcEnableInterrupt(sdhcExtPtr, InterruptMask);
     } else {
         SdhcDisableInterrupt(sdhcExtPtr, InterruptMask);
@@ -618,10 +712,12 @@ SdhcCleanup(
         NullPrivateExtensionPtr,
         "()");
 
-#if 0   //DevicePropertiesList Code
+    //
+    // DevicePropertiesList Code: there is no entry if the uSDHC has no
+    // device properties
+    //
     USDHC_DEVICE_PROPERTIES* devPropsPtr =
         DevicePropertiesListSafeFindByPdo(SdhcMiniportGetPdo(MiniportPtr));
-    NT_ASSERTMSG("Device properties entry should always exist", devPropsPtr != nullptr);
     if (devPropsPtr != nullptr) {
         //
         // The current design assumes and supports only 1 Slot. Which implies that for each
@@ -630,8 +726,9 @@ SdhcCleanup(
         NT_ASSERT(MiniportPtr->SlotCount == 1);
         (VOID)DevicePropertiesListSafeRemoveByKey(devPropsPtr->Key);
     }
-#endif
 
+    SdhcFreeCqeTaskLists(MiniportPtr);
+    SdhcFreeBounceSegments(MiniportPtr);
     SdhcLogCleanup(MiniportPtr);
     WPP_CLEANUP(NULL);
 }
@@ -695,6 +792,64 @@ SdhcAcknowledgeInterrupts(
     SdhcWriteRegister(&registersPtr->INT_STATUS, InterruptMask);
 }
 
+_Use_decl_annotations_
+NTSTATUS
+SdhcIssueCommandRequest(
+    USDHC_EXTENSION* SdhcExtPtr,
+    SDPORT_REQUEST* RequestPtr
+    )
+{
+    NTSTATUS status;
+    ULONG tag;
+
+    //
+    // Sdport reuses its requests, forget a task this one completed earlier
+    //
+    if (SdhcCqeFindTaskRequest(SdhcExtPtr, &RequestPtr->Command, &tag)) {
+        SdhcExtPtr->CqeTaskRequests[tag] = nullptr;
+    }
+
+    if (SdhcCqeIsQueueableRequest(SdhcExtPtr, RequestPtr)) {
+        status = SdhcCqeIssueRequest(SdhcExtPtr, RequestPtr);
+        if (!NT_SUCCESS(status)) {
+            USDHC_LOG_ERROR_STATUS(
+                SdhcExtPtr->IfrLogHandle,
+                SdhcExtPtr,
+                status,
+                "SdhcCqeIssueRequest() failed");
+        }
+
+    } else {
+        status = SdhcCqePrepareForCommand(SdhcExtPtr, RequestPtr);
+        if (!NT_SUCCESS(status)) {
+            USDHC_LOG_ERROR_STATUS(
+                SdhcExtPtr->IfrLogHandle,
+                SdhcExtPtr,
+                status,
+                "SdhcCqePrepareForCommand() failed");
+            return status;
+        }
+
+        status = SdhcSendCommand(SdhcExtPtr, RequestPtr);
+        if (!NT_SUCCESS(status)) {
+            USDHC_LOG_ERROR_STATUS(
+                SdhcExtPtr->IfrLogHandle,
+                SdhcExtPtr,
+                status,
+                "SdhcSendCommand() failed");
+        }
+    }
+
+    //
+    // A request that failed to start is not on the bus
+    //
+    if (!NT_SUCCESS(status) && (SdhcExtPtr->CqeLegacyRequestPtr == RequestPtr)) {
+        SdhcExtPtr->CqeLegacyRequestPtr = nullptr;
+    }
+
+    return status;
+}
+
 _Use_decl_annotations_
 NTSTATUS
 SdhcSendCommand(
@@ -707,6 +862,9 @@ SdhcSendCommand(
     USDHC_CMD_XFR_TYP_REG cmdXfrTyp = { 0 };
     NTSTATUS status;
 
+    SdhcExtPtr->CqeLegacyRequestPtr = RequestPtr;
+    SdhcExtPtr->CurrentTransferPio = FALSE;
+
     //
     // Initialize transfer parameters if this command is a data command
     //
@@ -719,10 +877,6 @@ SdhcSendCommand(
         }
     }
 
-    InterlockedExchange(
-        reinterpret_cast<volatile LONG*>(&SdhcExtPtr->CurrentTransferRemainingLength),
-        static_cast<LONG>(RequestPtr->Command.Length));
-
     //
     // Write the CMD argument
     //
@@ -815,19 +969,13 @@ SdhcSendCommand(
     // }
     //
 
-    if (cmdPtr->TransferMethod == SdTransferMethodSgDma) {
+    //
+    // Data transfers are carried by ADMA2, regardless of the transfer
+    // method Sdport chose, so the command completes once TC fires. A polled
+    // PIO transfer only completes after StartTransfer drained the FIFO
+    //
+    if (cmdXfrTyp.DPSEL && !SdhcExtPtr->CurrentTransferPio) {
         requiredEvents.TC = 1;
-    } else if (cmdPtr->TransferMethod == SdTransferMethodPio) {
-        if (cmdPtr->TransferDirection == SdTransferDirectionRead) {
-            requiredEvents.BRR = 1;
-        } else {
-            requiredEvents.BWR = 1;
-        }
-
-        USDHC_INT_STATUS_REG intStatusEnableMask = { 0 };
-        intStatusEnableMask.BRR = requiredEvents.BRR;
-        intStatusEnableMask.BWR = requiredEvents.BWR;
-        SdhcEnableInterrupt(SdhcExtPtr, intStatusEnableMask.AsUint32);
     }
 
     SdhcConvertIntStatusToStandardEvents(
@@ -878,12 +1026,23 @@ SdhcConfigureTransfer(
         }
     }
 
-    if (cmdPtr->TransferMethod == SdTransferMethodSgDma) {
-        mixCtrl.DMAEN= 1;
-    } else {
-        NT_ASSERT(cmdPtr->TransferMethod == SdTransferMethodPio);
+    NT_ASSERT(
+        (cmdPtr->TransferMethod == SdTransferMethodSgDma) ||
+        (cmdPtr->TransferMethod == SdTransferMethodPio));
+
+    //
+    // Without a bounce segment (crashdump), transfers ADMA2 can't reach
+    // directly fall back to polled PIO
+    //
+    if ((SdhcExtPtr->BounceSegmentPtr == nullptr) &&
+        (cmdPtr->DataBuffer != nullptr) &&
+        SdhcTransferNeedsBounce(SdhcExtPtr, RequestPtr)) {
+
+        SdhcExtPtr->CurrentTransferPio = TRUE;
     }
 
+    mixCtrl.DMAEN = SdhcExtPtr->CurrentTransferPio ? 0 : 1;
+
     mixCtrl.DTDSEL = 0;
     if (cmdPtr->TransferDirection == SdTransferDirectionRead) {
         mixCtrl.DTDSEL = 1;
@@ -899,13 +1058,13 @@ SdhcConfigureTransfer(
     //
     // Configure FIFO watermark levels to half the FIFO capacity
     // In case the whole transfer can fit in the FIFO, then use
-    // the whole transfer length as the FIFO threshold, so we do
-    // the read/write in one-shot
+    // the whole transfer length as the FIFO threshold, so ADMA2
+    // moves it in one burst sequence
     //
     USDHC_WTMK_LVL_REG wtmkLvl = { 0 };
     UINT32 fifoThresholdWordCount = USDHC_FIFO_MAX_WORD_COUNT / 2;
-    NT_ASSERT(cmdPtr->Length % sizeof(UINT32) == 0);
-    const UINT32 transferWordCount = cmdPtr->Length / sizeof(UINT32);
+    const UINT32 transferWordCount =
+        (cmdPtr->Length + sizeof(UINT32) - 1) / sizeof(UINT32);
     fifoThresholdWordCount = Min(transferWordCount, fifoThresholdWordCount);
 
     NT_ASSERT(fifoThresholdWordCount <= MAXUINT16);
@@ -918,274 +1077,1273 @@ SdhcConfigureTransfer(
 
     SdhcWriteRegister(&registersPtr->WTMK_LVL, wtmkLvl.AsUint32);
 
-    if (cmdPtr->TransferMethod == SdTransferMethodSgDma) {
-        NT_ASSERT(cmdPtr->ScatterGatherList != NULL);
-        //
-        // Create the ADMA2 descriptor table in the host's DMA buffer
-        //
-        NTSTATUS status = SdhcCreateAdmaDescriptorTable(SdhcExtPtr, RequestPtr);
-        if (!NT_SUCCESS(status)) {
-            return status;
-        }
+    if (SdhcExtPtr->CurrentTransferPio) {
+        return STATUS_SUCCESS;
+    }
 
-        NT_ASSERT(cmdPtr->DmaPhysicalAddress.HighPart == 0);
-        SdhcWriteRegister(
-            &registersPtr->ADMA_SYS_ADDR, 
-            static_cast<UINT32>(cmdPtr->DmaPhysicalAddress.LowPart));
+    PHYSICAL_ADDRESS descriptorTablePhysicalAddress;
+    NTSTATUS status = SdhcPrepareDescriptorTable(
+        SdhcExtPtr,
+        RequestPtr,
+        &descriptorTablePhysicalAddress);
+    if (!NT_SUCCESS(status)) {
+        return status;
     }
 
+    SdhcWriteRegister(
+        &registersPtr->ADMA_SYS_ADDR, 
+        static_cast<UINT32>(descriptorTablePhysicalAddress.LowPart));
+
     return STATUS_SUCCESS;
 }
 
 _Use_decl_annotations_
-VOID
-SdhcReadDataPort(
+NTSTATUS
+SdhcStartTransfer(
     USDHC_EXTENSION* SdhcExtPtr,
-    UINT32* BufferPtr,
-    UINT32 WordCount
+    SDPORT_REQUEST* RequestPtr
     )
 {
-    volatile USDHC_REGISTERS* registersPtr = SdhcExtPtr->RegistersPtr;
-    UINT32* readBufferPtr = static_cast<UINT32*>(BufferPtr);
+    NT_ASSERT(RequestPtr->Command.TransferType != SdTransferTypeNone);
 
-    while (WordCount) {
-        *readBufferPtr = SdhcReadRegisterNoFence(&registersPtr->DATA_BUFF_ACC_PORT);
-        ++readBufferPtr;
-        --WordCount;
+    if (SdhcExtPtr->CurrentTransferPio) {
+        return SdhcPollPioTransfer(SdhcExtPtr, RequestPtr);
     }
-}
 
-_Use_decl_annotations_
-VOID
-SdhcWriteDataPort(
-    USDHC_EXTENSION* SdhcExtPtr,
-    const UINT32* BufferPtr,
-    UINT32 WordCount
-    )
-{
-    volatile USDHC_REGISTERS* registersPtr = SdhcExtPtr->RegistersPtr;
-    const UINT32* writeBufferPtr = static_cast<const UINT32*>(BufferPtr);
+    switch (RequestPtr->Command.TransferMethod) {
+    case SdTransferMethodPio:
+    case SdTransferMethodSgDma:
+        return SdhcStartAdmaTransfer(SdhcExtPtr, RequestPtr);
 
-    while (WordCount) {
-        SdhcWriteRegisterNoFence(&registersPtr->DATA_BUFF_ACC_PORT, *writeBufferPtr);
-        ++writeBufferPtr;
-        --WordCount;
+    default:
+        NT_ASSERTMSG("Transfer method not supported", FALSE);
+        return STATUS_NOT_SUPPORTED;
     }
 }
 
 _Use_decl_annotations_
 NTSTATUS
-SdhcStartTransfer(
+SdhcStartAdmaTransfer(
     USDHC_EXTENSION* SdhcExtPtr,
     SDPORT_REQUEST* RequestPtr
     )
 {
-    NT_ASSERT(RequestPtr->Command.TransferType != SdTransferTypeNone);
-
-    switch (RequestPtr->Command.TransferMethod) {
-    case SdTransferMethodPio:
-        return SdhcStartPioTransfer(SdhcExtPtr, RequestPtr);
+    SDPORT_COMMAND* cmdPtr = &RequestPtr->Command;
 
-    case SdTransferMethodSgDma:
-        return SdhcStartAdmaTransfer(SdhcExtPtr, RequestPtr);
+    //
+    // ADMA2 has already moved the data by the time the command
+    // completed on TC, only bounced reads are left to be copied
+    // back to the caller's buffer
+    //
+    if (SdhcExtPtr->CurrentTransferBounced) {
+        if (cmdPtr->TransferDirection == SdTransferDirectionRead) {
+            RtlCopyMemory(
+                cmdPtr->DataBuffer,
+                SdhcExtPtr->BounceSegmentPtr + USDHC_BOUNCE_DATA_OFFSET,
+                cmdPtr->Length);
+
+            if (SdhcIsExtCsdRead(cmdPtr)) {
+                SdhcCqeReadCardSupport(
+                    SdhcExtPtr,
+                    SdhcExtPtr->BounceSegmentPtr + USDHC_BOUNCE_DATA_OFFSET);
+            }
+        }
 
-    default:
-        NT_ASSERTMSG("Transfer method not supported", FALSE);
-        return STATUS_NOT_SUPPORTED;
+        SdhcExtPtr->CurrentTransferBounced = FALSE;
     }
+
+    SdhcCompleteRequest(SdhcExtPtr, RequestPtr, STATUS_SUCCESS);
+    return STATUS_SUCCESS;
 }
 
 _Use_decl_annotations_
 NTSTATUS
-SdhcStartPioTransfer(
+SdhcPollPioTransfer(
     USDHC_EXTENSION* SdhcExtPtr,
     SDPORT_REQUEST* RequestPtr
     )
 {
     volatile USDHC_REGISTERS* registersPtr = SdhcExtPtr->RegistersPtr;
     SDPORT_COMMAND* cmdPtr = &RequestPtr->Command;
-
-    NT_ASSERT((cmdPtr->TransferDirection == SdTransferDirectionRead) ||
-              (cmdPtr->TransferDirection == SdTransferDirectionWrite));
+    const BOOLEAN isRead = (cmdPtr->TransferDirection == SdTransferDirectionRead);
 
     //
-    // PIO transfers are paced by FIFO interrupts, where each interrupt indicates that
-    // there is at least 1 RD_WML words to read or enough space for WR_WML words to write.
-    // To safely read/write to/from the FIFO without polling on any state bit, we should
-    // read exactly number of words equal to the FIFOs watermark for each interrupt
+    // Only used by crashdump, where interrupts are polled and the request
+    // can simply be waited on. The FIFO is moved in watermark sized bursts,
+    // a trailing partial word goes through a local word
     //
     USDHC_WTMK_LVL_REG wtmkLvl = { SdhcReadRegister(&registersPtr->WTMK_LVL) };
-    UINT32 subTransferLength;
+    const UINT32 burstWordCount = isRead ? wtmkLvl.RD_WML : wtmkLvl.WR_WML;
+    UCHAR* bufferPtr = cmdPtr->DataBuffer;
+    UINT32 remainingLength = cmdPtr->Length;
+    NTSTATUS status = STATUS_SUCCESS;
+
+    NT_ASSERT(burstWordCount != 0);
+
+    while (remainingLength != 0) {
+        USDHC_PRES_STATE_REG presState;
+        USDHC_INT_STATUS_REG intStatus;
+        UINT32 retries = USDHC_TUNING_COMMAND_RETRY_COUNT;
+
+        for (;;) {
+            presState.AsUint32 = SdhcReadRegister(&registersPtr->PRES_STATE);
+            intStatus.AsUint32 = SdhcReadRegister(&registersPtr->INT_STATUS);
+            if ((isRead ? presState.BREN : presState.BWEN) ||
+                (intStatus.AsUint32 & USDHC_INT_STATUS_DATA_ERROR) ||
+                (retries == 0)) {
+                break;
+            }
 
-    if (cmdPtr->TransferDirection == SdTransferDirectionRead) {
-        SdhcReadDataPort(SdhcExtPtr,
-                         reinterpret_cast<UINT32*>(cmdPtr->DataBuffer),
-                         wtmkLvl.RD_WML);
-        subTransferLength = (wtmkLvl.RD_WML * sizeof(UINT32));
-    } else {
-        SdhcWriteDataPort(SdhcExtPtr,
-                          reinterpret_cast<const UINT32*>(cmdPtr->DataBuffer),
-                          wtmkLvl.WR_WML);
-        subTransferLength = (wtmkLvl.WR_WML * sizeof(UINT32));
+            SdPortWait(USDHC_POLL_WAIT_TIME_US);
+            --retries;
+        }
+
+        if (intStatus.AsUint32 & USDHC_INT_STATUS_DATA_ERROR) {
+            status = STATUS_IO_DEVICE_ERROR;
+            break;
+        } else if (!(isRead ? presState.BREN : presState.BWEN)) {
+            status = STATUS_IO_TIMEOUT;
+            break;
+        }
+
+        for (UINT32 i = 0; (i < burstWordCount) && (remainingLength != 0); ++i) {
+            const UINT32 byteCount = Min(remainingLength, UINT32(sizeof(UINT32)));
+            UINT32 word = 0;
+
+            if (isRead) {
+                word = SdhcReadRegisterNoFence(&registersPtr->DATA_BUFF_ACC_PORT);
+                RtlCopyMemory(bufferPtr, &word, byteCount);
+            } else {
+                RtlCopyMemory(&word, bufferPtr, byteCount);
+                SdhcWriteRegisterNoFence(&registersPtr->DATA_BUFF_ACC_PORT, word);
+            }
+
+            bufferPtr += byteCount;
+            remainingLength -= byteCount;
+        }
     }
 
     //
-    // Achieve atomic subtraction by perform atomic add with negative transfer length
+    // The transfer is over once the DAT lines are released
     //
-    InterlockedExchangeAdd(
-        reinterpret_cast<volatile LONG*>(&SdhcExtPtr->CurrentTransferRemainingLength),
-        -static_cast<LONG>(subTransferLength));
+    if (NT_SUCCESS(status)) {
+        USDHC_PRES_STATE_REG presState;
+        USDHC_INT_STATUS_REG intStatus;
+        UINT32 retries = USDHC_TUNING_COMMAND_RETRY_COUNT;
+
+        for (;;) {
+            presState.AsUint32 = SdhcReadRegister(&registersPtr->PRES_STATE);
+            intStatus.AsUint32 = SdhcReadRegister(&registersPtr->INT_STATUS);
+            if ((!presState.CDIHB && !presState.DLA) ||
+                (intStatus.AsUint32 & USDHC_INT_STATUS_DATA_ERROR) ||
+                (retries == 0)) {
+                break;
+            }
 
-    USDHC_INT_STATUS_REG requiredEventsMask = { 0 };
+            SdPortWait(USDHC_POLL_WAIT_TIME_US);
+            --retries;
+        }
 
-    if (InterlockedCompareExchange(
-            reinterpret_cast<volatile LONG*>(&SdhcExtPtr->CurrentTransferRemainingLength),
-            0,
-            0) > 0) {
-        cmdPtr->DataBuffer += subTransferLength;
-        if (cmdPtr->TransferDirection == SdTransferDirectionRead) {
-            requiredEventsMask.BRR = 1;
-        } else {
-            requiredEventsMask.BWR = 1;
+        if (intStatus.AsUint32 & USDHC_INT_STATUS_DATA_ERROR) {
+            status = STATUS_IO_DEVICE_ERROR;
+        } else if (presState.CDIHB || presState.DLA) {
+            status = STATUS_IO_TIMEOUT;
         }
-        RequestPtr->Status = STATUS_MORE_PROCESSING_REQUIRED;
-    } else {
-        requiredEventsMask.TC = 1;
-        RequestPtr->Status = STATUS_SUCCESS;
     }
 
-    SdhcConvertIntStatusToStandardEvents(
-        requiredEventsMask,
-        &RequestPtr->RequiredEvents,
-        nullptr);
+    SdhcAcknowledgeInterrupts(
+        SdhcExtPtr,
+        USDHC_INT_STATUS_TC | USDHC_INT_STATUS_BRR | USDHC_INT_STATUS_BWR);
 
-    //
-    // Re-enable BRR and BWR if needed to chain the data transfer
-    //
-    // WORKAROUND: It is generally unsafe to enable interrupts from a DPC
-    // without the use of an interrupt synchronization construct, but
-    // it was found that uSDHC keeps firing the BRR and BWR interrupts and
-    // they don't get acknowledged as expected, so we disable them in the ISR
-    //
-    if (requiredEventsMask.BRR || requiredEventsMask.BWR) {
-        USDHC_INT_STATUS_REG intStatusEnableMask = { 0 };
-        intStatusEnableMask.BRR = requiredEventsMask.BRR;
-        intStatusEnableMask.BWR = requiredEventsMask.BWR;
-        SdhcEnableInterrupt(SdhcExtPtr, intStatusEnableMask.AsUint32);
+    SdhcExtPtr->CurrentTransferPio = FALSE;
+
+    if (!NT_SUCCESS(status)) {
+        USDHC_LOG_ERROR_STATUS(
+            SdhcExtPtr->IfrLogHandle,
+            SdhcExtPtr,
+            status,
+            "PIO transfer failed, %lu of %lu bytes left",
+            remainingLength,
+            cmdPtr->Length);
+
+        (VOID)SdhcResetHost(SdhcExtPtr, SdResetTypeDat);
+        return status;
     }
 
-    return STATUS_PENDING;
-}
+    if (isRead && SdhcIsExtCsdRead(cmdPtr)) {
+        SdhcCqeReadCardSupport(SdhcExtPtr, cmdPtr->DataBuffer);
+    }
 
-_Use_decl_annotations_
-NTSTATUS
-SdhcStartAdmaTransfer(
-    USDHC_EXTENSION* SdhcExtPtr,
-    SDPORT_REQUEST* RequestPtr
-    )
-{
     SdhcCompleteRequest(SdhcExtPtr, RequestPtr, STATUS_SUCCESS);
     return STATUS_SUCCESS;
 }
 
 _Use_decl_annotations_
 NTSTATUS
-SdhcCreateAdmaDescriptorTable(
+SdhcSendPolledCommand(
     USDHC_EXTENSION* SdhcExtPtr,
-    SDPORT_REQUEST* RequestPtr
+    UCHAR CommandIndex,
+    UINT32 Argument,
+    BOOLEAN WaitForBusy
     )
 {
-    USDHC_ADMA2_DESCRIPTOR_TABLE_ENTRY* descriptorPtr =
-        reinterpret_cast<USDHC_ADMA2_DESCRIPTOR_TABLE_ENTRY*>(RequestPtr->Command.DmaVirtualAddress);
-    ULONG sgListEelementCount = RequestPtr->Command.ScatterGatherList->NumberOfElements;
-    NT_ASSERT(sgListEelementCount > 0);
-    const SCATTER_GATHER_ELEMENT* sgListElementPtr = &RequestPtr->Command.ScatterGatherList->Elements[0];
-    PHYSICAL_ADDRESS nextAddress;
-    ULONG nextLength;
-    ULONG remainingLength;
-    ULONG tableEntryCount = 0;
+    volatile USDHC_REGISTERS* registersPtr = SdhcExtPtr->RegistersPtr;
+    USDHC_PRES_STATE_REG presState = { SdhcReadRegister(&registersPtr->PRES_STATE) };
+    UINT32 retries = USDHC_POLL_RETRY_COUNT;
+
+    while ((presState.CIHB || presState.CDIHB) && retries) {
+        SdPortWait(USDHC_POLL_WAIT_TIME_US);
+        --retries;
+        presState.AsUint32 = SdhcReadRegister(&registersPtr->PRES_STATE);
+    }
+
+    if (presState.CIHB || presState.CDIHB) {
+        NT_ASSERT(!retries);
+        return STATUS_IO_TIMEOUT;
+    }
 
     //
-    // Iterate through each element in the SG list and convert it into the
-    // descriptor table required by the controller.
+    // The command is polled, mask the interrupt signals so that the port
+    // driver ISR doesn't consume its status
     //
-    while (sgListEelementCount > 0) {
-        remainingLength = sgListElementPtr->Length;
-        nextAddress.QuadPart = sgListElementPtr->Address.QuadPart;
+    const UINT32 pollEvents = USDHC_INT_STATUS_CC | USDHC_INT_STATUS_TC | USDHC_INT_STATUS_CMD_ERROR;
+    const UINT32 intStatusEn = SdhcReadRegister(&registersPtr->INT_STATUS_EN);
+    const UINT32 intSignalEn = SdhcReadRegister(&registersPtr->INT_SIGNAL_EN);
+    SdhcWriteRegister(&registersPtr->INT_SIGNAL_EN, 0);
+    SdhcWriteRegister(&registersPtr->INT_STATUS_EN, intStatusEn | pollEvents);
+    SdhcAcknowledgeInterrupts(SdhcExtPtr, pollEvents);
 
-        NT_ASSERT(remainingLength > 0);
+    USDHC_MIX_CTRL_REG mixCtrl = { SdhcReadRegister(&registersPtr->MIX_CTRL) };
+    mixCtrl.DMAEN = 0;
+    mixCtrl.AC12EN = 0;
+    mixCtrl.AC23EN = 0;
+    SdhcWriteRegister(&registersPtr->MIX_CTRL, mixCtrl.AsUint32);
 
-        while (remainingLength > 0) {
+    SdhcWriteRegister(&registersPtr->CMD_ARG, Argument);
 
-            nextLength = Min(ULONG(SDHC_ADMA2_MAX_LENGTH_PER_ENTRY), remainingLength);
-            remainingLength -= nextLength;
+    USDHC_CMD_XFR_TYP_REG cmdXfrTyp = { 0 };
+    cmdXfrTyp.CMDINX = CommandIndex;
+    cmdXfrTyp.RSPTYP = USDHC_CMD_XFR_TYP_RSPTYP_RSP_48;
+    if (WaitForBusy) {
+        cmdXfrTyp.RSPTYP = USDHC_CMD_XFR_TYP_RSPTYP_RSP_48_CHK_BSY;
+    }
+    cmdXfrTyp.CCCEN = 1;
+    cmdXfrTyp.CICEN = 1;
+    cmdXfrTyp.CMDTYP = USDHC_CMD_XFR_TYP_CMDTYP_NORMAL;
+    SdhcWriteRegister(&registersPtr->CMD_XFR_TYP, cmdXfrTyp.AsUint32);
 
-            //
-            // Set the entry attributes and length.
-            //
-            descriptorPtr->AsUint64 = 0;
-            descriptorPtr->Valid = 1;
-            descriptorPtr->Action = USDHC_ADMA2_ACTION_TRAN;
+    USDHC_INT_STATUS_REG intStatus = { SdhcReadRegister(&registersPtr->INT_STATUS) };
+    retries = USDHC_POLL_RETRY_COUNT;
 
-            NT_ASSERT(nextLength <= SDHC_ADMA2_MAX_LENGTH_PER_ENTRY);
-            descriptorPtr->Length = static_cast<UINT32>(nextLength);
+    while (!intStatus.CC &&
+           !(intStatus.AsUint32 & USDHC_INT_STATUS_CMD_ERROR) &&
+           retries) {
+        SdPortWait(USDHC_POLL_WAIT_TIME_US);
+        --retries;
+        intStatus.AsUint32 = SdhcReadRegister(&registersPtr->INT_STATUS);
+    }
+
+    NTSTATUS status = STATUS_SUCCESS;
+
+    if (intStatus.AsUint32 & USDHC_INT_STATUS_CMD_ERROR) {
+        status = STATUS_IO_DEVICE_ERROR;
+    } else if (!intStatus.CC) {
+        status = STATUS_IO_TIMEOUT;
+    } else if (WaitForBusy) {
+        //
+        // Same as for R1b requests, TC does not fire on Busy deassertion
+        //
+        presState.AsUint32 = SdhcReadRegister(&registersPtr->PRES_STATE);
+        retries = USDHC_POLL_RETRY_COUNT;
+
+        while (presState.DLA && retries) {
+            SdPortWait(USDHC_POLL_WAIT_TIME_US);
+            --retries;
+            presState.AsUint32 = SdhcReadRegister(&registersPtr->PRES_STATE);
+        }
+
+        if (presState.DLA) {
+            status = STATUS_IO_TIMEOUT;
+        }
+    }
+
+    SdhcAcknowledgeInterrupts(SdhcExtPtr, pollEvents);
+    SdhcWriteRegister(&registersPtr->INT_STATUS_EN, intStatusEn);
+    SdhcWriteRegister(&registersPtr->INT_SIGNAL_EN, intSignalEn);
+
+    if (!NT_SUCCESS(status)) {
+        USDHC_LOG_ERROR_STATUS(
+            SdhcExtPtr->IfrLogHandle,
+            SdhcExtPtr,
+            status,
+            "CMD%lu(0x%08X) failed",
+            UINT32(CommandIndex),
+            Argument);
+
+        (VOID)SdhcResetHost(SdhcExtPtr, SdResetTypeCmd);
+        (VOID)SdhcResetHost(SdhcExtPtr, SdResetTypeDat);
+    }
+
+    return status;
+}
+
+_Use_decl_annotations_
+NTSTATUS
+SdhcCreateAdmaDescriptorTable(
+    USDHC_EXTENSION* SdhcExtPtr,
+    SDPORT_REQUEST* RequestPtr
+    )
+{
+    USDHC_ADMA2_DESCRIPTOR_TABLE_ENTRY* descriptorPtr =
+        reinterpret_cast<USDHC_ADMA2_DESCRIPTOR_TABLE_ENTRY*>(RequestPtr->Command.DmaVirtualAddress);
+    ULONG sgListEelementCount = RequestPtr->Command.ScatterGatherList->NumberOfElements;
+    NT_ASSERT(sgListEelementCount > 0);
+    const SCATTER_GATHER_ELEMENT* sgListElementPtr = &RequestPtr->Command.ScatterGatherList->Elements[0];
+    PHYSICAL_ADDRESS nextAddress;
+    ULONG nextLength;
+    ULONG remainingLength;
+    ULONG tableEntryCount = 0;
+
+    //
+    // Iterate through each element in the SG list and convert it into the
+    // descriptor table required by the controller.
+    //
+    while (sgListEelementCount > 0) {
+        remainingLength = sgListElementPtr->Length;
+        nextAddress.QuadPart = sgListElementPtr->Address.QuadPart;
+
+        NT_ASSERT(remainingLength > 0);
+
+        while (remainingLength > 0) {
+
+            nextLength = Min(ULONG(SDHC_ADMA2_MAX_LENGTH_PER_ENTRY), remainingLength);
+            remainingLength -= nextLength;
+
+            //
+            // Set the entry attributes and length.
+            //
+            descriptorPtr->AsUint64 = 0;
+            descriptorPtr->Valid = 1;
+            descriptorPtr->Action = USDHC_ADMA2_ACTION_TRAN;
+
+            NT_ASSERT(nextLength <= SDHC_ADMA2_MAX_LENGTH_PER_ENTRY);
+            descriptorPtr->Length = static_cast<UINT32>(nextLength);
+
+            //
+            // Segments above 4GB or off word boundaries were routed to the
+            // bounce segment by SdhcTransferNeedsBounce()
+            //
+            NT_ASSERT(nextAddress.HighPart == 0);
+            NT_ASSERT((ULONG_PTR(nextAddress.LowPart) & 0x3) == 0);
+            descriptorPtr->Address = static_cast<UINT32>(nextAddress.LowPart);
+    
+            nextAddress.QuadPart += nextLength;
+            ++descriptorPtr;
+            ++tableEntryCount;
+        }
+
+        ++sgListElementPtr;
+        --sgListEelementCount;
+    }
+
+    //
+    // Set the END bit at the last descriptor
+    //
+    --descriptorPtr;
+    descriptorPtr->End = 1;
+
+    USDHC_LOG_TRACE(
+        SdhcExtPtr->IfrLogHandle,
+        SdhcExtPtr,
+        "ADMA2 Descriptor Table Entry#:%lu PA:%p",
+        tableEntryCount,
+        reinterpret_cast<UINT32*>(RequestPtr->Command.DmaPhysicalAddress.LowPart));
+
+#if DEBUG_ADMA2_DESCRIPTOR_TABLE
+    descriptorPtr =
+        reinterpret_cast<USDHC_ADMA2_DESCRIPTOR_TABLE_ENTRY*>(RequestPtr->Command.DmaVirtualAddress);
+    for (UINT32 entryIdx = 0; entryIdx < tableEntryCount; ++entryIdx) {
+        USDHC_LOG_TRACE(
+            SdhcExtPtr->IfrLogHandle,
+            SdhcExtPtr,
+            "[Valid:%lu End:%lu Int:%lu Act:%lu Length:0x%X Addr:0x%p]",
+            descriptorPtr->Valid,
+            descriptorPtr->End,
+            descriptorPtr->Int,
+            descriptorPtr->Action,
+            descriptorPtr->Length,
+            reinterpret_cast<UINT32*>(descriptorPtr->Address));
+        ++descriptorPtr;
+    }
+#endif
+
+    return STATUS_SUCCESS;
+}
+
+_Use_decl_annotations_
+BOOLEAN
+SdhcTransferNeedsBounce(
+    USDHC_EXTENSION* SdhcExtPtr,
+    SDPORT_REQUEST* RequestPtr
+    )
+{
+    const SDPORT_COMMAND* cmdPtr = &RequestPtr->Command;
+
+    //
+    // PIO requests come with a virtual buffer only
+    //
+    if (cmdPtr->TransferMethod == SdTransferMethodPio) {
+        return TRUE;
+    }
+
+    //
+    // EXT_CSD is read through the non-cached bounce data area so that the
+    // card's command queuing support can be looked up once it arrived
+    //
+    if ((SdhcExtPtr->CqeTaskListPtr != nullptr) &&
+        (cmdPtr->DataBuffer != nullptr) &&
+        SdhcIsExtCsdRead(cmdPtr)) {
+        return TRUE;
+    }
+
+    //
+    // uSDHC FIFO is word wide, a transfer length that is not a multiple
+    // of a word can't be placed directly into the caller's buffer
+    //
+    if ((cmdPtr->Length & 0x3) != 0) {
+        return TRUE;
+    }
+
+    //
+    // ADMA_SYS_ADDR and the ADMA2 descriptor address field are 32-bit
+    //
+    if (cmdPtr->DmaPhysicalAddress.HighPart != 0) {
+        return TRUE;
+    }
+
+    NT_ASSERT(cmdPtr->ScatterGatherList != NULL);
+    const SCATTER_GATHER_ELEMENT* sgListElementPtr = &cmdPtr->ScatterGatherList->Elements[0];
+    for (ULONG i = 0; i < cmdPtr->ScatterGatherList->NumberOfElements; ++i) {
+        PHYSICAL_ADDRESS endAddress;
+        endAddress.QuadPart = sgListElementPtr->Address.QuadPart + sgListElementPtr->Length - 1;
+
+        if ((sgListElementPtr->Address.HighPart != 0) ||
+            (endAddress.HighPart != 0) ||
+            ((sgListElementPtr->Address.LowPart & 0x3) != 0) ||
+            ((sgListElementPtr->Length & 0x3) != 0)) {
+
+            return TRUE;
+        }
+
+        ++sgListElementPtr;
+    }
+
+    return FALSE;
+}
+
+_Use_decl_annotations_
+NTSTATUS
+SdhcCreateBounceDescriptorTable(
+    USDHC_EXTENSION* SdhcExtPtr,
+    SDPORT_REQUEST* RequestPtr
+    )
+{
+    SDPORT_COMMAND* cmdPtr = &RequestPtr->Command;
+
+    if (SdhcExtPtr->BounceSegmentPtr == nullptr) {
+        USDHC_LOG_ERROR(
+            SdhcExtPtr->IfrLogHandle,
+            SdhcExtPtr,
+            "Transfer needs the bounce segment which is not available");
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    if ((cmdPtr->DataBuffer == nullptr) ||
+        (cmdPtr->Length > USDHC_BOUNCE_DATA_LENGTH)) {
+        USDHC_LOG_ERROR(
+            SdhcExtPtr->IfrLogHandle,
+            SdhcExtPtr,
+            "Transfer can't be bounced DataBuffer:0x%p Length:%lu",
+            cmdPtr->DataBuffer,
+            cmdPtr->Length);
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    UCHAR* bounceDataPtr = SdhcExtPtr->BounceSegmentPtr + USDHC_BOUNCE_DATA_OFFSET;
+    if (cmdPtr->TransferDirection == SdTransferDirectionWrite) {
+        RtlCopyMemory(bounceDataPtr, cmdPtr->DataBuffer, cmdPtr->Length);
+    }
+
+    //
+    // The data area is contiguous, so only split it by the max length per
+    // entry. The last entry is padded up to a word since the FIFO is word
+    // wide, the padding lands in the bounce segment and is never copied back
+    //
+    USDHC_ADMA2_DESCRIPTOR_TABLE_ENTRY* descriptorPtr =
+        reinterpret_cast<USDHC_ADMA2_DESCRIPTOR_TABLE_ENTRY*>(SdhcExtPtr->BounceSegmentPtr);
+    UINT32 nextAddress =
+        SdhcExtPtr->BounceSegmentPhysicalAddress.LowPart + USDHC_BOUNCE_DATA_OFFSET;
+    ULONG remainingLength = (cmdPtr->Length + sizeof(UINT32) - 1) & ~ULONG(sizeof(UINT32) - 1);
+    ULONG nextLength;
+    ULONG tableEntryCount = 0;
+
+    NT_ASSERT(remainingLength > 0);
+
+    while (remainingLength > 0) {
+        nextLength = Min(ULONG(SDHC_ADMA2_MAX_LENGTH_PER_ENTRY), remainingLength);
+        remainingLength -= nextLength;
+
+        descriptorPtr->AsUint64 = 0;
+        descriptorPtr->Valid = 1;
+        descriptorPtr->Action = USDHC_ADMA2_ACTION_TRAN;
+        descriptorPtr->Length = static_cast<UINT32>(nextLength);
+        descriptorPtr->Address = nextAddress;
+
+        nextAddress += nextLength;
+        ++descriptorPtr;
+        ++tableEntryCount;
+    }
+
+    NT_ASSERT(tableEntryCount <= USDHC_BOUNCE_DESCRIPTOR_COUNT);
+
+    --descriptorPtr;
+    descriptorPtr->End = 1;
+
+    USDHC_LOG_TRACE(
+        SdhcExtPtr->IfrLogHandle,
+        SdhcExtPtr,
+        "ADMA2 Bounce Descriptor Table Entry#:%lu Length:%lu",
+        tableEntryCount,
+        cmdPtr->Length);
+
+    return STATUS_SUCCESS;
+}
+
+_Use_decl_annotations_
+NTSTATUS
+SdhcPrepareDescriptorTable(
+    USDHC_EXTENSION* SdhcExtPtr,
+    SDPORT_REQUEST* RequestPtr,
+    PHYSICAL_ADDRESS* DescriptorTablePhysicalAddressPtr
+    )
+{
+    //
+    // Transfers that the request's scatter/gather list can't describe
+    // directly go through the bounce segment, which carries its own
+    // descriptor table
+    //
+    NTSTATUS status;
+
+    SdhcExtPtr->CurrentTransferBounced = SdhcTransferNeedsBounce(SdhcExtPtr, RequestPtr);
+    if (SdhcExtPtr->CurrentTransferBounced) {
+        status = SdhcCreateBounceDescriptorTable(SdhcExtPtr, RequestPtr);
+        *DescriptorTablePhysicalAddressPtr = SdhcExtPtr->BounceSegmentPhysicalAddress;
+    } else {
+        //
+        // Create the ADMA2 descriptor table in the host's DMA buffer
+        //
+        status = SdhcCreateAdmaDescriptorTable(SdhcExtPtr, RequestPtr);
+        *DescriptorTablePhysicalAddressPtr = RequestPtr->Command.DmaPhysicalAddress;
+    }
+
+    if (!NT_SUCCESS(status)) {
+        SdhcExtPtr->CurrentTransferBounced = FALSE;
+        return status;
+    }
+
+    NT_ASSERT(DescriptorTablePhysicalAddressPtr->HighPart == 0);
+    return STATUS_SUCCESS;
+}
+
+_Use_decl_annotations_
+BOOLEAN
+SdhcCqeIsQueueableRequest(
+    USDHC_EXTENSION* SdhcExtPtr,
+    SDPORT_REQUEST* RequestPtr
+    )
+{
+    const SDPORT_COMMAND* cmdPtr = &RequestPtr->Command;
+
+    if ((SdhcExtPtr->CqeTaskListPtr == nullptr) ||
+        !SdhcExtPtr->CardCmdqSupported ||
+        !SdhcExtPtr->CardUserPartitionSelected ||
+        (RequestPtr->Type != SdRequestTypeCommandWithTransfer) ||
+        (cmdPtr->Class != SdCommandClassStandard) ||
+        (cmdPtr->BlockSize != MMC_BLOCK_SIZE)) {
+        return FALSE;
+    }
+
+    //
+    // Open ended transfers get stopped by Sdport with CMD12, a queued task
+    // always carries its block count
+    //
+    if ((cmdPtr->TransferType != SdTransferTypeSingleBlock) &&
+        (cmdPtr->TransferType != SdTransferTypeMultiBlock)) {
+        return FALSE;
+    }
+
+    switch (cmdPtr->Index) {
+    case SD_CMD17_READ_SINGLE_BLOCK:
+    case SD_CMD18_READ_MULTIPLE_BLOCK:
+    case SD_CMD24_WRITE_BLOCK:
+    case SD_CMD25_WRITE_MULTIPLE_BLOCK:
+        break;
+
+    default:
+        return FALSE;
+    }
+
+    //
+    // Tasks run concurrently, but there is a single bounce segment
+    //
+    return BOOLEAN(!SdhcTransferNeedsBounce(SdhcExtPtr, RequestPtr));
+}
+
+_Use_decl_annotations_
+UINT32
+SdhcCqeGetFreeTasks(
+    USDHC_EXTENSION* SdhcExtPtr
+    )
+{
+    const UINT32 queueDepthMask =
+        (SdhcExtPtr->CqeQueueDepth >= USDHC_CQE_TASK_COUNT) ?
+        MAXUINT32 : ((1UL << SdhcExtPtr->CqeQueueDepth) - 1);
+
+    return ~SdhcExtPtr->CqeActiveTasks & queueDepthMask;
+}
+
+_Use_decl_annotations_
+BOOLEAN
+SdhcCqeMustDeferRequest(
+    USDHC_EXTENSION* SdhcExtPtr,
+    SDPORT_REQUEST* RequestPtr
+    )
+{
+    if (SdhcExtPtr->CqeTaskListPtr == nullptr) {
+        return FALSE;
+    }
+
+    //
+    // A legacy command owns the bus until its transfer completed
+    //
+    if (SdhcExtPtr->CqeLegacyRequestPtr != nullptr) {
+        return TRUE;
+    }
+
+    if (SdhcExtPtr->CqeActiveTasks == 0) {
+        return FALSE;
+    }
+
+    //
+    // Other commands need the queue drained, a task needs a free slot
+    //
+    if (!SdhcCqeIsQueueableRequest(SdhcExtPtr, RequestPtr)) {
+        return TRUE;
+    }
+
+    return BOOLEAN(SdhcCqeGetFreeTasks(SdhcExtPtr) == 0);
+}
+
+_Use_decl_annotations_
+VOID
+SdhcCqeIssueDeferredRequests(
+    USDHC_EXTENSION* SdhcExtPtr
+    )
+{
+    while (SdhcExtPtr->CqeDeferredHead != SdhcExtPtr->CqeDeferredTail) {
+        SDPORT_REQUEST* requestPtr = SdhcExtPtr->CqeDeferredRequests[
+            SdhcExtPtr->CqeDeferredHead % USDHC_CQE_MAX_OUTSTANDING_REQUESTS];
+
+        if (SdhcCqeMustDeferRequest(SdhcExtPtr, requestPtr)) {
+            break;
+        }
+
+        ++SdhcExtPtr->CqeDeferredHead;
+
+        //
+        // Sdport got STATUS_PENDING for the request, so it gets completed here
+        //
+        NTSTATUS status = SdhcIssueCommandRequest(SdhcExtPtr, requestPtr);
+        if (!NT_SUCCESS(status)) {
+            SdhcCompleteRequest(SdhcExtPtr, requestPtr, status);
+        }
+    }
+}
+
+_Use_decl_annotations_
+BOOLEAN
+SdhcCqeFindTaskRequest(
+    USDHC_EXTENSION* SdhcExtPtr,
+    const SDPORT_COMMAND* CommandPtr,
+    ULONG* TagPtr
+    )
+{
+    for (ULONG tag = 0; tag < USDHC_CQE_TASK_COUNT; ++tag) {
+        const SDPORT_REQUEST* taskRequestPtr = SdhcExtPtr->CqeTaskRequests[tag];
+
+        if ((taskRequestPtr != nullptr) && (&taskRequestPtr->Command == CommandPtr)) {
+            *TagPtr = tag;
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+_Use_decl_annotations_
+NTSTATUS
+SdhcCqeIssueRequest(
+    USDHC_EXTENSION* SdhcExtPtr,
+    SDPORT_REQUEST* RequestPtr
+    )
+{
+    SDPORT_COMMAND* cmdPtr = &RequestPtr->Command;
+    NTSTATUS status;
+
+    //
+    // The card enters command queue mode on the first queued request after
+    // its identification, a card refusing it stays on the legacy path
+    //
+    if (!SdhcExtPtr->CardCmdqEnabled) {
+        status = SdhcCqeSetCardCmdqMode(SdhcExtPtr, TRUE);
+        if (!NT_SUCCESS(status)) {
+            USDHC_LOG_ERROR_STATUS(
+                SdhcExtPtr->IfrLogHandle,
+                SdhcExtPtr,
+                status,
+                "Card failed to enter command queue mode, command queuing disabled");
+
+            SdhcExtPtr->CardCmdqSupported = FALSE;
+            return SdhcSendCommand(SdhcExtPtr, RequestPtr);
+        }
+    }
+
+    if (!SdhcExtPtr->CqeEnabled) {
+        status = SdhcCqeEnable(SdhcExtPtr);
+        if (!NT_SUCCESS(status)) {
+            return status;
+        }
+    }
+
+    //
+    // Take the lowest free task slot within the card's queue depth
+    //
+    ULONG tag;
+
+    if (!BitScanForward(&tag, SdhcCqeGetFreeTasks(SdhcExtPtr))) {
+        return STATUS_DEVICE_BUSY;
+    }
+
+    PHYSICAL_ADDRESS descriptorTablePhysicalAddress;
+    status = SdhcPrepareDescriptorTable(
+        SdhcExtPtr,
+        RequestPtr,
+        &descriptorTablePhysicalAddress);
+    if (!NT_SUCCESS(status)) {
+        return status;
+    }
+
+    USDHC_CQE_TASK_DESCRIPTOR taskDescriptor = { 0 };
+    taskDescriptor.Valid = 1;
+    taskDescriptor.End = 1;
+    taskDescriptor.Int = 1;
+    taskDescriptor.Action = USDHC_CQE_TASK_ACTION_TASK;
+    taskDescriptor.DataDirection = USDHC_CQE_TASK_DIRECTION_WRITE;
+    if (cmdPtr->TransferDirection == SdTransferDirectionRead) {
+        taskDescriptor.DataDirection = USDHC_CQE_TASK_DIRECTION_READ;
+    }
+    taskDescriptor.BlockCount = cmdPtr->BlockCount;
+    taskDescriptor.BlockAddress = cmdPtr->Argument;
+
+    USDHC_ADMA2_DESCRIPTOR_TABLE_ENTRY linkDescriptor = { 0 };
+    linkDescriptor.Valid = 1;
+    linkDescriptor.Action = USDHC_ADMA2_ACTION_LINK;
+    linkDescriptor.Address = static_cast<UINT32>(descriptorTablePhysicalAddress.LowPart);
+
+    USDHC_CQE_TASK_SLOT* taskSlotPtr = &SdhcExtPtr->CqeTaskListPtr[tag];
+    taskSlotPtr->Task.AsUint64 = taskDescriptor.AsUint64;
+    taskSlotPtr->Link.AsUint64 = linkDescriptor.AsUint64;
+
+    SdhcExtPtr->CqeTaskRequests[tag] = RequestPtr;
+    SdhcExtPtr->CqeTaskResponses[tag] = 0;
+    SdhcExtPtr->CqeActiveTasks |= (1UL << tag);
+
+    USDHC_INT_STATUS_REG requiredEvents = { 0 };
+    requiredEvents.TC = 1;
+    SdhcConvertIntStatusToStandardEvents(
+        requiredEvents,
+        &RequestPtr->RequiredEvents,
+        nullptr);
+
+    USDHC_LOG_TRACE(
+        SdhcExtPtr->IfrLogHandle,
+        SdhcExtPtr,
+        "CQE Task:%lu %s Blocks#:%lu LBA:0x%x",
+        tag,
+        (cmdPtr->TransferDirection == SdTransferDirectionRead ? "Read" : "Write"),
+        (UINT32)cmdPtr->BlockCount,
+        cmdPtr->Argument);
+
+    //
+    // The task descriptor list is non-cached, ringing the doorbell hands
+    // the task over to the CQE
+    //
+    SdhcWriteRegister(&SdhcExtPtr->CqeRegistersPtr->CQTDBR, 1UL << tag);
+
+    return STATUS_PENDING;
+}
+
+_Use_decl_annotations_
+NTSTATUS
+SdhcCqePrepareForCommand(
+    USDHC_EXTENSION* SdhcExtPtr,
+    SDPORT_REQUEST* RequestPtr
+    )
+{
+    if (SdhcExtPtr->CqeTaskListPtr == nullptr) {
+        return STATUS_SUCCESS;
+    }
+
+    NTSTATUS status;
+
+    //
+    // Commands that are not queued go through the legacy path, which needs
+    // the CQE halted
+    //
+    if (SdhcExtPtr->CqeEnabled) {
+        status = SdhcCqeDisable(SdhcExtPtr);
+        if (!NT_SUCCESS(status)) {
+            return status;
+        }
+    }
+
+    const SDPORT_COMMAND* cmdPtr = &RequestPtr->Command;
+    if (cmdPtr->Class != SdCommandClassStandard) {
+        return STATUS_SUCCESS;
+    }
+
+    //
+    // Track the card state command queuing depends on, and take the card
+    // out of command queue mode ahead of the commands that are illegal in it
+    //
+    BOOLEAN exitCmdqMode = FALSE;
+
+    switch (cmdPtr->Index) {
+    case SD_CMD0_GO_IDLE_STATE:
+        SdhcExtPtr->CardCmdqSupported = FALSE;
+        SdhcExtPtr->CardCmdqEnabled = FALSE;
+        SdhcExtPtr->CardUserPartitionSelected = TRUE;
+        break;
+
+    case SD_CMD7_SELECT_CARD:
+        if ((cmdPtr->Argument >> 16) != 0) {
+            SdhcExtPtr->CardRca = static_cast<UINT16>(cmdPtr->Argument >> 16);
+        }
+        break;
+
+    case MMC_CMD6_SWITCH:
+        //
+        // Command queuing is limited to the user data area
+        //
+        if (MMC_CMD6_ARGUMENT_INDEX(cmdPtr->Argument) == MMC_EXT_CSD_PARTITION_CONFIG) {
+            SdhcExtPtr->CardUserPartitionSelected = BOOLEAN(
+                (MMC_CMD6_ARGUMENT_ACCESS(cmdPtr->Argument) == MMC_CMD6_ACCESS_WRITE_BYTE) &&
+                ((MMC_CMD6_ARGUMENT_VALUE(cmdPtr->Argument) & MMC_EXT_CSD_PARTITION_ACCESS_MASK) == 0));
+            exitCmdqMode = TRUE;
+        }
+        break;
+
+    case SD_CMD17_READ_SINGLE_BLOCK:
+    case SD_CMD18_READ_MULTIPLE_BLOCK:
+    case SD_CMD23_SET_BLOCK_COUNT:
+    case SD_CMD24_WRITE_BLOCK:
+    case SD_CMD25_WRITE_MULTIPLE_BLOCK:
+        //
+        // Reads and writes the CQE can't take, e.g open ended transfers
+        //
+        exitCmdqMode = TRUE;
+        break;
+
+    default:
+        break;
+    }
+
+    if (exitCmdqMode && SdhcExtPtr->CardCmdqEnabled) {
+        return SdhcCqeSetCardCmdqMode(SdhcExtPtr, FALSE);
+    }
+
+    return STATUS_SUCCESS;
+}
+
+_Use_decl_annotations_
+NTSTATUS
+SdhcCqeEnable(
+    USDHC_EXTENSION* SdhcExtPtr
+    )
+{
+    volatile USDHC_REGISTERS* registersPtr = SdhcExtPtr->RegistersPtr;
+    volatile USDHC_CQE_REGISTERS* cqeRegistersPtr = SdhcExtPtr->CqeRegistersPtr;
 
-            //
-            // The HighPart should not be a non-zero value, since in the
-            // DMA adapter object, we declared that this device only
-            // supports 32-bit addressing.
-            //
-            NT_ASSERT(nextAddress.HighPart == 0);
+    NT_ASSERT(!SdhcExtPtr->CqeEnabled);
 
-            //
-            // ADMA address field shall be set on word aligned boundaries
-            //
-            NT_ASSERT((ULONG_PTR(nextAddress.LowPart) & 0x3) == 0);
-            descriptorPtr->Address = static_cast<UINT32>(nextAddress.LowPart);
-    
-            nextAddress.QuadPart += nextLength;
-            ++descriptorPtr;
-            ++tableEntryCount;
-        }
+    //
+    // CQE gets stuck if it finds BREN set, which a tuning block consumed
+    // by the tuning circuit may leave behind
+    //
+    USDHC_PRES_STATE_REG presState = { SdhcReadRegister(&registersPtr->PRES_STATE) };
+    UINT32 retries = USDHC_FIFO_MAX_WORD_COUNT;
 
-        ++sgListElementPtr;
-        --sgListEelementCount;
+    while (presState.BREN && retries) {
+        (VOID)SdhcReadRegister(&registersPtr->DATA_BUFF_ACC_PORT);
+        --retries;
+        presState.AsUint32 = SdhcReadRegister(&registersPtr->PRES_STATE);
+    }
+
+    if (presState.BREN) {
+        USDHC_LOG_ERROR(
+            SdhcExtPtr->IfrLogHandle,
+            SdhcExtPtr,
+            "Unable to drain the read FIFO ahead of enabling CQE");
+        return STATUS_IO_DEVICE_ERROR;
     }
 
     //
-    // Set the END bit at the last descriptor
+    // CQE moves 512-byte blocks through ADMA2 and sends CMD44/45/46/47 on
+    // its own, the legacy command path leaves the transfer setup of its last
+    // command behind
     //
-    --descriptorPtr;
-    descriptorPtr->End = 1;
+    USDHC_MIX_CTRL_REG mixCtrl = { SdhcReadRegister(&registersPtr->MIX_CTRL) };
+    mixCtrl.DMAEN = 1;
+    mixCtrl.BCEN = 1;
+    mixCtrl.AC12EN = 0;
+    mixCtrl.AC23EN = 0;
+    mixCtrl.MSBSEL = 0;
+    mixCtrl.DTDSEL = 0;
+    SdhcWriteRegister(&registersPtr->MIX_CTRL, mixCtrl.AsUint32);
 
-    USDHC_LOG_TRACE(
+    USDHC_BLK_ATT_REG blkAtt = { 0 };
+    blkAtt.BLKSIZE = MMC_BLOCK_SIZE;
+    SdhcWriteRegister(&registersPtr->BLK_ATT, blkAtt.AsUint32);
+
+    USDHC_WTMK_LVL_REG wtmkLvl = { 0 };
+    wtmkLvl.RD_WML = USDHC_FIFO_MAX_WORD_COUNT / 2;
+    wtmkLvl.RD_BRST_LEN = 8;
+    wtmkLvl.WR_WML = wtmkLvl.RD_WML;
+    wtmkLvl.WR_BRST_LEN = wtmkLvl.RD_BRST_LEN;
+    SdhcWriteRegister(&registersPtr->WTMK_LVL, wtmkLvl.AsUint32);
+
+    //
+    // Only CQE, error and card detect interrupts while it runs, CQE's own
+    // commands would otherwise raise CC and TC
+    //
+    USDHC_INT_STATUS_REG savedInterruptMask = { SdhcReadRegister(&registersPtr->INT_STATUS_EN) };
+    USDHC_INT_STATUS_REG cqeInterruptMask = { USDHC_INT_STATUS_CQI | USDHC_INT_STATUS_ERROR };
+    cqeInterruptMask.CINS = savedInterruptMask.CINS;
+    cqeInterruptMask.CRM = savedInterruptMask.CRM;
+
+    SdhcExtPtr->CqeSavedInterruptMask = savedInterruptMask.AsUint32;
+    SdhcWriteRegister(&registersPtr->INT_STATUS_EN, cqeInterruptMask.AsUint32);
+    SdhcWriteRegister(&registersPtr->INT_SIGNAL_EN, cqeInterruptMask.AsUint32);
+
+    if (!SdhcExtPtr->CqeConfigured) {
+        USDHC_CQCFG_REG cqCfg = { 0 };
+        SdhcWriteRegister(&cqeRegistersPtr->CQCFG, cqCfg.AsUint32);
+
+        NT_ASSERT(SdhcExtPtr->CqeTaskListPhysicalAddress.HighPart == 0);
+        SdhcWriteRegister(
+            &cqeRegistersPtr->CQTDLBA,
+            SdhcExtPtr->CqeTaskListPhysicalAddress.LowPart);
+        SdhcWriteRegister(&cqeRegistersPtr->CQTDLBAU, 0);
+
+        //
+        // No interrupt coalescing, a task completion is reported right away.
+        // Halt completion is polled
+        //
+        SdhcWriteRegister(&cqeRegistersPtr->CQIC, 0);
+        SdhcWriteRegister(&cqeRegistersPtr->CQIS, USDHC_CQIS_ALL);
+        SdhcWriteRegister(&cqeRegistersPtr->CQISTE, USDHC_CQIS_ALL);
+        SdhcWriteRegister(&cqeRegistersPtr->CQISGE, USDHC_CQIS_TCC | USDHC_CQIS_RED);
+
+        cqCfg.CQ_EN = 1;
+        SdhcWriteRegister(&cqeRegistersPtr->CQCFG, cqCfg.AsUint32);
+        SdhcExtPtr->CqeConfigured = TRUE;
+    }
+
+    //
+    // CQE polls the card's queue status with CMD13 addressed by RCA
+    //
+    SdhcWriteRegister(&cqeRegistersPtr->CQSSC2, SdhcExtPtr->CardRca);
+
+    USDHC_CQCTL_REG cqCtl = { 0 };
+    SdhcWriteRegister(&cqeRegistersPtr->CQCTL, cqCtl.AsUint32);
+    SdhcExtPtr->CqeEnabled = TRUE;
+
+    return STATUS_SUCCESS;
+}
+
+_Use_decl_annotations_
+NTSTATUS
+SdhcCqeDisable(
+    USDHC_EXTENSION* SdhcExtPtr
+    )
+{
+    volatile USDHC_REGISTERS* registersPtr = SdhcExtPtr->RegistersPtr;
+    volatile USDHC_CQE_REGISTERS* cqeRegistersPtr = SdhcExtPtr->CqeRegistersPtr;
+
+    USDHC_CQCTL_REG cqCtl = { 0 };
+    cqCtl.HALT = 1;
+    SdhcWriteRegister(&cqeRegistersPtr->CQCTL, cqCtl.AsUint32);
+
+    UINT32 retries = USDHC_POLL_RETRY_COUNT;
+    cqCtl.AsUint32 = SdhcReadRegister(&cqeRegistersPtr->CQCTL);
+
+    while (!cqCtl.HALT && retries) {
+        SdPortWait(USDHC_POLL_WAIT_TIME_US);
+        --retries;
+        cqCtl.AsUint32 = SdhcReadRegister(&cqeRegistersPtr->CQCTL);
+    }
+
+    SdhcWriteRegister(&cqeRegistersPtr->CQIS, USDHC_CQIS_HAC);
+
+    SdhcWriteRegister(&registersPtr->INT_STATUS_EN, SdhcExtPtr->CqeSavedInterruptMask);
+    SdhcWriteRegister(&registersPtr->INT_SIGNAL_EN, SdhcExtPtr->CqeSavedInterruptMask);
+    SdhcExtPtr->CqeEnabled = FALSE;
+
+    if (!cqCtl.HALT) {
+        NT_ASSERT(!retries);
+        USDHC_LOG_ERROR(
+            SdhcExtPtr->IfrLogHandle,
+            SdhcExtPtr,
+            "Time-out waiting on CQE to halt");
+        return STATUS_IO_TIMEOUT;
+    }
+
+    return STATUS_SUCCESS;
+}
+
+_Use_decl_annotations_
+NTSTATUS
+SdhcCqeRecover(
+    USDHC_EXTENSION* SdhcExtPtr
+    )
+{
+    volatile USDHC_CQE_REGISTERS* cqeRegistersPtr = SdhcExtPtr->CqeRegistersPtr;
+
+    USDHC_LOG_ERROR(
         SdhcExtPtr->IfrLogHandle,
         SdhcExtPtr,
-        "ADMA2 Descriptor Table Entry#:%lu PA:%p",
-        tableEntryCount,
-        reinterpret_cast<UINT32*>(RequestPtr->Command.DmaPhysicalAddress.LowPart));
+        "CQE error recovery ActiveTasks:0x%08X DoorBell:0x%08X",
+        SdhcExtPtr->CqeActiveTasks,
+        SdhcReadRegister(&cqeRegistersPtr->CQTDBR));
 
-#if DEBUG_ADMA2_DESCRIPTOR_TABLE
-    descriptorPtr =
-        reinterpret_cast<USDHC_ADMA2_DESCRIPTOR_TABLE_ENTRY*>(RequestPtr->Command.DmaVirtualAddress);
-    for (UINT32 entryIdx = 0; entryIdx < tableEntryCount; ++entryIdx) {
-        USDHC_LOG_TRACE
+    if (SdhcExtPtr->CqeEnabled) {
+        (VOID)SdhcCqeDisable(SdhcExtPtr);
+    }
+
+    //
+    // The failed task left the CMD and DAT lines in an unknown state, and
+    // the card may still hold queued tasks that have to be discarded. The
+    // stop command only matters if a data transfer was cut short
+    //
+    (VOID)SdhcResetHost(SdhcExtPtr, SdResetTypeCmd);
+    (VOID)SdhcResetHost(SdhcExtPtr, SdResetTypeDat);
+    (VOID)SdhcSendPolledCommand(SdhcExtPtr, SD_CMD12_STOP_TRANSMISSION, 0, TRUE);
+    NTSTATUS status = SdhcSendPolledCommand(
+        SdhcExtPtr,
+        MMC_CMD48_CMDQ_TASK_MGMT,
+        MMC_CMD48_DISCARD_QUEUE,
+        TRUE);
+
+    USDHC_CQCTL_REG cqCtl = { 0 };
+    cqCtl.HALT = 1;
+    cqCtl.CLEAR_ALL_TASKS = 1;
+    SdhcWriteRegister(&cqeRegistersPtr->CQCTL, cqCtl.AsUint32);
+
+    UINT32 doorBell = SdhcReadRegister(&cqeRegistersPtr->CQTDBR);
+    UINT32 retries = USDHC_POLL_RETRY_COUNT;
+
+    while ((doorBell != 0) && retries) {
+        SdPortWait(USDHC_POLL_WAIT_TIME_US);
+        --retries;
+        doorBell = SdhcReadRegister(&cqeRegistersPtr->CQTDBR);
+    }
+
+    if (doorBell != 0) {
+        NT_ASSERT(!retries);
+        status = STATUS_IO_TIMEOUT;
+    }
+
+    SdhcWriteRegister(&cqeRegistersPtr->CQTCN, SdhcReadRegister(&cqeRegistersPtr->CQTCN));
+    SdhcWriteRegister(&cqeRegistersPtr->CQIS, USDHC_CQIS_ALL);
+    SdhcExtPtr->CqeCompletedTasks = 0;
+
+    if (!NT_SUCCESS(status)) {
+        USDHC_LOG_ERROR_STATUS(
             SdhcExtPtr->IfrLogHandle,
             SdhcExtPtr,
-            "[Valid:%lu End:%lu Int:%lu Act:%lu Length:0x%X Addr:0x%p]",
-            descriptorPtr->Valid,
-            descriptorPtr->End,
-            descriptorPtr->Int,
-            descriptorPtr->Action,
-            descriptorPtr->Length,
-            reinterpret_cast<UINT32*>(descriptorPtr->Address));
-        ++descriptorPtr;
+            status,
+            "CQE error recovery failed");
     }
-#endif
+
+    return status;
+}
+
+_Use_decl_annotations_
+NTSTATUS
+SdhcCqeSetCardCmdqMode(
+    USDHC_EXTENSION* SdhcExtPtr,
+    BOOLEAN Enable
+    )
+{
+    NT_ASSERT(!SdhcExtPtr->CqeEnabled);
+
+    NTSTATUS status = SdhcSendPolledCommand(
+        SdhcExtPtr,
+        MMC_CMD6_SWITCH,
+        MMC_CMD6_ARGUMENT(MMC_EXT_CSD_CMDQ_MODE_EN, (Enable ? 1 : 0)),
+        TRUE);
+    if (!NT_SUCCESS(status)) {
+        return status;
+    }
+
+    SdhcExtPtr->CardCmdqEnabled = Enable;
+
+    USDHC_LOG_INFORMATION(
+        SdhcExtPtr->IfrLogHandle,
+        SdhcExtPtr,
+        "Card command queue mode:%!bool!",
+        UINT32(Enable));
 
     return STATUS_SUCCESS;
 }
 
+_Use_decl_annotations_
+VOID
+SdhcCqeInterrupt(
+    USDHC_EXTENSION* SdhcExtPtr,
+    USDHC_INT_STATUS_REG* IntStatusPtr
+    )
+{
+    volatile USDHC_CQE_REGISTERS* cqeRegistersPtr = SdhcExtPtr->CqeRegistersPtr;
+    const UINT32 cqIs = SdhcReadRegister(&cqeRegistersPtr->CQIS);
+
+    SdhcWriteRegister(&cqeRegistersPtr->CQIS, cqIs);
+
+    if (cqIs & USDHC_CQIS_TCC) {
+        const UINT32 completedTasks = SdhcReadRegister(&cqeRegistersPtr->CQTCN);
+        SdhcWriteRegister(&cqeRegistersPtr->CQTCN, completedTasks);
+        InterlockedOr(&SdhcExtPtr->CqeCompletedTasks, static_cast<LONG>(completedTasks));
+        IntStatusPtr->TC = 1;
+    }
+
+    //
+    // The card flagged an error in the response to one of CQE's commands,
+    // which is reported the same way as a bad command response
+    //
+    if (cqIs & USDHC_CQIS_RED) {
+        USDHC_CQTERRI_REG cqTerri = { SdhcReadRegister(&cqeRegistersPtr->CQTERRI) };
+        USDHC_LOG_ERROR(
+            SdhcExtPtr->IfrLogHandle,
+            SdhcExtPtr,
+            "CQE response error CMD%lu Task:%lu CQCRA:0x%08X",
+            cqTerri.RMECI,
+            cqTerri.RMETI,
+            SdhcReadRegister(&cqeRegistersPtr->CQCRA));
+        IntStatusPtr->CIE = 1;
+    }
+
+    IntStatusPtr->TP = 0;
+}
+
+_Use_decl_annotations_
+BOOLEAN
+SdhcCqeCompleteTasks(
+    USDHC_EXTENSION* SdhcExtPtr,
+    SDPORT_REQUEST* RequestPtr,
+    ULONG Errors
+    )
+{
+    const UINT32 completedTasks =
+        static_cast<UINT32>(InterlockedExchange(&SdhcExtPtr->CqeCompletedTasks, 0)) &
+        SdhcExtPtr->CqeActiveTasks;
+
+    //
+    // CQCRA holds the card status the CQE got back for its last command,
+    // which is what Sdport gets as the response of the reaped tasks.
+    // The CQE latches no per task response, so all tasks reaped in one
+    // pass report the same card status. Errors are per task regardless,
+    // through CQTERRI and the recovery below
+    //
+    const UINT32 cqCra = SdhcReadRegister(&SdhcExtPtr->CqeRegistersPtr->CQCRA);
+
+    //
+    // An error fails every task that has not completed yet, the CQE gets
+    // recovered with all tasks cleared
+    //
+    if (Errors != 0) {
+        (VOID)SdhcCqeRecover(SdhcExtPtr);
+    }
+
+    const NTSTATUS errorStatus = SdhcConvertStandardErrorToStatus(Errors);
+    BOOLEAN requestDone = TRUE;
+    UINT32 remainingTasks = SdhcExtPtr->CqeActiveTasks;
+    ULONG tag;
+
+    while (BitScanForward(&tag, remainingTasks)) {
+        const UINT32 taskMask = 1UL << tag;
+        remainingTasks &= ~taskMask;
+
+        SDPORT_REQUEST* taskRequestPtr = SdhcExtPtr->CqeTaskRequests[tag];
+        const BOOLEAN taskCompleted = BOOLEAN((completedTasks & taskMask) != 0);
+
+        if (!taskCompleted && (Errors == 0)) {
+            if (taskRequestPtr == RequestPtr) {
+                requestDone = FALSE;
+            }
+            continue;
+        }
+
+        SdhcExtPtr->CqeTaskResponses[tag] = cqCra;
+        SdhcExtPtr->CqeActiveTasks &= ~taskMask;
+
+        //
+        // The request the DPC runs for is completed by the caller
+        //
+        if (taskRequestPtr != RequestPtr) {
+            SdhcCompleteRequest(
+                SdhcExtPtr,
+                taskRequestPtr,
+                taskCompleted ? STATUS_SUCCESS : errorStatus);
+        }
+    }
+
+    return requestDone;
+}
+
+_Use_decl_annotations_
+VOID
+SdhcCqeReadCardSupport(
+    USDHC_EXTENSION* SdhcExtPtr,
+    const UCHAR* ExtCsdPtr
+    )
+{
+    SdhcExtPtr->CardCmdqSupported =
+        BOOLEAN((ExtCsdPtr[MMC_EXT_CSD_CMDQ_SUPPORT] & 0x1) != 0);
+    SdhcExtPtr->CardCmdqEnabled =
+        BOOLEAN((ExtCsdPtr[MMC_EXT_CSD_CMDQ_MODE_EN] & 0x1) != 0);
+    SdhcExtPtr->CqeQueueDepth = Min(
+        UINT32(ExtCsdPtr[MMC_EXT_CSD_CMDQ_DEPTH] & MMC_EXT_CSD_CMDQ_DEPTH_MASK) + 1,
+        UINT32(USDHC_CQE_TASK_COUNT));
+
+    USDHC_LOG_INFORMATION(
+        SdhcExtPtr->IfrLogHandle,
+        SdhcExtPtr,
+        "Card command queuing Supported:%!bool! Depth:%lu Enabled:%!bool!",
+        UINT32(SdhcExtPtr->CardCmdqSupported),
+        SdhcExtPtr->CqeQueueDepth,
+        UINT32(SdhcExtPtr->CardCmdqEnabled));
+}
+
 UINT32
 SdhcConvertStandardEventsToIntStatusMask(
     _In_ ULONG StdEventMask,
@@ -1319,6 +2477,15 @@ SdhcCompleteRequest(
 
     RequestPtr->Status = Status;
 
+    //
+    // A legacy data command keeps the bus until Sdport's follow-up
+    // StartTransfer request completes
+    //
+    if ((RequestPtr == SdhcExtPtr->CqeLegacyRequestPtr) &&
+        ((RequestPtr->Type != SdRequestTypeCommandWithTransfer) || !NT_SUCCESS(Status))) {
+        SdhcExtPtr->CqeLegacyRequestPtr = nullptr;
+    }
+
     switch (RequestPtr->Type) {
     case SdRequestTypeCommandNoTransfer:
     case SdRequestTypeCommandWithTransfer:
@@ -1391,24 +2558,27 @@ SdhcGetSlotCount(
     USDHC_DDI_ENTER(DriverLogHandle, NullPrivateExtensionPtr, "()");
     NTSTATUS status;
 
-#if 0   // DevicePropertiesList Code
-    DEVICE_OBJECT* sdhcPdoPtr = SdhcMiniportGetPdo(MiniportPtr);
-    USDHC_DEVICE_PROPERTIES* devPropsPtr;
-
     //
-    // Read Device Properties associated with the SDHC PDO
+    // DevicePropertiesList Code: read Device Properties associated with
+    // the SDHC PDO, SdhcSlotInitialize picks them up by register base.
+    // Without them the slot runs with the defaults, as it does in
+    // crashdump where ACPI can't be evaluated
     //
-    status = SdhcReadDeviceProperties(sdhcPdoPtr, &devPropsPtr);
+    DEVICE_OBJECT* sdhcPdoPtr = SdhcMiniportGetPdo(MiniportPtr);
+
+    status = STATUS_NOT_SUPPORTED;
+    if (KeGetCurrentIrql() <= APC_LEVEL) {
+        status = SdhcReadDeviceProperties(sdhcPdoPtr, nullptr);
+    }
+
     if (!NT_SUCCESS(status)) {
-        USDHC_LOG_ERROR_STATUS(
+        USDHC_LOG_INFORMATION(
             DriverLogHandle,
             NullPrivateExtensionPtr,
-            status,
-            "Failed to read Device Properties for SDHC PDO:0x%p",
-            sdhcPdoPtr);
-        goto Cleanup;
+            "No Device Properties for SDHC PDO:0x%p, using defaults (status:%!STATUS!)",
+            sdhcPdoPtr,
+            status);
     }
-#endif
 
     switch (MiniportPtr->ConfigurationInfo.BusType) {
     case SdBusTypeAcpi:
@@ -1504,45 +2674,87 @@ SdhcSlotInitialize(
     //
     if (!CrashdumpMode) {
         SdhcLogInit(sdhcExtPtr);
-#if 0   // DevicePropertiesList Code
+
+        //
+        // Crashdump runs at high IRQL and can't allocate the bounce segment,
+        // dump transfers ADMA2 can't reach directly use polled PIO instead
+        //
+        status = SdhcAllocateBounceSegment(sdhcExtPtr);
+        if (!NT_SUCCESS(status)) {
+            USDHC_LOG_ERROR_STATUS(
+                sdhcExtPtr->IfrLogHandle,
+                sdhcExtPtr,
+                status,
+                "SdhcAllocateBounceSegment() failed");
+
+            goto Cleanup;
+        }
+
         //
-        // Grab device properties and keep a local copy of it
+        // DevicePropertiesList Code: grab device properties read by the
+        // preceding GetSlotCount bus operation and keep a local copy of it
         //
         USDHC_DEVICE_PROPERTIES* devPropsPtr =
-            DevicePropertiesListSafeFindByKey(
-                reinterpret_cast<UINT32>(sdhcExtPtr->PhysicalAddress));
-        if (devPropsPtr == nullptr) {
-            NT_ASSERTMSG("Can't operate without device properties", FALSE);
-            //
-            // We should have been preceded by GetSlotCount bus operation in which
-            // we should have read the device properties
-            //
-            USDHC_LOG_ERROR(
+            DevicePropertiesListSafeFindByKey(PhysicalBase.LowPart);
+        if (devPropsPtr != nullptr) {
+            RtlCopyMemory(
+                &sdhcExtPtr->DeviceProperties,
+                devPropsPtr,
+                sizeof(*devPropsPtr));
+        } else {
+            USDHC_LOG_INFORMATION(
                 sdhcExtPtr->IfrLogHandle,
                 sdhcExtPtr,
-                "Unable to locate Device Properties entry for uSDHC with "
-                "PhysicalAddress:0x%p",
+                "No Device Properties entry for uSDHC with PhysicalAddress:0x%p, "
+                "using defaults",
                 sdhcExtPtr->PhysicalAddress);
-            status = STATUS_DEVICE_CONFIGURATION_ERROR;
-            goto Cleanup;
         }
 
-        RtlCopyMemory(
-            &sdhcExtPtr->DeviceProperties,
-            devPropsPtr,
-            sizeof(*devPropsPtr));
-#endif
+        //
+        // The CQE is optional. uSDHCs without one (e.g iMX6) read CQVER
+        // as 0. Whether it's used is up to the card's EXT_CSD CMDQ_SUPPORT,
+        // see SdhcCqeIsQueueableRequest(). Run without it if the task
+        // descriptor list can't be allocated
+        //
+        volatile USDHC_CQE_REGISTERS* cqeRegistersPtr =
+            reinterpret_cast<USDHC_CQE_REGISTERS*>(
+                static_cast<UCHAR*>(VirtualBasePtr) + USDHC_CQE_REGISTERS_OFFSET);
+
+        if ((sdhcExtPtr->DeviceProperties.CqeDisabled == 0) &&
+            (Length >= (USDHC_CQE_REGISTERS_OFFSET + sizeof(USDHC_CQE_REGISTERS))) &&
+            (SdhcReadRegister(&cqeRegistersPtr->CQVER) != 0)) {
+
+            sdhcExtPtr->CqeRegistersPtr = cqeRegistersPtr;
+
+            status = SdhcAllocateCqeTaskList(sdhcExtPtr);
+            if (!NT_SUCCESS(status)) {
+                USDHC_LOG_ERROR_STATUS(
+                    sdhcExtPtr->IfrLogHandle,
+                    sdhcExtPtr,
+                    status,
+                    "SdhcAllocateCqeTaskList() failed, command queuing disabled");
+            }
+        }
+    }
+
+    //
+    // Without device properties (always the case in crashdump mode) there
+    // is no 1.8V regulator, which keeps SDR50/SDR104 and HS200/HS400 off
+    //
+    if (sdhcExtPtr->DeviceProperties.Key == USDHC_DEVICE_PROPERTIES_NULL_KEY) {
+        sdhcExtPtr->DeviceProperties.Regulator1V8Exist = FALSE;
+        sdhcExtPtr->DeviceProperties.Hs400Supported = 0;
+        sdhcExtPtr->DeviceProperties.SlotCount = USDHC_DEFAULT_SLOT_COUNT;
+        sdhcExtPtr->DeviceProperties.BaseClockFrequencyHz =
+            USDHC_DEFAULT_BASE_CLOCK_FREQ_HZ;
     }
 
     //
-    // Currently, we don't support 1.8V switching, SDR50/SDR104/DDR, and
-    // SDBus power control
+    // Currently, we don't support SDBus power control, so SD cards don't
+    // get switched to 1.8V signaling. eMMC runs HS200/HS400 on the board's
+    // 1.8V I/O supply without it
     //
-    sdhcExtPtr->DeviceProperties.Regulator1V8Exist = FALSE;
     sdhcExtPtr->DeviceProperties.SlotPowerControlSupported = FALSE;
-    sdhcExtPtr->DeviceProperties.SlotCount = USDHC_DEFAULT_SLOT_COUNT;
-    sdhcExtPtr->DeviceProperties.BaseClockFrequencyHz =
-        USDHC_DEFAULT_BASE_CLOCK_FREQ_HZ;
 
     //
     // Power-off the SD bus initially. Sdport will ask for power-up later on
@@ -1575,6 +2787,14 @@ SdhcSlotInitialize(
     //
     capabilitiesPtr->SpecVersion = 3;
     capabilitiesPtr->MaximumOutstandingRequests = USDHC_MAX_OUTSTANDING_REQUESTS;
+
+    //
+    // Command queue tasks get pipelined, the card's queue depth is only
+    // known later, requests beyond it are deferred
+    //
+    if (sdhcExtPtr->CqeTaskListPtr != nullptr) {
+        capabilitiesPtr->MaximumOutstandingRequests = USDHC_CQE_MAX_OUTSTANDING_REQUESTS;
+    }
     capabilitiesPtr->MaximumBlockSize = (USHORT)(512 << hostCtrlCap.MBL);
     capabilitiesPtr->MaximumBlockCount = 0xFFFF;
     capabilitiesPtr->BaseClockFrequencyKhz = sdhcExtPtr->DeviceProperties.BaseClockFrequencyHz / 1000;
@@ -1584,14 +2804,32 @@ SdhcSlotInitialize(
 
     capabilitiesPtr->AlignmentRequirement = sizeof(ULONG) - 1;
 
-    if (hostCtrlCap.ADMAS) {
-        capabilitiesPtr->Supported.ScatterGatherDma = 1;
+    //
+    // ADMA2 is the only data path
+    //
+    if (!hostCtrlCap.ADMAS) {
+        status = STATUS_NOT_SUPPORTED;
+        USDHC_LOG_ERROR(
+            sdhcExtPtr->IfrLogHandle,
+            sdhcExtPtr,
+            "uSDHC without ADMA2 support is not supported");
+        goto Cleanup;
     }
 
+    capabilitiesPtr->Supported.ScatterGatherDma = 1;
+
     if (hostCtrlCap.HSS) {
         capabilitiesPtr->Supported.HighSpeed = 1;
     }
 
+    //
+    // uSDHC revisions that report SDR104 support implement standard tuning
+    // and the TUNING_CTRL register, older ones (e.g iMX6Q) only manual tuning
+    //
+    sdhcExtPtr->StdTuningSupported = BOOLEAN(hostCtrlCap.SDR104_SUPPORT != 0);
+    sdhcExtPtr->CurrentBusSpeed = SdBusSpeedNormal;
+    sdhcExtPtr->CardUserPartitionSelected = TRUE;
+
     capabilitiesPtr->Supported.BusWidth8Bit = 1;
 
     //
@@ -1605,19 +2843,32 @@ SdhcSlotInitialize(
     }
 
     //
-    // uSDHC supports 1.8V signaling, SDR50, SDR105 and DDR50 modes
-    // However, we claim not supporting SD104 due to missing tuning implementation,
-    // and not supporting DDR50 due to Sdport not having that working properly
-    // at the moment
+    // uSDHC supports 1.8V signaling, SDR50, SDR104 and DDR50 modes
+    // However, we claim not supporting DDR50 due to Sdport not having
+    // that working properly at the moment
     //
     capabilitiesPtr->Supported.SDR50 = capabilitiesPtr->Supported.SignalingVoltage18V;
-    capabilitiesPtr->Supported.SDR104 = 0;
+    capabilitiesPtr->Supported.SDR104 = capabilitiesPtr->Supported.SignalingVoltage18V;
     capabilitiesPtr->Supported.DDR50 = 0;
 
+    //
+    // eMMC runs HS200/HS400 on the 1.8V I/O supply of the board, there is no
+    // signaling voltage switch handshake nor slot power cycling involved.
+    // HS400 additionally needs the strobe DLL
+    //
     capabilitiesPtr->Supported.HS200 = 0;
     capabilitiesPtr->Supported.HS400 = 0;
+    if (sdhcExtPtr->DeviceProperties.Regulator1V8Exist != 0) {
+        capabilitiesPtr->Supported.HS200 = 1;
+        if (sdhcExtPtr->DeviceProperties.Hs400Supported != 0) {
+            capabilitiesPtr->Supported.HS400 = 1;
+        }
+    }
 
     capabilitiesPtr->Supported.TuningForSDR50 = 0;
+    if (capabilitiesPtr->Supported.SDR50 && hostCtrlCap.USE_TUNING_SDR50) {
+        capabilitiesPtr->Supported.TuningForSDR50 = 1;
+    }
     capabilitiesPtr->Supported.DriverTypeA = 1;
     capabilitiesPtr->Supported.DriverTypeB = 1;
     capabilitiesPtr->Supported.DriverTypeC = 1;
@@ -1643,12 +2894,18 @@ SdhcSlotInitialize(
         capabilitiesPtr->Supported.Voltage33V = 1;
     }
 
-    if (gForcePio)
+    //
+    // With gForcePio, Sdport hands over virtual buffers which are moved
+    // by ADMA2 through the bounce segment, so cap the transfer size to it
+    //
+    if (gForcePio && !CrashdumpMode)
     {
         capabilitiesPtr->Flags.UsePioForRead = 1;
         capabilitiesPtr->Flags.UsePioForWrite = 1;
         capabilitiesPtr->DmaDescriptorSize = 0;
         capabilitiesPtr->Supported.ScatterGatherDma = 0;
+        capabilitiesPtr->MaximumBlockCount =
+            USHORT(USDHC_BOUNCE_DATA_LENGTH / capabilitiesPtr->MaximumBlockSize);
     }
 
     status = STATUS_SUCCESS;
@@ -1676,6 +2933,14 @@ SdhcSlotIssueBusOperation(
 
     NTSTATUS status;
 
+    //
+    // Bus operations drive the CMD/DAT lines or change the bus timing,
+    // neither of which may happen under a running CQE
+    //
+    if (sdhcExtPtr->CqeEnabled) {
+        (VOID)SdhcCqeDisable(sdhcExtPtr);
+    }
+
     switch (BusOperationPtr->Type) {
     case SdResetHost:
         status = SdhcResetHost(sdhcExtPtr, BusOperationPtr->Parameters.ResetType);
@@ -1825,6 +3090,30 @@ SdhcResetHost(
         return STATUS_INVALID_PARAMETER;
     }
 
+    //
+    // A reset ends whatever legacy command was on the bus
+    //
+    SdhcExtPtr->CqeLegacyRequestPtr = nullptr;
+
+    //
+    // RSTA does not reach the CQE, turn it off so it gets configured
+    // from scratch on the next queued request. Sdport aborts whatever
+    // request was outstanding, deferred ones included
+    //
+    if (ResetType == SdResetTypeAll) {
+        SdhcExtPtr->CqeDeferredHead = 0;
+        SdhcExtPtr->CqeDeferredTail = 0;
+
+        if (SdhcExtPtr->CqeConfigured) {
+            SdhcWriteRegister(&SdhcExtPtr->CqeRegistersPtr->CQCFG, 0);
+            RtlZeroMemory(SdhcExtPtr->CqeTaskRequests, sizeof(SdhcExtPtr->CqeTaskRequests));
+            SdhcExtPtr->CqeActiveTasks = 0;
+            SdhcExtPtr->CqeCompletedTasks = 0;
+            SdhcExtPtr->CqeConfigured = FALSE;
+            SdhcExtPtr->CqeEnabled = FALSE;
+        }
+    }
+
     USDHC_SYS_CTRL_REG sysCtrl = { SdhcReadRegister(&registersPtr->SYS_CTRL) };
     sysCtrl.AsUint32 |= sysCtrlMask.AsUint32;
     SdhcWriteRegister(&registersPtr->SYS_CTRL, sysCtrl.AsUint32);
@@ -1893,14 +3182,23 @@ SdhcResetHost(
     SdhcWriteRegister(&registersPtr->MMC_BOOT, 0);
     SdhcWriteRegister(&registersPtr->VEND_SPEC2, USDHC_VEND_SPEC2_RESET_VALUE);
 
+    if (SdhcExtPtr->DeviceProperties.Hs400Supported != 0) {
+        SdhcWriteRegister(&registersPtr->STROBE_DLL_CTRL, 0);
+    }
+
+    if (SdhcExtPtr->StdTuningSupported) {
+        USDHC_TUNING_CTRL_REG tuningCtrl = { SdhcReadRegister(&registersPtr->TUNING_CTRL) };
+        tuningCtrl.STD_TUNING_EN = 0;
+        SdhcWriteRegister(&registersPtr->TUNING_CTRL, tuningCtrl.AsUint32);
+    }
+
+    SdhcExtPtr->CurrentBusSpeed = SdBusSpeedNormal;
+
     //
-    // Initialize DMA if the controller supports it.
+    // All data transfers go through ADMA2
     //
     USDHC_PROT_CTRL_REG protCtrl = { USDHC_PROT_CTRL_RESET_VALUE };
-    protCtrl.DMASEL = USDHC_PROT_CTRL_DMASEL_NO_DMA;
-    if (SdhcExtPtr->Capabilities.Supported.ScatterGatherDma) {
-        protCtrl.DMASEL = USDHC_PROT_CTRL_DMASEL_ADMA2;
-    }
+    protCtrl.DMASEL = USDHC_PROT_CTRL_DMASEL_ADMA2;
     SdhcWriteRegister(&registersPtr->PROT_CTRL, protCtrl.AsUint32);
 
     return STATUS_SUCCESS;
@@ -2032,6 +3330,18 @@ SdhcSetClock(
         sysCtrl.SDCLKFS,
         sysCtrl.DVS);
 
+    SdhcExtPtr->CurrentSdClockHz = sdClk;
+
+    //
+    // HS400 strobe DLL has to be re-locked on every SDCLK change
+    //
+    if (SdhcExtPtr->CurrentBusSpeed == SdBusSpeedHS400) {
+        status = SdhcConfigureStrobeDll(SdhcExtPtr);
+        if (!NT_SUCCESS(status)) {
+            return status;
+        }
+    }
+
     return STATUS_SUCCESS;
 }
 
@@ -2117,21 +3427,48 @@ SdhcSetSpeed(
 
     case SdBusSpeedHS200:
     case SdBusSpeedHS400:
-        USDHC_LOG_ERROR(
-            SdhcExtPtr->IfrLogHandle,
-            SdhcExtPtr,
-            "Selected bus speed class is not supported");
-        return STATUS_NOT_SUPPORTED;
+        if (!SdhcExtPtr->Capabilities.Supported.HS200 ||
+            ((Speed == SdBusSpeedHS400) && !SdhcExtPtr->Capabilities.Supported.HS400)) {
+            USDHC_LOG_ERROR(
+                SdhcExtPtr->IfrLogHandle,
+                SdhcExtPtr,
+                "Selected bus speed class is not supported");
+            return STATUS_NOT_SUPPORTED;
+        }
+
+        //
+        // eMMC has no signaling voltage switch handshake, just move the pads
+        // to the 1.8V I/O supply
+        //
+        if (vendSpec.VSELECT == 0) {
+            vendSpec.VSELECT = USDHC_VEND_SPEC_VSELECT_S1V8;
+            SdhcWriteRegister(&registersPtr->VEND_SPEC, vendSpec.AsUint32);
+        }
+        break;
 
     default:
         NT_ASSERTMSG("Invalid speed mode selected", FALSE);
         return STATUS_INVALID_PARAMETER;
     }
 
+    USDHC_MIX_CTRL_REG mixCtrl = { SdhcReadRegister(&registersPtr->MIX_CTRL) };
+    mixCtrl.DDR_EN = 0;
+    mixCtrl.HS400_MODE = 0;
     if (Speed == SdBusSpeedDDR50) {
-        USDHC_MIX_CTRL_REG mixCtrl = { SdhcReadRegister(&registersPtr->MIX_CTRL) };
         mixCtrl.DDR_EN = 1;
-        SdhcWriteRegister(&registersPtr->MIX_CTRL, mixCtrl.AsUint32);
+    } else if (Speed == SdBusSpeedHS400) {
+        mixCtrl.DDR_EN = 1;
+        mixCtrl.HS400_MODE = 1;
+    }
+    SdhcWriteRegister(&registersPtr->MIX_CTRL, mixCtrl.AsUint32);
+
+    SdhcExtPtr->CurrentBusSpeed = Speed;
+
+    //
+    // Locks the strobe DLL for HS400 and turns it off for any other timing
+    //
+    if (SdhcExtPtr->DeviceProperties.Hs400Supported != 0) {
+        return SdhcConfigureStrobeDll(SdhcExtPtr);
     }
 
     return STATUS_SUCCESS;
@@ -2316,100 +3653,534 @@ SdhcSetBusVoltage(
     SdhcWriteRegister(&registersPtr->VEND_SPEC, vendSpec.AsUint32);
 
     //
-    // It is mandatory to power-cycle the SDBus to reset the card signaling
-    // voltage to 3.3V if a 1.8V switch happened earlier, otherwise the card will
-    // always reply to S18R with S18A=0 (i.e 1.8V switch is not accepted) since it
-    // is already operating in 1.8V
+    // It is mandatory to power-cycle the SDBus to reset the card signaling
+    // voltage to 3.3V if a 1.8V switch happened earlier, otherwise the card will
+    // always reply to S18R with S18A=0 (i.e 1.8V switch is not accepted) since it
+    // is already operating in 1.8V
+    //
+    if (SdhcExtPtr->DeviceProperties.SlotPowerControlSupported != FALSE) {
+        NTSTATUS status = SdhcSetSdBusPower(SdhcExtPtr, powerOn);
+        if (!NT_SUCCESS(status)) {
+            return status;
+        }
+    }
+
+    return STATUS_SUCCESS;
+}
+
+_Use_decl_annotations_
+NTSTATUS
+SdhcSetSdBusPower(
+    USDHC_EXTENSION* SdhcExtPtr,
+    BOOLEAN PowerOn
+    )
+{
+    UINT32 dsmPowerFunctionIdx = USDHC_DSM_FUNCTION_IDX_SLOT_POWER_OFF;
+
+    if (PowerOn != FALSE) {
+        dsmPowerFunctionIdx = USDHC_DSM_FUNCTION_IDX_SLOT_POWER_ON;
+    }
+
+    NT_ASSERT(SdhcExtPtr->DeviceProperties.PdoPtr != nullptr);
+    NTSTATUS status =
+        AcpiExecuteDsmFunctionNoParams(
+            SdhcExtPtr->DeviceProperties.PdoPtr,
+            &USDHC_DSM_GUID,
+            USDHC_DSM_REVISION_ID,
+            dsmPowerFunctionIdx,
+            nullptr);
+    if (!NT_SUCCESS(status)) {
+        USDHC_LOG_ERROR_STATUS(
+            SdhcExtPtr->IfrLogHandle,
+            SdhcExtPtr,
+            status,
+            "AcpiExecuteDsmFunctionNoParams(%d) failed",
+            dsmPowerFunctionIdx);
+        return status;
+    }
+
+    //
+    // Give the card an empirical 100ms to stabilize the power-up/power-down.
+    // According to specs, the max power ramp-up time for 2.7-3.3V power supply
+    // is 35ms per specs. Host should also wait at least 1ms for the VDD supply
+    // voltage to be stable after power ramp-up is complete
+    //
+    SdPortWait(USDHC_CARD_STABILIZATION_DELAY);
+
+    return STATUS_SUCCESS;
+}
+
+_Use_decl_annotations_
+BOOLEAN
+SdhcIsSlotPowerControlSupported(
+    DEVICE_OBJECT* PdoPtr
+    )
+{
+    UINT32 supportedFunctionsMask;
+    NTSTATUS status =
+        AcpiQueryDsm(
+            PdoPtr,
+            &USDHC_DSM_GUID,
+            USDHC_DSM_REVISION_ID,
+            &supportedFunctionsMask);
+    if (!NT_SUCCESS(status)) {
+        USDHC_LOG_ERROR_STATUS(
+            DriverLogHandle,
+            NullPrivateExtensionPtr,
+            status,
+            "AcpiQueryDsm() failed");
+        return FALSE;
+    }
+
+    if (NT_SUCCESS(status) &&
+        (supportedFunctionsMask & USDHC_DSM_POWER_FUNCTIONS_MASK)) {
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+_Use_decl_annotations_
+NTSTATUS
+SdhcExecuteTuning(
+    USDHC_EXTENSION* SdhcExtPtr
+    )
+{
+    volatile USDHC_REGISTERS* registersPtr = SdhcExtPtr->RegistersPtr;
+    UCHAR commandIndex;
+    USHORT blockSize = SD_TUNING_BLOCK_SIZE_4BIT;
+
+    switch (SdhcExtPtr->CurrentBusSpeed) {
+    case SdBusSpeedSDR50:
+    case SdBusSpeedSDR104:
+        commandIndex = SD_CMD19_SEND_TUNING_BLOCK;
+        break;
+
+    case SdBusSpeedHS200:
+    {
+        commandIndex = MMC_CMD21_SEND_TUNING_BLOCK;
+        USDHC_PROT_CTRL_REG protCtrl = { SdhcReadRegister(&registersPtr->PROT_CTRL) };
+        if (protCtrl.DTW == USDHC_PROT_CTRL_DTW_8BIT) {
+            blockSize = MMC_TUNING_BLOCK_SIZE_8BIT;
+        }
+    }
+        break;
+
+    default:
+        USDHC_LOG_ERROR(
+            SdhcExtPtr->IfrLogHandle,
+            SdhcExtPtr,
+            "Tuning is not applicable to bus speed %!BUSSPEED!",
+            SdhcExtPtr->CurrentBusSpeed);
+        return STATUS_INVALID_DEVICE_STATE;
+    }
+
+    //
+    // Tuning commands are polled, mask the interrupt signals so that the
+    // port driver ISR doesn't consume their status
+    //
+    const UINT32 intStatusEn = SdhcReadRegister(&registersPtr->INT_STATUS_EN);
+    const UINT32 intSignalEn = SdhcReadRegister(&registersPtr->INT_SIGNAL_EN);
+    SdhcWriteRegister(&registersPtr->INT_SIGNAL_EN, 0);
+    SdhcWriteRegister(&registersPtr->INT_STATUS_EN, intStatusEn | USDHC_INT_STATUS_TUNING);
+
+    NTSTATUS status = STATUS_IO_DEVICE_ERROR;
+    USDHC_TUNING_CACHE* tuningCachePtr = &SdhcExtPtr->TuningCache;
+    UINT32 delayCell;
+
+    //
+    // Same card at the same timing, e.g on resume: a single tuning command
+    // verifies the cached delay cell and saves the full sweep
+    //
+    if (tuningCachePtr->Valid &&
+        (tuningCachePtr->BusSpeed == SdhcExtPtr->CurrentBusSpeed) &&
+        RtlEqualMemory(
+            tuningCachePtr->CardCid,
+            SdhcExtPtr->CurrentCardCid,
+            sizeof(tuningCachePtr->CardCid))) {
+
+        delayCell = tuningCachePtr->DelayCell;
+        SdhcSetTuningDelayCell(SdhcExtPtr, delayCell, FALSE);
+        status = SdhcSendTuningCommand(SdhcExtPtr, commandIndex, blockSize, TRUE);
+
+        USDHC_LOG_INFORMATION(
+            SdhcExtPtr->IfrLogHandle,
+            SdhcExtPtr,
+            "Cached tuning delay cell:%lu %!STATUS!",
+            delayCell,
+            status);
+    }
+
+    if (!NT_SUCCESS(status)) {
+        tuningCachePtr->Valid = FALSE;
+
+        if (SdhcExtPtr->StdTuningSupported) {
+            status = SdhcExecuteStandardTuning(SdhcExtPtr, commandIndex, blockSize, &delayCell);
+        }
+
+        if (!SdhcExtPtr->StdTuningSupported || !NT_SUCCESS(status)) {
+            status = SdhcExecuteManualTuning(SdhcExtPtr, commandIndex, blockSize, &delayCell);
+        }
+
+        if (NT_SUCCESS(status)) {
+            tuningCachePtr->BusSpeed = SdhcExtPtr->CurrentBusSpeed;
+            tuningCachePtr->DelayCell = delayCell;
+            RtlCopyMemory(
+                tuningCachePtr->CardCid,
+                SdhcExtPtr->CurrentCardCid,
+                sizeof(tuningCachePtr->CardCid));
+            tuningCachePtr->Valid = TRUE;
+        }
+    }
+
+    SdhcAcknowledgeInterrupts(SdhcExtPtr, USDHC_INT_STATUS_TUNING);
+    SdhcWriteRegister(&registersPtr->INT_STATUS_EN, intStatusEn);
+    SdhcWriteRegister(&registersPtr->INT_SIGNAL_EN, intSignalEn);
+
+    if (!NT_SUCCESS(status)) {
+        USDHC_LOG_ERROR_STATUS(
+            SdhcExtPtr->IfrLogHandle,
+            SdhcExtPtr,
+            status,
+            "Tuning failed for bus speed %!BUSSPEED!",
+            SdhcExtPtr->CurrentBusSpeed);
+        return status;
+    }
+
+    USDHC_LOG_INFORMATION(
+        SdhcExtPtr->IfrLogHandle,
+        SdhcExtPtr,
+        "Tuned %!BUSSPEED! delay cell:%lu",
+        SdhcExtPtr->CurrentBusSpeed,
+        delayCell);
+
+    return STATUS_SUCCESS;
+}
+
+_Use_decl_annotations_
+NTSTATUS
+SdhcExecuteStandardTuning(
+    USDHC_EXTENSION* SdhcExtPtr,
+    UCHAR CommandIndex,
+    USHORT BlockSize,
+    UINT32* DelayCellPtr
+    )
+{
+    volatile USDHC_REGISTERS* registersPtr = SdhcExtPtr->RegistersPtr;
+
+    USDHC_TUNING_CTRL_REG tuningCtrl = { SdhcReadRegister(&registersPtr->TUNING_CTRL) };
+    tuningCtrl.STD_TUNING_EN = 1;
+    tuningCtrl.TUNING_START_TAP = USDHC_TUNING_CTRL_START_TAP_DEFAULT;
+    tuningCtrl.TUNING_STEP = USDHC_TUNING_CTRL_STEP_DEFAULT;
+    SdhcWriteRegister(&registersPtr->TUNING_CTRL, tuningCtrl.AsUint32);
+
+    USDHC_MIX_CTRL_REG mixCtrl = { SdhcReadRegister(&registersPtr->MIX_CTRL) };
+    mixCtrl.EXE_TUNE = 1;
+    mixCtrl.SMP_CLK_SEL = 0;
+    mixCtrl.FBCLK_SEL = 1;
+    mixCtrl.AUTO_TUNE_EN = 0;
+    SdhcWriteRegister(&registersPtr->MIX_CTRL, mixCtrl.AsUint32);
+
+    //
+    // The tuning circuit steps through the delay line on each tuning block
+    // and clears EXE_TUNE once done, SMP_CLK_SEL tells whether it found a
+    // sampling point
+    //
+    for (UINT32 i = 0; i < USDHC_STD_TUNING_MAX_LOOP; ++i) {
+        NTSTATUS status = SdhcSendTuningCommand(SdhcExtPtr, CommandIndex, BlockSize, FALSE);
+        if (status == STATUS_IO_TIMEOUT) {
+            break;
+        }
+
+        mixCtrl.AsUint32 = SdhcReadRegister(&registersPtr->MIX_CTRL);
+        if (!mixCtrl.EXE_TUNE) {
+            break;
+        }
+    }
+
+    mixCtrl.AsUint32 = SdhcReadRegister(&registersPtr->MIX_CTRL);
+    if (mixCtrl.EXE_TUNE || !mixCtrl.SMP_CLK_SEL) {
+        mixCtrl.EXE_TUNE = 0;
+        mixCtrl.SMP_CLK_SEL = 0;
+        SdhcWriteRegister(&registersPtr->MIX_CTRL, mixCtrl.AsUint32);
+
+        USDHC_LOG_ERROR(
+            SdhcExtPtr->IfrLogHandle,
+            SdhcExtPtr,
+            "Standard tuning failed, falling back to manual tuning");
+        return STATUS_IO_DEVICE_ERROR;
+    }
+
+    USDHC_CLK_TUNE_CTRL_STATUS_REG clkTuneCtrlStatus =
+        { SdhcReadRegister(&registersPtr->CLK_TUNE_CTRL_STATUS) };
+    *DelayCellPtr = clkTuneCtrlStatus.TAP_SEL_PRE;
+
+    return STATUS_SUCCESS;
+}
+
+_Use_decl_annotations_
+NTSTATUS
+SdhcExecuteManualTuning(
+    USDHC_EXTENSION* SdhcExtPtr,
+    UCHAR CommandIndex,
+    USHORT BlockSize,
+    UINT32* DelayCellPtr
+    )
+{
+    UINT32 passMap[USDHC_TUNING_DELAY_CELL_COUNT / 32] = { 0 };
+
+    //
+    // Sweep the whole delay line, then sample in the middle of the widest
+    // passing window which leaves the most margin on both sides
     //
-    if (SdhcExtPtr->DeviceProperties.SlotPowerControlSupported != FALSE) {
-        NTSTATUS status = SdhcSetSdBusPower(SdhcExtPtr, powerOn);
-        if (!NT_SUCCESS(status)) {
-            return status;
+    for (UINT32 delayCell = 0; delayCell < USDHC_TUNING_DELAY_CELL_COUNT; ++delayCell) {
+        SdhcSetTuningDelayCell(SdhcExtPtr, delayCell, TRUE);
+        NTSTATUS status = SdhcSendTuningCommand(SdhcExtPtr, CommandIndex, BlockSize, TRUE);
+        if (NT_SUCCESS(status)) {
+            passMap[delayCell / 32] |= (1 << (delayCell % 32));
         }
     }
 
+    UINT32 windowLength;
+    const UINT32 delayCell = SdhcFindTuningWindow(passMap, &windowLength);
+
+    USDHC_LOG_TRACE(
+        SdhcExtPtr->IfrLogHandle,
+        SdhcExtPtr,
+        "Manual tuning pass map:%08X%08X%08X%08X window:%lu center:%lu",
+        passMap[3],
+        passMap[2],
+        passMap[1],
+        passMap[0],
+        windowLength,
+        delayCell);
+
+    if (windowLength == 0) {
+        volatile USDHC_REGISTERS* registersPtr = SdhcExtPtr->RegistersPtr;
+        USDHC_MIX_CTRL_REG mixCtrl = { SdhcReadRegister(&registersPtr->MIX_CTRL) };
+        mixCtrl.EXE_TUNE = 0;
+        mixCtrl.SMP_CLK_SEL = 0;
+        SdhcWriteRegister(&registersPtr->MIX_CTRL, mixCtrl.AsUint32);
+        return STATUS_IO_DEVICE_ERROR;
+    }
+
+    SdhcSetTuningDelayCell(SdhcExtPtr, delayCell, FALSE);
+    *DelayCellPtr = delayCell;
+
     return STATUS_SUCCESS;
 }
 
 _Use_decl_annotations_
 NTSTATUS
-SdhcSetSdBusPower(
+SdhcSendTuningCommand(
     USDHC_EXTENSION* SdhcExtPtr,
-    BOOLEAN PowerOn
+    UCHAR CommandIndex,
+    USHORT BlockSize,
+    BOOLEAN VerifyTuningBlock
     )
 {
-    UINT32 dsmPowerFunctionIdx = USDHC_DSM_FUNCTION_IDX_SLOT_POWER_OFF;
+    volatile USDHC_REGISTERS* registersPtr = SdhcExtPtr->RegistersPtr;
+    USDHC_PRES_STATE_REG presState = { SdhcReadRegister(&registersPtr->PRES_STATE) };
+    UINT32 retries = USDHC_POLL_RETRY_COUNT;
 
-    if (PowerOn != FALSE) {
-        dsmPowerFunctionIdx = USDHC_DSM_FUNCTION_IDX_SLOT_POWER_ON;
+    while ((presState.CIHB || presState.CDIHB) && retries) {
+        SdPortWait(USDHC_POLL_WAIT_TIME_US);
+        --retries;
+        presState.AsUint32 = SdhcReadRegister(&registersPtr->PRES_STATE);
     }
 
-    NT_ASSERT(SdhcExtPtr->DeviceProperties.PdoPtr != nullptr);
-    NTSTATUS status =
-        AcpiExecuteDsmFunctionNoParams(
-            SdhcExtPtr->DeviceProperties.PdoPtr,
-            &USDHC_DSM_GUID,
-            USDHC_DSM_REVISION_ID,
-            dsmPowerFunctionIdx,
-            nullptr);
-    if (!NT_SUCCESS(status)) {
-        USDHC_LOG_ERROR_STATUS(
-            SdhcExtPtr->IfrLogHandle,
-            SdhcExtPtr,
-            status,
-            "AcpiExecuteDsmFunctionNoParams(%d) failed",
-            dsmPowerFunctionIdx);
-        return status;
+    if (presState.CIHB || presState.CDIHB) {
+        NT_ASSERT(!retries);
+        return STATUS_IO_TIMEOUT;
     }
 
+    SdhcAcknowledgeInterrupts(SdhcExtPtr, USDHC_INT_STATUS_TUNING);
+
+    USDHC_BLK_ATT_REG blkAtt = { 0 };
+    blkAtt.BLKSIZE = BlockSize;
+    blkAtt.BLKCNT = 1;
+    SdhcWriteRegister(&registersPtr->BLK_ATT, blkAtt.AsUint32);
+
     //
-    // Give the card an empirical 100ms to stabilize the power-up/power-down.
-    // According to specs, the max power ramp-up time for 2.7-3.3V power supply
-    // is 35ms per specs. Host should also wait at least 1ms for the VDD supply
-    // voltage to be stable after power ramp-up is complete
+    // The tuning block is read out of the FIFO, it is not worth an ADMA2 setup
     //
-    SdPortWait(USDHC_CARD_STABILIZATION_DELAY);
+    USDHC_MIX_CTRL_REG mixCtrl = { SdhcReadRegister(&registersPtr->MIX_CTRL) };
+    mixCtrl.DMAEN = 0;
+    mixCtrl.BCEN = 0;
+    mixCtrl.AC12EN = 0;
+    mixCtrl.AC23EN = 0;
+    mixCtrl.MSBSEL = 0;
+    mixCtrl.DTDSEL = 1;
+    SdhcWriteRegister(&registersPtr->MIX_CTRL, mixCtrl.AsUint32);
 
-    return STATUS_SUCCESS;
+    const UINT32 blockWordCount = BlockSize / sizeof(UINT32);
+    USDHC_WTMK_LVL_REG wtmkLvl = { SdhcReadRegister(&registersPtr->WTMK_LVL) };
+    wtmkLvl.RD_WML = static_cast<UINT8>(blockWordCount);
+    wtmkLvl.RD_BRST_LEN = Min(blockWordCount, UINT32(8));
+    SdhcWriteRegister(&registersPtr->WTMK_LVL, wtmkLvl.AsUint32);
+
+    SdhcWriteRegister(&registersPtr->CMD_ARG, 0);
+
+    USDHC_CMD_XFR_TYP_REG cmdXfrTyp = { 0 };
+    cmdXfrTyp.CMDINX = CommandIndex;
+    cmdXfrTyp.RSPTYP = USDHC_CMD_XFR_TYP_RSPTYP_RSP_48;
+    cmdXfrTyp.CCCEN = 1;
+    cmdXfrTyp.CICEN = 1;
+    cmdXfrTyp.DPSEL = 1;
+    cmdXfrTyp.CMDTYP = USDHC_CMD_XFR_TYP_CMDTYP_NORMAL;
+    SdhcWriteRegister(&registersPtr->CMD_XFR_TYP, cmdXfrTyp.AsUint32);
+
+    USDHC_INT_STATUS_REG intStatus = { SdhcReadRegister(&registersPtr->INT_STATUS) };
+    retries = USDHC_TUNING_COMMAND_RETRY_COUNT;
+
+    while (!intStatus.BRR &&
+           !(intStatus.AsUint32 & USDHC_INT_STATUS_ERROR) &&
+           retries) {
+        SdPortWait(USDHC_POLL_WAIT_TIME_US);
+        --retries;
+        intStatus.AsUint32 = SdhcReadRegister(&registersPtr->INT_STATUS);
+    }
+
+    NTSTATUS status = STATUS_SUCCESS;
+
+    if (intStatus.AsUint32 & USDHC_INT_STATUS_ERROR) {
+        status = STATUS_IO_DEVICE_ERROR;
+    } else if (!intStatus.BRR) {
+        status = STATUS_IO_TIMEOUT;
+    } else {
+        //
+        // In standard tuning the tuning circuit consumes the block, otherwise
+        // drain it from the FIFO and compare it against the spec pattern
+        //
+        presState.AsUint32 = SdhcReadRegister(&registersPtr->PRES_STATE);
+        if (presState.BREN) {
+            UINT32 tuningBlock[MMC_TUNING_BLOCK_SIZE_8BIT / sizeof(UINT32)];
+            NT_ASSERT(blockWordCount <= ARRAYSIZE(tuningBlock));
+
+            for (UINT32 i = 0; i < blockWordCount; ++i) {
+                tuningBlock[i] = SdhcReadRegisterNoFence(&registersPtr->DATA_BUFF_ACC_PORT);
+            }
+
+            if (VerifyTuningBlock) {
+                const UCHAR* patternPtr = SdTuningBlockPattern4Bit;
+                if (BlockSize == MMC_TUNING_BLOCK_SIZE_8BIT) {
+                    patternPtr = MmcTuningBlockPattern8Bit;
+                }
+
+                if (RtlCompareMemory(tuningBlock, patternPtr, BlockSize) != BlockSize) {
+                    status = STATUS_IO_DEVICE_ERROR;
+                }
+            }
+        } else if (VerifyTuningBlock) {
+            status = STATUS_IO_DEVICE_ERROR;
+        }
+    }
+
+    SdhcAcknowledgeInterrupts(SdhcExtPtr, USDHC_INT_STATUS_TUNING);
+
+    //
+    // A failed tuning command leaves the CMD and DAT lines state machines
+    // in an unknown state
+    //
+    if (!NT_SUCCESS(status)) {
+        (VOID)SdhcResetHost(SdhcExtPtr, SdResetTypeCmd);
+        (VOID)SdhcResetHost(SdhcExtPtr, SdResetTypeDat);
+    }
+
+    return status;
 }
 
 _Use_decl_annotations_
-BOOLEAN
-SdhcIsSlotPowerControlSupported(
-    DEVICE_OBJECT* PdoPtr
+VOID
+SdhcSetTuningDelayCell(
+    USDHC_EXTENSION* SdhcExtPtr,
+    UINT32 DelayCell,
+    BOOLEAN ExecuteTuning
     )
 {
-    UINT32 supportedFunctionsMask;
-    NTSTATUS status =
-        AcpiQueryDsm(
-            PdoPtr,
-            &USDHC_DSM_GUID,
-            USDHC_DSM_REVISION_ID,
-            &supportedFunctionsMask);
-    if (!NT_SUCCESS(status)) {
-        USDHC_LOG_ERROR_STATUS(
-            DriverLogHandle,
-            NullPrivateExtensionPtr,
-            status,
-            "AcpiQueryDsm() failed");
-        return FALSE;
-    }
+    volatile USDHC_REGISTERS* registersPtr = SdhcExtPtr->RegistersPtr;
 
-    if (NT_SUCCESS(status) &&
-        (supportedFunctionsMask & USDHC_DSM_POWER_FUNCTIONS_MASK)) {
-        return TRUE;
+    NT_ASSERT(DelayCell < USDHC_TUNING_DELAY_CELL_COUNT);
+
+    if (SdhcExtPtr->StdTuningSupported) {
+        USDHC_TUNING_CTRL_REG tuningCtrl = { SdhcReadRegister(&registersPtr->TUNING_CTRL) };
+        tuningCtrl.STD_TUNING_EN = 0;
+        SdhcWriteRegister(&registersPtr->TUNING_CTRL, tuningCtrl.AsUint32);
     }
 
-    return FALSE;
+    USDHC_MIX_CTRL_REG mixCtrl = { SdhcReadRegister(&registersPtr->MIX_CTRL) };
+    mixCtrl.EXE_TUNE = (ExecuteTuning ? 1 : 0);
+    mixCtrl.SMP_CLK_SEL = 1;
+    mixCtrl.FBCLK_SEL = 1;
+    SdhcWriteRegister(&registersPtr->MIX_CTRL, mixCtrl.AsUint32);
+
+    USDHC_CLK_TUNE_CTRL_STATUS_REG clkTuneCtrlStatus =
+        { SdhcReadRegister(&registersPtr->CLK_TUNE_CTRL_STATUS) };
+    clkTuneCtrlStatus.DLY_CELL_SET_PRE = DelayCell;
+    SdhcWriteRegister(&registersPtr->CLK_TUNE_CTRL_STATUS, clkTuneCtrlStatus.AsUint32);
 }
 
 _Use_decl_annotations_
 NTSTATUS
-SdhcExecuteTuning(
-    USDHC_EXTENSION* /* SdhcExtPtr */
+SdhcConfigureStrobeDll(
+    USDHC_EXTENSION* SdhcExtPtr
     )
 {
-    return STATUS_NOT_SUPPORTED;
+    volatile USDHC_REGISTERS* registersPtr = SdhcExtPtr->RegistersPtr;
+
+    if ((SdhcExtPtr->CurrentBusSpeed != SdBusSpeedHS400) ||
+        (SdhcExtPtr->CurrentSdClockHz <= USDHC_STROBE_DLL_MIN_CLOCK_HZ)) {
+        SdhcWriteRegister(&registersPtr->STROBE_DLL_CTRL, 0);
+        return STATUS_SUCCESS;
+    }
+
+    //
+    // SDCLK has to be gated-off while the strobe DLL is reset
+    //
+    USDHC_VEND_SPEC_REG vendSpec = { SdhcReadRegister(&registersPtr->VEND_SPEC) };
+    const BOOLEAN sdClockForcedOn = BOOLEAN(vendSpec.FRC_SDCLK_ON != 0);
+    SdhcSdClockEnableInIdle(SdhcExtPtr, FALSE);
+
+    USDHC_PRES_STATE_REG presState = { SdhcReadRegister(&registersPtr->PRES_STATE) };
+    UINT32 retries = USDHC_POLL_RETRY_COUNT;
+    while (!presState.SDOFF && retries) {
+        SdPortWait(USDHC_POLL_WAIT_TIME_US);
+        --retries;
+        presState.AsUint32 = SdhcReadRegister(&registersPtr->PRES_STATE);
+    }
+
+    USDHC_STROBE_DLL_CTRL_REG strobeDllCtrl = { 0 };
+    strobeDllCtrl.RESET = 1;
+    SdhcWriteRegister(&registersPtr->STROBE_DLL_CTRL, strobeDllCtrl.AsUint32);
+    SdhcWriteRegister(&registersPtr->STROBE_DLL_CTRL, 0);
+
+    strobeDllCtrl.AsUint32 = 0;
+    strobeDllCtrl.ENABLE = 1;
+    strobeDllCtrl.SLV_DLY_TARGET = USDHC_STROBE_DLL_CTRL_SLV_DLY_TARGET_DEFAULT;
+    strobeDllCtrl.SLV_UPDATE_INT = USDHC_STROBE_DLL_CTRL_SLV_UPDATE_INT_DEFAULT;
+    SdhcWriteRegister(&registersPtr->STROBE_DLL_CTRL, strobeDllCtrl.AsUint32);
+
+    USDHC_STROBE_DLL_STATUS_REG strobeDllStatus =
+        { SdhcReadRegister(&registersPtr->STROBE_DLL_STATUS) };
+    retries = USDHC_STROBE_DLL_LOCK_RETRY_COUNT;
+    while (!(strobeDllStatus.REF_LOCK && strobeDllStatus.SLV_LOCK) && retries) {
+        SdPortWait(1);
+        --retries;
+        strobeDllStatus.AsUint32 = SdhcReadRegister(&registersPtr->STROBE_DLL_STATUS);
+    }
+
+    SdhcSdClockEnableInIdle(SdhcExtPtr, sdClockForcedOn);
+
+    if (!(strobeDllStatus.REF_LOCK && strobeDllStatus.SLV_LOCK)) {
+        USDHC_LOG_ERROR(
+            SdhcExtPtr->IfrLogHandle,
+            SdhcExtPtr,
+            "Time-out waiting on strobe DLL lock STROBE_DLL_STATUS:0x%08X",
+            strobeDllStatus.AsUint32);
+        return STATUS_IO_TIMEOUT;
+    }
+
+    return STATUS_SUCCESS;
 }
 
 _Use_decl_annotations_
@@ -2449,6 +4220,38 @@ SdhcSdClockEnableInIdle(
     SdhcWriteRegister(&registersPtr->VEND_SPEC, vendSpec.AsUint32);
 }
 
+_Use_decl_annotations_
+UINT32
+SdhcFindTuningWindow(
+    const UINT32* PassMapPtr,
+    UINT32* WindowLengthPtr
+    )
+{
+    UINT32 bestStart = 0;
+    UINT32 bestLength = 0;
+    UINT32 runStart = 0;
+    UINT32 runLength = 0;
+
+    for (UINT32 delayCell = 0; delayCell < USDHC_TUNING_DELAY_CELL_COUNT; ++delayCell) {
+        if (PassMapPtr[delayCell / 32] & (1 << (delayCell % 32))) {
+            if (runLength == 0) {
+                runStart = delayCell;
+            }
+
+            ++runLength;
+            if (runLength > bestLength) {
+                bestStart = runStart;
+                bestLength = runLength;
+            }
+        } else {
+            runLength = 0;
+        }
+    }
+
+    *WindowLengthPtr = bestLength;
+    return bestStart + (bestLength / 2);
+}
+
 _Use_decl_annotations_
 NTSTATUS
 SdhcWaitForStableSdClock(
@@ -2576,6 +4379,32 @@ SdhcReadDeviceProperties(
         goto Cleanup;
     }
 
+    //
+    // HS400 support is optional, platforms not exposing it don't get HS400
+    //
+    status =
+        AcpiDevicePropertiesQueryIntegerValue(
+            devicePropertiesPkgPtr,
+            "Hs400Supported",
+            &devPropsPtr->Hs400Supported);
+    if (!NT_SUCCESS(status)) {
+        devPropsPtr->Hs400Supported = 0;
+        status = STATUS_SUCCESS;
+    }
+
+    //
+    // The CQE is used whenever present, unless the platform opts out
+    //
+    status =
+        AcpiDevicePropertiesQueryIntegerValue(
+            devicePropertiesPkgPtr,
+            "CqeDisabled",
+            &devPropsPtr->CqeDisabled);
+    if (!NT_SUCCESS(status)) {
+        devPropsPtr->CqeDisabled = 0;
+        status = STATUS_SUCCESS;
+    }
+
     //
     // Supporting slot power control is board design specific, and
     // not all uSDHCs will support slot power control via firmware
@@ -2663,4 +4492,126 @@ SdhcLogCleanup(
     }
 }
 
+_Use_decl_annotations_
+NTSTATUS
+SdhcAllocateBounceSegment(
+    USDHC_EXTENSION* SdhcExtPtr
+    )
+{
+    C_ASSERT(
+        (USDHC_BOUNCE_DESCRIPTOR_COUNT * sizeof(USDHC_ADMA2_DESCRIPTOR_TABLE_ENTRY)) <=
+        USDHC_BOUNCE_DATA_OFFSET);
+
+    if (SdhcExtPtr->BounceSegmentPtr != nullptr) {
+        return STATUS_SUCCESS;
+    }
+
+    //
+    // uSDHC is not cache coherent and ADMA2 addresses are 32-bit
+    //
+    PHYSICAL_ADDRESS lowestAcceptableAddress = { 0 };
+    PHYSICAL_ADDRESS highestAcceptableAddress = { 0 };
+    PHYSICAL_ADDRESS boundaryAddressMultiple = { 0 };
+    highestAcceptableAddress.LowPart = MAXULONG;
+
+    SdhcExtPtr->BounceSegmentPtr = static_cast<UCHAR*>(
+        MmAllocateContiguousMemorySpecifyCache(
+            USDHC_BOUNCE_SEGMENT_SIZE,
+            lowestAcceptableAddress,
+            highestAcceptableAddress,
+            boundaryAddressMultiple,
+            MmNonCached));
+    if (SdhcExtPtr->BounceSegmentPtr == nullptr) {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    SdhcExtPtr->BounceSegmentPhysicalAddress =
+        MmGetPhysicalAddress(SdhcExtPtr->BounceSegmentPtr);
+    NT_ASSERT(SdhcExtPtr->BounceSegmentPhysicalAddress.HighPart == 0);
+
+    return STATUS_SUCCESS;
+}
+
+_Use_decl_annotations_
+VOID
+SdhcFreeBounceSegments(
+    SD_MINIPORT* MiniportPtr
+    )
+{
+    USDHC_EXTENSION* sdhcExtPtr;
+
+    for (LONG i = 0; i < MiniportPtr->SlotCount; ++i) {
+        sdhcExtPtr = reinterpret_cast<USDHC_EXTENSION*>(
+            MiniportPtr->SlotExtensionList[i]->PrivateExtension);
+        if (sdhcExtPtr->BounceSegmentPtr != nullptr) {
+            MmFreeContiguousMemorySpecifyCache(
+                sdhcExtPtr->BounceSegmentPtr,
+                USDHC_BOUNCE_SEGMENT_SIZE,
+                MmNonCached);
+            sdhcExtPtr->BounceSegmentPtr = nullptr;
+        }
+    }
+}
+
+_Use_decl_annotations_
+NTSTATUS
+SdhcAllocateCqeTaskList(
+    USDHC_EXTENSION* SdhcExtPtr
+    )
+{
+    if (SdhcExtPtr->CqeTaskListPtr != nullptr) {
+        return STATUS_SUCCESS;
+    }
+
+    //
+    // The task descriptor list is fetched by the CQE, it has to be non-cached,
+    // below 4GB and 1KB aligned, which the page aligned allocation satisfies
+    //
+    PHYSICAL_ADDRESS lowestAcceptableAddress = { 0 };
+    PHYSICAL_ADDRESS highestAcceptableAddress = { 0 };
+    PHYSICAL_ADDRESS boundaryAddressMultiple = { 0 };
+    highestAcceptableAddress.LowPart = MAXULONG;
+
+    SdhcExtPtr->CqeTaskListPtr = static_cast<USDHC_CQE_TASK_SLOT*>(
+        MmAllocateContiguousMemorySpecifyCache(
+            USDHC_CQE_TASK_LIST_SIZE,
+            lowestAcceptableAddress,
+            highestAcceptableAddress,
+            boundaryAddressMultiple,
+            MmNonCached));
+    if (SdhcExtPtr->CqeTaskListPtr == nullptr) {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    RtlZeroMemory(SdhcExtPtr->CqeTaskListPtr, USDHC_CQE_TASK_LIST_SIZE);
+
+    SdhcExtPtr->CqeTaskListPhysicalAddress =
+        MmGetPhysicalAddress(SdhcExtPtr->CqeTaskListPtr);
+    NT_ASSERT(SdhcExtPtr->CqeTaskListPhysicalAddress.HighPart == 0);
+    NT_ASSERT((SdhcExtPtr->CqeTaskListPhysicalAddress.LowPart & 0x3FF) == 0);
+
+    return STATUS_SUCCESS;
+}
+
+_Use_decl_annotations_
+VOID
+SdhcFreeCqeTaskLists(
+    SD_MINIPORT* MiniportPtr
+    )
+{
+    USDHC_EXTENSION* sdhcExtPtr;
+
+    for (LONG i = 0; i < MiniportPtr->SlotCount; ++i) {
+        sdhcExtPtr = reinterpret_cast<USDHC_EXTENSION*>(
+            MiniportPtr->SlotExtensionList[i]->PrivateExtension);
+        if (sdhcExtPtr->CqeTaskListPtr != nullptr) {
+            MmFreeContiguousMemorySpecifyCache(
+                sdhcExtPtr->CqeTaskListPtr,
+                USDHC_CQE_TASK_LIST_SIZE,
+                MmNonCached);
+            sdhcExtPtr->CqeTaskListPtr = nullptr;
+        }
+    }
+}
+
 NONPAGED_SEGMENT_END; //======================================================
\ No newline at end of file
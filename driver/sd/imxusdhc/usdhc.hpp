@@ -36,6 +36,12 @@
 //
 #define USDHC_MAX_OUTSTANDING_REQUESTS      1
 
+//
+// With the CQE, as many requests as there are task slots. Requests that
+// can't be started right away are deferred
+//
+#define USDHC_CQE_MAX_OUTSTANDING_REQUESTS  USDHC_CQE_TASK_COUNT
+
 //
 // The error register in a standard SDHC is 16-bit, this
 // mask used to select all errors
@@ -54,6 +60,88 @@
 //
 #define USDHC_CARD_STABILIZATION_DELAY 100000
 
+//
+// ADMA2 bounce segment layout. The segment is physically contiguous, non-cached
+// and allocated below 4GB. It starts with its own ADMA2 descriptor table followed
+// by the data area, and is used for data transfers that can't be described by
+// the request's own scatter/gather list
+//
+#define USDHC_BOUNCE_DATA_LENGTH            (64 * 1024)
+#define USDHC_BOUNCE_DESCRIPTOR_COUNT \
+    ((USDHC_BOUNCE_DATA_LENGTH + SDHC_ADMA2_MAX_LENGTH_PER_ENTRY - 1) / SDHC_ADMA2_MAX_LENGTH_PER_ENTRY)
+#define USDHC_BOUNCE_DATA_OFFSET            64
+#define USDHC_BOUNCE_SEGMENT_SIZE           (USDHC_BOUNCE_DATA_OFFSET + USDHC_BOUNCE_DATA_LENGTH)
+
+//
+// Tuning commands and tuning block sizes
+//
+#define SD_CMD2_ALL_SEND_CID                2
+#define SD_CMD10_SEND_CID                   10
+#define SD_CMD19_SEND_TUNING_BLOCK          19
+#define MMC_CMD21_SEND_TUNING_BLOCK         21
+#define SD_TUNING_BLOCK_SIZE_4BIT           64
+#define MMC_TUNING_BLOCK_SIZE_8BIT          128
+
+//
+// Standard tuning gives up after 40 tuning commands as per SD specs, each
+// tuning command should complete within 150ms
+//
+#define USDHC_STD_TUNING_MAX_LOOP           40
+#define USDHC_TUNING_COMMAND_RETRY_COUNT    15000
+
+//
+// HS400 strobe DLL is only needed for SDCLK above 100MHz and should
+// lock within 50us
+//
+#define USDHC_STROBE_DLL_MIN_CLOCK_HZ       100000000
+#define USDHC_STROBE_DLL_LOCK_RETRY_COUNT   50
+
+//
+// eMMC command queuing. The card reports its queue support and depth in
+// EXT_CSD and enters command queue mode through CMD6 on CMDQ_MODE_EN.
+// Queued tasks are 512-byte block addressed reads and writes
+//
+#define SD_CMD0_GO_IDLE_STATE               0
+#define MMC_CMD6_SWITCH                     6
+#define SD_CMD7_SELECT_CARD                 7
+#define MMC_CMD8_SEND_EXT_CSD               8
+#define SD_CMD12_STOP_TRANSMISSION          12
+#define SD_CMD17_READ_SINGLE_BLOCK          17
+#define SD_CMD18_READ_MULTIPLE_BLOCK        18
+#define SD_CMD23_SET_BLOCK_COUNT            23
+#define SD_CMD24_WRITE_BLOCK                24
+#define SD_CMD25_WRITE_MULTIPLE_BLOCK       25
+#define MMC_CMD48_CMDQ_TASK_MGMT            48
+
+#define MMC_CMD48_DISCARD_QUEUE             0x1
+
+#define MMC_CMD6_ACCESS_WRITE_BYTE          0x3
+#define MMC_CMD6_ARGUMENT(Index, Value) \
+    ((MMC_CMD6_ACCESS_WRITE_BYTE << 24) | ((Index) << 16) | ((Value) << 8))
+#define MMC_CMD6_ARGUMENT_ACCESS(Argument)  (((Argument) >> 24) & 0x3)
+#define MMC_CMD6_ARGUMENT_INDEX(Argument)   (((Argument) >> 16) & 0xFF)
+#define MMC_CMD6_ARGUMENT_VALUE(Argument)   (((Argument) >> 8) & 0xFF)
+
+#define MMC_EXT_CSD_SIZE                    512
+#define MMC_EXT_CSD_CMDQ_MODE_EN            15
+#define MMC_EXT_CSD_PARTITION_CONFIG        179
+#define MMC_EXT_CSD_CMDQ_DEPTH              307
+#define MMC_EXT_CSD_CMDQ_SUPPORT            308
+
+#define MMC_EXT_CSD_PARTITION_ACCESS_MASK   0x7
+#define MMC_EXT_CSD_CMDQ_DEPTH_MASK         0x1F
+
+#define MMC_BLOCK_SIZE                      512
+
+#define USDHC_CQE_TASK_LIST_SIZE \
+    (USDHC_CQE_TASK_COUNT * sizeof(USDHC_CQE_TASK_SLOT))
+
+//
+// R1 card status of a task that completed without a response error
+//
+#define MMC_R1_READY_FOR_DATA               (1 << 8)
+#define MMC_R1_CURRENT_STATE_TRAN           (4 << 9)
+
 //
 // uSDHC Device Specific Method UUID
 //
@@ -128,6 +216,18 @@ typedef union {
 
 #include <poppack.h> // pshpack1.h
 
+//
+// Tuning result of the last tuned card, kept across power transitions so
+// re-initializing the same card only needs a single verification tuning
+// command instead of the full sweep. The card is identified by its CID
+//
+typedef struct {
+    BOOLEAN Valid;
+    SDPORT_BUS_SPEED BusSpeed;
+    UINT32 DelayCell;
+    UINT32 CardCid[4];
+} USDHC_TUNING_CACHE;
+
 //
 // SDHC Private Extension
 //
@@ -136,13 +236,57 @@ typedef struct {
     volatile USDHC_REGISTERS_DEBUG* DebugRegistersPtr;
     VOID* PhysicalAddress;
     SDPORT_CAPABILITIES Capabilities;
-    UINT32 CurrentTransferRemainingLength;
     RECORDER_LOG IfrLogHandle; 
     BOOLEAN CrashdumpMode;
     BOOLEAN BreakOnDdiEnter;
     BOOLEAN BreakOnDdiExit;
     BOOLEAN BreakOnError;
 
+    //
+    // ADMA2 bounce segment, not available in crashdump mode. Transfers
+    // that would need it are moved through the FIFO by polled PIO instead
+    //
+    UCHAR* BounceSegmentPtr;
+    PHYSICAL_ADDRESS BounceSegmentPhysicalAddress;
+    BOOLEAN CurrentTransferBounced;
+    BOOLEAN CurrentTransferPio;
+
+    //
+    // Bus timing and tuning state
+    //
+    BOOLEAN StdTuningSupported;
+    SDPORT_BUS_SPEED CurrentBusSpeed;
+    UINT32 CurrentSdClockHz;
+    UINT32 CurrentCardCid[4];
+    USDHC_TUNING_CACHE TuningCache;
+
+    //
+    // eMMC command queuing state. The CQE is used only if the card reports
+    // command queuing support and its task descriptor list got allocated,
+    // which is never the case in crashdump mode. A task slot keeps its
+    // request and response after completion, until the slot gets reused.
+    // The response is CQCRA at reap time, shared by tasks reaped together
+    //
+    volatile USDHC_CQE_REGISTERS* CqeRegistersPtr;
+    USDHC_CQE_TASK_SLOT* CqeTaskListPtr;
+    PHYSICAL_ADDRESS CqeTaskListPhysicalAddress;
+    SDPORT_REQUEST* CqeTaskRequests[USDHC_CQE_TASK_COUNT];
+    UINT32 CqeTaskResponses[USDHC_CQE_TASK_COUNT];
+    UINT32 CqeActiveTasks;
+    volatile LONG CqeCompletedTasks;
+    UINT32 CqeSavedInterruptMask;
+    UINT32 CqeQueueDepth;
+    BOOLEAN CqeConfigured;
+    BOOLEAN CqeEnabled;
+    SDPORT_REQUEST* CqeLegacyRequestPtr;
+    SDPORT_REQUEST* CqeDeferredRequests[USDHC_CQE_MAX_OUTSTANDING_REQUESTS];
+    UINT32 CqeDeferredHead;
+    UINT32 CqeDeferredTail;
+    BOOLEAN CardCmdqSupported;
+    BOOLEAN CardCmdqEnabled;
+    BOOLEAN CardUserPartitionSelected;
+    UINT16 CardRca;
+
     //
     // Information populated from ACPI
     //
@@ -220,6 +364,41 @@ NTSTATUS
 SdhcExecuteTuning(
     _In_ USDHC_EXTENSION* SdhcExtPtr);
 
+_IRQL_requires_max_(APC_LEVEL)
+NTSTATUS
+SdhcExecuteStandardTuning(
+    _In_ USDHC_EXTENSION* SdhcExtPtr,
+    _In_ UCHAR CommandIndex,
+    _In_ USHORT BlockSize,
+    _Out_ UINT32* DelayCellPtr);
+
+_IRQL_requires_max_(APC_LEVEL)
+NTSTATUS
+SdhcExecuteManualTuning(
+    _In_ USDHC_EXTENSION* SdhcExtPtr,
+    _In_ UCHAR CommandIndex,
+    _In_ USHORT BlockSize,
+    _Out_ UINT32* DelayCellPtr);
+
+_IRQL_requires_max_(APC_LEVEL)
+NTSTATUS
+SdhcSendTuningCommand(
+    _In_ USDHC_EXTENSION* SdhcExtPtr,
+    _In_ UCHAR CommandIndex,
+    _In_ USHORT BlockSize,
+    _In_ BOOLEAN VerifyTuningBlock);
+
+VOID
+SdhcSetTuningDelayCell(
+    _In_ USDHC_EXTENSION* SdhcExtPtr,
+    _In_ UINT32 DelayCell,
+    _In_ BOOLEAN ExecuteTuning);
+
+_IRQL_requires_max_(APC_LEVEL)
+NTSTATUS
+SdhcConfigureStrobeDll(
+    _In_ USDHC_EXTENSION* SdhcExtPtr);
+
 _IRQL_requires_max_(APC_LEVEL)
 NTSTATUS
 SdhcEnableBlockGapInterrupt(
@@ -249,6 +428,11 @@ SdhcAcknowledgeInterrupts(
 // Request helper routines
 //
 
+NTSTATUS
+SdhcIssueCommandRequest(
+    _In_ USDHC_EXTENSION* SdhcExtPtr,
+    _In_ SDPORT_REQUEST* RequestPtr);
+
 NTSTATUS
 SdhcSendCommand(
     _In_ USDHC_EXTENSION* SdhcExtPtr,
@@ -265,36 +449,118 @@ SdhcStartTransfer(
     _In_ SDPORT_REQUEST* RequestPtr);
 
 NTSTATUS
-SdhcStartPioTransfer(
+SdhcStartAdmaTransfer(
     _In_ USDHC_EXTENSION* SdhcExtPtr,
     _In_ SDPORT_REQUEST* RequestPtr);
 
 NTSTATUS
-SdhcStartAdmaTransfer(
+SdhcPollPioTransfer(
     _In_ USDHC_EXTENSION* SdhcExtPtr,
     _In_ SDPORT_REQUEST* RequestPtr);
 
+NTSTATUS
+SdhcSendPolledCommand(
+    _In_ USDHC_EXTENSION* SdhcExtPtr,
+    _In_ UCHAR CommandIndex,
+    _In_ UINT32 Argument,
+    _In_ BOOLEAN WaitForBusy);
+
 //
-// General utility routines
+// Command queuing routines
 //
 
+BOOLEAN
+SdhcCqeIsQueueableRequest(
+    _In_ USDHC_EXTENSION* SdhcExtPtr,
+    _In_ SDPORT_REQUEST* RequestPtr);
+
+UINT32
+SdhcCqeGetFreeTasks(
+    _In_ USDHC_EXTENSION* SdhcExtPtr);
+
+BOOLEAN
+SdhcCqeMustDeferRequest(
+    _In_ USDHC_EXTENSION* SdhcExtPtr,
+    _In_ SDPORT_REQUEST* RequestPtr);
+
+VOID
+SdhcCqeIssueDeferredRequests(
+    _In_ USDHC_EXTENSION* SdhcExtPtr);
+
+BOOLEAN
+SdhcCqeFindTaskRequest(
+    _In_ USDHC_EXTENSION* SdhcExtPtr,
+    _In_ const SDPORT_COMMAND* CommandPtr,
+    _Out_ ULONG* TagPtr);
+
+NTSTATUS
+SdhcCqeIssueRequest(
+    _In_ USDHC_EXTENSION* SdhcExtPtr,
+    _In_ SDPORT_REQUEST* RequestPtr);
+
+NTSTATUS
+SdhcCqePrepareForCommand(
+    _In_ USDHC_EXTENSION* SdhcExtPtr,
+    _In_ SDPORT_REQUEST* RequestPtr);
+
+NTSTATUS
+SdhcCqeEnable(
+    _In_ USDHC_EXTENSION* SdhcExtPtr);
+
+NTSTATUS
+SdhcCqeDisable(
+    _In_ USDHC_EXTENSION* SdhcExtPtr);
+
+NTSTATUS
+SdhcCqeRecover(
+    _In_ USDHC_EXTENSION* SdhcExtPtr);
+
+NTSTATUS
+SdhcCqeSetCardCmdqMode(
+    _In_ USDHC_EXTENSION* SdhcExtPtr,
+    _In_ BOOLEAN Enable);
+
 VOID
-SdhcReadDataPort(
+SdhcCqeInterrupt(
     _In_ USDHC_EXTENSION* SdhcExtPtr,
-    _Out_writes_all_(WordCount) UINT32* BufferPtr,
-    _In_ UINT32 WordCount);
+    _Inout_ USDHC_INT_STATUS_REG* IntStatusPtr);
+
+BOOLEAN
+SdhcCqeCompleteTasks(
+    _In_ USDHC_EXTENSION* SdhcExtPtr,
+    _In_ SDPORT_REQUEST* RequestPtr,
+    _In_ ULONG Errors);
 
 VOID
-SdhcWriteDataPort(
+SdhcCqeReadCardSupport(
     _In_ USDHC_EXTENSION* SdhcExtPtr,
-    _In_reads_(WordCount) const UINT32* BufferPtr,
-    _In_ UINT32 WordCount);
+    _In_reads_(MMC_EXT_CSD_SIZE) const UCHAR* ExtCsdPtr);
+
+//
+// General utility routines
+//
 
 NTSTATUS
 SdhcCreateAdmaDescriptorTable(
     _In_ USDHC_EXTENSION* SdhcExtPtr,
     _In_ SDPORT_REQUEST* RequestPtr);
 
+BOOLEAN
+SdhcTransferNeedsBounce(
+    _In_ USDHC_EXTENSION* SdhcExtPtr,
+    _In_ SDPORT_REQUEST* RequestPtr);
+
+NTSTATUS
+SdhcCreateBounceDescriptorTable(
+    _In_ USDHC_EXTENSION* SdhcExtPtr,
+    _In_ SDPORT_REQUEST* RequestPtr);
+
+NTSTATUS
+SdhcPrepareDescriptorTable(
+    _In_ USDHC_EXTENSION* SdhcExtPtr,
+    _In_ SDPORT_REQUEST* RequestPtr,
+    _Out_ PHYSICAL_ADDRESS* DescriptorTablePhysicalAddressPtr);
+
 UINT32
 SdhcConvertStandardEventsToIntStatusMask(
     _In_ ULONG StdEventMask,
@@ -325,6 +591,11 @@ SdhcSdClockEnableInIdle(
     _In_ USDHC_EXTENSION* SdhcExtPtr,
     _In_ BOOLEAN Enable);
 
+UINT32
+SdhcFindTuningWindow(
+    _In_reads_(USDHC_TUNING_DELAY_CELL_COUNT / 32) const UINT32* PassMapPtr,
+    _Out_ UINT32* WindowLengthPtr);
+
 _IRQL_requires_same_
 _IRQL_requires_(PASSIVE_LEVEL)
 VOID
@@ -337,6 +608,26 @@ VOID
 SdhcLogCleanup(
     _In_ SD_MINIPORT* MiniportPtr);
 
+_IRQL_requires_max_(APC_LEVEL)
+NTSTATUS
+SdhcAllocateBounceSegment(
+    _In_ USDHC_EXTENSION* SdhcExtPtr);
+
+_IRQL_requires_max_(APC_LEVEL)
+VOID
+SdhcFreeBounceSegments(
+    _In_ SD_MINIPORT* MiniportPtr);
+
+_IRQL_requires_max_(APC_LEVEL)
+NTSTATUS
+SdhcAllocateCqeTaskList(
+    _In_ USDHC_EXTENSION* SdhcExtPtr);
+
+_IRQL_requires_max_(APC_LEVEL)
+VOID
+SdhcFreeCqeTaskLists(
+    _In_ SD_MINIPORT* MiniportPtr);
+
 //
 // ACPI utilities
 //
@@ -368,6 +659,20 @@ SdhcMiniportGetPdo(
     return sdhcPdoPtr;
 }
 
+__forceinline
+BOOLEAN
+SdhcIsExtCsdRead(
+    _In_ const SDPORT_COMMAND* CommandPtr
+    )
+{
+    return BOOLEAN(
+        (CommandPtr->Class == SdCommandClassStandard) &&
+        (CommandPtr->Index == MMC_CMD8_SEND_EXT_CSD) &&
+        (CommandPtr->TransferType == SdTransferTypeSingleBlock) &&
+        (CommandPtr->TransferDirection == SdTransferDirectionRead) &&
+        (CommandPtr->Length == MMC_EXT_CSD_SIZE));
+}
+
 //
 // Register 32-bit access routines
 //
@@ -54,10 +54,14 @@ typedef struct {
     UINT32 DLL_CTRL;
     UINT32 DLL_STATUS;
     UINT32 CLK_TUNE_CTRL_STATUS;
-    UINT32 _reserved2[21];
+    UINT32 _reserved2;
+    UINT32 STROBE_DLL_CTRL;
+    UINT32 STROBE_DLL_STATUS;
+    UINT32 _reserved3[18];
     UINT32 VEND_SPEC;
     UINT32 MMC_BOOT;
     UINT32 VEND_SPEC2;
+    UINT32 TUNING_CTRL;
 } USDHC_REGISTERS;
 
 //
@@ -129,7 +133,14 @@ typedef union {
 typedef union {
     UINT32 AsUint32;
     struct {
-        UINT32 _reserved0       : 16; // 0:15
+        UINT32 SDR50_SUPPORT    : 1; // 0
+        UINT32 SDR104_SUPPORT   : 1; // 1
+        UINT32 DDR50_SUPPORT    : 1; // 2
+        UINT32 _reserved0       : 5; // 3:7
+        UINT32 TIME_COUNT_RETUNING : 4; // 8:11
+        UINT32 _reserved3       : 1; // 12
+        UINT32 USE_TUNING_SDR50 : 1; // 13
+        UINT32 RETUNING_MODE    : 2; // 14:15
         UINT32 MBL              : 3; // 16:18
         UINT32 _reserved1       : 1; // 19
         UINT32 ADMAS            : 1; // 20
@@ -177,7 +188,9 @@ typedef union {
         UINT32 SMP_CLK_SEL    : 1; // 23
         UINT32 AUTO_TUNE_EN   : 1; //24
         UINT32 FBCLK_SEL      : 1; // 25
-        UINT32 _reserved1     : 6; // 26-31
+        UINT32 HS400_MODE     : 1; // 26
+        UINT32 EN_HS400_MODE  : 1; // 27
+        UINT32 _reserved1     : 4; // 28-31
     };
 } USDHC_MIX_CTRL_REG;
 
@@ -299,7 +312,7 @@ typedef union {
         UINT32 _reserved0   : 3; // 9:11
         UINT32 RTE          : 1; // 12
         UINT32 _reserved1   : 1; // 13
-        UINT32 TP           : 1; // 14
+        UINT32 TP           : 1; // 14, CQI on uSDHCs with CQE
         UINT32 _reserved2   : 1; // 15
         UINT32 CTOE         : 1; // 16
         UINT32 CCE          : 1; // 17
@@ -321,6 +334,11 @@ typedef union {
 typedef USDHC_INT_STATUS_REG USDHC_INT_STATUS_EN_REG;
 typedef USDHC_INT_STATUS_REG USDHC_INT_SIGNAL_EN_REG;
 
+#define USDHC_INT_STATUS_CC      0x00000001
+#define USDHC_INT_STATUS_TC      0x00000002
+#define USDHC_INT_STATUS_BWR     0x00000010
+#define USDHC_INT_STATUS_BRR     0x00000020
+#define USDHC_INT_STATUS_CQI     0x00004000
 #define USDHC_INT_STATUS_CTOE    0x00010000
 #define USDHC_INT_STATUS_CCE     0x00020000
 #define USDHC_INT_STATUS_CEBE    0x00040000
@@ -347,6 +365,11 @@ typedef USDHC_INT_STATUS_REG USDHC_INT_SIGNAL_EN_REG;
                                     USDHC_INT_STATUS_DATA_ERROR  | \
                                     USDHC_INT_STATUS_TNE)
 
+#define USDHC_INT_STATUS_TUNING     (USDHC_INT_STATUS_CC     | \
+                                    USDHC_INT_STATUS_TC      | \
+                                    USDHC_INT_STATUS_BRR     | \
+                                    USDHC_INT_STATUS_ERROR)
+
 //
 // Vendor Specific Register uSDHCx_VEND_SPEC fields
 //
@@ -412,6 +435,214 @@ typedef union {
 
 #define USDHC_VEND_SPEC2_RESET_VALUE     0x00000006
 
+//
+// Clock Tuning Control and Status Register uSDHCx_CLK_TUNE_CTRL_STATUS fields
+//
+typedef union {
+    UINT32 AsUint32;
+    struct {
+        UINT32 DLY_CELL_SET_POST    : 4; // 0:3
+        UINT32 DLY_CELL_SET_OUT     : 4; // 4:7
+        UINT32 DLY_CELL_SET_PRE     : 7; // 8:14
+        UINT32 NXT_ERR              : 1; // 15
+        UINT32 TAP_SEL_POST         : 4; // 16:19
+        UINT32 TAP_SEL_OUT          : 4; // 20:23
+        UINT32 TAP_SEL_PRE          : 7; // 24:30
+        UINT32 PRE_ERR              : 1; // 31
+    };
+} USDHC_CLK_TUNE_CTRL_STATUS_REG;
+
+//
+// The pre-sampling delay line has 128 cells
+//
+#define USDHC_TUNING_DELAY_CELL_COUNT    128
+
+//
+// Strobe DLL Control Register uSDHCx_STROBE_DLL_CTRL fields (HS400)
+//
+typedef union {
+    UINT32 AsUint32;
+    struct {
+        UINT32 ENABLE               : 1; // 0
+        UINT32 RESET                : 1; // 1
+        UINT32 SLV_FORCE_UPD        : 1; // 2
+        UINT32 SLV_DLY_TARGET       : 4; // 3:6
+        UINT32 GATE_UPDATE_0        : 1; // 7
+        UINT32 GATE_UPDATE_1        : 1; // 8
+        UINT32 SLV_OVERRIDE         : 1; // 9
+        UINT32 SLV_OVERRIDE_VAL     : 7; // 10:16
+        UINT32 _reserved0           : 3; // 17:19
+        UINT32 SLV_UPDATE_INT       : 8; // 20:27
+        UINT32 REF_UPDATE_INT       : 4; // 28:31
+    };
+} USDHC_STROBE_DLL_CTRL_REG;
+
+#define USDHC_STROBE_DLL_CTRL_SLV_DLY_TARGET_DEFAULT    0x7
+#define USDHC_STROBE_DLL_CTRL_SLV_UPDATE_INT_DEFAULT    0x4
+
+//
+// Strobe DLL Status Register uSDHCx_STROBE_DLL_STATUS fields
+//
+typedef union {
+    UINT32 AsUint32;
+    struct {
+        UINT32 SLV_LOCK             : 1; // 0
+        UINT32 REF_LOCK             : 1; // 1
+        UINT32 SLV_SEL              : 7; // 2:8
+        UINT32 REF_SEL              : 7; // 9:15
+        UINT32 _reserved0           : 16; // 16:31
+    };
+} USDHC_STROBE_DLL_STATUS_REG;
+
+//
+// Tuning Control Register uSDHCx_TUNING_CTRL fields, only present on
+// uSDHC revisions that implement standard tuning
+//
+typedef union {
+    UINT32 AsUint32;
+    struct {
+        UINT32 TUNING_START_TAP     : 8; // 0:7
+        UINT32 TUNING_COUNTER       : 8; // 8:15
+        UINT32 TUNING_STEP          : 3; // 16:18
+        UINT32 _reserved0           : 1; // 19
+        UINT32 TUNING_WINDOW        : 3; // 20:22
+        UINT32 _reserved1           : 1; // 23
+        UINT32 STD_TUNING_EN        : 1; // 24
+        UINT32 _reserved2           : 7; // 25:31
+    };
+} USDHC_TUNING_CTRL_REG;
+
+#define USDHC_TUNING_CTRL_START_TAP_DEFAULT    0x1
+#define USDHC_TUNING_CTRL_STEP_DEFAULT         0x1
+
+//
+// Command Queuing Engine (CQE) registers, found on iMX8M uSDHCs at an offset
+// from the uSDHC register base and laid out as per eMMC 5.1 CQHCI
+//
+#define USDHC_CQE_REGISTERS_OFFSET  0x100
+
+typedef struct {
+    UINT32 CQVER;
+    UINT32 CQCAP;
+    UINT32 CQCFG;
+    UINT32 CQCTL;
+    UINT32 CQIS;
+    UINT32 CQISTE;
+    UINT32 CQISGE;
+    UINT32 CQIC;
+    UINT32 CQTDLBA;
+    UINT32 CQTDLBAU;
+    UINT32 CQTDBR;
+    UINT32 CQTCN;
+    UINT32 CQDQS;
+    UINT32 CQDPT;
+    UINT32 CQTCLR;
+    UINT32 _reserved0;
+    UINT32 CQSSC1;
+    UINT32 CQSSC2;
+    UINT32 CQCRDCT;
+    UINT32 _reserved1;
+    UINT32 CQRMEM;
+    UINT32 CQTERRI;
+    UINT32 CQCRI;
+    UINT32 CQCRA;
+} USDHC_CQE_REGISTERS;
+
+//
+// CQE Configuration Register CQCFG fields
+//
+typedef union {
+    UINT32 AsUint32;
+    struct {
+        UINT32 CQ_EN            : 1; // 0
+        UINT32 _reserved0       : 7; // 1:7
+        UINT32 TASK_DESC_SIZE   : 1; // 8
+        UINT32 _reserved1       : 3; // 9:11
+        UINT32 DCMD_EN          : 1; // 12
+        UINT32 _reserved2       : 19; // 13:31
+    };
+} USDHC_CQCFG_REG;
+
+//
+// CQE Control Register CQCTL fields
+//
+typedef union {
+    UINT32 AsUint32;
+    struct {
+        UINT32 HALT             : 1; // 0
+        UINT32 _reserved0       : 7; // 1:7
+        UINT32 CLEAR_ALL_TASKS  : 1; // 8
+        UINT32 _reserved1       : 23; // 9:31
+    };
+} USDHC_CQCTL_REG;
+
+//
+// CQE Interrupt Status Register CQIS fields, CQISTE and CQISGE share the layout
+//
+#define USDHC_CQIS_HAC              0x00000001
+#define USDHC_CQIS_TCC              0x00000002
+#define USDHC_CQIS_RED              0x00000004
+#define USDHC_CQIS_TCL              0x00000008
+
+#define USDHC_CQIS_ALL              (USDHC_CQIS_HAC | \
+                                    USDHC_CQIS_TCC  | \
+                                    USDHC_CQIS_RED  | \
+                                    USDHC_CQIS_TCL)
+
+//
+// CQE Task Error Information Register CQTERRI fields
+//
+typedef union {
+    UINT32 AsUint32;
+    struct {
+        UINT32 RMECI            : 6; // 0:5
+        UINT32 _reserved0       : 2; // 6:7
+        UINT32 RMETI            : 5; // 8:12
+        UINT32 _reserved1       : 2; // 13:14
+        UINT32 RMEFV            : 1; // 15
+        UINT32 DTECI            : 6; // 16:21
+        UINT32 _reserved2       : 2; // 22:23
+        UINT32 DTETI            : 5; // 24:28
+        UINT32 _reserved3       : 2; // 29:30
+        UINT32 DTEFV            : 1; // 31
+    };
+} USDHC_CQTERRI_REG;
+
+#define USDHC_CQE_TASK_COUNT        32
+
+//
+// Layout and definitions of the CQE 64-bit task descriptor. Each slot of the
+// task descriptor list holds a task descriptor followed by an ADMA2 link
+// descriptor to the task's ADMA2 descriptor table
+//
+typedef union {
+    UINT64 AsUint64;
+    struct {
+        UINT32 Valid            : 1; // 0
+        UINT32 End              : 1; // 1
+        UINT32 Int              : 1; // 2
+        UINT32 Action           : 3; // 3:5
+        UINT32 ForcedProgramming : 1; // 6
+        UINT32 Context          : 4; // 7:10
+        UINT32 DataTag          : 1; // 11
+        UINT32 DataDirection    : 1; // 12
+        UINT32 Priority         : 1; // 13
+        UINT32 QueueBarrier     : 1; // 14
+        UINT32 ReliableWrite    : 1; // 15
+        UINT32 BlockCount       : 16; // 16:31
+        UINT32 BlockAddress;
+    };
+} USDHC_CQE_TASK_DESCRIPTOR;
+
+#define USDHC_CQE_TASK_ACTION_TASK          0x5
+#define USDHC_CQE_TASK_DIRECTION_WRITE      0x0
+#define USDHC_CQE_TASK_DIRECTION_READ       0x1
+
+typedef struct {
+    USDHC_CQE_TASK_DESCRIPTOR Task;
+    USDHC_ADMA2_DESCRIPTOR_TABLE_ENTRY Link;
+} USDHC_CQE_TASK_SLOT;
+
 //
 // uSDHCx Registers Debug Layout
 //
@@ -442,11 +673,15 @@ typedef struct {
     UINT32 _reserved1;
     UINT32 DLL_CTRL;
     UINT32 DLL_STATUS;
-    UINT32 CLK_TUNE_CTRL_STATUS;
-    UINT32 _reserved2[21];
+    USDHC_CLK_TUNE_CTRL_STATUS_REG CLK_TUNE_CTRL_STATUS;
+    UINT32 _reserved2;
+    USDHC_STROBE_DLL_CTRL_REG STROBE_DLL_CTRL;
+    USDHC_STROBE_DLL_STATUS_REG STROBE_DLL_STATUS;
+    UINT32 _reserved3[18];
     USDHC_VEND_SPEC_REG VEND_SPEC;
     UINT32 MMC_BOOT;
     UINT32 VEND_SPEC2;
+    USDHC_TUNING_CTRL_REG TUNING_CTRL;
 } USDHC_REGISTERS_DEBUG;
 
 #include <poppack.h> // pshpack1.h
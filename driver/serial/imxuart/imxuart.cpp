@@ -12,6 +12,7 @@
 //
 #include "precomp.h"
 #include "imxuarthw.h"
+#include "imxuartioctl.h"
 #include "imxuart.h"
 #include "HalExtiMXDmaCfg.h"
 
@@ -49,50 +50,25 @@ IMX_UART_RING_BUFFER::EnqueueBytes (
     ULONG InputBufferSize
     )
 {
-    if (InputBufferSize == 0) return 0;
+    ULONG bytesCopied = 0;
 
-    const ULONG tail = ReadULongAcquire(&this->TailIndex);
-    const ULONG head = this->HeadIndex;
-    const ULONG size = this->Size;
-
-    ULONG bytesCopied;
-    if (((head + 1) % size) == tail) {
-        return 0;
-    } else if (head >= tail) {
-        // copy from head to the end
-        ULONG maxCount = (tail == 0) ? (size - 1) : size;
-        ULONG count = min(maxCount - head, InputBufferSize);
-        memcpy(
-            &this->BufferPtr[head],
-            &InputBufferPtr[0],
-            count);
-
-        bytesCopied = count;
-
-        // copy from beginning to tail
-        if (tail != 0) {
-            count = min(tail - 1, InputBufferSize - bytesCopied);
-            memcpy(
-                &this->BufferPtr[0],
-                &InputBufferPtr[bytesCopied],
-                count);
-
-            bytesCopied += count;
+    //
+    // At most two spans: head to the end of the buffer, then the beginning
+    // of the buffer up to the tail.
+    //
+    while (bytesCopied < InputBufferSize) {
+        ULONG spanLength;
+        UCHAR* spanPtr = this->ReserveEnqueueSpan(&spanLength);
+        if (spanLength == 0) {
+            break;
         }
-    } else {
-        // copy from head to tail
-        ULONG count = min(tail - head - 1, InputBufferSize);
-        memcpy(
-            &this->BufferPtr[head],
-            &InputBufferPtr[0],
-            count);
 
-        bytesCopied = count;
+        const ULONG count = min(spanLength, InputBufferSize - bytesCopied);
+        memcpy(spanPtr, &InputBufferPtr[bytesCopied], count);
+        this->CommitEnqueue(count);
+        bytesCopied += count;
     }
 
-    // Update head index
-    const ULONG newHeadIndex = (head + bytesCopied) % size;
-    WriteULongRelease(&this->HeadIndex, newHeadIndex);
     return bytesCopied;
 }
 
@@ -103,48 +79,94 @@ IMX_UART_RING_BUFFER::DequeueBytes (
     ULONG OutputBufferSize
     )
 {
-    const ULONG head = ReadULongAcquire(&this->HeadIndex);
-    const ULONG tail = this->TailIndex;
-    const ULONG size = this->Size;
+    ULONG bytesCopied = 0;
 
-    ULONG bytesCopied;
-    if (head == tail) {
-        return 0;
-    } else if (head > tail) {
-        // copy from tail to head
-        ULONG count = min(head - tail, OutputBufferSize);
-        memcpy(
-            &OutputBufferPtr[0],
-            &this->BufferPtr[tail],
-            count);
-
-        bytesCopied = count;
-    } else {
-        // copy from tail to end
-        ULONG count = min(size - tail, OutputBufferSize);
-        memcpy(
-            &OutputBufferPtr[0],
-            &this->BufferPtr[tail],
-            count);
-
-        bytesCopied = count;
-
-        // copy from beginning to head
-        count = min(head, OutputBufferSize - bytesCopied);
-        memcpy(
-            &OutputBufferPtr[bytesCopied],
-            &this->BufferPtr[0],
-            count);
+    //
+    // At most two spans: tail to the end of the buffer, then the beginning
+    // of the buffer up to the head.
+    //
+    while (bytesCopied < OutputBufferSize) {
+        ULONG spanLength;
+        const UCHAR* spanPtr = this->ReserveDequeueSpan(&spanLength);
+        if (spanLength == 0) {
+            break;
+        }
 
+        const ULONG count = min(spanLength, OutputBufferSize - bytesCopied);
+        memcpy(&OutputBufferPtr[bytesCopied], spanPtr, count);
+        this->CommitDequeue(count);
         bytesCopied += count;
     }
 
-    // update tail pointer
-    const ULONG newTailIndex = (tail + bytesCopied) % size;
-    WriteULongRelease(&this->TailIndex, newTailIndex);
     return bytesCopied;
 }
 
+//
+// Returns the number of characters that can be written to the TX FIFO
+// without polling UTS[TXFULL], based on status registers sampled earlier.
+// The FIFO only drains between the sample and the writes, so the result
+// is a lower bound.
+//
+FORCEINLINE
+ULONG
+IMXUartTxFifoKnownFreeCount (
+    ULONG Usr1,
+    ULONG Usr2,
+    ULONG UfcrCopy
+    )
+{
+    if ((Usr2 & IMX_UART_USR2_TXFE) != 0) {
+        return IMX_UART_FIFO_COUNT;
+    }
+
+    //
+    // TRDY is set while the FIFO holds fewer than TXTL characters
+    //
+    if ((Usr1 & IMX_UART_USR1_TRDY) != 0) {
+        const ULONG txtl =
+            (UfcrCopy & IMX_UART_UFCR_TXTL_MASK) >> IMX_UART_UFCR_TXTL_SHIFT;
+
+        return IMX_UART_FIFO_COUNT - min(txtl, IMX_UART_FIFO_COUNT);
+    }
+
+    return 0;
+}
+
+//
+// Writes bytes to the TX FIFO. The first KnownFreeCount bytes are written
+// without checking FIFO status, then UTS[TXFULL] is polled per byte.
+//
+FORCEINLINE
+ULONG
+IMXUartWriteTxFifo (
+    IMX_UART_REGISTERS* RegistersPtr,
+    _In_reads_(Length) const UCHAR* BufferPtr,
+    ULONG Length,
+    ULONG KnownFreeCount
+    )
+{
+    const ULONG burstLength = min(Length, KnownFreeCount);
+    ULONG bytesWritten = 0;
+    for (; bytesWritten < burstLength; ++bytesWritten) {
+        WRITE_REGISTER_NOFENCE_ULONG(
+            &RegistersPtr->Txd,
+            BufferPtr[bytesWritten]);
+    }
+
+    for (; bytesWritten < Length; ++bytesWritten) {
+        const ULONG uts = READ_REGISTER_NOFENCE_ULONG(&RegistersPtr->Uts);
+        if ((uts & IMX_UART_UTS_TXFULL) != 0) {
+            break;
+        }
+
+        WRITE_REGISTER_NOFENCE_ULONG(
+            &RegistersPtr->Txd,
+            BufferPtr[bytesWritten]);
+    }
+
+    return bytesWritten;
+}
+
 _Use_decl_annotations_
 BOOLEAN
 IMXUartEvtInterruptIsr (
@@ -174,6 +196,9 @@ IMXUartEvtInterruptIsr (
         return FALSE;
     }
 
+    ++interruptContextPtr->Statistics.InterruptCount;
+    ++interruptContextPtr->FifoTuning.WindowInterruptCount;
+
     bool queueDpc = false;
     const ULONG waitMask = interruptContextPtr->WaitMask;
     ULONG waitEvents = interruptContextPtr->WaitEvents;
@@ -182,63 +207,89 @@ IMXUartEvtInterruptIsr (
     // If DMA RX transfer is not active, service the RX buffer
     //
     if (!IMXUartIsRxDmaActive(interruptContextPtr) &&
-        ((usr1Masked & (IMX_UART_USR1_AGTIM | IMX_UART_USR1_RRDY)) != 0)) {
+        (((usr1Masked & (IMX_UART_USR1_AGTIM | IMX_UART_USR1_RRDY)) != 0) ||
+         ((usr2Masked & IMX_UART_USR2_IDLE) != 0))) {
 
         IMX_UART_RING_BUFFER* rxBufferPtr = &interruptContextPtr->RxBuffer;
-        const ULONG tail = ReadULongAcquire(&rxBufferPtr->TailIndex);
-        const ULONG oldHead = rxBufferPtr->HeadIndex;
-        const ULONG size = rxBufferPtr->Size;
 
-        ULONG head = oldHead;
-        ULONG nextHead = (head + 1) % size;
+        //
+        // Drain the FIFO directly into contiguous spans of the intermediate
+        // buffer. The buffer is full when a span comes back empty.
+        //
         ULONG bytesRead = 0;
-        while (nextHead != tail) {
-            const ULONG rxd = READ_REGISTER_NOFENCE_ULONG(&registersPtr->Rxd);
-            if ((rxd & IMX_UART_RXD_CHARRDY) == 0) {
+        bool fifoEmpty = false;
+        for (;;) {
+            ULONG spanLength;
+            UCHAR* spanPtr = rxBufferPtr->ReserveEnqueueSpan(&spanLength);
+            if (spanLength == 0) {
                 break;
             }
 
-            if ((rxd & IMX_UART_RXD_ERR) != 0) {
-                IMX_UART_LOG_ERROR("RX FIFO reported error. (rxd = 0x%lx)", rxd);
-
-                if ((rxd & IMX_UART_RXD_OVRRUN) != 0) {
-                    interruptContextPtr->CommStatusErrors |= SERIAL_ERROR_OVERRUN;
+            ULONG spanBytes = 0;
+            while (spanBytes < spanLength) {
+                const ULONG rxd = READ_REGISTER_NOFENCE_ULONG(&registersPtr->Rxd);
+                if ((rxd & IMX_UART_RXD_CHARRDY) == 0) {
+                    fifoEmpty = true;
+                    break;
                 }
 
-                if ((rxd & IMX_UART_RXD_FRMERR) != 0) {
-                    interruptContextPtr->CommStatusErrors |= SERIAL_ERROR_FRAMING;
-                }
+                if ((rxd & IMX_UART_RXD_ERR) != 0) {
+                    IMX_UART_LOG_ERROR("RX FIFO reported error. (rxd = 0x%lx)", rxd);
 
-                if ((rxd & IMX_UART_RXD_BRK) != 0) {
-                    interruptContextPtr->CommStatusErrors |= SERIAL_ERROR_BREAK;
-                }
+                    if ((rxd & IMX_UART_RXD_OVRRUN) != 0) {
+                        interruptContextPtr->CommStatusErrors |= SERIAL_ERROR_OVERRUN;
+                        ++interruptContextPtr->Statistics.RxOverrunCount;
+                        ++interruptContextPtr->FifoTuning.WindowRxOverrunCount;
+                    }
+
+                    if ((rxd & IMX_UART_RXD_FRMERR) != 0) {
+                        interruptContextPtr->CommStatusErrors |= SERIAL_ERROR_FRAMING;
+                    }
+
+                    if ((rxd & IMX_UART_RXD_BRK) != 0) {
+                        interruptContextPtr->CommStatusErrors |= SERIAL_ERROR_BREAK;
+                    }
+
+                    if ((rxd & IMX_UART_RXD_PRERR) != 0) {
+                        interruptContextPtr->CommStatusErrors |= SERIAL_ERROR_PARITY;
+                    }
+
+                    interruptContextPtr->FramedReceive.Flags |=
+                        ((rxd & IMX_UART_RXD_OVRRUN) != 0) ?
+                            IMX_UART_FRAME_FLAG_OVERRUN :
+                            IMX_UART_FRAME_FLAG_ERROR;
 
-                if ((rxd & IMX_UART_RXD_PRERR) != 0) {
-                    interruptContextPtr->CommStatusErrors |= SERIAL_ERROR_PARITY;
+                    waitEvents |= (waitMask & SERIAL_EV_ERR);
                 }
 
-                waitEvents |= (waitMask & SERIAL_EV_ERR);
+                spanPtr[spanBytes] = static_cast<UCHAR>(rxd);
+                ++spanBytes;
             }
 
-            rxBufferPtr->BufferPtr[head] = static_cast<UCHAR>(rxd);
+            rxBufferPtr->CommitEnqueue(spanBytes);
+            bytesRead += spanBytes;
 
-            ++bytesRead;
-            head = nextHead;
-            nextHead = (nextHead + 1) % size;
+            if (fifoEmpty) {
+                break;
+            }
         }
 
-        WriteULongRelease(&rxBufferPtr->HeadIndex, head);
-
         IMX_UART_LOG_TRACE("Read %lu bytes from FIFO.", bytesRead);
 
+        ++interruptContextPtr->Statistics.RxInterruptCount;
+        interruptContextPtr->Statistics.RxByteCount += bytesRead;
+        ++interruptContextPtr->FifoTuning.WindowRxInterruptCount;
+        interruptContextPtr->FifoTuning.WindowRxByteCount += bytesRead;
+
         //
         // If the intermediate buffer is full, disable the RRDY and AGTIM
         // interrupts so they do not continue asserting
         //
-        if (nextHead == tail) {
+        if (!fifoEmpty) {
             IMX_UART_LOG_WARNING("Intermediate receive buffer overflowed, disabling RRDY and AGTIM.");
 
             interruptContextPtr->CommStatusErrors |= SERIAL_ERROR_QUEUEOVERRUN;
+            interruptContextPtr->FramedReceive.Flags |= IMX_UART_FRAME_FLAG_OVERRUN;
             waitEvents |= (waitMask & SERIAL_EV_ERR);
 
             interruptContextPtr->Ucr1Copy &= ~IMX_UART_UCR1_RRDYEN;
@@ -265,7 +316,8 @@ IMXUartEvtInterruptIsr (
         // If there are bytes available and RX notifications are enabled,
         // queue the receive ready notification
         //
-        if ((head != tail) &&
+        if (!rxBufferPtr->IsEmpty() &&
+            !interruptContextPtr->FramedReceive.Enabled &&
             (interruptContextPtr->RxState ==
              IMX_UART_STATE::WAITING_FOR_INTERRUPT)) {
 
@@ -280,11 +332,104 @@ IMXUartEvtInterruptIsr (
         // Acknowledge AGTIM interrupt
         //
         if ((usr1Masked & IMX_UART_USR1_AGTIM) != 0) {
+            ++interruptContextPtr->Statistics.AgingTimerCount;
+            ++interruptContextPtr->FifoTuning.WindowAgingTimerCount;
+
             IMX_UART_LOG_TRACE("Acknowledging AGTIM interrupt.");
             WRITE_REGISTER_NOFENCE_ULONG(
                 &registersPtr->Usr1,
                 IMX_UART_USR1_AGTIM);
         }
+
+        //
+        // In framed receive mode, the idle condition ends the frame
+        // received since the previous one
+        //
+        if ((usr2Masked & IMX_UART_USR2_IDLE) != 0) {
+            WRITE_REGISTER_NOFENCE_ULONG(
+                &registersPtr->Usr2,
+                IMX_UART_USR2_IDLE);
+
+            auto framedPtr = &interruptContextPtr->FramedReceive;
+            const ULONG endIndex = rxBufferPtr->HeadIndex;
+            if (!framedPtr->Enabled || (endIndex == framedPtr->StartIndex)) {
+                //
+                // No frame to end
+                //
+            } else if ((framedPtr->QueueHead - framedPtr->QueueTail) >=
+                       IMX_UART_FRAME_QUEUE_SIZE) {
+
+                //
+                // No descriptor left to end the frame, it gets merged with
+                // the next one. Flag the merged frame so the boundary loss
+                // is reported to the reader.
+                //
+                IMX_UART_LOG_WARNING("Frame queue full, frame boundary lost.");
+
+                interruptContextPtr->CommStatusErrors |= SERIAL_ERROR_QUEUEOVERRUN;
+                framedPtr->Flags |= IMX_UART_FRAME_FLAG_OVERRUN;
+                waitEvents |= (waitMask & SERIAL_EV_ERR);
+
+            } else {
+
+                IMX_UART_FRAME_DESCRIPTOR* framePtr = &framedPtr->Queue[
+                    framedPtr->QueueHead & (IMX_UART_FRAME_QUEUE_SIZE - 1)];
+
+                framePtr->EndIndex = endIndex;
+                framePtr->Flags = framedPtr->Flags;
+                framePtr->Timestamp = KeQueryPerformanceCounter(nullptr);
+
+                IMX_UART_LOG_TRACE(
+                    "End of frame. (frameLength = %lu)",
+                    IMX_UART_RING_BUFFER::Count(
+                        endIndex,
+                        framedPtr->StartIndex,
+                        rxBufferPtr->Size));
+
+                ++framedPtr->QueueHead;
+                framedPtr->StartIndex = endIndex;
+                framedPtr->Flags = 0;
+
+                if (framedPtr->State == IMX_UART_STATE::WAITING_FOR_INTERRUPT) {
+                    framedPtr->State = IMX_UART_STATE::WAITING_FOR_DPC;
+                    queueDpc = true;
+                }
+            }
+        }
+    }
+
+    //
+    // If DMA RX transfer is active, the line going idle means the sender
+    // paused. Bytes sitting in a partially filled SDMA buffer descriptor
+    // are picked up by the DPC rather than by the progress timer.
+    //
+    if (IMXUartIsRxDmaActive(interruptContextPtr) &&
+        (((usr1Masked & IMX_UART_USR1_AGTIM) != 0) ||
+         ((usr2Masked & IMX_UART_USR2_IDLE) != 0))) {
+
+        ++interruptContextPtr->Statistics.RxDmaIdleCount;
+
+        if ((usr1Masked & IMX_UART_USR1_AGTIM) != 0) {
+            WRITE_REGISTER_NOFENCE_ULONG(
+                &registersPtr->Usr1,
+                IMX_UART_USR1_AGTIM);
+        }
+
+        if ((usr2Masked & IMX_UART_USR2_IDLE) != 0) {
+            WRITE_REGISTER_NOFENCE_ULONG(
+                &registersPtr->Usr2,
+                IMX_UART_USR2_IDLE);
+        }
+
+        if (interruptContextPtr->RxDmaIdleState ==
+            IMX_UART_STATE::WAITING_FOR_INTERRUPT) {
+
+            IMX_UART_LOG_TRACE("RX DMA: line idle, going to WAITING_FOR_DPC state.");
+
+            interruptContextPtr->RxDmaIdleState = IMX_UART_STATE::WAITING_FOR_DPC;
+
+            queueDpc = true;
+        }
     }
 
     if ((usr2 & IMX_UART_USR2_RDR) != 0) {
@@ -296,27 +441,58 @@ IMXUartEvtInterruptIsr (
     //
     if (!IMXUartIsTxDmaActive(interruptContextPtr)) {
         IMX_UART_RING_BUFFER* txBufferPtr = &interruptContextPtr->TxBuffer;
-        const ULONG head = ReadULongAcquire(&txBufferPtr->HeadIndex);
-        ULONG tail = txBufferPtr->TailIndex;
-        const ULONG size = txBufferPtr->Size;
+        ULONG fifoFreeCount = IMXUartTxFifoKnownFreeCount(
+                usr1,
+                usr2,
+                interruptContextPtr->UfcrCopy);
 
-        if (tail != head) {
-            do {
-                const ULONG uts = READ_REGISTER_NOFENCE_ULONG(&registersPtr->Uts);
-                if ((uts & IMX_UART_UTS_TXFULL) != 0) {
-                    break;
-                }
+        //
+        // If the FIFO ran completely empty while TRDY was armed and bytes
+        // were waiting, the line went idle before we could refill it.
+        //
+        if (((usr1Masked & IMX_UART_USR1_TRDY) != 0) &&
+            ((usr2 & IMX_UART_USR2_TXFE) != 0) &&
+            !txBufferPtr->IsEmpty()) {
+
+            ++interruptContextPtr->Statistics.TxUnderrunCount;
+            ++interruptContextPtr->FifoTuning.WindowTxUnderrunCount;
+        }
+
+        //
+        // Feed the FIFO from contiguous spans of the intermediate buffer
+        //
+        ULONG txBytesWritten = 0;
+        for (;;) {
+            ULONG spanLength;
+            const UCHAR* spanPtr = txBufferPtr->ReserveDequeueSpan(&spanLength);
+            if (spanLength == 0) {
+                break;
+            }
 
-                WRITE_REGISTER_NOFENCE_ULONG(
-                    &registersPtr->Txd,
-                    txBufferPtr->BufferPtr[tail]);
+            const ULONG bytesWritten = IMXUartWriteTxFifo(
+                    registersPtr,
+                    spanPtr,
+                    spanLength,
+                    fifoFreeCount);
 
-                tail = (tail + 1) % size;
-            } while (tail != head);
+            txBufferPtr->CommitDequeue(bytesWritten);
+            txBytesWritten += bytesWritten;
+            if (bytesWritten != spanLength) {
+                break;
+            }
+
+            fifoFreeCount -= min(fifoFreeCount, bytesWritten);
+        }
 
-            WriteULongRelease(&txBufferPtr->TailIndex, tail);
+        if (txBytesWritten != 0) {
+            ++interruptContextPtr->Statistics.TxInterruptCount;
+            interruptContextPtr->Statistics.TxByteCount += txBytesWritten;
         }
 
+        const ULONG head = ReadULongAcquire(&txBufferPtr->HeadIndex);
+        const ULONG tail = txBufferPtr->TailIndex;
+        const ULONG size = txBufferPtr->Size;
+
         //
         // If we drained the intermediate buffer, mask the TX ready interrupt
         // so it does not cause a storm. The interrupt will be reenabled
@@ -439,6 +615,16 @@ IMXUartEvtInterruptIsr (
             IMX_UART_USR2_RTSF);
     }
 
+    //
+    // Periodically retune the FIFO thresholds to the observed traffic
+    //
+    if (interruptContextPtr->FifoTuning.Enabled &&
+        (interruptContextPtr->FifoTuning.WindowInterruptCount >=
+         IMX_UART_FIFO_TUNING_WINDOW)) {
+
+        IMXUartTuneFifoThresholds(interruptContextPtr);
+    }
+
     interruptContextPtr->WaitEvents = waitEvents;
     if (waitEvents != 0) {
         queueDpc = true;
@@ -462,11 +648,12 @@ IMXUartEvtInterruptDpc (
             IMXUartGetInterruptContext(WdfInterrupt);
 
     IMX_UART_LOG_TRACE(
-        "DPC was fired. (RxState = %d, RxDmaState = %d, "
+        "DPC was fired. (RxState = %d, RxDmaState = %d, RxDmaIdleState = %d, "
         "TxState = %d, TxDrainState = %d, TxPurgeState = %d, "
         "TxDmaState = %d, TxDmaDrainState = %d, WaitEvents = 0x%lx)",
         int(interruptContextPtr->RxState),
         int(interruptContextPtr->RxDmaState),
+        int(interruptContextPtr->RxDmaIdleState),
         int(interruptContextPtr->TxState),
         int(interruptContextPtr->TxDrainState),
         int(interruptContextPtr->TxPurgeState),
@@ -483,6 +670,58 @@ IMXUartEvtInterruptDpc (
         SerCx2PioReceiveReady(interruptContextPtr->SerCx2PioReceive);
     }
 
+    //
+    // Frames were received in framed receive mode, rearm the frame
+    // notification and hand the frames out to the pending read requests
+    //
+    if (interruptContextPtr->FramedReceive.State ==
+        IMX_UART_STATE::WAITING_FOR_DPC) {
+
+        bool isFrameNotificationArmed = false;
+
+        WdfInterruptAcquireLock(interruptContextPtr->WdfInterrupt);
+        if (interruptContextPtr->FramedReceive.State ==
+            IMX_UART_STATE::WAITING_FOR_DPC) {
+
+            interruptContextPtr->FramedReceive.State =
+                IMX_UART_STATE::WAITING_FOR_INTERRUPT;
+
+            isFrameNotificationArmed = true;
+        }
+        WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
+
+        if (isFrameNotificationArmed) {
+            IMXUartFramedReceiveProcess(
+                IMXUartGetDeviceContext(WdfInterruptGetDevice(WdfInterrupt)));
+        }
+    }
+
+    //
+    // The line went idle during a custom receive transaction, rearm the
+    // idle notification and pick up the bytes received so far
+    //
+    if (interruptContextPtr->RxDmaIdleState ==
+        IMX_UART_STATE::WAITING_FOR_DPC) {
+
+        bool isIdleNotificationArmed = false;
+
+        WdfInterruptAcquireLock(interruptContextPtr->WdfInterrupt);
+        if (interruptContextPtr->RxDmaIdleState ==
+            IMX_UART_STATE::WAITING_FOR_DPC) {
+
+            interruptContextPtr->RxDmaIdleState =
+                IMX_UART_STATE::WAITING_FOR_INTERRUPT;
+
+            isIdleNotificationArmed = true;
+        }
+        WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
+
+        if (isIdleNotificationArmed) {
+            IMXUartRxDmaUpdateProgress(
+                interruptContextPtr->RxDmaTransactionContextPtr);
+        }
+    }
+
     //
     // If the TX buffer is below the threshold and TX notifications are
     // enabled, call SerCx2PioTransmitReady() to request more bytes
@@ -562,6 +801,8 @@ NTSTATUS IMXUartEvtSerCx2FileOpen (WDFDEVICE WdfDevice)
 
     NT_ASSERT(interruptContextPtr->RxState == IMX_UART_STATE::STOPPED);
     NT_ASSERT(interruptContextPtr->RxDmaState == IMX_UART_STATE::STOPPED);
+    NT_ASSERT(interruptContextPtr->RxDmaIdleState == IMX_UART_STATE::STOPPED);
+    NT_ASSERT(interruptContextPtr->FramedReceive.State == IMX_UART_STATE::STOPPED);
     NT_ASSERT(interruptContextPtr->TxState == IMX_UART_STATE::STOPPED);
     NT_ASSERT(interruptContextPtr->TxDrainState == IMX_UART_STATE::STOPPED);
     NT_ASSERT(interruptContextPtr->TxPurgeState == IMX_UART_STATE::STOPPED);
@@ -633,6 +874,8 @@ VOID IMXUartEvtSerCx2FileClose (WDFDEVICE WdfDevice)
     IMX_UART_INTERRUPT_CONTEXT* interruptContextPtr =
             deviceContextPtr->InterruptContextPtr;
 
+    IMXUartSetFramedReceive(deviceContextPtr, false, 0);
+
     NTSTATUS status = IMXUartStopRxDma(interruptContextPtr);
     if (!NT_SUCCESS(status)) {
         IMX_UART_LOG_ERROR(
@@ -652,7 +895,8 @@ VOID IMXUartEvtSerCx2FileClose (WDFDEVICE WdfDevice)
         ~(IMX_UART_UCR1_SNDBRK |
           IMX_UART_UCR1_RRDYEN |
           IMX_UART_UCR1_TRDYEN |
-          IMX_UART_UCR1_TXMPTYEN);
+          IMX_UART_UCR1_TXMPTYEN |
+          IMX_UART_UCR1_IDEN);
 
     interruptContextPtr->Ucr2Copy &= ~(IMX_UART_UCR2_ATEN | IMX_UART_UCR2_RTSEN);
     interruptContextPtr->Ucr4Copy &= ~IMX_UART_UCR4_BKEN;
@@ -665,6 +909,7 @@ VOID IMXUartEvtSerCx2FileClose (WDFDEVICE WdfDevice)
 
     interruptContextPtr->RxState = IMX_UART_STATE::STOPPED;
     interruptContextPtr->RxDmaState = IMX_UART_STATE::STOPPED;
+    interruptContextPtr->RxDmaIdleState = IMX_UART_STATE::STOPPED;
     interruptContextPtr->TxState = IMX_UART_STATE::STOPPED;
     interruptContextPtr->TxDrainState = IMX_UART_STATE::STOPPED;
     interruptContextPtr->TxPurgeState = IMX_UART_STATE::STOPPED;
@@ -801,6 +1046,22 @@ IMXUartEvtSerCx2Control (
         IMXUartIoctlGetModemControl(deviceContextPtr, WdfRequest);
         return STATUS_SUCCESS;
 
+    case IOCTL_IMX_UART_GET_STATISTICS:
+        IMXUartIoctlGetStatistics(deviceContextPtr, WdfRequest);
+        return STATUS_SUCCESS;
+
+    case IOCTL_IMX_UART_CLEAR_STATISTICS:
+        IMXUartIoctlClearStatistics(deviceContextPtr, WdfRequest);
+        return STATUS_SUCCESS;
+
+    case IOCTL_IMX_UART_SET_FRAMED_RECEIVE:
+        IMXUartIoctlSetFramedReceive(deviceContextPtr, WdfRequest);
+        return STATUS_SUCCESS;
+
+    case IOCTL_IMX_UART_READ_FRAME:
+        IMXUartIoctlReadFrame(deviceContextPtr, WdfRequest);
+        return STATUS_SUCCESS;
+
     case IOCTL_SERIAL_RESET_DEVICE: __fallthrough;
     case IOCTL_SERIAL_SET_QUEUE_SIZE: __fallthrough;
     case IOCTL_SERIAL_SET_XOFF: __fallthrough;
@@ -848,6 +1109,14 @@ IMXUartEvtSerCx2PioReceiveReadBuffer (
 
     interruptContextPtr->RxState = IMX_UART_STATE::IDLE;
 
+    //
+    // In framed receive mode the intermediate buffer is drained by
+    // IOCTL_IMX_UART_READ_FRAME requests only
+    //
+    if (interruptContextPtr->FramedReceive.Enabled) {
+        return 0;
+    }
+
     //
     // Check if there is any RX data pending from
     // previous DMA transaction?
@@ -903,6 +1172,15 @@ IMXUartEvtSerCx2PioReceiveEnableReadyNotification (
         interruptContextPtr->RxState ==
         IMX_UART_STATE::IDLE);
 
+    //
+    // In framed receive mode, read requests wait without data
+    //
+    if (interruptContextPtr->FramedReceive.Enabled) {
+        interruptContextPtr->RxState = IMX_UART_STATE::WAITING_FOR_INTERRUPT;
+        WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
+        return;
+    }
+
     //
     // If RRDY has been disabled and there are bytes available, we must
     // complete the request inline because the interrupt might never come.
@@ -1019,18 +1297,16 @@ IMXUartEvtSerCx2PioTransmitWriteBuffer (
         //
         // Write directly to TX FIFO
         //
-        while (fifoBytesWritten < Length) {
-            const ULONG uts = READ_REGISTER_NOFENCE_ULONG(&registersPtr->Uts);
-            if ((uts & IMX_UART_UTS_TXFULL) != 0) {
-                break;
-            }
-
-            WRITE_REGISTER_NOFENCE_ULONG(
-                &registersPtr->Txd,
-                Buffer[fifoBytesWritten]);
-
-            ++fifoBytesWritten;
-        }
+        const ULONG usr1 = READ_REGISTER_NOFENCE_ULONG(&registersPtr->Usr1);
+        const ULONG usr2 = READ_REGISTER_NOFENCE_ULONG(&registersPtr->Usr2);
+        fifoBytesWritten = IMXUartWriteTxFifo(
+                registersPtr,
+                Buffer,
+                Length,
+                IMXUartTxFifoKnownFreeCount(
+                    usr1,
+                    usr2,
+                    interruptContextPtr->UfcrCopy));
     }
 
     //
@@ -1359,6 +1635,18 @@ IMXUartEvtSerCx2CustomReceiveTransactionStart (
     IMX_UART_LOG_TRACE(
         "Starting custom receive transaction, length %lu", Length);
 
+    //
+    // In framed receive mode, received data goes through the intermediate
+    // buffer to IOCTL_IMX_UART_READ_FRAME requests
+    //
+    if (interruptContextPtr->FramedReceive.Enabled) {
+        IMX_UART_LOG_WARNING(
+            "Custom receive transaction is not allowed in framed receive mode");
+
+        WdfRequestComplete(WdfRequest, STATUS_INVALID_DEVICE_STATE);
+        return;
+    }
+
     //
     // Start the RX DMA if not already started
     //
@@ -1387,19 +1675,33 @@ IMXUartEvtSerCx2CustomReceiveTransactionStart (
         IMXUartEvtCustomReceiveTransactionRequestCancel);
 
     if (NT_SUCCESS(status)) {
+        //
+        // Large transactions are received directly into the caller
+        // buffer. The cyclic transfer is paused so the bytes already
+        // in the intermediate buffer can be copied first.
+        //
+        bool isDirectTransfer =
+            (rxDmaTransactionContextPtr->DirectMinTransactionLength != 0) &&
+            (Length >= rxDmaTransactionContextPtr->DirectMinTransactionLength);
+
         //
         // Enable RX DMA and Aging DMA timer
         //
         // Even though we do not handle DMA receive transactions through
-        // ISR/DPC, but rather through the DMA completion routine, and
-        // DMA progress timer, we set the RxDma state to WAITING_FOR_DPC,
-        // to mark it as active.
+        // ISR/DPC, but rather through the DMA completion routine, the
+        // idle line notification, and DMA progress timer, we set the
+        // RxDma state to WAITING_FOR_DPC, to mark it as active.
         //
         IMX_UART_REGISTERS* registersPtr = interruptContextPtr->RegistersPtr;
 
         WdfInterruptAcquireLock(interruptContextPtr->WdfInterrupt);
-        interruptContextPtr->Ucr1Copy |=
-            (IMX_UART_UCR1_RXDMAEN | IMX_UART_UCR1_ATDMAEN);
+        if (isDirectTransfer) {
+            interruptContextPtr->Ucr1Copy &=
+                ~(IMX_UART_UCR1_RXDMAEN | IMX_UART_UCR1_ATDMAEN);
+        } else {
+            interruptContextPtr->Ucr1Copy |=
+                (IMX_UART_UCR1_RXDMAEN | IMX_UART_UCR1_ATDMAEN);
+        }
 
         WRITE_REGISTER_NOFENCE_ULONG(
             &registersPtr->Ucr1,
@@ -1415,7 +1717,29 @@ IMXUartEvtSerCx2CustomReceiveTransactionStart (
 
         bool isRequestCompleted = IMXUartRxDmaCopyToUserBuffer(
             rxDmaTransactionContextPtr,
-            0);
+            isDirectTransfer ?
+                IMXUartRxDmaGetBytesTransferred(rxDmaTransactionContextPtr) :
+                0);
+
+        if (isDirectTransfer) {
+            if (!isRequestCompleted) {
+                status = IMXUartRxDmaStartDirectTransfer(
+                    rxDmaTransactionContextPtr);
+
+                if (NT_SUCCESS(status)) {
+                    return;
+                }
+            }
+
+            //
+            // Direct transfer was not started, go on with
+            // the cyclic transfer.
+            //
+            IMXUartRxDmaResumeCyclicTransfer(rxDmaTransactionContextPtr);
+            if (status == STATUS_CANCELLED) {
+                return;
+            }
+        }
 
         if (isRequestCompleted) {
             IMXUartCompleteCustomRxTransactionRequest(
@@ -1426,9 +1750,10 @@ IMXUartEvtSerCx2CustomReceiveTransactionStart (
         }
 
         //
-        // If all is good, start the DMA progress monitor timer
-        // based on the transaction length.
+        // If all is good, progress is reported when the line goes idle,
+        // and the DMA progress monitor timer is started as a safety net.
         //
+        IMXUartRxDmaEnableIdleNotification(interruptContextPtr);
         IMXUartRxDmaStartProgressTimer(rxDmaTransactionContextPtr);
         return;
     } else {
@@ -1464,6 +1789,8 @@ IMXUartEvtSerCx2CustomReceiveTransactionCleanup (
     // UART setup requests.
     //
 
+    IMXUartRxDmaDisableIdleNotification(interruptContextPtr);
+
     WdfSpinLockAcquire(rxDmaTransactionContextPtr->Lock);
 
     WdfInterruptAcquireLock(interruptContextPtr->WdfInterrupt);
@@ -1489,6 +1816,27 @@ IMXUartEvtSerCx2CustomReceiveTransactionQueryProgress (
     IMX_UART_RX_DMA_TRANSACTION_CONTEXT* rxDmaTransactionContextPtr =
         IMXUartGetRxDmaTransactionContext(CustomReceiveTransaction);
 
+    //
+    // The direct transfer is not polled, sample its progress here.
+    //
+    WdfSpinLockAcquire(rxDmaTransactionContextPtr->Lock);
+    if (rxDmaTransactionContextPtr->IsDirectTransferActive &&
+        !rxDmaTransactionContextPtr->IsDeferredCancellation) {
+
+        size_t directBytes =
+            IMXUartRxDmaGetDirectBytesTransferred(rxDmaTransactionContextPtr);
+
+        if (directBytes > rxDmaTransactionContextPtr->DirectBytesTransferred) {
+            InterlockedAdd(
+                &rxDmaTransactionContextPtr->UnreportedBytes,
+                LONG(directBytes -
+                     rxDmaTransactionContextPtr->DirectBytesTransferred));
+
+            rxDmaTransactionContextPtr->DirectBytesTransferred = directBytes;
+        }
+    }
+    WdfSpinLockRelease(rxDmaTransactionContextPtr->Lock);
+
     SERCX2_CUSTOM_RECEIVE_TRANSACTION_PROGRESS transactionProgress;
     LONG unreportedBytes = InterlockedExchange(
         &rxDmaTransactionContextPtr->UnreportedBytes, 0);
@@ -1532,6 +1880,41 @@ IMXUartEvtCustomReceiveTransactionRequestCancel (
 
     WdfSpinLockAcquire(rxDmaTransactionContextPtr->Lock);
 
+    if (rxDmaTransactionContextPtr->IsDirectTransferActive) {
+        IMX_UART_REGISTERS* registersPtr = interruptContextPtr->RegistersPtr;
+
+        WdfInterruptAcquireLock(interruptContextPtr->WdfInterrupt);
+        interruptContextPtr->Ucr1Copy &= ~IMX_UART_UCR1_RXDMAEN;
+        WRITE_REGISTER_NOFENCE_ULONG(
+            &registersPtr->Ucr1,
+            interruptContextPtr->Ucr1Copy);
+
+        WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
+
+        rxDmaTransactionContextPtr->DirectBytesTransferred =
+            IMXUartRxDmaGetDirectBytesTransferred(rxDmaTransactionContextPtr);
+
+        IMX_UART_LOG_TRACE(
+            "Deferring custom receive cancellation, length %Iu, %Iu bytes "
+            "transferred, %Iu bytes transferred directly",
+            rxDmaTransactionContextPtr->TransferLength,
+            rxDmaTransactionContextPtr->BytesTransferred,
+            rxDmaTransactionContextPtr->DirectBytesTransferred);
+
+        rxDmaTransactionContextPtr->IsDeferredCancellation = true;
+        WdfSpinLockRelease(rxDmaTransactionContextPtr->Lock);
+
+        //
+        // Stop the direct DMA transaction, processing continues in
+        // the transaction completion routine
+        // IMXUartEvtWdfRxDirectDmaTransactionTransferComplete.
+        //
+        WdfDmaTransactionStopSystemTransfer(
+            rxDmaTransactionContextPtr->DirectWdfDmaTransaction);
+
+        return;
+    }
+
     WdfInterruptAcquireLock(interruptContextPtr->WdfInterrupt);
     if (interruptContextPtr->IsRxDmaStarted) {
         interruptContextPtr->RxDmaState = IMX_UART_STATE::STOPPING;
@@ -1600,9 +1983,13 @@ IMXUartEvtWdfRxDmaTransactionConfigureDmaChannel (
     }
 
     //
-    // Set notification threshold
+    // Set notification threshold. The HAL only accepts it before the
+    // channel is running, and it sets the SDMA buffer descriptor size,
+    // so keep it small for frequent completion notifications.
     //
-    ULONG notificationBytes = (ULONG)(rxDmaTransactionContextPtr->DmaBufferSize) / 4;
+    ULONG notificationBytes = min(
+        ULONG(IMX_UART_RX_DMA_NOTIFICATION_BYTES),
+        (ULONG)(rxDmaTransactionContextPtr->DmaBufferSize) / 4);
     status = dmaAdapterPtr->DmaOperations->ConfigureAdapterChannel(
         dmaAdapterPtr,
         SDMA_CFG_FUN_SET_CHANNEL_NOTIFICATION_THRESHOLD,
@@ -1668,8 +2055,14 @@ IMXUartEvtWdfProgramRxDma (
 
     rxDmaTransactionContextPtr->DmaBufferReadPos = 0;
     rxDmaTransactionContextPtr->DmaBufferPendingBytes = 0;
-    rxDmaTransactionContextPtr->BytesTransferred = 0;
     rxDmaTransactionContextPtr->LastDmaCounter = 0;
+
+    //
+    // BytesTransferred belongs to the custom receive transaction, it is
+    // reset when the transaction starts. The cyclic transfer is also
+    // reprogrammed while a transaction is in progress, on resume after
+    // a direct transfer.
+    //
     return TRUE;
 }
 
@@ -1685,30 +2078,110 @@ IMXUartEvtTimerRxDmaProgress (
     IMX_UART_RX_DMA_TRANSACTION_CONTEXT* rxDmaTransactionContextPtr =
         rxDmaTimerContextPtr->RxDmaTransactionPtr;
 
+    if (IMXUartRxDmaUpdateProgress(rxDmaTransactionContextPtr)) {
+        return;
+    }
+
+    IMXUartRxDmaStartProgressTimer(rxDmaTransactionContextPtr);
+}
+
+_Use_decl_annotations_
+bool
+IMXUartRxDmaUpdateProgress (
+    IMX_UART_RX_DMA_TRANSACTION_CONTEXT* RxDmaTransactionContextPtr
+    )
+{
+    //
+    // Pick up the bytes received since the last SDMA counter sample,
+    // and complete the request if it is satisfied.
+    //
     size_t bytesTransferred =
-        IMXUartRxDmaGetBytesTransferred(rxDmaTransactionContextPtr);
+        IMXUartRxDmaGetBytesTransferred(RxDmaTransactionContextPtr);
 
     bool isRequestCompleted = IMXUartRxDmaCopyToUserBuffer(
-        rxDmaTransactionContextPtr,
+        RxDmaTransactionContextPtr,
         bytesTransferred);
 
     if (bytesTransferred != 0) {
         IMX_UART_LOG_TRACE(
-            "RX DMA timer: Got %Iu bytes. %Iu out of %Iu transferred",
+            "RX DMA progress: Got %Iu bytes. %Iu out of %Iu transferred",
             bytesTransferred,
-            rxDmaTransactionContextPtr->BytesTransferred,
-            rxDmaTransactionContextPtr->TransferLength);
+            RxDmaTransactionContextPtr->BytesTransferred,
+            RxDmaTransactionContextPtr->TransferLength);
     }
 
     if (isRequestCompleted) {
         IMXUartCompleteCustomRxTransactionRequest(
-            rxDmaTransactionContextPtr,
+            RxDmaTransactionContextPtr,
             STATUS_SUCCESS);
+    }
 
-        return;
+    return isRequestCompleted;
+}
+
+_Use_decl_annotations_
+VOID
+IMXUartRxDmaEnableIdleNotification (
+    IMX_UART_INTERRUPT_CONTEXT* InterruptContextPtr
+    )
+{
+    //
+    // Enable the idle line interrupt (UCR1[IDEN]) after 4 idle frames,
+    // which is sooner than the 8 frame aging DMA request. AGTIM is also
+    // serviced by the ISR in case PIO receive left UCR2[ATEN] enabled.
+    //
+    IMX_UART_REGISTERS* registersPtr = InterruptContextPtr->RegistersPtr;
+
+    WdfInterruptAcquireLock(InterruptContextPtr->WdfInterrupt);
+    if (InterruptContextPtr->RxDmaIdleState ==
+        IMX_UART_STATE::STOPPED) {
+
+        InterruptContextPtr->RxDmaIdleState =
+            IMX_UART_STATE::WAITING_FOR_INTERRUPT;
+
+        WRITE_REGISTER_NOFENCE_ULONG(
+            &registersPtr->Usr2,
+            IMX_UART_USR2_IDLE);
+
+        InterruptContextPtr->Ucr1Copy &= ~IMX_UART_UCR1_ICD_MASK;
+        InterruptContextPtr->Ucr1Copy |=
+            (IMX_UART_UCR1_ICD_4 | IMX_UART_UCR1_IDEN);
+
+        InterruptContextPtr->Usr2EnabledInterruptsMask |= IMX_UART_USR2_IDLE;
+
+        WRITE_REGISTER_NOFENCE_ULONG(
+            &registersPtr->Ucr1,
+            InterruptContextPtr->Ucr1Copy);
     }
+    WdfInterruptReleaseLock(InterruptContextPtr->WdfInterrupt);
+}
 
-    IMXUartRxDmaStartProgressTimer(rxDmaTransactionContextPtr);
+_Use_decl_annotations_
+VOID
+IMXUartRxDmaDisableIdleNotification (
+    IMX_UART_INTERRUPT_CONTEXT* InterruptContextPtr
+    )
+{
+    IMX_UART_REGISTERS* registersPtr = InterruptContextPtr->RegistersPtr;
+
+    WdfInterruptAcquireLock(InterruptContextPtr->WdfInterrupt);
+    if (InterruptContextPtr->RxDmaIdleState !=
+        IMX_UART_STATE::STOPPED) {
+
+        InterruptContextPtr->RxDmaIdleState = IMX_UART_STATE::STOPPED;
+
+        InterruptContextPtr->Ucr1Copy &= ~IMX_UART_UCR1_IDEN;
+        InterruptContextPtr->Usr2EnabledInterruptsMask &= ~IMX_UART_USR2_IDLE;
+
+        WRITE_REGISTER_NOFENCE_ULONG(
+            &registersPtr->Ucr1,
+            InterruptContextPtr->Ucr1Copy);
+
+        WRITE_REGISTER_NOFENCE_ULONG(
+            &registersPtr->Usr2,
+            IMX_UART_USR2_IDLE);
+    }
+    WdfInterruptReleaseLock(InterruptContextPtr->WdfInterrupt);
 }
 
 _Use_decl_annotations_
@@ -1808,7 +2281,10 @@ IMXUartRxDmaStartProgressTimer (
     )
 {
     //
-    // Start the timer, based on the remaining bytes
+    // Start the timer, based on the remaining bytes.
+    // Progress is normally reported by SDMA buffer descriptor completions
+    // and the idle line interrupt, so the timer is only a safety net and
+    // is kept from firing at a high rate for short transactions.
     //
 
     size_t bytesLeftToTransfer = RxDmaTransactionContextPtr->TransferLength -
@@ -1817,6 +2293,10 @@ IMXUartRxDmaStartProgressTimer (
     ULONG progressTimerUsec = (ULONG)bytesLeftToTransfer *
         RxDmaTransactionContextPtr->CurrentFrameTimeUsec;
 
+    progressTimerUsec = max(
+        progressTimerUsec,
+        ULONG(IMX_UART_RX_DMA_PROGRESS_TIMER_MIN_USEC));
+
     WdfTimerStart(
         RxDmaTransactionContextPtr->WdfProgressTimer,
         WDF_REL_TIMEOUT_IN_US(progressTimerUsec));
@@ -2075,6 +2555,9 @@ IMXUartCompleteCustomRxTransactionRequest (
     NTSTATUS RequestStatus
     )
 {
+    IMXUartRxDmaDisableIdleNotification(
+        RxDmaTransactionContextPtr->InterruptContextPtr);
+
     WdfSpinLockAcquire(RxDmaTransactionContextPtr->Lock);
 
     WDFREQUEST wdfRequest = RxDmaTransactionContextPtr->WdfRequest;
@@ -2084,6 +2567,12 @@ IMXUartCompleteCustomRxTransactionRequest (
     }
     RxDmaTransactionContextPtr->WdfRequest = WDF_NO_HANDLE;
 
+    //
+    // Bytes picked up after completion stay in the intermediate buffer
+    // for the next transaction.
+    //
+    RxDmaTransactionContextPtr->BufferMdlPtr = nullptr;
+
     ULONG_PTR requestInfo = RxDmaTransactionContextPtr->BytesTransferred;
     NTSTATUS status = WdfRequestUnmarkCancelable(wdfRequest);
     if (NT_SUCCESS(status) || (status == STATUS_CANCELLED)) {
@@ -2100,293 +2589,233 @@ IMXUartCompleteCustomRxTransactionRequest (
 }
 
 _Use_decl_annotations_
-VOID
-IMXUartEvtSerCx2CustomTransmitTransactionStart (
-    SERCX2CUSTOMTRANSMITTRANSACTION CustomTransmitTransaction,
-    WDFREQUEST WdfRequest,
-    PMDL MdlPtr,
-    ULONG Offset,
-    ULONG Length
+NTSTATUS
+IMXUartRxDmaStartDirectTransfer (
+    IMX_UART_RX_DMA_TRANSACTION_CONTEXT* RxDmaTransactionContextPtr
     )
 {
-    IMX_UART_LOG_TRACE("Start custom transmit transaction, length %lu", Length);
+    IMX_UART_INTERRUPT_CONTEXT* interruptContextPtr =
+        RxDmaTransactionContextPtr->InterruptContextPtr;
 
-    IMX_UART_TX_DMA_TRANSACTION_CONTEXT* txDmaTransactionContextPtr =
-        IMXUartGetTxDmaTransactionContext(CustomTransmitTransaction);
+    //
+    // The aging DMA request is not used during the direct transfer, since
+    // it makes SDMA close the current buffer descriptor early.
+    // The direct transfer length is thus a multiple of the watermark level,
+    // and the residual tail is received through the intermediate buffer.
+    //
+    WdfInterruptAcquireLock(interruptContextPtr->WdfInterrupt);
+    ULONG watermarkLevel =
+        (interruptContextPtr->UfcrCopy & IMX_UART_UFCR_RXTL_MASK) >>
+        IMX_UART_UFCR_RXTL_SHIFT;
 
-    IMX_UART_INTERRUPT_CONTEXT* interruptContextPtr =
-        txDmaTransactionContextPtr->InterruptContextPtr;
+    WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
+    watermarkLevel = max(watermarkLevel, 1UL);
 
-    WDFDMATRANSACTION txWdfDmaTransaction = txDmaTransactionContextPtr->WdfDmaTransaction;
+    size_t bytesLeftToTransfer = RxDmaTransactionContextPtr->TransferLength -
+        RxDmaTransactionContextPtr->BytesTransferred;
 
-    NTSTATUS status = WdfDmaTransactionInitializeUsingOffset(
-        txWdfDmaTransaction,
-        IMXUartEvtWdfProgramTxDma,
-        WdfDmaDirectionWriteToDevice,
-        MdlPtr,
-        Offset,
-        Length);
+    size_t directLength = bytesLeftToTransfer -
+        (bytesLeftToTransfer % watermarkLevel);
+
+    if (directLength < RxDmaTransactionContextPtr->DirectMinTransactionLength) {
+        return STATUS_BUFFER_TOO_SMALL;
+    }
 
+    //
+    // Both transactions use the same SDMA channel, so the cyclic
+    // transaction needs to be stopped first. The intermediate buffer has
+    // already been drained while RX DMA requests were disabled.
+    //
+    NTSTATUS status = IMXUartStopRxDma(interruptContextPtr);
     if (!NT_SUCCESS(status)) {
         IMX_UART_LOG_ERROR(
-            "WdfDmaTransactionInitializeUsingOffset(...) failed. "
-            "(status = %!STATUS!)",
+            "IMXUartStopRxDma failed. (status = %!STATUS!)",
             status);
 
-        WdfRequestComplete(WdfRequest, status);
-        return;
+        return status;
     }
 
-    txDmaTransactionContextPtr->TransferLength = Length;
-    txDmaTransactionContextPtr->BytesTransferred = 0;
-    txDmaTransactionContextPtr->IsDeferredCancellation = false;
-    interruptContextPtr->TxDmaState = IMX_UART_STATE::IDLE;
-    interruptContextPtr->TxDmaDrainState = IMX_UART_STATE::IDLE;
+    WdfSpinLockAcquire(RxDmaTransactionContextPtr->Lock);
 
-    WdfDmaTransactionSetImmediateExecution(txWdfDmaTransaction, TRUE);
-    status = WdfDmaTransactionExecute(
-        txWdfDmaTransaction,
-        static_cast<WDFCONTEXT>(txDmaTransactionContextPtr));
+    //
+    // Request may have been canceled while the cyclic
+    // transaction was being stopped.
+    //
+    if (RxDmaTransactionContextPtr->WdfRequest == WDF_NO_HANDLE) {
+        WdfSpinLockRelease(RxDmaTransactionContextPtr->Lock);
+        return STATUS_CANCELLED;
+    }
+
+    WDFDMATRANSACTION wdfDmaTransaction =
+        RxDmaTransactionContextPtr->DirectWdfDmaTransaction;
+
+    status = WdfDmaTransactionInitializeUsingOffset(
+        wdfDmaTransaction,
+        IMXUartEvtWdfProgramRxDirectDma,
+        WdfDmaDirectionReadFromDevice,
+        RxDmaTransactionContextPtr->BufferMdlPtr,
+        ULONG(RxDmaTransactionContextPtr->BufferMdlOffset),
+        directLength);
 
     if (!NT_SUCCESS(status)) {
-        interruptContextPtr->TxDmaState = IMX_UART_STATE::STOPPED;
-        WdfDmaTransactionRelease(txWdfDmaTransaction);
+        WdfSpinLockRelease(RxDmaTransactionContextPtr->Lock);
         IMX_UART_LOG_ERROR(
-            "TX DMA: WdfDmaTransactionExecute Failed! (status = %!STATUS!)",
+            "WdfDmaTransactionInitializeUsingOffset(...) failed. "
+            "(status = %!STATUS!)",
             status);
 
-        WdfRequestComplete(WdfRequest, status);
-        return;
+        return status;
     }
 
-    WdfSpinLockAcquire(txDmaTransactionContextPtr->Lock);
-    txDmaTransactionContextPtr->WdfRequest = WdfRequest;
-    status = WdfRequestMarkCancelableEx(
-        WdfRequest,
-        IMXUartEvtCustomTransmitTransactionRequestCancel);
+    RxDmaTransactionContextPtr->DirectBytesTransferred = 0;
+    RxDmaTransactionContextPtr->IsDeferredCancellation = false;
+
+    WdfDmaTransactionSetImmediateExecution(wdfDmaTransaction, TRUE);
+    status = WdfDmaTransactionExecute(
+        wdfDmaTransaction,
+        static_cast<WDFCONTEXT>(RxDmaTransactionContextPtr));
 
     if (!NT_SUCCESS(status)) {
-        txDmaTransactionContextPtr->IsDeferredCancellation = true;
-        WdfSpinLockRelease(txDmaTransactionContextPtr->Lock);
-        //
-        // Cancellation continues in transaction completion routine.
-        //
-        WdfDmaTransactionStopSystemTransfer(
-            txDmaTransactionContextPtr->WdfDmaTransaction);
+        WdfDmaTransactionRelease(wdfDmaTransaction);
+        WdfSpinLockRelease(RxDmaTransactionContextPtr->Lock);
+        IMX_UART_LOG_ERROR(
+            "RX DMA: WdfDmaTransactionExecute for direct transfer failed! "
+            "(status = %!STATUS!)",
+            status);
 
-        return;
+        return status;
     }
 
+    RxDmaTransactionContextPtr->IsDirectTransferActive = true;
+
     //
-    // Enable TX DMA
+    // Enable RX DMA, without the Aging DMA timer
     //
     IMX_UART_REGISTERS* registersPtr = interruptContextPtr->RegistersPtr;
 
     WdfInterruptAcquireLock(interruptContextPtr->WdfInterrupt);
-    interruptContextPtr->Ucr1Copy |= IMX_UART_UCR1_TXDMAEN;
+    interruptContextPtr->Ucr1Copy |= IMX_UART_UCR1_RXDMAEN;
     WRITE_REGISTER_NOFENCE_ULONG(
         &registersPtr->Ucr1,
         interruptContextPtr->Ucr1Copy);
 
-    //
-    // DMA interrupt is handled by the framework, nevertheless we
-    // we use to mark an active TX DMA transfer.
-    //
-    interruptContextPtr->TxDmaState = IMX_UART_STATE::WAITING_FOR_DPC;
+    interruptContextPtr->RxDmaState = IMX_UART_STATE::WAITING_FOR_DPC;
     WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
-    WdfSpinLockRelease(txDmaTransactionContextPtr->Lock);
+    WdfSpinLockRelease(RxDmaTransactionContextPtr->Lock);
+
+    IMX_UART_LOG_TRACE(
+        "RX DMA: Started direct transfer of %Iu out of %Iu bytes",
+        directLength,
+        bytesLeftToTransfer);
+
+    return STATUS_SUCCESS;
 }
 
 _Use_decl_annotations_
-VOID
-IMXUartEvtSerCx2CustomTransmitTransactionCleanup (
-    SERCX2CUSTOMTRANSMITTRANSACTION CustomTransmitTransaction
+NTSTATUS
+IMXUartRxDmaResumeCyclicTransfer (
+    IMX_UART_RX_DMA_TRANSACTION_CONTEXT* RxDmaTransactionContextPtr
     )
 {
-    IMX_UART_TX_DMA_TRANSACTION_CONTEXT* txDmaTransactionContextPtr =
-        IMXUartGetTxDmaTransactionContext(CustomTransmitTransaction);
+    IMX_UART_INTERRUPT_CONTEXT* interruptContextPtr =
+        RxDmaTransactionContextPtr->InterruptContextPtr;
 
-    IMX_UART_LOG_TRACE(
-        "Cleaning up custom transmit transaction, length %Iu, %Iu bytes transferred",
-        txDmaTransactionContextPtr->TransferLength,
-        txDmaTransactionContextPtr->BytesTransferred);
+    NTSTATUS status = IMXUartStartRxDma(interruptContextPtr);
+    if (!NT_SUCCESS(status)) {
+        IMX_UART_LOG_ERROR(
+            "IMXUartStartRxDma failed. (status = %!STATUS!)",
+            status);
 
-    IMX_UART_INTERRUPT_CONTEXT* interruptContextPtr =
-        txDmaTransactionContextPtr->InterruptContextPtr;
+        return status;
+    }
 
     //
-    // Disable TX DMA
+    // Enable RX DMA and Aging DMA timer
     //
     IMX_UART_REGISTERS* registersPtr = interruptContextPtr->RegistersPtr;
 
     WdfInterruptAcquireLock(interruptContextPtr->WdfInterrupt);
-    interruptContextPtr->Ucr1Copy &= ~IMX_UART_UCR1_TXDMAEN;
+    interruptContextPtr->Ucr1Copy |=
+        (IMX_UART_UCR1_RXDMAEN | IMX_UART_UCR1_ATDMAEN);
+
     WRITE_REGISTER_NOFENCE_ULONG(
         &registersPtr->Ucr1,
         interruptContextPtr->Ucr1Copy);
 
-    interruptContextPtr->TxDmaState = IMX_UART_STATE::STOPPED;
-    interruptContextPtr->TxDmaDrainState = IMX_UART_STATE::STOPPED;
+    interruptContextPtr->RxDmaState = IMX_UART_STATE::WAITING_FOR_DPC;
     WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
-
-    SerCx2CustomTransmitTransactionCleanupComplete(CustomTransmitTransaction);
+    return STATUS_SUCCESS;
 }
 
 _Use_decl_annotations_
-VOID
-IMXUartEvtCustomTransmitTransactionRequestCancel (
-    WDFREQUEST WdfRequest
+size_t
+IMXUartRxDmaGetDirectBytesTransferred (
+    IMX_UART_RX_DMA_TRANSACTION_CONTEXT* RxDmaTransactionContextPtr
     )
 {
-    IMX_UART_DEVICE_CONTEXT* deviceContextPtr = IMXUartGetDeviceContext(
-        WdfIoQueueGetDevice(WdfRequestGetIoQueue(WdfRequest)));
+    //
+    // Bytes of previous transfers of the transaction, plus the progress
+    // of the current one. Caller holds the transaction lock.
+    //
+    WDFDMATRANSACTION wdfDmaTransaction =
+        RxDmaTransactionContextPtr->DirectWdfDmaTransaction;
 
-    IMX_UART_INTERRUPT_CONTEXT* interruptContextPtr =
-        deviceContextPtr->InterruptContextPtr;
+    size_t currentTransferLength =
+        WdfDmaTransactionGetCurrentDmaTransferLength(wdfDmaTransaction);
 
-    IMX_UART_TX_DMA_TRANSACTION_CONTEXT* txDmaTransactionContextPtr =
-        interruptContextPtr->TxDmaTransactionContextPtr;
+    size_t bytesLeft = min(
+        size_t(IMXUartDmaReadCounter(
+            RxDmaTransactionContextPtr->DirectDmaAdapterPtr)),
+        currentTransferLength);
 
-    WdfSpinLockAcquire(txDmaTransactionContextPtr->Lock);
+    return WdfDmaTransactionGetBytesTransferred(wdfDmaTransaction) +
+        currentTransferLength - bytesLeft;
+}
 
-    WDFREQUEST wdfRequest = txDmaTransactionContextPtr->WdfRequest;
-    if (wdfRequest == WDF_NO_HANDLE) {
-        WdfSpinLockRelease(txDmaTransactionContextPtr->Lock);
-        return;
-    }
+_Use_decl_annotations_
+BOOLEAN
+IMXUartEvtWdfRxDirectDmaTransactionConfigureDmaChannel (
+    WDFDMATRANSACTION /* WdfDmaTransaction */,
+    WDFDEVICE /* Device */,
+    PVOID ContextPtr,
+    PMDL /* MdlPtr */,
+    size_t /* Offset */,
+    size_t Length
+    )
+{
+    IMX_UART_RX_DMA_TRANSACTION_CONTEXT* rxDmaTransactionContextPtr =
+        static_cast<IMX_UART_RX_DMA_TRANSACTION_CONTEXT*>(ContextPtr);
 
-    //
-    // Disable TX DMA
-    //
-    IMX_UART_REGISTERS* registersPtr = interruptContextPtr->RegistersPtr;
+    const IMX_UART_INTERRUPT_CONTEXT* interruptContextPtr =
+        rxDmaTransactionContextPtr->InterruptContextPtr;
 
     WdfInterruptAcquireLock(interruptContextPtr->WdfInterrupt);
-    interruptContextPtr->Ucr1Copy &= ~IMX_UART_UCR1_TXDMAEN;
-    WRITE_REGISTER_NOFENCE_ULONG(
-        &registersPtr->Ucr1,
-        interruptContextPtr->Ucr1Copy);
+    ULONG watermarkLevel =
+        (interruptContextPtr->UfcrCopy & IMX_UART_UFCR_RXTL_MASK) >>
+        IMX_UART_UFCR_RXTL_SHIFT;
+
+    WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
+
+    IMX_UART_LOG_TRACE(
+        "RX DMA direct transfer configuration: WL %lu, length %Iu",
+        watermarkLevel,
+        Length);
 
     //
-    // Update the drain state if we can at this point.
-    // We DO NOT change the TxDmaState since until it is completed,
-    // so ISR uses the DMA path (vs PIO path).
-    // TxDma cancellation is marked by IsDeferredCancellation.
+    // Set the RX DMA watermark level. No notification threshold is
+    // needed, the transfer completes when the caller buffer is full.
     //
-    switch (interruptContextPtr->TxDmaDrainState) {
-    case IMX_UART_STATE::STOPPED:
-    case IMX_UART_STATE::CANCELLED:
-        NT_ASSERT(!"Unexpected state");
-        __fallthrough;
+    DMA_ADAPTER* dmaAdapterPtr = rxDmaTransactionContextPtr->DirectDmaAdapterPtr;
+    NTSTATUS status = dmaAdapterPtr->DmaOperations->ConfigureAdapterChannel(
+        dmaAdapterPtr,
+        SDMA_CFG_FUN_SET_CHANNEL_WATERMARK_LEVEL,
+        &watermarkLevel);
 
-    case IMX_UART_STATE::IDLE:
-    case IMX_UART_STATE::WAITING_FOR_INTERRUPT:
-
-        //
-        // Let the ISR disable the TXFE interrupt, since we don't know who
-        // else might be relying on the TXFE interrupt.
-        //
-        interruptContextPtr->TxDmaDrainState = IMX_UART_STATE::CANCELLED;
-        break;
-
-    case IMX_UART_STATE::WAITING_FOR_DPC:
-    case IMX_UART_STATE::COMPLETE:
-    default:
-        break;
-    }
-    WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
-
-    WDFDMATRANSACTION wdfDmaTransaction =
-        txDmaTransactionContextPtr->WdfDmaTransaction;
-
-    //
-    // Check if request was canceled before map registers were
-    // allocated. In this case complete the request locally since
-    // DMA callbacks will not be called for this transaction.
-    //
-    if (WdfDmaTransactionCancel(wdfDmaTransaction)) {
-        IMX_UART_LOG_TRACE(
-            "Canceling custom transmit inline, length %Iu",
-            txDmaTransactionContextPtr->TransferLength);
-
-        txDmaTransactionContextPtr->WdfRequest = WDF_NO_HANDLE;
-        WdfDmaTransactionRelease(wdfDmaTransaction);
-        WdfSpinLockRelease(txDmaTransactionContextPtr->Lock);
-        if (wdfRequest != WDF_NO_HANDLE) {
-            WdfRequestComplete(
-                wdfRequest,
-                STATUS_CANCELLED);
-        }
-        return;
-    }
-
-    //
-    // Update the number of bytes transferred.
-    // The number of bytes transferred is unreliable, since the
-    // DMA controller only updates the host upon completion of a buffer descriptor.
-    //
-    txDmaTransactionContextPtr->BytesTransferred =
-        (txDmaTransactionContextPtr->TransferLength -
-         IMXUartDmaReadCounter(txDmaTransactionContextPtr->DmaAdapterPtr));
-
-    IMX_UART_LOG_TRACE(
-        "Deferring custom transmit cancellation, length %Iu, %Iu bytes transferred",
-        txDmaTransactionContextPtr->TransferLength,
-        txDmaTransactionContextPtr->BytesTransferred);
-
-    txDmaTransactionContextPtr->IsDeferredCancellation = true;
-    WdfSpinLockRelease(txDmaTransactionContextPtr->Lock);
-
-    //
-    // Stop the DMA transaction, processing continues in
-    // the transaction completion routine
-    // IMXUartEvtWdfTxDmaTransactionTransferComplete.
-    //
-    WdfDmaTransactionStopSystemTransfer(wdfDmaTransaction);
-}
-
-_Use_decl_annotations_
-BOOLEAN
-IMXUartEvtWdfTxDmaTransactionConfigureDmaChannel (
-    WDFDMATRANSACTION /* WdfDmaTransaction */,
-    WDFDEVICE /* Device*/,
-    PVOID ContextPtr,
-    PMDL /* MdlPtr */,
-    size_t /* Offset */,
-    size_t Length
-    )
-{
-    IMX_UART_TX_DMA_TRANSACTION_CONTEXT* txDmaTransactionContextPtr =
-        static_cast<IMX_UART_TX_DMA_TRANSACTION_CONTEXT*>(ContextPtr);
-
-    const IMX_UART_INTERRUPT_CONTEXT* interruptContextPtr =
-        txDmaTransactionContextPtr->InterruptContextPtr;
-
-    WdfInterruptAcquireLock(interruptContextPtr->WdfInterrupt);
-    ULONG watermarkLevel = IMX_UART_FIFO_COUNT -
-        ((interruptContextPtr->UfcrCopy & IMX_UART_UFCR_TXTL_MASK) >>
-        IMX_UART_UFCR_TXTL_SHIFT);
-
-    WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
-
-    IMX_UART_LOG_TRACE(
-        "TX DMA transaction configuration: WL %lu, length %Iu",
-        watermarkLevel,
-        Length);
-
-    //
-    // Set the TX DMA watermark level
-    //
-    DMA_ADAPTER* dmaAdapterPtr = txDmaTransactionContextPtr->DmaAdapterPtr;
-    NTSTATUS status = dmaAdapterPtr->DmaOperations->ConfigureAdapterChannel(
-        dmaAdapterPtr,
-        SDMA_CFG_FUN_SET_CHANNEL_WATERMARK_LEVEL,
-        &watermarkLevel);
-
-    if (!NT_SUCCESS(status)) {
-        IMX_UART_LOG_ERROR(
-            "SDMA_CFG_FUN_SET_CHANNEL_WATERMARK_LEVEL failed "
-            "for TX DMA transaction. (status = %!STATUS!)",
-            status);
+    if (!NT_SUCCESS(status)) {
+        IMX_UART_LOG_ERROR(
+            "SDMA_CFG_FUN_SET_CHANNEL_WATERMARK_LEVEL failed "
+            "for RX DMA direct transfer. (status = %!STATUS!)",
+            status);
 
         return FALSE;
     }
@@ -2396,7 +2825,7 @@ IMXUartEvtWdfTxDmaTransactionConfigureDmaChannel (
 
 _Use_decl_annotations_
 BOOLEAN
-IMXUartEvtWdfProgramTxDma (
+IMXUartEvtWdfProgramRxDirectDma (
     WDFDMATRANSACTION /* WdfDmaTransaction */,
     WDFDEVICE /* Device */,
     WDFCONTEXT /* ContextPtr */,
@@ -2405,33 +2834,138 @@ IMXUartEvtWdfProgramTxDma (
     )
 {
     //
-    // Since we are using System DMA, WDF programs the SG list into the
-    // System DMA controller for us.
+    // Since we are using System DMA, WDF programs the SG list, which
+    // describes the caller buffer, into the System DMA controller for us.
     //
     return TRUE;
 }
 
 _Use_decl_annotations_
 VOID
-IMXUartEvtWdfTxDmaTransactionTransferComplete (
+IMXUartEvtWdfRxDirectDmaTransactionTransferComplete (
     WDFDMATRANSACTION /* WdfTransaction */,
-    WDFDEVICE /* WdfDevice*/,
+    WDFDEVICE /* WdfDevice */,
     WDFCONTEXT ContextPtr,
     WDF_DMA_DIRECTION /* Direction */,
     DMA_COMPLETION_STATUS DmaStatus
     )
 {
-    IMX_UART_TX_DMA_TRANSACTION_CONTEXT* txDmaTransactionContextPtr =
-        static_cast<IMX_UART_TX_DMA_TRANSACTION_CONTEXT*>(ContextPtr);
+    IMX_UART_RX_DMA_TRANSACTION_CONTEXT* rxDmaTransactionContextPtr =
+        static_cast<IMX_UART_RX_DMA_TRANSACTION_CONTEXT*>(ContextPtr);
+
+    IMX_UART_INTERRUPT_CONTEXT* interruptContextPtr =
+        rxDmaTransactionContextPtr->InterruptContextPtr;
 
     IMX_UART_LOG_TRACE(
-        "TX DMA: Transaction completed. (status = %!DMACOMPLETIONSTATUS!)",
+        "RX DMA: Direct transfer completed. (status = %!DMACOMPLETIONSTATUS!)",
         DmaStatus);
 
-    if (DmaStatus == DmaComplete) {
-        IMXUartTxDmaDrainFifo(txDmaTransactionContextPtr);
-        return;
+    WdfSpinLockAcquire(rxDmaTransactionContextPtr->Lock);
+
+    WDFDMATRANSACTION wdfDmaTransaction =
+        rxDmaTransactionContextPtr->DirectWdfDmaTransaction;
+
+    NTSTATUS dmaStatus;
+    if ((DmaStatus == DmaComplete) &&
+        !rxDmaTransactionContextPtr->IsDeferredCancellation) {
+
+        //
+        // Long transactions are split by the framework,
+        // in which case the next transfer is programmed.
+        //
+        if (!WdfDmaTransactionDmaCompleted(wdfDmaTransaction, &dmaStatus)) {
+            WdfSpinLockRelease(rxDmaTransactionContextPtr->Lock);
+            return;
+        }
     } else {
+        if (!rxDmaTransactionContextPtr->IsDeferredCancellation) {
+            rxDmaTransactionContextPtr->DirectBytesTransferred =
+                IMXUartRxDmaGetDirectBytesTransferred(rxDmaTransactionContextPtr);
+        }
+
+        WdfDmaTransactionDmaCompletedFinal(
+            wdfDmaTransaction,
+            rxDmaTransactionContextPtr->DirectBytesTransferred -
+                WdfDmaTransactionGetBytesTransferred(wdfDmaTransaction),
+            &dmaStatus);
+    }
+
+    size_t directBytes = WdfDmaTransactionGetBytesTransferred(wdfDmaTransaction);
+    WdfDmaTransactionRelease(wdfDmaTransaction);
+
+    //
+    // Advance the caller buffer position past the bytes received directly,
+    // the residual tail is copied from the intermediate buffer.
+    //
+    PMDL mdlPtr = rxDmaTransactionContextPtr->BufferMdlPtr;
+    size_t mdlOffset = rxDmaTransactionContextPtr->BufferMdlOffset;
+    size_t bytesToSkip = directBytes;
+
+    while (mdlPtr != nullptr) {
+        size_t mdlBytes = MmGetMdlByteCount(mdlPtr) - mdlOffset;
+        if (bytesToSkip <= mdlBytes) {
+            mdlOffset += bytesToSkip;
+            break;
+        }
+        bytesToSkip -= mdlBytes;
+        mdlPtr = mdlPtr->Next;
+        mdlOffset = 0;
+    }
+
+    rxDmaTransactionContextPtr->BufferMdlPtr = mdlPtr;
+    rxDmaTransactionContextPtr->BufferMdlOffset = mdlOffset;
+    rxDmaTransactionContextPtr->BytesTransferred += directBytes;
+    rxDmaTransactionContextPtr->IsDirectTransferActive = false;
+
+    if (directBytes > rxDmaTransactionContextPtr->DirectBytesTransferred) {
+        InterlockedAdd(
+            &rxDmaTransactionContextPtr->UnreportedBytes,
+            LONG(directBytes - rxDmaTransactionContextPtr->DirectBytesTransferred));
+    }
+    rxDmaTransactionContextPtr->DirectBytesTransferred = directBytes;
+
+    //
+    // On deferred cancellation the request is no longer cancelable,
+    // and we complete it here.
+    //
+    bool isDeferredCancellation =
+        rxDmaTransactionContextPtr->IsDeferredCancellation;
+
+    rxDmaTransactionContextPtr->IsDeferredCancellation = false;
+
+    WDFREQUEST wdfRequest = WDF_NO_HANDLE;
+    if (isDeferredCancellation) {
+        wdfRequest = rxDmaTransactionContextPtr->WdfRequest;
+        rxDmaTransactionContextPtr->WdfRequest = WDF_NO_HANDLE;
+        rxDmaTransactionContextPtr->BufferMdlPtr = nullptr;
+    }
+
+    ULONG_PTR requestInfo = rxDmaTransactionContextPtr->BytesTransferred;
+    bool isRequestCompleted = rxDmaTransactionContextPtr->BytesTransferred ==
+        rxDmaTransactionContextPtr->TransferLength;
+
+    WdfSpinLockRelease(rxDmaTransactionContextPtr->Lock);
+
+    ULONG waitEvents = 0;
+    if (directBytes != 0) {
+        waitEvents |= SERIAL_EV_RXCHAR;
+    }
+
+    //
+    // Resume the cyclic transfer before completing the request, so
+    // bytes that arrive between requests land in the intermediate buffer,
+    // and RX DMA state is settled before the transaction cleanup.
+    //
+    IMXUartRxDmaResumeCyclicTransfer(rxDmaTransactionContextPtr);
+
+    if (isDeferredCancellation) {
+        if (wdfRequest != WDF_NO_HANDLE) {
+            WdfRequestCompleteWithInformation(
+                wdfRequest,
+                STATUS_SUCCESS,
+                requestInfo);
+        }
+    } else if (DmaStatus != DmaComplete) {
         NTSTATUS requestStatus;
         switch (DmaStatus) {
         case DmaAborted:
@@ -2439,7 +2973,8 @@ IMXUartEvtWdfTxDmaTransactionTransferComplete (
             break;
 
         case DmaError:
-            requestStatus = STATUS_DATA_OVERRUN;
+            waitEvents |= SERIAL_EV_ERR;
+            requestStatus = IMXUartGetErrorInformation(interruptContextPtr);
             break;
 
         case DmaCancelled:
@@ -2450,1404 +2985,2382 @@ IMXUartEvtWdfTxDmaTransactionTransferComplete (
             break;
         }
 
-        IMXUartCompleteCustomTxTransactionRequest(
-            txDmaTransactionContextPtr,
+        if (requestInfo != 0) {
+            requestStatus = STATUS_SUCCESS;
+        }
+
+        IMXUartCompleteCustomRxTransactionRequest(
+            rxDmaTransactionContextPtr,
             requestStatus);
+
+    } else if (isRequestCompleted) {
+        IMXUartCompleteCustomRxTransactionRequest(
+            rxDmaTransactionContextPtr,
+            STATUS_SUCCESS);
+
+    } else {
+        //
+        // Residual tail is received through the intermediate buffer
+        //
+        IMXUartRxDmaEnableIdleNotification(interruptContextPtr);
+        IMXUartRxDmaStartProgressTimer(rxDmaTransactionContextPtr);
+    }
+
+    //
+    // Notify events if any...
+    //
+    if (waitEvents != 0) {
+        IMXUartNotifyEventsDuringDma(
+            rxDmaTransactionContextPtr,
+            waitEvents,
+            0);
     }
 }
 
 _Use_decl_annotations_
 VOID
-IMXUartTxDmaDrainFifo (
-    IMX_UART_TX_DMA_TRANSACTION_CONTEXT* TxDmaTransactionContextPtr
+IMXUartEvtSerCx2CustomTransmitTransactionStart (
+    SERCX2CUSTOMTRANSMITTRANSACTION CustomTransmitTransaction,
+    WDFREQUEST WdfRequest,
+    PMDL MdlPtr,
+    ULONG Offset,
+    ULONG Length
     )
 {
-    IMX_UART_INTERRUPT_CONTEXT* interruptContextPtr =
-        TxDmaTransactionContextPtr->InterruptContextPtr;
+    IMX_UART_LOG_TRACE("Start custom transmit transaction, length %lu", Length);
 
-    IMX_UART_REGISTERS* registersPtr = interruptContextPtr->RegistersPtr;
+    IMX_UART_TX_DMA_TRANSACTION_CONTEXT* txDmaTransactionContextPtr =
+        IMXUartGetTxDmaTransactionContext(CustomTransmitTransaction);
 
-    //
-    // Clear drain complete flag and enable TX FIFO empty interrupt
-    //
-    WdfInterruptAcquireLock(interruptContextPtr->WdfInterrupt);
-    if (interruptContextPtr->TxDmaDrainState == IMX_UART_STATE::CANCELLED) {
-        IMX_UART_LOG_TRACE("TX DMA: TX DMA request was already cancelled");
-        WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
-        return;
-    }
+    IMX_UART_INTERRUPT_CONTEXT* interruptContextPtr =
+        txDmaTransactionContextPtr->InterruptContextPtr;
 
-    //
-    // Can we complete the drain FIFO request synchronously?
-    //
-    ULONG usr2 = READ_REGISTER_NOFENCE_ULONG(&registersPtr->Usr2);
-    if ((usr2 & IMX_UART_USR2_TXFE) != 0) {
-        IMX_UART_LOG_TRACE(
-            "TX DMA: TX FIFO is empty, completing DrainFifo request inline. "
-            "(usr2 = 0x%lx)",
-            usr2);
+    WDFDMATRANSACTION txWdfDmaTransaction = txDmaTransactionContextPtr->WdfDmaTransaction;
 
-        interruptContextPtr->TxDmaDrainState = IMX_UART_STATE::COMPLETE;
-        WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
-        IMXUartCompleteCustomTxTransactionRequest(
-            TxDmaTransactionContextPtr,
-            STATUS_SUCCESS);
+    NTSTATUS status = WdfDmaTransactionInitializeUsingOffset(
+        txWdfDmaTransaction,
+        IMXUartEvtWdfProgramTxDma,
+        WdfDmaDirectionWriteToDevice,
+        MdlPtr,
+        Offset,
+        Length);
+
+    if (!NT_SUCCESS(status)) {
+        IMX_UART_LOG_ERROR(
+            "WdfDmaTransactionInitializeUsingOffset(...) failed. "
+            "(status = %!STATUS!)",
+            status);
 
+        WdfRequestComplete(WdfRequest, status);
         return;
     }
 
-    //
-    // Enable the TX Fifo Empty interrupt
-    //
-    interruptContextPtr->Ucr1Copy |= IMX_UART_UCR1_TXMPTYEN;
-    interruptContextPtr->Usr2EnabledInterruptsMask |= IMX_UART_USR2_TXFE;
-    WRITE_REGISTER_NOFENCE_ULONG(
-        &registersPtr->Ucr1,
-        interruptContextPtr->Ucr1Copy);
-
-    IMX_UART_LOG_TRACE(
-        "TX DMA: enabled TX FIFO empty interrupt to notify of drain "
-        "completion");
-
-    interruptContextPtr->TxDmaDrainState =
-        IMX_UART_STATE::WAITING_FOR_INTERRUPT;
-
-    WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
-}
-
-_Use_decl_annotations_
-VOID
-IMXUartCompleteCustomTxTransactionRequest (
-    IMX_UART_TX_DMA_TRANSACTION_CONTEXT* TxDmaTransactionContextPtr,
-    NTSTATUS RequestStatus
-    )
-{
-    WdfSpinLockAcquire(TxDmaTransactionContextPtr->Lock);
-
-    WDFREQUEST wdfRequest = TxDmaTransactionContextPtr->WdfRequest;
-    if (wdfRequest == WDF_NO_HANDLE) {
-        WdfSpinLockRelease(TxDmaTransactionContextPtr->Lock);
-        return;
-    }
-
-    WDFDMATRANSACTION wdfDmaTransaction =
-        TxDmaTransactionContextPtr->WdfDmaTransaction;
-
-    BOOLEAN isDone;
-    NTSTATUS dmaStatus;
-    if (!NT_SUCCESS(RequestStatus) ||
-        TxDmaTransactionContextPtr->IsDeferredCancellation) {
-
-        isDone = WdfDmaTransactionDmaCompletedFinal(
-            wdfDmaTransaction,
-            TxDmaTransactionContextPtr->BytesTransferred,
-            &dmaStatus);
+    txDmaTransactionContextPtr->TransferLength = Length;
+    txDmaTransactionContextPtr->BytesTransferred = 0;
+    txDmaTransactionContextPtr->IsDeferredCancellation = false;
+    interruptContextPtr->TxDmaState = IMX_UART_STATE::IDLE;
+    interruptContextPtr->TxDmaDrainState = IMX_UART_STATE::IDLE;
 
-        NT_ASSERT(isDone);
+    WdfDmaTransactionSetImmediateExecution(txWdfDmaTransaction, TRUE);
+    status = WdfDmaTransactionExecute(
+        txWdfDmaTransaction,
+        static_cast<WDFCONTEXT>(txDmaTransactionContextPtr));
 
-    } else {
-        isDone = WdfDmaTransactionDmaCompleted(wdfDmaTransaction, &dmaStatus);
-        TxDmaTransactionContextPtr->BytesTransferred =
-            WdfDmaTransactionGetBytesTransferred(wdfDmaTransaction);
-    }
+    if (!NT_SUCCESS(status)) {
+        interruptContextPtr->TxDmaState = IMX_UART_STATE::STOPPED;
+        WdfDmaTransactionRelease(txWdfDmaTransaction);
+        IMX_UART_LOG_ERROR(
+            "TX DMA: WdfDmaTransactionExecute Failed! (status = %!STATUS!)",
+            status);
 
-    if (!isDone) {
-        WdfSpinLockRelease(TxDmaTransactionContextPtr->Lock);
+        WdfRequestComplete(WdfRequest, status);
         return;
     }
 
-    TxDmaTransactionContextPtr->WdfRequest = WDF_NO_HANDLE;
-    WdfDmaTransactionRelease(wdfDmaTransaction);
-
-    //
-    // If request was canceled and few bytes were sent,
-    // fix the status so caller gets number of bytes sent.
-    //
-    if ((RequestStatus == STATUS_REQUEST_CANCELED) &&
-        (TxDmaTransactionContextPtr->BytesTransferred != 0)) {
-
-        RequestStatus = STATUS_SUCCESS;
-    }
-
-    ULONG_PTR requestInfo = TxDmaTransactionContextPtr->BytesTransferred;
-
-    if (TxDmaTransactionContextPtr->IsDeferredCancellation) {
-        WdfSpinLockRelease(TxDmaTransactionContextPtr->Lock);
-        WdfRequestCompleteWithInformation(
-            wdfRequest,
-            RequestStatus,
-            requestInfo);
-
-        return;
-    }
+    WdfSpinLockAcquire(txDmaTransactionContextPtr->Lock);
+    txDmaTransactionContextPtr->WdfRequest = WdfRequest;
+    status = WdfRequestMarkCancelableEx(
+        WdfRequest,
+        IMXUartEvtCustomTransmitTransactionRequestCancel);
 
-    NTSTATUS cancelStatus = WdfRequestUnmarkCancelable(wdfRequest);
-    if (NT_SUCCESS(cancelStatus) || (cancelStatus == STATUS_CANCELLED)) {
-        WdfSpinLockRelease(TxDmaTransactionContextPtr->Lock);
-        WdfRequestCompleteWithInformation(
-            wdfRequest,
-            RequestStatus,
-            requestInfo);
+    if (!NT_SUCCESS(status)) {
+        txDmaTransactionContextPtr->IsDeferredCancellation = true;
+        WdfSpinLockRelease(txDmaTransactionContextPtr->Lock);
+        //
+        // Cancellation continues in transaction completion routine.
+        //
+        WdfDmaTransactionStopSystemTransfer(
+            txDmaTransactionContextPtr->WdfDmaTransaction);
 
         return;
     }
 
-    WdfSpinLockRelease(TxDmaTransactionContextPtr->Lock);
-}
-
-_Use_decl_annotations_
-NTSTATUS
-IMXUartGetErrorInformation (
-    IMX_UART_INTERRUPT_CONTEXT* InterruptContextPtr
-    )
-{
-    IMX_UART_REGISTERS* registersPtr = InterruptContextPtr->RegistersPtr;
-
-    WdfInterruptAcquireLock(InterruptContextPtr->WdfInterrupt);
-
     //
-    // Read log and acknowledge errors that are not handled through
-    // interrupts.
+    // Enable TX DMA
     //
+    IMX_UART_REGISTERS* registersPtr = interruptContextPtr->RegistersPtr;
 
-    const ULONG usr1 = READ_REGISTER_NOFENCE_ULONG(&registersPtr->Usr1);
-    const ULONG usr2 = READ_REGISTER_NOFENCE_ULONG(&registersPtr->Usr2);
-
-    WRITE_REGISTER_NOFENCE_ULONG(
-        &registersPtr->Usr1,
-        usr1 & (IMX_UART_USR1_FRAMERR | IMX_UART_USR1_PARITYERR));
-
+    WdfInterruptAcquireLock(interruptContextPtr->WdfInterrupt);
+    interruptContextPtr->Ucr1Copy |= IMX_UART_UCR1_TXDMAEN;
     WRITE_REGISTER_NOFENCE_ULONG(
-        &registersPtr->Usr2,
-        usr2 & (IMX_UART_USR2_ORE | IMX_UART_USR2_BRCD));
-
-    NTSTATUS status = STATUS_UNSUCCESSFUL;
+        &registersPtr->Ucr1,
+        interruptContextPtr->Ucr1Copy);
 
     //
-    // The following error types are checked by ascending severity order,
-    // which is reflected in the return status code.
+    // DMA interrupt is handled by the framework, nevertheless we
+    // we use to mark an active TX DMA transfer.
     //
-
-    if ((usr1 & IMX_UART_USR1_FRAMERR) != 0) {
-        InterruptContextPtr->CommStatusErrors |= SERIAL_ERROR_FRAMING;
-        status = STATUS_BAD_DATA;
-    }
-
-    if ((usr1 & IMX_UART_USR1_PARITYERR) != 0) {
-        InterruptContextPtr->CommStatusErrors |= SERIAL_ERROR_PARITY;
-        status = STATUS_PARITY_ERROR;
-    }
-
-    if ((usr2 & IMX_UART_USR2_BRCD) != 0) {
-        InterruptContextPtr->CommStatusErrors |= SERIAL_ERROR_BREAK;
-        status = STATUS_REQUEST_ABORTED;
-    }
-
-    if ((usr2 & IMX_UART_USR2_ORE) != 0) {
-        InterruptContextPtr->CommStatusErrors |= SERIAL_ERROR_OVERRUN;
-        status = STATUS_DATA_OVERRUN;
-    }
-
-    IMX_UART_LOG_TRACE(
-        "DMA error: CommStatus: 0x%08X ",
-        InterruptContextPtr->CommStatusErrors);
-
-    WdfInterruptReleaseLock(InterruptContextPtr->WdfInterrupt);
-    return status;
+    interruptContextPtr->TxDmaState = IMX_UART_STATE::WAITING_FOR_DPC;
+    WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
+    WdfSpinLockRelease(txDmaTransactionContextPtr->Lock);
 }
 
 _Use_decl_annotations_
 VOID
-IMXUartNotifyEventsDuringDma (
-    IMX_UART_DMA_TRANSACTION_CONTEXT* DmaTransactionContextPtr,
-    const ULONG WaitEvents,
-    const ULONG CommStatusInfo
+IMXUartEvtSerCx2CustomTransmitTransactionCleanup (
+    SERCX2CUSTOMTRANSMITTRANSACTION CustomTransmitTransaction
     )
 {
+    IMX_UART_TX_DMA_TRANSACTION_CONTEXT* txDmaTransactionContextPtr =
+        IMXUartGetTxDmaTransactionContext(CustomTransmitTransaction);
+
+    IMX_UART_LOG_TRACE(
+        "Cleaning up custom transmit transaction, length %Iu, %Iu bytes transferred",
+        txDmaTransactionContextPtr->TransferLength,
+        txDmaTransactionContextPtr->BytesTransferred);
+
     IMX_UART_INTERRUPT_CONTEXT* interruptContextPtr =
-        DmaTransactionContextPtr->InterruptContextPtr;
+        txDmaTransactionContextPtr->InterruptContextPtr;
 
-    if (CommStatusInfo != 0) {
-        IMX_UART_LOG_TRACE("DMA events: CommStatus: 0x%08X ", CommStatusInfo);
-    }
+    //
+    // Disable TX DMA
+    //
+    IMX_UART_REGISTERS* registersPtr = interruptContextPtr->RegistersPtr;
 
     WdfInterruptAcquireLock(interruptContextPtr->WdfInterrupt);
-    ULONG waitEvents = WaitEvents & interruptContextPtr->WaitMask;
-    interruptContextPtr->WaitEvents &= ~waitEvents;
-    interruptContextPtr->CommStatusErrors |= CommStatusInfo;
+    interruptContextPtr->Ucr1Copy &= ~IMX_UART_UCR1_TXDMAEN;
+    WRITE_REGISTER_NOFENCE_ULONG(
+        &registersPtr->Ucr1,
+        interruptContextPtr->Ucr1Copy);
+
+    interruptContextPtr->TxDmaState = IMX_UART_STATE::STOPPED;
+    interruptContextPtr->TxDmaDrainState = IMX_UART_STATE::STOPPED;
     WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
-    if (waitEvents != 0) {
-        IMX_UART_LOG_TRACE("DMA: Completing wait. "
-            "(WaitEvents = 0x%lx, CommStatusInfo = 0x%lx)",
-            waitEvents,
-            CommStatusInfo);
 
-        SerCx2CompleteWait(DmaTransactionContextPtr->WdfDevice, waitEvents);
-    }
+    SerCx2CustomTransmitTransactionCleanupComplete(CustomTransmitTransaction);
 }
 
 _Use_decl_annotations_
 VOID
-IMXUartEvtSerCx2PurgeFifos (
-    WDFDEVICE WdfDevice,
-    BOOLEAN PurgeRxFifo,
-    BOOLEAN PurgeTxFifo
+IMXUartEvtCustomTransmitTransactionRequestCancel (
+    WDFREQUEST WdfRequest
     )
 {
-    IMX_UART_ASSERT_MAX_IRQL(PASSIVE_LEVEL);
-
-    IMX_UART_DEVICE_CONTEXT* deviceContextPtr =
-        IMXUartGetDeviceContext(WdfDevice);
+    IMX_UART_DEVICE_CONTEXT* deviceContextPtr = IMXUartGetDeviceContext(
+        WdfIoQueueGetDevice(WdfRequestGetIoQueue(WdfRequest)));
 
     IMX_UART_INTERRUPT_CONTEXT* interruptContextPtr =
         deviceContextPtr->InterruptContextPtr;
 
-    IMX_UART_REGISTERS* registersPtr = deviceContextPtr->RegistersPtr;
+    IMX_UART_TX_DMA_TRANSACTION_CONTEXT* txDmaTransactionContextPtr =
+        interruptContextPtr->TxDmaTransactionContextPtr;
+
+    WdfSpinLockAcquire(txDmaTransactionContextPtr->Lock);
+
+    WDFREQUEST wdfRequest = txDmaTransactionContextPtr->WdfRequest;
+    if (wdfRequest == WDF_NO_HANDLE) {
+        WdfSpinLockRelease(txDmaTransactionContextPtr->Lock);
+        return;
+    }
 
     //
-    // If DMA is being used, stop RX DMA to clear all pending
-    // bytes.
+    // Disable TX DMA
     //
-    if (PurgeRxFifo != FALSE) {
-        NTSTATUS status = IMXUartStopRxDma(interruptContextPtr);
-        if (!NT_SUCCESS(status)) {
-            IMX_UART_LOG_ERROR(
-                "IMXUartStopRxDma failed, (status = %!STATUS!)",
-                status);
-        }
-    }
+    IMX_UART_REGISTERS* registersPtr = interruptContextPtr->RegistersPtr;
 
     WdfInterruptAcquireLock(interruptContextPtr->WdfInterrupt);
+    interruptContextPtr->Ucr1Copy &= ~IMX_UART_UCR1_TXDMAEN;
+    WRITE_REGISTER_NOFENCE_ULONG(
+        &registersPtr->Ucr1,
+        interruptContextPtr->Ucr1Copy);
 
-    if (PurgeRxFifo != FALSE) {
-        //
-        // We assume that the FIFO is purged if the UART is off.
-        //
-        if ((interruptContextPtr->Ucr1Copy & IMX_UART_UCR1_UARTEN) != 0) {
-            ULONG rxd;
-            do {
-                rxd = READ_REGISTER_NOFENCE_ULONG(&registersPtr->Rxd);
-            } while ((rxd & IMX_UART_RXD_CHARRDY) != 0);
-        }
-
-        interruptContextPtr->RxBuffer.Reset();
-    }
+    //
+    // Update the drain state if we can at this point.
+    // We DO NOT change the TxDmaState since until it is completed,
+    // so ISR uses the DMA path (vs PIO path).
+    // TxDma cancellation is marked by IsDeferredCancellation.
+    //
+    switch (interruptContextPtr->TxDmaDrainState) {
+    case IMX_UART_STATE::STOPPED:
+    case IMX_UART_STATE::CANCELLED:
+        NT_ASSERT(!"Unexpected state");
+        __fallthrough;
 
-    if (PurgeTxFifo != FALSE) {
+    case IMX_UART_STATE::IDLE:
+    case IMX_UART_STATE::WAITING_FOR_INTERRUPT:
 
         //
-        // If transmit FIFO is not empty, reset the UART to clear the TX FIFO
+        // Let the ISR disable the TXFE interrupt, since we don't know who
+        // else might be relying on the TXFE interrupt.
         //
-        const ULONG usr2 = READ_REGISTER_NOFENCE_ULONG(&registersPtr->Usr2);
-        if ((usr2 & IMX_UART_USR2_TXFE) == 0) {
+        interruptContextPtr->TxDmaDrainState = IMX_UART_STATE::CANCELLED;
+        break;
 
-            //
-            // The transmit FIFO should only be nonempty if the UART is on.
-            //
-            NT_ASSERT((interruptContextPtr->Ucr1Copy & IMX_UART_UCR1_UARTEN) != 0);
+    case IMX_UART_STATE::WAITING_FOR_DPC:
+    case IMX_UART_STATE::COMPLETE:
+    default:
+        break;
+    }
+    WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
 
-            if (PurgeRxFifo == FALSE) {
-                IMX_UART_LOG_WARNING(
-                    "UART must be reset to purge TX FIFO which will also purge "
-                    "RX FIFO, however RxFifo purge was not requested.");
-            }
+    WDFDMATRANSACTION wdfDmaTransaction =
+        txDmaTransactionContextPtr->WdfDmaTransaction;
 
-            IMXUartResetHardwareAndPreserveShadowedRegisters(interruptContextPtr);
-            IMXUartRestoreHardwareFromShadowedRegisters(interruptContextPtr);
+    //
+    // Check if request was canceled before map registers were
+    // allocated. In this case complete the request locally since
+    // DMA callbacks will not be called for this transaction.
+    //
+    if (WdfDmaTransactionCancel(wdfDmaTransaction)) {
+        IMX_UART_LOG_TRACE(
+            "Canceling custom transmit inline, length %Iu",
+            txDmaTransactionContextPtr->TransferLength);
 
-            NT_ASSERT(
-                (READ_REGISTER_NOFENCE_ULONG(&registersPtr->Usr2) &
-                    IMX_UART_USR2_TXFE) != 0);
+        txDmaTransactionContextPtr->WdfRequest = WDF_NO_HANDLE;
+        WdfDmaTransactionRelease(wdfDmaTransaction);
+        WdfSpinLockRelease(txDmaTransactionContextPtr->Lock);
+        if (wdfRequest != WDF_NO_HANDLE) {
+            WdfRequestComplete(
+                wdfRequest,
+                STATUS_CANCELLED);
         }
-
-        interruptContextPtr->TxBuffer.Reset();
+        return;
     }
 
-    WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
+    //
+    // Update the number of bytes transferred.
+    // The number of bytes transferred is unreliable, since the
+    // DMA controller only updates the host upon completion of a buffer descriptor.
+    //
+    txDmaTransactionContextPtr->BytesTransferred =
+        (txDmaTransactionContextPtr->TransferLength -
+         IMXUartDmaReadCounter(txDmaTransactionContextPtr->DmaAdapterPtr));
 
     IMX_UART_LOG_TRACE(
-        "Purged FIFOs. (PurgeRxFifo = %d, PurgeTxFifo = %d)",
-        PurgeRxFifo,
-        PurgeTxFifo);
+        "Deferring custom transmit cancellation, length %Iu, %Iu bytes transferred",
+        txDmaTransactionContextPtr->TransferLength,
+        txDmaTransactionContextPtr->BytesTransferred);
+
+    txDmaTransactionContextPtr->IsDeferredCancellation = true;
+    WdfSpinLockRelease(txDmaTransactionContextPtr->Lock);
+
+    //
+    // Stop the DMA transaction, processing continues in
+    // the transaction completion routine
+    // IMXUartEvtWdfTxDmaTransactionTransferComplete.
+    //
+    WdfDmaTransactionStopSystemTransfer(wdfDmaTransaction);
 }
 
 _Use_decl_annotations_
-NTSTATUS IMXUartReadDeviceProperties (
-    WDFDEVICE WdfDevice,
-    IMX_UART_DEVICE_CONTEXT* DeviceContextPtr
+BOOLEAN
+IMXUartEvtWdfTxDmaTransactionConfigureDmaChannel (
+    WDFDMATRANSACTION /* WdfDmaTransaction */,
+    WDFDEVICE /* Device*/,
+    PVOID ContextPtr,
+    PMDL /* MdlPtr */,
+    size_t /* Offset */,
+    size_t Length
     )
 {
-    IMX_UART_ASSERT_MAX_IRQL(APC_LEVEL);
+    IMX_UART_TX_DMA_TRANSACTION_CONTEXT* txDmaTransactionContextPtr =
+        static_cast<IMX_UART_TX_DMA_TRANSACTION_CONTEXT*>(ContextPtr);
 
-    ACPI_EVAL_OUTPUT_BUFFER UNALIGNED* dsdBufferPtr = nullptr;
-    UINT32 dteMode = 0;
-    NTSTATUS status = 0;
+    const IMX_UART_INTERRUPT_CONTEXT* interruptContextPtr =
+        txDmaTransactionContextPtr->InterruptContextPtr;
 
-    //
-    // Default is DCE mode if dte-mode is not present or it is equal to 0
-    // DTE mode is optional if dte-mode is present and not equal to 0
-    //
-    DeviceContextPtr->DTEModeSelected = FALSE;
+    WdfInterruptAcquireLock(interruptContextPtr->WdfInterrupt);
+    ULONG watermarkLevel = IMX_UART_FIFO_COUNT -
+        ((interruptContextPtr->UfcrCopy & IMX_UART_UFCR_TXTL_MASK) >>
+        IMX_UART_UFCR_TXTL_SHIFT);
 
-    status = AcpiQueryDsd(WdfDeviceWdmGetPhysicalDevice(WdfDevice), &dsdBufferPtr);
-    if (!NT_SUCCESS(status)) {
-        return status;
-    }
+    WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
 
-    const ACPI_METHOD_ARGUMENT UNALIGNED* devicePropertiesPkgPtr;
-    status = AcpiParseDsdAsDeviceProperties(dsdBufferPtr, &devicePropertiesPkgPtr);
-    if (!NT_SUCCESS(status)) {
-        if (dsdBufferPtr != nullptr) {
-            ExFreePoolWithTag(dsdBufferPtr, ACPI_TAG_EVAL_OUTPUT_BUFFER);
-        }
+    IMX_UART_LOG_TRACE(
+        "TX DMA transaction configuration: WL %lu, length %Iu",
+        watermarkLevel,
+        Length);
 
-        return status;
-    }
+    //
+    // Set the TX DMA watermark level
+    //
+    DMA_ADAPTER* dmaAdapterPtr = txDmaTransactionContextPtr->DmaAdapterPtr;
+    NTSTATUS status = dmaAdapterPtr->DmaOperations->ConfigureAdapterChannel(
+        dmaAdapterPtr,
+        SDMA_CFG_FUN_SET_CHANNEL_WATERMARK_LEVEL,
+        &watermarkLevel);
 
-    status = AcpiDevicePropertiesQueryIntegerValue(
-        devicePropertiesPkgPtr,
-        "dte-mode",
-        &dteMode);
     if (!NT_SUCCESS(status)) {
-        IMX_UART_LOG_WARNING(
-            "dte-mode is not present. (status = %!STATUS!)",
+        IMX_UART_LOG_ERROR(
+            "SDMA_CFG_FUN_SET_CHANNEL_WATERMARK_LEVEL failed "
+            "for TX DMA transaction. (status = %!STATUS!)",
             status);
-    }
-    else {
-        DeviceContextPtr->DTEModeSelected = (dteMode != 0);
-    }
 
-    if (dsdBufferPtr != nullptr) {
-        ExFreePoolWithTag(dsdBufferPtr, ACPI_TAG_EVAL_OUTPUT_BUFFER);
+        return FALSE;
     }
 
-    return status;
+    return TRUE;
 }
 
 _Use_decl_annotations_
-NTSTATUS
-IMXUartEvtSerCx2ApplyConfig (
-    WDFDEVICE WdfDevice,
-    PVOID ConnectionParametersPtr
+BOOLEAN
+IMXUartEvtWdfProgramTxDma (
+    WDFDMATRANSACTION /* WdfDmaTransaction */,
+    WDFDEVICE /* Device */,
+    WDFCONTEXT /* ContextPtr */,
+    WDF_DMA_DIRECTION /* Direction */,
+    PSCATTER_GATHER_LIST /* SgListPtr */
     )
 {
-    IMX_UART_ASSERT_MAX_IRQL(PASSIVE_LEVEL);
-
-    ULONG baudRate;
-    SERIAL_LINE_CONTROL lineControl;
-    SERIAL_HANDFLOW handflow;
-    bool rtsCtsEnabled;
-    NTSTATUS status = IMXUartParseConnectionDescriptor(
-            static_cast<const RH_QUERY_CONNECTION_PROPERTIES_OUTPUT_BUFFER*>(ConnectionParametersPtr),
-            &baudRate,
-            &lineControl,
-            &handflow,
-            &rtsCtsEnabled);
-
-    if (!NT_SUCCESS(status)) {
-        IMX_UART_LOG_ERROR(
-            "Failed to parse connection descriptor. (status = %!STATUS!)",
-            status);
-
-        return status;
-    }
-
-    return IMXUartConfigureUart(
-            WdfDevice,
-            baudRate,
-            &lineControl,
-            &handflow,
-            rtsCtsEnabled);
+    //
+    // Since we are using System DMA, WDF programs the SG list into the
+    // System DMA controller for us.
+    //
+    return TRUE;
 }
 
 _Use_decl_annotations_
-NTSTATUS
-IMXUartConfigureUart (
-    WDFDEVICE WdfDevice,
-    ULONG BaudRate,
-    const SERIAL_LINE_CONTROL *LineControl,
-    const SERIAL_HANDFLOW *Handflow,
-    bool RtsCtsEnabled
+VOID
+IMXUartEvtWdfTxDmaTransactionTransferComplete (
+    WDFDMATRANSACTION /* WdfTransaction */,
+    WDFDEVICE /* WdfDevice*/,
+    WDFCONTEXT ContextPtr,
+    WDF_DMA_DIRECTION /* Direction */,
+    DMA_COMPLETION_STATUS DmaStatus
     )
 {
-    IMX_UART_ASSERT_MAX_IRQL(PASSIVE_LEVEL);
-
-    IMX_UART_DEVICE_CONTEXT* deviceContextPtr =
-            IMXUartGetDeviceContext(WdfDevice);
+    IMX_UART_TX_DMA_TRANSACTION_CONTEXT* txDmaTransactionContextPtr =
+        static_cast<IMX_UART_TX_DMA_TRANSACTION_CONTEXT*>(ContextPtr);
 
-    NTSTATUS status = IMXUartCheckValidStateForConfigIoctl(deviceContextPtr);
-    if (!NT_SUCCESS(status)) {
-        IMX_UART_LOG_ERROR(
-            "Configuration cannot be applied while IO is active. (status = %!STATUS!)",
-            status);
+    IMX_UART_LOG_TRACE(
+        "TX DMA: Transaction completed. (status = %!DMACOMPLETIONSTATUS!)",
+        DmaStatus);
 
-        return status;
-    }
+    if (DmaStatus == DmaComplete) {
+        IMXUartTxDmaDrainFifo(txDmaTransactionContextPtr);
+        return;
+    } else {
+        NTSTATUS requestStatus;
+        switch (DmaStatus) {
+        case DmaAborted:
+            requestStatus = STATUS_REQUEST_ABORTED;
+            break;
 
-    IMX_UART_INTERRUPT_CONTEXT* interruptContextPtr =
-            deviceContextPtr->InterruptContextPtr;
-
-    IMX_UART_REGISTERS* registersPtr = deviceContextPtr->RegistersPtr;
+        case DmaError:
+            requestStatus = STATUS_DATA_OVERRUN;
+            break;
 
-    deviceContextPtr->RtsCtsLinesEnabled = RtsCtsEnabled;
+        case DmaCancelled:
+            __fallthrough;
 
-    if (deviceContextPtr->Initialized) {
-        WdfInterruptAcquireLock(interruptContextPtr->WdfInterrupt);
-        status = IMXUartResetHardwareAndClearShadowedRegisters(
-                interruptContextPtr);
+        default:
+            requestStatus = STATUS_REQUEST_CANCELED;
+            break;
+        }
 
-        WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
+        IMXUartCompleteCustomTxTransactionRequest(
+            txDmaTransactionContextPtr,
+            requestStatus);
+    }
+}
 
-        if (!NT_SUCCESS(status)) {
-            IMX_UART_LOG_ERROR(
-                "Failed to reset hardware. (status = %!STATUS!)",
-                status);
+_Use_decl_annotations_
+VOID
+IMXUartTxDmaDrainFifo (
+    IMX_UART_TX_DMA_TRANSACTION_CONTEXT* TxDmaTransactionContextPtr
+    )
+{
+    IMX_UART_INTERRUPT_CONTEXT* interruptContextPtr =
+        TxDmaTransactionContextPtr->InterruptContextPtr;
 
-            return status;
-        }
-    }
+    IMX_UART_REGISTERS* registersPtr = interruptContextPtr->RegistersPtr;
 
     //
-    // Set up UCR2-UCR4
+    // Clear drain complete flag and enable TX FIFO empty interrupt
     //
-    {
-        WdfInterruptAcquireLock(interruptContextPtr->WdfInterrupt);
-        interruptContextPtr->Ucr2Copy =
-            IMX_UART_UCR2_CTS |          // RTS asserted
-            IMX_UART_UCR2_IRTS |         // CTS ignored
-            IMX_UART_UCR2_TXEN |         // Enable transmitter
-            IMX_UART_UCR2_RXEN |         // Enable receiver
-            IMX_UART_UCR2_SRST;          // Do not reset
-
-        interruptContextPtr->Ucr3Copy =
-            IMX_UART_UCR3_DSR |          // assert DSR
-            IMX_UART_UCR3_RXDMUXSEL;
-
-        WRITE_REGISTER_NOFENCE_ULONG(
-            &registersPtr->Ucr3,
-            interruptContextPtr->Ucr3Copy);
-
-        //
-        // Set RTS trigger level
-        //
-        const ULONG rtsTriggerLevel = min(
-            IMX_UART_FIFO_COUNT,
-            deviceContextPtr->Parameters.RtsTriggerLevel);
-
-        interruptContextPtr->Ucr4Copy =
-            (rtsTriggerLevel << IMX_UART_UCR4_CTSTL_SHIFT);
-
-        WRITE_REGISTER_NOFENCE_ULONG(
-            &registersPtr->Ucr4,
-            interruptContextPtr->Ucr4Copy);
-
+    WdfInterruptAcquireLock(interruptContextPtr->WdfInterrupt);
+    if (interruptContextPtr->TxDmaDrainState == IMX_UART_STATE::CANCELLED) {
+        IMX_UART_LOG_TRACE("TX DMA: TX DMA request was already cancelled");
         WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
+        return;
     }
 
-    status = IMXUartSetBaudRate(deviceContextPtr, BaudRate);
-    if (!NT_SUCCESS(status)) {
-        IMX_UART_LOG_ERROR(
-            "Failed to set baud rate. (status = %!STATUS!, baudRate = %lu)",
-            status,
-            BaudRate);
-
-        return status;
-    }
-
-    status = IMXUartSetLineControl(deviceContextPtr, LineControl);
-    if (!NT_SUCCESS(status)) {
-        IMX_UART_LOG_ERROR(
-            "Failed to set line control. (status = %!STATUS!)",
-            status);
-
-        return status;
-    }
+    //
+    // Can we complete the drain FIFO request synchronously?
+    //
+    ULONG usr2 = READ_REGISTER_NOFENCE_ULONG(&registersPtr->Usr2);
+    if ((usr2 & IMX_UART_USR2_TXFE) != 0) {
+        IMX_UART_LOG_TRACE(
+            "TX DMA: TX FIFO is empty, completing DrainFifo request inline. "
+            "(usr2 = 0x%lx)",
+            usr2);
 
-    status = IMXUartSetHandflow(deviceContextPtr, Handflow);
-    if (!NT_SUCCESS(status)) {
-        IMX_UART_LOG_ERROR(
-            "Failed to set handflow. (status = %!STATUS!)",
-            status);
+        interruptContextPtr->TxDmaDrainState = IMX_UART_STATE::COMPLETE;
+        WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
+        IMXUartCompleteCustomTxTransactionRequest(
+            TxDmaTransactionContextPtr,
+            STATUS_SUCCESS);
 
-        return status;
+        return;
     }
 
     //
-    // Read Device Properties - check if dte-mode is present.
-    //
-    status = IMXUartReadDeviceProperties(WdfDevice, deviceContextPtr);
-
-    //
-    // Enable the UART
+    // Enable the TX Fifo Empty interrupt
     //
-    {
-        WdfInterruptAcquireLock(interruptContextPtr->WdfInterrupt);
+    interruptContextPtr->Ucr1Copy |= IMX_UART_UCR1_TXMPTYEN;
+    interruptContextPtr->Usr2EnabledInterruptsMask |= IMX_UART_USR2_TXFE;
+    WRITE_REGISTER_NOFENCE_ULONG(
+        &registersPtr->Ucr1,
+        interruptContextPtr->Ucr1Copy);
 
-        interruptContextPtr->Ucr1Copy |= IMX_UART_UCR1_UARTEN;
-        WRITE_REGISTER_NOFENCE_ULONG(
-            &registersPtr->Ucr1,
-            interruptContextPtr->Ucr1Copy);
+    IMX_UART_LOG_TRACE(
+        "TX DMA: enabled TX FIFO empty interrupt to notify of drain "
+        "completion");
 
-        WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
-    }
+    interruptContextPtr->TxDmaDrainState =
+        IMX_UART_STATE::WAITING_FOR_INTERRUPT;
 
-    deviceContextPtr->Initialized = true;
-    return STATUS_SUCCESS;
+    WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
 }
 
-//
-// UART configuration changes (Baud, Handflow, etc.) are only allowed before
-// the first read or write IRP is sent. Changing line configuration while
-// data transmission is in progress could have unpredictable effects.
-//
-NTSTATUS
-IMXUartCheckValidStateForConfigIoctl (
-    const IMX_UART_DEVICE_CONTEXT* DeviceContextPtr
+_Use_decl_annotations_
+VOID
+IMXUartCompleteCustomTxTransactionRequest (
+    IMX_UART_TX_DMA_TRANSACTION_CONTEXT* TxDmaTransactionContextPtr,
+    NTSTATUS RequestStatus
     )
 {
-    const IMX_UART_INTERRUPT_CONTEXT* interruptContextPtr =
-            DeviceContextPtr->InterruptContextPtr;
+    WdfSpinLockAcquire(TxDmaTransactionContextPtr->Lock);
 
-    switch (interruptContextPtr->RxState) {
-    case IMX_UART_STATE::WAITING_FOR_INTERRUPT:
-    case IMX_UART_STATE::WAITING_FOR_DPC:
-        return STATUS_INVALID_DEVICE_STATE;
+    WDFREQUEST wdfRequest = TxDmaTransactionContextPtr->WdfRequest;
+    if (wdfRequest == WDF_NO_HANDLE) {
+        WdfSpinLockRelease(TxDmaTransactionContextPtr->Lock);
+        return;
     }
 
-    switch (interruptContextPtr->RxDmaState) {
-    case IMX_UART_STATE::WAITING_FOR_DPC:
-        return STATUS_INVALID_DEVICE_STATE;
-    }
+    WDFDMATRANSACTION wdfDmaTransaction =
+        TxDmaTransactionContextPtr->WdfDmaTransaction;
 
-    switch (interruptContextPtr->TxState) {
-    case IMX_UART_STATE::WAITING_FOR_INTERRUPT:
-    case IMX_UART_STATE::WAITING_FOR_DPC:
-        return STATUS_INVALID_DEVICE_STATE;
+    BOOLEAN isDone;
+    NTSTATUS dmaStatus;
+    if (!NT_SUCCESS(RequestStatus) ||
+        TxDmaTransactionContextPtr->IsDeferredCancellation) {
+
+        isDone = WdfDmaTransactionDmaCompletedFinal(
+            wdfDmaTransaction,
+            TxDmaTransactionContextPtr->BytesTransferred,
+            &dmaStatus);
+
+        NT_ASSERT(isDone);
+
+    } else {
+        isDone = WdfDmaTransactionDmaCompleted(wdfDmaTransaction, &dmaStatus);
+        TxDmaTransactionContextPtr->BytesTransferred =
+            WdfDmaTransactionGetBytesTransferred(wdfDmaTransaction);
     }
 
-    switch (interruptContextPtr->TxDrainState) {
-    case IMX_UART_STATE::WAITING_FOR_INTERRUPT:
-    case IMX_UART_STATE::WAITING_FOR_DPC:
-        return STATUS_INVALID_DEVICE_STATE;
+    if (!isDone) {
+        WdfSpinLockRelease(TxDmaTransactionContextPtr->Lock);
+        return;
     }
 
-    switch (interruptContextPtr->TxPurgeState) {
-    case IMX_UART_STATE::WAITING_FOR_INTERRUPT:
-    case IMX_UART_STATE::WAITING_FOR_DPC:
-        return STATUS_INVALID_DEVICE_STATE;
+    TxDmaTransactionContextPtr->WdfRequest = WDF_NO_HANDLE;
+    WdfDmaTransactionRelease(wdfDmaTransaction);
+
+    //
+    // If request was canceled and few bytes were sent,
+    // fix the status so caller gets number of bytes sent.
+    //
+    if ((RequestStatus == STATUS_REQUEST_CANCELED) &&
+        (TxDmaTransactionContextPtr->BytesTransferred != 0)) {
+
+        RequestStatus = STATUS_SUCCESS;
     }
 
-    switch (interruptContextPtr->TxDmaState) {
-    case IMX_UART_STATE::WAITING_FOR_DPC:
-        return STATUS_INVALID_DEVICE_STATE;
+    ULONG_PTR requestInfo = TxDmaTransactionContextPtr->BytesTransferred;
+
+    if (TxDmaTransactionContextPtr->IsDeferredCancellation) {
+        WdfSpinLockRelease(TxDmaTransactionContextPtr->Lock);
+        WdfRequestCompleteWithInformation(
+            wdfRequest,
+            RequestStatus,
+            requestInfo);
+
+        return;
     }
 
-    switch (interruptContextPtr->TxDmaDrainState) {
-    case IMX_UART_STATE::WAITING_FOR_INTERRUPT:
-    case IMX_UART_STATE::WAITING_FOR_DPC:
-        return STATUS_INVALID_DEVICE_STATE;
+    NTSTATUS cancelStatus = WdfRequestUnmarkCancelable(wdfRequest);
+    if (NT_SUCCESS(cancelStatus) || (cancelStatus == STATUS_CANCELLED)) {
+        WdfSpinLockRelease(TxDmaTransactionContextPtr->Lock);
+        WdfRequestCompleteWithInformation(
+            wdfRequest,
+            RequestStatus,
+            requestInfo);
+
+        return;
     }
 
-    return STATUS_SUCCESS;
+    WdfSpinLockRelease(TxDmaTransactionContextPtr->Lock);
 }
 
-//
-// Follow procedure in datasheet section 64.10.2 to reset hardware.
-//
+_Use_decl_annotations_
 NTSTATUS
-IMXUartResetHardwareAndPreserveShadowedRegisters (
-    const IMX_UART_INTERRUPT_CONTEXT* InterruptContextPtr
+IMXUartGetErrorInformation (
+    IMX_UART_INTERRUPT_CONTEXT* InterruptContextPtr
     )
 {
     IMX_UART_REGISTERS* registersPtr = InterruptContextPtr->RegistersPtr;
 
+    WdfInterruptAcquireLock(InterruptContextPtr->WdfInterrupt);
+
     //
-    // Disable UART and reset control registers
+    // Read log and acknowledge errors that are not handled through
+    // interrupts.
     //
-    WRITE_REGISTER_NOFENCE_ULONG(&registersPtr->Ucr1, 0);
-    WRITE_REGISTER_NOFENCE_ULONG(&registersPtr->Ucr3, 0);
-    WRITE_REGISTER_NOFENCE_ULONG(&registersPtr->Ucr4, 0);
-    WRITE_REGISTER_NOFENCE_ULONG(&registersPtr->Umcr, 0);
 
-    //
-    // Initiate reset by clearing IMX_UART_UCR2_SRST bit
-    //
-    WRITE_REGISTER_NOFENCE_ULONG(&registersPtr->Ucr2, 0);
+    const ULONG usr1 = READ_REGISTER_NOFENCE_ULONG(&registersPtr->Usr1);
+    const ULONG usr2 = READ_REGISTER_NOFENCE_ULONG(&registersPtr->Usr2);
+
+    WRITE_REGISTER_NOFENCE_ULONG(
+        &registersPtr->Usr1,
+        usr1 & (IMX_UART_USR1_FRAMERR | IMX_UART_USR1_PARITYERR));
+
+    WRITE_REGISTER_NOFENCE_ULONG(
+        &registersPtr->Usr2,
+        usr2 & (IMX_UART_USR2_ORE | IMX_UART_USR2_BRCD));
+
+    NTSTATUS status = STATUS_UNSUCCESSFUL;
 
     //
-    // Wait for SOFTRST bit to deassert
+    // The following error types are checked by ascending severity order,
+    // which is reflected in the return status code.
     //
-    ULONG uts;
-    int i;
-    for (i = 1000; i != 0; --i) {
-        KeStallExecutionProcessor(1);
-        uts = READ_REGISTER_NOFENCE_ULONG(&registersPtr->Uts);
-        if ((uts & IMX_UART_UTS_SOFTRST) == 0) {
-            return STATUS_SUCCESS;
-        }
+
+    if ((usr1 & IMX_UART_USR1_FRAMERR) != 0) {
+        InterruptContextPtr->CommStatusErrors |= SERIAL_ERROR_FRAMING;
+        status = STATUS_BAD_DATA;
     }
 
-    IMX_UART_LOG_ERROR(
-        "Timed out waiting for SOFTRST bit to clear. (uts = 0x%lx)",
-        uts);
+    if ((usr1 & IMX_UART_USR1_PARITYERR) != 0) {
+        InterruptContextPtr->CommStatusErrors |= SERIAL_ERROR_PARITY;
+        status = STATUS_PARITY_ERROR;
+    }
 
-    NT_ASSERT(FALSE);
-    return STATUS_IO_TIMEOUT;
+    if ((usr2 & IMX_UART_USR2_BRCD) != 0) {
+        InterruptContextPtr->CommStatusErrors |= SERIAL_ERROR_BREAK;
+        status = STATUS_REQUEST_ABORTED;
+    }
+
+    if ((usr2 & IMX_UART_USR2_ORE) != 0) {
+        InterruptContextPtr->CommStatusErrors |= SERIAL_ERROR_OVERRUN;
+        status = STATUS_DATA_OVERRUN;
+    }
+
+    IMX_UART_LOG_TRACE(
+        "DMA error: CommStatus: 0x%08X ",
+        InterruptContextPtr->CommStatusErrors);
+
+    WdfInterruptReleaseLock(InterruptContextPtr->WdfInterrupt);
+    return status;
 }
 
-NTSTATUS
-IMXUartResetHardwareAndClearShadowedRegisters (
-    IMX_UART_INTERRUPT_CONTEXT* InterruptContextPtr
+_Use_decl_annotations_
+VOID
+IMXUartNotifyEventsDuringDma (
+    IMX_UART_DMA_TRANSACTION_CONTEXT* DmaTransactionContextPtr,
+    const ULONG WaitEvents,
+    const ULONG CommStatusInfo
     )
 {
-    NTSTATUS status = IMXUartResetHardwareAndPreserveShadowedRegisters(
-            InterruptContextPtr);
+    IMX_UART_INTERRUPT_CONTEXT* interruptContextPtr =
+        DmaTransactionContextPtr->InterruptContextPtr;
 
-    InterruptContextPtr->Ucr1Copy = 0;
-    InterruptContextPtr->Ucr2Copy = IMX_UART_UCR2_SRST;
-    InterruptContextPtr->Ucr3Copy = 0;
-    InterruptContextPtr->Ucr4Copy = 0;
-    InterruptContextPtr->UbirCopy = 0;
-    InterruptContextPtr->UbmrCopy = 0;
-    InterruptContextPtr->UfcrCopy = 0;
+    if (CommStatusInfo != 0) {
+        IMX_UART_LOG_TRACE("DMA events: CommStatus: 0x%08X ", CommStatusInfo);
+    }
 
-    return status;
+    WdfInterruptAcquireLock(interruptContextPtr->WdfInterrupt);
+    ULONG waitEvents = WaitEvents & interruptContextPtr->WaitMask;
+    interruptContextPtr->WaitEvents &= ~waitEvents;
+    interruptContextPtr->CommStatusErrors |= CommStatusInfo;
+    WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
+    if (waitEvents != 0) {
+        IMX_UART_LOG_TRACE("DMA: Completing wait. "
+            "(WaitEvents = 0x%lx, CommStatusInfo = 0x%lx)",
+            waitEvents,
+            CommStatusInfo);
+
+        SerCx2CompleteWait(DmaTransactionContextPtr->WdfDevice, waitEvents);
+    }
 }
 
-void
-IMXUartRestoreHardwareFromShadowedRegisters (
-    const IMX_UART_INTERRUPT_CONTEXT* InterruptContextPtr
+_Use_decl_annotations_
+VOID
+IMXUartEvtSerCx2PurgeFifos (
+    WDFDEVICE WdfDevice,
+    BOOLEAN PurgeRxFifo,
+    BOOLEAN PurgeTxFifo
     )
 {
-    IMX_UART_REGISTERS* registersPtr = InterruptContextPtr->RegistersPtr;
+    IMX_UART_ASSERT_MAX_IRQL(PASSIVE_LEVEL);
+
+    IMX_UART_DEVICE_CONTEXT* deviceContextPtr =
+        IMXUartGetDeviceContext(WdfDevice);
+
+    IMX_UART_INTERRUPT_CONTEXT* interruptContextPtr =
+        deviceContextPtr->InterruptContextPtr;
+
+    IMX_UART_REGISTERS* registersPtr = deviceContextPtr->RegistersPtr;
 
     //
-    // Precondition: UART should be disabled
+    // If DMA is being used, stop RX DMA to clear all pending
+    // bytes.
     //
-    NT_ASSERT(
-        (READ_REGISTER_NOFENCE_ULONG(&registersPtr->Ucr1) &
-        IMX_UART_UCR1_UARTEN) == 0);
+    if (PurgeRxFifo != FALSE) {
+        NTSTATUS status = IMXUartStopRxDma(interruptContextPtr);
+        if (!NT_SUCCESS(status)) {
+            IMX_UART_LOG_ERROR(
+                "IMXUartStopRxDma failed, (status = %!STATUS!)",
+                status);
+        }
+    }
 
-    WRITE_REGISTER_NOFENCE_ULONG(
-        &registersPtr->Ucr2,
-        InterruptContextPtr->Ucr2Copy);
+    WdfInterruptAcquireLock(interruptContextPtr->WdfInterrupt);
 
-    WRITE_REGISTER_NOFENCE_ULONG(
-        &registersPtr->Ucr3,
-        InterruptContextPtr->Ucr3Copy);
+    if (PurgeRxFifo != FALSE) {
+        //
+        // We assume that the FIFO is purged if the UART is off.
+        //
+        if ((interruptContextPtr->Ucr1Copy & IMX_UART_UCR1_UARTEN) != 0) {
+            ULONG rxd;
+            do {
+                rxd = READ_REGISTER_NOFENCE_ULONG(&registersPtr->Rxd);
+            } while ((rxd & IMX_UART_RXD_CHARRDY) != 0);
+        }
 
-    WRITE_REGISTER_NOFENCE_ULONG(
-        &registersPtr->Ucr4,
-        InterruptContextPtr->Ucr4Copy);
+        interruptContextPtr->RxBuffer.Reset();
+    }
 
-    WRITE_REGISTER_NOFENCE_ULONG(
-        &registersPtr->Ufcr,
-        InterruptContextPtr->UfcrCopy);
+    if (PurgeTxFifo != FALSE) {
 
-    WRITE_REGISTER_NOFENCE_ULONG(
-        &registersPtr->Ubir,
-        InterruptContextPtr->UbirCopy);
+        //
+        // If transmit FIFO is not empty, reset the UART to clear the TX FIFO
+        //
+        const ULONG usr2 = READ_REGISTER_NOFENCE_ULONG(&registersPtr->Usr2);
+        if ((usr2 & IMX_UART_USR2_TXFE) == 0) {
 
-    WRITE_REGISTER_NOFENCE_ULONG(
-        &registersPtr->Ubmr,
-        InterruptContextPtr->UbmrCopy);
+            //
+            // The transmit FIFO should only be nonempty if the UART is on.
+            //
+            NT_ASSERT((interruptContextPtr->Ucr1Copy & IMX_UART_UCR1_UARTEN) != 0);
 
-    //
-    // Write Ucr1 last because it contains the UART enable bit
-    //
-    WRITE_REGISTER_NOFENCE_ULONG(
-        &registersPtr->Ucr1,
-        InterruptContextPtr->Ucr1Copy);
+            if (PurgeRxFifo == FALSE) {
+                IMX_UART_LOG_WARNING(
+                    "UART must be reset to purge TX FIFO which will also purge "
+                    "RX FIFO, however RxFifo purge was not requested.");
+            }
+
+            IMXUartResetHardwareAndPreserveShadowedRegisters(interruptContextPtr);
+            IMXUartRestoreHardwareFromShadowedRegisters(interruptContextPtr);
+
+            NT_ASSERT(
+                (READ_REGISTER_NOFENCE_ULONG(&registersPtr->Usr2) &
+                    IMX_UART_USR2_TXFE) != 0);
+        }
+
+        interruptContextPtr->TxBuffer.Reset();
+    }
+
+    WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
+
+    IMX_UART_LOG_TRACE(
+        "Purged FIFOs. (PurgeRxFifo = %d, PurgeTxFifo = %d)",
+        PurgeRxFifo,
+        PurgeTxFifo);
 }
 
 _Use_decl_annotations_
-void
-IMXUartComputeFifoThresholds (
-    const IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
-    ULONG BaudRate,
-    ULONG BitsPerFrame,
-    ULONG* TxFifoThresholdPtr,
-    ULONG* RxFifoThresholdPtr
+NTSTATUS IMXUartReadDeviceProperties (
+    WDFDEVICE WdfDevice,
+    IMX_UART_DEVICE_CONTEXT* DeviceContextPtr
     )
 {
-    //
-    // Compute the minimum number of characters that take just longer to
-    // transmit than the time threshold.
-    //
-    ULONG txThreshold = IMXUartComputeCharactersPerDuration(
-            DeviceContextPtr->Parameters.TxFifoThresholdUs,
-            BaudRate,
-            BitsPerFrame);
+    IMX_UART_ASSERT_MAX_IRQL(APC_LEVEL);
+
+    ACPI_EVAL_OUTPUT_BUFFER UNALIGNED* dsdBufferPtr = nullptr;
+    UINT32 dteMode = 0;
+    NTSTATUS status = 0;
 
     //
-    // Clamp in range [2, IMX_UART_FIFO_COUNT]
+    // Default is DCE mode if dte-mode is not present or it is equal to 0
+    // DTE mode is optional if dte-mode is present and not equal to 0
     //
-    if (txThreshold < 2) {
-        txThreshold = 2;
-    } else if (txThreshold > IMX_UART_FIFO_COUNT) {
-        txThreshold = IMX_UART_FIFO_COUNT;
+    DeviceContextPtr->DTEModeSelected = FALSE;
+
+    status = AcpiQueryDsd(WdfDeviceWdmGetPhysicalDevice(WdfDevice), &dsdBufferPtr);
+    if (!NT_SUCCESS(status)) {
+        return status;
     }
 
-    ULONG rxThreshold = IMXUartComputeCharactersPerDuration(
-            DeviceContextPtr->Parameters.RxFifoThresholdUs,
-            BaudRate,
-            BitsPerFrame);
+    const ACPI_METHOD_ARGUMENT UNALIGNED* devicePropertiesPkgPtr;
+    status = AcpiParseDsdAsDeviceProperties(dsdBufferPtr, &devicePropertiesPkgPtr);
+    if (!NT_SUCCESS(status)) {
+        if (dsdBufferPtr != nullptr) {
+            ExFreePoolWithTag(dsdBufferPtr, ACPI_TAG_EVAL_OUTPUT_BUFFER);
+        }
 
-    //
-    // Clamp in range [1, IMX_UART_FIFO_COUNT - 1], which will cause
-    // IMX_UART_FIFO_COUNT - rxThreshold to be in the same range.
-    //
-    if (rxThreshold < 1) {
-        rxThreshold = 1;
-    } else if (rxThreshold > (IMX_UART_FIFO_COUNT - 1)) {
-        rxThreshold = IMX_UART_FIFO_COUNT - 1;
+        return status;
     }
 
-    *TxFifoThresholdPtr = txThreshold;
-    *RxFifoThresholdPtr = IMX_UART_FIFO_COUNT - rxThreshold;
-}
+    status = AcpiDevicePropertiesQueryIntegerValue(
+        devicePropertiesPkgPtr,
+        "dte-mode",
+        &dteMode);
+    if (!NT_SUCCESS(status)) {
+        IMX_UART_LOG_WARNING(
+            "dte-mode is not present. (status = %!STATUS!)",
+            status);
+    }
+    else {
+        DeviceContextPtr->DTEModeSelected = (dteMode != 0);
+    }
 
-ULONG
-IMXUartComputeCharactersPerDuration (
-    ULONG DurationUs,
-    ULONG BaudRate,
-    ULONG BitsPerFrame
-    )
-{
-    //
-    // Compute the FIFO threshold so there's at least this much time between
-    // when the interrupt is asserted and when the FIFO goes empty (or full).
-    //
-    const ULONG minimumTime = ULONG(DurationUs * 10000000ULL / 1000000ULL);
-    const ULONG timePerFrame = BitsPerFrame * 10000000UL / BaudRate;
+    if (dsdBufferPtr != nullptr) {
+        ExFreePoolWithTag(dsdBufferPtr, ACPI_TAG_EVAL_OUTPUT_BUFFER);
+    }
 
-    return (minimumTime + (timePerFrame - 1)) / timePerFrame;
+    return status;
 }
 
-//
-// This routine has been unit tested and will compute baud rates as follows:
-//
-// DesiredBaud     ActualBaud     RfDiv     Ubir     Ubmr    Error (%)
-//        1200    1199.197628         7      109    65519 0.066864
-//        2400    2398.395256         7      219    65519 0.066864
-//        4800    4796.790511         7      439    65519 0.066864
-//        9600    9593.581022         7      879    65519 0.066864
-//       19200   19198.063841         7     1760    65519 0.010084
-//       38400   38396.127682         7     3521    65519 0.010084
-//       76800   76792.255364         7     7043    65519 0.010084
-//      115200  115199.284842         7    10566    65519 0.000621
-//      230400  230398.569684         7    21133    65519 0.000621
-//      460800  460797.139369         7    42267    65519 0.000621
-//      614400  614392.551893         7    56356    65519 0.001212
-//      921600  921596.459096         5    60382    65519 0.000384
-//     1843200 1843177.655678         2    48305    65519 0.001212
-//     3686400 3686355.311355         1    48305    65519 0.001212
-//     5000000 5000000.000000         1    65519    65519 0.000000
-// Baud not supported: 5000001
-//
+_Use_decl_annotations_
 NTSTATUS
-IMXUartComputeDividers (
-    ULONG UartModuleClock,
-    ULONG DesiredBaudRate,
-    _Out_ ULONG* RfDivPtr,
-    _Out_ ULONG* UbirPtr,
-    _Out_ ULONG* UbmrPtr
+IMXUartEvtSerCx2ApplyConfig (
+    WDFDEVICE WdfDevice,
+    PVOID ConnectionParametersPtr
     )
 {
-    ULONG rfDiv = UartModuleClock / (16 * DesiredBaudRate);
-    if (rfDiv == 0) {
-        IMX_UART_LOG_ERROR(
-            "Baud rate is too high. (DesiredBaudRate = %lu, UartModuleClock = %lu)",
-            DesiredBaudRate,
-            UartModuleClock);
-
-        return STATUS_NOT_SUPPORTED;
-    }
-
-    rfDiv = min(7, rfDiv);
+    IMX_UART_ASSERT_MAX_IRQL(PASSIVE_LEVEL);
 
-    const ULONG num = UartModuleClock;
-    const ULONG denom = 16 * rfDiv * DesiredBaudRate;
-    const ULONG scale = (max(num, denom) + 65535) / 65536;
-    const ULONG ubmrPlusOne = num / scale;
-    const ULONG ubirPlusOne = denom / scale;
+    ULONG baudRate;
+    SERIAL_LINE_CONTROL lineControl;
+    SERIAL_HANDFLOW handflow;
+    bool rtsCtsEnabled;
+    NTSTATUS status = IMXUartParseConnectionDescriptor(
+            static_cast<const RH_QUERY_CONNECTION_PROPERTIES_OUTPUT_BUFFER*>(ConnectionParametersPtr),
+            &baudRate,
+            &lineControl,
+            &handflow,
+            &rtsCtsEnabled);
 
-    if ((ubmrPlusOne == 0) || (ubirPlusOne == 0)) {
+    if (!NT_SUCCESS(status)) {
         IMX_UART_LOG_ERROR(
-            "Baud rate is too high. (DesiredBaudRate = %lu, UartModuleClock = %lu)",
-            DesiredBaudRate,
-            UartModuleClock);
+            "Failed to parse connection descriptor. (status = %!STATUS!)",
+            status);
 
-        return STATUS_NOT_SUPPORTED;
+        return status;
     }
 
-    *RfDivPtr = rfDiv;
-    *UbirPtr = ubirPlusOne - 1;
-    *UbmrPtr = ubmrPlusOne - 1;
-
-    return STATUS_SUCCESS;
+    return IMXUartConfigureUart(
+            WdfDevice,
+            baudRate,
+            &lineControl,
+            &handflow,
+            rtsCtsEnabled);
 }
 
 _Use_decl_annotations_
 NTSTATUS
-IMXUartSetBaudRate (
-    IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
-    ULONG BaudRate
+IMXUartConfigureUart (
+    WDFDEVICE WdfDevice,
+    ULONG BaudRate,
+    const SERIAL_LINE_CONTROL *LineControl,
+    const SERIAL_HANDFLOW *Handflow,
+    bool RtsCtsEnabled
     )
 {
-    IMX_UART_REGISTERS* registersPtr = DeviceContextPtr->RegistersPtr;
+    IMX_UART_ASSERT_MAX_IRQL(PASSIVE_LEVEL);
 
-    ULONG rfDiv;
-    ULONG ubir;
-    ULONG ubmr;
-    NTSTATUS status = IMXUartComputeDividers(
-            DeviceContextPtr->Parameters.ModuleClockFrequency,
-            BaudRate,
-            &rfDiv,
-            &ubir,
-            &ubmr);
+    IMX_UART_DEVICE_CONTEXT* deviceContextPtr =
+            IMXUartGetDeviceContext(WdfDevice);
 
+    NTSTATUS status = IMXUartCheckValidStateForConfigIoctl(deviceContextPtr);
     if (!NT_SUCCESS(status)) {
         IMX_UART_LOG_ERROR(
-            "IMXUartComputeDividers(...) failed. (status = %!STATUS!)",
+            "Configuration cannot be applied while IO is active. (status = %!STATUS!)",
             status);
 
         return status;
     }
 
-    //
-    // Baud rate could get set before line control settings, so just assume
-    // the typical case of 10 bits per frame.
-    //
-    const ULONG bitsPerFrame8N1 = 10;
-    ULONG txThreshold;
-    ULONG rxThreshold;
-    IMXUartComputeFifoThresholds(
-        DeviceContextPtr,
-        BaudRate,
-        bitsPerFrame8N1,
-        &txThreshold,
-        &rxThreshold);
+    IMX_UART_INTERRUPT_CONTEXT* interruptContextPtr =
+            deviceContextPtr->InterruptContextPtr;
 
-    NT_ASSERT((txThreshold >= 2) && (txThreshold <= IMX_UART_FIFO_COUNT));
-    NT_ASSERT((rxThreshold >= 1) && (rxThreshold <= (IMX_UART_FIFO_COUNT - 1)));
+    IMX_UART_REGISTERS* registersPtr = deviceContextPtr->RegistersPtr;
 
-    IMX_UART_INTERRUPT_CONTEXT* interruptContextPtr =
-            DeviceContextPtr->InterruptContextPtr;
+    deviceContextPtr->RtsCtsLinesEnabled = RtsCtsEnabled;
 
-    ULONG txDpcThreshold = IMXUartComputeCharactersPerDuration(
-            DeviceContextPtr->Parameters.TxDpcThresholdUs,
-            BaudRate,
-            bitsPerFrame8N1);
+    if (deviceContextPtr->Initialized) {
+        WdfInterruptAcquireLock(interruptContextPtr->WdfInterrupt);
+        status = IMXUartResetHardwareAndClearShadowedRegisters(
+                interruptContextPtr);
 
-    txDpcThreshold = min(
-        DeviceContextPtr->InterruptContextPtr->TxBuffer.Size - 1,
-        txDpcThreshold + 1);
+        WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
+
+        if (!NT_SUCCESS(status)) {
+            IMX_UART_LOG_ERROR(
+                "Failed to reset hardware. (status = %!STATUS!)",
+                status);
+
+            return status;
+        }
+    }
 
     //
-    // Update registers under the interrupt spinlock
+    // Set up UCR2-UCR4
     //
     {
-        WdfInterruptAcquireLock(DeviceContextPtr->WdfInterrupt);
-
-        interruptContextPtr->TxDpcThreshold = txDpcThreshold;
+        WdfInterruptAcquireLock(interruptContextPtr->WdfInterrupt);
+        interruptContextPtr->Ucr2Copy =
+            IMX_UART_UCR2_CTS |          // RTS asserted
+            IMX_UART_UCR2_IRTS |         // CTS ignored
+            IMX_UART_UCR2_TXEN |         // Enable transmitter
+            IMX_UART_UCR2_RXEN |         // Enable receiver
+            IMX_UART_UCR2_SRST;          // Do not reset
 
-        interruptContextPtr->UfcrCopy =
-            (txThreshold << IMX_UART_UFCR_TXTL_SHIFT) |
-            IMXUartRfDivMaskFromIntegerValue(rfDiv) |
-            (DeviceContextPtr->DTEModeSelected ? IMX_UART_UFCR_DCEDTE : 0) |
-            (rxThreshold << IMX_UART_UFCR_RXTL_SHIFT);
+        interruptContextPtr->Ucr3Copy =
+            IMX_UART_UCR3_DSR |          // assert DSR
+            IMX_UART_UCR3_RXDMUXSEL;
 
         WRITE_REGISTER_NOFENCE_ULONG(
-            &registersPtr->Ufcr,
-            interruptContextPtr->UfcrCopy);
+            &registersPtr->Ucr3,
+            interruptContextPtr->Ucr3Copy);
 
-        interruptContextPtr->UbirCopy = ubir;
-        WRITE_REGISTER_NOFENCE_ULONG(&registersPtr->Ubir, ubir);
+        //
+        // Set RTS trigger level
+        //
+        const ULONG rtsTriggerLevel = min(
+            IMX_UART_FIFO_COUNT,
+            deviceContextPtr->Parameters.RtsTriggerLevel);
 
-        interruptContextPtr->UbmrCopy = ubmr;
-        WRITE_REGISTER_NOFENCE_ULONG(&registersPtr->Ubmr, ubmr);
+        interruptContextPtr->Ucr4Copy =
+            (rtsTriggerLevel << IMX_UART_UCR4_CTSTL_SHIFT);
 
-        DeviceContextPtr->CurrentBaudRate = BaudRate;
-        WdfInterruptReleaseLock(DeviceContextPtr->WdfInterrupt);
+        WRITE_REGISTER_NOFENCE_ULONG(
+            &registersPtr->Ucr4,
+            interruptContextPtr->Ucr4Copy);
+
+        WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
     }
 
-    IMX_UART_LOG_INFORMATION(
-        "Successfully set baud rate. "
-        "(BaudRate = %lu, rfDiv = %lu, ubir = %lu, ubmr = %lu, "
-        "rxThreshold = %lu, txThreshold = %lu, txDpcThreshold = %lu)",
-        BaudRate,
-        rfDiv,
-        ubir,
-        ubmr,
-        rxThreshold,
-        txThreshold,
-        txDpcThreshold);
+    status = IMXUartSetBaudRate(deviceContextPtr, BaudRate);
+    if (!NT_SUCCESS(status)) {
+        IMX_UART_LOG_ERROR(
+            "Failed to set baud rate. (status = %!STATUS!, baudRate = %lu)",
+            status,
+            BaudRate);
 
-    return STATUS_SUCCESS;
-}
+        return status;
+    }
 
-_Use_decl_annotations_
-NTSTATUS
-IMXUartSetLineControl (
-    IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
-    const SERIAL_LINE_CONTROL* LineControlPtr
-    )
-{
-    IMX_UART_INTERRUPT_CONTEXT* interruptContextPtr =
-            DeviceContextPtr->InterruptContextPtr;
+    status = IMXUartSetLineControl(deviceContextPtr, LineControl);
+    if (!NT_SUCCESS(status)) {
+        IMX_UART_LOG_ERROR(
+            "Failed to set line control. (status = %!STATUS!)",
+            status);
 
-    ULONG setMask = 0;
-    ULONG clearMask = 0;
-
-    switch (LineControlPtr->StopBits) {
-    case STOP_BIT_1:
-        clearMask |= IMX_UART_UCR2_STPB;
-        break;
-
-    case STOP_BITS_2:
-        setMask |= IMX_UART_UCR2_STPB;
-        break;
-
-    case STOP_BITS_1_5:
-        IMX_UART_LOG_ERROR("STOP_BITS_1_5 is not supported.");
-        return STATUS_INVALID_PARAMETER;
-
-    default:
-        return STATUS_INVALID_PARAMETER;
-    }
-
-    switch (LineControlPtr->Parity) {
-    case NO_PARITY:
-        clearMask |= IMX_UART_UCR2_PREN;
-        break;
-
-    case ODD_PARITY:
-        setMask |= IMX_UART_UCR2_PREN;
-        setMask |= IMX_UART_UCR2_PROE;
-        break;
-
-    case EVEN_PARITY:
-        setMask |= IMX_UART_UCR2_PREN;
-        clearMask |= IMX_UART_UCR2_PROE;
-        break;
-
-    case MARK_PARITY:
-    case SPACE_PARITY:
-        IMX_UART_LOG_ERROR(
-            "MARK_PARITY and SPACE_PARITY are not supported. (LineControlPtr->Parity = %d)",
-            LineControlPtr->Parity);
-
-        return STATUS_INVALID_PARAMETER;
-
-    default:
-        return STATUS_INVALID_PARAMETER;
+        return status;
     }
 
-    switch (LineControlPtr->WordLength) {
-    case 7:
-        clearMask |= IMX_UART_UCR2_WS;
-        break;
-
-    case 8:
-        setMask |= IMX_UART_UCR2_WS;
-        break;
-
-    default:
+    status = IMXUartSetHandflow(deviceContextPtr, Handflow);
+    if (!NT_SUCCESS(status)) {
         IMX_UART_LOG_ERROR(
-            "Unsupported word length: %d",
-            LineControlPtr->WordLength);
+            "Failed to set handflow. (status = %!STATUS!)",
+            status);
 
-        return STATUS_INVALID_PARAMETER;
+        return status;
     }
 
     //
-    // Set mask and clear mask should not overlap
+    // Read Device Properties - check if dte-mode is present.
     //
-    NT_ASSERT((setMask & clearMask) == 0);
-
-    IMX_UART_LOG_INFORMATION(
-        "Updating line control. (setMask = 0x%lx, clearMask = 0x%lx, StopBits = %d, Parity = %d, WordLength = %d)",
-        setMask,
-        clearMask,
-        LineControlPtr->StopBits,
-        LineControlPtr->Parity,
-        LineControlPtr->WordLength);
+    status = IMXUartReadDeviceProperties(WdfDevice, deviceContextPtr);
 
     //
-    // Update UCR2 register under the interrupt spinlock
+    // Enable the UART
     //
     {
         WdfInterruptAcquireLock(interruptContextPtr->WdfInterrupt);
 
-        interruptContextPtr->Ucr2Copy &= ~clearMask;
-        interruptContextPtr->Ucr2Copy |= setMask;
+        interruptContextPtr->Ucr1Copy |= IMX_UART_UCR1_UARTEN;
         WRITE_REGISTER_NOFENCE_ULONG(
-            &interruptContextPtr->RegistersPtr->Ucr2,
-            interruptContextPtr->Ucr2Copy);
+            &registersPtr->Ucr1,
+            interruptContextPtr->Ucr1Copy);
 
         WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
     }
 
+    deviceContextPtr->Initialized = true;
     return STATUS_SUCCESS;
 }
 
 //
-// The IMX6 Datasheet and Windows meanings of RTS/CTS are swapped.
-//
-// RTS is an output pin and has two modes:
-//
-//    SERIAL_RTS_CONTROL - whoever has a handle open to the serial port
-//                         can manually set the state of RTS using
-//                         the IOCTL_SERIAL_SET_RTS/IOCTL_SERIAL_CLR_RTS
-//                         IOCTLs
-//
-//    SERIAL_RTS_HANDSHAKE - the UART hardware automatically sets and
-//                           clears RTS depending on RX FIFO level. It is
-//                           illegal to send IOCTL_SERIAL_SET/CLR_RTS
-//                           in this mode.
-//
-// On the IMX6 UART controller, RTS is controlled by CTSC bit, which selects
-// between manual and automatic control of RTS. When the controller is in
-// manual RTS mode, the CTS bit controls the state of RTS (makes sense!).
-//
-// CTS is an input pin and has two modes:
-//
-//    SERIAL_CTS_HANDSHAKE bit set - the transmitter hardware only sends
-//                                   bytes when the CTS pin is high.
-//
-//    SERIAL_CTS_HANDSHAKE bit clear - the transmitter hardware
-//                                     ignores CTS and always sends bytes.
-//
-// On the IMX6 UART controller, CTS is controller by the IRTS bit, which
-// selects between ignoring and paying attention to the CTS line.
+// UART configuration changes (Baud, Handflow, etc.) are only allowed before
+// the first read or write IRP is sent. Changing line configuration while
+// data transmission is in progress could have unpredictable effects.
 //
-_Use_decl_annotations_
 NTSTATUS
-IMXUartSetHandflow (
-    IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
-    const SERIAL_HANDFLOW* LineControlPtr
+IMXUartCheckValidStateForConfigIoctl (
+    const IMX_UART_DEVICE_CONTEXT* DeviceContextPtr
     )
 {
-    ULONG setMask = 0;
-    ULONG clearMask = 0;
-
-    //
-    // Handle output flow control setting. The transmitter on this UART can
-    // optionally monitor the CTS pin - an input on this UART - to control when
-    // the transmitter hardware sends data.
-    //
-    switch (LineControlPtr->ControlHandShake & SERIAL_OUT_HANDSHAKEMASK) {
-    case 0:
+    const IMX_UART_INTERRUPT_CONTEXT* interruptContextPtr =
+            DeviceContextPtr->InterruptContextPtr;
 
-        //
-        // Ignore CTS (an input pin). Since the IMX6 datasheet swaps the
-        // meaning of RTS and CTS, we set the "Ignore RTS bit", which
-        // really means to ignore CTS.
-        //
-        setMask |= IMX_UART_UCR2_IRTS;
-        break;
+    switch (interruptContextPtr->RxState) {
+    case IMX_UART_STATE::WAITING_FOR_INTERRUPT:
+    case IMX_UART_STATE::WAITING_FOR_DPC:
+        return STATUS_INVALID_DEVICE_STATE;
+    }
 
-    case SERIAL_CTS_HANDSHAKE:
+    switch (interruptContextPtr->RxDmaState) {
+    case IMX_UART_STATE::WAITING_FOR_DPC:
+        return STATUS_INVALID_DEVICE_STATE;
+    }
 
-        //
-        // Pay attention to CTS. Since the IMX6 datasheet swaps the meaning
-        // of RTS and CTS, we clear the "Ignore RTS bit", which really means
-        // to pay attention to CTS.
-        //
-        if (!DeviceContextPtr->RtsCtsLinesEnabled) {
-            IMX_UART_LOG_ERROR(
-                "RTS/CTS flow control is not allowed on this UART instance "
-                "since RTS/CTS lines were not specified in the "
-                "SerialLinesEnabled mask in the UartSerialBus() connection "
-                "descriptor.");
+    switch (interruptContextPtr->TxState) {
+    case IMX_UART_STATE::WAITING_FOR_INTERRUPT:
+    case IMX_UART_STATE::WAITING_FOR_DPC:
+        return STATUS_INVALID_DEVICE_STATE;
+    }
 
-            return STATUS_INVALID_DEVICE_STATE;
-        }
+    switch (interruptContextPtr->TxDrainState) {
+    case IMX_UART_STATE::WAITING_FOR_INTERRUPT:
+    case IMX_UART_STATE::WAITING_FOR_DPC:
+        return STATUS_INVALID_DEVICE_STATE;
+    }
 
-        clearMask |= IMX_UART_UCR2_IRTS;
-        break;
+    switch (interruptContextPtr->TxPurgeState) {
+    case IMX_UART_STATE::WAITING_FOR_INTERRUPT:
+    case IMX_UART_STATE::WAITING_FOR_DPC:
+        return STATUS_INVALID_DEVICE_STATE;
+    }
 
-    case SERIAL_DSR_HANDSHAKE:
-    case SERIAL_DCD_HANDSHAKE:
-    default:
-        IMX_UART_LOG_ERROR(
-            "Unsupported flow control setting. (LineControlPtr->ControlHandShake = 0x%lx)",
-            LineControlPtr->ControlHandShake);
+    switch (interruptContextPtr->TxDmaState) {
+    case IMX_UART_STATE::WAITING_FOR_DPC:
+        return STATUS_INVALID_DEVICE_STATE;
+    }
 
-        return STATUS_NOT_SUPPORTED;
+    switch (interruptContextPtr->TxDmaDrainState) {
+    case IMX_UART_STATE::WAITING_FOR_INTERRUPT:
+    case IMX_UART_STATE::WAITING_FOR_DPC:
+        return STATUS_INVALID_DEVICE_STATE;
     }
 
-    if ((LineControlPtr->ControlHandShake & ~SERIAL_OUT_HANDSHAKEMASK) != 0) {
-        IMX_UART_LOG_ERROR(
-            "Unsupported ControlHandShake flag. "
-            "(LineControlPtr->ControlHandShake = 0x%lx)",
-            LineControlPtr->ControlHandShake);
+    return STATUS_SUCCESS;
+}
 
-        return STATUS_NOT_SUPPORTED;
-    }
+//
+// Follow procedure in datasheet section 64.10.2 to reset hardware.
+//
+NTSTATUS
+IMXUartResetHardwareAndPreserveShadowedRegisters (
+    const IMX_UART_INTERRUPT_CONTEXT* InterruptContextPtr
+    )
+{
+    IMX_UART_REGISTERS* registersPtr = InterruptContextPtr->RegistersPtr;
 
     //
-    // Handle RTS flow control. The receiver on this UART can optionally
-    // set the RTS pin - an output on this UART - depending on FIFO level.
-    // Or the user can control it manually with IOCTLs.
+    // Disable UART and reset control registers
     //
-    switch (LineControlPtr->FlowReplace & SERIAL_RTS_MASK) {
-    case 0:
-
-        //
-        // Treat no RTS setting the same as manual control
-        //
-        clearMask |= IMX_UART_UCR2_CTSC;
-        setMask |= IMX_UART_UCR2_CTS;
-        break;
+    WRITE_REGISTER_NOFENCE_ULONG(&registersPtr->Ucr1, 0);
+    WRITE_REGISTER_NOFENCE_ULONG(&registersPtr->Ucr3, 0);
+    WRITE_REGISTER_NOFENCE_ULONG(&registersPtr->Ucr4, 0);
+    WRITE_REGISTER_NOFENCE_ULONG(&registersPtr->Umcr, 0);
 
-    case SERIAL_RTS_CONTROL:
+    //
+    // Initiate reset by clearing IMX_UART_UCR2_SRST bit
+    //
+    WRITE_REGISTER_NOFENCE_ULONG(&registersPtr->Ucr2, 0);
 
-        if (!DeviceContextPtr->RtsCtsLinesEnabled) {
-            IMX_UART_LOG_WARNING(
-                "SERIAL_RTS_CONTROL was specified, but RTS/CTS were not "
-                "specified in the SerialLinesEnabled mask in the "
-                "UartSerialBus() connection descriptor, so RTS/CTS may not "
-                "be pinned out on this UART.");
+    //
+    // Wait for SOFTRST bit to deassert
+    //
+    ULONG uts;
+    int i;
+    for (i = 1000; i != 0; --i) {
+        KeStallExecutionProcessor(1);
+        uts = READ_REGISTER_NOFENCE_ULONG(&registersPtr->Uts);
+        if ((uts & IMX_UART_UTS_SOFTRST) == 0) {
+            return STATUS_SUCCESS;
         }
+    }
 
-        //
-        // Enable the CTS bit to control the RTS line and ensure line is
-        // initially asserted.
-        //
+    IMX_UART_LOG_ERROR(
+        "Timed out waiting for SOFTRST bit to clear. (uts = 0x%lx)",
+        uts);
+
+    NT_ASSERT(FALSE);
+    return STATUS_IO_TIMEOUT;
+}
+
+NTSTATUS
+IMXUartResetHardwareAndClearShadowedRegisters (
+    IMX_UART_INTERRUPT_CONTEXT* InterruptContextPtr
+    )
+{
+    NTSTATUS status = IMXUartResetHardwareAndPreserveShadowedRegisters(
+            InterruptContextPtr);
+
+    InterruptContextPtr->Ucr1Copy = 0;
+    InterruptContextPtr->Ucr2Copy = IMX_UART_UCR2_SRST;
+    InterruptContextPtr->Ucr3Copy = 0;
+    InterruptContextPtr->Ucr4Copy = 0;
+    InterruptContextPtr->UbirCopy = 0;
+    InterruptContextPtr->UbmrCopy = 0;
+    InterruptContextPtr->UfcrCopy = 0;
+
+    return status;
+}
+
+void
+IMXUartRestoreHardwareFromShadowedRegisters (
+    const IMX_UART_INTERRUPT_CONTEXT* InterruptContextPtr
+    )
+{
+    IMX_UART_REGISTERS* registersPtr = InterruptContextPtr->RegistersPtr;
+
+    //
+    // Precondition: UART should be disabled
+    //
+    NT_ASSERT(
+        (READ_REGISTER_NOFENCE_ULONG(&registersPtr->Ucr1) &
+        IMX_UART_UCR1_UARTEN) == 0);
+
+    WRITE_REGISTER_NOFENCE_ULONG(
+        &registersPtr->Ucr2,
+        InterruptContextPtr->Ucr2Copy);
+
+    WRITE_REGISTER_NOFENCE_ULONG(
+        &registersPtr->Ucr3,
+        InterruptContextPtr->Ucr3Copy);
+
+    WRITE_REGISTER_NOFENCE_ULONG(
+        &registersPtr->Ucr4,
+        InterruptContextPtr->Ucr4Copy);
+
+    WRITE_REGISTER_NOFENCE_ULONG(
+        &registersPtr->Ufcr,
+        InterruptContextPtr->UfcrCopy);
+
+    WRITE_REGISTER_NOFENCE_ULONG(
+        &registersPtr->Ubir,
+        InterruptContextPtr->UbirCopy);
+
+    WRITE_REGISTER_NOFENCE_ULONG(
+        &registersPtr->Ubmr,
+        InterruptContextPtr->UbmrCopy);
+
+    //
+    // Write Ucr1 last because it contains the UART enable bit
+    //
+    WRITE_REGISTER_NOFENCE_ULONG(
+        &registersPtr->Ucr1,
+        InterruptContextPtr->Ucr1Copy);
+}
+
+_Use_decl_annotations_
+void
+IMXUartComputeFifoThresholds (
+    const IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
+    ULONG BaudRate,
+    ULONG BitsPerFrame,
+    ULONG* TxFifoThresholdPtr,
+    ULONG* RxFifoThresholdPtr
+    )
+{
+    //
+    // Compute the minimum number of characters that take just longer to
+    // transmit than the time threshold.
+    //
+    ULONG txThreshold = IMXUartComputeCharactersPerDuration(
+            DeviceContextPtr->Parameters.TxFifoThresholdUs,
+            BaudRate,
+            BitsPerFrame);
+
+    //
+    // Clamp in range [2, IMX_UART_FIFO_COUNT]
+    //
+    if (txThreshold < 2) {
+        txThreshold = 2;
+    } else if (txThreshold > IMX_UART_FIFO_COUNT) {
+        txThreshold = IMX_UART_FIFO_COUNT;
+    }
+
+    ULONG rxThreshold = IMXUartComputeCharactersPerDuration(
+            DeviceContextPtr->Parameters.RxFifoThresholdUs,
+            BaudRate,
+            BitsPerFrame);
+
+    //
+    // Clamp in range [1, IMX_UART_FIFO_COUNT - 1], which will cause
+    // IMX_UART_FIFO_COUNT - rxThreshold to be in the same range.
+    //
+    if (rxThreshold < 1) {
+        rxThreshold = 1;
+    } else if (rxThreshold > (IMX_UART_FIFO_COUNT - 1)) {
+        rxThreshold = IMX_UART_FIFO_COUNT - 1;
+    }
+
+    *TxFifoThresholdPtr = txThreshold;
+    *RxFifoThresholdPtr = IMX_UART_FIFO_COUNT - rxThreshold;
+}
+
+//
+// Computes the limits the adaptive policy may move the FIFO thresholds to.
+// The static thresholds are the most conservative settings (most time to
+// service the FIFO) and form the other end of each range.
+//
+_Use_decl_annotations_
+void
+IMXUartComputeAdaptiveFifoBounds (
+    const IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
+    ULONG BaudRate,
+    ULONG BitsPerFrame,
+    ULONG TxFifoThreshold,
+    ULONG RxFifoThreshold,
+    ULONG* TxFifoThresholdMaxPtr,
+    ULONG* RxFifoThresholdMaxPtr
+    )
+{
+    //
+    // Raising TXTL refills the FIFO earlier. Never go beyond the number of
+    // characters that take TxFifoThresholdMaxUs to transmit.
+    //
+    ULONG txThresholdMax = IMXUartComputeCharactersPerDuration(
+            DeviceContextPtr->Parameters.TxFifoThresholdMaxUs,
+            BaudRate,
+            BitsPerFrame);
+
+    if (txThresholdMax < TxFifoThreshold) {
+        txThresholdMax = TxFifoThreshold;
+    } else if (txThresholdMax > IMX_UART_FIFO_COUNT) {
+        txThresholdMax = IMX_UART_FIFO_COUNT;
+    }
+
+    //
+    // Raising RXTL leaves fewer free FIFO slots when RRDY asserts. Always
+    // leave room for at least RxFifoThresholdMinUs worth of characters.
+    //
+    ULONG rxHeadroomMin = IMXUartComputeCharactersPerDuration(
+            DeviceContextPtr->Parameters.RxFifoThresholdMinUs,
+            BaudRate,
+            BitsPerFrame);
+
+    if (rxHeadroomMin < 1) {
+        rxHeadroomMin = 1;
+    } else if (rxHeadroomMin > (IMX_UART_FIFO_COUNT - 1)) {
+        rxHeadroomMin = IMX_UART_FIFO_COUNT - 1;
+    }
+
+    ULONG rxThresholdMax = IMX_UART_FIFO_COUNT - rxHeadroomMin;
+    if (rxThresholdMax < RxFifoThreshold) {
+        rxThresholdMax = RxFifoThreshold;
+    }
+
+    *TxFifoThresholdMaxPtr = txThresholdMax;
+    *RxFifoThresholdMaxPtr = rxThresholdMax;
+}
+
+//
+// Called from the ISR once per tuning window. RXTL is raised one step at a
+// time while the FIFO is being serviced because it reached the threshold
+// (sustained traffic) and no overruns occur, and is pulled halfway back
+// toward the static setting on any overrun. TXTL is raised halfway toward
+// its limit when the FIFO runs dry with data pending, and decays one step
+// per quiet window. Aging timer dominated windows (idle trickle) leave RXTL
+// alone since AGTIM already bounds latency there.
+//
+// The SDMA watermark level is taken from UFCR when a DMA transaction is
+// configured and cannot follow a retune of a running channel. RX DMA stays
+// armed for as long as it is available, so RXTL is only tuned for PIO
+// receive. TXTL is left alone while a TX DMA transfer or its drain is in
+// flight; the next TX DMA transaction picks up the new value.
+//
+_Use_decl_annotations_
+void
+IMXUartTuneFifoThresholds (
+    IMX_UART_INTERRUPT_CONTEXT* InterruptContextPtr
+    )
+{
+    auto& tuning = InterruptContextPtr->FifoTuning;
+    const ULONG ufcr = InterruptContextPtr->UfcrCopy;
+    ULONG rxThreshold =
+        (ufcr & IMX_UART_UFCR_RXTL_MASK) >> IMX_UART_UFCR_RXTL_SHIFT;
+
+    ULONG txThreshold =
+        (ufcr & IMX_UART_UFCR_TXTL_MASK) >> IMX_UART_UFCR_TXTL_SHIFT;
+
+    const bool isRxDmaUsed =
+        InterruptContextPtr->RxDmaTransactionContextPtr != nullptr;
+
+    const bool isTxDmaInFlight =
+        (InterruptContextPtr->TxDmaState != IMX_UART_STATE::STOPPED) ||
+        (InterruptContextPtr->TxDmaDrainState != IMX_UART_STATE::STOPPED);
+
+    if (isRxDmaUsed) {
+        //
+        // RXTL is also the RX SDMA watermark level
+        //
+    } else if (tuning.WindowRxOverrunCount != 0) {
+        rxThreshold = tuning.RxThresholdMin +
+            (rxThreshold - min(rxThreshold, tuning.RxThresholdMin)) / 2;
+
+    } else if ((tuning.WindowRxInterruptCount != 0) &&
+               ((tuning.WindowAgingTimerCount * 4) <
+                tuning.WindowRxInterruptCount) &&
+               ((tuning.WindowRxByteCount / tuning.WindowRxInterruptCount) >=
+                rxThreshold)) {
+
+        rxThreshold = min(rxThreshold + 1, tuning.RxThresholdMax);
+    }
+
+    if (isTxDmaInFlight) {
+        //
+        // TXTL is also the TX SDMA watermark level
+        //
+    } else if (tuning.WindowTxUnderrunCount != 0) {
+        txThreshold +=
+            (tuning.TxThresholdMax - min(txThreshold, tuning.TxThresholdMax) + 1) / 2;
+
+        txThreshold = min(txThreshold, tuning.TxThresholdMax);
+    } else if (txThreshold > tuning.TxThresholdMin) {
+        --txThreshold;
+    }
+
+    const ULONG newUfcr = (ufcr &
+        ~(IMX_UART_UFCR_RXTL_MASK | IMX_UART_UFCR_TXTL_MASK)) |
+        (txThreshold << IMX_UART_UFCR_TXTL_SHIFT) |
+        (rxThreshold << IMX_UART_UFCR_RXTL_SHIFT);
+
+    if (newUfcr != ufcr) {
+        InterruptContextPtr->UfcrCopy = newUfcr;
+        WRITE_REGISTER_NOFENCE_ULONG(
+            &InterruptContextPtr->RegistersPtr->Ufcr,
+            newUfcr);
+
+        ++InterruptContextPtr->Statistics.FifoThresholdUpdateCount;
+    }
+
+    tuning.WindowInterruptCount = 0;
+    tuning.WindowRxInterruptCount = 0;
+    tuning.WindowRxByteCount = 0;
+    tuning.WindowAgingTimerCount = 0;
+    tuning.WindowRxOverrunCount = 0;
+    tuning.WindowTxUnderrunCount = 0;
+}
+
+ULONG
+IMXUartComputeCharactersPerDuration (
+    ULONG DurationUs,
+    ULONG BaudRate,
+    ULONG BitsPerFrame
+    )
+{
+    //
+    // Compute the FIFO threshold so there's at least this much time between
+    // when the interrupt is asserted and when the FIFO goes empty (or full).
+    //
+    const ULONG minimumTime = ULONG(DurationUs * 10000000ULL / 1000000ULL);
+    const ULONG timePerFrame = BitsPerFrame * 10000000UL / BaudRate;
+
+    return (minimumTime + (timePerFrame - 1)) / timePerFrame;
+}
+
+//
+// This routine has been unit tested and will compute baud rates as follows:
+//
+// DesiredBaud     ActualBaud     RfDiv     Ubir     Ubmr    Error (%)
+//        1200    1199.197628         7      109    65519 0.066864
+//        2400    2398.395256         7      219    65519 0.066864
+//        4800    4796.790511         7      439    65519 0.066864
+//        9600    9593.581022         7      879    65519 0.066864
+//       19200   19198.063841         7     1760    65519 0.010084
+//       38400   38396.127682         7     3521    65519 0.010084
+//       76800   76792.255364         7     7043    65519 0.010084
+//      115200  115199.284842         7    10566    65519 0.000621
+//      230400  230398.569684         7    21133    65519 0.000621
+//      460800  460797.139369         7    42267    65519 0.000621
+//      614400  614392.551893         7    56356    65519 0.001212
+//      921600  921596.459096         5    60382    65519 0.000384
+//     1843200 1843177.655678         2    48305    65519 0.001212
+//     3686400 3686355.311355         1    48305    65519 0.001212
+//     5000000 5000000.000000         1    65519    65519 0.000000
+// Baud not supported: 5000001
+//
+NTSTATUS
+IMXUartComputeDividers (
+    ULONG UartModuleClock,
+    ULONG DesiredBaudRate,
+    _Out_ ULONG* RfDivPtr,
+    _Out_ ULONG* UbirPtr,
+    _Out_ ULONG* UbmrPtr
+    )
+{
+    ULONG rfDiv = UartModuleClock / (16 * DesiredBaudRate);
+    if (rfDiv == 0) {
+        IMX_UART_LOG_ERROR(
+            "Baud rate is too high. (DesiredBaudRate = %lu, UartModuleClock = %lu)",
+            DesiredBaudRate,
+            UartModuleClock);
+
+        return STATUS_NOT_SUPPORTED;
+    }
+
+    rfDiv = min(7, rfDiv);
+
+    const ULONG num = UartModuleClock;
+    const ULONG denom = 16 * rfDiv * DesiredBaudRate;
+    const ULONG scale = (max(num, denom) + 65535) / 65536;
+    const ULONG ubmrPlusOne = num / scale;
+    const ULONG ubirPlusOne = denom / scale;
+
+    if ((ubmrPlusOne == 0) || (ubirPlusOne == 0)) {
+        IMX_UART_LOG_ERROR(
+            "Baud rate is too high. (DesiredBaudRate = %lu, UartModuleClock = %lu)",
+            DesiredBaudRate,
+            UartModuleClock);
+
+        return STATUS_NOT_SUPPORTED;
+    }
+
+    *RfDivPtr = rfDiv;
+    *UbirPtr = ubirPlusOne - 1;
+    *UbmrPtr = ubmrPlusOne - 1;
+
+    return STATUS_SUCCESS;
+}
+
+_Use_decl_annotations_
+NTSTATUS
+IMXUartSetBaudRate (
+    IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
+    ULONG BaudRate
+    )
+{
+    IMX_UART_REGISTERS* registersPtr = DeviceContextPtr->RegistersPtr;
+
+    ULONG rfDiv;
+    ULONG ubir;
+    ULONG ubmr;
+    NTSTATUS status = IMXUartComputeDividers(
+            DeviceContextPtr->Parameters.ModuleClockFrequency,
+            BaudRate,
+            &rfDiv,
+            &ubir,
+            &ubmr);
+
+    if (!NT_SUCCESS(status)) {
+        IMX_UART_LOG_ERROR(
+            "IMXUartComputeDividers(...) failed. (status = %!STATUS!)",
+            status);
+
+        return status;
+    }
+
+    //
+    // Baud rate could get set before line control settings, so just assume
+    // the typical case of 10 bits per frame.
+    //
+    const ULONG bitsPerFrame8N1 = 10;
+    ULONG txThreshold;
+    ULONG rxThreshold;
+    IMXUartComputeFifoThresholds(
+        DeviceContextPtr,
+        BaudRate,
+        bitsPerFrame8N1,
+        &txThreshold,
+        &rxThreshold);
+
+    NT_ASSERT((txThreshold >= 2) && (txThreshold <= IMX_UART_FIFO_COUNT));
+    NT_ASSERT((rxThreshold >= 1) && (rxThreshold <= (IMX_UART_FIFO_COUNT - 1)));
+
+    IMX_UART_INTERRUPT_CONTEXT* interruptContextPtr =
+            DeviceContextPtr->InterruptContextPtr;
+
+    ULONG txDpcThreshold = IMXUartComputeCharactersPerDuration(
+            DeviceContextPtr->Parameters.TxDpcThresholdUs,
+            BaudRate,
+            bitsPerFrame8N1);
+
+    txDpcThreshold = min(
+        DeviceContextPtr->InterruptContextPtr->TxBuffer.Size - 1,
+        txDpcThreshold + 1);
+
+    ULONG txThresholdMax;
+    ULONG rxThresholdMax;
+    IMXUartComputeAdaptiveFifoBounds(
+        DeviceContextPtr,
+        BaudRate,
+        bitsPerFrame8N1,
+        txThreshold,
+        rxThreshold,
+        &txThresholdMax,
+        &rxThresholdMax);
+
+    //
+    // Update registers under the interrupt spinlock
+    //
+    {
+        WdfInterruptAcquireLock(DeviceContextPtr->WdfInterrupt);
+
+        interruptContextPtr->TxDpcThreshold = txDpcThreshold;
+
+        //
+        // Restart adaptive tuning from the static thresholds
+        //
+        RtlZeroMemory(
+            &interruptContextPtr->FifoTuning,
+            sizeof(interruptContextPtr->FifoTuning));
+
+        interruptContextPtr->FifoTuning.Enabled =
+            DeviceContextPtr->Parameters.AdaptiveFifoThresholds != 0;
+
+        interruptContextPtr->FifoTuning.RxThresholdMin = rxThreshold;
+        interruptContextPtr->FifoTuning.RxThresholdMax = rxThresholdMax;
+        interruptContextPtr->FifoTuning.TxThresholdMin = txThreshold;
+        interruptContextPtr->FifoTuning.TxThresholdMax = txThresholdMax;
+
+        interruptContextPtr->UfcrCopy =
+            (txThreshold << IMX_UART_UFCR_TXTL_SHIFT) |
+            IMXUartRfDivMaskFromIntegerValue(rfDiv) |
+            (DeviceContextPtr->DTEModeSelected ? IMX_UART_UFCR_DCEDTE : 0) |
+            (rxThreshold << IMX_UART_UFCR_RXTL_SHIFT);
+
+        WRITE_REGISTER_NOFENCE_ULONG(
+            &registersPtr->Ufcr,
+            interruptContextPtr->UfcrCopy);
+
+        interruptContextPtr->UbirCopy = ubir;
+        WRITE_REGISTER_NOFENCE_ULONG(&registersPtr->Ubir, ubir);
+
+        interruptContextPtr->UbmrCopy = ubmr;
+        WRITE_REGISTER_NOFENCE_ULONG(&registersPtr->Ubmr, ubmr);
+
+        DeviceContextPtr->CurrentBaudRate = BaudRate;
+        WdfInterruptReleaseLock(DeviceContextPtr->WdfInterrupt);
+    }
+
+    IMX_UART_LOG_INFORMATION(
+        "Successfully set baud rate. "
+        "(BaudRate = %lu, rfDiv = %lu, ubir = %lu, ubmr = %lu, "
+        "rxThreshold = %lu, txThreshold = %lu, txDpcThreshold = %lu)",
+        BaudRate,
+        rfDiv,
+        ubir,
+        ubmr,
+        rxThreshold,
+        txThreshold,
+        txDpcThreshold);
+
+    return STATUS_SUCCESS;
+}
+
+_Use_decl_annotations_
+NTSTATUS
+IMXUartSetLineControl (
+    IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
+    const SERIAL_LINE_CONTROL* LineControlPtr
+    )
+{
+    IMX_UART_INTERRUPT_CONTEXT* interruptContextPtr =
+            DeviceContextPtr->InterruptContextPtr;
+
+    ULONG setMask = 0;
+    ULONG clearMask = 0;
+
+    switch (LineControlPtr->StopBits) {
+    case STOP_BIT_1:
+        clearMask |= IMX_UART_UCR2_STPB;
+        break;
+
+    case STOP_BITS_2:
+        setMask |= IMX_UART_UCR2_STPB;
+        break;
+
+    case STOP_BITS_1_5:
+        IMX_UART_LOG_ERROR("STOP_BITS_1_5 is not supported.");
+        return STATUS_INVALID_PARAMETER;
+
+    default:
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    switch (LineControlPtr->Parity) {
+    case NO_PARITY:
+        clearMask |= IMX_UART_UCR2_PREN;
+        break;
+
+    case ODD_PARITY:
+        setMask |= IMX_UART_UCR2_PREN;
+        setMask |= IMX_UART_UCR2_PROE;
+        break;
+
+    case EVEN_PARITY:
+        setMask |= IMX_UART_UCR2_PREN;
+        clearMask |= IMX_UART_UCR2_PROE;
+        break;
+
+    case MARK_PARITY:
+    case SPACE_PARITY:
+        IMX_UART_LOG_ERROR(
+            "MARK_PARITY and SPACE_PARITY are not supported. (LineControlPtr->Parity = %d)",
+            LineControlPtr->Parity);
+
+        return STATUS_INVALID_PARAMETER;
+
+    default:
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    switch (LineControlPtr->WordLength) {
+    case 7:
+        clearMask |= IMX_UART_UCR2_WS;
+        break;
+
+    case 8:
+        setMask |= IMX_UART_UCR2_WS;
+        break;
+
+    default:
+        IMX_UART_LOG_ERROR(
+            "Unsupported word length: %d",
+            LineControlPtr->WordLength);
+
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    //
+    // Set mask and clear mask should not overlap
+    //
+    NT_ASSERT((setMask & clearMask) == 0);
+
+    IMX_UART_LOG_INFORMATION(
+        "Updating line control. (setMask = 0x%lx, clearMask = 0x%lx, StopBits = %d, Parity = %d, WordLength = %d)",
+        setMask,
+        clearMask,
+        LineControlPtr->StopBits,
+        LineControlPtr->Parity,
+        LineControlPtr->WordLength);
+
+    //
+    // Update UCR2 register under the interrupt spinlock
+    //
+    {
+        WdfInterruptAcquireLock(interruptContextPtr->WdfInterrupt);
+
+        interruptContextPtr->Ucr2Copy &= ~clearMask;
+        interruptContextPtr->Ucr2Copy |= setMask;
+        WRITE_REGISTER_NOFENCE_ULONG(
+            &interruptContextPtr->RegistersPtr->Ucr2,
+            interruptContextPtr->Ucr2Copy);
+
+        WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
+    }
+
+    return STATUS_SUCCESS;
+}
+
+//
+// The IMX6 Datasheet and Windows meanings of RTS/CTS are swapped.
+//
+// RTS is an output pin and has two modes:
+//
+//    SERIAL_RTS_CONTROL - whoever has a handle open to the serial port
+//                         can manually set the state of RTS using
+//                         the IOCTL_SERIAL_SET_RTS/IOCTL_SERIAL_CLR_RTS
+//                         IOCTLs
+//
+//    SERIAL_RTS_HANDSHAKE - the UART hardware automatically sets and
+//                           clears RTS depending on RX FIFO level. It is
+//                           illegal to send IOCTL_SERIAL_SET/CLR_RTS
+//                           in this mode.
+//
+// On the IMX6 UART controller, RTS is controlled by CTSC bit, which selects
+// between manual and automatic control of RTS. When the controller is in
+// manual RTS mode, the CTS bit controls the state of RTS (makes sense!).
+//
+// CTS is an input pin and has two modes:
+//
+//    SERIAL_CTS_HANDSHAKE bit set - the transmitter hardware only sends
+//                                   bytes when the CTS pin is high.
+//
+//    SERIAL_CTS_HANDSHAKE bit clear - the transmitter hardware
+//                                     ignores CTS and always sends bytes.
+//
+// On the IMX6 UART controller, CTS is controller by the IRTS bit, which
+// selects between ignoring and paying attention to the CTS line.
+//
+_Use_decl_annotations_
+NTSTATUS
+IMXUartSetHandflow (
+    IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
+    const SERIAL_HANDFLOW* LineControlPtr
+    )
+{
+    ULONG setMask = 0;
+    ULONG clearMask = 0;
+
+    //
+    // Handle output flow control setting. The transmitter on this UART can
+    // optionally monitor the CTS pin - an input on this UART - to control when
+    // the transmitter hardware sends data.
+    //
+    switch (LineControlPtr->ControlHandShake & SERIAL_OUT_HANDSHAKEMASK) {
+    case 0:
+
+        //
+        // Ignore CTS (an input pin). Since the IMX6 datasheet swaps the
+        // meaning of RTS and CTS, we set the "Ignore RTS bit", which
+        // really means to ignore CTS.
+        //
+        setMask |= IMX_UART_UCR2_IRTS;
+        break;
+
+    case SERIAL_CTS_HANDSHAKE:
+
+        //
+        // Pay attention to CTS. Since the IMX6 datasheet swaps the meaning
+        // of RTS and CTS, we clear the "Ignore RTS bit", which really means
+        // to pay attention to CTS.
+        //
+        if (!DeviceContextPtr->RtsCtsLinesEnabled) {
+            IMX_UART_LOG_ERROR(
+                "RTS/CTS flow control is not allowed on this UART instance "
+                "since RTS/CTS lines were not specified in the "
+                "SerialLinesEnabled mask in the UartSerialBus() connection "
+                "descriptor.");
+
+            return STATUS_INVALID_DEVICE_STATE;
+        }
+
+        clearMask |= IMX_UART_UCR2_IRTS;
+        break;
+
+    case SERIAL_DSR_HANDSHAKE:
+    case SERIAL_DCD_HANDSHAKE:
+    default:
+        IMX_UART_LOG_ERROR(
+            "Unsupported flow control setting. (LineControlPtr->ControlHandShake = 0x%lx)",
+            LineControlPtr->ControlHandShake);
+
+        return STATUS_NOT_SUPPORTED;
+    }
+
+    if ((LineControlPtr->ControlHandShake & ~SERIAL_OUT_HANDSHAKEMASK) != 0) {
+        IMX_UART_LOG_ERROR(
+            "Unsupported ControlHandShake flag. "
+            "(LineControlPtr->ControlHandShake = 0x%lx)",
+            LineControlPtr->ControlHandShake);
+
+        return STATUS_NOT_SUPPORTED;
+    }
+
+    //
+    // Handle RTS flow control. The receiver on this UART can optionally
+    // set the RTS pin - an output on this UART - depending on FIFO level.
+    // Or the user can control it manually with IOCTLs.
+    //
+    switch (LineControlPtr->FlowReplace & SERIAL_RTS_MASK) {
+    case 0:
+
+        //
+        // Treat no RTS setting the same as manual control
+        //
+        clearMask |= IMX_UART_UCR2_CTSC;
+        setMask |= IMX_UART_UCR2_CTS;
+        break;
+
+    case SERIAL_RTS_CONTROL:
+
+        if (!DeviceContextPtr->RtsCtsLinesEnabled) {
+            IMX_UART_LOG_WARNING(
+                "SERIAL_RTS_CONTROL was specified, but RTS/CTS were not "
+                "specified in the SerialLinesEnabled mask in the "
+                "UartSerialBus() connection descriptor, so RTS/CTS may not "
+                "be pinned out on this UART.");
+        }
+
+        //
+        // Enable the CTS bit to control the RTS line and ensure line is
+        // initially asserted.
+        //
         clearMask |= IMX_UART_UCR2_CTSC;
         setMask |= IMX_UART_UCR2_CTS;
         break;
 
-    case SERIAL_RTS_HANDSHAKE:
+    case SERIAL_RTS_HANDSHAKE:
+
+        if (!DeviceContextPtr->RtsCtsLinesEnabled) {
+            IMX_UART_LOG_WARNING(
+                "SERIAL_RTS_HANDSHAKE was specified, but RTS/CTS were not "
+                "specified in the SerialLinesEnabled mask in the "
+                "UartSerialBus() connection descriptor, so RTS/CTS may not "
+                "be pinned out on this UART.");
+        }
+
+        //
+        // Enable hardware control of the CTS (actually the RTS) line.
+        //
+        setMask |= IMX_UART_UCR2_CTSC;
+        break;
+
+    case SERIAL_TRANSMIT_TOGGLE:
+    default:
+        IMX_UART_LOG_ERROR(
+            "Unsupported RTS flow control value. "
+            "(LineControlPtr->FlowReplace = 0x%lx)",
+            LineControlPtr->FlowReplace);
+
+        return STATUS_NOT_SUPPORTED;
+    }
+
+    if ((LineControlPtr->FlowReplace & ~SERIAL_RTS_MASK) != 0) {
+        IMX_UART_LOG_ERROR(
+            "Unsupported FlowReplace flag. (LineControlPtr->FlowReplace = 0x%lx)",
+            LineControlPtr->FlowReplace);
+
+        return STATUS_NOT_SUPPORTED;
+    }
+
+    NT_ASSERT((setMask & clearMask) == 0);
+
+    //
+    // Ignore XonLimit/XoffLimit since we do not support Xon/Xoff flow control
+    //
+
+    IMX_UART_INTERRUPT_CONTEXT* interruptContextPtr =
+            DeviceContextPtr->InterruptContextPtr;
+
+    //
+    // Update UCR2 under the interrupt spinlock
+    //
+    {
+        WdfInterruptAcquireLock(interruptContextPtr->WdfInterrupt);
+
+        interruptContextPtr->Ucr2Copy &= ~clearMask;
+        interruptContextPtr->Ucr2Copy |= setMask;
+        WRITE_REGISTER_NOFENCE_ULONG(
+            &interruptContextPtr->RegistersPtr->Ucr2,
+            interruptContextPtr->Ucr2Copy);
+
+        DeviceContextPtr->CurrentFlowReplace = LineControlPtr->FlowReplace;
+        WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
+    }
+
+    return STATUS_SUCCESS;
+}
+
+
+_Use_decl_annotations_
+void
+IMXUartSetBreakOnOff (
+    IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
+    bool BreakOn
+    )
+{
+    IMX_UART_INTERRUPT_CONTEXT* interruptContextPtr =
+            DeviceContextPtr->InterruptContextPtr;
+
+    WdfInterruptAcquireLock(interruptContextPtr->WdfInterrupt);
+
+    if (BreakOn) {
+        interruptContextPtr->Ucr1Copy |= IMX_UART_UCR1_SNDBRK;
+    } else {
+        interruptContextPtr->Ucr1Copy &= ~IMX_UART_UCR1_SNDBRK;
+    }
+
+    WRITE_REGISTER_NOFENCE_ULONG(
+        &interruptContextPtr->RegistersPtr->Ucr1,
+        interruptContextPtr->Ucr1Copy);
+
+    WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
+
+    IMX_UART_LOG_TRACE("Set break state. (BreakOn = %d)", BreakOn);
+}
+
+
+_Use_decl_annotations_
+void
+IMXUartSetWaitMask (
+    IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
+    ULONG WaitMask
+    )
+{
+    IMX_UART_INTERRUPT_CONTEXT* interruptContextPtr =
+            DeviceContextPtr->InterruptContextPtr;
+
+    IMX_UART_REGISTERS* registersPtr =
+            interruptContextPtr->RegistersPtr;
+
+    //
+    // Mask of bits that changed from the old wait mask to the new wait mask
+    //
+    const ULONG waitMaskDifference = interruptContextPtr->WaitMask ^ WaitMask;
+
+    WdfInterruptAcquireLock(interruptContextPtr->WdfInterrupt);
+
+    //
+    // Nothing to do here for SERIAL_EV_RXCHAR or SERIAL_EV_ERR -
+    // the ISR handles everything
+    //
+
+    if ((waitMaskDifference & SERIAL_EV_BREAK) != 0) {
+        if ((WaitMask & SERIAL_EV_BREAK) != 0) {
+            interruptContextPtr->Ucr4Copy |= IMX_UART_UCR4_BKEN;
+            interruptContextPtr->Usr2EnabledInterruptsMask |= IMX_UART_USR2_BRCD;
+        } else {
+            interruptContextPtr->Ucr4Copy &= ~IMX_UART_UCR4_BKEN;
+            interruptContextPtr->Usr2EnabledInterruptsMask &= ~IMX_UART_USR2_BRCD;
+        }
+
+        WRITE_REGISTER_NOFENCE_ULONG(
+            &registersPtr->Ucr4,
+            interruptContextPtr->Ucr4Copy);
+
+        //
+        // Clear BRCD bit
+        //
+        WRITE_REGISTER_NOFENCE_ULONG(
+            &registersPtr->Usr2,
+            IMX_UART_USR2_BRCD);
+    }
+
+    if ((waitMaskDifference & SERIAL_EV_TXEMPTY) != 0) {
+        if ((WaitMask & SERIAL_EV_TXEMPTY) != 0) {
+            interruptContextPtr->Ucr1Copy |= IMX_UART_UCR1_TXMPTYEN;
+            interruptContextPtr->Usr2EnabledInterruptsMask |= IMX_UART_USR2_TXFE;
+            WRITE_REGISTER_NOFENCE_ULONG(
+                &registersPtr->Ucr1,
+                interruptContextPtr->Ucr1Copy);
+        } else {
+            // Always disabled by ISR
+        }
+    }
+
+    if ((waitMaskDifference & SERIAL_EV_CTS) != 0) {
+        if ((WaitMask & SERIAL_EV_CTS) != 0) {
+            interruptContextPtr->Ucr2Copy &= ~IMX_UART_UCR2_RTEC_MASK;
+            interruptContextPtr->Ucr2Copy |=
+                IMX_UART_UCR2_RTSEN | IMX_UART_UCR2_RTEC_BOTH;
+
+            interruptContextPtr->Usr2EnabledInterruptsMask |= IMX_UART_USR2_RTSF;
+        } else {
+            interruptContextPtr->Ucr2Copy &= ~IMX_UART_UCR2_RTSEN;
+            interruptContextPtr->Usr2EnabledInterruptsMask &= ~IMX_UART_USR2_RTSF;
+        }
+
+        WRITE_REGISTER_NOFENCE_ULONG(
+            &registersPtr->Ucr2,
+            interruptContextPtr->Ucr2Copy);
+
+        //
+        // Clear RTSF bit
+        //
+        WRITE_REGISTER_NOFENCE_ULONG(
+            &registersPtr->Usr2,
+            IMX_UART_USR2_RTSF);
+    }
+
+    interruptContextPtr->WaitMask = WaitMask;
+    interruptContextPtr->WaitEvents = 0;
+    WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
+
+    IMX_UART_LOG_TRACE("Successfully set wait mask. (WaitMask = 0x%lx)", WaitMask);
+}
+
+_Use_decl_annotations_
+VOID
+IMXUartIoctlSetBaudRate (
+    IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
+    WDFREQUEST WdfRequest
+    )
+{
+    NTSTATUS status = IMXUartCheckValidStateForConfigIoctl(DeviceContextPtr);
+    if (!NT_SUCCESS(status)) {
+        IMX_UART_LOG_WARNING(
+            "Behavior is undefined if baud is set while IO is active. (status = %!STATUS!)",
+            status);
+    }
+
+    SERIAL_BAUD_RATE* inputBufferPtr;
+    status = WdfRequestRetrieveInputBuffer(
+            WdfRequest,
+            sizeof(*inputBufferPtr),
+            reinterpret_cast<PVOID*>(&inputBufferPtr),
+            nullptr);
+
+    if (!NT_SUCCESS(status)) {
+        IMX_UART_LOG_ERROR(
+            "Failed to retreive input buffer for IOCTL_SERIAL_SET_BAUD_RATE request. (status = %!STATUS!)",
+            status);
+
+        WdfRequestComplete(WdfRequest, status);
+        return;
+    }
+
+    status = IMXUartSetBaudRate(DeviceContextPtr, inputBufferPtr->BaudRate);
+    if (!NT_SUCCESS(status)) {
+        WdfRequestComplete(WdfRequest, status);
+        return;
+    }
+
+    status = IMXUartUpdateDmaSettings(DeviceContextPtr);
+    WdfRequestComplete(WdfRequest, status);
+}
+
+_Use_decl_annotations_
+VOID
+IMXUartIoctlGetBaudRate (
+    const IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
+    WDFREQUEST WdfRequest
+    )
+{
+    SERIAL_BAUD_RATE* outputBufferPtr;
+    NTSTATUS status = WdfRequestRetrieveOutputBuffer(
+            WdfRequest,
+            sizeof(*outputBufferPtr),
+            reinterpret_cast<PVOID*>(&outputBufferPtr),
+            nullptr);
 
-        if (!DeviceContextPtr->RtsCtsLinesEnabled) {
-            IMX_UART_LOG_WARNING(
-                "SERIAL_RTS_HANDSHAKE was specified, but RTS/CTS were not "
-                "specified in the SerialLinesEnabled mask in the "
-                "UartSerialBus() connection descriptor, so RTS/CTS may not "
-                "be pinned out on this UART.");
+    if (!NT_SUCCESS(status)) {
+        IMX_UART_LOG_ERROR(
+            "Failed to retrieve output buffer for IOCTL_SERIAL_GET_BAUD_RATE request. (status = %!STATUS!)",
+            status);
+
+        WdfRequestComplete(WdfRequest, status);
+        return;
+    }
+
+    outputBufferPtr->BaudRate = DeviceContextPtr->CurrentBaudRate;
+    WdfRequestCompleteWithInformation(
+        WdfRequest,
+        STATUS_SUCCESS,
+        sizeof(*outputBufferPtr));
+}
+
+_Use_decl_annotations_
+void
+IMXUartIoctlSetLineControl (
+    IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
+    WDFREQUEST WdfRequest
+    )
+{
+    NTSTATUS status = IMXUartCheckValidStateForConfigIoctl(DeviceContextPtr);
+    if (!NT_SUCCESS(status)) {
+        IMX_UART_LOG_WARNING(
+            "Behavior is undefined if line control is modified while IO is active. (status = %!STATUS!)",
+            status);
+    }
+
+    SERIAL_LINE_CONTROL* inputBufferPtr;
+    status = WdfRequestRetrieveInputBuffer(
+            WdfRequest,
+            sizeof(*inputBufferPtr),
+            reinterpret_cast<PVOID*>(&inputBufferPtr),
+            nullptr);
+
+    if (!NT_SUCCESS(status)) {
+        IMX_UART_LOG_ERROR(
+            "Failed to retrieve input buffer for IOCTL_SERIAL_SET_LINE_CONTROL request. (status = %!STATUS!)",
+            status);
+
+        WdfRequestComplete(WdfRequest, status);
+        return;
+    }
+
+    status = IMXUartSetLineControl(DeviceContextPtr, inputBufferPtr);
+    WdfRequestComplete(WdfRequest, status);
+}
+
+_Use_decl_annotations_
+void
+IMXUartIoctlGetLineControl (
+    const IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
+    WDFREQUEST WdfRequest
+    )
+{
+    SERIAL_LINE_CONTROL* outputBufferPtr;
+    NTSTATUS status = WdfRequestRetrieveOutputBuffer(
+            WdfRequest,
+            sizeof(*outputBufferPtr),
+            reinterpret_cast<PVOID*>(&outputBufferPtr),
+            nullptr);
+
+    if (!NT_SUCCESS(status)) {
+        IMX_UART_LOG_ERROR(
+            "Failed to retrieve output buffer for IOCTL_SERIAL_GET_LINE_CONTROL request. (status = %!STATUS!)",
+            status);
+
+        WdfRequestComplete(WdfRequest, status);
+        return;
+    }
+
+    WdfInterruptAcquireLock(DeviceContextPtr->WdfInterrupt);
+    const ULONG ucr2 = DeviceContextPtr->InterruptContextPtr->Ucr2Copy;
+    WdfInterruptReleaseLock(DeviceContextPtr->WdfInterrupt);
+
+    if ((ucr2 & IMX_UART_UCR2_STPB) == 0) {
+        outputBufferPtr->StopBits = STOP_BIT_1;
+    } else {
+        outputBufferPtr->StopBits = STOP_BITS_2;
+    }
+
+    if ((ucr2 & IMX_UART_UCR2_PREN) == 0) {
+        outputBufferPtr->Parity = NO_PARITY;
+    } else {
+        if ((ucr2 & IMX_UART_UCR2_PROE) == 0) {
+            outputBufferPtr->Parity = EVEN_PARITY;
+        } else {
+            outputBufferPtr->Parity = ODD_PARITY;
         }
+    }
 
+    if ((ucr2 & IMX_UART_UCR2_WS) == 0) {
+        outputBufferPtr->WordLength = 7;
+    } else {
+        outputBufferPtr->WordLength = 8;
+    }
+
+    WdfRequestCompleteWithInformation(
+        WdfRequest,
+        STATUS_SUCCESS,
+        sizeof(*outputBufferPtr));
+}
+
+_Use_decl_annotations_
+void
+IMXUartIoctlSetHandflow (
+    IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
+    WDFREQUEST WdfRequest
+    )
+{
+    NTSTATUS status = IMXUartCheckValidStateForConfigIoctl(DeviceContextPtr);
+    if (!NT_SUCCESS(status)) {
         //
-        // Enable hardware control of the CTS (actually the RTS) line.
+        // This is a warning because the MITT tests set handflow after
+        // performing IO.
         //
-        setMask |= IMX_UART_UCR2_CTSC;
-        break;
+        IMX_UART_LOG_WARNING(
+            "Behavior is undefined if line control is set after IO has been started. (status = %!STATUS!)",
+            status);
+    }
 
-    case SERIAL_TRANSMIT_TOGGLE:
-    default:
+    SERIAL_HANDFLOW* inputBufferPtr;
+    status = WdfRequestRetrieveInputBuffer(
+            WdfRequest,
+            sizeof(*inputBufferPtr),
+            reinterpret_cast<PVOID*>(&inputBufferPtr),
+            nullptr);
+
+    if (!NT_SUCCESS(status)) {
         IMX_UART_LOG_ERROR(
-            "Unsupported RTS flow control value. "
-            "(LineControlPtr->FlowReplace = 0x%lx)",
-            LineControlPtr->FlowReplace);
+            "Failed to retrieve input buffer for IOCTL_SERIAL_SET_HANDFLOW request. (status = %!STATUS!)",
+            status);
 
-        return STATUS_NOT_SUPPORTED;
+        WdfRequestComplete(WdfRequest, status);
+        return;
     }
 
-    if ((LineControlPtr->FlowReplace & ~SERIAL_RTS_MASK) != 0) {
+    status = IMXUartSetHandflow(DeviceContextPtr, inputBufferPtr);
+    if (!NT_SUCCESS(status)) {
         IMX_UART_LOG_ERROR(
-            "Unsupported FlowReplace flag. (LineControlPtr->FlowReplace = 0x%lx)",
-            LineControlPtr->FlowReplace);
+            "Failed to set handflow. (status = %!STATUS!)",
+            status);
 
-        return STATUS_NOT_SUPPORTED;
+        WdfRequestComplete(WdfRequest, status);
+        return;
     }
 
-    NT_ASSERT((setMask & clearMask) == 0);
+    WdfRequestComplete(WdfRequest, STATUS_SUCCESS);
+}
 
-    //
-    // Ignore XonLimit/XoffLimit since we do not support Xon/Xoff flow control
-    //
+_Use_decl_annotations_
+void
+IMXUartIoctlGetHandflow (
+    const IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
+    WDFREQUEST WdfRequest
+    )
+{
+    SERIAL_HANDFLOW* outputBufferPtr;
+    NTSTATUS status = WdfRequestRetrieveOutputBuffer(
+            WdfRequest,
+            sizeof(*outputBufferPtr),
+            reinterpret_cast<PVOID*>(&outputBufferPtr),
+            nullptr);
 
-    IMX_UART_INTERRUPT_CONTEXT* interruptContextPtr =
-            DeviceContextPtr->InterruptContextPtr;
+    if (!NT_SUCCESS(status)) {
+        IMX_UART_LOG_ERROR(
+            "Failed to retrieve output buffer for IOCTL_SERIAL_GET_HANDFLOW request. (status = %!STATUS!)",
+            status);
+
+        WdfRequestComplete(WdfRequest, status);
+        return;
+    }
+
+    WdfInterruptAcquireLock(DeviceContextPtr->WdfInterrupt);
+    const ULONG ucr2 = DeviceContextPtr->InterruptContextPtr->Ucr2Copy;
+    WdfInterruptReleaseLock(DeviceContextPtr->WdfInterrupt);
+
+    *outputBufferPtr = SERIAL_HANDFLOW();
 
     //
-    // Update UCR2 under the interrupt spinlock
+    // If the Ignore RTS bit (which is really the Ignore CTS bit) is
+    // NOT set, then the controller is paying attention to CTS, which
+    // means we're using CTS handshaking.
     //
-    {
-        WdfInterruptAcquireLock(interruptContextPtr->WdfInterrupt);
+    if ((ucr2 & IMX_UART_UCR2_IRTS) == 0) {
+        outputBufferPtr->ControlHandShake |= SERIAL_CTS_HANDSHAKE;
+    }
 
-        interruptContextPtr->Ucr2Copy &= ~clearMask;
-        interruptContextPtr->Ucr2Copy |= setMask;
-        WRITE_REGISTER_NOFENCE_ULONG(
-            &interruptContextPtr->RegistersPtr->Ucr2,
-            interruptContextPtr->Ucr2Copy);
+    if ((ucr2 & IMX_UART_UCR2_CTSC) != 0) {
+
+        //
+        // If the CTS Pin control bit (which is really the RTS pin control bit)
+        // is set, it means RTS is automatically controlled by hardware.
+        //
+        outputBufferPtr->FlowReplace |= SERIAL_RTS_HANDSHAKE;
+
+    } else {
+        if ((DeviceContextPtr->CurrentFlowReplace & SERIAL_RTS_MASK) ==
+             SERIAL_RTS_CONTROL)
+        {
+            //
+            // If the CTS Pin control bit (which is really the RTS pin control bit)
+            // is clear, it means RTS is under manual control.
+            //
+            outputBufferPtr->FlowReplace |= SERIAL_RTS_CONTROL;
+        }
+    }
+
+    WdfRequestCompleteWithInformation(
+        WdfRequest,
+        STATUS_SUCCESS,
+        sizeof(*outputBufferPtr));
+}
+
+_Use_decl_annotations_
+void
+IMXUartIoctlGetProperties (
+    const IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
+    WDFREQUEST WdfRequest
+    )
+{
+    SERIAL_COMMPROP* outputBufferPtr;
+    NTSTATUS status = WdfRequestRetrieveOutputBuffer(
+            WdfRequest,
+            sizeof(*outputBufferPtr),
+            reinterpret_cast<PVOID*>(&outputBufferPtr),
+            nullptr);
 
-        DeviceContextPtr->CurrentFlowReplace = LineControlPtr->FlowReplace;
-        WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
+    if (!NT_SUCCESS(status)) {
+        IMX_UART_LOG_ERROR(
+            "Failed to retrieve output buffer for IOCTL_SERIAL_GET_PROPERTIES request. (status = %!STATUS!)",
+            status);
+
+        WdfRequestComplete(WdfRequest, status);
+        return;
     }
 
-    return STATUS_SUCCESS;
-}
+    const IMX_UART_INTERRUPT_CONTEXT* interruptContextPtr =
+            DeviceContextPtr->InterruptContextPtr;
 
+    *outputBufferPtr = SERIAL_COMMPROP();
 
-_Use_decl_annotations_
-void
-IMXUartSetBreakOnOff (
-    IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
-    bool BreakOn
-    )
-{
-    IMX_UART_INTERRUPT_CONTEXT* interruptContextPtr =
-            DeviceContextPtr->InterruptContextPtr;
+    outputBufferPtr->PacketLength = sizeof(*outputBufferPtr);
+    outputBufferPtr->PacketVersion = 2;
+    outputBufferPtr->ServiceMask = SERIAL_SP_SERIALCOMM;
+    outputBufferPtr->MaxTxQueue = interruptContextPtr->TxBuffer.Capacity();
+    outputBufferPtr->MaxRxQueue = interruptContextPtr->RxBuffer.Capacity();
+    outputBufferPtr->MaxBaud =
+        DeviceContextPtr->Parameters.ModuleClockFrequency / 16;
 
-    WdfInterruptAcquireLock(interruptContextPtr->WdfInterrupt);
+    outputBufferPtr->ProvSubType = SERIAL_SP_RS232;
+    outputBufferPtr->ProvCapabilities =
+        SERIAL_PCF_RTSCTS |
+        SERIAL_PCF_PARITY_CHECK |
+        SERIAL_PCF_TOTALTIMEOUTS |
+        SERIAL_PCF_INTTIMEOUTS;
 
-    if (BreakOn) {
-        interruptContextPtr->Ucr1Copy |= IMX_UART_UCR1_SNDBRK;
-    } else {
-        interruptContextPtr->Ucr1Copy &= ~IMX_UART_UCR1_SNDBRK;
-    }
+    outputBufferPtr->SettableParams =
+        SERIAL_SP_PARITY |
+        SERIAL_SP_BAUD |
+        SERIAL_SP_DATABITS |
+        SERIAL_SP_STOPBITS |
+        SERIAL_SP_HANDSHAKING |
+        SERIAL_SP_PARITY_CHECK;
 
-    WRITE_REGISTER_NOFENCE_ULONG(
-        &interruptContextPtr->RegistersPtr->Ucr1,
-        interruptContextPtr->Ucr1Copy);
+    outputBufferPtr->SettableBaud = SERIAL_BAUD_USER;
+    outputBufferPtr->SettableData = SERIAL_DATABITS_7 | SERIAL_DATABITS_8;
+    outputBufferPtr->SettableStopParity =
+        SERIAL_STOPBITS_10 |
+        SERIAL_STOPBITS_20 |
+        SERIAL_PARITY_NONE |
+        SERIAL_PARITY_ODD |
+        SERIAL_PARITY_EVEN;
 
-    WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
+    outputBufferPtr->CurrentTxQueue = 0;
+    outputBufferPtr->CurrentRxQueue = 0;
 
-    IMX_UART_LOG_TRACE("Set break state. (BreakOn = %d)", BreakOn);
+    WdfRequestCompleteWithInformation(
+        WdfRequest,
+        STATUS_SUCCESS,
+        sizeof(*outputBufferPtr));
 }
 
-
 _Use_decl_annotations_
 void
-IMXUartSetWaitMask (
-    IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
-    ULONG WaitMask
+IMXUartIoctlGetCommStatus (
+    const IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
+    WDFREQUEST WdfRequest
     )
 {
+    SERIAL_STATUS* outputBufferPtr;
+    NTSTATUS status = WdfRequestRetrieveOutputBuffer(
+            WdfRequest,
+            sizeof(*outputBufferPtr),
+            reinterpret_cast<PVOID*>(&outputBufferPtr),
+            nullptr);
+
+    if (!NT_SUCCESS(status)) {
+        IMX_UART_LOG_ERROR(
+            "Failed to retrieve output buffer for IOCTL_SERIAL_GET_COMMSTATUS request. (status = %!STATUS!)",
+            status);
+
+        WdfRequestComplete(WdfRequest, status);
+        return;
+    }
+
     IMX_UART_INTERRUPT_CONTEXT* interruptContextPtr =
             DeviceContextPtr->InterruptContextPtr;
 
-    IMX_UART_REGISTERS* registersPtr =
-            interruptContextPtr->RegistersPtr;
+    *outputBufferPtr = SERIAL_STATUS();
 
     //
-    // Mask of bits that changed from the old wait mask to the new wait mask
+    // Read and reset error mask
     //
-    const ULONG waitMaskDifference = interruptContextPtr->WaitMask ^ WaitMask;
-
-    WdfInterruptAcquireLock(interruptContextPtr->WdfInterrupt);
+    {
+        WdfInterruptAcquireLock(interruptContextPtr->WdfInterrupt);
+        outputBufferPtr->Errors = interruptContextPtr->CommStatusErrors;
+        interruptContextPtr->CommStatusErrors = 0;
+        WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
+    }
 
     //
-    // Nothing to do here for SERIAL_EV_RXCHAR or SERIAL_EV_ERR -
-    // the ISR handles everything
+    // If output CTS flow control is on, check the status of the RTSS bit
+    // (which really indicates states of CTS pin)
     //
+    if ((interruptContextPtr->Ucr2Copy & IMX_UART_UCR2_IRTS) == 0) {
+        const ULONG usr1 = READ_REGISTER_NOFENCE_ULONG(
+                &interruptContextPtr->RegistersPtr->Usr1);
 
-    if ((waitMaskDifference & SERIAL_EV_BREAK) != 0) {
-        if ((WaitMask & SERIAL_EV_BREAK) != 0) {
-            interruptContextPtr->Ucr4Copy |= IMX_UART_UCR4_BKEN;
-            interruptContextPtr->Usr2EnabledInterruptsMask |= IMX_UART_USR2_BRCD;
-        } else {
-            interruptContextPtr->Ucr4Copy &= ~IMX_UART_UCR4_BKEN;
-            interruptContextPtr->Usr2EnabledInterruptsMask &= ~IMX_UART_USR2_BRCD;
-        }
-
-        WRITE_REGISTER_NOFENCE_ULONG(
-            &registersPtr->Ucr4,
-            interruptContextPtr->Ucr4Copy);
-
-        //
-        // Clear BRCD bit
-        //
-        WRITE_REGISTER_NOFENCE_ULONG(
-            &registersPtr->Usr2,
-            IMX_UART_USR2_BRCD);
-    }
-
-    if ((waitMaskDifference & SERIAL_EV_TXEMPTY) != 0) {
-        if ((WaitMask & SERIAL_EV_TXEMPTY) != 0) {
-            interruptContextPtr->Ucr1Copy |= IMX_UART_UCR1_TXMPTYEN;
-            interruptContextPtr->Usr2EnabledInterruptsMask |= IMX_UART_USR2_TXFE;
-            WRITE_REGISTER_NOFENCE_ULONG(
-                &registersPtr->Ucr1,
-                interruptContextPtr->Ucr1Copy);
-        } else {
-            // Always disabled by ISR
+        if ((usr1 & IMX_UART_USR1_RTSS) != 0) {
+            outputBufferPtr->HoldReasons |= SERIAL_TX_WAITING_FOR_CTS;
         }
     }
 
-    if ((waitMaskDifference & SERIAL_EV_CTS) != 0) {
-        if ((WaitMask & SERIAL_EV_CTS) != 0) {
-            interruptContextPtr->Ucr2Copy &= ~IMX_UART_UCR2_RTEC_MASK;
-            interruptContextPtr->Ucr2Copy |=
-                IMX_UART_UCR2_RTSEN | IMX_UART_UCR2_RTEC_BOTH;
-
-            interruptContextPtr->Usr2EnabledInterruptsMask |= IMX_UART_USR2_RTSF;
-        } else {
-            interruptContextPtr->Ucr2Copy &= ~IMX_UART_UCR2_RTSEN;
-            interruptContextPtr->Usr2EnabledInterruptsMask &= ~IMX_UART_USR2_RTSF;
-        }
-
-        WRITE_REGISTER_NOFENCE_ULONG(
-            &registersPtr->Ucr2,
-            interruptContextPtr->Ucr2Copy);
-
-        //
-        // Clear RTSF bit
-        //
-        WRITE_REGISTER_NOFENCE_ULONG(
-            &registersPtr->Usr2,
-            IMX_UART_USR2_RTSF);
+    //
+    // Check if break is currently in progress
+    //
+    if ((interruptContextPtr->Ucr1Copy & IMX_UART_UCR1_SNDBRK) != 0) {
+        outputBufferPtr->HoldReasons |= SERIAL_TX_WAITING_ON_BREAK;
     }
 
-    interruptContextPtr->WaitMask = WaitMask;
-    interruptContextPtr->WaitEvents = 0;
-    WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
+    outputBufferPtr->AmountInInQueue = 0;
+    outputBufferPtr->AmountInOutQueue = interruptContextPtr->TxBuffer.Count();
+    outputBufferPtr->EofReceived = FALSE;
+    outputBufferPtr->WaitForImmediate = FALSE;
 
-    IMX_UART_LOG_TRACE("Successfully set wait mask. (WaitMask = 0x%lx)", WaitMask);
+    WdfRequestCompleteWithInformation(
+        WdfRequest,
+        STATUS_SUCCESS,
+        sizeof(*outputBufferPtr));
 }
 
 _Use_decl_annotations_
-VOID
-IMXUartIoctlSetBaudRate (
-    IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
+void
+IMXUartIoctlGetModemStatus (
+    const IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
     WDFREQUEST WdfRequest
     )
 {
-    NTSTATUS status = IMXUartCheckValidStateForConfigIoctl(DeviceContextPtr);
-    if (!NT_SUCCESS(status)) {
-        IMX_UART_LOG_WARNING(
-            "Behavior is undefined if baud is set while IO is active. (status = %!STATUS!)",
-            status);
-    }
+    //
+    // Define locally so we are less likely to conflict with future
+    // public definitions.
+    //
+    enum SERIAL_MSR : ULONG {
+        //
+        // This bit is the delta clear to send.  It is used to indicate
+        // that the clear to send bit (in this register) has *changed*
+        // since this register was last read by the CPU.
+        //
+        SERIAL_MSR_DCTS = 0x01,
 
-    SERIAL_BAUD_RATE* inputBufferPtr;
-    status = WdfRequestRetrieveInputBuffer(
-            WdfRequest,
-            sizeof(*inputBufferPtr),
-            reinterpret_cast<PVOID*>(&inputBufferPtr),
-            nullptr);
+        //
+        // This bit is the delta data set ready.  It is used to indicate
+        // that the data set ready bit (in this register) has *changed*
+        // since this register was last read by the CPU.
+        //
+        SERIAL_MSR_DDSR = 0x02,
 
-    if (!NT_SUCCESS(status)) {
-        IMX_UART_LOG_ERROR(
-            "Failed to retreive input buffer for IOCTL_SERIAL_SET_BAUD_RATE request. (status = %!STATUS!)",
-            status);
+        //
+        // This is the trailing edge ring indicator.  It is used to indicate
+        // that the ring indicator input has changed from a low to high state.
+        //
+        SERIAL_MSR_TERI = 0x04,
 
-        WdfRequestComplete(WdfRequest, status);
-        return;
-    }
+        //
+        // This bit is the delta data carrier detect.  It is used to indicate
+        // that the data carrier bit (in this register) has *changed*
+        // since this register was last read by the CPU.
+        //
+        SERIAL_MSR_DDCD = 0x08,
 
-    status = IMXUartSetBaudRate(DeviceContextPtr, inputBufferPtr->BaudRate);
-    if (!NT_SUCCESS(status)) {
-        WdfRequestComplete(WdfRequest, status);
-        return;
-    }
+        //
+        // This bit contains the (complemented) state of the clear to send
+        // (CTS) line.
+        //
+        SERIAL_MSR_CTS = 0x10,
+
+        //
+        // This bit contains the (complemented) state of the data set ready
+        // (DSR) line.
+        //
+        SERIAL_MSR_DSR = 0x20,
+
+        //
+        // This bit contains the (complemented) state of the ring indicator
+        // (RI) line.
+        //
+        SERIAL_MSR_RI = 0x40,
 
-    status = IMXUartUpdateDmaSettings(DeviceContextPtr);
-    WdfRequestComplete(WdfRequest, status);
-}
+        //
+        // This bit contains the (complemented) state of the data carrier detect
+        // (DCD) line.
+        //
+        SERIAL_MSR_DCD = 0x80,
+    };
 
-_Use_decl_annotations_
-VOID
-IMXUartIoctlGetBaudRate (
-    const IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
-    WDFREQUEST WdfRequest
-    )
-{
-    SERIAL_BAUD_RATE* outputBufferPtr;
+    ULONG* outputBufferPtr;
     NTSTATUS status = WdfRequestRetrieveOutputBuffer(
             WdfRequest,
             sizeof(*outputBufferPtr),
@@ -3856,14 +5369,37 @@ IMXUartIoctlGetBaudRate (
 
     if (!NT_SUCCESS(status)) {
         IMX_UART_LOG_ERROR(
-            "Failed to retrieve output buffer for IOCTL_SERIAL_GET_BAUD_RATE request. (status = %!STATUS!)",
+            "Failed to retrieve output buffer for IOCTL_SERIAL_GET_MODEMSTATUS request. (status = %!STATUS!)",
             status);
 
         WdfRequestComplete(WdfRequest, status);
         return;
     }
 
-    outputBufferPtr->BaudRate = DeviceContextPtr->CurrentBaudRate;
+    ULONG msr = 0;
+
+    const ULONG usr1 = READ_REGISTER_NOFENCE_ULONG(
+            &DeviceContextPtr->RegistersPtr->Usr1);
+
+    //
+    // Check the RTS Delta bit (aka. CTS delta bit), and clear bit by writing 1
+    //
+    if ((usr1 & IMX_UART_USR1_RTSD) != 0) {
+        msr |= SERIAL_MSR_DCTS;
+
+        WRITE_REGISTER_NOFENCE_ULONG(
+            &DeviceContextPtr->RegistersPtr->Usr1,
+            IMX_UART_USR1_RTSD);
+    }
+
+    //
+    // Read current RTS (aka. CTS) status
+    //
+    if ((usr1 & IMX_UART_USR1_RTSS) != 0) {
+        msr |= SERIAL_MSR_CTS;
+    }
+
+    *outputBufferPtr = msr;
     WdfRequestCompleteWithInformation(
         WdfRequest,
         STATUS_SUCCESS,
@@ -3872,46 +5408,53 @@ IMXUartIoctlGetBaudRate (
 
 _Use_decl_annotations_
 void
-IMXUartIoctlSetLineControl (
+IMXUartIoctlSetClrRts (
     IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
-    WDFREQUEST WdfRequest
+    WDFREQUEST WdfRequest,
+    bool RtsState
     )
 {
-    NTSTATUS status = IMXUartCheckValidStateForConfigIoctl(DeviceContextPtr);
-    if (!NT_SUCCESS(status)) {
-        IMX_UART_LOG_WARNING(
-            "Behavior is undefined if line control is modified while IO is active. (status = %!STATUS!)",
-            status);
-    }
+    IMX_UART_INTERRUPT_CONTEXT* interruptContextPtr =
+            DeviceContextPtr->InterruptContextPtr;
 
-    SERIAL_LINE_CONTROL* inputBufferPtr;
-    status = WdfRequestRetrieveInputBuffer(
-            WdfRequest,
-            sizeof(*inputBufferPtr),
-            reinterpret_cast<PVOID*>(&inputBufferPtr),
-            nullptr);
+    WdfInterruptAcquireLock(interruptContextPtr->WdfInterrupt);
 
-    if (!NT_SUCCESS(status)) {
+    //
+    // Only allowed when CTSC is clear
+    //
+    if ((interruptContextPtr->Ucr2Copy & IMX_UART_UCR2_CTSC) != 0) {
+        WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
         IMX_UART_LOG_ERROR(
-            "Failed to retrieve input buffer for IOCTL_SERIAL_SET_LINE_CONTROL request. (status = %!STATUS!)",
-            status);
+            "Attempted to set state of RTS pin when manual RTS control is not enabled. "
+            "(interruptContextPtr->Ucr2Copy = 0x%lx)",
+            interruptContextPtr->Ucr2Copy);
 
-        WdfRequestComplete(WdfRequest, status);
+        WdfRequestComplete(WdfRequest, STATUS_INVALID_PARAMETER);
         return;
     }
 
-    status = IMXUartSetLineControl(DeviceContextPtr, inputBufferPtr);
-    WdfRequestComplete(WdfRequest, status);
+    if (RtsState) {
+        interruptContextPtr->Ucr2Copy |= IMX_UART_UCR2_CTS;
+    } else {
+        interruptContextPtr->Ucr2Copy &= ~IMX_UART_UCR2_CTS;
+    }
+
+    WRITE_REGISTER_NOFENCE_ULONG(
+        &interruptContextPtr->RegistersPtr->Ucr2,
+        interruptContextPtr->Ucr2Copy);
+
+    WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
+    WdfRequestComplete(WdfRequest, STATUS_SUCCESS);
 }
 
 _Use_decl_annotations_
 void
-IMXUartIoctlGetLineControl (
+IMXUartIoctlGetDtrRts (
     const IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
     WDFREQUEST WdfRequest
     )
 {
-    SERIAL_LINE_CONTROL* outputBufferPtr;
+    ULONG* outputBufferPtr;
     NTSTATUS status = WdfRequestRetrieveOutputBuffer(
             WdfRequest,
             sizeof(*outputBufferPtr),
@@ -3920,39 +5463,23 @@ IMXUartIoctlGetLineControl (
 
     if (!NT_SUCCESS(status)) {
         IMX_UART_LOG_ERROR(
-            "Failed to retrieve output buffer for IOCTL_SERIAL_GET_LINE_CONTROL request. (status = %!STATUS!)",
+            "Failed to retrieve output buffer for IOCTL_SERIAL_GET_DTRRTS request. (status = %!STATUS!)",
             status);
 
         WdfRequestComplete(WdfRequest, status);
         return;
     }
 
-    WdfInterruptAcquireLock(DeviceContextPtr->WdfInterrupt);
-    const ULONG ucr2 = DeviceContextPtr->InterruptContextPtr->Ucr2Copy;
-    WdfInterruptReleaseLock(DeviceContextPtr->WdfInterrupt);
-
-    if ((ucr2 & IMX_UART_UCR2_STPB) == 0) {
-        outputBufferPtr->StopBits = STOP_BIT_1;
-    } else {
-        outputBufferPtr->StopBits = STOP_BITS_2;
-    }
+    const IMX_UART_INTERRUPT_CONTEXT* interruptContextPtr =
+            DeviceContextPtr->InterruptContextPtr;
 
-    if ((ucr2 & IMX_UART_UCR2_PREN) == 0) {
-        outputBufferPtr->Parity = NO_PARITY;
-    } else {
-        if ((ucr2 & IMX_UART_UCR2_PROE) == 0) {
-            outputBufferPtr->Parity = EVEN_PARITY;
-        } else {
-            outputBufferPtr->Parity = ODD_PARITY;
-        }
-    }
+    ULONG mask = 0;
 
-    if ((ucr2 & IMX_UART_UCR2_WS) == 0) {
-        outputBufferPtr->WordLength = 7;
-    } else {
-        outputBufferPtr->WordLength = 8;
+    if ((interruptContextPtr->Ucr2Copy & IMX_UART_UCR2_CTS) != 0) {
+        mask |= SERIAL_RTS_STATE;
     }
 
+    *outputBufferPtr = mask;
     WdfRequestCompleteWithInformation(
         WdfRequest,
         STATUS_SUCCESS,
@@ -3961,59 +5488,66 @@ IMXUartIoctlGetLineControl (
 
 _Use_decl_annotations_
 void
-IMXUartIoctlSetHandflow (
+IMXUartIoctlSetBreakOnOff (
     IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
-    WDFREQUEST WdfRequest
+    WDFREQUEST WdfRequest,
+    bool BreakOn
     )
 {
-    NTSTATUS status = IMXUartCheckValidStateForConfigIoctl(DeviceContextPtr);
-    if (!NT_SUCCESS(status)) {
-        //
-        // This is a warning because the MITT tests set handflow after
-        // performing IO.
-        //
-        IMX_UART_LOG_WARNING(
-            "Behavior is undefined if line control is set after IO has been started. (status = %!STATUS!)",
-            status);
-    }
-
-    SERIAL_HANDFLOW* inputBufferPtr;
-    status = WdfRequestRetrieveInputBuffer(
-            WdfRequest,
-            sizeof(*inputBufferPtr),
-            reinterpret_cast<PVOID*>(&inputBufferPtr),
-            nullptr);
-
-    if (!NT_SUCCESS(status)) {
-        IMX_UART_LOG_ERROR(
-            "Failed to retrieve input buffer for IOCTL_SERIAL_SET_HANDFLOW request. (status = %!STATUS!)",
-            status);
-
-        WdfRequestComplete(WdfRequest, status);
-        return;
-    }
-
-    status = IMXUartSetHandflow(DeviceContextPtr, inputBufferPtr);
-    if (!NT_SUCCESS(status)) {
-        IMX_UART_LOG_ERROR(
-            "Failed to set handflow. (status = %!STATUS!)",
-            status);
-
-        WdfRequestComplete(WdfRequest, status);
-        return;
-    }
-
+    IMXUartSetBreakOnOff(DeviceContextPtr, BreakOn);
     WdfRequestComplete(WdfRequest, STATUS_SUCCESS);
 }
 
 _Use_decl_annotations_
 void
-IMXUartIoctlGetHandflow (
+IMXUartIoctlGetModemControl (
     const IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
     WDFREQUEST WdfRequest
     )
 {
-    SERIAL_HANDFLOW* outputBufferPtr;
+    //
+    // These masks define access the modem control register.
+    // Define locally to avoid conflict with potential future public definition.
+    //
+    enum SERIAL_MCR : ULONG {
+
+        //
+        // This bit controls the data terminal ready (DTR) line.  When
+        // this bit is set the line goes to logic 0 (which is then inverted
+        // by normal hardware).  This is normally used to indicate that
+        // the device is available to be used.  Some odd hardware
+        // protocols (like the kernel debugger) use this for handshaking
+        // purposes.
+        //
+        SERIAL_MCR_DTR = 0x01,
+
+        //
+        // This bit controls the ready to send (RTS) line.  When this bit
+        // is set the line goes to logic 0 (which is then inverted by the normal
+        // hardware).  This is used for hardware handshaking.  It indicates that
+        // the hardware is ready to send data and it is waiting for the
+        // receiving end to set clear to send (CTS).
+        //
+        SERIAL_MCR_RTS = 0x02,
+
+        //
+        // This bit is used for general purpose output.
+        //
+        SERIAL_MCR_OUT1 = 0x04,
+
+        //
+        // This bit is used for general purpose output.
+        //
+        SERIAL_MCR_OUT2 = 0x08,
+
+        //
+        // This bit controls the loopback testing mode of the device.  Basically
+        // the outputs are connected to the inputs (and vice versa).
+        //
+        SERIAL_MCR_LOOP = 0x10,
+    };
+
+    ULONG* outputBufferPtr;
     NTSTATUS status = WdfRequestRetrieveOutputBuffer(
             WdfRequest,
             sizeof(*outputBufferPtr),
@@ -4022,48 +5556,23 @@ IMXUartIoctlGetHandflow (
 
     if (!NT_SUCCESS(status)) {
         IMX_UART_LOG_ERROR(
-            "Failed to retrieve output buffer for IOCTL_SERIAL_GET_HANDFLOW request. (status = %!STATUS!)",
+            "Failed to retrieve output buffer for IOCTL_SERIAL_GET_MODEM_CONTROL request. (status = %!STATUS!)",
             status);
 
         WdfRequestComplete(WdfRequest, status);
         return;
     }
 
-    WdfInterruptAcquireLock(DeviceContextPtr->WdfInterrupt);
-    const ULONG ucr2 = DeviceContextPtr->InterruptContextPtr->Ucr2Copy;
-    WdfInterruptReleaseLock(DeviceContextPtr->WdfInterrupt);
-
-    *outputBufferPtr = SERIAL_HANDFLOW();
-
-    //
-    // If the Ignore RTS bit (which is really the Ignore CTS bit) is
-    // NOT set, then the controller is paying attention to CTS, which
-    // means we're using CTS handshaking.
-    //
-    if ((ucr2 & IMX_UART_UCR2_IRTS) == 0) {
-        outputBufferPtr->ControlHandShake |= SERIAL_CTS_HANDSHAKE;
-    }
-
-    if ((ucr2 & IMX_UART_UCR2_CTSC) != 0) {
-
-        //
-        // If the CTS Pin control bit (which is really the RTS pin control bit)
-        // is set, it means RTS is automatically controlled by hardware.
-        //
-        outputBufferPtr->FlowReplace |= SERIAL_RTS_HANDSHAKE;
-
-    } else {
-        if ((DeviceContextPtr->CurrentFlowReplace & SERIAL_RTS_MASK) ==
-             SERIAL_RTS_CONTROL)
-        {
-            //
-            // If the CTS Pin control bit (which is really the RTS pin control bit)
-            // is clear, it means RTS is under manual control.
-            //
-            outputBufferPtr->FlowReplace |= SERIAL_RTS_CONTROL;
-        }
+    const IMX_UART_INTERRUPT_CONTEXT* interruptContextPtr =
+            DeviceContextPtr->InterruptContextPtr;
+
+    ULONG mcr = 0;
+
+    if ((interruptContextPtr->Ucr2Copy & IMX_UART_UCR2_CTS) != 0) {
+        mcr |= SERIAL_MCR_RTS;
     }
 
+    *outputBufferPtr = mcr;
     WdfRequestCompleteWithInformation(
         WdfRequest,
         STATUS_SUCCESS,
@@ -4072,12 +5581,12 @@ IMXUartIoctlGetHandflow (
 
 _Use_decl_annotations_
 void
-IMXUartIoctlGetProperties (
+IMXUartIoctlGetStatistics (
     const IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
     WDFREQUEST WdfRequest
     )
 {
-    SERIAL_COMMPROP* outputBufferPtr;
+    IMX_UART_STATISTICS* outputBufferPtr;
     NTSTATUS status = WdfRequestRetrieveOutputBuffer(
             WdfRequest,
             sizeof(*outputBufferPtr),
@@ -4086,7 +5595,7 @@ IMXUartIoctlGetProperties (
 
     if (!NT_SUCCESS(status)) {
         IMX_UART_LOG_ERROR(
-            "Failed to retrieve output buffer for IOCTL_SERIAL_GET_PROPERTIES request. (status = %!STATUS!)",
+            "Failed to retrieve output buffer for IOCTL_IMX_UART_GET_STATISTICS request. (status = %!STATUS!)",
             status);
 
         WdfRequestComplete(WdfRequest, status);
@@ -4096,43 +5605,35 @@ IMXUartIoctlGetProperties (
     const IMX_UART_INTERRUPT_CONTEXT* interruptContextPtr =
             DeviceContextPtr->InterruptContextPtr;
 
-    *outputBufferPtr = SERIAL_COMMPROP();
+    //
+    // Take a consistent snapshot of the counters maintained by the ISR
+    //
+    IMX_UART_STATISTICS statistics;
+    ULONG ufcr;
+    bool adaptive;
+    {
+        WdfInterruptAcquireLock(DeviceContextPtr->WdfInterrupt);
+        statistics = interruptContextPtr->Statistics;
+        ufcr = interruptContextPtr->UfcrCopy;
+        adaptive = interruptContextPtr->FifoTuning.Enabled;
+        WdfInterruptReleaseLock(DeviceContextPtr->WdfInterrupt);
+    }
 
-    outputBufferPtr->PacketLength = sizeof(*outputBufferPtr);
-    outputBufferPtr->PacketVersion = 2;
-    outputBufferPtr->ServiceMask = SERIAL_SP_SERIALCOMM;
-    outputBufferPtr->MaxTxQueue = interruptContextPtr->TxBuffer.Capacity();
-    outputBufferPtr->MaxRxQueue = interruptContextPtr->RxBuffer.Capacity();
-    outputBufferPtr->MaxBaud =
-        DeviceContextPtr->Parameters.ModuleClockFrequency / 16;
+    statistics.RxBytesPerInterrupt = (statistics.RxInterruptCount != 0) ?
+        ULONG(statistics.RxByteCount / statistics.RxInterruptCount) : 0;
 
-    outputBufferPtr->ProvSubType = SERIAL_SP_RS232;
-    outputBufferPtr->ProvCapabilities =
-        SERIAL_PCF_RTSCTS |
-        SERIAL_PCF_PARITY_CHECK |
-        SERIAL_PCF_TOTALTIMEOUTS |
-        SERIAL_PCF_INTTIMEOUTS;
+    statistics.TxBytesPerInterrupt = (statistics.TxInterruptCount != 0) ?
+        ULONG(statistics.TxByteCount / statistics.TxInterruptCount) : 0;
 
-    outputBufferPtr->SettableParams =
-        SERIAL_SP_PARITY |
-        SERIAL_SP_BAUD |
-        SERIAL_SP_DATABITS |
-        SERIAL_SP_STOPBITS |
-        SERIAL_SP_HANDSHAKING |
-        SERIAL_SP_PARITY_CHECK;
+    statistics.RxFifoThreshold =
+        (ufcr & IMX_UART_UFCR_RXTL_MASK) >> IMX_UART_UFCR_RXTL_SHIFT;
 
-    outputBufferPtr->SettableBaud = SERIAL_BAUD_USER;
-    outputBufferPtr->SettableData = SERIAL_DATABITS_7 | SERIAL_DATABITS_8;
-    outputBufferPtr->SettableStopParity =
-        SERIAL_STOPBITS_10 |
-        SERIAL_STOPBITS_20 |
-        SERIAL_PARITY_NONE |
-        SERIAL_PARITY_ODD |
-        SERIAL_PARITY_EVEN;
+    statistics.TxFifoThreshold =
+        (ufcr & IMX_UART_UFCR_TXTL_MASK) >> IMX_UART_UFCR_TXTL_SHIFT;
 
-    outputBufferPtr->CurrentTxQueue = 0;
-    outputBufferPtr->CurrentRxQueue = 0;
+    statistics.AdaptiveFifoThresholds = adaptive ? TRUE : FALSE;
 
+    *outputBufferPtr = statistics;
     WdfRequestCompleteWithInformation(
         WdfRequest,
         STATUS_SUCCESS,
@@ -4141,354 +5642,362 @@ IMXUartIoctlGetProperties (
 
 _Use_decl_annotations_
 void
-IMXUartIoctlGetCommStatus (
-    const IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
+IMXUartIoctlClearStatistics (
+    IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
     WDFREQUEST WdfRequest
     )
 {
-    SERIAL_STATUS* outputBufferPtr;
-    NTSTATUS status = WdfRequestRetrieveOutputBuffer(
+    IMX_UART_INTERRUPT_CONTEXT* interruptContextPtr =
+            DeviceContextPtr->InterruptContextPtr;
+
+    WdfInterruptAcquireLock(DeviceContextPtr->WdfInterrupt);
+    RtlZeroMemory(
+        &interruptContextPtr->Statistics,
+        sizeof(interruptContextPtr->Statistics));
+
+    WdfInterruptReleaseLock(DeviceContextPtr->WdfInterrupt);
+
+    WdfRequestComplete(WdfRequest, STATUS_SUCCESS);
+}
+
+_Use_decl_annotations_
+void
+IMXUartIoctlSetFramedReceive (
+    IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
+    WDFREQUEST WdfRequest
+    )
+{
+    IMX_UART_FRAMED_RECEIVE_INPUT* inputBufferPtr;
+    NTSTATUS status = WdfRequestRetrieveInputBuffer(
             WdfRequest,
-            sizeof(*outputBufferPtr),
-            reinterpret_cast<PVOID*>(&outputBufferPtr),
+            sizeof(*inputBufferPtr),
+            reinterpret_cast<PVOID*>(&inputBufferPtr),
             nullptr);
 
     if (!NT_SUCCESS(status)) {
         IMX_UART_LOG_ERROR(
-            "Failed to retrieve output buffer for IOCTL_SERIAL_GET_COMMSTATUS request. (status = %!STATUS!)",
+            "Failed to retrieve input buffer for IOCTL_IMX_UART_SET_FRAMED_RECEIVE request. (status = %!STATUS!)",
             status);
 
         WdfRequestComplete(WdfRequest, status);
         return;
     }
 
-    IMX_UART_INTERRUPT_CONTEXT* interruptContextPtr =
-            DeviceContextPtr->InterruptContextPtr;
+    status = IMXUartSetFramedReceive(
+            DeviceContextPtr,
+            inputBufferPtr->Enable != FALSE,
+            inputBufferPtr->IdleCharacters);
 
-    *outputBufferPtr = SERIAL_STATUS();
+    WdfRequestComplete(WdfRequest, status);
+}
 
-    //
-    // Read and reset error mask
-    //
-    {
-        WdfInterruptAcquireLock(interruptContextPtr->WdfInterrupt);
-        outputBufferPtr->Errors = interruptContextPtr->CommStatusErrors;
-        interruptContextPtr->CommStatusErrors = 0;
-        WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
+_Use_decl_annotations_
+void
+IMXUartIoctlReadFrame (
+    IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
+    WDFREQUEST WdfRequest
+    )
+{
+    IMX_UART_FRAME_HEADER* outputBufferPtr;
+    NTSTATUS status = WdfRequestRetrieveOutputBuffer(
+            WdfRequest,
+            sizeof(*outputBufferPtr),
+            reinterpret_cast<PVOID*>(&outputBufferPtr),
+            nullptr);
+
+    if (!NT_SUCCESS(status)) {
+        IMX_UART_LOG_ERROR(
+            "Failed to retrieve output buffer for IOCTL_IMX_UART_READ_FRAME request. (status = %!STATUS!)",
+            status);
+
+        WdfRequestComplete(WdfRequest, status);
+        return;
     }
 
     //
-    // If output CTS flow control is on, check the status of the RTSS bit
-    // (which really indicates states of CTS pin)
+    // Park the request until a frame is available, so it does not hold
+    // up the SerCx2 control requests.
+    // The mode check and the forward are done under FrameReadLock, so
+    // a concurrent disable either fails the request here, or finds it in
+    // the queue when it drains it.
     //
-    if ((interruptContextPtr->Ucr2Copy & IMX_UART_UCR2_IRTS) == 0) {
-        const ULONG usr1 = READ_REGISTER_NOFENCE_ULONG(
-                &interruptContextPtr->RegistersPtr->Usr1);
+    WdfSpinLockAcquire(DeviceContextPtr->FrameReadLock);
 
-        if ((usr1 & IMX_UART_USR1_RTSS) != 0) {
-            outputBufferPtr->HoldReasons |= SERIAL_TX_WAITING_FOR_CTS;
-        }
+    const bool isFramedReceiveEnabled =
+            DeviceContextPtr->InterruptContextPtr->FramedReceive.Enabled;
+
+    if (isFramedReceiveEnabled) {
+        status = WdfRequestForwardToIoQueue(
+                WdfRequest,
+                DeviceContextPtr->FrameReadWdfQueue);
     }
 
-    //
-    // Check if break is currently in progress
-    //
-    if ((interruptContextPtr->Ucr1Copy & IMX_UART_UCR1_SNDBRK) != 0) {
-        outputBufferPtr->HoldReasons |= SERIAL_TX_WAITING_ON_BREAK;
+    WdfSpinLockRelease(DeviceContextPtr->FrameReadLock);
+
+    if (!isFramedReceiveEnabled) {
+        IMX_UART_LOG_ERROR(
+            "IOCTL_IMX_UART_READ_FRAME requires framed receive mode.");
+
+        WdfRequestComplete(WdfRequest, status);
+        return;
     }
 
-    outputBufferPtr->AmountInInQueue = 0;
-    outputBufferPtr->AmountInOutQueue = interruptContextPtr->TxBuffer.Count();
-    outputBufferPtr->EofReceived = FALSE;
-    outputBufferPtr->WaitForImmediate = FALSE;
+    if (!NT_SUCCESS(status)) {
+        IMX_UART_LOG_ERROR(
+            "WdfRequestForwardToIoQueue(...) failed. (status = %!STATUS!)",
+            status);
 
-    WdfRequestCompleteWithInformation(
-        WdfRequest,
-        STATUS_SUCCESS,
-        sizeof(*outputBufferPtr));
+        WdfRequestComplete(WdfRequest, status);
+        return;
+    }
+
+    IMXUartFramedReceiveProcess(DeviceContextPtr);
 }
 
 _Use_decl_annotations_
-void
-IMXUartIoctlGetModemStatus (
-    const IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
-    WDFREQUEST WdfRequest
+NTSTATUS
+IMXUartSetFramedReceive (
+    IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
+    bool Enable,
+    ULONG IdleCharacters
     )
 {
-    //
-    // Define locally so we are less likely to conflict with future
-    // public definitions.
-    //
-    enum SERIAL_MSR : ULONG {
-        //
-        // This bit is the delta clear to send.  It is used to indicate
-        // that the clear to send bit (in this register) has *changed*
-        // since this register was last read by the CPU.
-        //
-        SERIAL_MSR_DCTS = 0x01,
+    IMX_UART_INTERRUPT_CONTEXT* interruptContextPtr =
+            DeviceContextPtr->InterruptContextPtr;
 
-        //
-        // This bit is the delta data set ready.  It is used to indicate
-        // that the data set ready bit (in this register) has *changed*
-        // since this register was last read by the CPU.
-        //
-        SERIAL_MSR_DDSR = 0x02,
+    IMX_UART_REGISTERS* registersPtr = interruptContextPtr->RegistersPtr;
 
+    if (Enable) {
         //
-        // This is the trailing edge ring indicator.  It is used to indicate
-        // that the ring indicator input has changed from a low to high state.
+        // Received data must go through the intermediate buffer
         //
-        SERIAL_MSR_TERI = 0x04,
+        NTSTATUS status = IMXUartStopRxDma(interruptContextPtr);
+        if (!NT_SUCCESS(status)) {
+            IMX_UART_LOG_ERROR(
+                "IMXUartStopRxDma failed, (status = %!STATUS!)",
+                status);
 
-        //
-        // This bit is the delta data carrier detect.  It is used to indicate
-        // that the data carrier bit (in this register) has *changed*
-        // since this register was last read by the CPU.
-        //
-        SERIAL_MSR_DDCD = 0x08,
+            return status;
+        }
+    }
 
-        //
-        // This bit contains the (complemented) state of the clear to send
-        // (CTS) line.
-        //
-        SERIAL_MSR_CTS = 0x10,
+    //
+    // UCR1[ICD] only supports 4, 8, 16 or 32 idle frames
+    //
+    ULONG icd;
+    if (IdleCharacters <= 4) {
+        icd = IMX_UART_UCR1_ICD_4;
+    } else if (IdleCharacters <= 8) {
+        icd = IMX_UART_UCR1_ICD_8;
+    } else if (IdleCharacters <= 16) {
+        icd = IMX_UART_UCR1_ICD_16;
+    } else {
+        icd = IMX_UART_UCR1_ICD_32;
+    }
 
-        //
-        // This bit contains the (complemented) state of the data set ready
-        // (DSR) line.
-        //
-        SERIAL_MSR_DSR = 0x20,
+    WdfInterruptAcquireLock(interruptContextPtr->WdfInterrupt);
 
-        //
-        // This bit contains the (complemented) state of the ring indicator
-        // (RI) line.
-        //
-        SERIAL_MSR_RI = 0x40,
+    auto framedPtr = &interruptContextPtr->FramedReceive;
+    if (Enable) {
+        interruptContextPtr->RxBuffer.Reset();
+
+        framedPtr->Enabled = true;
+        framedPtr->State = IMX_UART_STATE::WAITING_FOR_INTERRUPT;
+        framedPtr->StartIndex = interruptContextPtr->RxBuffer.HeadIndex;
+        framedPtr->Flags = 0;
+        framedPtr->QueueHead = 0;
+        framedPtr->QueueTail = 0;
+
+        WRITE_REGISTER_NOFENCE_ULONG(
+            &registersPtr->Usr2,
+            IMX_UART_USR2_IDLE);
 
         //
-        // This bit contains the (complemented) state of the data carrier detect
-        // (DCD) line.
+        // Keep RRDY, AGTIM and IDLE enabled for as long as the mode is on
         //
-        SERIAL_MSR_DCD = 0x80,
-    };
+        interruptContextPtr->Ucr1Copy &= ~IMX_UART_UCR1_ICD_MASK;
+        interruptContextPtr->Ucr1Copy |=
+            (icd | IMX_UART_UCR1_IDEN | IMX_UART_UCR1_RRDYEN);
 
-    ULONG* outputBufferPtr;
-    NTSTATUS status = WdfRequestRetrieveOutputBuffer(
-            WdfRequest,
-            sizeof(*outputBufferPtr),
-            reinterpret_cast<PVOID*>(&outputBufferPtr),
-            nullptr);
+        interruptContextPtr->Ucr2Copy |= IMX_UART_UCR2_ATEN;
 
-    if (!NT_SUCCESS(status)) {
-        IMX_UART_LOG_ERROR(
-            "Failed to retrieve output buffer for IOCTL_SERIAL_GET_MODEMSTATUS request. (status = %!STATUS!)",
-            status);
+        interruptContextPtr->Usr1EnabledInterruptsMask |=
+            (IMX_UART_USR1_RRDY | IMX_UART_USR1_AGTIM);
 
-        WdfRequestComplete(WdfRequest, status);
-        return;
-    }
+        interruptContextPtr->Usr2EnabledInterruptsMask |= IMX_UART_USR2_IDLE;
 
-    ULONG msr = 0;
+        WRITE_REGISTER_NOFENCE_ULONG(
+            &registersPtr->Ucr2,
+            interruptContextPtr->Ucr2Copy);
 
-    const ULONG usr1 = READ_REGISTER_NOFENCE_ULONG(
-            &DeviceContextPtr->RegistersPtr->Usr1);
+        WRITE_REGISTER_NOFENCE_ULONG(
+            &registersPtr->Ucr1,
+            interruptContextPtr->Ucr1Copy);
 
-    //
-    // Check the RTS Delta bit (aka. CTS delta bit), and clear bit by writing 1
-    //
-    if ((usr1 & IMX_UART_USR1_RTSD) != 0) {
-        msr |= SERIAL_MSR_DCTS;
+        IMX_UART_LOG_TRACE(
+            "Framed receive enabled. (IdleCharacters = %lu, ucr1 = 0x%lx)",
+            IdleCharacters,
+            interruptContextPtr->Ucr1Copy);
+
+    } else if (framedPtr->Enabled) {
+        framedPtr->Enabled = false;
+        framedPtr->State = IMX_UART_STATE::STOPPED;
+        framedPtr->QueueHead = 0;
+        framedPtr->QueueTail = 0;
+
+        interruptContextPtr->Ucr1Copy &= ~IMX_UART_UCR1_IDEN;
+        interruptContextPtr->Usr2EnabledInterruptsMask &= ~IMX_UART_USR2_IDLE;
 
         WRITE_REGISTER_NOFENCE_ULONG(
-            &DeviceContextPtr->RegistersPtr->Usr1,
-            IMX_UART_USR1_RTSD);
+            &registersPtr->Ucr1,
+            interruptContextPtr->Ucr1Copy);
+
+        //
+        // Bytes left in the intermediate buffer go to read requests
+        //
+        if (!interruptContextPtr->RxBuffer.IsEmpty() &&
+            (interruptContextPtr->RxState ==
+             IMX_UART_STATE::WAITING_FOR_INTERRUPT)) {
+
+            interruptContextPtr->RxState = IMX_UART_STATE::WAITING_FOR_DPC;
+            WdfInterruptQueueDpcForIsr(interruptContextPtr->WdfInterrupt);
+        }
+
+        IMX_UART_LOG_TRACE("Framed receive disabled.");
     }
 
+    WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
+
     //
-    // Read current RTS (aka. CTS) status
+    // Fail the frame read requests that are still waiting
     //
-    if ((usr1 & IMX_UART_USR1_RTSS) != 0) {
-        msr |= SERIAL_MSR_CTS;
+    if (!Enable) {
+        WdfSpinLockAcquire(DeviceContextPtr->FrameReadLock);
+        WDFREQUEST wdfRequest;
+        while (NT_SUCCESS(WdfIoQueueRetrieveNextRequest(
+                DeviceContextPtr->FrameReadWdfQueue,
+                &wdfRequest))) {
+
+            WdfRequestComplete(wdfRequest, STATUS_CANCELLED);
+        }
+        WdfSpinLockRelease(DeviceContextPtr->FrameReadLock);
     }
 
-    *outputBufferPtr = msr;
-    WdfRequestCompleteWithInformation(
-        WdfRequest,
-        STATUS_SUCCESS,
-        sizeof(*outputBufferPtr));
+    return STATUS_SUCCESS;
 }
 
 _Use_decl_annotations_
-void
-IMXUartIoctlSetClrRts (
-    IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
-    WDFREQUEST WdfRequest,
-    bool RtsState
+VOID
+IMXUartFramedReceiveProcess (
+    IMX_UART_DEVICE_CONTEXT* DeviceContextPtr
     )
 {
     IMX_UART_INTERRUPT_CONTEXT* interruptContextPtr =
             DeviceContextPtr->InterruptContextPtr;
 
-    WdfInterruptAcquireLock(interruptContextPtr->WdfInterrupt);
+    IMX_UART_REGISTERS* registersPtr = interruptContextPtr->RegistersPtr;
+    IMX_UART_RING_BUFFER* rxBufferPtr = &interruptContextPtr->RxBuffer;
+    auto framedPtr = &interruptContextPtr->FramedReceive;
 
     //
-    // Only allowed when CTSC is clear
+    // Serialize the RX intermediate buffer consumers, one frame
+    // goes to one request.
     //
-    if ((interruptContextPtr->Ucr2Copy & IMX_UART_UCR2_CTSC) != 0) {
-        WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
-        IMX_UART_LOG_ERROR(
-            "Attempted to set state of RTS pin when manual RTS control is not enabled. "
-            "(interruptContextPtr->Ucr2Copy = 0x%lx)",
-            interruptContextPtr->Ucr2Copy);
-
-        WdfRequestComplete(WdfRequest, STATUS_INVALID_PARAMETER);
-        return;
-    }
-
-    if (RtsState) {
-        interruptContextPtr->Ucr2Copy |= IMX_UART_UCR2_CTS;
-    } else {
-        interruptContextPtr->Ucr2Copy &= ~IMX_UART_UCR2_CTS;
-    }
-
-    WRITE_REGISTER_NOFENCE_ULONG(
-        &interruptContextPtr->RegistersPtr->Ucr2,
-        interruptContextPtr->Ucr2Copy);
-
-    WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
-    WdfRequestComplete(WdfRequest, STATUS_SUCCESS);
-}
-
-_Use_decl_annotations_
-void
-IMXUartIoctlGetDtrRts (
-    const IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
-    WDFREQUEST WdfRequest
-    )
-{
-    ULONG* outputBufferPtr;
-    NTSTATUS status = WdfRequestRetrieveOutputBuffer(
-            WdfRequest,
-            sizeof(*outputBufferPtr),
-            reinterpret_cast<PVOID*>(&outputBufferPtr),
-            nullptr);
-
-    if (!NT_SUCCESS(status)) {
-        IMX_UART_LOG_ERROR(
-            "Failed to retrieve output buffer for IOCTL_SERIAL_GET_DTRRTS request. (status = %!STATUS!)",
-            status);
+    WdfSpinLockAcquire(DeviceContextPtr->FrameReadLock);
 
-        WdfRequestComplete(WdfRequest, status);
-        return;
-    }
+    for (;;) {
+        IMX_UART_FRAME_DESCRIPTOR frame;
 
-    const IMX_UART_INTERRUPT_CONTEXT* interruptContextPtr =
-            DeviceContextPtr->InterruptContextPtr;
+        WdfInterruptAcquireLock(interruptContextPtr->WdfInterrupt);
+        if (!framedPtr->Enabled ||
+            (framedPtr->QueueHead == framedPtr->QueueTail)) {
 
-    ULONG mask = 0;
+            WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
+            break;
+        }
+        frame = framedPtr->Queue[
+            framedPtr->QueueTail & (IMX_UART_FRAME_QUEUE_SIZE - 1)];
+        WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
 
-    if ((interruptContextPtr->Ucr2Copy & IMX_UART_UCR2_CTS) != 0) {
-        mask |= SERIAL_RTS_STATE;
-    }
+        WDFREQUEST wdfRequest;
+        NTSTATUS status = WdfIoQueueRetrieveNextRequest(
+                DeviceContextPtr->FrameReadWdfQueue,
+                &wdfRequest);
 
-    *outputBufferPtr = mask;
-    WdfRequestCompleteWithInformation(
-        WdfRequest,
-        STATUS_SUCCESS,
-        sizeof(*outputBufferPtr));
-}
+        if (!NT_SUCCESS(status)) {
+            break;
+        }
 
-_Use_decl_annotations_
-void
-IMXUartIoctlSetBreakOnOff (
-    IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
-    WDFREQUEST WdfRequest,
-    bool BreakOn
-    )
-{
-    IMXUartSetBreakOnOff(DeviceContextPtr, BreakOn);
-    WdfRequestComplete(WdfRequest, STATUS_SUCCESS);
-}
+        IMX_UART_FRAME_HEADER* headerPtr;
+        size_t outputBufferLength;
+        status = WdfRequestRetrieveOutputBuffer(
+                wdfRequest,
+                sizeof(*headerPtr),
+                reinterpret_cast<PVOID*>(&headerPtr),
+                &outputBufferLength);
 
-_Use_decl_annotations_
-void
-IMXUartIoctlGetModemControl (
-    const IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
-    WDFREQUEST WdfRequest
-    )
-{
-    //
-    // These masks define access the modem control register.
-    // Define locally to avoid conflict with potential future public definition.
-    //
-    enum SERIAL_MCR : ULONG {
+        if (!NT_SUCCESS(status)) {
+            WdfRequestComplete(wdfRequest, status);
+            continue;
+        }
 
-        //
-        // This bit controls the data terminal ready (DTR) line.  When
-        // this bit is set the line goes to logic 0 (which is then inverted
-        // by normal hardware).  This is normally used to indicate that
-        // the device is available to be used.  Some odd hardware
-        // protocols (like the kernel debugger) use this for handshaking
-        // purposes.
-        //
-        SERIAL_MCR_DTR = 0x01,
+        const ULONG frameLength = IMX_UART_RING_BUFFER::Count(
+                frame.EndIndex,
+                rxBufferPtr->TailIndex,
+                rxBufferPtr->Size);
 
-        //
-        // This bit controls the ready to send (RTS) line.  When this bit
-        // is set the line goes to logic 0 (which is then inverted by the normal
-        // hardware).  This is used for hardware handshaking.  It indicates that
-        // the hardware is ready to send data and it is waiting for the
-        // receiving end to set clear to send (CTS).
-        //
-        SERIAL_MCR_RTS = 0x02,
+        const size_t maxBytes = outputBufferLength - sizeof(*headerPtr);
+        const ULONG bytesRead = rxBufferPtr->DequeueBytes(
+                reinterpret_cast<UCHAR*>(headerPtr + 1),
+                ULONG(min(size_t(frameLength), maxBytes)));
 
-        //
-        // This bit is used for general purpose output.
-        //
-        SERIAL_MCR_OUT1 = 0x04,
+        ULONG flags = frame.Flags;
+        if (bytesRead < frameLength) {
+            rxBufferPtr->CommitDequeue(frameLength - bytesRead);
+            flags |= IMX_UART_FRAME_FLAG_TRUNCATED;
+        }
 
-        //
-        // This bit is used for general purpose output.
-        //
-        SERIAL_MCR_OUT2 = 0x08,
+        headerPtr->Length = bytesRead;
+        headerPtr->Flags = flags;
+        headerPtr->Timestamp = frame.Timestamp;
 
         //
-        // This bit controls the loopback testing mode of the device.  Basically
-        // the outputs are connected to the inputs (and vice versa).
+        // Release the frame, and reenable RRDY and AGTIM if they were
+        // disabled when the intermediate buffer overflowed.
         //
-        SERIAL_MCR_LOOP = 0x10,
-    };
-
-    ULONG* outputBufferPtr;
-    NTSTATUS status = WdfRequestRetrieveOutputBuffer(
-            WdfRequest,
-            sizeof(*outputBufferPtr),
-            reinterpret_cast<PVOID*>(&outputBufferPtr),
-            nullptr);
+        WdfInterruptAcquireLock(interruptContextPtr->WdfInterrupt);
+        ++framedPtr->QueueTail;
+        if (framedPtr->Enabled &&
+            ((interruptContextPtr->Ucr1Copy & IMX_UART_UCR1_RRDYEN) == 0)) {
 
-    if (!NT_SUCCESS(status)) {
-        IMX_UART_LOG_ERROR(
-            "Failed to retrieve output buffer for IOCTL_SERIAL_GET_MODEM_CONTROL request. (status = %!STATUS!)",
-            status);
+            interruptContextPtr->Ucr1Copy |= IMX_UART_UCR1_RRDYEN;
+            interruptContextPtr->Ucr2Copy |= IMX_UART_UCR2_ATEN;
+            interruptContextPtr->Usr1EnabledInterruptsMask |=
+                (IMX_UART_USR1_RRDY | IMX_UART_USR1_AGTIM);
 
-        WdfRequestComplete(WdfRequest, status);
-        return;
-    }
+            WRITE_REGISTER_NOFENCE_ULONG(
+                &registersPtr->Ucr2,
+                interruptContextPtr->Ucr2Copy);
 
-    const IMX_UART_INTERRUPT_CONTEXT* interruptContextPtr =
-            DeviceContextPtr->InterruptContextPtr;
+            WRITE_REGISTER_NOFENCE_ULONG(
+                &registersPtr->Ucr1,
+                interruptContextPtr->Ucr1Copy);
+        }
+        WdfInterruptReleaseLock(interruptContextPtr->WdfInterrupt);
 
-    ULONG mcr = 0;
+        IMX_UART_LOG_TRACE(
+            "Completing frame read. (frameLength = %lu, bytesRead = %lu, flags = 0x%lx)",
+            frameLength,
+            bytesRead,
+            flags);
 
-    if ((interruptContextPtr->Ucr2Copy & IMX_UART_UCR2_CTS) != 0) {
-        mcr |= SERIAL_MCR_RTS;
+        WdfRequestCompleteWithInformation(
+            wdfRequest,
+            STATUS_SUCCESS,
+            sizeof(*headerPtr) + bytesRead);
     }
 
-    *outputBufferPtr = mcr;
-    WdfRequestCompleteWithInformation(
-        WdfRequest,
-        STATUS_SUCCESS,
-        sizeof(*outputBufferPtr));
+    WdfSpinLockRelease(DeviceContextPtr->FrameReadLock);
 }
 
 _Use_decl_annotations_
@@ -4651,6 +6160,7 @@ IMXUartStopRxDma (
     InterruptContextPtr->IsRxDmaStarted = false;
 
     WdfTimerStop(rxDmaTransactionContextPtr->WdfProgressTimer, FALSE);
+    IMXUartRxDmaDisableIdleNotification(InterruptContextPtr);
 
     //
     // Stop RX DMA
@@ -5321,6 +6831,46 @@ IMXUartEvtDeviceAdd (
         deviceContextPtr->InterruptContextPtr = interruptContextPtr;
     }
 
+    //
+    // Create the queue that holds IOCTL_IMX_UART_READ_FRAME requests
+    // until a frame is received
+    //
+    {
+        WDF_IO_QUEUE_CONFIG queueConfig;
+        WDF_IO_QUEUE_CONFIG_INIT(&queueConfig, WdfIoQueueDispatchManual);
+        queueConfig.PowerManaged = WdfFalse;
+
+        status = WdfIoQueueCreate(
+                wdfDevice,
+                &queueConfig,
+                WDF_NO_OBJECT_ATTRIBUTES,
+                &deviceContextPtr->FrameReadWdfQueue);
+
+        if (!NT_SUCCESS(status)) {
+            IMX_UART_LOG_ERROR(
+                "WdfIoQueueCreate(...) for frame read queue failed. (status = %!STATUS!)",
+                status);
+
+            return status;
+        }
+
+        WDF_OBJECT_ATTRIBUTES attributes;
+        WDF_OBJECT_ATTRIBUTES_INIT(&attributes);
+        attributes.ParentObject = wdfDevice;
+
+        status = WdfSpinLockCreate(
+                &attributes,
+                &deviceContextPtr->FrameReadLock);
+
+        if (!NT_SUCCESS(status)) {
+            IMX_UART_LOG_ERROR(
+                "WdfSpinLockCreate(...) for frame read lock failed. (status = %!STATUS!)",
+                status);
+
+            return status;
+        }
+    }
+
     //
     // Initialize SerCx2 class extension.
     //
@@ -5512,7 +7062,27 @@ IMXUartEvtDeviceAdd (
                 L"TxDmaMinTransactionLength",
                 &deviceContextPtr->Parameters.TxDmaMinTransactionLength,
                 4 * IMX_UART_FIFO_COUNT,
-            }
+            },
+            {
+                L"RxDmaDirectMinTransactionLength",
+                &deviceContextPtr->Parameters.RxDmaDirectMinTransactionLength,
+                0,
+            },
+            {
+                L"AdaptiveFifoThresholds",
+                &deviceContextPtr->Parameters.AdaptiveFifoThresholds,
+                0,
+            },
+            {
+                L"RxFifoThresholdMinUs",
+                &deviceContextPtr->Parameters.RxFifoThresholdMinUs,
+                20,
+            },
+            {
+                L"TxFifoThresholdMaxUs",
+                &deviceContextPtr->Parameters.TxFifoThresholdMaxUs,
+                50,
+            },
         };
 
         for (ULONG i = 0; i < ARRAYSIZE(regTable); ++i) {
@@ -6349,6 +7919,99 @@ IMXUartInitializeDma (
             IMX_UART_RX_DMA_TIMER_CONTEXT();
 
         customRxTimerContextPtr->RxDmaTransactionPtr = dmaTransactionContextPtr;
+
+        //
+        // Create a second, non looped, WDF system DMA object and transaction
+        // for receiving large custom transactions directly into the caller
+        // buffer. It uses the same SDMA channel and request line as the
+        // cyclic transaction, so the request line ownership covers both.
+        //
+        if (deviceContextPtr->Parameters.RxDmaDirectMinTransactionLength == 0) {
+            IMX_UART_LOG_TRACE("RX DMA direct transfer is disabled");
+        } else {
+            WDF_DMA_ENABLER_CONFIG_INIT(
+                &wdfDmaEnablerConfig,
+                WdfDmaProfileSystem,
+                SDMA_MAX_TRANSFER_LENGTH);
+
+            wdfDmaEnablerConfig.WdmDmaVersionOverride =
+                DEVICE_DESCRIPTION_VERSION3;
+
+            status = WdfDmaEnablerCreate(
+                WdfDevice,
+                &wdfDmaEnablerConfig,
+                WDF_NO_OBJECT_ATTRIBUTES,
+                &wdfDmaEnabler);
+
+            if (!NT_SUCCESS(status)) {
+                IMX_UART_LOG_ERROR(
+                    "WdfDmaEnablerCreate(...) for RX DMA direct transfer "
+                    "failed. (status = %!STATUS!)",
+                    status);
+
+                return status;
+            }
+
+            //
+            // Configure the system DMA for:
+            // - Demand mode
+            //
+            WDF_DMA_SYSTEM_PROFILE_CONFIG_INIT(
+                &wdfDmaSystemProfileConfig,
+                uartRxdPA,
+                Width8Bits,
+                (PCM_PARTIAL_RESOURCE_DESCRIPTOR)RxDmaResourcePtr);
+
+            wdfDmaSystemProfileConfig.DemandMode = TRUE;
+
+            status = WdfDmaEnablerConfigureSystemProfile(
+                wdfDmaEnabler,
+                &wdfDmaSystemProfileConfig,
+                WdfDmaDirectionReadFromDevice);
+
+            if (!NT_SUCCESS(status)) {
+                IMX_UART_LOG_ERROR(
+                    "WdfDmaEnablerConfigureSystemProfile(...) for RX DMA "
+                    "direct transfer failed. (status = %!STATUS!)",
+                    status);
+
+                return status;
+            }
+
+            status = WdfDmaTransactionCreate(
+                wdfDmaEnabler,
+                WDF_NO_OBJECT_ATTRIBUTES,
+                &wdfDmaTransaction);
+
+            if (!NT_SUCCESS(status)) {
+                IMX_UART_LOG_ERROR(
+                    "WdfDmaTransactionCreate(...) for RX DMA direct transfer "
+                    "failed. (status = %!STATUS!)",
+                    status);
+
+                return status;
+            }
+
+            dmaTransactionContextPtr->DirectWdfDmaEnabler = wdfDmaEnabler;
+            dmaTransactionContextPtr->DirectWdfDmaTransaction = wdfDmaTransaction;
+            dmaTransactionContextPtr->DirectDmaAdapterPtr =
+                WdfDmaEnablerWdmGetDmaAdapter(
+                    wdfDmaEnabler,
+                    WdfDmaDirectionReadFromDevice);
+
+            dmaTransactionContextPtr->DirectMinTransactionLength =
+                deviceContextPtr->Parameters.RxDmaDirectMinTransactionLength;
+
+            WdfDmaTransactionSetChannelConfigurationCallback(
+                wdfDmaTransaction,
+                IMXUartEvtWdfRxDirectDmaTransactionConfigureDmaChannel,
+                dmaTransactionContextPtr);
+
+            WdfDmaTransactionSetTransferCompleteCallback(
+                wdfDmaTransaction,
+                IMXUartEvtWdfRxDirectDmaTransactionTransferComplete,
+                dmaTransactionContextPtr);
+        }
     } // Configure receive DMA
 
     //
@@ -55,6 +55,27 @@ enum IMX_UART_STATE : ULONG {
 
 enum : ULONG { IMX_UART_RX_DMA_MIN_BUFFER_SIZE = 4096UL };
 
+//
+// RX DMA progress is reported from SDMA buffer descriptor completions and
+// from the idle line interrupt. The SDMA notification threshold sets the
+// buffer descriptor size, and the progress timer only serves as a safety
+// net, so it never fires sooner than IMX_UART_RX_DMA_PROGRESS_TIMER_MIN_USEC.
+//
+enum : ULONG { IMX_UART_RX_DMA_NOTIFICATION_BYTES = 256UL };
+enum : ULONG { IMX_UART_RX_DMA_PROGRESS_TIMER_MIN_USEC = 50000UL };
+
+//
+// Number of interrupts over which traffic is observed before the adaptive
+// FIFO threshold policy reevaluates UFCR[RXTL] and UFCR[TXTL].
+//
+enum : ULONG { IMX_UART_FIFO_TUNING_WINDOW = 64UL };
+
+//
+// Number of received frames (IOCTL_IMX_UART_READ_FRAME) that can be waiting
+// in the RX intermediate buffer. Must be a power of two.
+//
+enum : ULONG { IMX_UART_FRAME_QUEUE_SIZE = 32UL };
+
 //
 // Placement new and delete operators
 //
@@ -70,26 +91,41 @@ void* __cdecl operator new[] ( size_t, _In_ void* Ptr ) throw ();
 void __cdecl operator delete[] ( void*, void* ) throw ();
 
 //
-// Single-reader, single-writer circular buffer.
+// Single-reader, single-writer circular buffer. The number of slots is always
+// a power of two so that indices can be wrapped with a mask instead of a
+// division. The producer may reserve a contiguous span of free slots, fill it
+// in place, and commit it with a single release store; the consumer may do
+// the same with a contiguous span of filled slots.
 //
 struct IMX_UART_RING_BUFFER {
     ULONG HeadIndex;                    // points to next available slot
     ULONG TailIndex;                    // points to least recently filled slot
     ULONG Size;                         // number of slots in buffer
+    ULONG Mask;                         // Size - 1
     _Field_size_(Size) UCHAR* BufferPtr;
 
     FORCEINLINE IMX_UART_RING_BUFFER () :
         HeadIndex(0),
         TailIndex(0),
         Size(0),
+        Mask(0),
         BufferPtr(nullptr)
     {}
 
-    FORCEINLINE void SetBuffer (_In_reads_(Size) UCHAR* InBufferPtr, ULONG InBufferSize)
+    //
+    // Only the largest power of two that fits in InBufferSize is used.
+    //
+    FORCEINLINE void SetBuffer (_In_reads_(InBufferSize) UCHAR* InBufferPtr, ULONG InBufferSize)
     {
+        ULONG size = InBufferSize;
+        while ((size & (size - 1)) != 0) {
+            size &= size - 1;
+        }
+
         this->HeadIndex = 0;
         this->TailIndex = 0;
-        this->Size = InBufferSize;
+        this->Size = size;
+        this->Mask = (size != 0) ? (size - 1) : 0;
         this->BufferPtr = InBufferPtr;
     }
 
@@ -100,24 +136,18 @@ struct IMX_UART_RING_BUFFER {
 
     FORCEINLINE ULONG Count () const
     {
-        return Count(this->HeadIndex, this->TailIndex, this->Size);
+        return (this->HeadIndex - this->TailIndex) & this->Mask;
     }
 
     FORCEINLINE static ULONG Count (ULONG HeadIndex, ULONG TailIndex, ULONG Size)
     {
-        if (HeadIndex >= TailIndex)
-        {
-            return HeadIndex - TailIndex;
-        }
-        else
-        {
-            return Size + HeadIndex - TailIndex;
-        }
+        NT_ASSERT((Size & (Size - 1)) == 0);
+        return (HeadIndex - TailIndex) & (Size - 1);
     }
 
     FORCEINLINE ULONG Capacity () const
     {
-        return this->Size - 1;
+        return this->Mask;
     }
 
     //
@@ -132,6 +162,49 @@ struct IMX_UART_RING_BUFFER {
         return count;
     }
 
+    //
+    // Producer side. Returns a pointer to the longest run of free slots that
+    // starts at HeadIndex and does not wrap. The run may be shorter than the
+    // total free space; call again after CommitEnqueue() to get the rest.
+    //
+    FORCEINLINE UCHAR* ReserveEnqueueSpan (_Out_ ULONG* SpanLengthPtr) const
+    {
+        const ULONG tail = ReadULongAcquire(&this->TailIndex);
+        const ULONG head = this->HeadIndex;
+        const ULONG freeCount = (tail - head - 1) & this->Mask;
+
+        *SpanLengthPtr = min(freeCount, this->Size - head);
+        return &this->BufferPtr[head];
+    }
+
+    FORCEINLINE void CommitEnqueue (ULONG ByteCount)
+    {
+        WriteULongRelease(
+            &this->HeadIndex,
+            (this->HeadIndex + ByteCount) & this->Mask);
+    }
+
+    //
+    // Consumer side. Returns a pointer to the longest run of filled slots
+    // that starts at TailIndex and does not wrap.
+    //
+    FORCEINLINE const UCHAR* ReserveDequeueSpan (_Out_ ULONG* SpanLengthPtr) const
+    {
+        const ULONG head = ReadULongAcquire(&this->HeadIndex);
+        const ULONG tail = this->TailIndex;
+        const ULONG usedCount = (head - tail) & this->Mask;
+
+        *SpanLengthPtr = min(usedCount, this->Size - tail);
+        return &this->BufferPtr[tail];
+    }
+
+    FORCEINLINE void CommitDequeue (ULONG ByteCount)
+    {
+        WriteULongRelease(
+            &this->TailIndex,
+            (this->TailIndex + ByteCount) & this->Mask);
+    }
+
     ULONG
     EnqueueBytes (
         _In_reads_(InputBufferSize) const UCHAR* InputBufferPtr,
@@ -145,6 +218,15 @@ struct IMX_UART_RING_BUFFER {
         );
 };
 
+//
+// A received frame that ends at EndIndex in the RX intermediate buffer
+//
+struct IMX_UART_FRAME_DESCRIPTOR {
+    ULONG EndIndex;
+    ULONG Flags;
+    LARGE_INTEGER Timestamp;
+};
+
 struct IMX_UART_WDFKEY {
     WDFKEY Handle;
 
@@ -173,6 +255,13 @@ struct IMX_UART_DEVICE_CONTEXT {
     WDFDEVICE WdfDevice;
     WDFINTERRUPT WdfInterrupt;
 
+    //
+    // Pending IOCTL_IMX_UART_READ_FRAME requests, and the lock that
+    // serializes handing out frames to them
+    //
+    WDFQUEUE FrameReadWdfQueue;
+    WDFSPINLOCK FrameReadLock;
+
     //
     // Has IMXUartEvtSerCx2ApplyConfig() been called at least once?
     //
@@ -203,6 +292,10 @@ struct IMX_UART_DEVICE_CONTEXT {
         ULONG ModuleClockFrequency;
         ULONG RxDmaMinTransactionLength;
         ULONG TxDmaMinTransactionLength;
+        ULONG RxDmaDirectMinTransactionLength;
+        ULONG AdaptiveFifoThresholds;
+        ULONG RxFifoThresholdMinUs;
+        ULONG TxFifoThresholdMaxUs;
     } Parameters;
 };
 
@@ -221,6 +314,7 @@ struct IMX_UART_INTERRUPT_CONTEXT {
 
     IMX_UART_STATE RxState;
     IMX_UART_STATE RxDmaState;
+    IMX_UART_STATE RxDmaIdleState;
     IMX_UART_STATE TxState;
     IMX_UART_STATE TxDrainState;
     IMX_UART_STATE TxPurgeState;
@@ -274,6 +368,48 @@ struct IMX_UART_INTERRUPT_CONTEXT {
     IMX_UART_RX_DMA_TRANSACTION_CONTEXT* RxDmaTransactionContextPtr;
     IMX_UART_TX_DMA_TRANSACTION_CONTEXT* TxDmaTransactionContextPtr;
     bool IsRxDmaStarted;
+
+    //
+    // Adaptive FIFO threshold state, owned by the ISR. The bounds are UFCR
+    // RXTL/TXTL values derived from the configured latency limits and are
+    // recomputed whenever the baud rate changes. A higher RXTL and a lower
+    // TXTL mean fewer interrupts but less time to service the FIFO.
+    //
+    struct {
+        bool Enabled;
+        ULONG RxThresholdMin;
+        ULONG RxThresholdMax;
+        ULONG TxThresholdMin;
+        ULONG TxThresholdMax;
+        ULONG WindowInterruptCount;
+        ULONG WindowRxInterruptCount;
+        ULONG WindowRxByteCount;
+        ULONG WindowAgingTimerCount;
+        ULONG WindowRxOverrunCount;
+        ULONG WindowTxUnderrunCount;
+    } FifoTuning;
+
+    //
+    // Counters reported by IOCTL_IMX_UART_GET_STATISTICS
+    //
+    IMX_UART_STATISTICS Statistics;
+
+    //
+    // Framed receive state (IOCTL_IMX_UART_SET_FRAMED_RECEIVE). The ISR
+    // closes a frame at the RX intermediate buffer head whenever the idle
+    // condition is detected, and IMXUartFramedReceiveProcess() hands the
+    // frames out to IOCTL_IMX_UART_READ_FRAME requests. The frame queue
+    // indices are free running.
+    //
+    struct {
+        bool Enabled;
+        IMX_UART_STATE State;
+        ULONG StartIndex;
+        ULONG Flags;
+        ULONG QueueHead;
+        ULONG QueueTail;
+        IMX_UART_FRAME_DESCRIPTOR Queue[IMX_UART_FRAME_QUEUE_SIZE];
+    } FramedReceive;
 };
 
 WDF_DECLARE_CONTEXT_TYPE_WITH_NAME(
@@ -345,6 +481,18 @@ struct IMX_UART_RX_DMA_TRANSACTION_CONTEXT
     PMDL BufferMdlPtr;
     size_t BufferMdlOffset;
 
+    //
+    // Direct (zero-copy) transfer into the caller buffer. It uses a second,
+    // non looped, system DMA transaction on the same SDMA channel, so it
+    // only runs while the cyclic transaction is stopped.
+    //
+    WDFDMAENABLER DirectWdfDmaEnabler;
+    PDMA_ADAPTER DirectDmaAdapterPtr;
+    WDFDMATRANSACTION DirectWdfDmaTransaction;
+    size_t DirectMinTransactionLength;
+    size_t DirectBytesTransferred;
+    bool IsDirectTransferActive;
+
     //
     // Progress information
     //
@@ -417,6 +565,10 @@ EVT_WDF_DMA_TRANSACTION_DMA_TRANSFER_COMPLETE IMXUartEvtWdfRxDmaTransactionTrans
 EVT_WDF_PROGRAM_DMA IMXUartEvtWdfProgramRxDma;
 EVT_WDF_TIMER IMXUartEvtTimerRxDmaProgress;
 
+EVT_WDF_DMA_TRANSACTION_CONFIGURE_DMA_CHANNEL IMXUartEvtWdfRxDirectDmaTransactionConfigureDmaChannel;
+EVT_WDF_DMA_TRANSACTION_DMA_TRANSFER_COMPLETE IMXUartEvtWdfRxDirectDmaTransactionTransferComplete;
+EVT_WDF_PROGRAM_DMA IMXUartEvtWdfProgramRxDirectDma;
+
 EVT_SERCX2_CUSTOM_TRANSMIT_TRANSACTION_INITIALIZE IMXUartEvtSerCx2CustomTransmitTransactionInitialize;
 EVT_SERCX2_CUSTOM_TRANSMIT_TRANSACTION_START IMXUartEvtSerCx2CustomTransmitTransactionStart;
 EVT_SERCX2_CUSTOM_TRANSMIT_TRANSACTION_CLEANUP IMXUartEvtSerCx2CustomTransmitTransactionCleanup;
@@ -458,6 +610,22 @@ IMXUartComputeFifoThresholds (
     _Out_range_(1, IMX_UART_FIFO_COUNT - 1) ULONG* RxFifoThresholdPtr
     );
 
+void
+IMXUartComputeAdaptiveFifoBounds (
+    const IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
+    ULONG BaudRate,
+    _In_range_(9, 11) ULONG BitsPerFrame,
+    ULONG TxFifoThreshold,
+    ULONG RxFifoThreshold,
+    _Out_ ULONG* TxFifoThresholdMaxPtr,
+    _Out_ ULONG* RxFifoThresholdMaxPtr
+    );
+
+void
+IMXUartTuneFifoThresholds (
+    IMX_UART_INTERRUPT_CONTEXT* InterruptContextPtr
+    );
+
 ULONG
 IMXUartComputeCharactersPerDuration (
     ULONG DurationUs,
@@ -590,6 +758,24 @@ IMXUartRxDmaStartProgressTimer (
     IMX_UART_RX_DMA_TRANSACTION_CONTEXT* RxDmaTransactionContextPtr
     );
 
+_IRQL_requires_max_(DISPATCH_LEVEL)
+bool
+IMXUartRxDmaUpdateProgress (
+    IMX_UART_RX_DMA_TRANSACTION_CONTEXT* RxDmaTransactionContextPtr
+    );
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+VOID
+IMXUartRxDmaEnableIdleNotification (
+    IMX_UART_INTERRUPT_CONTEXT* InterruptContextPtr
+    );
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+VOID
+IMXUartRxDmaDisableIdleNotification (
+    IMX_UART_INTERRUPT_CONTEXT* InterruptContextPtr
+    );
+
 _IRQL_requires_max_(DISPATCH_LEVEL)
 bool
 IMXUartRxDmaCopyToUserBuffer (
@@ -612,6 +798,24 @@ IMXUartCompleteCustomRxTransactionRequest (
     NTSTATUS RequestStatus
     );
 
+_IRQL_requires_max_(DISPATCH_LEVEL)
+NTSTATUS
+IMXUartRxDmaStartDirectTransfer (
+    IMX_UART_RX_DMA_TRANSACTION_CONTEXT* RxDmaTransactionContextPtr
+    );
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+NTSTATUS
+IMXUartRxDmaResumeCyclicTransfer (
+    IMX_UART_RX_DMA_TRANSACTION_CONTEXT* RxDmaTransactionContextPtr
+    );
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+size_t
+IMXUartRxDmaGetDirectBytesTransferred (
+    IMX_UART_RX_DMA_TRANSACTION_CONTEXT* RxDmaTransactionContextPtr
+    );
+
 _IRQL_requires_max_(DISPATCH_LEVEL)
 VOID
 IMXUartTxDmaDrainFifo (
@@ -736,6 +940,48 @@ IMXUartIoctlGetModemControl (
     WDFREQUEST WdfRequest
     );
 
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+IMXUartIoctlGetStatistics (
+    const IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
+    WDFREQUEST WdfRequest
+    );
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+IMXUartIoctlClearStatistics (
+    IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
+    WDFREQUEST WdfRequest
+    );
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+IMXUartIoctlSetFramedReceive (
+    IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
+    WDFREQUEST WdfRequest
+    );
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+void
+IMXUartIoctlReadFrame (
+    IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
+    WDFREQUEST WdfRequest
+    );
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+NTSTATUS
+IMXUartSetFramedReceive (
+    IMX_UART_DEVICE_CONTEXT* DeviceContextPtr,
+    bool Enable,
+    ULONG IdleCharacters
+    );
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+VOID
+IMXUartFramedReceiveProcess (
+    IMX_UART_DEVICE_CONTEXT* DeviceContextPtr
+    );
+
 //
 // ACPI - Device Properties
 //
@@ -0,0 +1,125 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+//
+// Module Name:
+//
+//   imxuartioctl.h
+//
+// Abstract:
+//
+//   IMX UART driver specific IOCTL definitions. These IOCTLs are not
+//   handled by SerCx2 and are forwarded to the controller driver.
+//
+
+#ifndef _IMX_UART_IOCTL_H_
+#define _IMX_UART_IOCTL_H_
+
+//
+// IMX UART IOCTL function codes
+//
+
+enum IMX_UART_IOCTL_ID : ULONG {
+    IMX_UART_IOCTL_ID_GET_STATISTICS = 0x800,
+    IMX_UART_IOCTL_ID_CLEAR_STATISTICS,
+    IMX_UART_IOCTL_ID_SET_FRAMED_RECEIVE,
+    IMX_UART_IOCTL_ID_READ_FRAME,
+};
+
+//
+// IOCTL_IMX_UART_GET_STATISTICS
+//
+// Returns interrupt and throughput counters collected by the ISR along
+// with the FIFO thresholds currently programmed into UFCR.
+//
+
+#define IOCTL_IMX_UART_GET_STATISTICS \
+            CTL_CODE( \
+                FILE_DEVICE_SERIAL_PORT, \
+                IMX_UART_IOCTL_ID_GET_STATISTICS, \
+                METHOD_BUFFERED, \
+                FILE_ANY_ACCESS)
+
+typedef struct _IMX_UART_STATISTICS {
+    ULONG64 InterruptCount;             // interrupts claimed by the ISR
+    ULONG64 RxInterruptCount;           // interrupts that serviced the RX FIFO
+    ULONG64 RxByteCount;                // bytes read from the RX FIFO
+    ULONG64 TxInterruptCount;           // interrupts that serviced the TX FIFO
+    ULONG64 TxByteCount;                // bytes written to the TX FIFO by the ISR
+    ULONG64 AgingTimerCount;            // AGTIM (aging timer) interrupts
+    ULONG64 RxOverrunCount;             // characters received with OVRRUN set
+    ULONG64 TxUnderrunCount;            // TX FIFO ran empty with data pending
+    ULONG64 FifoThresholdUpdateCount;   // adaptive RXTL/TXTL reprogrammings
+    ULONG64 RxDmaIdleCount;             // IDLE/AGTIM interrupts during RX DMA
+    ULONG RxBytesPerInterrupt;          // RxByteCount / RxInterruptCount
+    ULONG TxBytesPerInterrupt;          // TxByteCount / TxInterruptCount
+    ULONG RxFifoThreshold;              // current UFCR[RXTL]
+    ULONG TxFifoThreshold;              // current UFCR[TXTL]
+    BOOLEAN AdaptiveFifoThresholds;     // adaptive tuning is enabled
+} IMX_UART_STATISTICS;
+
+typedef IMX_UART_STATISTICS IMX_UART_GET_STATISTICS_OUTPUT;
+
+//
+// IOCTL_IMX_UART_CLEAR_STATISTICS
+//
+
+#define IOCTL_IMX_UART_CLEAR_STATISTICS \
+            CTL_CODE( \
+                FILE_DEVICE_SERIAL_PORT, \
+                IMX_UART_IOCTL_ID_CLEAR_STATISTICS, \
+                METHOD_BUFFERED, \
+                FILE_WRITE_DATA)
+
+//
+// IOCTL_IMX_UART_SET_FRAMED_RECEIVE
+//
+// Enables or disables framed receive mode. In framed receive mode a frame
+// ends when the line stays idle for IdleCharacters character times
+// (UCR1[ICD]), and received data is returned one frame at a time through
+// IOCTL_IMX_UART_READ_FRAME. IdleCharacters is rounded up to 4, 8, 16 or 32.
+// Enabling the mode discards buffered receive data, and while it is
+// enabled, read requests do not return data.
+//
+
+#define IOCTL_IMX_UART_SET_FRAMED_RECEIVE \
+            CTL_CODE( \
+                FILE_DEVICE_SERIAL_PORT, \
+                IMX_UART_IOCTL_ID_SET_FRAMED_RECEIVE, \
+                METHOD_BUFFERED, \
+                FILE_WRITE_DATA)
+
+typedef struct _IMX_UART_FRAMED_RECEIVE_INPUT {
+    BOOLEAN Enable;
+    ULONG IdleCharacters;               // idle gap that ends a frame
+} IMX_UART_FRAMED_RECEIVE_INPUT;
+
+//
+// IOCTL_IMX_UART_READ_FRAME
+//
+// Completes with one received frame: an IMX_UART_FRAME_HEADER followed by
+// the frame data. If the output buffer is too small for the whole frame,
+// the rest of the frame is discarded and IMX_UART_FRAME_FLAG_TRUNCATED
+// is set.
+//
+
+#define IOCTL_IMX_UART_READ_FRAME \
+            CTL_CODE( \
+                FILE_DEVICE_SERIAL_PORT, \
+                IMX_UART_IOCTL_ID_READ_FRAME, \
+                METHOD_OUT_DIRECT, \
+                FILE_READ_DATA)
+
+enum IMX_UART_FRAME_FLAGS : ULONG {
+    IMX_UART_FRAME_FLAG_TRUNCATED = 0x01,   // frame longer than the buffer
+    IMX_UART_FRAME_FLAG_ERROR = 0x02,       // framing/parity/break error
+    IMX_UART_FRAME_FLAG_OVERRUN = 0x04,     // bytes or a frame boundary were lost
+};
+
+typedef struct _IMX_UART_FRAME_HEADER {
+    ULONG Length;                       // frame bytes following the header
+    ULONG Flags;                        // IMX_UART_FRAME_FLAGS
+    LARGE_INTEGER Timestamp;            // QPC when the idle gap was detected
+} IMX_UART_FRAME_HEADER;
+
+#endif // _IMX_UART_IOCTL_H_
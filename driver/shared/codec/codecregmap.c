@@ -0,0 +1,485 @@
+/* Copyright (c) Microsoft Corporation. All rights reserved.
+   Licensed under the MIT License.
+
+Module Name:
+
+    codecregmap.c
+
+Abstract:
+
+    This module implements the register map shared by the I2C audio codec
+    drivers: a shadow of the codec registers and a queue of pending writes
+    that is sent to the codec as one SPB sequence.
+
+Environment:
+
+    User-mode Driver Framework 2
+
+*/
+
+#include <windows.h>
+#include <wdf.h>
+#include <spb.h>
+#include "codecregmap.h"
+
+static
+ULONG
+CodecRegMapEncodedLength(
+    _In_ const CODEC_REGMAP* RegMap
+    )
+{
+    return (RegMap->Format == CodecRegMapFormat7Addr9Data) ? 2 : 4;
+}
+
+static
+BOOLEAN
+CodecRegMapIsVolatile(
+    _In_ const CODEC_REGMAP* RegMap,
+    _In_ USHORT Address
+    )
+{
+    ULONG i;
+
+    for (i = 0; i < RegMap->VolatileRegisterCount; i++)
+    {
+        if (RegMap->VolatileRegisters[i] == Address)
+        {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+static
+PCODEC_REGMAP_ENTRY
+CodecRegMapFindEntry(
+    _In_ PCODEC_REGMAP RegMap,
+    _In_ USHORT Address
+    )
+{
+    ULONG i;
+
+    for (i = 0; i < RegMap->CacheCount; i++)
+    {
+        if (RegMap->Cache[i].Address == Address)
+        {
+            return &RegMap->Cache[i];
+        }
+    }
+
+    return NULL;
+}
+
+static
+VOID
+CodecRegMapShadow(
+    _Inout_ PCODEC_REGMAP RegMap,
+    _In_ USHORT Address,
+    _In_ USHORT Value
+    )
+{
+    PCODEC_REGMAP_ENTRY entry;
+
+    entry = CodecRegMapFindEntry(RegMap, Address);
+
+    if (entry == NULL)
+    {
+        //
+        // When the shadow is full the register is simply not cached and
+        // every write to it goes to the codec.
+        //
+        if (RegMap->CacheCount == CODEC_REGMAP_MAX_REGISTERS)
+        {
+            return;
+        }
+
+        entry = &RegMap->Cache[RegMap->CacheCount];
+        entry->Address = Address;
+        RegMap->CacheCount++;
+    }
+
+    entry->Value = Value;
+}
+
+VOID
+CodecRegMapInitialize(
+    _Out_ PCODEC_REGMAP RegMap,
+    _In_ WDFIOTARGET I2cTarget,
+    _In_ CODEC_REGMAP_FORMAT Format,
+    _In_reads_opt_(VolatileRegisterCount) const USHORT* VolatileRegisters,
+    _In_ ULONG VolatileRegisterCount
+    )
+/*++
+
+Routine Description:
+
+    Initializes an empty register map for a codec behind the given I2C target.
+
+Arguments:
+
+    RegMap - register map to initialize.
+
+    I2cTarget - opened SPB I/O target of the codec.
+
+    Format - how register address and value are encoded on the bus.
+
+    VolatileRegisters - registers that must always be written and whose write
+                        invalidates the shadowed values.
+
+    VolatileRegisterCount - number of entries in VolatileRegisters.
+
+Return Value:
+
+    VOID
+
+--*/
+{
+    RtlZeroMemory(RegMap, sizeof(*RegMap));
+
+    RegMap->I2cTarget = I2cTarget;
+    RegMap->Format = Format;
+    RegMap->VolatileRegisters = VolatileRegisters;
+    RegMap->VolatileRegisterCount = VolatileRegisterCount;
+}
+
+VOID
+CodecRegMapInvalidate(
+    _Inout_ PCODEC_REGMAP RegMap
+    )
+/*++
+
+Routine Description:
+
+    Drops all shadowed register values, e.g. after the codec was reset or
+    lost power. Pending writes are kept.
+
+Arguments:
+
+    RegMap - register map.
+
+Return Value:
+
+    VOID
+
+--*/
+{
+    RegMap->CacheCount = 0;
+}
+
+NTSTATUS
+CodecRegMapFlush(
+    _Inout_ PCODEC_REGMAP RegMap
+    )
+/*++
+
+Routine Description:
+
+    Sends all pending register writes to the codec. A single write is sent
+    as a plain write, several writes as one SPB sequence so that the bus is
+    acquired only once.
+
+Arguments:
+
+    RegMap - register map.
+
+Return Value:
+
+    NTSTATUS
+
+--*/
+{
+    SPB_TRANSFER_LIST_AND_ENTRIES(CODEC_REGMAP_MAX_BATCH) sequence;
+    ULONG_PTR bytesTransferred;
+    ULONG i;
+    ULONG length;
+    WDF_MEMORY_DESCRIPTOR memDescriptor;
+    NTSTATUS status;
+
+    if (RegMap->PendingCount == 0)
+    {
+        return STATUS_SUCCESS;
+    }
+
+    length = CodecRegMapEncodedLength(RegMap);
+
+    if (RegMap->PendingCount == 1)
+    {
+        WDF_MEMORY_DESCRIPTOR_INIT_BUFFER(&memDescriptor, &RegMap->PendingBytes[0][0], length);
+
+        status = WdfIoTargetSendWriteSynchronously(RegMap->I2cTarget, NULL, &memDescriptor, 0, NULL, &bytesTransferred);
+    }
+    else
+    {
+        SPB_TRANSFER_LIST_INIT(&sequence.List, RegMap->PendingCount);
+
+        for (i = 0; i < RegMap->PendingCount; i++)
+        {
+            sequence.List.Transfers[i] = SPB_TRANSFER_LIST_ENTRY_INIT_SIMPLE(
+                                             SpbTransferDirectionToDevice,
+                                             0,
+                                             &RegMap->PendingBytes[i][0],
+                                             length);
+        }
+
+        WDF_MEMORY_DESCRIPTOR_INIT_BUFFER(&memDescriptor, &sequence, sizeof(sequence));
+
+        status = WdfIoTargetSendIoctlSynchronously(RegMap->I2cTarget,
+                                                   NULL,
+                                                   IOCTL_SPB_EXECUTE_SEQUENCE,
+                                                   &memDescriptor,
+                                                   NULL,
+                                                   NULL,
+                                                   &bytesTransferred);
+    }
+
+    RegMap->BusRequestCount++;
+    RegMap->PendingCount = 0;
+
+    if (!NT_SUCCESS(status))
+    {
+        //
+        // Some of the queued values may not have reached the codec.
+        //
+        CodecRegMapInvalidate(RegMap);
+    }
+
+    return status;
+}
+
+NTSTATUS
+CodecRegMapWrite(
+    _Inout_ PCODEC_REGMAP RegMap,
+    _In_ USHORT Address,
+    _In_ USHORT Value
+    )
+/*++
+
+Routine Description:
+
+    Queues a register write. The write is skipped if the shadowed value of
+    the register already matches. Queued writes are sent when the queue is
+    full, when a volatile register is written, before a bus read, or by
+    CodecRegMapFlush.
+
+Arguments:
+
+    RegMap - register map.
+
+    Address - register address.
+
+    Value - value to write.
+
+Return Value:
+
+    NTSTATUS
+
+--*/
+{
+    PCODEC_REGMAP_ENTRY entry;
+    BOOLEAN isVolatile;
+    PUCHAR bytes;
+    NTSTATUS status;
+
+    RegMap->WriteCount++;
+
+    isVolatile = CodecRegMapIsVolatile(RegMap, Address);
+
+    if (!isVolatile)
+    {
+        entry = CodecRegMapFindEntry(RegMap, Address);
+
+        if ((entry != NULL) && (entry->Value == Value))
+        {
+            RegMap->WriteSkipCount++;
+            return STATUS_SUCCESS;
+        }
+    }
+
+    if (RegMap->PendingCount == CODEC_REGMAP_MAX_BATCH)
+    {
+        status = CodecRegMapFlush(RegMap);
+
+        if (!NT_SUCCESS(status))
+        {
+            return status;
+        }
+    }
+
+    bytes = &RegMap->PendingBytes[RegMap->PendingCount][0];
+
+    if (RegMap->Format == CodecRegMapFormat7Addr9Data)
+    {
+        bytes[0] = (UCHAR)((Address << 1) | ((Value & 0x1FF) >> 8));
+        bytes[1] = (UCHAR)(Value & 0xFF);
+    }
+    else
+    {
+        bytes[0] = (UCHAR)(Address >> 8);
+        bytes[1] = (UCHAR)(Address & 0xFF);
+        bytes[2] = (UCHAR)(Value >> 8);
+        bytes[3] = (UCHAR)(Value & 0xFF);
+    }
+
+    RegMap->PendingCount++;
+
+    if (isVolatile)
+    {
+        status = CodecRegMapFlush(RegMap);
+        CodecRegMapInvalidate(RegMap);
+        return status;
+    }
+
+    CodecRegMapShadow(RegMap, Address, Value);
+
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS
+CodecRegMapRead(
+    _Inout_ PCODEC_REGMAP RegMap,
+    _In_ USHORT Address,
+    _Out_ PUSHORT ValuePtr
+    )
+/*++
+
+Routine Description:
+
+    Returns the value of a register, from the shadow if it is known and
+    from the codec otherwise. Write-only codecs can only return shadowed
+    values.
+
+Arguments:
+
+    RegMap - register map.
+
+    Address - register address.
+
+    ValuePtr - receives the register value.
+
+Return Value:
+
+    NTSTATUS
+
+--*/
+{
+    UCHAR addressBytes[2];
+    ULONG_PTR bytesTransferred;
+    PCODEC_REGMAP_ENTRY entry;
+    WDF_MEMORY_DESCRIPTOR memDescriptor;
+    SPB_TRANSFER_LIST_AND_ENTRIES(2) sequence;
+    NTSTATUS status;
+    UCHAR valueBytes[2];
+
+    *ValuePtr = 0;
+
+    if (!CodecRegMapIsVolatile(RegMap, Address))
+    {
+        entry = CodecRegMapFindEntry(RegMap, Address);
+
+        if (entry != NULL)
+        {
+            *ValuePtr = entry->Value;
+            return STATUS_SUCCESS;
+        }
+    }
+
+    if (RegMap->Format == CodecRegMapFormat7Addr9Data)
+    {
+        return STATUS_NOT_SUPPORTED;
+    }
+
+    //
+    // Pending writes must reach the codec before it is read back.
+    //
+    status = CodecRegMapFlush(RegMap);
+
+    if (!NT_SUCCESS(status))
+    {
+        return status;
+    }
+
+    addressBytes[0] = (UCHAR)(Address >> 8);
+    addressBytes[1] = (UCHAR)(Address & 0xFF);
+
+    SPB_TRANSFER_LIST_INIT(&sequence.List, 2);
+    sequence.List.Transfers[0] = SPB_TRANSFER_LIST_ENTRY_INIT_SIMPLE(
+                                     SpbTransferDirectionToDevice,
+                                     0,
+                                     addressBytes,
+                                     sizeof(addressBytes));
+    sequence.List.Transfers[1] = SPB_TRANSFER_LIST_ENTRY_INIT_SIMPLE(
+                                     SpbTransferDirectionFromDevice,
+                                     0,
+                                     valueBytes,
+                                     sizeof(valueBytes));
+
+    WDF_MEMORY_DESCRIPTOR_INIT_BUFFER(&memDescriptor, &sequence, sizeof(sequence));
+
+    status = WdfIoTargetSendIoctlSynchronously(RegMap->I2cTarget,
+                                               NULL,
+                                               IOCTL_SPB_EXECUTE_SEQUENCE,
+                                               &memDescriptor,
+                                               NULL,
+                                               NULL,
+                                               &bytesTransferred);
+
+    RegMap->BusRequestCount++;
+
+    if (!NT_SUCCESS(status))
+    {
+        return status;
+    }
+
+    *ValuePtr = (USHORT)((valueBytes[0] << 8) | valueBytes[1]);
+
+    if (!CodecRegMapIsVolatile(RegMap, Address))
+    {
+        CodecRegMapShadow(RegMap, Address, *ValuePtr);
+    }
+
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS
+CodecRegMapUpdateBits(
+    _Inout_ PCODEC_REGMAP RegMap,
+    _In_ USHORT Address,
+    _In_ USHORT Mask,
+    _In_ USHORT Value
+    )
+/*++
+
+Routine Description:
+
+    Changes the bits selected by Mask in a register. The current value comes
+    from the shadow when it is known, so no bus read is needed.
+
+Arguments:
+
+    RegMap - register map.
+
+    Address - register address.
+
+    Mask - bits to change.
+
+    Value - new value of the bits selected by Mask.
+
+Return Value:
+
+    NTSTATUS
+
+--*/
+{
+    USHORT current;
+    NTSTATUS status;
+
+    status = CodecRegMapRead(RegMap, Address, &current);
+
+    if (!NT_SUCCESS(status))
+    {
+        return status;
+    }
+
+    return CodecRegMapWrite(RegMap, Address, (USHORT)((current & ~Mask) | (Value & Mask)));
+}
@@ -30,6 +30,7 @@
 #include "ECSPIhw.h"
 #include "ECSPIspb.h"
 #include "ECSPIdriver.h"
+#include "ECSPIdma.h"
 #include "ECSPIdevice.h"
 
 #ifdef ALLOC_PRAGMA
@@ -73,7 +74,10 @@ ECSPIEvtDevicePrepareHardware (
     ULONG numIntResourcesFound = 0;
     ULONG numMemResourcesFound = 0;
     ULONG numConnectionResourcesFound = 0;
+    ULONG numDmaResourcesFound = 0;
     const CM_PARTIAL_RESOURCE_DESCRIPTOR* memResourceDescPtr = nullptr;
+    const CM_PARTIAL_RESOURCE_DESCRIPTOR* dmaResourceDescPtrs[ECSPI_DMA_CHANNEL_COUNT] =
+        { nullptr };
     ULONG traceLogId = 0;
 
     for (ULONG resInx = 0; resInx < numResourses; ++resInx) {
@@ -191,6 +195,24 @@ ECSPIEvtDevicePrepareHardware (
             } // New CS GPIO pin entry
             break;
 
+        case CmResourceTypeDma:
+            //
+            // Optional SDMA request lines: RX, TX
+            //
+            if (numDmaResourcesFound >= ECSPI_DMA_CHANNEL_COUNT) {
+
+                ECSPI_LOG_ERROR(
+                    DRIVER_LOG_HANDLE,
+                    "Unexpected additional DMA resource %lu, expected %lu!",
+                    numDmaResourcesFound,
+                    ECSPI_DMA_CHANNEL_COUNT
+                    );
+                return STATUS_DEVICE_CONFIGURATION_ERROR;
+            }
+            dmaResourceDescPtrs[numDmaResourcesFound] = resDescPtr;
+            ++numDmaResourcesFound;
+            break;
+
         default:
             ECSPI_ASSERT(DRIVER_LOG_HANDLE, FALSE);
             break;
@@ -260,6 +282,39 @@ ECSPIEvtDevicePrepareHardware (
         PVOID(devExtPtr->ECSPIRegsPtr)
         );
 
+    //
+    // SDMA is optional, if not available or fails to initialize
+    // all transfers are done in PIO mode.
+    //
+    if (numDmaResourcesFound == ECSPI_DMA_CHANNEL_COUNT) {
+
+        status = ECSPIDmaInitialize(
+            devExtPtr,
+            memResourceDescPtr,
+            dmaResourceDescPtrs[ECSPI_DMA_RX],
+            dmaResourceDescPtrs[ECSPI_DMA_TX]
+            );
+        if (!NT_SUCCESS(status)) {
+
+            ECSPI_LOG_WARNING(
+                devExtPtr->IfrLogHandle,
+                "ECSPIDmaInitialize failed, using PIO mode. "
+                "status = %!STATUS!",
+                status
+                );
+            ECSPIDmaDeinitialize(devExtPtr);
+        }
+
+    } else if (numDmaResourcesFound != 0) {
+
+        ECSPI_LOG_WARNING(
+            devExtPtr->IfrLogHandle,
+            "Expected %lu DMA resources, found %lu, using PIO mode.",
+            ECSPI_DMA_CHANNEL_COUNT,
+            numDmaResourcesFound
+            );
+    }
+
     return STATUS_SUCCESS;
 }
 
@@ -295,6 +350,8 @@ ECSPIEvtDeviceReleaseHardware (
 
     UNREFERENCED_PARAMETER(ResourcesTranslated);
 
+    ECSPIDmaDeinitialize(devExtPtr);
+
     if (devExtPtr->ECSPIRegsPtr != nullptr) {
 
         MmUnmapIoSpace(
@@ -813,6 +870,11 @@ ECSPIEvtInterruptDpc (
         return;
     }
 
+    //
+    // Copy data received by a DMA read transfer
+    //
+    ECSPIDmaCompleteReadTransfer(devExtPtr);
+
     if (hwTimeOut) {
         ECSPISpbCompleteTransferRequest(
             requestPtr,
@@ -833,7 +895,8 @@ ECSPIEvtInterruptDpc (
 
         ECSPI_ASSERT(
             devExtPtr->IfrLogHandle,
-            ECSPISpbIsAllDataTransferred(transfer1Ptr)
+            ECSPISpbIsAllDataTransferred(transfer1Ptr) ||
+            !NT_SUCCESS(requestPtr->Status)
             );
         if (transfer2Ptr != nullptr) {
 
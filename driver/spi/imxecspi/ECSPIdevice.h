@@ -100,6 +100,11 @@ typedef struct _ECSPI_DEVICE_EXTENSION
     //
     WDFINTERRUPT WdfSpiInterrupt;
 
+    //
+    // ECSPI SDMA resources
+    //
+    ECSPI_DMA_CONTEXT DmaContext;
+
     //
     //  Runtime...
     //
@@ -0,0 +1,1221 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// Module Name:
+//
+//    ECSPIdma.cpp
+//
+// Abstract:
+//
+//    This module contains the implementation of the IMX ECSPI controller
+//    SDMA transfer mode.
+//    Long transfers are moved between an intermediate buffer and the
+//    ECSPI FIFOs by the SDMA, RX and TX DMA requests are driven
+//    by the ECSPI FIFO thresholds.
+//    This controller driver uses the SPB WDF class extension (SpbCx).
+//
+// Environment:
+//
+//    kernel-mode only
+//
+#include "precomp.h"
+#pragma hdrstop
+
+#define _ECSPI_DMA_CPP_
+
+// Logging header files
+#include "ECSPItrace.h"
+#include "ECSPIdma.tmh"
+
+// Common driver header files
+#include "ECSPIcommon.h"
+
+// Module specific header files
+#include "ECSPIhw.h"
+#include "ECSPIspb.h"
+#include "ECSPIdriver.h"
+#include "ECSPIdma.h"
+#include "ECSPIdevice.h"
+
+// SDMA configuration
+#include "HalExtiMXDmaCfg.h"
+
+
+#ifdef ALLOC_PRAGMA
+    #pragma alloc_text(PAGE, ECSPIDmaInitialize)
+    #pragma alloc_text(PAGE, ECSPIDmaDeinitialize)
+    #pragma alloc_text(PAGE, ECSPIpDmaCreateChannel)
+#endif
+
+
+//
+// Routine Description:
+//
+//  ECSPIDmaInitialize is called from ECSPIEvtDevicePrepareHardware
+//  to create the RX and TX DMA channels, when SDMA resources are
+//  available.
+//  The routine creates the WDF DMA objects, allocates the intermediate
+//  DMA buffers, and acquires the SDMA request lines.
+//  On failure the caller calls ECSPIDmaDeinitialize, and the driver
+//  continues in PIO mode.
+//
+// Arguments:
+//
+//  DevExtPtr - The device extension.
+//
+//  RegistersResourcePtr - The ECSPI registers resource descriptor.
+//
+//  RxDmaResourcePtr - The RX SDMA request line resource descriptor.
+//
+//  TxDmaResourcePtr - The TX SDMA request line resource descriptor.
+//
+// Return Value:
+//
+//  NTSTATUS
+//
+_Use_decl_annotations_
+NTSTATUS
+ECSPIDmaInitialize (
+    ECSPI_DEVICE_EXTENSION* DevExtPtr,
+    const CM_PARTIAL_RESOURCE_DESCRIPTOR* RegistersResourcePtr,
+    const CM_PARTIAL_RESOURCE_DESCRIPTOR* RxDmaResourcePtr,
+    const CM_PARTIAL_RESOURCE_DESCRIPTOR* TxDmaResourcePtr
+    )
+{
+    PAGED_CODE();
+
+    ECSPI_DMA_CONTEXT* dmaCtxPtr = &DevExtPtr->DmaContext;
+
+    RtlZeroMemory(dmaCtxPtr, sizeof(ECSPI_DMA_CONTEXT));
+
+    //
+    // RX DMA reads from RXDATA, TX DMA writes to TXDATA
+    //
+    PHYSICAL_ADDRESS rxDataPA;
+    rxDataPA.QuadPart = RegistersResourcePtr->u.Memory.Start.QuadPart +
+        FIELD_OFFSET(ECSPI_REGISTERS, RXDATA);
+
+    NTSTATUS status = ECSPIpDmaCreateChannel(
+        DevExtPtr,
+        &dmaCtxPtr->Channels[ECSPI_DMA_RX],
+        WdfDmaDirectionReadFromDevice,
+        rxDataPA,
+        RxDmaResourcePtr
+        );
+    if (!NT_SUCCESS(status)) {
+
+        return status;
+    }
+
+    PHYSICAL_ADDRESS txDataPA;
+    txDataPA.QuadPart = RegistersResourcePtr->u.Memory.Start.QuadPart +
+        FIELD_OFFSET(ECSPI_REGISTERS, TXDATA);
+
+    status = ECSPIpDmaCreateChannel(
+        DevExtPtr,
+        &dmaCtxPtr->Channels[ECSPI_DMA_TX],
+        WdfDmaDirectionWriteToDevice,
+        txDataPA,
+        TxDmaResourcePtr
+        );
+    if (!NT_SUCCESS(status)) {
+
+        return status;
+    }
+
+    dmaCtxPtr->IsEnabled = TRUE;
+
+    ECSPI_LOG_INFORMATION(
+        DevExtPtr->IfrLogHandle,
+        "SDMA enabled, RX request line %lu, TX request line %lu, "
+        "min transfer length %lu",
+        dmaCtxPtr->Channels[ECSPI_DMA_RX].DmaRequestLine,
+        dmaCtxPtr->Channels[ECSPI_DMA_TX].DmaRequestLine,
+        ECSPIDriverGetDmaMinTransferLength()
+        );
+
+    return STATUS_SUCCESS;
+}
+
+
+//
+// Routine Description:
+//
+//  ECSPIDmaDeinitialize is called from ECSPIEvtDeviceReleaseHardware,
+//  or when ECSPIDmaInitialize fails, to release the DMA resources.
+//  The WDF DMA objects are parented to the device and are not
+//  explicitly deleted.
+//
+// Arguments:
+//
+//  DevExtPtr - The device extension.
+//
+// Return Value:
+//
+_Use_decl_annotations_
+VOID
+ECSPIDmaDeinitialize (
+    ECSPI_DEVICE_EXTENSION* DevExtPtr
+    )
+{
+    PAGED_CODE();
+
+    ECSPI_DMA_CONTEXT* dmaCtxPtr = &DevExtPtr->DmaContext;
+
+    dmaCtxPtr->IsEnabled = FALSE;
+
+    for (ULONG chn = 0; chn < ECSPI_DMA_CHANNEL_COUNT; ++chn) {
+
+        ECSPI_DMA_CHANNEL* dmaChannelPtr = &dmaCtxPtr->Channels[chn];
+
+        ECSPI_ASSERT(
+            DevExtPtr->IfrLogHandle,
+            !dmaChannelPtr->IsActive
+            );
+
+        if (dmaChannelPtr->IsRequestLineAcquired) {
+
+            DMA_ADAPTER* dmaAdapterPtr = dmaChannelPtr->DmaAdapterPtr;
+            NTSTATUS status = dmaAdapterPtr->DmaOperations->ConfigureAdapterChannel(
+                dmaAdapterPtr,
+                SDMA_CFG_FUN_RELEASE_REQUEST_LINE,
+                &dmaChannelPtr->DmaRequestLine
+                );
+            if (!NT_SUCCESS(status)) {
+
+                ECSPI_LOG_ERROR(
+                    DevExtPtr->IfrLogHandle,
+                    "SDMA_CFG_FUN_RELEASE_REQUEST_LINE failed for line %lu. "
+                    "status = %!STATUS!",
+                    dmaChannelPtr->DmaRequestLine,
+                    status
+                    );
+            }
+            dmaChannelPtr->IsRequestLineAcquired = FALSE;
+        }
+
+        if (dmaChannelPtr->BufferMdlPtr != nullptr) {
+
+            IoFreeMdl(dmaChannelPtr->BufferMdlPtr);
+            dmaChannelPtr->BufferMdlPtr = nullptr;
+        }
+
+        if (dmaChannelPtr->BufferPtr != nullptr) {
+
+            MmFreeNonCachedMemory(
+                dmaChannelPtr->BufferPtr,
+                ECSPI_DMA_BUFFER_SIZE
+                );
+            dmaChannelPtr->BufferPtr = nullptr;
+        }
+
+        dmaChannelPtr->WdfDmaTransaction = NULL;
+        dmaChannelPtr->WdfDmaEnabler = NULL;
+        dmaChannelPtr->DmaAdapterPtr = nullptr;
+
+    } // For each DMA channel
+}
+
+
+//
+// Routine Description:
+//
+//  ECSPIDmaIsTransferEligible is called when a transfer is prepared to
+//  check if it should be done using DMA.
+//  DMA is used for transfers that:
+//  - Are at least DmaMinTransferLength bytes long, and fit the
+//    intermediate buffer.
+//  - Are a multiple of the FIFO word size, since in DMA mode every
+//    FIFO word is a separate 32 bit burst.
+//  - Use a GPIO CS line, since the controller negates its own CS
+//    line between bursts.
+//  - Are not part of a full duplex request.
+//
+// Arguments:
+//
+//  RequestPtr - The request the transfer belongs to.
+//
+//  TransferPtr - The transfer to check.
+//
+// Return Value:
+//
+//  TRUE if the transfer should be done using DMA, otherwise FALSE.
+//
+_Use_decl_annotations_
+BOOLEAN
+ECSPIDmaIsTransferEligible (
+    const ECSPI_SPB_REQUEST* RequestPtr,
+    const ECSPI_SPB_TRANSFER* TransferPtr
+    )
+{
+    const ECSPI_TARGET_CONTEXT* trgCtxPtr = RequestPtr->SpbTargetPtr;
+    const ECSPI_DEVICE_EXTENSION* devExtPtr = trgCtxPtr->DevExtPtr;
+
+    if (!devExtPtr->DmaContext.IsEnabled) {
+
+        return FALSE;
+    }
+
+    ULONG minTransferLength = ECSPIDriverGetDmaMinTransferLength();
+    if (minTransferLength == 0) {
+        //
+        // DMA disabled through registry
+        //
+        return FALSE;
+    }
+
+    if (RequestPtr->Type == ECSPI_REQUEST_TYPE::FULL_DUPLEX) {
+
+        return FALSE;
+    }
+
+    size_t length = TransferPtr->SpbTransferDescriptor.TransferLength;
+    if ((length < minTransferLength) ||
+        (length > ECSPI_DMA_BUFFER_SIZE) ||
+        ((length % sizeof(ULONG)) != 0)) {
+
+        return FALSE;
+    }
+
+    const ECSPI_CS_GPIO_PIN* csGpioPinPtr =
+        &devExtPtr->CsGpioPins[trgCtxPtr->Settings.DeviceSelection];
+    if (csGpioPinPtr->GpioConnectionId.QuadPart == 0) {
+
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+
+//
+// Routine Description:
+//
+//  ECSPIDmaStartTransfer is called by ECSPISpbStartNextTransfer to start
+//  a DMA transfer.
+//  Both RX and TX DMA channels are used for any transfer direction:
+//  A write transfer drains the RX FIFO into the RX buffer, and a read
+//  transfer sends zeros from the TX buffer.
+//  Transfer completion is reported by the RX DMA channel, after the
+//  last word has been shifted in, and the ECSPI DPC is scheduled
+//  to complete the transfer.
+//  The routine is called with the device lock held.
+//
+// Arguments:
+//
+//  DevExtPtr - The device extension.
+//
+//  TransferPtr - The transfer to start.
+//
+// Return Value:
+//
+//  STATUS_SUCCESS - DMA transfer started, or a TX DMA failure will be
+//      reported through the ECSPI DPC.
+//  Any other status - DMA could not be started, the caller should do the
+//      transfer in PIO mode.
+//
+_Use_decl_annotations_
+NTSTATUS
+ECSPIDmaStartTransfer (
+    ECSPI_DEVICE_EXTENSION* DevExtPtr,
+    ECSPI_SPB_TRANSFER* TransferPtr
+    )
+{
+    ECSPI_DMA_CONTEXT* dmaCtxPtr = &DevExtPtr->DmaContext;
+
+    if (InterlockedCompareExchange(
+            &dmaCtxPtr->PendingCount,
+            ECSPI_DMA_TRANSFER_REFERENCES,
+            0) != 0) {
+
+        ECSPI_LOG_WARNING(
+            DevExtPtr->IfrLogHandle,
+            "DMA is busy, transfer %p done in PIO mode",
+            TransferPtr
+            );
+        return STATUS_DEVICE_BUSY;
+    }
+
+    size_t length = TransferPtr->SpbTransferDescriptor.TransferLength;
+    size_t words = length / sizeof(ULONG);
+
+    dmaCtxPtr->TransferPtr = TransferPtr;
+    dmaCtxPtr->WatermarkWords = ECSPIpDmaGetWatermark(words);
+    dmaCtxPtr->IsAborted = FALSE;
+    dmaCtxPtr->Status = STATUS_SUCCESS;
+    dmaCtxPtr->IsRxDataPending = 0;
+
+    //
+    // Prepare the TX data
+    //
+    ULONG* txBufferPtr = static_cast<ULONG*>(
+        dmaCtxPtr->Channels[ECSPI_DMA_TX].BufferPtr
+        );
+    if (ECSPISpbIsWriteTransfer(TransferPtr)) {
+
+        ECSPIpDmaCopyMdl(
+            TransferPtr->CurrentMdlPtr,
+            reinterpret_cast<UCHAR*>(txBufferPtr),
+            length,
+            TRUE // MDL => Buffer
+            );
+        ECSPIHwDataSwapBuffer(txBufferPtr, words, TransferPtr->BufferStride);
+
+    } else {
+
+        RtlZeroMemory(txBufferPtr, length);
+
+        dmaCtxPtr->RxMdlPtr = TransferPtr->CurrentMdlPtr;
+        dmaCtxPtr->RxLength = length;
+        dmaCtxPtr->RxBufferStride = TransferPtr->BufferStride;
+    }
+
+    WdfInterruptAcquireLock(DevExtPtr->WdfSpiInterrupt);
+
+    ECSPIHwConfigureDmaTransfer(
+        DevExtPtr,
+        TransferPtr,
+        dmaCtxPtr->WatermarkWords
+        );
+
+    WdfInterruptReleaseLock(DevExtPtr->WdfSpiInterrupt);
+
+    ECSPI_LOG_TRACE(
+        DevExtPtr->IfrLogHandle,
+        "DMA transfer %p started: %s, length %Iu, watermark %lu words",
+        TransferPtr,
+        DIR2STR(TransferPtr->SpbTransferDescriptor.Direction),
+        length,
+        dmaCtxPtr->WatermarkWords
+        );
+
+    //
+    // RX first, so it is ready for the data TX DMA clocks in.
+    //
+    NTSTATUS status = ECSPIpDmaStartChannel(
+        &dmaCtxPtr->Channels[ECSPI_DMA_RX],
+        length
+        );
+    if (!NT_SUCCESS(status)) {
+
+        WdfInterruptAcquireLock(DevExtPtr->WdfSpiInterrupt);
+
+        ECSPIHwStopDma(DevExtPtr, TransferPtr);
+
+        WdfInterruptReleaseLock(DevExtPtr->WdfSpiInterrupt);
+
+        dmaCtxPtr->TransferPtr = nullptr;
+        InterlockedExchange(&dmaCtxPtr->PendingCount, 0);
+        return status;
+    }
+
+    status = ECSPIpDmaStartChannel(
+        &dmaCtxPtr->Channels[ECSPI_DMA_TX],
+        length
+        );
+    if (!NT_SUCCESS(status)) {
+        //
+        // RX DMA is already running, stop it, and let the
+        // completion path report the failure.
+        //
+        dmaCtxPtr->Status = status;
+        ECSPIpDmaDereference(DevExtPtr);
+
+        WdfDmaTransactionStopSystemTransfer(
+            dmaCtxPtr->Channels[ECSPI_DMA_RX].WdfDmaTransaction
+            );
+    }
+
+    return STATUS_SUCCESS;
+}
+
+
+//
+// Routine Description:
+//
+//  ECSPIDmaAbortTransfer is called by ECSPISpbAbortAllTransfers to
+//  stop the active DMA transfer, if any.
+//  Once aborted, the DMA completion does not update the transfer nor
+//  schedules the ECSPI DPC.
+//
+// Arguments:
+//
+//  DevExtPtr - The device extension.
+//
+// Return Value:
+//
+_Use_decl_annotations_
+VOID
+ECSPIDmaAbortTransfer (
+    ECSPI_DEVICE_EXTENSION* DevExtPtr
+    )
+{
+    ECSPI_DMA_CONTEXT* dmaCtxPtr = &DevExtPtr->DmaContext;
+
+    if (!dmaCtxPtr->IsEnabled) {
+
+        return;
+    }
+
+    WdfInterruptAcquireLock(DevExtPtr->WdfSpiInterrupt);
+
+    dmaCtxPtr->IsAborted = TRUE;
+
+    WdfInterruptReleaseLock(DevExtPtr->WdfSpiInterrupt);
+
+    if (!ECSPIpDmaReference(dmaCtxPtr)) {
+        //
+        // No DMA channel is active
+        //
+        return;
+    }
+
+    ECSPI_LOG_INFORMATION(
+        DevExtPtr->IfrLogHandle,
+        "Aborting DMA transfer %p",
+        dmaCtxPtr->TransferPtr
+        );
+
+    for (ULONG chn = 0; chn < ECSPI_DMA_CHANNEL_COUNT; ++chn) {
+
+        ECSPI_DMA_CHANNEL* dmaChannelPtr = &dmaCtxPtr->Channels[chn];
+
+        if (dmaChannelPtr->IsActive) {
+
+            WdfDmaTransactionStopSystemTransfer(
+                dmaChannelPtr->WdfDmaTransaction
+                );
+        }
+    }
+
+    ECSPIpDmaDereference(DevExtPtr);
+}
+
+
+//
+// Routine Description:
+//
+//  ECSPIDmaCompleteReadTransfer is called from the ECSPI DPC to copy
+//  the data received by a DMA read transfer to the transfer MDL(s).
+//  The copy is done at DISPATCH_LEVEL, after request cancellation has
+//  been disabled, to keep the time spent with the interrupt lock held
+//  short.
+//
+// Arguments:
+//
+//  DevExtPtr - The device extension.
+//
+// Return Value:
+//
+_Use_decl_annotations_
+VOID
+ECSPIDmaCompleteReadTransfer (
+    ECSPI_DEVICE_EXTENSION* DevExtPtr
+    )
+{
+    ECSPI_DMA_CONTEXT* dmaCtxPtr = &DevExtPtr->DmaContext;
+
+    if (InterlockedExchange(&dmaCtxPtr->IsRxDataPending, 0) == 0) {
+
+        return;
+    }
+
+    ULONG* rxBufferPtr = static_cast<ULONG*>(
+        dmaCtxPtr->Channels[ECSPI_DMA_RX].BufferPtr
+        );
+
+    ECSPIHwDataSwapBuffer(
+        rxBufferPtr,
+        dmaCtxPtr->RxLength / sizeof(ULONG),
+        dmaCtxPtr->RxBufferStride
+        );
+    ECSPIpDmaCopyMdl(
+        dmaCtxPtr->RxMdlPtr,
+        reinterpret_cast<UCHAR*>(rxBufferPtr),
+        dmaCtxPtr->RxLength,
+        FALSE // Buffer => MDL
+        );
+}
+
+
+//
+// ECSPIdma private methods
+// ------------------------
+//
+
+
+//
+// Routine Description:
+//
+//  ECSPIpDmaCreateChannel creates a single direction DMA channel.
+//
+// Arguments:
+//
+//  DevExtPtr - The device extension.
+//
+//  DmaChannelPtr - The DMA channel to initialize.
+//
+//  Direction - The DMA channel direction.
+//
+//  DeviceAddress - The FIFO data register physical address.
+//
+//  DmaResourcePtr - The SDMA request line resource descriptor.
+//
+// Return Value:
+//
+//  NTSTATUS
+//
+_Use_decl_annotations_
+NTSTATUS
+ECSPIpDmaCreateChannel (
+    ECSPI_DEVICE_EXTENSION* DevExtPtr,
+    ECSPI_DMA_CHANNEL* DmaChannelPtr,
+    WDF_DMA_DIRECTION Direction,
+    PHYSICAL_ADDRESS DeviceAddress,
+    const CM_PARTIAL_RESOURCE_DESCRIPTOR* DmaResourcePtr
+    )
+{
+    PAGED_CODE();
+
+    DmaChannelPtr->DevExtPtr = DevExtPtr;
+    DmaChannelPtr->Direction = Direction;
+
+    WDF_DMA_ENABLER_CONFIG wdfDmaEnablerConfig;
+    WDF_DMA_ENABLER_CONFIG_INIT(
+        &wdfDmaEnablerConfig,
+        WdfDmaProfileSystem,
+        ECSPI_DMA_BUFFER_SIZE
+        );
+    wdfDmaEnablerConfig.WdmDmaVersionOverride = DEVICE_DESCRIPTION_VERSION3;
+
+    NTSTATUS status = WdfDmaEnablerCreate(
+        DevExtPtr->WdfDevice,
+        &wdfDmaEnablerConfig,
+        WDF_NO_OBJECT_ATTRIBUTES,
+        &DmaChannelPtr->WdfDmaEnabler
+        );
+    if (!NT_SUCCESS(status)) {
+
+        ECSPI_LOG_ERROR(
+            DevExtPtr->IfrLogHandle,
+            "WdfDmaEnablerCreate failed. "
+            "status = %!STATUS!",
+            status
+            );
+        return status;
+    }
+
+    //
+    // Demand mode, the ECSPI FIFO thresholds drive the DMA requests.
+    // The ECSPI FIFOs are 32 bit wide.
+    //
+    WDF_DMA_SYSTEM_PROFILE_CONFIG wdfDmaSystemProfileConfig;
+    WDF_DMA_SYSTEM_PROFILE_CONFIG_INIT(
+        &wdfDmaSystemProfileConfig,
+        DeviceAddress,
+        Width32Bits,
+        const_cast<PCM_PARTIAL_RESOURCE_DESCRIPTOR>(DmaResourcePtr)
+        );
+    wdfDmaSystemProfileConfig.DemandMode = TRUE;
+
+    status = WdfDmaEnablerConfigureSystemProfile(
+        DmaChannelPtr->WdfDmaEnabler,
+        &wdfDmaSystemProfileConfig,
+        Direction
+        );
+    if (!NT_SUCCESS(status)) {
+
+        ECSPI_LOG_ERROR(
+            DevExtPtr->IfrLogHandle,
+            "WdfDmaEnablerConfigureSystemProfile failed. "
+            "status = %!STATUS!",
+            status
+            );
+        return status;
+    }
+
+    status = WdfDmaTransactionCreate(
+        DmaChannelPtr->WdfDmaEnabler,
+        WDF_NO_OBJECT_ATTRIBUTES,
+        &DmaChannelPtr->WdfDmaTransaction
+        );
+    if (!NT_SUCCESS(status)) {
+
+        ECSPI_LOG_ERROR(
+            DevExtPtr->IfrLogHandle,
+            "WdfDmaTransactionCreate failed. "
+            "status = %!STATUS!",
+            status
+            );
+        return status;
+    }
+
+    WdfDmaTransactionSetChannelConfigurationCallback(
+        DmaChannelPtr->WdfDmaTransaction,
+        ECSPIpDmaConfigureChannel,
+        DmaChannelPtr
+        );
+    WdfDmaTransactionSetTransferCompleteCallback(
+        DmaChannelPtr->WdfDmaTransaction,
+        ECSPIpDmaTransferComplete,
+        DmaChannelPtr
+        );
+
+    DmaChannelPtr->DmaAdapterPtr = WdfDmaEnablerWdmGetDmaAdapter(
+        DmaChannelPtr->WdfDmaEnabler,
+        Direction
+        );
+    DmaChannelPtr->DmaRequestLine = DmaResourcePtr->u.DmaV3.RequestLine;
+
+    //
+    // The intermediate DMA buffer
+    //
+    DmaChannelPtr->BufferPtr = MmAllocateNonCachedMemory(ECSPI_DMA_BUFFER_SIZE);
+    if (DmaChannelPtr->BufferPtr == nullptr) {
+
+        ECSPI_LOG_ERROR(
+            DevExtPtr->IfrLogHandle,
+            "Failed to allocate DMA buffer, size %lu",
+            ECSPI_DMA_BUFFER_SIZE
+            );
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    DmaChannelPtr->BufferMdlPtr = IoAllocateMdl(
+        DmaChannelPtr->BufferPtr,
+        ECSPI_DMA_BUFFER_SIZE,
+        FALSE,
+        FALSE,
+        nullptr
+        );
+    if (DmaChannelPtr->BufferMdlPtr == nullptr) {
+
+        ECSPI_LOG_ERROR(
+            DevExtPtr->IfrLogHandle,
+            "Failed to allocate DMA buffer MDL"
+            );
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+    MmBuildMdlForNonPagedPool(DmaChannelPtr->BufferMdlPtr);
+
+    //
+    // The ECSPI SDMA request lines may be shared with other
+    // peripherals, make sure we own it.
+    //
+    DMA_ADAPTER* dmaAdapterPtr = DmaChannelPtr->DmaAdapterPtr;
+    status = dmaAdapterPtr->DmaOperations->ConfigureAdapterChannel(
+        dmaAdapterPtr,
+        SDMA_CFG_FUN_ACQUIRE_REQUEST_LINE,
+        &DmaChannelPtr->DmaRequestLine
+        );
+    if (!NT_SUCCESS(status)) {
+
+        ECSPI_LOG_ERROR(
+            DevExtPtr->IfrLogHandle,
+            "SDMA_CFG_FUN_ACQUIRE_REQUEST_LINE failed for line %lu. "
+            "status = %!STATUS!",
+            DmaChannelPtr->DmaRequestLine,
+            status
+            );
+        return status;
+    }
+    DmaChannelPtr->IsRequestLineAcquired = TRUE;
+
+    return STATUS_SUCCESS;
+}
+
+
+//
+// Routine Description:
+//
+//  ECSPIpDmaStartChannel initializes and executes the channel DMA
+//  transaction on the intermediate buffer.
+//
+// Arguments:
+//
+//  DmaChannelPtr - The DMA channel.
+//
+//  Length - Number of bytes to transfer.
+//
+// Return Value:
+//
+//  NTSTATUS
+//
+_Use_decl_annotations_
+NTSTATUS
+ECSPIpDmaStartChannel (
+    ECSPI_DMA_CHANNEL* DmaChannelPtr,
+    size_t Length
+    )
+{
+    ECSPI_DEVICE_EXTENSION* devExtPtr = DmaChannelPtr->DevExtPtr;
+    WDFDMATRANSACTION wdfDmaTransaction = DmaChannelPtr->WdfDmaTransaction;
+
+    NTSTATUS status = WdfDmaTransactionInitializeUsingOffset(
+        wdfDmaTransaction,
+        ECSPIpDmaProgramDma,
+        DmaChannelPtr->Direction,
+        DmaChannelPtr->BufferMdlPtr,
+        0,
+        Length
+        );
+    if (!NT_SUCCESS(status)) {
+
+        ECSPI_LOG_ERROR(
+            devExtPtr->IfrLogHandle,
+            "WdfDmaTransactionInitializeUsingOffset failed. "
+            "status = %!STATUS!",
+            status
+            );
+        return status;
+    }
+
+    DmaChannelPtr->IsActive = TRUE;
+
+    WdfDmaTransactionSetImmediateExecution(wdfDmaTransaction, TRUE);
+    status = WdfDmaTransactionExecute(wdfDmaTransaction, DmaChannelPtr);
+    if (!NT_SUCCESS(status)) {
+
+        DmaChannelPtr->IsActive = FALSE;
+        WdfDmaTransactionRelease(wdfDmaTransaction);
+
+        ECSPI_LOG_ERROR(
+            devExtPtr->IfrLogHandle,
+            "WdfDmaTransactionExecute failed. "
+            "status = %!STATUS!",
+            status
+            );
+        return status;
+    }
+
+    return STATUS_SUCCESS;
+}
+
+
+//
+// Routine Description:
+//
+//  ECSPIpDmaReference takes a reference on the active DMA transfer,
+//  if the transfer channels have not all completed yet.
+//
+// Arguments:
+//
+//  DmaCtxPtr - The DMA context.
+//
+// Return Value:
+//
+//  TRUE if a reference was taken, otherwise FALSE.
+//
+_Use_decl_annotations_
+BOOLEAN
+ECSPIpDmaReference (
+    ECSPI_DMA_CONTEXT* DmaCtxPtr
+    )
+{
+    for (;;) {
+
+        LONG pendingCount = DmaCtxPtr->PendingCount;
+        if (pendingCount <= 1) {
+            //
+            // Idle, or completion processing in progress
+            //
+            return FALSE;
+        }
+
+        if (InterlockedCompareExchange(
+                &DmaCtxPtr->PendingCount,
+                pendingCount + 1,
+                pendingCount) == pendingCount) {
+
+            return TRUE;
+        }
+    }
+}
+
+
+//
+// Routine Description:
+//
+//  ECSPIpDmaDereference releases a reference on the active DMA transfer.
+//  When only the completion reference is left, the transfer
+//  completion is processed.
+//
+// Arguments:
+//
+//  DevExtPtr - The device extension.
+//
+// Return Value:
+//
+_Use_decl_annotations_
+VOID
+ECSPIpDmaDereference (
+    ECSPI_DEVICE_EXTENSION* DevExtPtr
+    )
+{
+    ECSPI_DMA_CONTEXT* dmaCtxPtr = &DevExtPtr->DmaContext;
+
+    LONG pendingCount = InterlockedDecrement(&dmaCtxPtr->PendingCount);
+
+    ECSPI_ASSERT(DevExtPtr->IfrLogHandle, pendingCount > 0);
+
+    if (pendingCount == 1) {
+
+        ECSPIpDmaCompleteTransfer(DevExtPtr);
+    }
+}
+
+
+//
+// Routine Description:
+//
+//  ECSPIpDmaCompleteTransfer is called when both DMA channels are done.
+//  If the transfer has not been aborted, the routine restores the
+//  controller PIO configuration, updates the transfer/request progress,
+//  and schedules the ECSPI DPC to continue the request processing.
+//  The routine does not acquire the device lock, since it may be called
+//  from ECSPIDmaStartTransfer and ECSPIDmaAbortTransfer, with
+//  the device lock held.
+//
+// Arguments:
+//
+//  DevExtPtr - The device extension.
+//
+// Return Value:
+//
+_Use_decl_annotations_
+VOID
+ECSPIpDmaCompleteTransfer (
+    ECSPI_DEVICE_EXTENSION* DevExtPtr
+    )
+{
+    ECSPI_DMA_CONTEXT* dmaCtxPtr = &DevExtPtr->DmaContext;
+    ECSPI_SPB_TRANSFER* transferPtr = dmaCtxPtr->TransferPtr;
+    NTSTATUS status = dmaCtxPtr->Status;
+
+    ECSPI_ASSERT(DevExtPtr->IfrLogHandle, transferPtr != nullptr);
+
+    WdfInterruptAcquireLock(DevExtPtr->WdfSpiInterrupt);
+
+    if (!dmaCtxPtr->IsAborted) {
+
+        ECSPI_SPB_REQUEST* requestPtr = transferPtr->AssociatedRequestPtr;
+
+        ECSPIHwStopDma(DevExtPtr, transferPtr);
+
+        if (NT_SUCCESS(status)) {
+
+            size_t length = transferPtr->SpbTransferDescriptor.TransferLength;
+
+            transferPtr->BytesTransferred = length;
+            transferPtr->BytesLeftInBurst = 0;
+            requestPtr->TotalBytesTransferred += length;
+
+            if (!ECSPISpbIsWriteTransfer(transferPtr)) {
+
+                InterlockedExchange(&dmaCtxPtr->IsRxDataPending, 1);
+            }
+
+            if (requestPtr->Type == ECSPI_REQUEST_TYPE::SEQUENCE) {
+
+                ECSPISpbCompleteSequenceTransfer(transferPtr);
+            }
+
+        } else {
+
+            ECSPI_LOG_ERROR(
+                DevExtPtr->IfrLogHandle,
+                "DMA transfer %p failed. status = %!STATUS!",
+                transferPtr,
+                status
+                );
+
+            requestPtr->Status = status;
+            requestPtr->TransfersLeft = 0;
+        }
+
+        ECSPI_LOG_TRACE(
+            DevExtPtr->IfrLogHandle,
+            "DMA transfer %p done, status = %!STATUS!",
+            transferPtr,
+            status
+            );
+
+        //
+        // Continue in DPC...
+        //
+        WdfInterruptQueueDpcForIsr(DevExtPtr->WdfSpiInterrupt);
+    }
+
+    dmaCtxPtr->TransferPtr = nullptr;
+
+    WdfInterruptReleaseLock(DevExtPtr->WdfSpiInterrupt);
+
+    //
+    // Release the completion reference, DMA can be used again.
+    //
+    InterlockedExchange(&dmaCtxPtr->PendingCount, 0);
+}
+
+
+//
+// Routine Description:
+//
+//  ECSPIpDmaGetWatermark calculates the DMA request watermark.
+//  The watermark is the largest number of words, up to half the
+//  FIFO depth, the transfer word count is a multiple of, so the
+//  last RX DMA request is issued when the last word is received.
+//
+// Arguments:
+//
+//  TransferWords - Transfer length (FIFO words).
+//
+// Return Value:
+//
+//  The DMA request watermark (FIFO words).
+//
+_Use_decl_annotations_
+ULONG
+ECSPIpDmaGetWatermark (
+    size_t TransferWords
+    )
+{
+    for (ULONG watermark = ECSPI_DMA_MAX_WATERMARK_WORDS;
+         watermark > 1;
+         --watermark) {
+
+        if ((TransferWords % watermark) == 0) {
+
+            return watermark;
+        }
+    }
+
+    return 1;
+}
+
+
+//
+// Routine Description:
+//
+//  ECSPIpDmaCopyMdl copies data between a transfer MDL chain and a DMA
+//  intermediate buffer.
+//  The transfer MDLs have been mapped by ECSPISpbPrepareNextTransfer.
+//
+// Arguments:
+//
+//  MdlPtr - The first MDL of the transfer.
+//
+//  BufferPtr - The DMA buffer.
+//
+//  Length - Number of bytes to copy.
+//
+//  IsToBuffer - TRUE to copy from MDL to the buffer, FALSE to copy from
+//      the buffer to the MDL.
+//
+// Return Value:
+//
+_Use_decl_annotations_
+VOID
+ECSPIpDmaCopyMdl (
+    PMDL MdlPtr,
+    UCHAR* BufferPtr,
+    size_t Length,
+    BOOLEAN IsToBuffer
+    )
+{
+    size_t bytesLeft = Length;
+
+    while ((MdlPtr != nullptr) && (bytesLeft > 0)) {
+
+        UCHAR* mdlAddr = static_cast<UCHAR*>(MdlPtr->MappedSystemVa);
+        size_t bytesToCopy = min(MmGetMdlByteCount(MdlPtr), bytesLeft);
+
+        if (IsToBuffer) {
+
+            RtlCopyMemory(BufferPtr, mdlAddr, bytesToCopy);
+
+        } else {
+
+            RtlCopyMemory(mdlAddr, BufferPtr, bytesToCopy);
+        }
+
+        BufferPtr += bytesToCopy;
+        bytesLeft -= bytesToCopy;
+        MdlPtr = MdlPtr->Next;
+
+    } // More MDLs
+
+    NT_ASSERT(bytesLeft == 0);
+}
+
+
+//
+// Routine Description:
+//
+//  ECSPIpDmaProgramDma is the WDF DMA program callback.
+//  System DMA is programmed by the HAL, nothing to do.
+//
+// Arguments:
+//
+//  WdfDmaTransaction - The DMA transaction.
+//
+//  WdfDevice - The WDF device.
+//
+//  Context - The DMA channel.
+//
+//  Direction - Transfer direction.
+//
+//  SgListPtr - The transfer scatter/gather list.
+//
+// Return Value:
+//
+//  TRUE
+//
+_Use_decl_annotations_
+BOOLEAN
+ECSPIpDmaProgramDma (
+    WDFDMATRANSACTION /*WdfDmaTransaction*/,
+    WDFDEVICE /*WdfDevice*/,
+    WDFCONTEXT /*Context*/,
+    WDF_DMA_DIRECTION /*Direction*/,
+    PSCATTER_GATHER_LIST /*SgListPtr*/
+    )
+{
+    return TRUE;
+}
+
+
+//
+// Routine Description:
+//
+//  ECSPIpDmaConfigureChannel is the WDF DMA channel configuration callback.
+//  The routine sets the SDMA channel watermark to match the ECSPI
+//  FIFO DMA thresholds.
+//
+// Arguments:
+//
+//  WdfDmaTransaction - The DMA transaction.
+//
+//  WdfDevice - The WDF device.
+//
+//  ContextPtr - The DMA channel.
+//
+//  MdlPtr - The transfer MDL.
+//
+//  Offset - The transfer offset.
+//
+//  Length - The transfer length.
+//
+// Return Value:
+//
+//  TRUE if channel was successfully configured, otherwise FALSE.
+//
+_Use_decl_annotations_
+BOOLEAN
+ECSPIpDmaConfigureChannel (
+    WDFDMATRANSACTION /*WdfDmaTransaction*/,
+    WDFDEVICE /*WdfDevice*/,
+    PVOID ContextPtr,
+    PMDL /*MdlPtr*/,
+    size_t /*Offset*/,
+    size_t /*Length*/
+    )
+{
+    ECSPI_DMA_CHANNEL* dmaChannelPtr = static_cast<ECSPI_DMA_CHANNEL*>(ContextPtr);
+    ECSPI_DEVICE_EXTENSION* devExtPtr = dmaChannelPtr->DevExtPtr;
+
+    //
+    // SDMA watermark is in bytes
+    //
+    ULONG watermarkLevel = devExtPtr->DmaContext.WatermarkWords * sizeof(ULONG);
+
+    DMA_ADAPTER* dmaAdapterPtr = dmaChannelPtr->DmaAdapterPtr;
+    NTSTATUS status = dmaAdapterPtr->DmaOperations->ConfigureAdapterChannel(
+        dmaAdapterPtr,
+        SDMA_CFG_FUN_SET_CHANNEL_WATERMARK_LEVEL,
+        &watermarkLevel
+        );
+    if (!NT_SUCCESS(status)) {
+
+        ECSPI_LOG_ERROR(
+            devExtPtr->IfrLogHandle,
+            "SDMA_CFG_FUN_SET_CHANNEL_WATERMARK_LEVEL failed. "
+            "status = %!STATUS!",
+            status
+            );
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+
+//
+// Routine Description:
+//
+//  ECSPIpDmaTransferComplete is the WDF DMA transfer complete callback.
+//  It is called when a channel completes, or after it has been stopped.
+//
+// Arguments:
+//
+//  WdfDmaTransaction - The DMA transaction.
+//
+//  WdfDevice - The WDF device.
+//
+//  Context - The DMA channel.
+//
+//  Direction - Transfer direction.
+//
+//  DmaStatus - DMA completion status.
+//
+// Return Value:
+//
+_Use_decl_annotations_
+VOID
+ECSPIpDmaTransferComplete (
+    WDFDMATRANSACTION WdfDmaTransaction,
+    WDFDEVICE /*WdfDevice*/,
+    WDFCONTEXT Context,
+    WDF_DMA_DIRECTION /*Direction*/,
+    DMA_COMPLETION_STATUS DmaStatus
+    )
+{
+    ECSPI_DMA_CHANNEL* dmaChannelPtr = static_cast<ECSPI_DMA_CHANNEL*>(Context);
+    ECSPI_DEVICE_EXTENSION* devExtPtr = dmaChannelPtr->DevExtPtr;
+    NTSTATUS status;
+
+    if (DmaStatus == DmaComplete) {
+
+        if (!WdfDmaTransactionDmaCompleted(WdfDmaTransaction, &status)) {
+            //
+            // More stages to go...
+            //
+            return;
+        }
+
+    } else {
+
+        (void)WdfDmaTransactionDmaCompletedFinal(
+            WdfDmaTransaction,
+            WdfDmaTransactionGetBytesTransferred(WdfDmaTransaction),
+            &status
+            );
+        if (NT_SUCCESS(status)) {
+
+            status = STATUS_CANCELLED;
+        }
+    }
+
+    dmaChannelPtr->IsActive = FALSE;
+    WdfDmaTransactionRelease(WdfDmaTransaction);
+
+    if (!NT_SUCCESS(status)) {
+
+        InterlockedCompareExchange(
+            reinterpret_cast<volatile LONG*>(&devExtPtr->DmaContext.Status),
+            status,
+            STATUS_SUCCESS
+            );
+    }
+
+    ECSPIpDmaDereference(devExtPtr);
+}
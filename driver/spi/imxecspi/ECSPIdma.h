@@ -0,0 +1,273 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//
+// Module Name:
+//
+//    ECSPIdma.h
+//
+// Abstract:
+//
+//    This module contains all the enums, types, and functions related to
+//    the IMX ECSPI controller SDMA transfer mode.
+//    This controller driver uses the SPB WDF class extension (SpbCx).
+//
+// Environment:
+//
+//    kernel-mode only
+//
+
+#ifndef _ECSPI_DMA_H_
+#define _ECSPI_DMA_H_
+
+WDF_EXTERN_C_START
+
+
+//
+// ECSPI_DMA_CHANNEL_ID.
+//  The SDMA request lines are listed in ACPI in this order.
+//
+enum ECSPI_DMA_CHANNEL_ID : ULONG {
+    ECSPI_DMA_RX = 0,
+    ECSPI_DMA_TX = 1,
+
+    ECSPI_DMA_CHANNEL_COUNT = 2
+};
+
+
+//
+// ECSPI DMA configuration parameters
+//
+enum : ULONG {
+    //
+    // Transfer reference count initial value:
+    // RX + TX channels, and the completion reference.
+    //
+    ECSPI_DMA_TRANSFER_REFERENCES = ECSPI_DMA_CHANNEL_COUNT + 1,
+
+    //
+    // Size of each of the RX/TX DMA intermediate buffers, which
+    // is also the longest transfer that can use DMA.
+    //
+    ECSPI_DMA_BUFFER_SIZE = 64 * 1024,
+
+    //
+    // Default shortest transfer (bytes) that uses DMA,
+    // shorter transfers are done in PIO mode.
+    //
+    ECSPI_DMA_DEFAULT_MIN_TRANSFER_LENGTH = 1024,
+
+    //
+    // Max DMA request watermark (FIFO words)
+    //
+    ECSPI_DMA_MAX_WATERMARK_WORDS = ECSPI_FIFO_DEPTH / 2,
+};
+
+
+//
+// ECSPI_DMA_CHANNEL.
+//  A single direction (RX/TX) system DMA channel.
+//
+typedef struct _ECSPI_DMA_CHANNEL
+{
+    //
+    // The device extension
+    //
+    ECSPI_DEVICE_EXTENSION* DevExtPtr;
+
+    //
+    // Transfer direction
+    //
+    WDF_DMA_DIRECTION Direction;
+
+    //
+    // WDF DMA objects
+    //
+    WDFDMAENABLER WdfDmaEnabler;
+    WDFDMATRANSACTION WdfDmaTransaction;
+    DMA_ADAPTER* DmaAdapterPtr;
+
+    //
+    // The SDMA request line, and if we own it
+    //
+    ULONG DmaRequestLine;
+    BOOLEAN IsRequestLineAcquired;
+
+    //
+    // If the DMA transaction is initialized
+    //
+    BOOLEAN IsActive;
+
+    //
+    // The intermediate (non cached) DMA buffer, and its MDL
+    //
+    VOID* BufferPtr;
+    PMDL BufferMdlPtr;
+
+} ECSPI_DMA_CHANNEL;
+
+
+//
+// ECSPI_DMA_CONTEXT.
+//  Contains all the ECSPI DMA resources, and the
+//  active DMA transfer runtime parameters.
+//
+typedef struct _ECSPI_DMA_CONTEXT
+{
+    //
+    // If DMA resources are available
+    //
+    BOOLEAN IsEnabled;
+
+    //
+    // RX/TX DMA channels
+    //
+    ECSPI_DMA_CHANNEL Channels[ECSPI_DMA_CHANNEL_COUNT];
+
+    //
+    //  Runtime...
+    //
+
+    //
+    // The active DMA transfer
+    //
+    ECSPI_SPB_TRANSFER* TransferPtr;
+
+    //
+    // DMA request watermark (FIFO words)
+    //
+    ULONG WatermarkWords;
+
+    //
+    // DMA transfer reference count:
+    // - One for each active DMA channel.
+    // - One held by ECSPIDmaAbortTransfer while stopping the channels.
+    // - One released when the transfer completion processing is done.
+    // 0 means DMA is not in use.
+    //
+    volatile LONG PendingCount;
+
+    //
+    // If the transfer has been aborted, protected by the
+    // interrupt lock.
+    //
+    BOOLEAN IsAborted;
+
+    //
+    // DMA transfer status
+    //
+    volatile NTSTATUS Status;
+
+    //
+    // RX data waiting to be copied to the transfer MDL(s)
+    //
+    volatile LONG IsRxDataPending;
+    PMDL RxMdlPtr;
+    size_t RxLength;
+    ULONG RxBufferStride;
+
+} ECSPI_DMA_CONTEXT;
+
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+NTSTATUS
+ECSPIDmaInitialize (
+    _In_ ECSPI_DEVICE_EXTENSION* DevExtPtr,
+    _In_ const CM_PARTIAL_RESOURCE_DESCRIPTOR* RegistersResourcePtr,
+    _In_ const CM_PARTIAL_RESOURCE_DESCRIPTOR* RxDmaResourcePtr,
+    _In_ const CM_PARTIAL_RESOURCE_DESCRIPTOR* TxDmaResourcePtr
+    );
+
+_IRQL_requires_max_(PASSIVE_LEVEL)
+VOID
+ECSPIDmaDeinitialize (
+    _In_ ECSPI_DEVICE_EXTENSION* DevExtPtr
+    );
+
+BOOLEAN
+ECSPIDmaIsTransferEligible (
+    _In_ const ECSPI_SPB_REQUEST* RequestPtr,
+    _In_ const ECSPI_SPB_TRANSFER* TransferPtr
+    );
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+NTSTATUS
+ECSPIDmaStartTransfer (
+    _In_ ECSPI_DEVICE_EXTENSION* DevExtPtr,
+    _In_ ECSPI_SPB_TRANSFER* TransferPtr
+    );
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+VOID
+ECSPIDmaAbortTransfer (
+    _In_ ECSPI_DEVICE_EXTENSION* DevExtPtr
+    );
+
+_IRQL_requires_max_(DISPATCH_LEVEL)
+VOID
+ECSPIDmaCompleteReadTransfer (
+    _In_ ECSPI_DEVICE_EXTENSION* DevExtPtr
+    );
+
+
+//
+// ECSPIdma private methods
+//
+#ifdef _ECSPI_DMA_CPP_
+
+    _IRQL_requires_max_(PASSIVE_LEVEL)
+    static NTSTATUS
+    ECSPIpDmaCreateChannel (
+        _In_ ECSPI_DEVICE_EXTENSION* DevExtPtr,
+        _In_ ECSPI_DMA_CHANNEL* DmaChannelPtr,
+        _In_ WDF_DMA_DIRECTION Direction,
+        _In_ PHYSICAL_ADDRESS DeviceAddress,
+        _In_ const CM_PARTIAL_RESOURCE_DESCRIPTOR* DmaResourcePtr
+        );
+
+    _IRQL_requires_max_(DISPATCH_LEVEL)
+    static NTSTATUS
+    ECSPIpDmaStartChannel (
+        _In_ ECSPI_DMA_CHANNEL* DmaChannelPtr,
+        _In_ size_t Length
+        );
+
+    _IRQL_requires_max_(DISPATCH_LEVEL)
+    static BOOLEAN
+    ECSPIpDmaReference (
+        _In_ ECSPI_DMA_CONTEXT* DmaCtxPtr
+        );
+
+    _IRQL_requires_max_(DISPATCH_LEVEL)
+    static VOID
+    ECSPIpDmaDereference (
+        _In_ ECSPI_DEVICE_EXTENSION* DevExtPtr
+        );
+
+    _IRQL_requires_max_(DISPATCH_LEVEL)
+    static VOID
+    ECSPIpDmaCompleteTransfer (
+        _In_ ECSPI_DEVICE_EXTENSION* DevExtPtr
+        );
+
+    static ULONG
+    ECSPIpDmaGetWatermark (
+        _In_ size_t TransferWords
+        );
+
+    static VOID
+    ECSPIpDmaCopyMdl (
+        _In_ PMDL MdlPtr,
+        _Inout_updates_bytes_(Length) UCHAR* BufferPtr,
+        _In_ size_t Length,
+        _In_ BOOLEAN IsToBuffer
+        );
+
+    static EVT_WDF_PROGRAM_DMA ECSPIpDmaProgramDma;
+    static EVT_WDF_DMA_TRANSACTION_CONFIGURE_DMA_CHANNEL ECSPIpDmaConfigureChannel;
+    static EVT_WDF_DMA_TRANSACTION_DMA_TRANSFER_COMPLETE ECSPIpDmaTransferComplete;
+
+#endif // _ECSPI_DMA_CPP_
+
+WDF_EXTERN_C_END
+
+#endif // !_ECSPI_DMA_H_
@@ -30,6 +30,7 @@
 #include "ECSPIhw.h"
 #include "ECSPIspb.h"
 #include "ECSPIdriver.h"
+#include "ECSPIdma.h"
 #include "ECSPIdevice.h"
 
 
@@ -475,6 +476,12 @@ ECSPIpDriverReadConfig ()
             FIELD_SIZE(ECSPI_DRIVER_EXTENSION, Flags),
             0,
         },
+        {
+            REGSTR_VAL_DMA_MIN_TRANSFER_LENGTH,
+            &drvExtPtr->DmaMinTransferLength,
+            FIELD_SIZE(ECSPI_DRIVER_EXTENSION, DmaMinTransferLength),
+            ECSPI_DMA_DEFAULT_MIN_TRANSFER_LENGTH,
+        },
 
     }; // regValues
 
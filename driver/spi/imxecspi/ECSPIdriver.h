@@ -26,6 +26,7 @@ WDF_EXTERN_C_START
 #define REGSTR_VAL_REFERENCE_CLOCK_HZ L"ReferenceClockHz"
 #define REGSTR_VAL_REFERENCE_MAX_SPEED_HZ L"MaxSpeedHz"
 #define REGSTR_VAL_FLAGS L"Flags"
+#define REGSTR_VAL_DMA_MIN_TRANSFER_LENGTH L"DmaMinTransferLength"
 
 
 //
@@ -75,6 +76,13 @@ typedef struct _ECSPI_DRIVER_EXTENSION
     //
     ULONG Flags;
 
+    //
+    // Shortest transfer (bytes) that uses DMA, when
+    // SDMA resources are available.
+    // Optional, 0 disables DMA.
+    //
+    ULONG DmaMinTransferLength;
+
 } ECSPI_DRIVER_EXTENSION;
 
 WDF_DECLARE_CONTEXT_TYPE_WITH_NAME(ECSPI_DRIVER_EXTENSION, ECSPIDriverGetExtension);
@@ -155,6 +163,25 @@ ECSPIDriverGetFlags ()
     return ECSPIDriverGetDriverExtension()->Flags;
 }
 
+//
+// Routine Description:
+//
+//  ECSPIDriverGetDmaMinTransferLength returns the shortest transfer
+//  length that uses DMA.
+//
+// Arguments:
+//
+// Return Value:
+//
+//  Min DMA transfer length in bytes, 0 if DMA is disabled.
+//
+__forceinline
+ULONG
+ECSPIDriverGetDmaMinTransferLength ()
+{
+    return ECSPIDriverGetDriverExtension()->DmaMinTransferLength;
+}
+
 //
 // Routine Description:
 //
@@ -31,6 +31,7 @@
 #include "ECSPIhw.h"
 #include "ECSPIspb.h"
 #include "ECSPIdriver.h"
+#include "ECSPIdma.h"
 #include "ECSPIdevice.h"
 
 
@@ -591,18 +592,34 @@ ECSPIHwWriteTxFIFO (
     while ((maxWordsToWrite != 0) &&
            !ECSPISpbIsAllDataTransferred(TransferPtr)) {
 
-        ULONG txFifoWord;
-        ULONG bytesRead = ECSPIpHwReadWordFromMdl(TransferPtr, &txFifoWord);
+        //
+        // Whole words from a contiguous MDL span first, a single 
+        // word at a time for partial words and MDL boundaries.
+        //
+        ULONG bytesRead = ECSPIpHwWriteTxFifoFast(
+            DevExtPtr,
+            TransferPtr,
+            maxWordsToWrite
+            );
+        if (bytesRead != 0) {
 
-        WRITE_REGISTER_NOFENCE_ULONG(txDataRegPtr, txFifoWord);
-        --TransferPtr->BurstWords;
+            maxWordsToWrite -= bytesRead / sizeof(ULONG);
+
+        } else {
+
+            ULONG txFifoWord;
+            bytesRead = ECSPIpHwReadWordFromMdl(TransferPtr, &txFifoWord);
 
-        ECSPIpHwUpdateTransfer(TransferPtr, bytesRead);
+            WRITE_REGISTER_NOFENCE_ULONG(txDataRegPtr, txFifoWord);
+            --TransferPtr->BurstWords;
+
+            ECSPIpHwUpdateTransfer(TransferPtr, bytesRead);
+            --maxWordsToWrite;
+        }
 
         ECSPIpHwStartBurstIf(DevExtPtr, TransferPtr);
 
         totalBytesRead += bytesRead;
-        --maxWordsToWrite;
     }
     requestPtr->TotalBytesTransferred += totalBytesRead;
 
@@ -651,10 +668,22 @@ ECSPIHwReadRxFIFO (
     while (!ECSPIHwIsRxFifoEmpty(ecspiRegsPtr) && 
            !ECSPISpbIsAllDataTransferred(TransferPtr)) {
 
-        ULONG rxFifoWord = READ_REGISTER_NOFENCE_ULONG(rxDataRegPtr);
-        ULONG bytesWritten = ECSPIpHwWriteWordToMdl(TransferPtr, rxFifoWord);
+        //
+        // Whole words to a contiguous MDL span first, a single 
+        // word at a time for partial words and MDL boundaries.
+        //
+        ULONG bytesWritten = ECSPIpHwReadRxFifoFast(
+            DevExtPtr,
+            TransferPtr,
+            ECSPIHwQueryRxFifoCount(ecspiRegsPtr)
+            );
+        if (bytesWritten == 0) {
 
-        ECSPIpHwUpdateTransfer(TransferPtr, bytesWritten);
+            ULONG rxFifoWord = READ_REGISTER_NOFENCE_ULONG(rxDataRegPtr);
+            bytesWritten = ECSPIpHwWriteWordToMdl(TransferPtr, rxFifoWord);
+
+            ECSPIpHwUpdateTransfer(TransferPtr, bytesWritten);
+        }
 
         ECSPIpHwStartBurstIf(DevExtPtr, TransferPtr);
 
@@ -798,6 +827,183 @@ ECSPIHwDisableTransferInterrupts (
 }
 
 
+//
+// Routine Description:
+//
+//  ECSPIHwConfigureDmaTransfer configures the controller for a DMA
+//  transfer.
+//  In DMA mode every 32 bit FIFO word is a separate burst, and
+//  the controller starts a burst as soon as TX FIFO is not empty.
+//  Multi-burst mode is used so the controller keeps transferring
+//  bursts until TX FIFO is empty. Since the controller negates its CS
+//  line between bursts, DMA is only used with GPIO CS lines.
+//  ECSPI interrupts are disabled, transfer completion is reported by
+//  the RX DMA channel.
+//  The routine is called with the interrupt lock held.
+//
+// Arguments:
+//
+//  DevExtPtr - The device extension.
+//
+//  TransferPtr - The transfer descriptor
+//
+//  WatermarkWords - DMA request watermark (FIFO words).
+//
+// Return Value:
+//
+_Use_decl_annotations_
+VOID
+ECSPIHwConfigureDmaTransfer (
+    ECSPI_DEVICE_EXTENSION* DevExtPtr,
+    ECSPI_SPB_TRANSFER* TransferPtr,
+    ULONG WatermarkWords
+    )
+{
+    volatile ECSPI_REGISTERS* ecspiRegsPtr = DevExtPtr->ECSPIRegsPtr;
+    const ECSPI_TARGET_SETTINGS* trgSettingsPtr =
+        &TransferPtr->AssociatedRequestPtr->SpbTargetPtr->Settings;
+    ECSPI_CHANNEL spiChannel = static_cast<ECSPI_CHANNEL>(
+        trgSettingsPtr->DeviceSelection
+        );
+
+    ECSPI_ASSERT(
+        DevExtPtr->IfrLogHandle,
+        (WatermarkWords > 0) && (WatermarkWords <= (ECSPI_FIFO_DEPTH / 2))
+        );
+
+    WRITE_REGISTER_NOFENCE_ULONG(&ecspiRegsPtr->INTREG, 0);
+
+    //
+    // Configuration register: multi-burst mode
+    //
+    {
+        ECSPI_CONFIGREG configReg = { trgSettingsPtr->ConfigReg.AsUlong };
+
+        configReg.SS_CTL =
+            ECSPI_CH_ATTR(spiChannel, ECSPI_SS_CTL::SS_MULTI_BURST);
+        WRITE_REGISTER_NOFENCE_ULONG(&ecspiRegsPtr->CONFIGREG, configReg.AsUlong);
+
+    } // Configuration register
+
+    //
+    // Control register: 32 bit bursts, started when TX FIFO is written.
+    //
+    {
+        ECSPI_CONREG ctrlReg = {
+            READ_REGISTER_NOFENCE_ULONG(&ecspiRegsPtr->CONREG)
+            };
+
+        ctrlReg.BURST_LENGTH = (sizeof(ULONG) * 8) - 1;
+        ctrlReg.SMC = ECSPI_START_MODE::IMMEDIATE;
+        WRITE_REGISTER_NOFENCE_ULONG(&ecspiRegsPtr->CONREG, ctrlReg.AsUlong);
+
+    } // Control register
+
+    #ifdef DBG
+        ECSPIpHwEnableLoopbackIf(DevExtPtr);
+    #endif // DBG
+
+    //
+    // TX DMA request when TX FIFO has room for a watermark,
+    // RX DMA request when RX FIFO holds a watermark.
+    //
+    {
+        ECSPI_DMAREG dmaReg = { 0 };
+
+        dmaReg.TX_THRESHOLD = WatermarkWords;
+        dmaReg.TEDEN = 1;
+        dmaReg.RX_THRESHOLD = WatermarkWords - 1;
+        dmaReg.RXDEN = 1;
+        WRITE_REGISTER_NOFENCE_ULONG(&ecspiRegsPtr->DMAREG, dmaReg.AsUlong);
+
+    } // DMA thresholds
+
+    TransferPtr->IsStartBurst = FALSE;
+}
+
+
+//
+// Routine Description:
+//
+//  ECSPIHwStopDma disables the controller DMA requests, and restores the
+//  target PIO configuration.
+//  The routine is called with the interrupt lock held.
+//
+// Arguments:
+//
+//  DevExtPtr - The device extension.
+//
+//  TransferPtr - The DMA transfer descriptor
+//
+// Return Value:
+//
+_Use_decl_annotations_
+VOID
+ECSPIHwStopDma (
+    ECSPI_DEVICE_EXTENSION* DevExtPtr,
+    const ECSPI_SPB_TRANSFER* TransferPtr
+    )
+{
+    volatile ECSPI_REGISTERS* ecspiRegsPtr = DevExtPtr->ECSPIRegsPtr;
+    const ECSPI_TARGET_SETTINGS* trgSettingsPtr =
+        &TransferPtr->AssociatedRequestPtr->SpbTargetPtr->Settings;
+
+    WRITE_REGISTER_NOFENCE_ULONG(&ecspiRegsPtr->DMAREG, 0);
+
+    ECSPI_CONREG ctrlReg = {
+        READ_REGISTER_NOFENCE_ULONG(&ecspiRegsPtr->CONREG)
+        };
+    ctrlReg.SMC = ECSPI_START_MODE::XCH;
+    WRITE_REGISTER_NOFENCE_ULONG(&ecspiRegsPtr->CONREG, ctrlReg.AsUlong);
+
+    WRITE_REGISTER_NOFENCE_ULONG(
+        &ecspiRegsPtr->CONFIGREG,
+        trgSettingsPtr->ConfigReg.AsUlong
+        );
+}
+
+
+//
+// Routine Description:
+//
+//  ECSPIHwDataSwapBuffer converts a DMA buffer between memory byte order
+//  and the ECSPI FIFO word order, based on the data bit length.
+//  The conversion is symmetric, and used for both TX and RX data.
+//
+// Arguments:
+//
+//  BufferPtr - The DMA buffer.
+//
+//  Words - Buffer size in FIFO words.
+//
+//  BufferStride - Data bit length in bytes.
+//
+// Return Value:
+//
+_Use_decl_annotations_
+VOID
+ECSPIHwDataSwapBuffer (
+    ULONG* BufferPtr,
+    size_t Words,
+    ULONG BufferStride
+    )
+{
+    if (BufferStride == sizeof(ULONG)) {
+
+        return;
+    }
+
+    for (size_t word = 0; word < Words; ++word) {
+
+        BufferPtr[word] = ECSPIpHwDataSwap(
+            BufferPtr[word],
+            sizeof(ULONG),
+            BufferStride
+            );
+    }
+}
+
+
 //
 // Routine Description:
 //
@@ -1099,6 +1305,310 @@ done:
 }
 
 
+//
+// Routine Description:
+//
+//  ECSPIpHwGetMdlWordSpan returns the number of whole words that can be
+//  accessed directly at the current MDL position.
+//  The span is limited to the current MDL and burst, and is available
+//  only when the current MDL position is ULONG aligned, and the next
+//  FIFO word is a whole word.
+//
+// Arguments:
+//
+//  TransferPtr - The transfer descriptor
+//
+//  WordPtrPtr - Address of a caller pointer to receive the span
+//      start address.
+//
+// Return Value:
+//  
+//  Number of words in span, 0 if the single word path should be used.
+//
+_Use_decl_annotations_
+size_t
+ECSPIpHwGetMdlWordSpan (
+    ECSPI_SPB_TRANSFER* TransferPtr,
+    ULONG** WordPtrPtr
+    )
+{
+    *WordPtrPtr = nullptr;
+
+    //
+    // LSBytes are in the first WORD of burst
+    //
+    if (ECSPISpbIsBurstStart(TransferPtr) &&
+        ((TransferPtr->BurstLength % sizeof(ULONG)) != 0)) {
+
+        return 0;
+    }
+
+    PMDL mdlPtr = TransferPtr->CurrentMdlPtr;
+    if (mdlPtr == nullptr) {
+
+        return 0;
+    }
+
+    size_t byteCount = MmGetMdlByteCount(mdlPtr) - TransferPtr->CurrentMdlOffset;
+    if ((byteCount == 0) && (mdlPtr->Next != nullptr)) {
+        //
+        // Current MDL consumed, move to the next one.
+        //
+        mdlPtr = mdlPtr->Next;
+        TransferPtr->CurrentMdlPtr = mdlPtr;
+        TransferPtr->CurrentMdlOffset = 0;
+        byteCount = MmGetMdlByteCount(mdlPtr);
+    }
+
+    UCHAR* mdlAddr = reinterpret_cast<UCHAR*>(mdlPtr->MappedSystemVa) +
+        TransferPtr->CurrentMdlOffset;
+    if ((ULONG_PTR(mdlAddr) % sizeof(ULONG)) != 0) {
+
+        return 0;
+    }
+
+    *WordPtrPtr = reinterpret_cast<ULONG*>(mdlAddr);
+    return min(byteCount, TransferPtr->BytesLeftInBurst) / sizeof(ULONG);
+}
+
+
+//
+// Routine Description:
+//
+//  ECSPIpHwSwapWord is the compile time specialization of
+//  ECSPIpHwDataSwap for a whole word, based on the buffer stride.
+//
+// Arguments:
+//
+//  Data - The original value
+//
+// Return Value:
+//
+//  A ULONG value with the bytes swapped.
+//
+template <ULONG BUFFER_STRIDE>
+__forceinline
+ULONG
+ECSPIpHwSwapWord (
+    _In_ ULONG Data
+    )
+{
+    static_assert(
+        (BUFFER_STRIDE == 1) || (BUFFER_STRIDE == 2) || (BUFFER_STRIDE == 4),
+        "Unsupported buffer stride"
+        );
+
+    switch (BUFFER_STRIDE) {
+    case 1: // 8 bit transfers
+        return RtlUlongByteSwap(Data);
+
+    case 2: // 16 bit transfers
+        return UlongWordSwap(Data);
+
+    default: // 32 bit transfers
+        return Data;
+    }
+}
+
+
+//
+// Routine Description:
+//
+//  ECSPIpHwWriteTxFifoWords writes a contiguous span of whole words
+//  to TX FIFO.
+//
+// Arguments:
+//
+//  TxDataRegPtr - The TX data register address.
+//
+//  WordPtr - The words to write.
+//
+//  Words - Number of words to write.
+//
+// Return Value:
+//
+template <ULONG BUFFER_STRIDE>
+static
+VOID
+ECSPIpHwWriteTxFifoWords (
+    _In_ volatile ULONG* TxDataRegPtr,
+    _In_reads_(Words) const ULONG* WordPtr,
+    _In_ size_t Words
+    )
+{
+    for (size_t word = 0; word < Words; ++word) {
+
+        WRITE_REGISTER_NOFENCE_ULONG(
+            TxDataRegPtr,
+            ECSPIpHwSwapWord<BUFFER_STRIDE>(WordPtr[word])
+            );
+    }
+}
+
+
+//
+// Routine Description:
+//
+//  ECSPIpHwReadRxFifoWords reads a contiguous span of whole words
+//  from RX FIFO.
+//
+// Arguments:
+//
+//  RxDataRegPtr - The RX data register address.
+//
+//  WordPtr - The caller buffer to receive the words.
+//
+//  Words - Number of words to read.
+//
+// Return Value:
+//
+template <ULONG BUFFER_STRIDE>
+static
+VOID
+ECSPIpHwReadRxFifoWords (
+    _In_ volatile ULONG* RxDataRegPtr,
+    _Out_writes_(Words) ULONG* WordPtr,
+    _In_ size_t Words
+    )
+{
+    for (size_t word = 0; word < Words; ++word) {
+
+        WordPtr[word] = ECSPIpHwSwapWord<BUFFER_STRIDE>(
+            READ_REGISTER_NOFENCE_ULONG(RxDataRegPtr)
+            );
+    }
+}
+
+
+//
+// Routine Description:
+//
+//  ECSPIpHwWriteTxFifoFast writes whole words from a contiguous MDL span
+//  to TX FIFO, and updates the transfer.
+//
+// Arguments:
+//
+//  DevExtPtr - The device extension.
+//
+//  TransferPtr - The transfer descriptor
+//
+//  MaxWords - Max number of words to write.
+//
+// Return Value:
+//  
+//  Number of bytes read from MDL, 0 if the single word path should 
+//  be used.
+//
+_Use_decl_annotations_
+ULONG
+ECSPIpHwWriteTxFifoFast (
+    ECSPI_DEVICE_EXTENSION* DevExtPtr,
+    ECSPI_SPB_TRANSFER* TransferPtr,
+    ULONG MaxWords
+    )
+{
+    ULONG* wordPtr;
+    size_t words = ECSPIpHwGetMdlWordSpan(TransferPtr, &wordPtr);
+    words = min(words, MaxWords);
+    if (words == 0) {
+
+        return 0;
+    }
+
+    volatile ULONG* txDataRegPtr = &DevExtPtr->ECSPIRegsPtr->TXDATA;
+
+    switch (TransferPtr->BufferStride) {
+    case 1:
+        ECSPIpHwWriteTxFifoWords<1>(txDataRegPtr, wordPtr, words);
+        break;
+
+    case 2:
+        ECSPIpHwWriteTxFifoWords<2>(txDataRegPtr, wordPtr, words);
+        break;
+
+    case 4:
+        ECSPIpHwWriteTxFifoWords<4>(txDataRegPtr, wordPtr, words);
+        break;
+
+    default:
+        NT_ASSERT(FALSE);
+        return 0;
+    }
+
+    ULONG bytesRead = ULONG(words * sizeof(ULONG));
+
+    TransferPtr->CurrentMdlOffset += bytesRead;
+    TransferPtr->BurstWords -= words;
+    ECSPIpHwUpdateTransfer(TransferPtr, bytesRead);
+
+    return bytesRead;
+}
+
+
+//
+// Routine Description:
+//
+//  ECSPIpHwReadRxFifoFast reads whole words from RX FIFO to a contiguous
+//  MDL span, and updates the transfer.
+//
+// Arguments:
+//
+//  DevExtPtr - The device extension.
+//
+//  TransferPtr - The transfer descriptor
+//
+//  MaxWords - Max number of words to read, the RX FIFO count.
+//
+// Return Value:
+//  
+//  Number of bytes written to MDL, 0 if the single word path should 
+//  be used.
+//
+_Use_decl_annotations_
+ULONG
+ECSPIpHwReadRxFifoFast (
+    ECSPI_DEVICE_EXTENSION* DevExtPtr,
+    ECSPI_SPB_TRANSFER* TransferPtr,
+    ULONG MaxWords
+    )
+{
+    ULONG* wordPtr;
+    size_t words = ECSPIpHwGetMdlWordSpan(TransferPtr, &wordPtr);
+    words = min(words, MaxWords);
+    if (words == 0) {
+
+        return 0;
+    }
+
+    volatile ULONG* rxDataRegPtr = &DevExtPtr->ECSPIRegsPtr->RXDATA;
+
+    switch (TransferPtr->BufferStride) {
+    case 1:
+        ECSPIpHwReadRxFifoWords<1>(rxDataRegPtr, wordPtr, words);
+        break;
+
+    case 2:
+        ECSPIpHwReadRxFifoWords<2>(rxDataRegPtr, wordPtr, words);
+        break;
+
+    case 4:
+        ECSPIpHwReadRxFifoWords<4>(rxDataRegPtr, wordPtr, words);
+        break;
+
+    default:
+        NT_ASSERT(FALSE);
+        return 0;
+    }
+
+    ULONG bytesWritten = ULONG(words * sizeof(ULONG));
+
+    TransferPtr->CurrentMdlOffset += bytesWritten;
+    ECSPIpHwUpdateTransfer(TransferPtr, bytesWritten);
+
+    return bytesWritten;
+}
+
+
 //
 // Routine Description:
 //  ECSPIpHwUpdateTransfer updates the transfer/burst progress with the number
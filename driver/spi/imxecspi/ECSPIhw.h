@@ -539,6 +539,26 @@ ECSPIHwDisableTransferInterrupts (
     _In_ const ECSPI_SPB_TRANSFER* TransferPtr
     );
 
+VOID
+ECSPIHwConfigureDmaTransfer (
+    _In_ ECSPI_DEVICE_EXTENSION* DevExtPtr,
+    _In_ ECSPI_SPB_TRANSFER* TransferPtr,
+    _In_ ULONG WatermarkWords
+    );
+
+VOID
+ECSPIHwStopDma (
+    _In_ ECSPI_DEVICE_EXTENSION* DevExtPtr,
+    _In_ const ECSPI_SPB_TRANSFER* TransferPtr
+    );
+
+VOID
+ECSPIHwDataSwapBuffer (
+    _Inout_updates_(Words) ULONG* BufferPtr,
+    _In_ size_t Words,
+    _In_ ULONG BufferStride
+    );
+
 BOOLEAN
 ECSPIpHwStartBurstIf (
     _In_ ECSPI_DEVICE_EXTENSION* DevExtPtr,
@@ -569,6 +589,26 @@ ECSPIpHwStartBurstIf (
         _In_ ULONG Data
         );
 
+    static size_t
+    ECSPIpHwGetMdlWordSpan (
+        _In_ ECSPI_SPB_TRANSFER* TransferPtr,
+        _Outptr_result_maybenull_ ULONG** WordPtrPtr
+        );
+
+    static ULONG
+    ECSPIpHwWriteTxFifoFast (
+        _In_ ECSPI_DEVICE_EXTENSION* DevExtPtr,
+        _In_ ECSPI_SPB_TRANSFER* TransferPtr,
+        _In_ ULONG MaxWords
+        );
+
+    static ULONG
+    ECSPIpHwReadRxFifoFast (
+        _In_ ECSPI_DEVICE_EXTENSION* DevExtPtr,
+        _In_ ECSPI_SPB_TRANSFER* TransferPtr,
+        _In_ ULONG MaxWords
+        );
+
     //
     // Routine Description:
     //
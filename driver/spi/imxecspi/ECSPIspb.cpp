@@ -30,6 +30,7 @@
 // Module specific header files
 #include "ECSPIhw.h"
 #include "ECSPIspb.h"
+#include "ECSPIdma.h"
 #include "ECSPIdevice.h"
 
 
@@ -723,18 +724,21 @@ ECSPISpbPrepareNextTransfer (
             );
         reqXferPtr->BytesLeftInBurst = reqXferPtr->BurstLength;
 		reqXferPtr->BurstWords = ECSPISpbWordsLeftInBurst(reqXferPtr);
+        reqXferPtr->IsDmaTransfer = 
+            ECSPIDmaIsTransferEligible(RequestPtr, reqXferPtr);
         ECSPI_LOG_INFORMATION(
             devExtPtr->IfrLogHandle,
             "Preparing transfer %p: target %p, request %p ,"
             "type %!REQUESTTYPE!, direction %s, "
-            "length %Iu, delay %lu uSec",
+            "length %Iu, delay %lu uSec, DMA %d",
             reqXferPtr,
             RequestPtr->SpbTargetPtr,
             RequestPtr,
             RequestPtr->Type,
             DIR2STR(reqXferPtr->SpbTransferDescriptor.Direction),
             reqXferPtr->SpbTransferDescriptor.TransferLength,
-            reqXferPtr->SpbTransferDescriptor.DelayInUs
+            reqXferPtr->SpbTransferDescriptor.DelayInUs,
+            reqXferPtr->IsDmaTransfer
             );
 
         //
@@ -798,7 +802,8 @@ ECSPISpbPrepareNextTransfer (
 // Return Value:
 //
 //  NTSTATUS: STATUS_SUCCESS, or STATUS_NO_MORE_FILES if there are no
-//      more prepared transfers.
+//      more prepared transfers, or STATUS_PENDING if the next transfer
+//      is a DMA transfer, which cannot be started above DISPATCH_LEVEL.
 //
 _Use_decl_annotations_
 NTSTATUS
@@ -859,8 +864,32 @@ ECSPISpbStartNextTransfer (
             );
     }
 
+    //
+    // DMA transactions can only be started at IRQL <= DISPATCH_LEVEL,
+    // the DPC starts it.
+    //
+    if (activeXfer1Ptr->IsDmaTransfer &&
+        (KeGetCurrentIrql() > DISPATCH_LEVEL)) {
+
+        return STATUS_PENDING;
+    }
+
     ECSPIHwClearFIFOs(devExtPtr);  // only clears Rx fifo
 
+    if (activeXfer1Ptr->IsDmaTransfer) {
+
+        NTSTATUS status = ECSPIDmaStartTransfer(devExtPtr, activeXfer1Ptr);
+        if (NT_SUCCESS(status)) {
+
+            return STATUS_SUCCESS;
+        }
+
+        //
+        // Fall back to PIO
+        //
+        activeXfer1Ptr->IsDmaTransfer = FALSE;
+    }
+
     //
     // Configure the HW with the transfer(s) parameters
     //
@@ -1057,10 +1086,13 @@ ECSPISpbCompleteSequenceTransfer (
     //
     if (requestPtr->TransfersLeft != 0) {
 
-        if (ECSPISpbStartNextTransfer(requestPtr) == STATUS_NO_MORE_FILES) {
+        NTSTATUS status = ECSPISpbStartNextTransfer(requestPtr);
+        if ((status == STATUS_NO_MORE_FILES) || (status == STATUS_PENDING)) {
             //
             // Mark that transfer is idle due to lack of prepared transfers, since
             // transfers can only be prepared at IRQL <= DISPATCH_LEVEL.
+            // The same goes for DMA transfers that can only be started
+            // at IRQL <= DISPATCH_LEVEL.
             // When a request is marked as 'idle', DPC knows it needs 
             // to start the next transfer after preparing it.
             //
@@ -1079,7 +1111,9 @@ ECSPISpbCompleteSequenceTransfer (
 //
 //  RequestPtr - The request to complete
 //
-//  Status - Request status
+//  Status - Request status, if STATUS_SUCCESS the request status
+//      is used, to report transfer failures that were
+//      detected outside of the completion path.
 //
 //  Information - Request information (number of bytes transferred).
 //
@@ -1101,6 +1135,11 @@ ECSPISpbCompleteTransferRequest (
 
     if (spbRequest != NULL) {
 
+        if (NT_SUCCESS(Status)) {
+
+            Status = RequestPtr->Status;
+        }
+
         RequestPtr->Type = ECSPI_REQUEST_TYPE::INVALID;
         RequestPtr->State = ECSPI_REQUEST_STATE::INACTIVE;
 
@@ -1114,7 +1153,7 @@ ECSPISpbCompleteTransferRequest (
 // Routine Description:
 //
 //  ECSPISpbAbortAllTransfers is called to abort all active transfers.
-//  The routine resets the block.
+//  The routine stops an active DMA transfer, and resets the block.
 //
 // Arguments:
 //
@@ -1131,6 +1170,8 @@ ECSPISpbAbortAllTransfers (
     ECSPI_TARGET_CONTEXT* trgCtxPtr = RequestPtr->SpbTargetPtr;
     ECSPI_DEVICE_EXTENSION* devExtPtr = trgCtxPtr->DevExtPtr;
 
+    ECSPIDmaAbortTransfer(devExtPtr);
+
     WdfInterruptAcquireLock(devExtPtr->WdfSpiInterrupt);
 
     ECSPIHwUnselectTarget(trgCtxPtr);
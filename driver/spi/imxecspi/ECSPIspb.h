@@ -186,6 +186,11 @@ typedef struct _ECSPI_SPB_TRANSFER {
     //
     ULONG BufferStride;
 
+    //
+    // If transfer is done using DMA
+    //
+    BOOLEAN IsDmaTransfer;
+
 } ECSPI_SPB_TRANSFER;
 
 
@@ -267,6 +272,12 @@ typedef struct _ECSPI_SPB_REQUEST {
     //
     ULONG_PTR TotalBytesTransferred;
 
+    //
+    // Request status, set when a transfer fails
+    // outside of the request completion path (DMA).
+    //
+    NTSTATUS Status;
+
     //
     // If sequence request is idle and next
     // transfer needs to be started manually from DPC.
@@ -217,7 +217,7 @@ Return Value:
                                            DMA_32_BIT_PORT_WIDTH;
         DmaInitBlock.MinimumTransferUnit = 1;
         DmaInitBlock.MinimumRequestLine = SdmaController.SdmaInstance << SDMA_INSTANCE_ID_SHIFT;
-        DmaInitBlock.MaximumRequestLine = (SdmaController.SdmaInstance << SDMA_INSTANCE_ID_SHIFT) + SdmaController.SdmaReqMaxId;
+        DmaInitBlock.MaximumRequestLine = (SdmaController.SdmaInstance << SDMA_INSTANCE_ID_SHIFT) + SDMA_REQ_MEMCOPY;
         DmaInitBlock.CacheCoherent = FALSE;
         DmaInitBlock.GeneratesInterrupt = TRUE;
         DmaInitBlock.InternalData = (PVOID)&SdmaController;
@@ -403,6 +403,20 @@ Environment:
         return FALSE;
     }
 
+    if (SdmaControllerPtr->ChannelsPtr[ChannelNumber] == NULL) {
+        NT_ASSERT(SdmaControllerPtr->ChannelsPtr[ChannelNumber] != NULL);
+        return FALSE;
+    }
+
+    //
+    // The memory copy engine request line is not part of the SOC
+    // request line table, and can be bound to any channel.
+    //
+
+    if (SdmaRequestLine == SDMA_REQ_MEMCOPY) {
+        return TRUE;
+    }
+
     if (SdmaRequestLine > SdmaControllerPtr->SdmaReqMaxId) {
         return FALSE;
     }
@@ -424,11 +438,6 @@ Environment:
         return FALSE;
     }
 
-    if (SdmaControllerPtr->ChannelsPtr[ChannelNumber] == NULL) {
-        NT_ASSERT(SdmaControllerPtr->ChannelsPtr[ChannelNumber] != NULL);
-        return FALSE;
-    }
-
     if (SDMA_DEVICE_FLAG_ON(SdmaChannelConfigPtr->DeviceFlags,
                             SDMA_DEVICE_FLAG_P2P) &&
         (SdmaChannelConfigPtr->Peripheral2Address == 0)) {
@@ -831,6 +840,23 @@ Return Value:
         SdmaChannelPtr->NotificationThreshold = UlongValue;
         return STATUS_SUCCESS;
 
+    case SDMA_CFG_FUN_MEMCOPY_START:
+        if (ContextPtr == NULL) {
+            return STATUS_INVALID_PARAMETER;
+        }
+
+        return SdmaMemCopyStart(SdmaControllerPtr,
+                                ChannelNumber,
+                                (const SDMA_MEMCOPY_REQUEST*)ContextPtr);
+
+    case SDMA_CFG_FUN_MEMCOPY_ABORT:
+        if (SdmaControllerPtr->MemCopyChannel != (LONG)ChannelNumber) {
+            return STATUS_INVALID_DEVICE_STATE;
+        }
+
+        SdmaMemCopyComplete(SdmaControllerPtr, ChannelNumber, TRUE);
+        return STATUS_SUCCESS;
+
     default:
         NT_ASSERT(FALSE);
         break;
@@ -868,7 +894,7 @@ Return Value:
 
 {
 
-    const SDMA_CHANNEL* SdmaChannelPtr;
+    SDMA_CHANNEL* SdmaChannelPtr;
     SDMA_CONTROLLER* SdmaControllerPtr;
     NTSTATUS Status;
 
@@ -880,6 +906,8 @@ Return Value:
 
     if (SdmaChannelPtr->State != CHANNEL_ERROR) {
         NT_ASSERT(!SdmaHwIsChannelRunning(SdmaControllerPtr, ChannelNumber));
+    } else {
+        SdmaChannelPtr->IsContextLoaded = FALSE;
     }
 
     Status = SdmaHwStopChannel(SdmaControllerPtr, ChannelNumber);
@@ -984,6 +1012,16 @@ Return Value:
         }
         InterruptStatus &= ~ChannelMask;
 
+        //
+        // Memory copy engine requests are completed here, and are not
+        // reported to the framework.
+        //
+
+        if ((LONG)ChannelIndex == SdmaControllerPtr->MemCopyChannel) {
+            SdmaMemCopyComplete(SdmaControllerPtr, ChannelIndex, FALSE);
+            continue;
+        }
+
         SdmaChannelPtr = SdmaControllerPtr->ChannelsPtr[ChannelIndex];
 
         switch (SdmaChannelPtr->State) {
@@ -1325,6 +1363,21 @@ Return Value:
         }
     }
 
+    //
+    // Memory copy engine channel configuration:
+    // AP to AP script, with no DMA events so the channel runs as
+    // soon as it is started.
+    //
+
+    SdmaControllerPtr->MemCopyChannelConfig.SdmaScriptAddr = SdmaControllerPtr->SdmaAp2ApScript;
+    SdmaControllerPtr->MemCopyChannelConfig.DmaRequestId = SDMA_REQ_MEMCOPY;
+    SdmaControllerPtr->MemCopyChannelConfig.TransferWidth = DMA_WIDTH_32BIT;
+    SdmaControllerPtr->MemCopyChannelConfig.DeviceFlags = SDMA_DEVICE_FLAG_EXT_ADDRESS;
+    SdmaControllerPtr->MemCopyChannelConfig.WatermarkLevelScale = 100;
+    SdmaControllerPtr->MemCopyChannelConfig.TriggerDmaEventCount = 0;
+    SdmaControllerPtr->MemCopyChannelConfig.SdmaInstance = Instance;
+    SdmaControllerPtr->MemCopyFillValue = SDMA_MEMCOPY_FILL_VALUE_INVALID;
+
     return STATUS_SUCCESS;
 }
 
@@ -1396,6 +1449,281 @@ Return Value:
 }
 
 
+_Use_decl_annotations_
+NTSTATUS
+SdmaMemCopyStart (
+    SDMA_CONTROLLER* SdmaControllerPtr,
+    ULONG ChannelNumber,
+    const SDMA_MEMCOPY_REQUEST* MemCopyRequestPtr
+    )
+
+/*++
+
+Routine Description:
+
+    SdmaMemCopyStart is called to start an asynchronous memory copy/fill
+    request on the given channel.
+    The channel is bound to the controller memory copy configuration (AP to AP
+    script, no DMA events) for the life time of the request.
+
+Arguments:
+
+    SdmaControllerPtr - The controller's internal data.
+
+    ChannelNumber - The target channel index.
+
+    MemCopyRequestPtr - The caller memory copy request.
+
+Return Value:
+
+    STATUS_SUCCESS - Request started, completion routine will be called.
+    STATUS_INVALID_PARAMETER - Malformed request.
+    STATUS_INVALID_DEVICE_STATE - Channel is already in use.
+    STATUS_DEVICE_BUSY - Another memory copy request is active.
+    STATUS_INSUFFICIENT_RESOURCES - Not enough buffer descriptors.
+
+--*/
+
+{
+
+    SDMA_CHANNEL* SdmaChannelPtr;
+    SDMA_CHANNEL0* SdmaChannel0Ptr;
+    NTSTATUS Status;
+
+
+    NT_ASSERT(ChannelNumber < SDMA_NUM_CHANNELS);
+
+#pragma prefast(suppress: 25024, "Channel 0 context is SDMA_CHANNEL0*")
+    SdmaChannel0Ptr = (SDMA_CHANNEL0*)SdmaControllerPtr->ChannelsPtr[0];
+    SdmaChannelPtr = SdmaControllerPtr->ChannelsPtr[ChannelNumber];
+
+    if ((ChannelNumber == 0) || (SdmaChannelPtr == NULL)) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    if ((MemCopyRequestPtr->ElementCount == 0) ||
+        ((MemCopyRequestPtr->Operation != SDMA_MEMCOPY_OP_COPY) &&
+         (MemCopyRequestPtr->Operation != SDMA_MEMCOPY_OP_FILL))) {
+
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    if ((SdmaChannelPtr->State != CHANNEL_IDLE) ||
+        (SdmaChannelPtr->ChannelConfigPtr != NULL)) {
+
+        return STATUS_INVALID_DEVICE_STATE;
+    }
+
+    //
+    // Claim the controller memory copy engine.
+    // The fill block in channel 0 is shared by all channels, so only one
+    // request can be active at a time.
+    //
+
+    if (InterlockedCompareExchange(&SdmaControllerPtr->MemCopyChannel,
+                                   (LONG)ChannelNumber,
+                                   0) != 0) {
+
+        return STATUS_DEVICE_BUSY;
+    }
+
+    //
+    // Bind the channel to the memory copy configuration.
+    // The AP to AP script counts bytes, thus the DMA word size is 1.
+    //
+
+    SdmaChannelPtr->ChannelConfigPtr = &SdmaControllerPtr->MemCopyChannelConfig;
+    SdmaChannelPtr->DmaWordSize = 1;
+    SdmaChannelPtr->IsAutoInitialize = FALSE;
+    SdmaChannelPtr->DeviceAddress.QuadPart = 0;
+    SdmaChannelPtr->AutoInitNextBufferIndex = 0;
+    SdmaChannelPtr->AutoInitBytesTransferred = 0;
+    SdmaChannelPtr->TransferLength = 0;
+    SdmaChannelPtr->ActiveBufferCount = 0;
+
+    SdmaHwSetChannelOverride(SdmaControllerPtr,
+                             ChannelNumber,
+                             TRUE); // Event override
+
+    SdmaControllerPtr->MemCopyCompletionRoutine =
+        MemCopyRequestPtr->CompletionRoutine;
+    SdmaControllerPtr->MemCopyCompletionContextPtr =
+        MemCopyRequestPtr->CompletionContextPtr;
+
+    //
+    // Build the buffer descriptors chain
+    //
+
+    Status = SdmaHwConfigureMemCopyList(SdmaControllerPtr,
+                                        SdmaChannelPtr,
+                                        MemCopyRequestPtr);
+
+    if (!NT_SUCCESS(Status)) {
+        goto Done;
+    }
+
+    //
+    // Reset the current buffer descriptor address
+    //
+
+    SdmaChannel0Ptr->SdmaCCBs[ChannelNumber].CurrentBdAddress =
+        SdmaChannel0Ptr->SdmaCCBs[ChannelNumber].BasedBdAddress;
+
+    //
+    // Setup the channel: set and load the context etc.
+    //
+
+    Status = SdmaHwSetupChannel(SdmaControllerPtr, ChannelNumber);
+
+    if (!NT_SUCCESS(Status)) {
+        NT_ASSERT(NT_SUCCESS(Status));
+        goto Done;
+    }
+
+    //
+    // Start the transfer
+    //
+
+    Status = SdmaHwStartChannel(SdmaControllerPtr, ChannelNumber);
+
+    if (!NT_SUCCESS(Status)) {
+        NT_ASSERT(NT_SUCCESS(Status));
+        goto Done;
+    }
+
+Done:
+
+    if (!NT_SUCCESS(Status)) {
+        SdmaHwStopChannel(SdmaControllerPtr, ChannelNumber);
+
+        SdmaControllerPtr->MemCopyCompletionRoutine = NULL;
+        SdmaControllerPtr->MemCopyCompletionContextPtr = NULL;
+        InterlockedExchange(&SdmaControllerPtr->MemCopyChannel, 0);
+    }
+
+    return Status;
+}
+
+
+_Use_decl_annotations_
+VOID
+SdmaMemCopyComplete (
+    SDMA_CONTROLLER* SdmaControllerPtr,
+    ULONG ChannelNumber,
+    BOOLEAN IsCancelled
+    )
+
+/*++
+
+Routine Description:
+
+    SdmaMemCopyComplete is called to complete the active memory copy request,
+    either from the interrupt handler when the last buffer descriptor is done,
+    or when the request is aborted.
+    The routine releases the channel and calls the request completion routine.
+
+    Note:
+        The interrupt handler and SDMA_CFG_FUN_MEMCOPY_ABORT are not
+        serialized, thus the request is claimed atomically, and only the
+        first caller completes it.
+
+Arguments:
+
+    SdmaControllerPtr - The controller's internal data.
+
+    ChannelNumber - The memory copy channel index.
+
+    IsCancelled - If the request is aborted (TRUE) or done (FALSE).
+
+Return Value:
+
+    None.
+
+--*/
+
+{
+
+    ULONG BufferIndex;
+    ULONG ChannelMask;
+    PSDMA_MEMCOPY_COMPLETION_ROUTINE CompletionRoutine;
+    PVOID CompletionContextPtr;
+    const volatile SDMA_BD_ATTRIBUTES* SdmaBufferDescAttrPtr;
+    SDMA_CHANNEL* SdmaChannelPtr;
+    volatile SDMA_REGS* SdmaRegsPtr;
+    NTSTATUS Status;
+
+
+    NT_ASSERT(ChannelNumber < SDMA_NUM_CHANNELS);
+
+    if (InterlockedCompareExchange(&SdmaControllerPtr->MemCopyChannel,
+                                   SDMA_MEMCOPY_CHANNEL_COMPLETING,
+                                   (LONG)ChannelNumber) != (LONG)ChannelNumber) {
+
+        return;
+    }
+
+    SdmaRegsPtr = SdmaControllerPtr->SdmaRegsPtr;
+    SdmaChannelPtr = SdmaControllerPtr->ChannelsPtr[ChannelNumber];
+    ChannelMask = (1 << ChannelNumber);
+
+    if (IsCancelled) {
+        SdmaChannelPtr->State = CHANNEL_ABORTING;
+        SdmaHwStopTransfer(SdmaControllerPtr, ChannelNumber);
+
+        //
+        // Drop an interrupt the channel may have already asserted,
+        // so it is not reported to the framework.
+        //
+
+        SDMA_WRITE_REGISTER_ULONG(&SdmaRegsPtr->INTR, ChannelMask);
+        SdmaControllerPtr->PendingInterrupts &= ~ChannelMask;
+
+        Status = STATUS_CANCELLED;
+
+    } else {
+
+        //
+        // All buffer descriptors should be processed without errors.
+        //
+
+        Status = STATUS_SUCCESS;
+        for (BufferIndex = 0;
+             BufferIndex < SdmaChannelPtr->ActiveBufferCount;
+             ++BufferIndex) {
+
+            SdmaBufferDescAttrPtr = &SdmaChannelPtr->SdmaBD[BufferIndex].Attributes;
+
+            if ((SdmaBufferDescAttrPtr->D != 0) ||
+                (SdmaBufferDescAttrPtr->R != 0)) {
+
+                Status = STATUS_DEVICE_DATA_ERROR;
+                SdmaChannelPtr->IsContextLoaded = FALSE;
+                break;
+            }
+        }
+    }
+
+    CompletionRoutine = SdmaControllerPtr->MemCopyCompletionRoutine;
+    CompletionContextPtr = SdmaControllerPtr->MemCopyCompletionContextPtr;
+    SdmaControllerPtr->MemCopyCompletionRoutine = NULL;
+    SdmaControllerPtr->MemCopyCompletionContextPtr = NULL;
+
+    //
+    // Release the channel and the memory copy engine
+    //
+
+    SdmaHwStopChannel(SdmaControllerPtr, ChannelNumber);
+
+    InterlockedExchange(&SdmaControllerPtr->MemCopyChannel, 0);
+
+    if (CompletionRoutine != NULL) {
+        CompletionRoutine(CompletionContextPtr, Status);
+    }
+
+    return;
+}
+
+
 //
 // ------------------------------------------------------- HW support Functions
 //
@@ -1676,8 +2004,12 @@ Return Value:
 
     //
     // Setup the channel: set and load the context etc.
+    // The context is always reloaded, so the script restarts from
+    // the current buffer descriptor.
     //
 
+    SdmaChannelPtr->IsContextLoaded = FALSE;
+
     Status = SdmaHwSetupChannel(SdmaControllerPtr, ChannelNumber);
 
     if (!NT_SUCCESS(Status)) {
@@ -1822,6 +2154,16 @@ Return Value:
     SdmaRegsPtr = SdmaControllerPtr->SdmaRegsPtr;
     ChannelMask = (1 << ChannelNumber);
 
+    //
+    // Stopping a running script leaves its context in SDMA RAM
+    // in the middle of a transfer, so it needs to be reloaded.
+    //
+
+    RegValue = SDMA_READ_REGISTER_ULONG(&SdmaRegsPtr->STOP_STAT);
+    if (((RegValue & ChannelMask) != 0) && (ChannelNumber != 0)) {
+        SdmaControllerPtr->ChannelsPtr[ChannelNumber]->IsContextLoaded = FALSE;
+    }
+
     //
     // Disable the channel by clearing HE[i], HSTART[i] bits.
     //
@@ -2048,6 +2390,15 @@ Return Value:
         return STATUS_INVALID_PARAMETER;
     }
 
+    //
+    // Memory copy engine channels are only started through
+    // SDMA_CFG_FUN_MEMCOPY_START.
+    //
+
+    if (SdmaRequestLine == SDMA_REQ_MEMCOPY) {
+        return STATUS_NOT_SUPPORTED;
+    }
+
     if (SdmaRequestLine > SdmaControllerPtr->SdmaReqMaxId) {
         NT_ASSERT(SdmaRequestLine <= SdmaControllerPtr->SdmaReqMaxId);
         return STATUS_INVALID_PARAMETER;
@@ -2360,6 +2711,162 @@ Return Value:
 }
 
 
+_Use_decl_annotations_
+NTSTATUS
+SdmaHwConfigureMemCopyList (
+    SDMA_CONTROLLER* SdmaControllerPtr,
+    SDMA_CHANNEL* SdmaChannelPtr,
+    const SDMA_MEMCOPY_REQUEST* MemCopyRequestPtr
+    )
+
+/*++
+
+Routine Description:
+
+    This routine builds the SDMA buffer descriptor chain for a memory copy
+    engine request.
+    Each element is split into buffer descriptors of up to
+    SDMA_MEMCOPY_BD_MAX_LENGTH bytes. Fill elements use the fill block in
+    channel 0 as the source, so each of their buffer descriptors covers up to
+    SDMA_MEMCOPY_FILL_BLOCK_SIZE bytes.
+
+Arguments:
+
+    SdmaControllerPtr - The controller's internal data.
+
+    SdmaChannelPtr - The SDMA channel descriptor.
+
+    MemCopyRequestPtr - The caller memory copy request.
+
+Return Value:
+
+    STATUS_SUCCESS, STATUS_INVALID_PARAMETER for a malformed element,
+    or STATUS_INSUFFICIENT_RESOURCES if the request needs more than
+    SDMA_SG_LIST_MAX_SIZE buffer descriptors.
+
+--*/
+
+{
+
+    ULONG BufferCount;
+    ULONG BufferIndex;
+    ULONG BufferLength;
+    PHYSICAL_ADDRESS DestinationAddress;
+    ULONG ElementIndex;
+    const SDMA_MEMCOPY_ELEMENT* ElementPtr;
+    PHYSICAL_ADDRESS FillBlockAddress;
+    BOOLEAN IsFill;
+    ULONG MaxBufferLength;
+    ULONG RemainingLength;
+    SDMA_CHANNEL0* SdmaChannel0Ptr;
+    PHYSICAL_ADDRESS SourceAddress;
+    ULONG TransferLength;
+
+
+#pragma prefast(suppress: 25024, "Channel 0 context is SDMA_CHANNEL0*")
+    SdmaChannel0Ptr = (SDMA_CHANNEL0*)SdmaControllerPtr->ChannelsPtr[0];
+
+    IsFill = (MemCopyRequestPtr->Operation == SDMA_MEMCOPY_OP_FILL);
+    MaxBufferLength = SDMA_MEMCOPY_BD_MAX_LENGTH;
+    if (IsFill) {
+        MaxBufferLength = SDMA_MEMCOPY_FILL_BLOCK_SIZE;
+    }
+
+    //
+    // Validate the request and count the buffer descriptors it needs,
+    // before any buffer descriptor is touched.
+    //
+
+    BufferCount = 0;
+    TransferLength = 0;
+    for (ElementIndex = 0;
+         ElementIndex < MemCopyRequestPtr->ElementCount;
+         ++ElementIndex) {
+
+        ElementPtr = &MemCopyRequestPtr->Elements[ElementIndex];
+
+        if ((ElementPtr->Length == 0) ||
+            (ElementPtr->DestinationAddress.HighPart != 0) ||
+            (!IsFill && (ElementPtr->SourceAddress.HighPart != 0))) {
+
+            return STATUS_INVALID_PARAMETER;
+        }
+
+        BufferCount += (ElementPtr->Length + MaxBufferLength - 1) /
+            MaxBufferLength;
+
+        if (BufferCount > SDMA_SG_LIST_MAX_SIZE) {
+            return STATUS_INSUFFICIENT_RESOURCES;
+        }
+
+        TransferLength += ElementPtr->Length;
+    }
+
+    //
+    // The fill block only needs to be refreshed when the fill value changes.
+    //
+
+    if (IsFill &&
+        (SdmaControllerPtr->MemCopyFillValue != MemCopyRequestPtr->FillValue)) {
+
+        RtlFillMemory(SdmaChannel0Ptr->MemCopyFillBlock,
+                      sizeof(SdmaChannel0Ptr->MemCopyFillBlock),
+                      MemCopyRequestPtr->FillValue);
+
+        SdmaControllerPtr->MemCopyFillValue = MemCopyRequestPtr->FillValue;
+    }
+
+    FillBlockAddress.QuadPart =
+        SDMA_CHN0_LOGICAL_ADDR(SdmaChannel0Ptr, MemCopyFillBlock);
+
+    //
+    // Build the chain: buffer address is the source,
+    // the extended address is the destination.
+    //
+
+    BufferIndex = 0;
+    for (ElementIndex = 0;
+         ElementIndex < MemCopyRequestPtr->ElementCount;
+         ++ElementIndex) {
+
+        ElementPtr = &MemCopyRequestPtr->Elements[ElementIndex];
+        DestinationAddress = ElementPtr->DestinationAddress;
+        SourceAddress = ElementPtr->SourceAddress;
+        if (IsFill) {
+            SourceAddress = FillBlockAddress;
+        }
+
+        RemainingLength = ElementPtr->Length;
+        while (RemainingLength != 0) {
+            BufferLength = min(RemainingLength, MaxBufferLength);
+
+            SdmaHwInitBufferDescriptor(SdmaChannelPtr,
+                                       BufferIndex,
+                                       BufferLength,
+                                       SourceAddress,
+                                       DestinationAddress,
+                                       (BufferIndex + 1) == BufferCount,
+                                       FALSE);
+
+            DestinationAddress.QuadPart += BufferLength;
+            if (!IsFill) {
+                SourceAddress.QuadPart += BufferLength;
+            }
+
+            RemainingLength -= BufferLength;
+            ++BufferIndex;
+        }
+    }
+
+    NT_ASSERT(BufferIndex == BufferCount);
+
+    SdmaChannelPtr->TransferLength = TransferLength;
+    SdmaChannelPtr->ActiveBufferCount = BufferCount;
+
+    return STATUS_SUCCESS;
+}
+
+
 _Use_decl_annotations_
 ULONG
 SdmaGetTransferLength (
@@ -2696,6 +3203,8 @@ Routine Description:
     This routine prepares the channel for running:
     - Initializes the channel context in Arm memory.
     - Loads channel context to SDMA memory, using channel 0.
+    If the context loaded to SDMA memory is still valid, both are skipped,
+    and the script resumes from the reset current buffer descriptor address.
 
 Arguments:
 
@@ -2711,11 +3220,28 @@ Return Value:
 
 {
 
+    SDMA_CHANNEL* SdmaChannelPtr;
     NTSTATUS Status;
 
 
     NT_ASSERT(ChannelNumber < SDMA_NUM_CHANNELS);
 
+    SdmaChannelPtr = SdmaControllerPtr->ChannelsPtr[ChannelNumber];
+
+    if (SdmaChannelPtr->IsContextLoaded &&
+        (SdmaChannelPtr->LoadedContextConfigPtr ==
+         SdmaChannelPtr->ChannelConfigPtr) &&
+        (SdmaChannelPtr->LoadedContextWatermarkLevel ==
+         SdmaChannelPtr->WatermarkLevel) &&
+        (SdmaChannelPtr->LoadedContextDeviceAddress ==
+         SdmaChannelPtr->DeviceAddress.LowPart)) {
+
+        ++SdmaControllerPtr->ContextLoadSkipCount;
+        goto Done;
+    }
+
+    SdmaChannelPtr->IsContextLoaded = FALSE;
+
     //
     // Prepare channel context for target script
     //
@@ -2736,6 +3262,15 @@ Return Value:
         return Status;
     }
 
+    ++SdmaControllerPtr->ContextLoadCount;
+    SdmaChannelPtr->IsContextLoaded = TRUE;
+    SdmaChannelPtr->LoadedContextConfigPtr = SdmaChannelPtr->ChannelConfigPtr;
+    SdmaChannelPtr->LoadedContextWatermarkLevel = SdmaChannelPtr->WatermarkLevel;
+    SdmaChannelPtr->LoadedContextDeviceAddress =
+        SdmaChannelPtr->DeviceAddress.LowPart;
+
+Done:
+
     SdmaHwSetChannelPriority(SdmaControllerPtr, ChannelNumber, CHN_PRI_NORMAL);
 
     return STATUS_SUCCESS;
@@ -73,6 +73,29 @@ Revision History:
 #define IMX_MAX_CHANNEL_DONE_WAIT_RETRY 1000UL
 
 
+//
+// Max bytes per memory copy buffer descriptor.
+// The AP to AP script counts bytes, keep chunks word aligned.
+//
+
+#define SDMA_MEMCOPY_BD_MAX_LENGTH 0xFFFCUL
+
+
+//
+// Fill block value that does not match any fill byte
+//
+
+#define SDMA_MEMCOPY_FILL_VALUE_INVALID 0xFFFFFFFFUL
+
+
+//
+// SDMA_CONTROLLER::MemCopyChannel value while the active memory copy
+// request is being completed.
+//
+
+#define SDMA_MEMCOPY_CHANNEL_COMPLETING ((LONG)SDMA_NUM_CHANNELS)
+
+
 #define SDMA_READ_REGISTER_ULONG(_Address) \
     READ_REGISTER_NOFENCE_ULONG((_Address))
 
@@ -522,6 +545,19 @@ typedef struct _SDMA_CHANNEL {
 
     ULONG DmaWordSize;
 
+    //
+    // The parameters the channel context was last loaded with.
+    // The context only depends on the channel configuration, the
+    // watermark level and the device address, so as long as those
+    // are unchanged, and the channel script was not interrupted,
+    // the context in SDMA RAM can be reused.
+    //
+
+    BOOLEAN IsContextLoaded;
+    const SDMA_CHANNEL_CONFIG* LoadedContextConfigPtr;
+    ULONG LoadedContextWatermarkLevel;
+    ULONG LoadedContextDeviceAddress;
+
 } SDMA_CHANNEL;
 
 
@@ -563,6 +599,12 @@ typedef struct _SDMA_CHANNEL0 {
 
     SDMA_CHANNEL_CONTEXT ChannelContext;
 
+    //
+    // Fill source block for memory copy engine fill requests
+    //
+
+    UCHAR MemCopyFillBlock[SDMA_MEMCOPY_FILL_BLOCK_SIZE];
+
 } SDMA_CHANNEL0;
 
 
@@ -644,6 +686,29 @@ typedef struct _SDMA_CONTROLLER {
 
     NTSTATUS ControllerStatus;
 
+    //
+    // Memory copy engine:
+    // - The channel running the active request, or 0 if idle.
+    // - Channel configuration for SDMA_REQ_MEMCOPY.
+    // - The byte value MemCopyFillBlock is currently filled with.
+    // - The active request completion routine and context.
+    //
+
+    volatile LONG MemCopyChannel;
+    SDMA_CHANNEL_CONFIG MemCopyChannelConfig;
+    ULONG MemCopyFillValue;
+    PSDMA_MEMCOPY_COMPLETION_ROUTINE MemCopyCompletionRoutine;
+    PVOID MemCopyCompletionContextPtr;
+
+    //
+    // Channel context load statistics:
+    // - Number of channel contexts loaded to SDMA RAM.
+    // - Number of channel setups that reused the loaded context.
+    //
+
+    ULONG ContextLoadCount;
+    ULONG ContextLoadSkipCount;
+
 } SDMA_CONTROLLER;
 
 
@@ -673,6 +738,20 @@ SdmaInitDmaReqMapping (
     _In_ ULONG Instance
     );
 
+NTSTATUS
+SdmaMemCopyStart (
+    _In_ SDMA_CONTROLLER* SdmaControllerPtr,
+    _In_ ULONG ChannelNumber,
+    _In_ const SDMA_MEMCOPY_REQUEST* MemCopyRequestPtr
+    );
+
+VOID
+SdmaMemCopyComplete (
+    _In_ SDMA_CONTROLLER* SdmaControllerPtr,
+    _In_ ULONG ChannelNumber,
+    _In_ BOOLEAN IsCancelled
+    );
+
 VOID
 SdmaAcquireChannel0 (
     _In_ SDMA_CONTROLLER* SdmaControllerPtr
@@ -764,6 +843,13 @@ SdmaHwInitBufferDescriptor (
     _In_ BOOLEAN IsAutoInitialize
     );
 
+NTSTATUS
+SdmaHwConfigureMemCopyList (
+    _In_ SDMA_CONTROLLER* SdmaControllerPtr,
+    _In_ SDMA_CHANNEL* SdmaChannelPtr,
+    _In_ const SDMA_MEMCOPY_REQUEST* MemCopyRequestPtr
+    );
+
 ULONG
 SdmaGetTransferLength (
     _In_ const DMA_SCATTER_GATHER_LIST* MemoryAddressesPtr
@@ -56,6 +56,22 @@ Revision History:
 
 #define SDMA_MAX_WATERMARK_LEVEL 0xFFFFUL
 
+//
+// Memory copy engine request line.
+// A DMA adapter bound to this request line (on any SDMA instance) gets
+// a software triggered channel that is driven through
+// SDMA_CFG_FUN_MEMCOPY_START, rather than through MapTransferEx.
+//
+
+#define SDMA_REQ_MEMCOPY 0x3FFUL
+
+//
+// Size of the fill source block used by SDMA_MEMCOPY_OP_FILL requests.
+// Each fill buffer descriptor covers at most this many bytes.
+//
+
+#define SDMA_MEMCOPY_FILL_BLOCK_SIZE 4096UL
+
 
 //
 // ----------------------------------------------------------- Type Definitions
@@ -73,10 +89,103 @@ enum _SDMA_CONFIG_FUNCTION_ID {
     SDMA_CFG_FUN_ACQUIRE_REQUEST_LINE = 0x8002,
     SDMA_CFG_FUN_RELEASE_REQUEST_LINE = 0x8003,
     SDMA_CFG_FUN_SET_CHANNEL_NOTIFICATION_THRESHOLD = 0x8004,
+    SDMA_CFG_FUN_MEMCOPY_START = 0x8005,
+    SDMA_CFG_FUN_MEMCOPY_ABORT = 0x8006,
 
 } SDMA_CONFIG_FUNCTION_ID;
 
 
+//
+// Memory copy engine operations
+//
+
+typedef enum _SDMA_MEMCOPY_OPERATION {
+
+    SDMA_MEMCOPY_OP_COPY = 0,
+    SDMA_MEMCOPY_OP_FILL = 1,
+
+} SDMA_MEMCOPY_OPERATION;
+
+
+//
+// Memory copy engine completion callback.
+// Called once per started request, either from the SDMA interrupt
+// handler (DIRQL), or from the SDMA_CFG_FUN_MEMCOPY_ABORT caller.
+// The routine should only record the status and queue a DPC.
+//
+
+typedef
+VOID
+SDMA_MEMCOPY_COMPLETION_ROUTINE (
+    _In_opt_ PVOID ContextPtr,
+    _In_ NTSTATUS Status
+    );
+
+typedef SDMA_MEMCOPY_COMPLETION_ROUTINE* PSDMA_MEMCOPY_COMPLETION_ROUTINE;
+
+
+//
+// Memory copy engine scatter-gather element
+//
+
+typedef struct _SDMA_MEMCOPY_ELEMENT {
+
+    //
+    // Destination buffer logical address
+    //
+
+    PHYSICAL_ADDRESS DestinationAddress;
+
+    //
+    // Source buffer logical address, ignored by SDMA_MEMCOPY_OP_FILL.
+    //
+
+    PHYSICAL_ADDRESS SourceAddress;
+
+    //
+    // Number of bytes to copy/fill
+    //
+
+    ULONG Length;
+
+} SDMA_MEMCOPY_ELEMENT;
+
+
+//
+// Memory copy engine request
+//
+
+typedef struct _SDMA_MEMCOPY_REQUEST {
+
+    //
+    // SDMA_MEMCOPY_OP_xxx
+    //
+
+    SDMA_MEMCOPY_OPERATION Operation;
+
+    //
+    // Byte value used by SDMA_MEMCOPY_OP_FILL
+    //
+
+    UCHAR FillValue;
+
+    //
+    // Optional completion callback and its context
+    //
+
+    PSDMA_MEMCOPY_COMPLETION_ROUTINE CompletionRoutine;
+    PVOID CompletionContextPtr;
+
+    //
+    // The scatter-gather list
+    //
+
+    ULONG ElementCount;
+    SDMA_MEMCOPY_ELEMENT Elements[ANYSIZE_ARRAY];
+
+} SDMA_MEMCOPY_REQUEST;
+
+
 //
 // SDMA Configuration Function IDs data structures
 //
@@ -110,6 +219,30 @@ enum _SDMA_CONFIG_FUNCTION_ID {
 //     process the data in time.
 //
 
+//
+// SDMA_CFG_FUN_MEMCOPY_START input buffer:
+// SDMA_MEMCOPY_REQUEST
+//   Starts an asynchronous copy/fill on a channel whose adapter is bound to
+//   SDMA_REQ_MEMCOPY. The request is consumed before the call returns.
+//   The completion routine is only called if STATUS_SUCCESS is returned.
+//   Note:
+//     Only one memory copy request can be active per SDMA controller,
+//     STATUS_DEVICE_BUSY is returned otherwise.
+//     Every element is split into buffer descriptors of up to 64KB (SDMA_MEMCOPY_FILL_BLOCK_SIZE for fills);
+//     STATUS_INSUFFICIENT_RESOURCES is returned if the request needs more
+//     than SDMA_SG_LIST_MAX_SIZE descriptors, and the caller should split it.
+//     The caller is responsible for flushing the source and invalidating
+//     the destination buffers, since SDMA is not cache coherent.
+//
+
+//
+// SDMA_CFG_FUN_MEMCOPY_ABORT:
+// No input buffer.
+//   Aborts the active memory copy request on the channel. The completion
+//   routine is called with STATUS_CANCELLED, unless the request has
+//   already completed.
+//
+
 #ifdef __cplusplus
     }
 #endif // __cplusplus